@@ -82,6 +82,7 @@
 #include <jz_sail/ThreePointLighting.h>
 #include <jz_system/Files.h>
 #include <jz_system/Input.h>
+#include <jz_system/Jobs.h>
 #include <jz_system/Loader.h>
 #include <jz_system/Profiler.h>
 #include <jz_system/System.h>
@@ -315,6 +316,33 @@
         }
     }
 
+    static void GatherRenderables(::std::vector< ::jz::engine_3D::IRenderable* >& arOut, ::jz::engine_3D::IRenderable* p)
+    {
+        arOut.push_back(p);
+    }
+
+    static const size_t kPoserGrainSize = 32u;
+
+    // Culls and poses a range of renderables. Run with Jobs::ParallelFor(), RenderMan
+    // records the poses of each worker separately.
+    struct PoserBody
+    {
+        PoserBody(const ::jz::Region& aFrustum, const ::std::vector< ::jz::engine_3D::IRenderable* >& aRenderables)
+            : Frustum(aFrustum), Renderables(aRenderables)
+        {}
+
+        void operator()(size_t aBegin, size_t aEnd)
+        {
+            for (size_t i = aBegin; i < aEnd; i++)
+            {
+                Poser(Frustum, Renderables[i]);
+            }
+        }
+
+        const ::jz::Region& Frustum;
+        const ::std::vector< ::jz::engine_3D::IRenderable* >& Renderables;
+    };
+
 #   ifdef DEBUG_PHYSICS
         static void HideMeshNodes(::jz::engine_3D::MeshNode* p)
         {
@@ -472,7 +500,8 @@
                         files.AddArchive(new ZipArchive("media.dat"));
 #                   endif
 
-#                   if JZ_MULTITHREADED
+                    Jobs jobs;
+#                   if JZ_MULTITHREADED_IO
                         Loader loader;
 #                   endif
 
@@ -655,6 +684,7 @@
 #endif
 
                         Profiler profiler;
+                        vector<IRenderable*> renderables;
 
                         MSG msg; 
                         memset(&msg, 0, sizeof(MSG));
@@ -673,7 +703,7 @@
                                 Time::GetSingleton().Tick();
                                 float t = Time::GetSingleton().GetElapsedSeconds();
 
-#                               if JZ_MULTITHREADED                                
+#                               if JZ_MULTITHREADED_IO
                                     loader.Tick();
 #                               endif
 
@@ -737,7 +767,12 @@
 #endif
 #                               if !TEST_RADIOSITY
                                 Region frustum(-man.GetView().GetTranslation(), man.GetView() * man.GetProjection());
-                                pRoot->Apply<IRenderable>(tr1::bind(Poser, frustum, tr1::placeholders::_1));
+                                renderables.clear();
+                                pRoot->Apply<IRenderable>(tr1::bind(GatherRenderables, tr1::ref(renderables), tr1::placeholders::_1));
+                                {
+                                    PoserBody poser(frustum, renderables);
+                                    jobs.ParallelFor(poser, 0u, renderables.size(), kPoserGrainSize);
+                                }
                                 pRoot->Apply<LightNode>(tr1::bind(Lighter, frustum, pRoot, tr1::placeholders::_1));
                                 pRoot->Apply<ReflectivePlaneNode>(tr1::bind(Reflector, frustum, pRoot, tr1::placeholders::_1));
 #                               endif
@@ -0,0 +1,663 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+// Renders a scene through the null graphics backend and reports the CPU time of each
+// phase of a frame and the work submitted to the (null) device.
+//
+// Usage: jz_app_benchmark <media directory or .dat> <scene> [frames] [warmup frames]
+//        jz_app_benchmark --generate <existing directory> [meshes per side]
+//        jz_app_benchmark --codecs <file> [more files...]
+//
+// --generate writes a synthetic media set in the formats the null backend reads: a grid
+// of mesh nodes lit by point and spot lights, in "synthetic.scene", together with
+// stand-ins for the built-in meshes and effects that the engine loads at startup.
+//
+// --codecs compresses the files, as one corpus, with every registered block codec at
+// the default FileSystem block size, and reports the ratio and the encode and decode
+// rates, for choosing FileSystem codecs by extension.
+
+#include <jz_core/Logger.h>
+#include <jz_core/Region.h>
+#include <jz_core/StringUtility.h>
+#include <jz_engine_3D/CameraNode.h>
+#include <jz_engine_3D/Deferred.h>
+#include <jz_engine_3D/IRenderable.h>
+#include <jz_engine_3D/IShadowable.h>
+#include <jz_engine_3D/LightNode.h>
+#include <jz_engine_3D/PickMan.h>
+#include <jz_engine_3D/ReflectivePlaneNode.h>
+#include <jz_engine_3D/RenderMan.h>
+#include <jz_engine_3D/SceneNode.h>
+#include <jz_engine_3D/SceneReader.h>
+#include <jz_filesystem/BlockCodec.h>
+#include <jz_filesystem/FileSystem.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics_null/Null.h>
+#include <jz_system/Files.h>
+#include <jz_system/Jobs.h>
+#include <jz_system/System.h>
+#include <jz_system/Time.h>
+#include <jz_system/WriteHelpers.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const size_t kDefaultFrames = 500u;
+static const size_t kDefaultWarmupFrames = 50u;
+static const size_t kPoserGrainSize = 32u;
+
+// The camera stands at the center of the scene and turns at a fixed rate per frame, so
+// every run of a scene sees the same sequence of views.
+static const float kCameraRadiansPerFrame = 0.01f;
+
+static void ActivateShadowing(::jz::engine_3D::LightNode* p)
+{
+    if (p->GetType() == ::jz::engine_3D::LightNodeType::kSpot)
+    {
+        p->SetCastShadow(true);
+    }
+}
+
+static void Light(float* apMaxRange, ::jz::engine_3D::LightNode* apLight, ::jz::engine_3D::IShadowable* p)
+{
+    if (p->bCastShadow())
+    {
+        if (apLight->GetBoundingSphere().Intersects(p->GetBoundingBox()))
+        {
+            const jz::BoundingBox& aabb = p->GetBoundingBox();
+            float d = jz::Vector3::Distance(apLight->GetWorldTranslation(), p->GetBoundingBox().Center());
+            jz::Vector3 n = jz::Vector3::Normalize(apLight->GetWorldTranslation() - p->GetBoundingBox().Center());
+            float r = aabb.EffectiveRadius(n);
+
+            (*apMaxRange) = jz::Max(*apMaxRange, (d + r));
+
+            if (apLight->GetWorldFrustum().Test(p->GetBoundingBox()) != ::jz::Geometric::kDisjoint)
+            {
+                p->PoseForShadow(apLight);
+            }
+        }
+    }
+}
+
+static void Lighter(const ::jz::Region& aViewFrustum, const ::jz::engine_3D::SceneNodePtr& apRoot, ::jz::engine_3D::LightNode* p)
+{
+    if (p->GetShadowHandle() >= 0)
+    {
+        if (aViewFrustum.Test(p->GetBoundingSphere()) != jz::Geometric::kDisjoint)
+        {
+            float maxRange = jz::Constants<float>::kMin;
+
+            apRoot->Apply<jz::engine_3D::IShadowable>(std::tr1::bind(Light, &maxRange, p, std::tr1::placeholders::_1));
+
+            if (!jz::AboutEqual(maxRange, p->GetRange()))
+            {
+                p->SetRange(maxRange);
+            }
+        }
+    }
+}
+
+static void Reflect(const ::jz::Region& aReflectedFrustum, ::jz::engine_3D::ReflectivePlaneNode* apNode, ::jz::engine_3D::IReflectable* p)
+{
+    if (aReflectedFrustum.Test(p->GetBoundingBox()) != jz::Geometric::kDisjoint)
+    {
+        p->PoseForReflection(apNode);
+    }
+}
+
+static void Reflector(const ::jz::Region& aViewFrustum, const ::jz::engine_3D::SceneNodePtr& apRoot, ::jz::engine_3D::ReflectivePlaneNode* p)
+{
+    if (p->GetReflectionHandle() >= 0)
+    {
+        if (aViewFrustum.Test(p->GetBoundingSphere()) != jz::Geometric::kDisjoint)
+        {
+            const ::jz::Plane& plane = p->GetReflectionPlane();
+            size_t size = aViewFrustum.Planes.size();
+            ::jz::Matrix4 m = ::jz::Matrix4::CreateReflection(plane);
+
+            ::jz::Region reflectedFrustum(::jz::Vector3::TransformPosition(m, aViewFrustum.Center), aViewFrustum.Planes.size());
+
+            for (size_t i = 0u; i < size; i++)
+            {
+                reflectedFrustum.Planes[i] = ::jz::Plane::Transform(m, aViewFrustum.Planes[i]);
+            }
+
+            apRoot->Apply< ::jz::engine_3D::IReflectable>(std::tr1::bind(Reflect, reflectedFrustum, p, std::tr1::placeholders::_1));
+        }
+    }
+}
+
+static void Poser(const ::jz::Region& aFrustum, ::jz::engine_3D::IRenderable* p)
+{
+    if (aFrustum.Test(p->GetBoundingBox()) != ::jz::Geometric::kDisjoint)
+    {
+        p->PoseForRender();
+    }
+}
+
+static void GatherRenderables(::std::vector< ::jz::engine_3D::IRenderable* >& arOut, ::jz::engine_3D::IRenderable* p)
+{
+    arOut.push_back(p);
+}
+
+struct PoserBody
+{
+    PoserBody(const ::jz::Region& aFrustum, const ::std::vector< ::jz::engine_3D::IRenderable* >& aRenderables)
+        : Frustum(aFrustum), Renderables(aRenderables)
+    {}
+
+    void operator()(size_t aBegin, size_t aEnd)
+    {
+        for (size_t i = aBegin; i < aEnd; i++)
+        {
+            Poser(Frustum, Renderables[i]);
+        }
+    }
+
+    const ::jz::Region& Frustum;
+    const ::std::vector< ::jz::engine_3D::IRenderable* >& Renderables;
+};
+
+namespace Phase
+{
+    enum Enum
+    {
+        kUpdate = 0,
+        kPose = 1,
+        kDraw = 2,
+        kCount = 3
+    };
+
+    static const char* kNames[kCount] = { "Update", "Pose", "Draw" };
+}
+
+static double PerFrame(::jz::u64 aCount, size_t aFrames)
+{
+    return (aFrames > 0u) ? ((double)aCount / (double)aFrames) : 0.0;
+}
+
+static void Report(const ::jz::s64 aPhaseNanoseconds[Phase::kCount], size_t aFrames, size_t aRenderables)
+{
+    using namespace jz;
+    using namespace jz::graphics;
+
+    const NullStatistics& s = gNullStatistics;
+
+    printf("frames: %u\n", (uint)aFrames);
+    printf("renderables: %u\n", (uint)aRenderables);
+    printf("\n%-24s %12s\n", "phase", "avg ms");
+    for (int i = 0; i < Phase::kCount; i++)
+    {
+        double ms = PerFrame((u64)aPhaseNanoseconds[i], aFrames) / (double)system::Time::kNanosecondsPerMillisecond;
+        printf("%-24s %12.4f\n", Phase::kNames[i], ms);
+    }
+
+    printf("\n%-24s %12s\n", "per frame", "avg");
+    printf("%-24s %12.1f\n", "presents", PerFrame(s.Frames, aFrames));
+    printf("%-24s %12.1f\n", "clears", PerFrame(s.Clears, aFrames));
+    printf("%-24s %12.1f\n", "draw calls", PerFrame(s.DrawCalls, aFrames));
+    printf("%-24s %12.1f\n", "primitives", PerFrame(s.Primitives, aFrames));
+    printf("%-24s %12.1f\n", "effect begins", PerFrame(s.EffectBegins, aFrames));
+    printf("%-24s %12.1f\n", "pass begins", PerFrame(s.PassBegins, aFrames));
+    printf("%-24s %12.1f\n", "commits", PerFrame(s.Commits, aFrames));
+    printf("%-24s %12.1f\n", "parameter sets", PerFrame(s.ParameterSets, aFrames));
+    printf("%-24s %12.1f\n", "texture sets", PerFrame(s.TextureSets, aFrames));
+    printf("%-24s %12.1f\n", "uploaded bytes", PerFrame(s.UploadedBytes, aFrames));
+
+    printf("\n%-24s %12s %12s\n", "state", "changes", "redundant");
+    for (int i = 0; i < NullState::kCount; i++)
+    {
+        printf("%-24s %12.1f %12.1f\n",
+            NullState::ToString((NullState::Enum)i),
+            PerFrame(s.Changes[i], aFrames),
+            PerFrame(s.RedundantChanges[i], aFrames));
+    }
+}
+
+#pragma region Synthetic media
+static const size_t kDefaultMeshesPerSide = 32u;
+static const size_t kSyntheticMaterialCount = 4u;
+static const size_t kSyntheticPrimitiveCount = 12u;
+static const size_t kSyntheticPointLightCount = 8u;
+static const size_t kSyntheticSpotLightCount = 2u;
+static const float kSyntheticSpacing = 2.0f;
+static const char* kSyntheticScene = "synthetic.scene";
+static const char* kSyntheticEffect = "synthetic.cfx";
+static const char* kSyntheticMesh = "synthetic.mesh";
+static const char* kSyntheticVertexDeclaration = "synthetic.vdecl";
+
+// The null backend treats a name as present in an effect if it is stored null terminated
+// in the file, so every stand-in effect is the list of names the engine looks up.
+static const char* kSyntheticEffectNames[] =
+{
+    "jz_Render", "jz_Pick", "jz_Shadow", "jz_Wit", "jz_World", "jz_Gamma", "jz_Time",
+    "jz_CameraFocalLength", "jz_Projection", "jz_ReflectionPlane", "jz_ScreenDimensions", "jz_View",
+    "jz_ShadowTexture", "jz_ShadowDelta", "jz_ShadowNearFar", "jz_ShadowScaleShift",
+    "jz_ShadowTransform", "jz_ShadowControlTerm", "jz_PrevProjection", "jz_PrevView",
+    "jz_MotionBlurAmount", "jz_BloomThreshold", "jz_MrtTexture0", "jz_MrtTexture1",
+    "jz_MrtTexture2", "jz_MrtTexture3", "jz_GaussianWeights", "jz_HdrTexture", "jz_AoRadius",
+    "jz_AoScale", "jz_bDebugAO", "jz_FocusDistances", "jz_bDebugDeferred", "jz_LightAttenuation",
+    "jz_LightColor", "jz_LightV", "jz_SpotDirection", "jz_SpotFalloffCosHalfAngle",
+    "jz_SpotFalloffExponent", "Ao", "LdrPass", "ShadowBlurPass1", "ShadowBlurPass2", "MotionBlur",
+    "BloomProcess", "BloomBlurPass1", "BloomBlurPass2", "DofBlurPass1", "DofBlurPass2",
+    "Directional", "Point", "PointAsQuad", "Spot", "SpotWithShadow", "SpotAsQuad",
+    "SpotWithShadowAsQuad"
+};
+
+static const char* kSyntheticEffects[] = { "SimpleEffect.cfx", "engine_3D_deferred.cfx", kSyntheticEffect };
+static const char* kSyntheticBuiltInMeshes[] =
+{
+    "built-in_unit-box.mesh", "built-in_unit-frustum.mesh", "built-in_instancing-quad.mesh",
+    "built-in_unit-quad.mesh", "built-in_unit-sphere.mesh", kSyntheticMesh
+};
+
+static ::jz::system::IWriteFilePtr OpenSynthetic(const ::jz::string& aDirectory, const ::jz::string& aFilename)
+{
+    return ::jz::system::IWriteFilePtr(new ::jz::system::WriteFile(aDirectory + "/" + aFilename));
+}
+
+static ::jz::string SyntheticMaterial(size_t i)
+{
+    return "synthetic" + ::jz::StringUtility::ToString((::jz::uint)i) + ".mat";
+}
+
+static void WriteSyntheticMesh(const ::jz::string& aDirectory, const ::jz::string& aFilename)
+{
+    using namespace jz;
+    using namespace jz::system;
+
+    static const size_t kVertexStride = 32u;
+    static const size_t kVertexCount = 8u;
+    const size_t kIndexCount = (kSyntheticPrimitiveCount * 3u);
+
+    IWriteFilePtr p = OpenSynthetic(aDirectory, aFilename);
+    WriteBoundingBox(p, BoundingBox(Vector3(-0.5f), Vector3(0.5f)));
+    WriteBoundingSphere(p, BoundingSphere(Vector3::kZero, Sqrt(0.75f)));
+    WriteInt32(p, (s32)kSyntheticPrimitiveCount);
+    WriteInt32(p, (s32)graphics::PrimitiveType::kTriangleList);
+    WriteInt32(p, (s32)kVertexCount);
+    WriteString(p, kSyntheticVertexDeclaration);
+    WriteInt32(p, (s32)kVertexStride);
+
+    // The null device skips index and vertex data, only the sizes matter.
+    vector<u8> zero(jz::Max(kIndexCount * sizeof(u16), kVertexCount * kVertexStride), 0u);
+    WriteSizeT(p, kIndexCount);
+    WriteArray(p, &zero[0], (kIndexCount * sizeof(u16)));
+    WriteSizeT(p, (kVertexCount * kVertexStride));
+    WriteArray(p, &zero[0], (kVertexCount * kVertexStride));
+}
+
+static void WriteSyntheticEffect(const ::jz::string& aDirectory, const ::jz::string& aFilename)
+{
+    ::jz::system::IWriteFilePtr p = OpenSynthetic(aDirectory, aFilename);
+
+    for (size_t i = 0u; i < sizeof(kSyntheticEffectNames) / sizeof(kSyntheticEffectNames[0]); i++)
+    {
+        ::jz::system::WriteArray(p, kSyntheticEffectNames[i], strlen(kSyntheticEffectNames[i]) + 1u);
+    }
+}
+
+struct SyntheticScene
+{
+    template <typename T>
+    static void Append(::std::vector< ::jz::u8 >& arOut, const T& v)
+    {
+        const ::jz::u8* p = (const ::jz::u8*)(&v);
+        arOut.insert(arOut.end(), p, p + sizeof(T));
+    }
+
+    // In the format of ReadString().
+    static void AppendString(::std::vector< ::jz::u8 >& arOut, const ::jz::string& s)
+    {
+        Append(arOut, (::jz::u32)(s.size() + 1u));
+        arOut.insert(arOut.end(), s.c_str(), s.c_str() + s.size() + 1u);
+    }
+
+    static void Align(::std::vector< ::jz::u8 >& arOut)
+    {
+        arOut.resize((arOut.size() + ::jz::engine_3D::SceneFile::kAlignment - 1u) & ~((size_t)::jz::engine_3D::SceneFile::kAlignment - 1u), 0u);
+    }
+
+    void Add(::jz::u32 aParent, const ::jz::string& aId, ::jz::u32 aType, const ::jz::Matrix4& aLocal, const ::std::vector< ::jz::u8 >& aPayload)
+    {
+        ::jz::engine_3D::SceneFile::Node node;
+        node.Parent = aParent;
+        node.BaseId = (::jz::u32)Strings.size();
+        Strings.push_back(0u);
+        node.Id = (::jz::u32)Strings.size();
+        Strings.insert(Strings.end(), aId.c_str(), aId.c_str() + aId.size() + 1u);
+        node.Type = aType;
+        node.Payload = (::jz::u32)Payload.size();
+        node.PayloadSize = (::jz::u32)aPayload.size();
+        Payload.insert(Payload.end(), aPayload.begin(), aPayload.end());
+
+        Nodes.push_back(node);
+        Transforms.push_back(aLocal);
+    }
+
+    void Write(const ::jz::string& aDirectory, const ::jz::string& aFilename) const
+    {
+        using namespace jz;
+        using namespace jz::engine_3D;
+
+        vector<u8> data(sizeof(SceneFile::Header), 0u);
+        Align(data);
+
+        SceneFile::Header header;
+        memset(&header, 0, sizeof(header));
+        header.Magic = SceneFile::kMagic;
+        header.Version = SceneFile::kVersion;
+        header.HeaderSize = (u16)sizeof(SceneFile::Header);
+        header.NodeCount = (u32)Nodes.size();
+
+        header.TransformsOffset = (u32)data.size();
+        for (size_t i = 0u; i < Transforms.size(); i++) { Append(data, Transforms[i]); }
+        Align(data);
+
+        header.NodesOffset = (u32)data.size();
+        for (size_t i = 0u; i < Nodes.size(); i++) { Append(data, Nodes[i]); }
+        Align(data);
+
+        header.StringsOffset = (u32)data.size();
+        header.StringsSize = (u32)Strings.size();
+        data.insert(data.end(), Strings.begin(), Strings.end());
+        Align(data);
+
+        header.PayloadOffset = (u32)data.size();
+        header.PayloadSize = (u32)Payload.size();
+        data.insert(data.end(), Payload.begin(), Payload.end());
+
+        memcpy(&data[0], &header, sizeof(header));
+
+        system::IWriteFilePtr p = OpenSynthetic(aDirectory, aFilename);
+        system::WriteArray(p, &data[0], data.size());
+    }
+
+    ::std::vector< ::jz::Matrix4 > Transforms;
+    ::std::vector< ::jz::engine_3D::SceneFile::Node > Nodes;
+    ::std::vector< ::jz::u8 > Strings;
+    ::std::vector< ::jz::u8 > Payload;
+};
+
+// Node types, as numbered by SceneReader.
+namespace SyntheticType
+{
+    enum Enum
+    {
+        kDirectionalLight = 3,
+        kMesh = 6,
+        kNode = 7,
+        kPointLight = 9,
+        kSpotLight = 10
+    };
+}
+
+static void GenerateSynthetic(const ::jz::string& aDirectory, size_t aMeshesPerSide)
+{
+    using namespace jz;
+    using namespace jz::engine_3D;
+
+    for (size_t i = 0u; i < sizeof(kSyntheticEffects) / sizeof(kSyntheticEffects[0]); i++) { WriteSyntheticEffect(aDirectory, kSyntheticEffects[i]); }
+    for (size_t i = 0u; i < sizeof(kSyntheticBuiltInMeshes) / sizeof(kSyntheticBuiltInMeshes[0]); i++) { WriteSyntheticMesh(aDirectory, kSyntheticBuiltInMeshes[i]); }
+    for (size_t i = 0u; i < kSyntheticMaterialCount; i++)
+    {
+        system::IWriteFilePtr p = OpenSynthetic(aDirectory, SyntheticMaterial(i));
+        system::WriteInt32(p, 0);
+    }
+
+    {
+        system::IWriteFilePtr p = OpenSynthetic(aDirectory, kSyntheticVertexDeclaration);
+        system::WriteInt32(p, 0);
+    }
+
+    SyntheticScene scene;
+    vector<u8> payload;
+    const float kExtent = (kSyntheticSpacing * (float)aMeshesPerSide);
+    const Vector3 kOrigin(-0.5f * kExtent, 0.0f, -0.5f * kExtent);
+
+    scene.Add(SceneFile::kNoParent, "root", SyntheticType::kNode, Matrix4::kIdentity, payload);
+
+    for (size_t z = 0u; z < aMeshesPerSide; z++)
+    {
+        for (size_t x = 0u; x < aMeshesPerSide; x++)
+        {
+            payload.clear();
+            SyntheticScene::AppendString(payload, kSyntheticEffect);
+            SyntheticScene::AppendString(payload, SyntheticMaterial((x + z) % kSyntheticMaterialCount));
+            SyntheticScene::AppendString(payload, kSyntheticMesh);
+
+            const Vector3 kPosition = kOrigin + Vector3(kSyntheticSpacing * (float)x, 0.0f, kSyntheticSpacing * (float)z);
+            scene.Add(0u, "mesh" + StringUtility::ToString((uint)((z * aMeshesPerSide) + x)), SyntheticType::kMesh, Matrix4::CreateTranslation(kPosition), payload);
+        }
+    }
+
+    payload.clear();
+    SyntheticScene::Append(payload, Vector3::kOne);
+    scene.Add(0u, "sun", SyntheticType::kDirectionalLight, Matrix4::CreateRotationX(Radian(-Constants<float>::kPi * 0.25f)), payload);
+
+    for (size_t i = 0u; i < kSyntheticPointLightCount; i++)
+    {
+        const Radian kAngle((Constants<float>::kTwoPi * (float)i) / (float)kSyntheticPointLightCount);
+
+        payload.clear();
+        SyntheticScene::Append(payload, Vector3(1.0f, 0.1f, 0.01f));
+        SyntheticScene::Append(payload, Vector3::kOne);
+        scene.Add(0u, "point" + StringUtility::ToString((uint)i), SyntheticType::kPointLight,
+            Matrix4::CreateTranslation(Vector3(0.25f * kExtent * Cos(kAngle), 2.0f, 0.25f * kExtent * Sin(kAngle))), payload);
+    }
+
+    for (size_t i = 0u; i < kSyntheticSpotLightCount; i++)
+    {
+        payload.clear();
+        SyntheticScene::Append(payload, Constants<float>::kPi * 0.25f);
+        SyntheticScene::Append(payload, 1.0f);
+        SyntheticScene::Append(payload, Vector3(1.0f, 0.1f, 0.01f));
+        SyntheticScene::Append(payload, Vector3::kOne);
+        scene.Add(0u, "spot" + StringUtility::ToString((uint)i), SyntheticType::kSpotLight,
+            Matrix4::CreateRotationX(Radian(-Constants<float>::kPi * 0.5f)) *
+            Matrix4::CreateTranslation(Vector3((i == 0u) ? -0.25f * kExtent : 0.25f * kExtent, 8.0f, 0.0f)), payload);
+    }
+
+    scene.Write(aDirectory, kSyntheticScene);
+
+    printf("wrote %u nodes to %s/%s\n", (uint)scene.Nodes.size(), aDirectory.c_str(), kSyntheticScene);
+}
+#pragma endregion
+
+static void BenchmarkCodecs(int aFileCount, char** apFilenames)
+{
+    using namespace jz;
+    using namespace jz::filesystem;
+
+    ByteBuffer corpus;
+    for (int i = 0; i < aFileCount; i++)
+    {
+        system::IReadFilePtr pFile(new system::ReadFile(apFilenames[i]));
+        const size_t kOffset = corpus.size();
+        const size_t kSize = pFile->GetSize();
+
+        corpus.resize(kOffset + kSize);
+        JZ_E_ON_FAIL(pFile->Read(corpus.Get() + kOffset, kSize) == kSize, "failed reading corpus.");
+    }
+
+    JZ_E_ON_FAIL(corpus.size() > 0u, "empty corpus.");
+
+    const size_t kBlockDataSize = ((size_t)(1u << gskDefaultBlockSizePower) - sizeof(BlockHeader));
+
+    vector<BlockCodecStats> stats;
+    BlockCodecs::Benchmark(corpus, kBlockDataSize, stats);
+
+    printf("%u bytes in blocks of %u bytes\n", (uint)corpus.size(), (uint)kBlockDataSize);
+    printf("%-16s %12s %8s %12s %12s\n", "codec", "bytes", "ratio", "encode MB/s", "decode MB/s");
+    for (size_t i = 0u; i < stats.size(); i++)
+    {
+        const BlockCodecStats& s = stats[i];
+        printf("%-16s %12u %8.2f %12.1f %12.1f\n", s.pName, (uint)s.OutSize, s.GetRatio(), s.EncodeMBps, s.DecodeMBps);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "--codecs") == 0)
+    {
+        try
+        {
+            BenchmarkCodecs((argc - 2), (argv + 2));
+        }
+        catch (std::exception& e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "--generate") == 0)
+    {
+        try
+        {
+            const size_t kMeshesPerSide = (argc > 3) ? (size_t)atoi(argv[3]) : kDefaultMeshesPerSide;
+            GenerateSynthetic(argv[2], kMeshesPerSide);
+        }
+        catch (std::exception& e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <media directory or .dat> <scene> [frames] [warmup frames]\n", argv[0]);
+        fprintf(stderr, "       %s --generate <existing directory> [meshes per side]\n", argv[0]);
+        fprintf(stderr, "       %s --codecs <file> [more files...]\n", argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        using namespace jz;
+        using namespace jz::engine_3D;
+        using namespace jz::graphics;
+        using namespace jz::system;
+
+        const string kMedia(argv[1]);
+        const string kScene(argv[2]);
+        const size_t kFrames = (argc > 3) ? (size_t)atoi(argv[3]) : kDefaultFrames;
+        const size_t kWarmupFrames = (argc > 4) ? (size_t)atoi(argv[4]) : kDefaultWarmupFrames;
+
+#       if JZ_PLATFORM_WINDOWS
+            System system;
+#       else
+            Time time;
+            Files files;
+#       endif
+
+        if (kMedia.size() > 4u && kMedia.substr(kMedia.size() - 4u) == ".dat")
+        {
+            Files::GetSingleton().AddArchive(new ZipArchive(kMedia));
+        }
+        else
+        {
+            Files::GetSingleton().AddArchive(new FileArchive(kMedia));
+        }
+
+        Jobs jobs;
+        Graphics graphics;
+        {
+            RenderMan man;
+            PickMan pm;
+
+            Deferred::GetSingleton().SetActive(true);
+
+            SceneNodePtr pRoot(LoadScene(kScene));
+            pRoot->Update();
+            pRoot->Apply<LightNode>(ActivateShadowing);
+
+            const BoundingSphere kBounding = pRoot->GetBoundingSphere();
+            const float kFar = Max(2.0f * kBounding.Radius, 1.0f);
+
+            CameraNodePtr pCamera(new CameraNode(string(), "benchmark_camera"));
+            float ar = ((float)graphics.GetViewportWidth()) / ((float)graphics.GetViewportHeight());
+            pCamera->SetProjection(Matrix4::CreatePerspectiveFieldOfViewDirectX(Radian::kPiOver2, ar, (kFar * 1e-3f), kFar));
+            pCamera->SetActive(true);
+            pCamera->SetParent(pRoot.Get());
+
+            vector<IRenderable*> renderables;
+            s64 phaseNanoseconds[Phase::kCount] = { 0 };
+
+            for (size_t frame = 0u; frame < (kWarmupFrames + kFrames); frame++)
+            {
+                if (frame == kWarmupFrames)
+                {
+                    memset(phaseNanoseconds, 0, sizeof(phaseNanoseconds));
+                    gNullStatistics = NullStatistics::Create();
+                }
+
+                Time& t = Time::GetSingleton();
+                s64 start = t.GetAbsoluteNanoseconds();
+
+                t.Tick();
+                pCamera->SetLocalTransform(
+                    Matrix4::CreateRotationY(Radian(kCameraRadiansPerFrame * (float)frame)) *
+                    Matrix4::CreateTranslation(kBounding.Center));
+                pRoot->Update();
+
+                s64 update = t.GetAbsoluteNanoseconds();
+
+                Region frustum(-man.GetView().GetTranslation(), man.GetView() * man.GetProjection());
+                renderables.clear();
+                pRoot->Apply<IRenderable>(tr1::bind(GatherRenderables, tr1::ref(renderables), tr1::placeholders::_1));
+                {
+                    PoserBody poser(frustum, renderables);
+                    jobs.ParallelFor(poser, 0u, renderables.size(), kPoserGrainSize);
+                }
+                pRoot->Apply<LightNode>(tr1::bind(Lighter, frustum, pRoot, tr1::placeholders::_1));
+                pRoot->Apply<ReflectivePlaneNode>(tr1::bind(Reflector, frustum, pRoot, tr1::placeholders::_1));
+
+                s64 pose = t.GetAbsoluteNanoseconds();
+
+                man.Render();
+
+                s64 draw = t.GetAbsoluteNanoseconds();
+
+                phaseNanoseconds[Phase::kUpdate] += (update - start);
+                phaseNanoseconds[Phase::kPose] += (pose - update);
+                phaseNanoseconds[Phase::kDraw] += (draw - pose);
+            }
+
+            Report(phaseNanoseconds, kFrames, renderables.size());
+        }
+    }
+    catch (std::exception& e)
+    {
+        jz::LogMessage(e.what(), jz::Logger::kError);
+        fprintf(stderr, "%s\n", e.what());
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -113,7 +113,7 @@ namespace jz
             size_t size = mObjects.size();
             for (size_t i = 0u; i < size; i++) { t.push_back(i); }
 
-            BoundingBox aabb = CalculateTotalAABB(t, aAABBs);
+            BoundingBox aabb = AABBTreeHelpers::CalculateTotalAABB(t, aAABBs);
 
             mNodes.clear();
             #pragma region Insert a root node
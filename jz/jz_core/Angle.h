@@ -147,8 +147,8 @@ namespace jz
         return Radian(std::atan2(y, x));
     }
 
-    const Degree Constants<Degree>::kZeroTolerance = Degree(Constants<float>::kZeroTolerance);
-    const Radian Constants<Radian>::kZeroTolerance = Radian(Constants<float>::kZeroTolerance);
+    JZ_CONSTANT const Degree Constants<Degree>::kZeroTolerance = Degree(Constants<float>::kZeroTolerance);
+    JZ_CONSTANT const Radian Constants<Radian>::kZeroTolerance = Radian(Constants<float>::kZeroTolerance);
 
     __inline bool AboutZero(Degree a, float aEpsilon = Constants<float>::kZeroTolerance)
     {
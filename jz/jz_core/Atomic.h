@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_ATOMIC_H_
+#define _JZ_ATOMIC_H_
+
+#include <jz_core/Prereqs.h>
+
+#if JZ_PLATFORM_WINDOWS
+#   include <intrin.h>
+#   pragma intrinsic(_InterlockedIncrement)
+#   pragma intrinsic(_InterlockedDecrement)
+#   pragma intrinsic(_InterlockedExchange)
+#   pragma intrinsic(_InterlockedExchangeAdd)
+#   pragma intrinsic(_InterlockedCompareExchange)
+#   pragma intrinsic(_ReadWriteBarrier)
+#   pragma intrinsic(_mm_mfence)
+#endif
+
+namespace jz
+{
+
+    // Minimal set of atomic operations on 32-bit integers and pointers. All read-modify-write
+    // operations are full barriers. Load/store variants give acquire/release ordering, which
+    // is all that the single-producer/single-consumer queues in the codebase require.
+#   if JZ_PLATFORM_WINDOWS
+    JZ_STATIC_ASSERT(sizeof(long) == sizeof(s32));
+
+    __inline s32 AtomicIncrement(volatile s32* p) { return _InterlockedIncrement((volatile long*)p); }
+    __inline s32 AtomicDecrement(volatile s32* p) { return _InterlockedDecrement((volatile long*)p); }
+    __inline s32 AtomicExchange(volatile s32* p, s32 v) { return _InterlockedExchange((volatile long*)p, v); }
+    __inline s32 AtomicExchangeAdd(volatile s32* p, s32 v) { return _InterlockedExchangeAdd((volatile long*)p, v); }
+    __inline s32 AtomicCompareExchange(volatile s32* p, s32 aExchange, s32 aComparand) { return _InterlockedCompareExchange((volatile long*)p, aExchange, aComparand); }
+
+    __inline void_p AtomicCompareExchangePointer(void_p volatile* p, void_p aExchange, void_p aComparand)
+    {
+        JZ_STATIC_ASSERT(sizeof(void_p) == sizeof(long));
+        return (void_p)_InterlockedCompareExchange((volatile long*)p, (long)aExchange, (long)aComparand);
+    }
+
+    __inline void_p AtomicExchangePointer(void_p volatile* p, void_p v)
+    {
+        return (void_p)_InterlockedExchange((volatile long*)p, (long)v);
+    }
+
+    __inline void AtomicFence() { _mm_mfence(); }
+
+    // On x86, volatile loads have acquire and volatile stores have release semantics
+    // with VC8 and later, the barrier only prevents compiler reordering.
+    __inline s32 AtomicLoadAcquire(const volatile s32* p) { s32 ret = *p; _ReadWriteBarrier(); return ret; }
+    __inline void AtomicStoreRelease(volatile s32* p, s32 v) { _ReadWriteBarrier(); *p = v; }
+    __inline void_p AtomicLoadAcquirePointer(void_p const volatile* p) { void_p ret = *p; _ReadWriteBarrier(); return ret; }
+    __inline void AtomicStoreReleasePointer(void_p volatile* p, void_p v) { _ReadWriteBarrier(); *p = v; }
+#   else
+    __inline s32 AtomicIncrement(volatile s32* p) { return __sync_add_and_fetch(p, 1); }
+    __inline s32 AtomicDecrement(volatile s32* p) { return __sync_sub_and_fetch(p, 1); }
+    __inline s32 AtomicExchange(volatile s32* p, s32 v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+    __inline s32 AtomicExchangeAdd(volatile s32* p, s32 v) { return __sync_fetch_and_add(p, v); }
+    __inline s32 AtomicCompareExchange(volatile s32* p, s32 aExchange, s32 aComparand) { return __sync_val_compare_and_swap(p, aComparand, aExchange); }
+
+    __inline void_p AtomicCompareExchangePointer(void_p volatile* p, void_p aExchange, void_p aComparand)
+    {
+        return __sync_val_compare_and_swap(p, aComparand, aExchange);
+    }
+
+    __inline void_p AtomicExchangePointer(void_p volatile* p, void_p v)
+    {
+        return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+    }
+
+    __inline void AtomicFence() { __sync_synchronize(); }
+
+    __inline s32 AtomicLoadAcquire(const volatile s32* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+    __inline void AtomicStoreRelease(volatile s32* p, s32 v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+    __inline void_p AtomicLoadAcquirePointer(void_p const volatile* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+    __inline void AtomicStoreReleasePointer(void_p volatile* p, void_p v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+#   endif
+
+    // 32-bit integer that is only accessed atomically.
+    class AtomicInt sealed
+    {
+    public:
+        AtomicInt(s32 v = 0)
+            : mValue(v)
+        {}
+
+        s32 CompareExchange(s32 aExchange, s32 aComparand) { return AtomicCompareExchange(&mValue, aExchange, aComparand); }
+        s32 Decrement() { return AtomicDecrement(&mValue); }
+        s32 Exchange(s32 v) { return AtomicExchange(&mValue, v); }
+        s32 ExchangeAdd(s32 v) { return AtomicExchangeAdd(&mValue, v); }
+        s32 Increment() { return AtomicIncrement(&mValue); }
+
+        s32 Get() const { return AtomicLoadAcquire(&mValue); }
+        void Set(s32 v) { AtomicStoreRelease(&mValue, v); }
+
+        operator s32() const { return Get(); }
+
+    private:
+        AtomicInt(const AtomicInt&);
+        AtomicInt& operator=(const AtomicInt&);
+
+        volatile s32 mValue;
+    };
+
+    // Pointer that is only accessed atomically.
+    template <typename T>
+    class AtomicPointer sealed
+    {
+    public:
+        AtomicPointer(T* p = null)
+            : mpValue(p)
+        {}
+
+        T* CompareExchange(T* aExchange, T* aComparand) { return static_cast<T*>(AtomicCompareExchangePointer(&mpValue, aExchange, aComparand)); }
+        T* Exchange(T* p) { return static_cast<T*>(AtomicExchangePointer(&mpValue, p)); }
+
+        T* Get() const { return static_cast<T*>(AtomicLoadAcquirePointer(&mpValue)); }
+        void Set(T* p) { AtomicStoreReleasePointer(&mpValue, p); }
+
+        T* operator->() const { return Get(); }
+        operator T*() const { return Get(); }
+
+    private:
+        AtomicPointer(const AtomicPointer&);
+        AtomicPointer& operator=(const AtomicPointer&);
+
+        void_p volatile mpValue;
+    };
+
+}
+
+#endif
@@ -25,6 +25,11 @@
 #include <jz_core/CoordinateFrame3D.h>
 #include <jz_core/CoordinateFrame3D.h>
 #include <jz_core/Matrix4.h>
+#include <jz_core/Vector4.h>
+
+#if JZ_PLATFORM_SSE
+#   include <xmmintrin.h>
+#endif
 
 namespace jz
 {
@@ -170,4 +175,75 @@ namespace jz
         return ret;
     }
 
+    // Transforms the center and takes the extents through the absolute value of the
+    // transform (Arvo, "Transforming Axis-Aligned Bounding Boxes") instead of
+    // transforming 8 corners.
+    BoundingBox BoundingBox::MergeTransformed(const Vector4* apColumns, const BoundingBox* apBoxes, size_t aCount)
+    {
+#if JZ_PLATFORM_SSE
+        const __m128 kSign = _mm_set1_ps(-0.0f);
+        __m128 min = _mm_set1_ps(Constants<float>::kMax);
+        __m128 max = _mm_set1_ps(Constants<float>::kMin);
+
+        for (size_t i = 0u; i < aCount; i++)
+        {
+            const BoundingBox& box = apBoxes[i];
+            if (box.Min.X > box.Max.X) { continue; }
+
+            // Rows of the 4x3 transform; the fourth is the translation.
+            __m128 r0 = _mm_loadu_ps(apColumns[(3u * i) + 0u].pData);
+            __m128 r1 = _mm_loadu_ps(apColumns[(3u * i) + 1u].pData);
+            __m128 r2 = _mm_loadu_ps(apColumns[(3u * i) + 2u].pData);
+            __m128 r3 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            const Vector3 kCenter = box.Center();
+            const Vector3 kHalfExtents = box.HalfExtents();
+
+            __m128 center = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kCenter.X), r0), r3);
+            center = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kCenter.Y), r1), center);
+            center = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kCenter.Z), r2), center);
+
+            __m128 extents = _mm_mul_ps(_mm_set1_ps(kHalfExtents.X), _mm_andnot_ps(kSign, r0));
+            extents = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kHalfExtents.Y), _mm_andnot_ps(kSign, r1)), extents);
+            extents = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kHalfExtents.Z), _mm_andnot_ps(kSign, r2)), extents);
+
+            min = _mm_min_ps(min, _mm_sub_ps(center, extents));
+            max = _mm_max_ps(max, _mm_add_ps(center, extents));
+        }
+
+        float pMin[4];
+        float pMax[4];
+        _mm_storeu_ps(pMin, min);
+        _mm_storeu_ps(pMax, max);
+
+        return BoundingBox(Vector3(pMin[0], pMin[1], pMin[2]), Vector3(pMax[0], pMax[1], pMax[2]));
+#else
+        BoundingBox ret(kInvertedMax);
+
+        for (size_t i = 0u; i < aCount; i++)
+        {
+            const BoundingBox& box = apBoxes[i];
+            if (box.Min.X > box.Max.X) { continue; }
+
+            const Vector4* p = (apColumns + (3u * i));
+            const Vector3 kCenter = box.Center();
+            const Vector3 kHalfExtents = box.HalfExtents();
+
+            Vector3 center;
+            Vector3 extents;
+            for (int j = 0; j < 3; j++)
+            {
+                center[j] = (p[j].X * kCenter.X) + (p[j].Y * kCenter.Y) + (p[j].Z * kCenter.Z) + p[j].W;
+                extents[j] = (Abs(p[j].X) * kHalfExtents.X) + (Abs(p[j].Y) * kHalfExtents.Y) + (Abs(p[j].Z) * kHalfExtents.Z);
+            }
+
+            ret.Min = Vector3::Min(ret.Min, center - extents);
+            ret.Max = Vector3::Max(ret.Max, center + extents);
+        }
+
+        return ret;
+#endif
+    }
+
 }
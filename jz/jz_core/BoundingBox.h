@@ -36,6 +36,7 @@ namespace jz
     struct CoordinateFrame3D;
     struct Matrix4;
     struct Ray;
+    struct Vector4;
 
     struct BoundingBox
     {
@@ -171,6 +172,11 @@ namespace jz
 
         static BoundingBox Transform(const CoordinateFrame3D& cf, const BoundingBox& a);
         static BoundingBox Transform(const Matrix4& m, const BoundingBox& a);
+
+        // Merge of apBoxes[i] transformed by the affine transform whose first three columns
+        // are apColumns[(3 * i) + 0..2], as in a skinning palette. Inverted boxes are
+        // skipped; returns kInvertedMax if all of them are.
+        static BoundingBox MergeTransformed(const Vector4* apColumns, const BoundingBox* apBoxes, size_t aCount);
     };
     
 }
@@ -24,6 +24,7 @@
 #ifndef _JZ_BOUNDING_SPHERE_H_
 #define _JZ_BOUNDING_SPHERE_H_
 
+#include <jz_core/Matrix3.h>
 #include <jz_core/Memory.h>
 #include <jz_core/Plane.h>
 #include <jz_core/Vector3.h>
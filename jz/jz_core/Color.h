@@ -146,6 +146,8 @@ namespace jz
             R = b.R;
             G = b.G;
             B = b.B;
+
+            return *this;
         }
 
         static const ColorRGBu kBlack;
@@ -20,48 +20,557 @@
 // THE SOFTWARE.
 //
 
+#include <jz_core/Atomic.h>
 #include <jz_core/Logger.h>
+#include <jz_core/Memory.h>
 #include <jz_core/StringUtility.h>
+#include <cstddef>
 #include <iostream>
 #include <time.h>
 
+#if JZ_PLATFORM_WINDOWS
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#   include <unistd.h>
+#endif
+
 namespace jz
 {
 
     const char* Logger::kLogFilename = "jz.log";
     const char* Logger::kTab = "    ";
 
-    bool Logger::msbLogBufferDirty = false;
+    volatile bool Logger::msbLogBufferDirty = false;
     uint Logger::msLogBufferTop = 0u;
 
     ofstream Logger::msLogStream;
     string Logger::msLogBuffer[Logger::kBufferLineCount];
 
     bool Logger::msbAttemptedOpen = false;
+    volatile Logger::MessageType Logger::msMinSeverity = (Logger::MessageType)JZ_LOG_MIN_SEVERITY;
 
-    void Logger::LogMessage(const string& s, Logger::MessageType t)
+#pragma region Platform helpers
+    class LoggerMutex
     {
-        static uint sLogBufferIndex = 0u;
+    public:
+#       if JZ_PLATFORM_WINDOWS
+            LoggerMutex() { InitializeCriticalSection(&mSection); }
+            ~LoggerMutex() { DeleteCriticalSection(&mSection); }
+
+            void Lock() { EnterCriticalSection(&mSection); }
+            void Unlock() { LeaveCriticalSection(&mSection); }
+#       else
+            LoggerMutex() { pthread_mutex_init(&mMutex, null); }
+            ~LoggerMutex() { pthread_mutex_destroy(&mMutex); }
+
+            void Lock() { pthread_mutex_lock(&mMutex); }
+            void Unlock() { pthread_mutex_unlock(&mMutex); }
+#       endif
+
+    private:
+        LoggerMutex(const LoggerMutex&);
+        LoggerMutex& operator=(const LoggerMutex&);
+
+#       if JZ_PLATFORM_WINDOWS
+            CRITICAL_SECTION mSection;
+#       else
+            pthread_mutex_t mMutex;
+#       endif
+    };
+
+    class LoggerLock
+    {
+    public:
+        explicit LoggerLock(LoggerMutex& aMutex)
+            : mMutex(aMutex)
+        {
+            mMutex.Lock();
+        }
+
+        ~LoggerLock()
+        {
+            mMutex.Unlock();
+        }
+
+    private:
+        LoggerLock(const LoggerLock&);
+        LoggerLock& operator=(const LoggerLock&);
+
+        LoggerMutex& mMutex;
+    };
+
+    static void _LoggerSleep(unatural aMilliseconds)
+    {
+#       if JZ_PLATFORM_WINDOWS
+            ::Sleep(aMilliseconds);
+#       else
+            usleep(aMilliseconds * 1000u);
+#       endif
+    }
+#pragma endregion
+
+#pragma region Thread queues
+    // Single-producer (the owning thread), single-consumer (whichever thread holds
+    // gsWriterMutex) ring of variable sized records. Read and Write increase
+    // monotonically and are masked into Data.
+    //
+    // Queues are never unlinked, the writer may be draining one when its thread exits.
+    // The thread releases it instead (bOwned back to 0) and the next thread that logs
+    // claims it, so the list only grows to the peak count of threads logging at once.
+    struct LoggerQueue
+    {
+        LoggerQueue* pNext;
+        volatile s32 bOwned;
+        s32 Padding;
+        volatile s32 Read;
+        volatile s32 Write;
+        u8 Data[Logger::kThreadQueueSize];
+    };
+
+    struct LoggerRecordHeader
+    {
+        u32 Size;
+        u8 Type;
+        u8 Category;
+        u16 ArgCount;
+        s64 Time;
+        const char* pFormat;
+    };
+
+    struct LoggerArgHeader
+    {
+        u32 Type;
+        u32 Size;
+    };
 
-        struct tm localTime;
+    JZ_STATIC_ASSERT((Logger::kThreadQueueSize & (Logger::kThreadQueueSize - 1u)) == 0u);
 
-        time_t curTime;
-        time(&curTime);
+    static const u32 kRecordAlignment = 8u;
+    static const u32 kPadFlag = (1u << 31);
+    static const u32 kMaxStringSize = (Logger::kThreadQueueSize >> 4);
+    static const u32 kQueueMask = (Logger::kThreadQueueSize - 1u);
+
+    JZ_STATIC_ASSERT((offsetof(LoggerQueue, Data) % kRecordAlignment) == 0u);
+
+    static __inline u32 _RoundUp(u32 a) { return (a + (kRecordAlignment - 1u)) & ~(kRecordAlignment - 1u); }
+
+    static JZ_THREAD_LOCAL LoggerQueue* tlspQueue = null;
+    static void_p volatile gspQueues = null;
+    static volatile s32 gsDroppedCount = 0;
+    static volatile s32 gsQueueCount = 0;
+
+    // 0 - not started, 1 - running, 2 - no writer thread (stopped or failed to start).
+    static volatile s32 gsWriterState = 0;
+    static volatile s32 gsbStopWriter = 0;
+    static volatile s32 gsbShutdown = 0;
+
+    static LoggerMutex gsWriterMutex;
+    static LoggerMutex gsBufferMutex;
+
+    // Called on the exiting thread. Records still in the queue are drained as usual, the
+    // next owner appends after them.
+    static void _ReleaseThreadQueue(LoggerQueue* p)
+    {
+        // Queues are freed at static destruction.
+        if (p && AtomicLoadAcquire(&gsbShutdown) == 0)
+        {
+            tlspQueue = null;
+            AtomicStoreRelease(&p->bOwned, 0);
+        }
+    }
+
+#   if JZ_PLATFORM_WINDOWS
+        static VOID WINAPI _OnThreadExit(PVOID ap) { _ReleaseThreadQueue((LoggerQueue*)ap); }
+        static DWORD gsQueueKey = FLS_OUT_OF_INDEXES;
+#   else
+        static void _OnThreadExit(void_p ap) { _ReleaseThreadQueue((LoggerQueue*)ap); }
+        static pthread_key_t gsQueueKey;
+#   endif
+
+    // 0 - not created, 1 - being created, 2 - created, 3 - failed.
+    static volatile s32 gsQueueKeyState = 0;
+
+    // JZ_THREAD_LOCAL has no destructor, so a thread exit hook is taken from a TLS key
+    // that holds the same queue.
+    static bool _CreateQueueKey()
+    {
+        if (AtomicCompareExchange(&gsQueueKeyState, 1, 0) == 0)
+        {
+#           if JZ_PLATFORM_WINDOWS
+                gsQueueKey = FlsAlloc(&_OnThreadExit);
+                bool bCreated = (gsQueueKey != FLS_OUT_OF_INDEXES);
+#           else
+                bool bCreated = (pthread_key_create(&gsQueueKey, &_OnThreadExit) == 0);
+#           endif
+
+            AtomicStoreRelease(&gsQueueKeyState, (bCreated) ? 2 : 3);
+        }
+
+        s32 state;
+        while ((state = AtomicLoadAcquire(&gsQueueKeyState)) == 1) { _LoggerSleep(0u); }
+
+        return (state == 2);
+    }
+
+    static LoggerQueue* _GetThreadQueue()
+    {
+        if (!tlspQueue)
+        {
+            LoggerQueue* p = null;
+            for (LoggerQueue* q = (LoggerQueue*)AtomicLoadAcquirePointer(&gspQueues); q; q = q->pNext)
+            {
+                if (AtomicCompareExchange(&q->bOwned, 1, 0) == 0) { p = q; break; }
+            }
+
+            if (!p)
+            {
+                p = (LoggerQueue*)Malloc(sizeof(LoggerQueue), kRecordAlignment);
+                p->bOwned = 1;
+                p->Read = 0;
+                p->Write = 0;
+                AtomicIncrement(&gsQueueCount);
+
+                void_p pHead;
+                do
+                {
+                    pHead = AtomicLoadAcquirePointer(&gspQueues);
+                    p->pNext = (LoggerQueue*)pHead;
+                } while (AtomicCompareExchangePointer(&gspQueues, p, pHead) != pHead);
+            }
+
+            tlspQueue = p;
+
+            // Without a key the queue is kept until static destruction.
+            if (_CreateQueueKey())
+            {
+#               if JZ_PLATFORM_WINDOWS
+                    FlsSetValue(gsQueueKey, p);
+#               else
+                    pthread_setspecific(gsQueueKey, p);
+#               endif
+            }
+        }
+
+        return tlspQueue;
+    }
+
+    static u32 _GetRecordSize(const LogArg* const* apArgs, uint aArgCount)
+    {
+        u32 ret = sizeof(LoggerRecordHeader);
+        for (uint i = 0u; i < aArgCount; i++)
+        {
+            u32 argSize = (apArgs[i]->GetType() == LogArg::kString) ? jz::Min((u32)apArgs[i]->GetStringSize(), kMaxStringSize) : (u32)sizeof(u64);
+            ret += sizeof(LoggerArgHeader) + _RoundUp(argSize);
+        }
+
+        return _RoundUp(ret);
+    }
+
+    static void _Encode(u8* p, u32 aSize, Logger::Category c, Logger::MessageType t, const char* apFormat, const LogArg* const* apArgs, uint aArgCount)
+    {
+        LoggerRecordHeader& h = *((LoggerRecordHeader*)p);
+        h.Size = aSize;
+        h.Type = (u8)t;
+        h.Category = (u8)c;
+        h.ArgCount = (u16)aArgCount;
+        h.Time = (s64)time(null);
+        h.pFormat = apFormat;
+        p += sizeof(LoggerRecordHeader);
+
+        for (uint i = 0u; i < aArgCount; i++)
+        {
+            const LogArg& a = *(apArgs[i]);
+            LoggerArgHeader& ah = *((LoggerArgHeader*)p);
+            ah.Type = (u32)a.GetType();
+            p += sizeof(LoggerArgHeader);
+
+            switch (a.GetType())
+            {
+                case LogArg::kSigned: ah.Size = sizeof(s64); *((s64*)p) = a.GetSigned(); break;
+                case LogArg::kUnsigned: ah.Size = sizeof(u64); *((u64*)p) = a.GetUnsigned(); break;
+                case LogArg::kPointer: ah.Size = sizeof(u64); *((u64*)p) = a.GetUnsigned(); break;
+                case LogArg::kFloat: ah.Size = sizeof(double); *((double*)p) = a.GetFloat(); break;
+                case LogArg::kString:
+                    ah.Size = jz::Min((u32)a.GetStringSize(), kMaxStringSize);
+                    memcpy(p, a.GetString(), ah.Size);
+                break;
+                default:
+                    JZ_ASSERT(false);
+                break;
+            }
+
+            p += _RoundUp(ah.Size);
+        }
+    }
+
+    static string _Format(const char* apFormat, const u8* apArgs, uint aArgCount)
+    {
+        string ret;
+
+        for (const char* p = apFormat; *p != string_terminator; p++)
+        {
+            if (*p != '%') { ret += *p; continue; }
+            if (*(p + 1) == '%') { ret += '%'; p++; continue; }
+            if (aArgCount == 0u) { ret += '%'; continue; }
+
+            const LoggerArgHeader& h = *((const LoggerArgHeader*)apArgs);
+            const u8* pData = (apArgs + sizeof(LoggerArgHeader));
+
+            switch (h.Type)
+            {
+                case LogArg::kSigned:
+                    {
+                        s64 v = *((const s64*)pData);
+                        if (v < 0) { ret += '-' + StringUtility::ToString((u64)(-v)); }
+                        else { ret += StringUtility::ToString((u64)v); }
+                    }
+                break;
+                case LogArg::kUnsigned: ret += StringUtility::ToString(*((const u64*)pData)); break;
+                case LogArg::kFloat: ret += StringUtility::ToString((float)(*((const double*)pData))); break;
+                case LogArg::kString: ret.append((const char*)pData, h.Size); break;
+                case LogArg::kPointer: ret += StringUtility::ToString((size_t)(*((const u64*)pData)), true); break;
+                default:
+                    JZ_ASSERT(false);
+                break;
+            }
+
+            apArgs += sizeof(LoggerArgHeader) + _RoundUp(h.Size);
+            aArgCount--;
+        }
+
+        return ret;
+    }
+#pragma endregion
+
+    struct LoggerWriter
+    {
+        static void WriteRecord(const LoggerRecordHeader& h)
+        {
+            time_t t = (time_t)h.Time;
+            struct tm localTime;
 
 #if defined(_MSC_VER) && (_MSC_VER >= 1400)
-        errno_t error = localtime_s(&localTime, &curTime);
-        JZ_ASSERT(error == 0);
+            errno_t error = localtime_s(&localTime, &t);
+            JZ_ASSERT(error == 0);
 #else
-        localTime = localtime(&curTime);
+            localtime_r(&t, &localTime);
 #endif
-        string message = string("[") + _TypeToString(t) + ": " + 
-            StringUtility::ToString(localTime.tm_hour) + ":" +
-            StringUtility::ToString(localTime.tm_min)  + ":" +
-            StringUtility::ToString(localTime.tm_sec) + "]: " + s;
+            Logger::MessageType type = (Logger::MessageType)h.Type;
+            string message = string("[") + Logger::_TypeToString(type) + ": " + 
+                StringUtility::ToString(localTime.tm_hour) + ":" +
+                StringUtility::ToString(localTime.tm_min)  + ":" +
+                StringUtility::ToString(localTime.tm_sec) + "]: " +
+                _Format(h.pFormat, ((const u8*)&h) + sizeof(LoggerRecordHeader), h.ArgCount);
+
+            Logger::_Write(type, message);
+        }
+
+        // Consumes all pending records. Must be called with gsWriterMutex held. Returns
+        // true if an error was written, in which case the caller should flush.
+        static bool Drain()
+        {
+            bool bError = false;
 
+            for (LoggerQueue* q = (LoggerQueue*)AtomicLoadAcquirePointer(&gspQueues); q; q = q->pNext)
+            {
+                u32 read = (u32)q->Read;
+                u32 write = (u32)AtomicLoadAcquire(&q->Write);
+
+                while (read != write)
+                {
+                    const LoggerRecordHeader& h = *((const LoggerRecordHeader*)(q->Data + (read & kQueueMask)));
+
+                    if ((h.Size & kPadFlag) == 0u)
+                    {
+                        WriteRecord(h);
+                        bError = bError || (h.Type == Logger::kError);
+                    }
+
+                    read += (h.Size & ~kPadFlag);
+                    AtomicStoreRelease(&q->Read, (s32)read);
+                }
+            }
+
+            return bError;
+        }
+
+        static void Flush()
+        {
+            if (Logger::msLogStream.is_open()) { Logger::msLogStream.flush(); }
+            else { cerr.flush(); }
+        }
+
+        static void Run()
+        {
+            const unatural kFlushTicks = jz::Max(Logger::kFlushIntervalMilliseconds / Logger::kWriterSleepMilliseconds, (unatural)1u);
+            unatural ticks = 0u;
+
+            while (AtomicLoadAcquire(&gsbStopWriter) == 0)
+            {
+                {
+                    LoggerLock lock(gsWriterMutex);
+                    bool bError = Drain();
+
+                    if (bError || ++ticks >= kFlushTicks)
+                    {
+                        Flush();
+                        ticks = 0u;
+                    }
+                }
+
+                _LoggerSleep(Logger::kWriterSleepMilliseconds);
+            }
+        }
+
+#       if JZ_PLATFORM_WINDOWS
+            static DWORD WINAPI ThreadStart(LPVOID) { Run(); return 0u; }
+            static HANDLE msThread;
+#       else
+            static void_p ThreadStart(void_p) { Run(); return null; }
+            static pthread_t msThread;
+#       endif
+
+        static void Start()
+        {
+            if (AtomicCompareExchange(&gsWriterState, 1, 0) != 0) { return; }
+
+#           if JZ_PLATFORM_WINDOWS
+                DWORD d;
+                msThread = CreateThread(null, 0u, &ThreadStart, null, 0u, &d);
+                bool bStarted = (msThread != null);
+                if (bStarted) { SetThreadPriority(msThread, THREAD_PRIORITY_BELOW_NORMAL); }
+#           else
+                bool bStarted = (pthread_create(&msThread, null, &ThreadStart, null) == 0);
+#           endif
+
+            if (!bStarted) { AtomicExchange(&gsWriterState, 2); }
+        }
+
+        static void Stop()
+        {
+            if (AtomicCompareExchange(&gsWriterState, 2, 1) == 1)
+            {
+                AtomicExchange(&gsbStopWriter, 1);
+#               if JZ_PLATFORM_WINDOWS
+                    WaitForSingleObject(msThread, INFINITE);
+                    CloseHandle(msThread);
+#               else
+                    pthread_join(msThread, null);
+#               endif
+            }
+            else
+            {
+                AtomicExchange(&gsWriterState, 2);
+            }
+
+            LoggerLock lock(gsWriterMutex);
+            Drain();
+            Flush();
+        }
+    };
+
+#   if JZ_PLATFORM_WINDOWS
+        HANDLE LoggerWriter::msThread = null;
+#   else
+        pthread_t LoggerWriter::msThread;
+#   endif
+
+    // Stops the writer thread and releases queues at static destruction. Declared after
+    // msLogStream so that it is destroyed first.
+    static struct LoggerShutdown
+    {
+        ~LoggerShutdown()
+        {
+            LoggerWriter::Stop();
+            AtomicExchange(&gsbShutdown, 1);
+
+            // Threads that exit from here on must not touch the queues.
+            if (AtomicLoadAcquire(&gsQueueKeyState) == 2)
+            {
+#               if JZ_PLATFORM_WINDOWS
+                    FlsFree(gsQueueKey);
+#               else
+                    pthread_key_delete(gsQueueKey);
+#               endif
+            }
+
+            LoggerQueue* p = (LoggerQueue*)AtomicLoadAcquirePointer(&gspQueues);
+            AtomicStoreReleasePointer(&gspQueues, null);
+
+            while (p)
+            {
+                LoggerQueue* pNext = p->pNext;
+                Free(p);
+                p = pNext;
+            }
+            tlspQueue = null;
+        }
+    } gsLoggerShutdown;
+
+    void Logger::_Log(Category c, MessageType t, const char* apFormat, const LogArg* const* apArgs, uint aArgCount)
+    {
+        JZ_ASSERT(apFormat != null);
+        JZ_ASSERT(aArgCount <= Constants<u16>::kMax);
+
+        if (t < msMinSeverity) { return; }
+
+        u32 size = _GetRecordSize(apArgs, aArgCount);
+
+        // Thread queues are gone during static destruction, write directly.
+        if (AtomicLoadAcquire(&gsbShutdown) != 0)
+        {
+            ByteBuffer buf(size);
+            _Encode(buf.Get(), size, c, t, apFormat, apArgs, aArgCount);
+
+            LoggerLock lock(gsWriterMutex);
+            LoggerWriter::WriteRecord(*((const LoggerRecordHeader*)buf.Get()));
+            LoggerWriter::Flush();
+            return;
+        }
+
+        LoggerQueue* q = _GetThreadQueue();
+        u32 write = (u32)q->Write;
+        u32 read = (u32)AtomicLoadAcquire(&q->Read);
+        u32 offset = (write & kQueueMask);
+        u32 tail = (kThreadQueueSize - offset);
+        u32 needed = (tail < size) ? (tail + size) : size;
+
+        // Never block the caller, a full queue drops the message.
+        if ((kThreadQueueSize - (write - read)) < needed)
+        {
+            AtomicIncrement(&gsDroppedCount);
+            return;
+        }
+
+        if (tail < size)
+        {
+            ((LoggerRecordHeader*)(q->Data + offset))->Size = (tail | kPadFlag);
+            write += tail;
+            offset = 0u;
+        }
+
+        _Encode(q->Data + offset, size, c, t, apFormat, apArgs, aArgCount);
+        AtomicStoreRelease(&q->Write, (s32)(write + size));
+
+        if (AtomicLoadAcquire(&gsWriterState) == 0) { LoggerWriter::Start(); }
+
+        // No writer thread could be started, write synchronously.
+        if (AtomicLoadAcquire(&gsWriterState) == 2)
+        {
+            LoggerLock lock(gsWriterMutex);
+            LoggerWriter::Drain();
+            LoggerWriter::Flush();
+        }
+    }
+
+    void Logger::_Write(MessageType t, const string& aMessage)
+    {
         if (msLogStream.is_open())
         {
-            msLogStream << message << endl;
+            msLogStream << aMessage << endl;
 #ifdef NDEBUG
             if (t == kError)
             {
@@ -76,18 +585,18 @@ namespace jz
             try
             {
                 msLogStream.open(kLogFilename);
-                msLogStream << message << endl;
+                msLogStream << aMessage << endl;
             }
             catch (...)
             {
-                cerr << __FUNCTION__ ": failed to open log file. Using cerr instead." << endl;
+                cerr << __FUNCTION__ << ": failed to open log file. Using cerr instead." << endl;
                 cerr.flush();
             }
             msbAttemptedOpen = true;
         }
         else
         {
-            cerr << message << endl;
+            cerr << aMessage << endl;
 #ifdef NDEBUG
             if (t == kError)
             {
@@ -98,6 +607,10 @@ namespace jz
 #endif
         }
 
+        static uint sLogBufferIndex = 0u;
+
+        LoggerLock lock(gsBufferMutex);
+        string message = aMessage;
         string buf;
 
         while (message.size() > 0u)
@@ -146,8 +659,74 @@ namespace jz
         msbLogBufferDirty = true;
     }
 
+    void Logger::Log(Category c, MessageType t, const char* apFormat)
+    {
+        _Log(c, t, apFormat, null, 0u);
+    }
+
+    void Logger::Log(Category c, MessageType t, const char* apFormat, const LogArg& a0)
+    {
+        const LogArg* args[] = { &a0 };
+        _Log(c, t, apFormat, args, 1u);
+    }
+
+    void Logger::Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1)
+    {
+        const LogArg* args[] = { &a0, &a1 };
+        _Log(c, t, apFormat, args, 2u);
+    }
+
+    void Logger::Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2)
+    {
+        const LogArg* args[] = { &a0, &a1, &a2 };
+        _Log(c, t, apFormat, args, 3u);
+    }
+
+    void Logger::Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3)
+    {
+        const LogArg* args[] = { &a0, &a1, &a2, &a3 };
+        _Log(c, t, apFormat, args, 4u);
+    }
+
+    void Logger::Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4)
+    {
+        const LogArg* args[] = { &a0, &a1, &a2, &a3, &a4 };
+        _Log(c, t, apFormat, args, 5u);
+    }
+
+    void Logger::Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5)
+    {
+        const LogArg* args[] = { &a0, &a1, &a2, &a3, &a4, &a5 };
+        _Log(c, t, apFormat, args, 6u);
+    }
+
+    void Logger::LogMessage(const string& s, Logger::MessageType t)
+    {
+        LogArg arg(s);
+        const LogArg* args[] = { &arg };
+        _Log(kGeneral, t, "%", args, 1u);
+    }
+
+    void Logger::Flush()
+    {
+        LoggerLock lock(gsWriterMutex);
+        LoggerWriter::Drain();
+        LoggerWriter::Flush();
+    }
+
+    unatural Logger::GetDroppedCount()
+    {
+        return (unatural)AtomicLoadAcquire(&gsDroppedCount);
+    }
+
+    unatural Logger::GetThreadQueueCount()
+    {
+        return (unatural)AtomicLoadAcquire(&gsQueueCount);
+    }
+
     string Logger::GetLogBuffer()
     {
+        LoggerLock lock(gsBufferMutex);
         string output;
 
         for (size_t i = msLogBufferTop; i < kBufferLineCount; i++)
@@ -170,6 +749,7 @@ namespace jz
 
     void Logger::GetLogBuffer(vector<string>& arLogBuffer)
     {
+        LoggerLock lock(gsBufferMutex);
         arLogBuffer.clear();
         
         for (size_t i = msLogBufferTop; i < kBufferLineCount; i++)
@@ -190,6 +770,11 @@ namespace jz
 
     void Logger::SetLogFilename(const char* apFilename, bool abAppend)
     {
+        LoggerLock lock(gsWriterMutex);
+
+        // Pending messages go to the previous file.
+        LoggerWriter::Drain();
+
         try
         {
             if (msLogStream.is_open())
@@ -202,7 +787,7 @@ namespace jz
         }
         catch (...)
         {
-            cerr << __FUNCTION__ ": failed to open log file. Using cerr instead." << endl;
+            cerr << __FUNCTION__ << ": failed to open log file. Using cerr instead." << endl;
             cerr.flush();
         }
         msbAttemptedOpen = true;        
@@ -25,27 +25,124 @@
 #define _JZ_LOGGER_H_
 
 #include <jz_core/Prereqs.h>
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <vector>
 
+// Compile time filtering. A JZ_LOG() with a severity below JZ_LOG_MIN_SEVERITY, or a
+// category whose bit is not set in JZ_LOG_CATEGORY_MASK, compiles to nothing.
+#ifndef JZ_LOG_MIN_SEVERITY
+#   ifdef NDEBUG
+#       define JZ_LOG_MIN_SEVERITY 1
+#   else
+#       define JZ_LOG_MIN_SEVERITY 0
+#   endif
+#endif
+
+#ifndef JZ_LOG_CATEGORY_MASK
+#   define JZ_LOG_CATEGORY_MASK 0xFFFFFFFF
+#endif
+
+// Usage: JZ_LOG(Logger::kGraphics, Logger::kWarning, "loaded % in % ms", name, ms);
+// Each % in the format is replaced with the next argument. The format must be a
+// string literal, it is stored by pointer and only expanded on the writer thread.
+#define JZ_LOG(category, severity, ...) \
+    do { \
+        if ((int)(severity) >= JZ_LOG_MIN_SEVERITY && ((1u << (category)) & (JZ_LOG_CATEGORY_MASK)) != 0u) \
+        { \
+            ::jz::Logger::Log((category), (severity), __VA_ARGS__); \
+        } \
+    } while (false)
+
 namespace jz
 {
 
+    // An argument recorded by JZ_LOG. Holds a reference to (not a copy of) string data,
+    // the data is copied into the per-thread queue before Logger::Log() returns.
+    class LogArg
+    {
+    public:
+        enum Type
+        {
+            kSigned,
+            kUnsigned,
+            kFloat,
+            kString,
+            kPointer
+        };
+
+        LogArg(int v) : mType(kSigned) { mSigned = v; }
+        LogArg(long v) : mType(kSigned) { mSigned = v; }
+        LogArg(s64 v) : mType(kSigned) { mSigned = v; }
+        LogArg(uint v) : mType(kUnsigned) { mUnsigned = v; }
+        LogArg(ulong v) : mType(kUnsigned) { mUnsigned = v; }
+        LogArg(u64 v) : mType(kUnsigned) { mUnsigned = v; }
+        LogArg(float v) : mType(kFloat) { mFloat = v; }
+        LogArg(double v) : mType(kFloat) { mFloat = v; }
+        LogArg(const char* v) : mType(kString) { mString.p = (v) ? v : ""; mString.Size = strlen(mString.p); }
+        LogArg(const string& v) : mType(kString) { mString.p = v.c_str(); mString.Size = v.size(); }
+        LogArg(voidc_p v) : mType(kPointer) { mUnsigned = (u64)(size_t)v; }
+
+        Type GetType() const { return mType; }
+
+        s64 GetSigned() const { return mSigned; }
+        u64 GetUnsigned() const { return mUnsigned; }
+        double GetFloat() const { return mFloat; }
+        const char* GetString() const { return mString.p; }
+        size_t GetStringSize() const { return mString.Size; }
+
+    private:
+        Type mType;
+
+        union
+        {
+            s64 mSigned;
+            u64 mUnsigned;
+            double mFloat;
+            struct
+            {
+                const char* p;
+                size_t Size;
+            } mString;
+        };
+    };
+
+    // Messages are recorded into a lock-free queue owned by the calling thread and
+    // formatted and written to the log file by a background writer thread, so the
+    // cost at the call site is a copy of the arguments.
     class Logger
     {
     public:
         static const unatural kBufferLineCount = 10u;
         static const unatural kLineWidth = 80u;
+        static const unatural kFlushIntervalMilliseconds = 100u;
+        static const unatural kWriterSleepMilliseconds = 5u;
+        static const unatural kThreadQueueSize = (1 << 16);
 
         static const char* kLogFilename;
         static const char* kTab;
 
         enum MessageType
         {
-            kNormal,
-            kWarning,
-            kError
+            kVerbose = 0,
+            kNormal = 1,
+            kWarning = 2,
+            kError = 3
+        };
+
+        enum Category
+        {
+            kGeneral = 0,
+            kCore = 1,
+            kSystem = 2,
+            kFilesystem = 3,
+            kGraphics = 4,
+            kEngine = 5,
+            kPhysics = 6,
+            kSound = 7,
+            kGui = 8,
+            kCategoryCount
         };
 
         static bool IsLogBufferDirty() { return msbLogBufferDirty; }
@@ -54,19 +151,48 @@ namespace jz
         JZ_EXPORT static void GetLogBuffer(vector<string>& arLogBuffer);
         JZ_EXPORT static void LogMessage(const string& s, MessageType t = kNormal);
 
+        JZ_EXPORT static void Log(Category c, MessageType t, const char* apFormat);
+        JZ_EXPORT static void Log(Category c, MessageType t, const char* apFormat, const LogArg& a0);
+        JZ_EXPORT static void Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1);
+        JZ_EXPORT static void Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2);
+        JZ_EXPORT static void Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3);
+        JZ_EXPORT static void Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4);
+        JZ_EXPORT static void Log(Category c, MessageType t, const char* apFormat, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5);
+
+        // Drains all thread queues and flushes the log file on the calling thread.
+        JZ_EXPORT static void Flush();
+
+        // Messages dropped because a thread queue was full.
+        JZ_EXPORT static unatural GetDroppedCount();
+
+        // Thread queues allocated, the peak number of threads that have logged at once.
+        JZ_EXPORT static unatural GetThreadQueueCount();
+
+        // Runtime filter applied on top of the compile time filter, cheap enough to leave
+        // verbose logging compiled in.
+        static MessageType GetMinSeverity() { return msMinSeverity; }
+        static void SetMinSeverity(MessageType t) { msMinSeverity = t; }
+
         JZ_EXPORT static void SetLogFilename(const char* apFilename, bool abAppend = false);
 
     private:
         static ofstream msLogStream;
         static string msLogBuffer[kBufferLineCount];
-        static bool msbLogBufferDirty;
+        static volatile bool msbLogBufferDirty;
         static uint msLogBufferTop;
         static bool msbAttemptedOpen;
+        static volatile MessageType msMinSeverity;
+
+        friend struct LoggerWriter;
+
+        static void _Log(Category c, MessageType t, const char* apFormat, const LogArg* const* apArgs, uint aArgCount);
+        static void _Write(MessageType t, const string& aMessage);
 
         static const char* _TypeToString(MessageType t)
         {
             switch (t)
             {
+                case kVerbose: return "VERBOSE"; break;
                 case kNormal: return "NORMAL"; break;
                 case kWarning: return "WARNING"; break;
                 case kError: return "ERROR"; break;
@@ -25,6 +25,7 @@
 #define _JZ_MATH_H_
 
 #include <jz_core/Prereqs.h>
+#include <cmath>
 
 namespace jz
 {
@@ -38,26 +39,26 @@ namespace jz
     double UniformRandomd();
 
     template <typename T>
-    __inline bool AboutEqual(T a, T b, T aEpsilon = Constants<T>::kZeroTolerance)
+    __inline T Abs(T a)
     {
         JZ_STATIC_ASSERT(std::numeric_limits<T>::is_specialized);
+        JZ_STATIC_ASSERT(std::numeric_limits<T>::is_signed);
 
-        return (Abs(a - b) < aEpsilon);
+        return (a < T(0)) ? -a : a;
     }
 
     template <typename T>
-    __inline bool AboutZero(T a, T aEpsilon = Constants<T>::kZeroTolerance)
+    __inline bool AboutEqual(T a, T b, T aEpsilon = Constants<T>::kZeroTolerance)
     {
-        return (Abs(a) < aEpsilon);
+        JZ_STATIC_ASSERT(std::numeric_limits<T>::is_specialized);
+
+        return (Abs(a - b) < aEpsilon);
     }
 
     template <typename T>
-    __inline T Abs(T a)
+    __inline bool AboutZero(T a, T aEpsilon = Constants<T>::kZeroTolerance)
     {
-        JZ_STATIC_ASSERT(std::numeric_limits<T>::is_specialized);
-        JZ_STATIC_ASSERT(std::numeric_limits<T>::is_signed);
-
-        return (a < T(0)) ? -a : a;
+        return (Abs(a) < aEpsilon);
     }
 
     template <typename T>
@@ -139,7 +140,7 @@ namespace jz
     template <typename T>
     __inline T RSqrt(T v)
     {
-        return (T)std::rsqrt(v);
+        return (T)(T(1) / std::sqrt(v));
     }
 
     template <typename T>
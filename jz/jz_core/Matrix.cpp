@@ -145,7 +145,7 @@ namespace jz
     {
         if (mCols != m.mRows)
         {
-            throw std::exception(__FUNCTION__ ": incompatible matrix dimensions.");
+            throw JZ_EXCEPTION("incompatible matrix dimensions.");
         }
 
         Matrix ret(mRows, m.mCols);
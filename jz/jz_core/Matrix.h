@@ -74,7 +74,7 @@ namespace jz
             return *this;
         }
     
-        Matrix::~Matrix()
+        ~Matrix()
         {}
 
         const_iterator begin() const
@@ -356,6 +356,115 @@ namespace jz
     void FromMatrix(const Matrix3& m, Quaternion& q);
     void ToMatrix(const Quaternion& q, Matrix3& m);
 
+	template <typename ITR>
+	int CalculatePrincipalComponentAxes(ITR aBegin, ITR aEnd, Vector3& arR, Vector3& arS, Vector3& arT)
+	{
+		int count = 0;
+		Vector3 mean = Vector3::kZero;
+
+		for (ITR I = aBegin; I != aEnd; I++)
+		{
+			mean += (*I);
+			count++;
+		}
+
+		float invCount = (count > 0) ? ((float)(1.0 / ((double)count))) : 0.0f;
+		mean *= invCount;
+
+        float m11 = 0.0f;
+        float m22 = 0.0f;
+        float m33 = 0.0f;
+        float m12 = 0.0f;
+        float m13 = 0.0f;
+        float m23 = 0.0f;
+
+		for (ITR I = aBegin; I != aEnd; I++)
+		{
+			Vector3 v = ((*I) - mean);
+            m11 += v.X * v.X;
+            m22 += v.Y * v.Y;
+            m33 += v.Z * v.Z;
+            m12 += v.X * v.Y;
+            m13 += v.X * v.Z;
+            m23 += v.Y * v.Z;
+		}
+
+        m11 *= invCount;
+        m22 *= invCount;
+        m33 *= invCount;
+        m12 *= invCount;
+        m13 *= invCount;
+        m23 *= invCount;
+
+		Matrix3 m = Matrix3(m11, m12, m13, m12, m22, m23, m13, m23, m33);
+        Vector3 eigenValues;
+        Matrix3 eigenVectors;
+
+        Matrix3::FindEigenspace(m, eigenValues, eigenVectors);
+
+        m11 = jz::Abs(eigenValues.X);
+        m22 = jz::Abs(eigenValues.Y);
+        m33 = jz::Abs(eigenValues.Z);
+
+        if (jz::GreaterThan(m11, m22) && jz::GreaterThan(m11, m33))
+        {
+            arR = Vector3(eigenVectors.M11, eigenVectors.M21, eigenVectors.M31);
+
+            if (jz::GreaterThan(m22, m33))
+            {
+                arS = Vector3(eigenVectors.M12, eigenVectors.M22, eigenVectors.M32);
+                arT = Vector3(eigenVectors.M13, eigenVectors.M23, eigenVectors.M33);
+            }
+            else
+            {
+                arS = Vector3(eigenVectors.M13, eigenVectors.M23, eigenVectors.M33);
+                arT = Vector3(eigenVectors.M12, eigenVectors.M22, eigenVectors.M32);
+            }
+        }
+        else if (jz::GreaterThan(m22, m33))
+        {
+            arR = Vector3(eigenVectors.M12, eigenVectors.M22, eigenVectors.M32);
+
+            if (jz::GreaterThan(m11, m33))
+            {
+                arS = Vector3(eigenVectors.M11, eigenVectors.M21, eigenVectors.M31);
+                arT = Vector3(eigenVectors.M13, eigenVectors.M23, eigenVectors.M33);
+            }
+            else
+            {
+                arS = Vector3(eigenVectors.M13, eigenVectors.M23, eigenVectors.M33);
+                arT = Vector3(eigenVectors.M11, eigenVectors.M21, eigenVectors.M31);
+            }
+        }
+        else
+        {
+            arR = Vector3(eigenVectors.M13, eigenVectors.M23, eigenVectors.M33);
+
+            if (jz::GreaterThan(m11, m22))
+            {
+                arS = Vector3(eigenVectors.M11, eigenVectors.M21, eigenVectors.M31);
+                arT = Vector3(eigenVectors.M12, eigenVectors.M22, eigenVectors.M32);
+            }
+            else
+            {
+                arS = Vector3(eigenVectors.M12, eigenVectors.M22, eigenVectors.M32);
+                arT = Vector3(eigenVectors.M11, eigenVectors.M21, eigenVectors.M31);
+            }
+        }
+
+        arR = Vector3::Normalize(arR);
+        arS = Vector3::Normalize(arS);
+        arT = Vector3::Normalize(arT);
+
+	    Matrix3 refl = Matrix3(arR.X, arS.X, arT.X,
+						       arR.Y, arS.Y, arT.Y,
+						       arR.Z, arS.Z, arT.Z);
+
+		if (refl.IsReflection()) { (arT = -arT); }
+
+        return count;
+	}
+
 }
 
 #endif
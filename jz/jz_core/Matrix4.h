@@ -32,6 +32,8 @@
 
 #if (JZ_PLATFORM_SSE && JZ_PLATFORM_WINDOWS)
 #   include <emmintrin.h>
+#elif (JZ_PLATFORM_SSE)
+#   include <xmmintrin.h>
 #endif
 
 namespace jz
@@ -44,8 +46,10 @@ namespace jz
     void _SSE_MatrixMultiply(Matrix4 const* pA, Matrix4 const* pB, Matrix4* pOut);
 #endif
 
-#if (JZ_PLATFORM_SSE)
+#if (JZ_PLATFORM_SSE && JZ_PLATFORM_WINDOWS)
     __declspec(align(16)) struct Matrix4
+#elif (JZ_PLATFORM_SSE)
+    struct __attribute__((aligned(16))) Matrix4
 #else
     struct Matrix4
 #endif
@@ -200,6 +204,26 @@ namespace jz
 #       if (JZ_PLATFORM_SSE && JZ_PLATFORM_WINDOWS)
             Matrix4 r;
             _SSE_MatrixMultiply(this, &b, &r);
+            return r;
+#       elif (JZ_PLATFORM_SSE)
+            // The product of _SSE_MatrixMultiply, with intrinsics where MSVC inline assembly
+            // is not available. Each column of the result is the columns of this scaled by
+            // the elements of the same column of b, summed in the order of the scalar path.
+            const __m128 kC0 = _mm_loadu_ps(pData + 0);
+            const __m128 kC1 = _mm_loadu_ps(pData + 4);
+            const __m128 kC2 = _mm_loadu_ps(pData + 8);
+            const __m128 kC3 = _mm_loadu_ps(pData + 12);
+
+            Matrix4 r;
+            for (int i = 0; i < N; i += S)
+            {
+                __m128 c = _mm_mul_ps(kC0, _mm_set1_ps(b.pData[i + 0]));
+                c = _mm_add_ps(c, _mm_mul_ps(kC1, _mm_set1_ps(b.pData[i + 1])));
+                c = _mm_add_ps(c, _mm_mul_ps(kC2, _mm_set1_ps(b.pData[i + 2])));
+                c = _mm_add_ps(c, _mm_mul_ps(kC3, _mm_set1_ps(b.pData[i + 3])));
+                _mm_storeu_ps(r.pData + i, c);
+            }
+
             return r;
 #       else
             // column 1
@@ -22,11 +22,14 @@
 
 #include <jz_core/Memory.h>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <new>
 
 namespace jz
 {
 
+#if JZ_PLATFORM_WINDOWS
     void Free(void_p p)
     {
         _aligned_free(p);
@@ -49,5 +52,39 @@ namespace jz
 
         return pRet;
     }
+#else
+    void Free(void_p p)
+    {
+        free(p);
+    }
+
+    void_p Malloc(size_t aSize, size_t aAlignment)
+    {
+        void_p pRet = null;
+
+        if (posix_memalign(&pRet, Max(aAlignment, sizeof(void_p)), aSize) != 0) { throw std::bad_alloc(); }
+
+        return pRet;
+    }
+
+    // There is no aligned realloc. The block is reallocated and then moved if the
+    // new block is not aligned.
+    void_p Realloc(void_p p, size_t aSize, size_t aAlignment)
+    {
+        void_p pRet = realloc(p, aSize);
+
+        if (!pRet) { throw std::bad_alloc(); }
+
+        if ((((size_t)pRet) % aAlignment) != 0u)
+        {
+            void_p pAligned = Malloc(aSize, aAlignment);
+            memcpy(pAligned, pRet, aSize);
+            free(pRet);
+            pRet = pAligned;
+        }
+
+        return pRet;
+    }
+#endif
 
 }
@@ -25,6 +25,7 @@
 #define _JZ_MEMORY_H_
 
 #include <jz_core/Prereqs.h>
+#include <cstring>
 #include <type_traits>
 
 namespace jz
@@ -24,6 +24,10 @@
 #ifndef _JZ_PREREQS_H_
 #define _JZ_PREREQS_H_
 
+#include <cassert>
+#include <cfloat>
+#include <climits>
+#include <cstddef>
 #include <limits>
 #include <type_traits>
 
@@ -48,10 +52,14 @@ namespace jz
 #define JZ_CAT_IMPL(a) JZ_CAT_IMPLB##a
 #define JZ_CAT(a,b) JZ_CAT_IMPL((a,b))
 
-#define JZ_STATIC_ASSERT( a )                       \
+#if defined(__GNUC__)
+#   define JZ_STATIC_ASSERT( a ) static_assert(( a ), #a)
+#else
+#   define JZ_STATIC_ASSERT( a )                    \
     typedef ::jz::__StaticAssertHelper__<            \
     sizeof(::jz::__StaticAssert__<(bool)( a )>)> \
     __StaticAssertTypedef__
+#endif
 
 namespace jz
 {
@@ -66,6 +74,7 @@ namespace jz
     //  basic platform defines.
 #   if WIN32 || _WIN32
 #       define JZ_PLATFORM_MACOS   0
+#       define JZ_PLATFORM_POSIX   0
 #       define JZ_PLATFORM_WINDOWS 1
 #       define JZ_LITTLE_ENDIAN    1
 #       define JZ_BIG_ENDIAN       0
@@ -75,21 +84,74 @@ namespace jz
 
 #       define JZ_PLATFORM_SSE     1
 
-        // Multithreading is disabled because I think I have some bugs in the multithreaded IO.
-        // Disabling until I have time to implement that code carefully and correctly.
-#       define JZ_MULTITHREADED    0
+        // Jobs workers and the threading primitives are enabled. Background IO (the Loader
+        // and the AsyncIO worker threads) is not, because I think I have some bugs in the
+        // multithreaded IO. Disabled until I have time to implement that code carefully and
+        // correctly.
+#       define JZ_MULTITHREADED    1
+#       define JZ_MULTITHREADED_IO 0
 
 #       define JZ_ALIGN_OF __alignof
+#       define JZ_THREAD_LOCAL __declspec(thread)
+#   elif defined(__GNUC__) && (defined(__linux__) || defined(__APPLE__))
+#       if defined(__APPLE__)
+#           define JZ_PLATFORM_MACOS   1
+#       else
+#           define JZ_PLATFORM_MACOS   0
+#       endif
+#       define JZ_PLATFORM_POSIX   1
+#       define JZ_PLATFORM_WINDOWS 0
+
+#       if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#           define JZ_LITTLE_ENDIAN    0
+#           define JZ_BIG_ENDIAN       1
+#       else
+#           define JZ_LITTLE_ENDIAN    1
+#           define JZ_BIG_ENDIAN       0
+#       endif
+
+#       if defined(__LP64__)
+#           define JZ_PLATFORM_32      0
+#           define JZ_PLATFORM_64      1
+#       else
+#           define JZ_PLATFORM_32      1
+#           define JZ_PLATFORM_64      0
+#       endif
+
+#       if defined(__SSE__)
+#           define JZ_PLATFORM_SSE     1
+#       else
+#           define JZ_PLATFORM_SSE     0
+#       endif
+
+        // The pthread backend of jz_system threading primitives.
+#       define JZ_MULTITHREADED    1
+#       define JZ_MULTITHREADED_IO 1
+
+#       define JZ_ALIGN_OF __alignof__
+#       define JZ_THREAD_LOCAL __thread
+
+#       ifndef __forceinline
+#           define __forceinline inline __attribute__((always_inline))
+#       endif
+
+        // MSVC keywords.
+#       define sealed final
+#       define abstract
 #   else
 #       error "Platform not yet supported."
 #   endif
 
     // define JZ_STATICLIB if you want to link as a static library.
 #   ifndef JZ_STATICLIB
-#       ifdef JZ_BUILD
-#           define JZ_EXPORT __declspec(dllexport)
+#       if JZ_PLATFORM_WINDOWS
+#           ifdef JZ_BUILD
+#               define JZ_EXPORT __declspec(dllexport)
+#           else
+#               define JZ_EXPORT __declspec(dllimport)
+#           endif
 #       else
-#           define JZ_EXPORT __declspec(dllimport)
+#           define JZ_EXPORT __attribute__((visibility("default")))
 #       endif
 #   else
 #       define JZ_EXPORT
@@ -117,9 +179,14 @@ namespace jz
     typedef unsigned short ushort;
     typedef unsigned long  ulong;
 
+    // natural is 32-bit on every target. It is long on Win32, but long is 64-bit under
+    // LP64, so POSIX uses int.
 #   if JZ_PLATFORM_WINDOWS && JZ_PLATFORM_32
     typedef long  natural;
     typedef ulong unatural;
+#   elif JZ_PLATFORM_POSIX
+    typedef int   natural;
+    typedef uint  unatural;
 #   endif
 
     typedef void* void_p;
@@ -159,7 +226,19 @@ namespace jz
     JZ_STATIC_ASSERT(std::numeric_limits<s32>::is_signed);
     JZ_STATIC_ASSERT(std::numeric_limits<s32>::is_integer);
 
-#   if JZ_PLATFORM_32
+#   if JZ_PLATFORM_POSIX
+    typedef float f32;
+
+    typedef unsigned long long u64;
+    JZ_STATIC_ASSERT(std::numeric_limits<u64>::digits == 64);
+    JZ_STATIC_ASSERT(!std::numeric_limits<u64>::is_signed);
+    JZ_STATIC_ASSERT(std::numeric_limits<u64>::is_integer);
+
+    typedef long long s64;
+    JZ_STATIC_ASSERT(std::numeric_limits<s64>::digits == 63);
+    JZ_STATIC_ASSERT(std::numeric_limits<s64>::is_signed);
+    JZ_STATIC_ASSERT(std::numeric_limits<s64>::is_integer);
+#   elif JZ_PLATFORM_32
     typedef float f32;
 
     typedef unsigned __int64 u64;
@@ -173,7 +252,12 @@ namespace jz
     JZ_STATIC_ASSERT(std::numeric_limits<s64>::is_integer);
 #   endif
 
+#   if JZ_PLATFORM_POSIX
+    // A const int is not a null pointer constant in C++11.
+    static const std::nullptr_t null = nullptr;
+#   else
     static const int null = 0;
+#   endif
     static const char string_terminator = 0;
 
     struct Handle
@@ -186,6 +270,12 @@ namespace jz
             : V(i)
         {}
 
+#       if JZ_PLATFORM_POSIX
+        Handle(std::nullptr_t)
+            : P(null)
+        {}
+#       endif
+
         template <typename T>
         Handle(T* p)
             : P(p)
@@ -211,12 +301,13 @@ namespace jz
         operator void_p() const { return P; }
         operator voidc_p() const { return const_cast<voidc_p>(P); }
 
-        JZ_STATIC_ASSERT(sizeof(uint) == sizeof(void_p));
+        JZ_STATIC_ASSERT(sizeof(size_t) == sizeof(void_p));
 
+        // V is pointer sized so that Handle(uint) clears all of P.
         union
         {
             void_p P;
-            uint V;
+            size_t V;
         };
     };
 
@@ -229,7 +320,7 @@ namespace jz
     template <>
     __inline uint StaticCast<uint>(Handle v)
     {
-        return (v.V);
+        return (uint)(v.V);
     }
 
 #   define kUnreachableException "expected unreachable code reached."
@@ -266,55 +357,69 @@ namespace jz
         static const T kZeroTolerance;
     };
 
-    const float  Constants<float>::kE                = 2.71828182845904523536f;
-    const double Constants<double>::kE               = 2.71828182845904523536;
-    const float  Constants<float>::kInfinity         = std::numeric_limits<float>::infinity();
-    const double Constants<double>::kInfinity        = std::numeric_limits<double>::infinity();
-    const float  Constants<float>::kJacobiTolerance  = 1e-8f;
-    const double Constants<double>::kJacobiTolerance = 1e-10;
-    const float  Constants<float>::kLooseTolerance   = 1e-3f;
-    const double Constants<double>::kLooseTolerance  = 1e-5;
-    const float  Constants<float>::kNegativeLooseTolerance = -Constants<float>::kLooseTolerance; 
-    const double Constants<double>::kNegativeLooseTolerance = -Constants<double>::kLooseTolerance; 
-    const float  Constants<float>::kMax              = FLT_MAX;
-    const double Constants<double>::kMax             = DBL_MAX;
+    // Definitions of the explicit specializations. They are inline on POSIX, C++17 allows
+    // that and it avoids a definition per translation unit.
+#   if JZ_PLATFORM_POSIX
+#       define JZ_CONSTANT template <> inline
+#   else
+#       define JZ_CONSTANT
+#   endif
+
+    JZ_CONSTANT const float  Constants<float>::kE                = 2.71828182845904523536f;
+    JZ_CONSTANT const double Constants<double>::kE               = 2.71828182845904523536;
+    JZ_CONSTANT const float  Constants<float>::kInfinity         = std::numeric_limits<float>::infinity();
+    JZ_CONSTANT const double Constants<double>::kInfinity        = std::numeric_limits<double>::infinity();
+    JZ_CONSTANT const float  Constants<float>::kJacobiTolerance  = 1e-8f;
+    JZ_CONSTANT const double Constants<double>::kJacobiTolerance = 1e-10;
+    JZ_CONSTANT const float  Constants<float>::kLooseTolerance   = 1e-3f;
+    JZ_CONSTANT const double Constants<double>::kLooseTolerance  = 1e-5;
+    JZ_CONSTANT const float  Constants<float>::kNegativeLooseTolerance = -Constants<float>::kLooseTolerance; 
+    JZ_CONSTANT const double Constants<double>::kNegativeLooseTolerance = -Constants<double>::kLooseTolerance; 
+    JZ_CONSTANT const float  Constants<float>::kMax              = FLT_MAX;
+    JZ_CONSTANT const double Constants<double>::kMax             = DBL_MAX;
     // Note: numeric_limits<float>::min() actually returns the smallest positive number that can
     //       be represented, not the smallest signed number.
-    const float  Constants<float>::kMin              = -FLT_MAX; 
-    const double Constants<double>::kMin             = -DBL_MAX;
-    const float  Constants<float>::kMinLuminance     = 1e-6f;
-    const double Constants<double>::kMinLuminance    = 1e-6;
-    const float  Constants<float>::kNaN              = std::numeric_limits<float>::signaling_NaN();
-    const double Constants<double>::kNaN             = std::numeric_limits<double>::signaling_NaN();
-    const float  Constants<float>::kPi               = 3.14159265359f;
-    const double Constants<double>::kPi              = 3.14159265359;
-    const float  Constants<float>::kPiOver2          = 1.57079632679f;
-    const double Constants<double>::kPiOver2         = 1.57079632679;
-    const float  Constants<float>::kPiOver4          = 0.7853981634f;
-    const double Constants<double>::kPiOver4         = 0.7853981634;
-    const float  Constants<float>::kSlerpThreshold   = 5e-4f;
-    const double Constants<double>::kSlerpThreshold  = 5e-4;
-    const float  Constants<float>::k3PiOver2         = 4.71238898f;
-    const double Constants<double>::k3PiOver2        = 4.71238898;
-    const float  Constants<float>::kTwoPi            = 6.28318530718f;
-    const double Constants<double>::kTwoPi           = 6.28318530718;
-    const float  Constants<float>::kZeroTolerance    = 1e-06f;
-    const double Constants<double>::kZeroTolerance   = 1e-08;
-
-    const int Constants<int>::kMin = INT_MIN;
-    const int Constants<int>::kMax = INT_MAX;
-
-    const u8 Constants<u8>::kMin = 0u;
-    const u8 Constants<u8>::kMax = 0xFF;
-
-    const u16 Constants<u16>::kMin = 0u;
-    const u16 Constants<u16>::kMax = 0xFFFF;
-
-    const size_t Constants<size_t>::kMin = 0u;
-    const size_t Constants<size_t>::kMax = UINT_MAX;
-
-    const unatural Constants<unatural>::kMin = 0u;
-    const unatural Constants<unatural>::kMax = UINT_MAX;
+    JZ_CONSTANT const float  Constants<float>::kMin              = -FLT_MAX; 
+    JZ_CONSTANT const double Constants<double>::kMin             = -DBL_MAX;
+    JZ_CONSTANT const float  Constants<float>::kMinLuminance     = 1e-6f;
+    JZ_CONSTANT const double Constants<double>::kMinLuminance    = 1e-6;
+    JZ_CONSTANT const float  Constants<float>::kNaN              = std::numeric_limits<float>::signaling_NaN();
+    JZ_CONSTANT const double Constants<double>::kNaN             = std::numeric_limits<double>::signaling_NaN();
+    JZ_CONSTANT const float  Constants<float>::kPi               = 3.14159265359f;
+    JZ_CONSTANT const double Constants<double>::kPi              = 3.14159265359;
+    JZ_CONSTANT const float  Constants<float>::kPiOver2          = 1.57079632679f;
+    JZ_CONSTANT const double Constants<double>::kPiOver2         = 1.57079632679;
+    JZ_CONSTANT const float  Constants<float>::kPiOver4          = 0.7853981634f;
+    JZ_CONSTANT const double Constants<double>::kPiOver4         = 0.7853981634;
+    JZ_CONSTANT const float  Constants<float>::kSlerpThreshold   = 5e-4f;
+    JZ_CONSTANT const double Constants<double>::kSlerpThreshold  = 5e-4;
+    JZ_CONSTANT const float  Constants<float>::k3PiOver2         = 4.71238898f;
+    JZ_CONSTANT const double Constants<double>::k3PiOver2        = 4.71238898;
+    JZ_CONSTANT const float  Constants<float>::kTwoPi            = 6.28318530718f;
+    JZ_CONSTANT const double Constants<double>::kTwoPi           = 6.28318530718;
+    JZ_CONSTANT const float  Constants<float>::kZeroTolerance    = 1e-06f;
+    JZ_CONSTANT const double Constants<double>::kZeroTolerance   = 1e-08;
+
+    JZ_CONSTANT const int Constants<int>::kMin = INT_MIN;
+    JZ_CONSTANT const int Constants<int>::kMax = INT_MAX;
+
+    JZ_CONSTANT const u8 Constants<u8>::kMin = 0u;
+    JZ_CONSTANT const u8 Constants<u8>::kMax = 0xFF;
+
+    JZ_CONSTANT const u16 Constants<u16>::kMin = 0u;
+    JZ_CONSTANT const u16 Constants<u16>::kMax = 0xFFFF;
+
+    JZ_CONSTANT const size_t Constants<size_t>::kMin = 0u;
+    JZ_CONSTANT const size_t Constants<size_t>::kMax = ((size_t)-1);
+
+    JZ_CONSTANT const unatural Constants<unatural>::kMin = 0u;
+    JZ_CONSTANT const unatural Constants<unatural>::kMax = UINT_MAX;
+
+    template <typename T>
+    __inline bool IsNan(T a)
+    {
+        return (a != a);
+    }
 
     template <typename T>
     __inline T Clamp(T aValue, T aMin, T aMax)
@@ -326,12 +431,6 @@ namespace jz
         else { return aValue; }
     }
 
-    template <typename T>
-    __inline bool IsNan(T a)
-    {
-        return (a != a);
-    }
-
     template <typename T>
     __inline T Max(T a, T b)
     {
@@ -376,7 +475,13 @@ namespace jz
         b = tmp;
     }
 
-#   define JZ_E_ON_FAIL(a, msg) if (!(a)) { throw std::exception(__FUNCTION__ ": " msg); }
+    // __FUNCTION__ is a string literal in MSVC only.
+#   if JZ_PLATFORM_WINDOWS
+#       define JZ_EXCEPTION(msg) std::exception(__FUNCTION__ ": " msg)
+#   else
+#       define JZ_EXCEPTION(msg) std::runtime_error(std::string(__FUNCTION__) + ": " msg)
+#   endif
+#   define JZ_E_ON_FAIL(a, msg) if (!(a)) { throw JZ_EXCEPTION(msg); }
 
     template <typename T> struct _stride_helper { T a; char b; };
 
@@ -479,6 +584,26 @@ namespace jz
     void_p Realloc(void_p p, size_t aSize, size_t aAlignment);
 }
 
+#if JZ_PLATFORM_POSIX
+#   include <functional>
+#   include <stdexcept>
+#   include <string>
+
+    // VC9 has TR1 in std::tr1. The parts that are used here are in std since C++11.
+    namespace std
+    {
+        namespace tr1
+        {
+            using std::bind;
+            using std::function;
+            using std::is_arithmetic;
+            using std::is_base_of;
+            using std::ref;
+            namespace placeholders = std::placeholders;
+        }
+    }
+#endif
+
 #if JZ_PLATFORM_SSE
 #   include <new>
 #   define JZ_ALIGNED_NEW \
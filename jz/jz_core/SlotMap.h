@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SLOT_MAP_H_
+#define _JZ_SLOT_MAP_H_
+
+#include <jz_core/Prereqs.h>
+#include <stdexcept>
+#include <vector>
+
+namespace jz
+{
+
+    // Handle based container with O(1) add and remove. Handles are 32-bits, the low
+    // kIndexBits select a slot and the remaining bits are a generation counter that
+    // is incremented each time the slot is released, so a stale handle never aliases
+    // a reused slot. Values are kept packed in a dense array (remove swaps the last
+    // element into the hole) so iteration only touches live elements.
+    template <typename T>
+    class SlotMap
+    {
+    public:
+        typedef typename vector<T>::const_iterator const_iterator;
+        typedef typename vector<T>::iterator iterator;
+        typedef typename vector<T>::size_type size_type;
+        typedef T value_type;
+        typedef u32 handle_type;
+
+        static const u32 kIndexBits = 20u;
+        static const u32 kGenerationBits = (32u - kIndexBits);
+        static const u32 kIndexMask = ((1u << kIndexBits) - 1u);
+        static const u32 kGenerationMask = ((1u << kGenerationBits) - 1u);
+        static const u32 kMaxSize = kIndexMask;
+        static const handle_type kInvalidHandle = 0u;
+
+        static u32 GetIndex(handle_type aHandle) { return (aHandle & kIndexMask); }
+        static u32 GetGeneration(handle_type aHandle) { return ((aHandle >> kIndexBits) & kGenerationMask); }
+
+        SlotMap()
+            : mFreeHead(kIndexMask), mFreeTail(kIndexMask)
+        {}
+
+        handle_type Add(const T& a)
+        {
+            u32 index;
+
+            if (mFreeHead != kIndexMask)
+            {
+                index = mFreeHead;
+                mFreeHead = mSlots[index].Next;
+                if (mFreeHead == kIndexMask) { mFreeTail = kIndexMask; }
+            }
+            else
+            {
+                if (mSlots.size() >= kMaxSize) { throw std::length_error("SlotMap exceeded maximum size."); }
+
+                index = (u32)mSlots.size();
+                mSlots.push_back(Slot());
+            }
+
+            Slot& slot = mSlots[index];
+            slot.Next = (u32)mData.size();
+            mData.push_back(a);
+            mDenseToSlot.push_back(index);
+
+            return _MakeHandle(index, slot.Generation);
+        }
+
+        bool IsValid(handle_type aHandle) const
+        {
+            u32 index = GetIndex(aHandle);
+
+            return (index < mSlots.size() &&
+                mSlots[index].Generation == GetGeneration(aHandle) &&
+                mSlots[index].Next < mData.size() &&
+                mDenseToSlot[mSlots[index].Next] == index);
+        }
+
+        // Returns null if aHandle is stale or invalid.
+        const T* Find(handle_type aHandle) const { return (IsValid(aHandle)) ? &(mData[mSlots[GetIndex(aHandle)].Next]) : null; }
+        T* Find(handle_type aHandle) { return (IsValid(aHandle)) ? &(mData[mSlots[GetIndex(aHandle)].Next]) : null; }
+
+        const T& operator[](handle_type aHandle) const
+        {
+            JZ_ASSERT(IsValid(aHandle));
+            return mData[mSlots[GetIndex(aHandle)].Next];
+        }
+
+        T& operator[](handle_type aHandle)
+        {
+            JZ_ASSERT(IsValid(aHandle));
+            return mData[mSlots[GetIndex(aHandle)].Next];
+        }
+
+        // Access by slot index only, without the generation check. The slot index of a
+        // live handle is stable for its lifetime, so this is useful when a client can only
+        // store a narrow id.
+        const T& GetByIndex(u32 aIndex) const { return mData[mSlots[aIndex].Next]; }
+        T& GetByIndex(u32 aIndex) { return mData[mSlots[aIndex].Next]; }
+
+        handle_type GetHandleFromIndex(u32 aIndex) const
+        {
+            JZ_ASSERT(aIndex < mSlots.size());
+            return _MakeHandle(aIndex, mSlots[aIndex].Generation);
+        }
+
+        // Handle of the element at position aDenseIndex in [begin(), end()).
+        handle_type GetHandleFromDense(size_type aDenseIndex) const
+        {
+            u32 index = mDenseToSlot[aDenseIndex];
+            return _MakeHandle(index, mSlots[index].Generation);
+        }
+
+        bool Remove(handle_type aHandle)
+        {
+            if (!IsValid(aHandle)) { return false; }
+
+            u32 index = GetIndex(aHandle);
+            u32 dense = mSlots[index].Next;
+            u32 last = (u32)(mData.size() - 1u);
+
+            if (dense != last)
+            {
+                mData[dense] = mData[last];
+                mDenseToSlot[dense] = mDenseToSlot[last];
+                mSlots[mDenseToSlot[dense]].Next = dense;
+            }
+
+            mData.pop_back();
+            mDenseToSlot.pop_back();
+
+            // Generation 0 is skipped so that kInvalidHandle is never a live handle.
+            Slot& slot = mSlots[index];
+            slot.Generation = (slot.Generation + 1u) & kGenerationMask;
+            if (slot.Generation == 0u) { slot.Generation = 1u; }
+
+            // FIFO free list, delays reuse of a slot as long as possible to make
+            // generation wrap around less likely.
+            slot.Next = kIndexMask;
+            if (mFreeTail != kIndexMask) { mSlots[mFreeTail].Next = index; }
+            else { mFreeHead = index; }
+            mFreeTail = index;
+
+            return true;
+        }
+
+        void clear()
+        {
+            for (size_type i = 0u; i < mDenseToSlot.size(); i++)
+            {
+                Slot& slot = mSlots[mDenseToSlot[i]];
+                slot.Generation = (slot.Generation + 1u) & kGenerationMask;
+                if (slot.Generation == 0u) { slot.Generation = 1u; }
+            }
+
+            mData.clear();
+            mDenseToSlot.clear();
+
+            mFreeHead = kIndexMask;
+            mFreeTail = kIndexMask;
+            for (u32 i = 0u; i < (u32)mSlots.size(); i++)
+            {
+                mSlots[i].Next = kIndexMask;
+                if (mFreeTail != kIndexMask) { mSlots[mFreeTail].Next = i; }
+                else { mFreeHead = i; }
+                mFreeTail = i;
+            }
+        }
+
+        void reserve(size_type aSize)
+        {
+            mData.reserve(aSize);
+            mDenseToSlot.reserve(aSize);
+            mSlots.reserve(aSize);
+        }
+
+        const_iterator begin() const { return mData.begin(); }
+        iterator begin() { return mData.begin(); }
+        const_iterator end() const { return mData.end(); }
+        iterator end() { return mData.end(); }
+
+        bool empty() const { return mData.empty(); }
+        size_type size() const { return mData.size(); }
+
+    private:
+        // For a live slot, Next is the index into mData. For a free slot, Next is the
+        // next free slot or kIndexMask at the end of the free list.
+        struct Slot
+        {
+            Slot()
+                : Generation(1u), Next(0u)
+            {}
+
+            u32 Generation;
+            u32 Next;
+        };
+
+        static handle_type _MakeHandle(u32 aIndex, u32 aGeneration)
+        {
+            return ((aGeneration & kGenerationMask) << kIndexBits) | (aIndex & kIndexMask);
+        }
+
+        vector<T> mData;
+        vector<u32> mDenseToSlot;
+        vector<Slot> mSlots;
+        u32 mFreeHead;
+        u32 mFreeTail;
+    };
+
+}
+
+#endif
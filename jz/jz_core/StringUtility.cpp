@@ -27,6 +27,7 @@
 #include <jz_core/StringUtility.h>
 
 #include <cstdio>
+#include <cwctype>
 
 namespace jz
 {
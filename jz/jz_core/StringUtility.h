@@ -43,7 +43,12 @@ namespace jz
         static void TrimWhitespace(string& ar);
 
         static string ToString(int n, bool bHex = false);
+#       if (JZ_PLATFORM_POSIX && JZ_PLATFORM_64)
+        // size_t is ulong under LP64, so it is uint that needs forwarding.
+        static string ToString(uint n, bool bHex = false) { return ToString((size_t)n, bHex); }
+#       else
         static string ToString(ulong n, bool bHex = false) { return ToString((size_t)n, bHex); }
+#       endif
         static string ToString(voidc_p p) { return ToString((size_t)p, true); }
         static string ToString(size_t n, bool bHex = false);
         static string ToString(u64 n, bool bHex = false);
@@ -98,7 +98,9 @@ namespace jz
                     I->mpNextSibling.Reset();
                 }
 
-                mpFirstChild.Reset();            
+                if (mpFirstChild.IsValid()) { mpFirstChild->mpParent = null; }
+                mpFirstChild.Reset();
+                mpLastChild = null;
             }
 
             virtual ~TreeNode()
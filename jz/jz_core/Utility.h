@@ -104,6 +104,7 @@ namespace jz
             InternalListIterator& operator=(const InternalListIterator& i)
             {
                 mpPtr = i.mpPtr;
+                return *this;
             }
             
             bool operator==(const InternalListIterator& i) const
@@ -189,6 +190,7 @@ namespace jz
             ConstInternalListIterator& operator=(const ConstInternalListIterator& i)
             {
                 mpPtr = i.mpPtr;
+                return *this;
             }
             
             bool operator==(const ConstInternalListIterator& i) const
@@ -271,6 +273,7 @@ namespace jz
             ReverseInternalListIterator& operator=(const ReverseInternalListIterator& i)
             {
                 mpPtr = i.mpPtr;
+                return *this;
             }
             
             bool operator==(const ReverseInternalListIterator& i) const
@@ -357,6 +360,7 @@ namespace jz
             ConstReverseInternalListIterator& operator=(const ConstReverseInternalListIterator& i)
             {
                 mpPtr = i.mpPtr;
+                return *this;
             }
             
             bool operator==(const ConstReverseInternalListIterator& i) const
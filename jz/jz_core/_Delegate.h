@@ -75,48 +75,50 @@ class DelegateImpl<R JZ_DELEGATE_COMMA JZ_DELEGATE_T_ARGS>
 template <typename R JZ_DELEGATE_COMMA JZ_DELEGATE_T>
 class Delegate<R (JZ_DELEGATE_T_ARGS)> : public DelegateImpl<R JZ_DELEGATE_COMMA JZ_DELEGATE_T_ARGS>
 {
+    typedef DelegateImpl<R JZ_DELEGATE_COMMA JZ_DELEGATE_T_ARGS> Impl;
+
     public:
         Delegate()
         {}
         
         Delegate(const Delegate& d)
-            : DelegateImpl(d.mpCaller, d.mpObject)
+            : Impl(d.mpCaller, d.mpObject)
         {}
         
-        Delegate(const DelegateImpl& d)
-            : DelegateImpl(d.mpCaller, d.mpObject)
+        Delegate(const Impl& d)
+            : Impl(d.mpCaller, d.mpObject)
         {}
 
         Delegate& operator=(const Delegate& d)
         {
-            mpCaller = d.mpCaller;
-            mpObject = d.mpObject;
+            this->mpCaller = d.mpCaller;
+            this->mpObject = d.mpObject;
             
             return *this;
         }
         
-        Delegate& operator=(const DelegateImpl& d)
+        Delegate& operator=(const Impl& d)
         {
-            mpCaller = d.mpCaller;
-            mpObject = d.mpObject;
+            this->mpCaller = d.mpCaller;
+            this->mpObject = d.mpObject;
             
             return *this;
         }
         
         operator bool() const
         {
-            return mpCaller != 0;
+            return this->mpCaller != 0;
         }
 
         R operator()(JZ_DELEGATE_ARGS) const
         {
-            return (*mpCaller)(mpObject JZ_DELEGATE_COMMA JZ_DELEGATE_PARAMS);
+            return (*this->mpCaller)(this->mpObject JZ_DELEGATE_COMMA JZ_DELEGATE_PARAMS);
         }
 
         void Reset()
         {
-            mpCaller = 0;
-            mpObject = 0;
+            this->mpCaller = 0;
+            this->mpObject = 0;
         }        
 };
 
@@ -151,7 +151,7 @@ public:
         template <R (*F)(JZ_EVENT_T_ARGS)>
         void Add(Entry& e)
         {
-            EntryDelegate d(EntryDelegate::Bind<F>());
+            EntryDelegate d(EntryDelegate::template Bind<F>());
             
             Add(d, e);
         }
@@ -159,7 +159,7 @@ public:
         template <typename T, R (T::*M)(JZ_EVENT_T_ARGS)>
         void Add(T* apObject, Entry& e)
         {
-            EntryDelegate d(EntryDelegate::Bind<T, M>(apObject));
+            EntryDelegate d(EntryDelegate::template Bind<T, M>(apObject));
             
             Add(d, e);
         }
@@ -175,10 +175,12 @@ public:
 template <typename R JZ_EVENT_COMMA JZ_EVENT_T>
 class Event<R (JZ_EVENT_T_ARGS)> : public EventImpl<R JZ_EVENT_COMMA JZ_EVENT_T_ARGS>
 {
+    typedef typename EventImpl<R JZ_EVENT_COMMA JZ_EVENT_T_ARGS>::const_iterator const_iterator;
+
 public:
     void operator()(JZ_EVENT_ARGS) const
     {
-        for (const_iterator I = begin(); I != end(); I++)
+        for (const_iterator I = this->begin(); I != this->end(); I++)
         {
 #           ifndef NDEBUG
             const_cast<bool&>(I->mbInDelegate) = true;
@@ -196,10 +198,12 @@ public:
 template <JZ_EVENT_T>
 class Event<bool (JZ_EVENT_T_ARGS)> : public EventImpl<bool JZ_EVENT_COMMA JZ_EVENT_T_ARGS>
 {
+    typedef typename EventImpl<bool JZ_EVENT_COMMA JZ_EVENT_T_ARGS>::const_iterator const_iterator;
+
 public:
     void operator()(JZ_EVENT_ARGS) const
     {
-        for (const_iterator I = begin(); I != end(); I++)
+        for (const_iterator I = this->begin(); I != this->end(); I++)
         {
 #           ifndef NDEBUG
             const_cast<bool&>(I->mbInDelegate) = true;
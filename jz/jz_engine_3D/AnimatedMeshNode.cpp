@@ -76,24 +76,41 @@ namespace jz
             apNode->RenderChildren();
         }
 
+        JZ_SCENE_NODE_CLASS_IMPL(AnimatedMeshNode, MeshNode);
+
+        const float AnimatedMeshNode::kClipPadding = 0.1f;
+
         AnimatedMeshNode::AnimatedMeshNode()
             : MeshNode(),
             mpAnimationControl(new AnimationControl()),
-            mBind(Matrix4::kIdentity),
+            mpSkin(new SkinData()),
             mbJointsDirty(false),
-            mRootIndex(-1)
+            mRootIndex(-1),
+            mbSkinningChanged(false),
+            mSkinnedAABB(BoundingBox::kInvertedMax),
+            mbSkinnedAABBChanged(false),
+            mbConservativeBounds(false),
+            mClip(0u),
+            mClipIndex(-1)
         {}
 
-        AnimatedMeshNode::AnimatedMeshNode(const string& aBaseId, const string& aId)
+        AnimatedMeshNode::AnimatedMeshNode(const system::StringId& aBaseId, const system::StringId& aId)
             : MeshNode(aBaseId, aId),
             mpAnimationControl(new AnimationControl()),
-            mBind(Matrix4::kIdentity),
+            mpSkin(new SkinData()),
             mbJointsDirty(false),
-            mRootIndex(-1)
+            mRootIndex(-1),
+            mbSkinningChanged(false),
+            mSkinnedAABB(BoundingBox::kInvertedMax),
+            mbSkinnedAABBChanged(false),
+            mbConservativeBounds(false),
+            mClip(0u),
+            mClipIndex(-1)
         { }
 
         AnimatedMeshNode::~AnimatedMeshNode()
         {
+            msAnimation.Remove(this);
         }
 
         void AnimatedMeshNode::PoseForRender()
@@ -102,13 +119,12 @@ namespace jz
             {
                 RenderMan& rm = RenderMan::GetSingleton();
                 
-                graphics::RenderPack pack = mPack;
-                pack.DrawFunc = DrawAnimatedMesh;
-                pack.DrawFuncParam = this;
-                pack.EffectTechnique = (mbNonDeferred) ? static_cast<StandardEffect*>(pack.pEffect.Get())->GetNonDeferredTechnique() : static_cast<StandardEffect*>(pack.pEffect.Get())->GetRenderTechnique();
-                pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition((mWorld * rm.GetView()), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                StandardEffect* pEffect = static_cast<StandardEffect*>(mPack.pEffect.Get());
+                graphics::Technique technique = (mbNonDeferred) ? pEffect->GetNonDeferredTechnique() : pEffect->GetRenderTechnique();
+                float sort = (mPack.pMesh.IsValid()) ? Vector3::TransformPosition((_World() * rm.GetView()), mPack.pMesh->GetAABB().Center()).Z : 0.0f;
 
-                rm.Pose(pack);
+                // mPack is not copied, posing can run on job workers.
+                rm.Pose(mPack, DrawAnimatedMesh, this, technique, sort);
             }
         }
 
@@ -127,7 +143,7 @@ namespace jz
                     pack.DrawFuncParam = this;
                     pack.Flags = (graphics::RenderPack::kShadow);
                     pack.EffectTechnique = se->GetShadowTechnique();
-                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(mWorld * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(_World() * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
                     pack.PreEffectFunc = SetActiveShadowHandle;
                     pack.PreEffectFuncParam = apLight;
 
@@ -151,7 +167,7 @@ namespace jz
                     pack.DrawFunc = DrawAnimatedMesh;
                     pack.DrawFuncParam = this;
                     pack.EffectTechnique = pEffect->GetPickingTechnique();
-                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(mWorld * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(_World() * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
 
                     pm.Pose(pack, this);
                 }
@@ -162,23 +178,57 @@ namespace jz
         {
             AnimatedMeshNode* p = static_cast<AnimatedMeshNode*>(apNode);
 
-            p->mpAnimationControl = mpAnimationControl;
-            p->mBind = mBind;
-            p->mInvBinds = mInvBinds;
-            p->mJoints = mJoints;
-            p->mJointIds = mJointIds;
-            p->mbJointsDirty = mbJointsDirty;
-            p->mRootIndex = mRootIndex;
-            p->mpRootJoint = mpRootJoint;
-            p->mRootJointId = mRootJointId;
+            MeshNode::_PopulateClone(apNode);
+
+            p->mpSkin = mpSkin;
             p->mSkinning = mSkinning;
+            p->mSkinnedAABB = mSkinnedAABB;
+            p->mbConservativeBounds = mbConservativeBounds;
+
+            // A clone under another base id is an instance with its own skeleton; it
+            // keeps its own AnimationControl and resolves its joints by id on update.
+            if (p->GetBaseId() == GetBaseId())
+            {
+                p->mpAnimationControl = mpAnimationControl;
+                p->mJoints = mJoints;
+                p->mbJointsDirty = mbJointsDirty;
+                p->mRootIndex = mRootIndex;
+                p->mpRootJoint = mpRootJoint;
+            }
+            else
+            {
+                p->mbJointsDirty = true;
+            }
         }
 
-        SceneNode* AnimatedMeshNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        SceneNode* AnimatedMeshNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
             return new AnimatedMeshNode(aBaseId, aCloneId);
         }
 
+        // A fade or a layer reaches poses outside the range, which would widen the bounds
+        // of every instance playing it.
+        size_t AnimatedMeshNode::_FindClip() const
+        {
+            const SkinData& skin = *mpSkin;
+            const AnimationControl* p = mpAnimationControl.Get();
+
+            if (!p || p->bFading() || p->GetLayerCount() > 0u) { return skin.Clips.size(); }
+
+            return skin.FindClip(p->GetStartIndex(), p->GetEndIndex(), p->GetMaxJointDepth());
+        }
+
+        SkinData& AnimatedMeshNode::_Skin()
+        {
+            if (!mpSkin.IsUnique()) { mpSkin.Reset(new SkinData(*mpSkin)); }
+
+            // Anything that changes the skin changes the skinned bounds.
+            mpSkin->Clips.clear();
+            mpSkin->bSkinTransformsValid = false;
+
+            return *mpSkin;
+        }
+
         void AnimatedMeshNode::_SetJoint(size_t i, SceneNode* p)
         {
             if (i < mJoints.size())
@@ -187,7 +237,7 @@ namespace jz
                 {
                     mJoints[i]->SetAnimationControl(null);
                 }
-                mJoints[i].Reset(dynamic_cast<JointNode*>(p));
+                mJoints[i].Reset(SceneNodeCast<JointNode>(p));
                 if (mJoints[i].IsValid())
                 {
                     mJoints[i]->SetAnimationControl(mpAnimationControl.Get());
@@ -204,13 +254,13 @@ namespace jz
                 mRootIndex = -1;
             }
 
-            mpRootJoint.Reset(dynamic_cast<JointNode*>(p));
+            mpRootJoint.Reset(SceneNodeCast<JointNode>(p));
             
             if (mpRootJoint.IsValid())
             {
                 mpRootJoint->SetAnimationControl(mpAnimationControl.Get());
 
-                for (size_t i = 0; i < mJointIds.size(); i++)
+                for (size_t i = 0; i < mJoints.size(); i++)
                 {
                     if (mJoints[i] == mpRootJoint)
                     {
@@ -221,80 +271,210 @@ namespace jz
             }
         }
 
+        const Animation* AnimatedMeshNode::_GetTimeline() const
+        {
+            if (mpRootJoint.IsValid()) { return &(mpRootJoint->GetAnimation()); }
+
+            for (size_t i = 0u; i < mJoints.size(); i++)
+            {
+                if (mJoints[i].IsValid()) { return &(mJoints[i]->GetAnimation()); }
+            }
+
+            return null;
+        }
+
+        void AnimatedMeshNode::_PreUpdateA(const Matrix4& aParentWorld, bool abParentChanged)
+        {
+            MeshNode::_PreUpdateA(aParentWorld, abParentChanged);
+
+            // Built here, on the updating thread, since the skin may be shared.
+            SkinData& skin = *mpSkin;
+            if (!skin.bSkinTransformsValid)
+            {
+                const size_t kCount = skin.InvBinds.size();
+
+                skin.SkinTransforms.resize(kCount);
+                for (size_t i = 0u; i < kCount; i++)
+                {
+                    skin.SkinTransforms[i] = (skin.Bind * skin.InvBinds[i]);
+                }
+                skin.bSkinTransformsValid = true;
+            }
+
+            msAnimation.Add(this);
+        }
+
+        // Called from AnimationBatch::Skin(), possibly on a worker thread. Only reads
+        // state other than this node's own palette.
+        void AnimatedMeshNode::_UpdateSkinning()
+        {
+            if (mpRootJoint.IsValid() && mpRootJoint->bDirty())
+            {
+                const SkinData& skin = *mpSkin;
+                const size_t kCount = mJoints.size();
+
+                for (size_t i = 0u; i < kCount; i++)
+                {
+                    const size_t kEntry = (i * 3u);
+
+                    if (mJoints[i].IsValid())
+                    {
+                        const Matrix4 kTransform = (skin.SkinTransforms[i] * mJoints[i]->GetWorldTransform());
+
+                        mSkinning[kEntry + 0u] = kTransform.GetCol(0);
+                        mSkinning[kEntry + 1u] = kTransform.GetCol(1);
+                        mSkinning[kEntry + 2u] = kTransform.GetCol(2);
+                    }
+                    else
+                    {
+                        mSkinning[kEntry + 0u] = Vector4::kUnitX;
+                        mSkinning[kEntry + 1u] = Vector4::kUnitY;
+                        mSkinning[kEntry + 2u] = Vector4::kUnitZ;
+                    }
+                }
+
+                mbSkinningChanged = true;
+
+                // Skip the pose's own bounds once the conservative ones are known.
+                const size_t kClip = _FindClip();
+                if (!mbConservativeBounds || kClip >= skin.Clips.size() || skin.Clips[kClip].Remaining > 0u)
+                {
+                    _UpdateBounds();
+                }
+            }
+        }
+
+        void AnimatedMeshNode::_UpdateBounds()
+        {
+            const SkinData& skin = *mpSkin;
+
+            if (skin.JointAABBs.size() == mJoints.size() && mJoints.size() > 0u)
+            {
+                mSkinnedAABB = BoundingBox::MergeTransformed(mSkinning.Get(), skin.JointAABBs.Get(), mJoints.size());
+                mbSkinnedAABBChanged = true;
+            }
+        }
+
         void AnimatedMeshNode::_PostUpdate(bool abChanged)
         {
             if (mbJointsDirty)
             {
-                size_t count = mJointIds.size();
+                const SkinData& skin = *mpSkin;
+                size_t count = skin.JointIds.size();
                 mJoints.resize(count);
                 mSkinning.resize(count * 3u);
-                mBoundingCached.assign(mBoundingCached.size(), false);
 
-                for (size_t i = 0; i < count; i += 3)
+                for (size_t i = 0; i < count; i++)
                 {
-                    mSkinning[i+0] = Vector4::kUnitX;
-                    mSkinning[i+1] = Vector4::kUnitY;
-                    mSkinning[i+2] = Vector4::kUnitZ;
+                    mSkinning[(i * 3u) + 0u] = Vector4::kUnitX;
+                    mSkinning[(i * 3u) + 1u] = Vector4::kUnitY;
+                    mSkinning[(i * 3u) + 2u] = Vector4::kUnitZ;
                 }
 
                 for (size_t i = 0; i < count; i++)
                 {
-                    Get(GetBaseId(), mJointIds[i], bind(&AnimatedMeshNode::_SetJoint, this, i, tr1::placeholders::_1));
+                    Get(GetBaseId(), skin.JointIds[i], bind(&AnimatedMeshNode::_SetJoint, this, i, tr1::placeholders::_1));
                 }
 
-                Get(GetBaseId(), mRootJointId, bind(&AnimatedMeshNode::_SetRootJoint, this, tr1::placeholders::_1));
+                Get(GetBaseId(), skin.RootJointId, bind(&AnimatedMeshNode::_SetRootJoint, this, tr1::placeholders::_1));
 
                 mbJointsDirty = false;
                 abChanged = true;
             }
 
-            if (mpRootJoint.IsValid() && mpRootJoint->bDirty())
+            // Built for every mesh at once by AnimationBatch::Skin().
+            if (mbSkinningChanged)
             {
-                size_t size = mJoints.size();
-                for (size_t i = 0u; i < size; i++)
-                {
-                    size_t entryIndex = (i * 3u);
+                mbSkinningChanged = false;
+                abChanged = true;
+            }
 
-                    if (mJoints[i].IsValid())
-                    {
-                        Matrix4 transform = (mBind * mInvBinds[i] * mJoints[i]->GetWorldTransform());
+            if (abChanged && mpAnimationControl.IsValid() && mPack.pMesh.IsValid())
+            {
+                SkinData& skin = *mpSkin;
 
-                        mSkinning[entryIndex + 0u] = transform.GetCol(0);
-                        mSkinning[entryIndex + 1u] = transform.GetCol(1);
-                        mSkinning[entryIndex + 2u] = transform.GetCol(2);
-                    }
-                    else
+                // Scenes without joint bounds bound every joint by the whole mesh. Derived
+                // data, so filled in place even if the skin is shared.
+                if (skin.JointAABBs.size() != mJoints.size() && mPack.pMesh->IsLoaded())
+                {
+                    skin.JointAABBs.resize(mJoints.size());
+                    for (size_t i = 0u; i < mJoints.size(); i++)
                     {
-                        mSkinning[entryIndex + 0u] = Vector4::kUnitX;
-                        mSkinning[entryIndex + 1u] = Vector4::kUnitY;
-                        mSkinning[entryIndex + 2u] = Vector4::kUnitZ;
+                        skin.JointAABBs[i] = mPack.pMesh->GetAABB();
                     }
+                    skin.Clips.clear();
+
+                    _UpdateBounds();
                 }
-                abChanged = true;
-            }
 
-            if (abChanged && mpAnimationControl.IsValid() && mPack.pMesh.IsValid())
-            {
-                size_t curIndex = (size_t)mpAnimationControl->GetCurrentIndex();
-                if (mBoundingCache.size() <= curIndex)
+                const int kStart = mpAnimationControl->GetStartIndex();
+                const int kEnd = mpAnimationControl->GetEndIndex();
+                const int kCurrent = mpAnimationControl->GetCurrentIndex();
+                const u32 kDepth = mpAnimationControl->GetMaxJointDepth();
+                const bool kbBareRange = (!mpAnimationControl->bFading() && mpAnimationControl->GetLayerCount() == 0u);
+
+                const size_t kClip = _FindClip();
+                SkinData::ClipBounds* pClip = (kClip < skin.Clips.size()) ? &(skin.Clips[kClip]) : null;
+                if (!pClip && kbBareRange && kStart >= 0 && kStart <= kEnd)
                 {
-                    mAABBCache.resize(curIndex + 1u);
-                    mBoundingCache.resize(curIndex + 1u);
-                    mBoundingCached.resize(curIndex + 1u);
+                    SkinData::ClipBounds clip;
+                    clip.StartIndex = kStart;
+                    clip.EndIndex = kEnd;
+                    clip.MaxJointDepth = kDepth;
+                    clip.AABB = BoundingBox::kInvertedMax;
+                    clip.Posed.assign((size_t)(kEnd - kStart + 1), false);
+                    clip.Remaining = clip.Posed.size();
+
+                    skin.Clips.push_back(clip);
+                    pClip = &(skin.Clips.back());
                 }
 
-                if (!mBoundingCached[curIndex])
+                if (mbSkinnedAABBChanged && pClip)
                 {
-                    mPack.pMesh->CalculateBoundings(mSkinning, mAABBCache[curIndex], mBoundingCache[curIndex]);
-                    mBoundingCached[curIndex] = true;
+                    pClip->AABB = BoundingBox::Merge(pClip->AABB, mSkinnedAABB);
+
+                    if (kCurrent >= kStart && kCurrent <= kEnd)
+                    {
+                        // Updates skipped for LOD can step over keys; the keys played past
+                        // since the last pose count as posed, or Remaining might never reach
+                        // zero.
+                        int i = (mClip == kClip && mClipIndex >= kStart && mClipIndex <= kEnd) ? mClipIndex : kCurrent;
+                        while (true)
+                        {
+                            if (!pClip->Posed[i - kStart])
+                            {
+                                pClip->Posed[i - kStart] = true;
+                                pClip->Remaining--;
+
+                                if (pClip->Remaining == 0u)
+                                {
+                                    const Vector3 kPadding = (kClipPadding * pClip->AABB.Extents());
+                                    pClip->AABB = BoundingBox(pClip->AABB.Min - kPadding, pClip->AABB.Max + kPadding);
+                                }
+                            }
+
+                            if (i == kCurrent) { break; }
+                            i = (i == kEnd) ? kStart : (i + 1);
+                        }
+
+                        mClip = kClip;
+                        mClipIndex = kCurrent;
+                    }
                 }
-            
-                mWorldAABB = BoundingBox::Transform(mWorld, mAABBCache[curIndex]);
-                mWorldBounding = BoundingSphere::Transform(mWorld, mBoundingCache[curIndex]);
-                mbValidBounding = true;
+                else if (!pClip)
+                {
+                    mClipIndex = -1;
+                }
+                mbSkinnedAABBChanged = false;
+
+                const BoundingBox& aabb = (mbConservativeBounds && pClip && pClip->Remaining == 0u) ? pClip->AABB : mSkinnedAABB;
 
-                // Need to calculate tighter AABB
-                // Need to reset bounding cache if mesh, animationcontrol, or joints change.
+                if (aabb.Min.X <= aabb.Max.X)
+                {
+                    mWorldAABB = BoundingBox::Transform(_World(), aabb);
+                    mWorldBounding = BoundingSphere::Transform(_World(), BoundingSphere::CreateFrom(aabb));
+                    mbValidBounding = true;
+                }
             }
         }
 
@@ -36,11 +36,88 @@ namespace jz
     namespace engine_3D
     {
 
+        // Skinning data read from the scene file. Clones of an AnimatedMeshNode share one
+        // SkinData; the mutable accessors of AnimatedMeshNode copy it first if it is shared.
+        class SkinData sealed
+        {
+        public:
+            JZ_ALIGNED_NEW
+
+            SkinData()
+                : Bind(Matrix4::kIdentity), bSkinTransformsValid(false), mReferenceCount(0u)
+            {}
+
+            SkinData(const SkinData& b)
+                : Bind(b.Bind),
+                InvBinds(b.InvBinds),
+                JointIds(b.JointIds),
+                RootJointId(b.RootJointId),
+                JointAABBs(b.JointAABBs),
+                Clips(b.Clips),
+                SkinTransforms(b.SkinTransforms),
+                bSkinTransformsValid(b.bSkinTransformsValid),
+                mReferenceCount(0u)
+            {}
+
+            Matrix4 Bind;
+            MemoryBuffer<Matrix4> InvBinds;
+            vector<system::StringId> JointIds;
+            system::StringId RootJointId;
+
+            // Bounds of the vertices influenced by each joint, before skinning. Skinned
+            // bounds are these boxes transformed by the palette.
+            MemoryBuffer<BoundingBox> JointAABBs;
+
+            // Union of the skinned bounds seen while playing a key range, complete once
+            // every key of the range has been posed or played past. Built at run time from
+            // the poses instances reach, not offline from the key frames, and shared by
+            // every instance of the skin. Only the bare range is recorded, since cross-fades
+            // and layers reach other poses; a joint depth limit leaves joints unposed, so
+            // the depth is part of the key.
+            struct ClipBounds
+            {
+                int StartIndex;
+                int EndIndex;
+                u32 MaxJointDepth;
+                BoundingBox AABB;
+                vector<bool> Posed;
+                size_t Remaining;
+            };
+
+            vector<ClipBounds> Clips;
+
+            // Returns Clips.size() if the range has no entry.
+            size_t FindClip(int aStartIndex, int aEndIndex, u32 aMaxJointDepth) const
+            {
+                size_t i = 0u;
+                while (i < Clips.size() && (Clips[i].StartIndex != aStartIndex || Clips[i].EndIndex != aEndIndex || Clips[i].MaxJointDepth != aMaxJointDepth)) { i++; }
+
+                return i;
+            }
+
+            // Bind * InvBinds[i], rebuilt when either changes.
+            MemoryBuffer<Matrix4> SkinTransforms;
+            bool bSkinTransformsValid;
+
+        private:
+            friend void ::jz::__IncrementRefCount<SkinData>(SkinData*);
+            friend void ::jz::__DecrementRefCount<SkinData>(SkinData*);
+            friend size_t ::jz::__GetRefCount<SkinData>(SkinData*);
+
+            SkinData& operator=(const SkinData&);
+
+            size_t mReferenceCount;
+        };
+
+        typedef AutoPtr<SkinData> SkinDataPtr;
+
         class AnimatedMeshNode : public MeshNode
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             AnimatedMeshNode();
-            AnimatedMeshNode(const string& aBaseId, const string& aId);
+            AnimatedMeshNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~AnimatedMeshNode();
 
             virtual void Pick(const Ray3D& aRay) override;
@@ -49,47 +126,70 @@ namespace jz
 
             const AnimationControlPtr& GetAnimationControl() const { return mpAnimationControl; }
             
-            const Matrix4& GetBindTransform() const { return mBind; }
-            void SetBindTransform(const Matrix4& m) { mBind = m; }
+            const Matrix4& GetBindTransform() const { return mpSkin->Bind; }
+            void SetBindTransform(const Matrix4& m) { _Skin().Bind = m; }
+
+            const MemoryBuffer<Matrix4>& GetInvBindTransforms() const { return mpSkin->InvBinds; }
+            MemoryBuffer<Matrix4>& GetInvBindTransforms() { return _Skin().InvBinds; }
+
+            const vector<system::StringId>& GetJointIds() const { return mpSkin->JointIds; }
+            vector<system::StringId>& GetJointIds() { mbJointsDirty = true; return _Skin().JointIds; }
 
-            const MemoryBuffer<Matrix4>& GetInvBindTransforms() const { return mInvBinds; }
-            MemoryBuffer<Matrix4>& GetInvBindTransforms() { return mInvBinds; }
+            const system::StringId& GetRootJointId() const { return mpSkin->RootJointId; }
+            void SetRootJointId(const system::StringId& s) { _Skin().RootJointId = s; mbJointsDirty = true; }
 
-            const vector<string>& GetJointIds() const { return mJointIds; }
-            vector<string>& GetJointIds() { return mJointIds; mbJointsDirty = true; }
+            const MemoryBuffer<BoundingBox>& GetJointAABBs() const { return mpSkin->JointAABBs; }
+            MemoryBuffer<BoundingBox>& GetJointAABBs() { return _Skin().JointAABBs; }
 
-            const string& GetRootJointId() const { return mRootJointId; }
-            void SetRootJointId(const string& s) { mRootJointId = s; mbJointsDirty = true; }
+            // Fraction of its size by which a complete clip bound is grown on each side,
+            // for poses between updates that were never seen.
+            static const float kClipPadding;
+
+            // When set, the node is bounded by the padded union of the poses seen playing
+            // its key range, once every key has been reached, instead of by its current
+            // pose, which is then no longer bounded each update. Fades and layers fall back
+            // to the current pose. For characters too far away for tight bounds to pay for
+            // themselves.
+            bool bConservativeBounds() const { return mbConservativeBounds; }
+            void SetConservativeBounds(bool b) { mbConservativeBounds = b; }
 
             const MemoryBuffer<Vector4>& GetSkinning() const { return mSkinning; }
 
         protected:
             virtual void _PopulateClone(SceneNode* apNode) override;
             virtual void _PostUpdate(bool abChanged)  override;
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId) override;
+            virtual void _PreUpdateA(const Matrix4& aParentWorld, bool abParentChanged) override;
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId) override;
 
-            Matrix4 mBind;
             AnimationControlPtr mpAnimationControl;
-            MemoryBuffer<Matrix4> mInvBinds;
+            SkinDataPtr mpSkin;
             vector<JointNodePtr> mJoints;
-            vector<string> mJointIds;
             bool mbJointsDirty;
             int mRootIndex;
             JointNodePtr mpRootJoint;
-            string mRootJointId;
             MemoryBuffer<Vector4> mSkinning;
-            
-            vector<BoundingBox> mAABBCache;
-            vector<BoundingSphere> mBoundingCache;
-            vector<bool> mBoundingCached;
+            bool mbSkinningChanged;
+            BoundingBox mSkinnedAABB;
+            bool mbSkinnedAABBChanged;
+            bool mbConservativeBounds;
+
+            // The clip this node last added a pose to, and the key it was at.
+            size_t mClip;
+            int mClipIndex;
 
         private:
+            friend class AnimationBatch;
             friend void ::jz::__IncrementRefCount<AnimatedMeshNode>(AnimatedMeshNode*);
             friend void ::jz::__DecrementRefCount<AnimatedMeshNode>(AnimatedMeshNode*);
 
             AnimatedMeshNode(const AnimatedMeshNode&);
             AnimatedMeshNode& operator=(const AnimatedMeshNode&);
 
+            size_t _FindClip() const;
+            const Animation* _GetTimeline() const;
+            SkinData& _Skin();
+            void _UpdateBounds();
+            void _UpdateSkinning();
             void _SetJoint(size_t i, SceneNode* p);
             void _SetRootJoint(SceneNode* p);
         };
@@ -20,77 +20,581 @@
 // THE SOFTWARE.
 // 
 
+#include <jz_core/Quaternion.h>
 #include <jz_engine_3D/Animation.h>
-#include <jz_system/Time.h>
+#include <algorithm>
 
 namespace jz
 {
     namespace engine_3D
     {
 
+        static const float kPackedQuaternionScale = 32767.0f;
+
+        static s16 PackComponent(float v)
+        {
+            const float kScaled = (jz::Clamp(v, -1.0f, 1.0f) * kPackedQuaternionScale);
+
+            return (s16)((kScaled >= 0.0f) ? (kScaled + 0.5f) : (kScaled - 0.5f));
+        }
+
+        static PackedQuaternion Pack(const Quaternion& q)
+        {
+            PackedQuaternion ret;
+            ret.X = PackComponent(q.X);
+            ret.Y = PackComponent(q.Y);
+            ret.Z = PackComponent(q.Z);
+            ret.W = PackComponent(q.W);
+
+            return ret;
+        }
+
+        static Quaternion Unpack(const PackedQuaternion& q)
+        {
+            return Quaternion(q.X / kPackedQuaternionScale,
+                              q.Y / kPackedQuaternionScale,
+                              q.Z / kPackedQuaternionScale,
+                              q.W / kPackedQuaternionScale);
+        }
+
+        // Splits m into scale * rotation * translation. A mirrored basis is carried by a
+        // negative X scale so that the rotation stays proper.
+        static void Decompose(const Matrix4& m, Quaternion& arRotation, Vector3& arTranslation, Vector3& arScale)
+        {
+            Vector3 r0(m.M11, m.M12, m.M13);
+            Vector3 r1(m.M21, m.M22, m.M23);
+            Vector3 r2(m.M31, m.M32, m.M33);
+
+            arScale = Vector3(r0.Length(), r1.Length(), r2.Length());
+            if (Vector3::Dot(Vector3::Cross(r0, r1), r2) < 0.0f) { arScale.X = -arScale.X; }
+
+            r0 = (AboutZero(arScale.X)) ? Vector3::kUnitX : (r0 / arScale.X);
+            r1 = (AboutZero(arScale.Y)) ? Vector3::kUnitY : (r1 / arScale.Y);
+            r2 = (AboutZero(arScale.Z)) ? Vector3::kUnitZ : (r2 / arScale.Z);
+
+            Matrix4 rotation(r0.X, r0.Y, r0.Z, 0,
+                             r1.X, r1.Y, r1.Z, 0,
+                             r2.X, r2.Y, r2.Z, 0,
+                             0,    0,    0,    1);
+
+            ToQuaternion(rotation, arRotation);
+            arRotation = Quaternion::Normalize(arRotation);
+            arTranslation = m.GetTranslation();
+        }
+
+        static void Compose(const Quaternion& aRotation, const Vector3& aTranslation, const Vector3& aScale, Matrix4& m)
+        {
+            m = Matrix4::kIdentity;
+            ToTransform(aRotation, m);
+
+            m.M11 *= aScale.X; m.M12 *= aScale.X; m.M13 *= aScale.X;
+            m.M21 *= aScale.Y; m.M22 *= aScale.Y; m.M23 *= aScale.Y;
+            m.M31 *= aScale.Z; m.M32 *= aScale.Z; m.M33 *= aScale.Z;
+
+            ToTransform(aTranslation, m);
+        }
+
+        static Quaternion Interpolate(const Quaternion& a, const Quaternion& b, float aWeightOfB) { return Quaternion::Nlerp(a, b, aWeightOfB); }
+        static Vector3 Interpolate(const Vector3& a, const Vector3& b, float aWeightOfB) { return Vector3::Lerp(a, b, aWeightOfB); }
+
+        // q and -q are the same rotation.
+        static float Distance(const Quaternion& a, const Quaternion& b) { return Min((a - b).Length(), (a + b).Length()); }
+        static float Distance(const Vector3& a, const Vector3& b) { return Vector3::Distance(a, b); }
+
+        // Picks the keys of aValues to keep so that interpolating between kept keys is
+        // within aTolerance of every dropped key. The first key is always kept.
+        template <typename T>
+        static void Reduce(const vector<T>& aValues, const MemoryBuffer<float>& aTimes, float aTolerance, vector<u16>& arKeys)
+        {
+            const size_t kCount = aValues.size();
+
+            arKeys.clear();
+            arKeys.push_back(0u);
+
+            size_t a = 0u;
+            for (size_t b = 2u; b < kCount; b++)
+            {
+                const float kSpan = (aTimes[b] - aTimes[a]);
+
+                bool bCovered = true;
+                for (size_t k = (a + 1u); k < b && bCovered; k++)
+                {
+                    const float kWeight = (kSpan > 0.0f) ? ((aTimes[k] - aTimes[a]) / kSpan) : 0.0f;
+                    bCovered = (Distance(Interpolate(aValues[a], aValues[b], kWeight), aValues[k]) <= aTolerance);
+                }
+
+                if (!bCovered)
+                {
+                    a = (b - 1u);
+                    arKeys.push_back((u16)a);
+                }
+            }
+
+            if (kCount > 1u)
+            {
+                bool bConstant = (arKeys.size() == 1u);
+                for (size_t k = 1u; k < kCount && bConstant; k++)
+                {
+                    bConstant = (Distance(aValues[0], aValues[k]) <= aTolerance);
+                }
+
+                if (!bConstant) { arKeys.push_back((u16)(kCount - 1u)); }
+            }
+        }
+
+        static void Store(const vector<u16>& aKeys, const vector<Vector3>& aValues, MemoryBuffer<u16>& arKeys, MemoryBuffer<Vector3>& arValues)
+        {
+            const size_t kCount = aKeys.size();
+
+            arKeys.resize(kCount);
+            arValues.resize(kCount);
+            for (size_t i = 0u; i < kCount; i++)
+            {
+                arKeys[i] = aKeys[i];
+                arValues[i] = aValues[aKeys[i]];
+            }
+        }
+
+        const float Animation::kDefaultTolerance = 1e-3f;
+
+        void Animation::Compress(float aTolerance)
+        {
+            const size_t kCount = KeyFrames.size();
+
+            if (kCount == 0u || kCount > ((size_t)USHRT_MAX + 1u)) { return; }
+
+            vector<Quaternion> rotations(kCount);
+            vector<Vector3> translations(kCount);
+            vector<Vector3> scales(kCount);
+
+            mTimes.resize(kCount);
+            for (size_t i = 0u; i < kCount; i++)
+            {
+                mTimes[i] = KeyFrames[i].TimeAndPadding.X;
+                Decompose(KeyFrames[i].Key, rotations[i], translations[i], scales[i]);
+
+                // Keep neighbouring rotations in one hemisphere so that nlerp takes the
+                // short way round.
+                if (i > 0u && Quaternion::Dot(rotations[i - 1u], rotations[i]) < 0.0f)
+                {
+                    rotations[i] = -rotations[i];
+                }
+            }
+
+            vector<u16> keys;
+
+            Reduce(rotations, mTimes, aTolerance, keys);
+            mRotations.Keys.resize(keys.size());
+            mRotations.Values.resize(keys.size());
+            for (size_t i = 0u; i < keys.size(); i++)
+            {
+                mRotations.Keys[i] = keys[i];
+                mRotations.Values[i] = Pack(rotations[keys[i]]);
+            }
+
+            Reduce(translations, mTimes, aTolerance, keys);
+            Store(keys, translations, mTranslations.Keys, mTranslations.Values);
+
+            Reduce(scales, mTimes, aTolerance, keys);
+            Store(keys, scales, mScales.Keys, mScales.Values);
+
+            KeyFrames.clear();
+        }
+
+        size_t Animation::FindKey(float aTime, size_t aBegin, size_t aEnd) const
+        {
+            size_t low = aBegin;
+            size_t high = aEnd;
+
+            while (low < high)
+            {
+                const size_t kMiddle = low + ((high - low) / 2u);
+
+                if (GetTime(kMiddle) <= aTime) { low = (kMiddle + 1u); }
+                else { high = kMiddle; }
+            }
+
+            return (low > aBegin) ? (low - 1u) : aBegin;
+        }
+
+        template <typename T>
+        float Animation::_GetWeight(const Channel<T>& aChannel, size_t aKey, float aTime, size_t& arIndex) const
+        {
+            // Keys[0] is always 0, so the upper bound is never the first entry.
+            const u16* p = upper_bound(aChannel.Keys.begin(), aChannel.Keys.end(), (u16)aKey);
+            arIndex = (size_t)(p - aChannel.Keys.begin()) - 1u;
+
+            if ((arIndex + 1u) >= aChannel.Keys.size()) { return 0.0f; }
+
+            const float kTime0 = mTimes[aChannel.Keys[arIndex]];
+            const float kTime1 = mTimes[aChannel.Keys[arIndex + 1u]];
+
+            return (kTime1 > kTime0) ? jz::Clamp((aTime - kTime0) / (kTime1 - kTime0), 0.0f, 1.0f) : 0.0f;
+        }
+
+        void Animation::Sample(size_t aKey, float aTime, Matrix4& m) const
+        {
+            if (!bCompressed())
+            {
+                if ((aKey + 1u) < KeyFrames.size())
+                {
+                    const float kTime0 = KeyFrames[aKey].TimeAndPadding.X;
+                    const float kTime1 = KeyFrames[aKey + 1u].TimeAndPadding.X;
+                    const float kWeight = (kTime1 > kTime0) ? jz::Clamp((aTime - kTime0) / (kTime1 - kTime0), 0.0f, 1.0f) : 0.0f;
+
+                    m = Matrix4::Lerp(KeyFrames[aKey].Key, KeyFrames[aKey + 1u].Key, kWeight);
+                }
+                else
+                {
+                    m = KeyFrames[aKey].Key;
+                }
+
+                return;
+            }
+
+            AnimationPose pose;
+            Sample(aKey, aTime, pose);
+            pose.ToTransform(m);
+        }
+
+        void Animation::Sample(size_t aKey, float aTime, AnimationPose& arPose) const
+        {
+            if (!bCompressed())
+            {
+                Matrix4 m;
+                Sample(aKey, aTime, m);
+                Decompose(m, arPose.Rotation, arPose.Translation, arPose.Scale);
+
+                return;
+            }
+
+            size_t i;
+            float weight;
+
+            weight = _GetWeight(mRotations, aKey, aTime, i);
+            arPose.Rotation = (weight > 0.0f)
+                ? Quaternion::Nlerp(Unpack(mRotations.Values[i]), Unpack(mRotations.Values[i + 1u]), weight)
+                : Quaternion::Normalize(Unpack(mRotations.Values[i]));
+
+            weight = _GetWeight(mTranslations, aKey, aTime, i);
+            arPose.Translation = (weight > 0.0f)
+                ? Vector3::Lerp(mTranslations.Values[i], mTranslations.Values[i + 1u], weight)
+                : mTranslations.Values[i];
+
+            weight = _GetWeight(mScales, aKey, aTime, i);
+            arPose.Scale = (weight > 0.0f)
+                ? Vector3::Lerp(mScales.Values[i], mScales.Values[i + 1u], weight)
+                : mScales.Values[i];
+        }
+
+        AnimationPose AnimationPose::Blend(const AnimationPose& a, const AnimationPose& b, float aWeightOfB)
+        {
+            AnimationPose ret;
+            ret.Rotation = Quaternion::Nlerp(a.Rotation, b.Rotation, aWeightOfB);
+            ret.Translation = Vector3::Lerp(a.Translation, b.Translation, aWeightOfB);
+            ret.Scale = Vector3::Lerp(a.Scale, b.Scale, aWeightOfB);
+
+            return ret;
+        }
+
+        AnimationPose AnimationPose::Add(const AnimationPose& aBase, const AnimationPose& aReference, const AnimationPose& aPose, float aWeight)
+        {
+            // Rotation delta taken so that aBase == aReference gives back aPose.
+            const Quaternion kDelta = (Quaternion::Invert(aReference.Rotation) * aPose.Rotation);
+
+            AnimationPose ret;
+            ret.Rotation = Quaternion::Normalize(aBase.Rotation * Quaternion::Nlerp(Quaternion::kIdentity, kDelta, aWeight));
+            ret.Translation = aBase.Translation + (aWeight * (aPose.Translation - aReference.Translation));
+
+            for (int i = 0; i < 3; i++)
+            {
+                const float kRatio = (AboutZero(aReference.Scale[i])) ? 1.0f : (aPose.Scale[i] / aReference.Scale[i]);
+                ret.Scale[i] = aBase.Scale[i] * jz::Lerp(1.0f, kRatio, aWeight);
+            }
+
+            return ret;
+        }
+
+        void AnimationPose::ToTransform(Matrix4& m) const
+        {
+            Compose(Rotation, Translation, Scale, m);
+        }
+
         AnimationControl::AnimationControl()
             : mReferenceCount(0u),
-            mStartTime(0.0f),
+            mStartTime(0.0),
             mCurrentIndex(0),
             mStartIndex(0),
             mEndIndex(0),
             mbPlay(false),
-            mbDirty(true)
+            mbDirty(true),
+            mTime(0.0),
+            mRelativeTime(0.0f),
+            mbChanged(false),
+            mbValid(false),
+            mbBlendDirty(false),
+            mFadeDuration(0.0f),
+            mFadeStartTime(0.0),
+            mFadeWeight(1.0f),
+            mbFadeStarted(false),
+            mUpdateInterval(0.0),
+            mMaxJointDepth(kAllJoints)
         {}
 
         AnimationControl::~AnimationControl()
         {
         }
 
-        bool AnimationControl::Tick(const Animation& aAnimation, Matrix4& m)
+        void AnimationControl::CrossFade(int aStartIndex, int aEndIndex, float aDuration)
+        {
+            if (aDuration > 0.0f && mbValid)
+            {
+                // Snapshot of the current range, which keeps playing on its own while it
+                // fades out. A fade still in progress carries over with it.
+                AnimationControlPtr p(new AnimationControl());
+                p->mCurrentIndex = mCurrentIndex;
+                p->mStartIndex = mStartIndex;
+                p->mEndIndex = mEndIndex;
+                p->mbPlay = mbPlay;
+                p->mStartTime = mStartTime;
+                p->mbDirty = mbDirty;
+                p->mTime = mTime;
+                p->mRelativeTime = mRelativeTime;
+                p->mbChanged = mbChanged;
+                p->mbValid = mbValid;
+                p->mpFadeFrom = mpFadeFrom;
+                p->mFadeDuration = mFadeDuration;
+                p->mFadeStartTime = mFadeStartTime;
+                p->mFadeWeight = mFadeWeight;
+                p->mbFadeStarted = mbFadeStarted;
+
+                mpFadeFrom = p;
+                mFadeDuration = aDuration;
+                mFadeWeight = 0.0f;
+                mbFadeStarted = false;
+            }
+            else
+            {
+                mpFadeFrom.Reset();
+                mFadeWeight = 1.0f;
+            }
+
+            mStartIndex = aStartIndex;
+            mEndIndex = aEndIndex;
+            mCurrentIndex = aStartIndex;
+            mbPlay = true;
+            mbDirty = true;
+        }
+
+        size_t AnimationControl::AddLayer(AnimationControl* apControl, float aWeight, bool abAdditive)
+        {
+            JZ_ASSERT(apControl && apControl != this);
+
+            Layer layer;
+            layer.pControl.Reset(apControl);
+            layer.Weight = aWeight;
+            layer.bAdditive = abAdditive;
+
+            mLayers.push_back(layer);
+            mbBlendDirty = true;
+
+            return (mLayers.size() - 1u);
+        }
+
+        void AnimationControl::RemoveLayer(size_t aLayer)
+        {
+            mLayers.erase(mLayers.begin() + aLayer);
+            mbBlendDirty = true;
+        }
+
+        void AnimationControl::SetLayerMask(size_t aLayer, const JointMask& aMask)
+        {
+            JointMask& mask = mLayers[aLayer].Mask;
+            mask = aMask;
+            sort(mask.begin(), mask.end());
+            mask.erase(unique(mask.begin(), mask.end()), mask.end());
+
+            mbBlendDirty = true;
+        }
+
+        bool AnimationControl::Advance(const Animation& aTimeline, double aTime)
+        {
+            const bool kbDirty = (mbDirty || mbBlendDirty);
+
+            if (!kbDirty && aTime == mTime) { return mbChanged; }
+
+            // Reduced update rate: hold the last pose until the interval has passed. The
+            // next update samples at the actual time, so the motion does not fall behind.
+            if (!kbDirty && mUpdateInterval > 0.0 && (aTime - mTime) < mUpdateInterval)
+            {
+                mbChanged = false;
+                return mbChanged;
+            }
+
+            _AdvanceRange(aTimeline, aTime);
+
+            bool bChanged = (mbChanged || mbBlendDirty);
+            mbBlendDirty = false;
+
+            const size_t kLayers = mLayers.size();
+            for (size_t i = 0u; i < kLayers; i++)
+            {
+                if (mLayers[i].pControl->Advance(aTimeline, aTime)) { bChanged = true; }
+            }
+
+            if (mpFadeFrom.IsValid())
+            {
+                mpFadeFrom->Advance(aTimeline, aTime);
+
+                if (!mbFadeStarted)
+                {
+                    mFadeStartTime = aTime;
+                    mbFadeStarted = true;
+                }
+
+                mFadeWeight = jz::Clamp((float)((aTime - mFadeStartTime) / mFadeDuration), 0.0f, 1.0f);
+                if (mFadeWeight >= 1.0f) { mpFadeFrom.Reset(); }
+
+                bChanged = true;
+            }
+
+            mbChanged = bChanged;
+
+            return mbChanged;
+        }
+
+        void AnimationControl::_AdvanceRange(const Animation& aTimeline, double aTime)
         {
-            if (mbPlay || mbDirty)
+            mTime = aTime;
+            mbChanged = (mbPlay || mbDirty);
+
+            if (mbChanged)
             {
-                bool bOk = (mStartIndex >= 0 &&
-                            mStartIndex < mEndIndex &&
-                            mEndIndex < (int)aAnimation.KeyFrames.size());
+                mbValid = (mStartIndex >= 0 &&
+                           mStartIndex < mEndIndex &&
+                           mEndIndex < (int)aTimeline.GetKeyCount());
                 
                 mCurrentIndex = jz::Clamp(mCurrentIndex, mStartIndex, mEndIndex);
 
-                float currentTime = system::Time::GetSingleton().GetSeconds();
-
-                if (bOk && mbDirty)
+                if (mbValid && mbDirty)
                 {
-                    mStartTime = (currentTime - aAnimation.KeyFrames[mCurrentIndex].TimeAndPadding.X);
-                    mbDirty = false;
+                    mStartTime = (aTime - aTimeline.GetTime(mCurrentIndex));
                 }
+                mbDirty = false;
 
-                float relTime = (currentTime - mStartTime);
+                float relTime = (float)(aTime - mStartTime);
 
-                if (bOk)
+                if (mbValid)
                 {
-                    while (relTime > aAnimation.KeyFrames[mCurrentIndex + 1].TimeAndPadding.X)
+                    const float kStartTime = aTimeline.GetTime(mStartIndex);
+                    const float kLength = (aTimeline.GetTime(mEndIndex) - kStartTime);
+
+                    // Wrap by whole loops in one step, however long since the last tick.
+                    if (kLength > 0.0f && relTime > (kStartTime + kLength))
                     {
-                        mCurrentIndex++;
+                        mStartTime += (kLength * floor((relTime - kStartTime) / kLength));
+                        relTime = (float)(aTime - mStartTime);
+                        mCurrentIndex = mStartIndex;
+                    }
 
-                        if (mCurrentIndex >= mEndIndex)
+                    // Usually still in the current key or the next one; otherwise search.
+                    if (mCurrentIndex >= mEndIndex || relTime > aTimeline.GetTime(mCurrentIndex + 1))
+                    {
+                        if ((mCurrentIndex + 2) <= mEndIndex && relTime <= aTimeline.GetTime(mCurrentIndex + 2))
                         {
-                            mCurrentIndex = mStartIndex;
-                            mStartTime += (aAnimation.KeyFrames[mEndIndex].TimeAndPadding.X - aAnimation.KeyFrames[mStartIndex].TimeAndPadding.X);
-                            relTime = (currentTime - mStartTime);
+                            mCurrentIndex++;
+                        }
+                        else
+                        {
+                            mCurrentIndex = (int)aTimeline.FindKey(relTime, (size_t)mStartIndex, (size_t)mEndIndex);
                         }
                     }
+                }
+
+                mRelativeTime = relTime;
+            }
+        }
+
+        bool AnimationControl::Sample(const Animation& aAnimation, const system::StringId& aJoint, Matrix4& m) const
+        {
+            if (!mbChanged || aAnimation.GetKeyCount() == 0u) { return false; }
+
+            if (mLayers.empty() && !mpFadeFrom.IsValid())
+            {
+                if (mbValid && (size_t)mCurrentIndex < aAnimation.GetKeyCount())
+                {
+                    aAnimation.Sample((size_t)mCurrentIndex, mRelativeTime, m);
+                }
+                else
+                {
+                    aAnimation.Sample(0u, aAnimation.GetTime(0u), m);
+                }
+
+                return true;
+            }
+
+            AnimationPose pose;
+            _Sample(aAnimation, aJoint, pose);
+            pose.ToTransform(m);
+
+            return true;
+        }
+
+        void AnimationControl::_Sample(const Animation& aAnimation, const system::StringId& aJoint, AnimationPose& arPose) const
+        {
+            _SampleRange(aAnimation, arPose);
+
+            if (mpFadeFrom.IsValid())
+            {
+                AnimationPose from;
+                mpFadeFrom->_Sample(aAnimation, aJoint, from);
+                arPose = AnimationPose::Blend(from, arPose, mFadeWeight);
+            }
+
+            const size_t kLayers = mLayers.size();
+            for (size_t i = 0u; i < kLayers; i++)
+            {
+                const Layer& layer = mLayers[i];
+                const float kWeight = jz::Clamp(layer.Weight, 0.0f, 1.0f);
 
-                    float lerp = jz::Clamp((relTime - aAnimation.KeyFrames[mCurrentIndex].TimeAndPadding.X) / (aAnimation.KeyFrames[mCurrentIndex + 1].TimeAndPadding.X - aAnimation.KeyFrames[mCurrentIndex].TimeAndPadding.X), 0.0f, 1.0f);
-                    m = Matrix4::Lerp(aAnimation.KeyFrames[mCurrentIndex].Key, aAnimation.KeyFrames[mCurrentIndex + 1].Key, lerp);
+                if (kWeight <= 0.0f) { continue; }
+                if (!layer.Mask.empty() && !binary_search(layer.Mask.begin(), layer.Mask.end(), aJoint)) { continue; }
 
-                    return true;
+                AnimationPose pose;
+                layer.pControl->_Sample(aAnimation, aJoint, pose);
+
+                if (layer.bAdditive)
+                {
+                    AnimationPose reference;
+                    layer.pControl->_SampleReference(aAnimation, reference);
+                    arPose = AnimationPose::Add(arPose, reference, pose, kWeight);
                 }
-                else if (aAnimation.KeyFrames.size() > 0)
+                else
                 {
-                    m = aAnimation.KeyFrames[0].Key;
-                    return true;
+                    arPose = AnimationPose::Blend(arPose, pose, kWeight);
                 }
             }
+        }
 
-            return false;
+        void AnimationControl::_SampleRange(const Animation& aAnimation, AnimationPose& arPose) const
+        {
+            if (mbValid && (size_t)mCurrentIndex < aAnimation.GetKeyCount())
+            {
+                aAnimation.Sample((size_t)mCurrentIndex, mRelativeTime, arPose);
+            }
+            else
+            {
+                aAnimation.Sample(0u, aAnimation.GetTime(0u), arPose);
+            }
+        }
+
+        // Additive layers apply their difference from the first key of their range.
+        void AnimationControl::_SampleReference(const Animation& aAnimation, AnimationPose& arPose) const
+        {
+            const size_t kKey = (mbValid) ? Min((size_t)mStartIndex, aAnimation.GetKeyCount() - 1u) : 0u;
+
+            aAnimation.Sample(kKey, aAnimation.GetTime(kKey), arPose);
         }
 
     }
 }
-
@@ -27,6 +27,10 @@
 #include <jz_core/Auto.h>
 #include <jz_core/Matrix4.h>
 #include <jz_core/Memory.h>
+#include <jz_core/Quaternion.h>
+#include <jz_core/Vector3.h>
+#include <jz_system/StringId.h>
+#include <vector>
 
 namespace jz
 {
@@ -45,14 +49,131 @@ namespace jz
 
         JZ_STATIC_ASSERT(sizeof(KeyFrame) == 80);
 
-        struct Animation
+        // A joint transform split into parts that can be blended.
+        struct AnimationPose
         {
-            MemoryBuffer<KeyFrame> KeyFrames;        
+            Quaternion Rotation;
+            Vector3 Translation;
+            Vector3 Scale;
+
+            static AnimationPose Blend(const AnimationPose& a, const AnimationPose& b, float aWeightOfB);
+
+            // Adds aWeight of the difference between aPose and aReference to aBase.
+            static AnimationPose Add(const AnimationPose& aBase, const AnimationPose& aReference, const AnimationPose& aPose, float aWeight);
+
+            void ToTransform(Matrix4& m) const;
+        };
+
+        // A rotation quantized to 16 bits per component.
+        struct PackedQuaternion
+        {
+            s16 X, Y, Z, W;
         };
 
+        // Key frames of one joint. Reference counted so that instances of a prefab can
+        // share a single copy; see JointNode::GetAnimation().
+        //
+        // Animations are read as full matrices in KeyFrames. Compress() replaces them with
+        // separate rotation, translation and scale channels, each of which only keeps the
+        // keys that cannot be reproduced by interpolating their neighbours. Key indices
+        // (as used by AnimationControl) refer to the original key frames either way.
+        class Animation sealed
+        {
+        public:
+            static const float kDefaultTolerance;
+
+            Animation()
+                : mReferenceCount(0u)
+            {}
+
+            Animation(const Animation& b)
+                : KeyFrames(b.KeyFrames),
+                mTimes(b.mTimes),
+                mRotations(b.mRotations),
+                mTranslations(b.mTranslations),
+                mScales(b.mScales),
+                mReferenceCount(0u)
+            {}
+
+            Animation& operator=(const Animation& b)
+            {
+                KeyFrames = b.KeyFrames;
+                mTimes = b.mTimes;
+                mRotations = b.mRotations;
+                mTranslations = b.mTranslations;
+                mScales = b.mScales;
+
+                return *this;
+            }
+
+            MemoryBuffer<KeyFrame> KeyFrames;
+
+            // aTolerance bounds the error of a dropped key: the distance between unit
+            // quaternions for rotation, and between vectors for translation and scale.
+            // Animations with more keys than a channel can index are left uncompressed.
+            void Compress(float aTolerance = kDefaultTolerance);
+            bool bCompressed() const { return (mTimes.size() > 0u); }
+
+            // Keys kept by each channel of a compressed animation.
+            size_t GetRotationKeyCount() const { return mRotations.Keys.size(); }
+            size_t GetTranslationKeyCount() const { return mTranslations.Keys.size(); }
+            size_t GetScaleKeyCount() const { return mScales.Keys.size(); }
+
+            size_t GetKeyCount() const { return (bCompressed()) ? mTimes.size() : KeyFrames.size(); }
+            float GetTime(size_t aKey) const { return (bCompressed()) ? mTimes[aKey] : KeyFrames[aKey].TimeAndPadding.X; }
+
+            // Returns the last key in [aBegin, aEnd) whose time is <= aTime, or aBegin.
+            size_t FindKey(float aTime, size_t aBegin, size_t aEnd) const;
+
+            // The transform at aTime, which lies between the times of aKey and aKey + 1.
+            void Sample(size_t aKey, float aTime, Matrix4& m) const;
+            void Sample(size_t aKey, float aTime, AnimationPose& arPose) const;
+
+        private:
+            friend void ::jz::__IncrementRefCount<Animation>(Animation*);
+            friend void ::jz::__DecrementRefCount<Animation>(Animation*);
+            friend size_t ::jz::__GetRefCount<Animation>(Animation*);
+
+            template <typename T>
+            struct Channel
+            {
+                MemoryBuffer<u16> Keys;
+                MemoryBuffer<T> Values;
+            };
+
+            MemoryBuffer<float> mTimes;
+            Channel<PackedQuaternion> mRotations;
+            Channel<Vector3> mTranslations;
+            Channel<Vector3> mScales;
+
+            size_t mReferenceCount;
+
+            template <typename T>
+            float _GetWeight(const Channel<T>& aChannel, size_t aKey, float aTime, size_t& arIndex) const;
+        };
+
+        typedef AutoPtr<Animation> AnimationPtr;
+
+        // Joints a layer applies to, sorted. An empty mask applies to every joint.
+        typedef vector<system::StringId> JointMask;
+
+        class AnimationControl;
+        typedef AutoPtr<AnimationControl> AnimationControlPtr;
+
+        // Plays a range of key frames of the animations of a skeleton's joints. On top of
+        // the range, a control can cross-fade from the range it played before, and blend
+        // in layers: other controls, applied in order either as a weighted override or as
+        // an additive difference from the first key of their range, optionally masked to
+        // some joints.
+        //
+        // For animation LOD, a control can be limited to an update interval (skipped
+        // updates hold the last pose) and to a joint depth below which joints are left
+        // unposed; see AnimationBatch.
         class AnimationControl sealed
         {
         public:
+            static const u32 kAllJoints = 0xFFFFFFFF;
+
             AnimationControl();
             ~AnimationControl();
 
@@ -68,7 +189,35 @@ namespace jz
             bool bPlay() const { return mbPlay; }
             void SetPlay(bool b) { mbPlay = b; mCurrentIndex = mStartIndex; mbDirty = true; }
 
-            bool Tick(const Animation& aAnimation, Matrix4& m);
+            // Plays [aStartIndex, aEndIndex], blending from the current range over aDuration
+            // seconds.
+            void CrossFade(int aStartIndex, int aEndIndex, float aDuration);
+            bool bFading() const { return mpFadeFrom.IsValid(); }
+
+            size_t AddLayer(AnimationControl* apControl, float aWeight, bool abAdditive);
+            void RemoveLayer(size_t aLayer);
+            size_t GetLayerCount() const { return mLayers.size(); }
+            AnimationControl* GetLayerControl(size_t aLayer) const { return mLayers[aLayer].pControl.Get(); }
+            float GetLayerWeight(size_t aLayer) const { return mLayers[aLayer].Weight; }
+            void SetLayerWeight(size_t aLayer, float v) { mLayers[aLayer].Weight = v; mbBlendDirty = true; }
+            const JointMask& GetLayerMask(size_t aLayer) const { return mLayers[aLayer].Mask; }
+            void SetLayerMask(size_t aLayer, const JointMask& aMask);
+
+            double GetUpdateInterval() const { return mUpdateInterval; }
+            void SetUpdateInterval(double v) { mUpdateInterval = v; }
+
+            u32 GetMaxJointDepth() const { return mMaxJointDepth; }
+            void SetMaxJointDepth(u32 v) { mMaxJointDepth = v; }
+
+            // Moves the play position to aTime (in seconds), with the key times taken from
+            // aTimeline. Returns true if joints driven by this control need to be posed
+            // again. Advancing twice to the same time without a change in between does
+            // nothing the second time.
+            bool Advance(const Animation& aTimeline, double aTime);
+
+            // Poses the joint aJoint at the play position of the last Advance(). Returns false
+            // if the joint does not need to be posed.
+            bool Sample(const Animation& aAnimation, const system::StringId& aJoint, Matrix4& m) const;
 
         protected:
             size_t mReferenceCount;
@@ -78,18 +227,46 @@ namespace jz
             int mEndIndex;
             bool mbPlay;
             
-            float mStartTime;
+            double mStartTime;
             bool mbDirty;
 
+            double mTime;
+            float mRelativeTime;
+            bool mbChanged;
+            bool mbValid;
+
+            struct Layer
+            {
+                AnimationControlPtr pControl;
+                float Weight;
+                bool bAdditive;
+                JointMask Mask;
+            };
+
+            vector<Layer> mLayers;
+            bool mbBlendDirty;
+
+            AnimationControlPtr mpFadeFrom;
+            float mFadeDuration;
+            double mFadeStartTime;
+            float mFadeWeight;
+            bool mbFadeStarted;
+
+            double mUpdateInterval;
+            u32 mMaxJointDepth;
+
         private:
             friend void ::jz::__IncrementRefCount<AnimationControl>(AnimationControl*);
             friend void ::jz::__DecrementRefCount<AnimationControl>(AnimationControl*);
 
             AnimationControl(const AnimationControl&);
             AnimationControl& operator=(const AnimationControl&);
-        };
 
-        typedef AutoPtr<AnimationControl> AnimationControlPtr;
+            void _AdvanceRange(const Animation& aTimeline, double aTime);
+            void _Sample(const Animation& aAnimation, const system::StringId& aJoint, AnimationPose& arPose) const;
+            void _SampleRange(const Animation& aAnimation, AnimationPose& arPose) const;
+            void _SampleReference(const Animation& aAnimation, AnimationPose& arPose) const;
+        };
 
     }
 }
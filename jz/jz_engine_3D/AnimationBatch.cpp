@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_engine_3D/AnimatedMeshNode.h>
+#include <jz_engine_3D/AnimationBatch.h>
+#include <jz_engine_3D/JointNode.h>
+#include <jz_system/Jobs.h>
+#include <jz_system/Time.h>
+#include <algorithm>
+
+namespace jz
+{
+    namespace engine_3D
+    {
+
+        AnimationBatch::AnimationBatch()
+            : mFrame(0u)
+        {}
+
+        AnimationBatch::~AnimationBatch()
+        {}
+
+        void AnimationBatch::Add(AnimatedMeshNode* apMesh)
+        {
+            mMeshes.push_back(apMesh);
+        }
+
+        void AnimationBatch::Remove(AnimatedMeshNode* apMesh)
+        {
+            mMeshes.erase(remove(mMeshes.begin(), mMeshes.end(), apMesh), mMeshes.end());
+        }
+
+        void AnimationBatch::Pose()
+        {
+            if (mMeshes.empty()) { return; }
+
+            mFrame++;
+            mJoints.clear();
+
+            const double kTime = system::Time::GetSingleton().GetSecondsPrecise();
+            const size_t kMeshes = mMeshes.size();
+
+            // Controls are shared between the joints of a skeleton and sometimes between
+            // meshes, so they are advanced here, once each, before any joint is sampled.
+            for (size_t i = 0u; i < kMeshes; i++)
+            {
+                AnimatedMeshNode* pMesh = mMeshes[i];
+                AnimationControl* pControl = pMesh->mpAnimationControl.Get();
+                const Animation* pTimeline = pMesh->_GetTimeline();
+
+                if (!pControl || !pTimeline || !pControl->Advance(*pTimeline, kTime)) { continue; }
+
+                // Joints below the control's depth limit keep their last pose.
+                const u32 kMaxDepth = pControl->GetMaxJointDepth();
+                const size_t kJoints = pMesh->mJoints.size();
+                for (size_t j = 0u; j <= kJoints; j++)
+                {
+                    JointNode* p = (j < kJoints) ? pMesh->mJoints[j].Get() : pMesh->mpRootJoint.Get();
+
+                    if (p && p->mPoseFrame != mFrame && p->mpAnimationControl.Get() == pControl && p->mSkeletonDepth <= kMaxDepth)
+                    {
+                        p->mPoseFrame = mFrame;
+                        mJoints.push_back(p);
+                    }
+                }
+            }
+
+            if (mJoints.empty()) { return; }
+
+            PoseBody body;
+            body.pThis = this;
+
+            if (system::Jobs::GetSingletonExists() && mJoints.size() >= kParallelThreshold)
+            {
+                system::Jobs::GetSingleton().ParallelFor(body, 0u, mJoints.size(), kJointGrainSize);
+            }
+            else
+            {
+                body(0u, mJoints.size());
+            }
+        }
+
+        void AnimationBatch::Skin()
+        {
+            if (mMeshes.empty()) { return; }
+
+            SkinBody body;
+            body.pThis = this;
+
+            if (system::Jobs::GetSingletonExists() && mMeshes.size() >= kParallelThreshold)
+            {
+                system::Jobs::GetSingleton().ParallelFor(body, 0u, mMeshes.size(), kMeshGrainSize);
+            }
+            else
+            {
+                body(0u, mMeshes.size());
+            }
+
+            mMeshes.clear();
+        }
+
+        void AnimationBatch::_PoseRange(size_t aBegin, size_t aEnd)
+        {
+            for (size_t i = aBegin; i < aEnd; i++)
+            {
+                mJoints[i]->_Pose();
+            }
+        }
+
+        void AnimationBatch::_SkinRange(size_t aBegin, size_t aEnd)
+        {
+            for (size_t i = aBegin; i < aEnd; i++)
+            {
+                mMeshes[i]->_UpdateSkinning();
+            }
+        }
+
+    }
+}
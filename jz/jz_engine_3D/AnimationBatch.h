@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_ENGINE_3D_ANIMATION_BATCH_H_
+#define _JZ_ENGINE_3D_ANIMATION_BATCH_H_
+
+#include <jz_core/Prereqs.h>
+#include <vector>
+
+namespace jz
+{
+    namespace engine_3D
+    {
+
+        class AnimatedMeshNode;
+        class JointNode;
+
+        // Animates the AnimatedMeshNodes visited by one SceneNode::Update() together
+        // instead of one at a time. Meshes add themselves during the pre-update pass.
+        // Pose() then advances each AnimationControl once and samples every joint that
+        // needs it. After the transform update, Skin() builds the skinning palettes of
+        // all meshes whose skeleton moved. Both spread their work over system::Jobs when
+        // it exists.
+        class AnimationBatch sealed
+        {
+        public:
+            // Below this many joints (or meshes), work stays on the calling thread.
+            static const size_t kParallelThreshold = (1 << 6);
+            static const size_t kJointGrainSize = (1 << 5);
+            static const size_t kMeshGrainSize = (1 << 2);
+
+            AnimationBatch();
+            ~AnimationBatch();
+
+            void Add(AnimatedMeshNode* apMesh);
+            void Remove(AnimatedMeshNode* apMesh);
+
+            void Pose();
+            void Skin();
+
+        private:
+            AnimationBatch(const AnimationBatch&);
+            AnimationBatch& operator=(const AnimationBatch&);
+
+            struct PoseBody
+            {
+                void operator()(size_t aBegin, size_t aEnd) { pThis->_PoseRange(aBegin, aEnd); }
+
+                AnimationBatch* pThis;
+            };
+
+            struct SkinBody
+            {
+                void operator()(size_t aBegin, size_t aEnd) { pThis->_SkinRange(aBegin, aEnd); }
+
+                AnimationBatch* pThis;
+            };
+
+            vector<AnimatedMeshNode*> mMeshes;
+            vector<JointNode*> mJoints;
+            u32 mFrame;
+
+            void _PoseRange(size_t aBegin, size_t aEnd);
+            void _SkinRange(size_t aBegin, size_t aEnd);
+        };
+
+    }
+}
+
+#endif
@@ -35,6 +35,8 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(CameraFPSNode, CameraNode);
+
         void CameraFPSNode::SetCollisionEnabled(bool b, float aCollisionRadius, bool abFriction)
         {
             mbWantsPhysicsBody = b;
@@ -57,7 +59,7 @@ namespace jz
                         mpPhysicsBody->SetAffectedByGravity(false);
                         mpPhysicsBody->SetFriction((mbWantsFriction) ? 1.0f : 0.0f);
                         mpPhysicsBody->SetMass(1.0f);
-                        mpPhysicsBody->SetFrame(CoordinateFrame3D::CreateFromMatrix4(mWorld));
+                        mpPhysicsBody->SetFrame(CoordinateFrame3D::CreateFromMatrix4(_World()));
                         mpPhysicsBody->OnUpdate.Add<CameraFPSNode, &CameraFPSNode::__UpdateHandler>(this, mUpdateConnection);
                     }
                     else
@@ -126,9 +128,9 @@ namespace jz
             using namespace system;
             CameraNode::_PreUpdateA(aParentWorld, abParentChanged);
 
-            if (mpPhysicsBody.IsValid() && (mFlags & SceneNodeFlags::kWorldDirty) != 0)
+            if (mpPhysicsBody.IsValid() && (_Flags() & SceneNodeFlags::kWorldDirty) != 0)
             {
-                mpPhysicsBody->SetFrame(CoordinateFrame3D::CreateFromMatrix4(mWorld));
+                mpPhysicsBody->SetFrame(CoordinateFrame3D::CreateFromMatrix4(_World()));
             }
 
             Vector3 vChange = Vector3::kZero;
@@ -178,14 +180,14 @@ namespace jz
             {
                 #pragma region Orientation
                 Quaternion q = Quaternion::CreateFromAxisAngle(Vector3::kUp, mYaw) * Quaternion::CreateFromAxisAngle(Vector3::kRight, mPitch);
-                ToTransform(q, mWorld);
+                ToTransform(q, _World());
                 #pragma endregion
 
                 if (mpPhysicsBody.IsValid())
                 {
-                    Vector3 v = (Vector3::TransformDirection(mWorld, vChange) * mMoveRate);
+                    Vector3 v = (Vector3::TransformDirection(_World(), vChange) * mMoveRate);
                     mpPhysicsBody->SetLinearVelocity(v);
-                    mpPhysicsBody->SetOrientation(Matrix3::CreateFromUpperLeft(mWorld));
+                    mpPhysicsBody->SetOrientation(Matrix3::CreateFromUpperLeft(_World()));
                 }
                 else
                 {
@@ -193,13 +195,13 @@ namespace jz
                     float et = (Time::GetSingleton().GetElapsedSeconds());
                     float delta = (et * mMoveRate);
 
-                    Vector3 newPosition = mWorld.GetTranslation() + (Vector3::TransformDirection(mWorld, vChange) * delta);
-                    ToTransform(newPosition, mWorld);
+                    Vector3 newPosition = _World().GetTranslation() + (Vector3::TransformDirection(_World(), vChange) * delta);
+                    ToTransform(newPosition, _World());
                     #pragma endregion
                 }
 
                 mbUpdateCamera = false;
-                mFlags |= SceneNodeFlags::kWorldDirty;
+                _Flags() |= SceneNodeFlags::kWorldDirty;
             }
             else
             {
@@ -212,8 +214,8 @@ namespace jz
 
         void CameraFPSNode::__UpdateHandler(physics::Body3D* apBody)
         {
-            ToTransform(apBody->GetFrame(), mWorld);
-            mFlags |= SceneNodeFlags::kWorldDirty;
+            ToTransform(apBody->GetFrame(), _World());
+            _Flags() |= SceneNodeFlags::kWorldDirty;
         }
 
         void CameraFPSNode::ResizeHandler()
@@ -51,6 +51,8 @@ namespace jz
 
         class CameraFPSNode sealed : public CameraNode
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             CameraFPSNode()
                 : CameraNode(),
@@ -81,7 +83,7 @@ namespace jz
                 memset(mMouseButtons, system::Mouse::kReleased, system::Mouse::kButtonCount * sizeof(system::Mouse::State));
             }
 
-            CameraFPSNode(const string& aBaseId, const string& aId)
+            CameraFPSNode(const system::StringId& aBaseId, const system::StringId& aId)
                 : CameraNode(aBaseId, aId),
                 mbUpdateMouseLook(false),
                 mbCustomMouseLookRate(false),
@@ -164,7 +166,7 @@ namespace jz
                 }
             }
 
-            virtual void SetIds(const string& aBaseId, const string& aId) override
+            virtual void SetIds(const system::StringId& aBaseId, const system::StringId& aId) override
             {
                 if (aBaseId != GetBaseId())
                 {
@@ -182,7 +184,7 @@ namespace jz
                 }
             }
 
-            virtual void SetBaseId(const string& v) override
+            virtual void SetBaseId(const system::StringId& v) override
             {
                 if (v != GetBaseId())
                 {
@@ -29,11 +29,13 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(CameraNode, SceneNode);
+
         void CameraNode::_PostUpdate(bool abChanged)
         {
             if (abChanged)
             {
-                mView = Matrix4::Invert(mWorld);
+                mView = Matrix4::Invert(_World());
                 mbViewDirty = true;
             }
 
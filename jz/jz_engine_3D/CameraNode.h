@@ -34,6 +34,8 @@ namespace jz
 
         class CameraNode : public SceneNode
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             CameraNode()
                 : SceneNode(),
@@ -43,10 +45,10 @@ namespace jz
                 mProjection(Matrix4::kIdentity),
                 mView(Matrix4::kIdentity)
             {
-                mFlags |= SceneNodeFlags::kExcludeFromBounding;
+                _Flags() |= SceneNodeFlags::kExcludeFromBounding;
             }
 
-            CameraNode(const string& aBaseId, const string& aId)
+            CameraNode(const system::StringId& aBaseId, const system::StringId& aId)
                 : SceneNode(aBaseId, aId),
                 mbActive(false),
                 mbProjectionDirty(false),
@@ -54,7 +56,7 @@ namespace jz
                 mProjection(Matrix4::kIdentity),
                 mView(Matrix4::kIdentity)
             {
-                mFlags |= SceneNodeFlags::kExcludeFromBounding;
+                _Flags() |= SceneNodeFlags::kExcludeFromBounding;
             }
 
             const Matrix4& GetProjection() const { return mProjection; }
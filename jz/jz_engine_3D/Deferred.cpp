@@ -37,7 +37,7 @@
 
 namespace jz
 {
-    engine_3D::Deferred* engine_3D::Deferred::mspSingleton = null;
+    template <> engine_3D::Deferred* Singleton<engine_3D::Deferred>::mspSingleton = null;
     namespace engine_3D
     {
 
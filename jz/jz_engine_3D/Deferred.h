@@ -31,6 +31,7 @@
 #include <jz_core/Utility.h>
 #include <jz_core/Vector4.h>
 #include <jz_graphics/Effect.h>
+#include <jz_system/Mutex.h>
 #include <vector>
 
 namespace jz
@@ -81,8 +82,13 @@ namespace jz
             bool bDebugDeferredLighting() const { return mbDebugDeferredLighting; }
             void SetDebugDeferredLighting(bool v) { mbDebugDeferredLighting = v; }
 
+            // Lights are posed with renderables, which may happen on job workers.
             void RenderLight(LightNode* apNode)
             {
+#               if JZ_MULTITHREADED
+                    system::Lock lock(mLightsMutex);
+#               endif
+
                 if (mbActive && apNode) { mLights.push_back(apNode); }
             }
 
@@ -207,6 +213,9 @@ namespace jz
 
             bool mbDebugDeferredLighting;
             vector<LightNode*> mLights;
+#           if JZ_MULTITHREADED
+                system::Mutex mLightsMutex;
+#           endif
 
             void _Activate();
             void _Deactivate();
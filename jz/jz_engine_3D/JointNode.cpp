@@ -27,12 +27,20 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(JointNode, SceneNode);
+
         JointNode::JointNode()
-            : SceneNode()
+            : SceneNode(),
+            mpAnimation(new Animation()),
+            mPoseFrame(0u),
+            mSkeletonDepth(0u)
         {}
 
-        JointNode::JointNode(const string& aBaseId, const string& aId)
-            : SceneNode(aBaseId, aId)
+        JointNode::JointNode(const system::StringId& aBaseId, const system::StringId& aId)
+            : SceneNode(aBaseId, aId),
+            mpAnimation(new Animation()),
+            mPoseFrame(0u),
+            mSkeletonDepth(0u)
         { }
 
         JointNode::~JointNode()
@@ -43,26 +51,34 @@ namespace jz
         {
             JointNode* p = static_cast<JointNode*>(apNode);
 
-            // Temp: Animation should be referenced.
-            p->mAnimation = mAnimation;
+            SceneNode::_PopulateClone(apNode);
+
+            p->mpAnimation = mpAnimation;
             p->mpAnimationControl = mpAnimationControl;
         }
 
-        SceneNode* JointNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        SceneNode* JointNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
             return new JointNode(aBaseId, aCloneId);
         }
 
         void JointNode::_PreUpdateA(const Matrix4& aParentWorld, bool abParentChanged)
         {
-            if (mpParent && typeid(*mpParent) != typeid(JointNode)) { mFlags |= SceneNodeFlags::kIgnoreParent; }
-            else { mFlags &= ~SceneNodeFlags::kIgnoreParent; }
+            if (mpParent && typeid(*mpParent) != typeid(JointNode)) { _Flags() |= SceneNodeFlags::kIgnoreParent; }
+            else { _Flags() &= ~SceneNodeFlags::kIgnoreParent; }
+
+            // Parents are updated first, so their depth is current.
+            if (mpParent && typeid(*mpParent) == typeid(JointNode)) { mSkeletonDepth = static_cast<JointNode*>(mpParent)->mSkeletonDepth + 1u; }
+            else { mSkeletonDepth = 0u; }
 
             SceneNode::_PreUpdateA(aParentWorld, abParentChanged);
+        }
 
-            if (mpAnimationControl.IsValid() && mpAnimationControl->Tick(mAnimation, mLocal))
+        void JointNode::_Pose()
+        {
+            if (mpAnimationControl.IsValid() && mpAnimationControl->Sample(*mpAnimation, GetId(), _Local()))
             {
-                mFlags |= SceneNodeFlags::kLocalDirty; 
+                _Flags() |= SceneNodeFlags::kLocalDirty; 
             }
         }
 
@@ -34,26 +34,46 @@ namespace jz
 
         class JointNode : public SceneNode
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             JointNode();
-            JointNode(const string& aBaseId, const string& aId);
+            JointNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~JointNode();
 
-            const Animation& GetAnimation() const { return mAnimation; }
-            Animation& GetAnimation() { return mAnimation; }
+            // Clones share the animation of their source until one of them asks for a
+            // mutable reference, which copies the key frames.
+            const Animation& GetAnimation() const { return *mpAnimation; }
+            Animation& GetAnimation()
+            {
+                if (!mpAnimation.IsUnique()) { mpAnimation.Reset(new Animation(*mpAnimation)); }
+
+                return *mpAnimation;
+            }
 
             const AnimationControlPtr& GetAnimationControl() const { return mpAnimationControl; }
             void SetAnimationControl(AnimationControl* p) { mpAnimationControl.Reset(p); }
 
+            // Number of joints between this one and the root of its skeleton, as of the
+            // last update.
+            u32 GetSkeletonDepth() const { return mSkeletonDepth; }
+
         protected:
             virtual void _PopulateClone(SceneNode* apNode) override;
             virtual void _PreUpdateA(const Matrix4& aParentWorld, bool abParentChanged)  override;
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId) override;
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId) override;
 
-            Animation mAnimation;
+            AnimationPtr mpAnimation;
             AnimationControlPtr mpAnimationControl;
 
         private:
+            friend class AnimationBatch;
+
+            u32 mPoseFrame;
+            u32 mSkeletonDepth;
+
+            void _Pose();
+
             friend void jz::__IncrementRefCount<engine_3D::JointNode>(engine_3D::JointNode*);
             friend void jz::__DecrementRefCount<engine_3D::JointNode>(engine_3D::JointNode*);
 
@@ -30,6 +30,8 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(LightNode, SceneNode);
+
         static const float kNearPlaneScale = 4.38e-4f;
         static const float kFarPlaneScale = 1.0f;
         static const float kMaxLightRange = Sqrt(Constants<float>::kMax * 0.5f);
@@ -88,7 +90,7 @@ namespace jz
             mShadowProjection(Matrix4::kIdentity)
         {}
 
-        LightNode::LightNode(const string& aBaseId, const string& aId)
+        LightNode::LightNode(const system::StringId& aBaseId, const system::StringId& aId)
             : SceneNode(aBaseId, aId),
             mType(LightNodeType::kDirectional),
             mAttenuation(Vector3::kUnitX),
@@ -159,7 +161,7 @@ namespace jz
             p->SetCastShadow((mShadowHandle >= 0));
         }
 
-        SceneNode* LightNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        SceneNode* LightNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
             return new LightNode(aBaseId, aCloneId);
         }
@@ -180,7 +182,7 @@ namespace jz
                 #pragma region Update light direction
                 if (mType != LightNodeType::kPoint)
                 {
-                    mWorldLightDirection = Vector3::Normalize(Vector3::TransformDirection(mWit, Vector3::kForward));
+                    mWorldLightDirection = Vector3::Normalize(Vector3::TransformDirection(_Wit(), Vector3::kForward));
                 }
                 else
                 {
@@ -194,7 +196,7 @@ namespace jz
                     float near = (kNearPlaneScale * mRange);
                     float far = (kFarPlaneScale * mRange);
                     mShadowProjection = Matrix4::CreatePerspectiveFieldOfViewDirectX(mFalloffAngle, 1.0f, near, far);
-                    mShadowView = Matrix4::Invert(mWorld);
+                    mShadowView = Matrix4::Invert(_World());
                     mShadowTransform = (mShadowView * mShadowProjection);
                     mWorldFrustum.Set(GetWorldTranslation(), mShadowTransform);
                 }
@@ -49,16 +49,18 @@ namespace jz
 
         class LightNode : public SceneNode, public IRenderable
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             LightNode();
-            LightNode(const string& aBaseId, const string& aId);
+            LightNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~LightNode();
 
             void ClearFixedRange()
             {
                 mbFixedRange = false;
                 mRange = CalculateLightRange(mAttenuation, mColor);
-                mFlags |= SceneNodeFlags::kLocalDirty;
+                _Flags() |= SceneNodeFlags::kLocalDirty;
             }
 
             virtual const BoundingBox& GetBoundingBox() const override { return mWorldAABB; }
@@ -73,7 +75,7 @@ namespace jz
                 if (!mbFixedRange)
                 {
                     mRange = CalculateLightRange(mAttenuation, mColor);
-                    mFlags |= SceneNodeFlags::kLocalDirty;
+                    _Flags() |= SceneNodeFlags::kLocalDirty;
                 }
             }
 
@@ -85,7 +87,7 @@ namespace jz
                 if (!mbFixedRange)
                 {
                     mRange = CalculateLightRange(mAttenuation, mColor);
-                    mFlags |= SceneNodeFlags::kLocalDirty;
+                    _Flags() |= SceneNodeFlags::kLocalDirty;
                 }
             }
 
@@ -94,7 +96,7 @@ namespace jz
             {
                 mbFixedRange = true;
                 mRange = v;
-                mFlags |= SceneNodeFlags::kLocalDirty;
+                _Flags() |= SceneNodeFlags::kLocalDirty;
             }
 
             const Region& GetWorldFrustum() const { return mWorldFrustum; }
@@ -127,7 +129,7 @@ namespace jz
         protected:
             virtual void _PopulateClone(SceneNode* apNode) override;
             virtual void _PostUpdate(bool abChanged)  override;
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId) override;
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId) override;
 
             Vector3 mAttenuation;
             Vector3 mColor;
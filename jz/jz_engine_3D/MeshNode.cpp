@@ -39,6 +39,8 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(MeshNode, SceneNode);
+
         static void DrawMesh(graphics::RenderNode* apNode, voidc_p apInstance)
         {
             const MeshNode* p = static_cast<const MeshNode*>(apInstance);
@@ -113,7 +115,7 @@ namespace jz
             mScale(Vector3::kOne)
         {}
 
-        MeshNode::MeshNode(const string& aBaseId, const string& aId)
+        MeshNode::MeshNode(const system::StringId& aBaseId, const system::StringId& aId)
             : SceneNode(aBaseId, aId), 
             mbVisible(true),
             mbNonDeferred(false),
@@ -134,13 +136,12 @@ namespace jz
             {
                 RenderMan& rm = RenderMan::GetSingleton();
                 
-                graphics::RenderPack pack = mPack;
-                pack.DrawFunc = DrawMesh;
-                pack.DrawFuncParam = this;
-                pack.EffectTechnique = (mbNonDeferred) ? static_cast<StandardEffect*>(pack.pEffect.Get())->GetNonDeferredTechnique() : static_cast<StandardEffect*>(pack.pEffect.Get())->GetRenderTechnique();
-                pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(mWorld * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                StandardEffect* pEffect = static_cast<StandardEffect*>(mPack.pEffect.Get());
+                graphics::Technique technique = (mbNonDeferred) ? pEffect->GetNonDeferredTechnique() : pEffect->GetRenderTechnique();
+                float sort = (mPack.pMesh.IsValid()) ? Vector3::TransformPosition(_World() * rm.GetView(), mPack.pMesh->GetAABB().Center()).Z : 0.0f;
 
-                rm.Pose(pack);
+                // mPack is not copied, posing can run on job workers.
+                rm.Pose(mPack, DrawMesh, this, technique, sort);
             }
         }
 
@@ -159,7 +160,7 @@ namespace jz
                     pack.DrawFunc = DrawMesh;
                     pack.DrawFuncParam = this;
                     pack.EffectTechnique = pEffect->GetPickingTechnique();
-                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(mWorld * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(_World() * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
 
                     pm.Pose(pack, this);
                 }
@@ -181,7 +182,7 @@ namespace jz
                     pack.DrawFuncParam = this;
                     pack.Flags |= (graphics::RenderPack::kReflection);
                     pack.EffectTechnique = se->GetReflectionTechnique();
-                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(mWorld * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(_World() * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
                     pack.PreEffectFunc = SetActiveReflectivePlaneHandle;
                     pack.PreEffectFuncParam = apReflectivePlane;
 
@@ -205,7 +206,7 @@ namespace jz
                     pack.DrawFuncParam = this;
                     pack.Flags = (graphics::RenderPack::kShadow);
                     pack.EffectTechnique = se->GetShadowTechnique();
-                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(mWorld * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                    pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(_World() * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
                     pack.PreEffectFunc = SetActiveShadowHandle;
                     pack.PreEffectFuncParam = apLight;
 
@@ -247,10 +248,12 @@ namespace jz
         {
             MeshNode* p = static_cast<MeshNode*>(apNode);
 
+            SceneNode::_PopulateClone(apNode);
+
             p->mPack = mPack;
         }
 
-        SceneNode* MeshNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        SceneNode* MeshNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
             return new MeshNode(aBaseId, aCloneId);
         }
@@ -259,8 +262,8 @@ namespace jz
         {
             if (abChanged && mPack.pMesh.IsValid())
             {
-                mWorldAABB = BoundingBox::Transform(mWorld, mPack.pMesh->GetAABB());
-                mWorldBounding = BoundingSphere::Transform(mWorld, mPack.pMesh->GetBoundingSphere());
+                mWorldAABB = BoundingBox::Transform(_World(), mPack.pMesh->GetAABB());
+                mWorldBounding = BoundingSphere::Transform(_World(), mPack.pMesh->GetBoundingSphere());
                 mbValidBounding = true;
             }
 
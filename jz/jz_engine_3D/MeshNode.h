@@ -40,9 +40,11 @@ namespace jz
         class StandardEffect; typedef AutoPtr<StandardEffect> StandardEffectPtr;
         class MeshNode : public SceneNode, public IPickable, public IReflectable, public IRenderable, public IShadowable
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             MeshNode();
-            MeshNode(const string& aBaseId, const string& aId);
+            MeshNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~MeshNode();
 
             bool bVisible() const { return mbVisible; }
@@ -86,7 +88,7 @@ namespace jz
         protected:
             virtual void _PopulateClone(SceneNode* apNode) override;
             virtual void _PostUpdate(bool abChanged)  override;
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId) override;
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId) override;
 
             bool mbVisible;
             bool mbNonDeferred;
@@ -30,6 +30,7 @@
 #include <jz_physics/World.h>
 #include <jz_physics/narrowphase/Body.h>
 #include <jz_physics/narrowphase/collision/TriangleTreeShape.h>
+#include <jz_system/Jobs.h>
 #include <jz_system/Time.h>
 
 namespace jz
@@ -37,22 +38,26 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(PhysicsNode, SceneNode);
+
         PhysicsNode::PhysicsNode()
             : SceneNode(),
             mpWorld(new physics::World3D()),
             mpWorldTree(new physics::TriangleTreeShape()),
             mpWorldBody(mpWorld->Create(mpWorldTree.Get(),
                 physics::Body3D::kStatic, physics::Body3D::kDynamic)),
+            mDebugPack(graphics::RenderPack::Create()),
             mbTreeDirty(false),
             mbDebugPhysics(false)
         {}
 
-        PhysicsNode::PhysicsNode(const string& aBaseId, const string& aId)
+        PhysicsNode::PhysicsNode(const system::StringId& aBaseId, const system::StringId& aId)
             : SceneNode(aBaseId, aId),
             mpWorld(new physics::World3D()),
             mpWorldTree(new physics::TriangleTreeShape()),
             mpWorldBody(mpWorld->Create(mpWorldTree.Get(),
                 physics::Body3D::kStatic, physics::Body3D::kDynamic)),
+            mDebugPack(graphics::RenderPack::Create()),
             mbTreeDirty(false),
             mbDebugPhysics(false)
         {}
@@ -80,30 +85,40 @@ namespace jz
         {
             if (mbDebugPhysics)
             {
-                RenderMan& rm = RenderMan::GetSingleton();
+                RenderMan::GetSingleton().Pose(mDebugPack);
+            }
+        }
+
+        void PhysicsNode::SetDebugPhysics(bool b)
+        {
+            JZ_ASSERT(system::Jobs::GetCurrentWorkerIndex() <= 0);
+
+            mbDebugPhysics = b;
+            mDebugPack = graphics::RenderPack::Create();
 
-                graphics::RenderPack pack(graphics::RenderPack::Create());
-                pack.DrawFunc = DrawPhysicsNode;
-                pack.DrawFuncParam = this;
-                pack.pEffect = rm.GetSimpleEffect();
-                pack.EffectTechnique = rm.GetSimpleEffect()->GetRenderTechnique();
-                pack.pVertexDeclaration = rm.GetUnitBoxMesh()->GetVertexDeclaration();
-                pack.Sort = 0.0f;
+            if (mbDebugPhysics)
+            {
+                RenderMan& rm = RenderMan::GetSingleton();
 
-                RenderMan::GetSingleton().Pose(pack);
+                mDebugPack.DrawFunc = DrawPhysicsNode;
+                mDebugPack.DrawFuncParam = this;
+                mDebugPack.pEffect = rm.GetSimpleEffect();
+                mDebugPack.EffectTechnique = rm.GetSimpleEffect()->GetRenderTechnique();
+                mDebugPack.pVertexDeclaration = rm.GetUnitBoxMesh()->GetVertexDeclaration();
+                mDebugPack.Sort = 0.0f;
             }
         }
 
-        SceneNode* PhysicsNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        SceneNode* PhysicsNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
-            throw std::exception(__FUNCTION__ ": cannot clone PhysicsNode.");
+            throw JZ_EXCEPTION("cannot clone PhysicsNode.");
         }
 
         void PhysicsNode::_PostUpdate(bool abChanged)
         {
             if (abChanged || mbTreeDirty)
             {
-                mWorldAABB = BoundingBox::Transform(mWorld, mpWorldTree->GetBounding());
+                mWorldAABB = BoundingBox::Transform(_World(), mpWorldTree->GetBounding());
                 mWorldBounding = BoundingSphere::CreateFrom(mWorldAABB);
                 mbValidBounding = true;
 
@@ -113,8 +128,7 @@ namespace jz
 
         void PhysicsNode::_PreUpdateB(const Matrix4& aParentWorld, bool abParentChanged)
         {
-            float tick = system::Time::GetSingleton().GetElapsedSeconds();
-            mpWorld->Tick(tick);
+            mpWorld->Tick(system::Time::GetSingleton().GetElapsedNanoseconds());
 
             SceneNode::_PreUpdateB(aParentWorld, abParentChanged);
         }
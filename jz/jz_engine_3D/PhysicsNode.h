@@ -26,6 +26,7 @@
 
 #include <jz_engine_3D/IRenderable.h>
 #include <jz_engine_3D/SceneNode.h>
+#include <jz_graphics/RenderPack.h>
 #include <jz_physics/World.h>
 #include <jz_system/TriangleTree.h>
 
@@ -42,9 +43,11 @@ namespace jz
 
         class PhysicsNode : public SceneNode, public IRenderable
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             PhysicsNode();
-            PhysicsNode(const string& aBaseId, const string& aId);
+            PhysicsNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~PhysicsNode();
 
             virtual const BoundingBox& GetBoundingBox() const override { return mWorldAABB; }
@@ -60,18 +63,22 @@ namespace jz
                 return (mpWorldTree.Get());
             }
 
-            void SetDebugPhysics(bool b) { mbDebugPhysics = b; }
+            // Must be called from the main thread.
+            void SetDebugPhysics(bool b);
 
         protected:
             virtual void _PostUpdate(bool abChanged) override;
             virtual void _PreUpdateB(const Matrix4& aParentWorld, bool abParentChanged) override;
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId) override;
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId) override;
 
         private:
             physics::World3D* mpWorld;
             physics::TriangleTreeShapePtr mpWorldTree;
             physics::Body3DPtr mpWorldBody;
             
+            // Built when debug drawing is enabled, so posing on a worker does not copy
+            // the shared effect and mesh references.
+            graphics::RenderPack mDebugPack;
             bool mbTreeDirty;
             bool mbDebugPhysics;
 
@@ -25,22 +25,24 @@
 #include <jz_graphics/Graphics.h>
 #include <jz_graphics/RenderOps.h>
 #include <jz_graphics/SystemMemorySurface.h>
-#include <jz_graphics_directx9/DirectX9.h>
 #include <jz_engine_3D/PickMan.h>
 #include <jz_engine_3D/RenderMan.h>
 #include <jz_engine_3D/StandardEffect.h>
+#include <jz_system/Jobs.h>
 
 namespace jz
 {
-    engine_3D::PickMan* engine_3D::PickMan::mspSingleton = null;
+    template <> engine_3D::PickMan* Singleton<engine_3D::PickMan>::mspSingleton = null;
     namespace engine_3D
     {
 
         static const ColorRGBAu kDefaultPickColor = { 255, 0, 0, 255 };
 
         PickMan::PickMan()
-            : mPickColor(kDefaultPickColor)
+            : mPickColorObject(null)
         { 
+            mPickColor = kDefaultPickColor;
+
             graphics::Graphics& graphics = graphics::Graphics::GetSingleton();
             mpPickSurface = graphics.Create<graphics::SystemMemorySurface>(0, 0, graphics::SystemMemorySurface::kX8R8G8B8);
         }
@@ -124,6 +126,9 @@ namespace jz
         {
             using namespace graphics;
 
+            // Unlike RenderMan, picks are posed and rendered immediately, from the main thread.
+            JZ_ASSERT(system::Jobs::GetCurrentWorkerIndex() <= 0);
+
             mPickColor.A = 255;
             mPickColor.R = 255;
             mPickColor.G = (mPickColor.G == 255) ? 0 : ((mPickColor.B == 255) ? (mPickColor.G + 1) : mPickColor.G);
@@ -132,16 +137,20 @@ namespace jz
             mPickTable.insert(make_pair(mPickColor, apPickable));
 
             float sort = SortForOpaque(r.Sort);
-            RenderNode* node = &mRenderPick;
-            if (r.PreEffectFunc) { node = node->AdoptAndUpdateSort(r.PreEffectFunc, r.PreEffectFuncParam, sort); }
-            if (r.pEffect.IsValid()) { node = node->AdoptAndUpdateSort(RenderOperations::SetEffect, r.pEffect.Get(), sort); }
-            if (r.PostEffectFunc) { node = node->AdoptAndUpdateSort(r.PostEffectFunc, r.PostEffectFuncParam, sort); }
-            if (r.EffectTechnique.IsValid()) { node = node->AdoptAndUpdateSort(RenderOperations::SetEffectTechnique, graphics::Technique::ToVoidP(r.EffectTechnique), sort); }
-            if (r.pVertexDeclaration.IsValid()) { node = node->AdoptAndUpdateSort(RenderOperations::SetVertexDeclaration, r.pVertexDeclaration.Get(), sort); }
-            if (r.pMaterial.IsValid()) { node = node->AdoptAndUpdateSort(RenderOperations::SetMaterial, r.pMaterial.Get(), sort); }
-            if (r.pMesh.IsValid()) { node = node->AdoptAndUpdateSort(RenderOperations::SetMesh, r.pMesh.Get(), sort); }
-            node = node->AdoptAndUpdateSort(SetPickColor, mPickColorObject, sort);
-            if (r.DrawFunc) { node = node->AdoptAndUpdateSort(r.DrawFunc, r.DrawFuncParam, sort); }
+            RenderCommand commands[RenderQueue::kMaxCommands];
+            size_t states[RenderQueue::kStateCount];
+            size_t count = RenderQueue::BuildStateCommands(r, r.EffectTechnique, false, commands, states);
+            commands[count].Op = SetPickColor;
+            commands[count].pInstance = mPickColorObject;
+            count++;
+            if (r.DrawFunc)
+            {
+                commands[count].Op = r.DrawFunc;
+                commands[count].pInstance = r.DrawFuncParam;
+                count++;
+            }
+
+            mPickQueue.Add(0u, false, sort, states, commands, count);
         }
 
         bool PickMan::Pick(const RectangleU& aRectangle, IPickable*& arpPickable, float& arDepth)
@@ -157,8 +166,8 @@ namespace jz
                 if (graphics.Begin(ColorRGBA::kBlack, true))
                 {
                     rm.SetStandardParameters();
-                    mRenderPick.RenderChildren();
-                    mRenderPick.Reset();
+                    mPickQueue.Render(0u);
+                    mPickQueue.Reset();
                     mPickColor = kDefaultPickColor;
 
                     mpPickSurface->PopulateFromBackbuffer();
@@ -29,8 +29,8 @@
 #include <jz_core/Rectangle.h>
 #include <jz_core/Utility.h>
 #include <jz_core/Vector3.h>
-#include <jz_graphics/RenderNode.h>
 #include <jz_graphics/RenderPack.h>
+#include <jz_graphics/RenderQueue.h>
 #include <map>
 
 namespace jz
@@ -65,9 +65,11 @@ namespace jz
             PickMan& operator=(const PickMan&);
 
             graphics::SystemMemorySurfacePtr mpPickSurface;
-            graphics::RenderNode mRenderPick;
+            graphics::RenderQueue mPickQueue;
 
-            JZ_STATIC_ASSERT(sizeof(ColorRGBAu) == sizeof(voidc_p));
+            // The color is passed through the void pointer of the draw command. The bytes
+            // past the color are zero when pointers are 64-bit.
+            JZ_STATIC_ASSERT(sizeof(ColorRGBAu) <= sizeof(voidc_p));
             union
             {
                 ColorRGBAu mPickColor;
@@ -28,7 +28,7 @@
 
 namespace jz
 {
-    engine_3D::ReflectionMan* engine_3D::ReflectionMan::mspSingleton = null;
+    template <> engine_3D::ReflectionMan* Singleton<engine_3D::ReflectionMan>::mspSingleton = null;
     namespace engine_3D
     {
 
@@ -35,6 +35,8 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(ReflectivePlaneNode, SceneNode);
+
         static void DrawMesh(graphics::RenderNode* apNode, voidc_p apInstance)
         {
             ReflectionMan& rm = ReflectionMan::GetSingleton();
@@ -60,7 +62,7 @@ namespace jz
             mHandle = ReflectionMan::GetSingleton().Grab();
         }
 
-        ReflectivePlaneNode::ReflectivePlaneNode(const string& aBaseId, const string& aId)
+        ReflectivePlaneNode::ReflectivePlaneNode(const system::StringId& aBaseId, const system::StringId& aId)
             : SceneNode(aBaseId, aId), mbNonDeferred(false), mPack(graphics::RenderPack::Create()), 
             mbVisible(true), mHandle(-1), mPlane(Vector3::kForward, 0.0f)
         {
@@ -103,13 +105,12 @@ namespace jz
             {
                 RenderMan& rm = RenderMan::GetSingleton();
                 
-                graphics::RenderPack pack = mPack;
-                pack.DrawFunc = DrawMesh;
-                pack.DrawFuncParam = this;
-                pack.EffectTechnique = (mbNonDeferred) ? static_cast<StandardEffect*>(pack.pEffect.Get())->GetNonDeferredTechnique() : static_cast<StandardEffect*>(pack.pEffect.Get())->GetRenderTechnique();
-                pack.Sort = (pack.pMesh.IsValid()) ? Vector3::TransformPosition(mWorld * rm.GetView(), pack.pMesh->GetAABB().Center()).Z : 0.0f;
+                StandardEffect* pEffect = static_cast<StandardEffect*>(mPack.pEffect.Get());
+                graphics::Technique technique = (mbNonDeferred) ? pEffect->GetNonDeferredTechnique() : pEffect->GetRenderTechnique();
+                float sort = (mPack.pMesh.IsValid()) ? Vector3::TransformPosition(_World() * rm.GetView(), mPack.pMesh->GetAABB().Center()).Z : 0.0f;
 
-                rm.Pose(pack);
+                // mPack is not copied, posing can run on job workers.
+                rm.Pose(mPack, DrawMesh, this, technique, sort);
             }
         }
 
@@ -149,7 +150,7 @@ namespace jz
             p->mPack = mPack;
         }
 
-        SceneNode* ReflectivePlaneNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        SceneNode* ReflectivePlaneNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
             return new ReflectivePlaneNode(aBaseId, aCloneId);
         }
@@ -160,8 +161,8 @@ namespace jz
             {
                 if (mPack.pMesh.IsValid())
                 {
-                    mWorldAABB = BoundingBox::Transform(mWorld, mPack.pMesh->GetAABB());
-                    mWorldBounding = BoundingSphere::Transform(mWorld, mPack.pMesh->GetBoundingSphere());
+                    mWorldAABB = BoundingBox::Transform(_World(), mPack.pMesh->GetAABB());
+                    mWorldBounding = BoundingSphere::Transform(_World(), mPack.pMesh->GetBoundingSphere());
                     mbValidBounding = true;
                 }
             }
@@ -24,6 +24,8 @@
 #ifndef _JZ_ENGINE_3D_REFLECTIVE_PLANE_NODE_H_
 #define _JZ_ENGINE_3D_REFLECTIVE_PLANE_NODE_H_
 
+#include <jz_graphics/Material.h>
+#include <jz_graphics/Mesh.h>
 #include <jz_graphics/Parameter.h>
 #include <jz_graphics/RenderPack.h>
 #include <jz_engine_3D/IPickable.h>
@@ -46,9 +48,11 @@ namespace jz
         class StandardEffect; typedef AutoPtr<StandardEffect> StandardEffectPtr;
         class ReflectivePlaneNode : public SceneNode, public IRenderable
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             ReflectivePlaneNode();
-            ReflectivePlaneNode(const string& aBaseId, const string& aId);
+            ReflectivePlaneNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~ReflectivePlaneNode();
 
             bool bVisible() const { return mbVisible; }
@@ -80,7 +84,7 @@ namespace jz
         protected:
             virtual void _PopulateClone(SceneNode* apNode) override;
             virtual void _PostUpdate(bool abChanged)  override;
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId) override;
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId) override;
 
             bool mbVisible;
             bool mbNonDeferred;
@@ -30,6 +30,7 @@
 #include <jz_engine_3D/SimpleEffect.h>
 #include <jz_engine_3D/StandardEffect.h>
 #include <jz_system/Files.h>
+#include <jz_system/Jobs.h>
 #include <jz_system/Time.h>
 #include <jz_graphics/Graphics.h>
 #include <jz_graphics/Material.h>
@@ -43,10 +44,11 @@
 
 namespace jz
 {
-    engine_3D::RenderMan* engine_3D::RenderMan::mspSingleton = null;
+    template <> engine_3D::RenderMan* Singleton<engine_3D::RenderMan>::mspSingleton = null;
     namespace engine_3D
     {
         static float kGamma = 2.2f;
+        static const u32 kNoInstanceBatch = 0xFFFFFFFFu;
 
         static const char* kSimpleEffect = "SimpleEffect.cfx";
         static const char* kUnitBox = "built-in_unit-box.mesh";
@@ -106,7 +108,7 @@ namespace jz
 #           define JZ_HELPER(n) if (!n->IsLoadable()) \
             { \
                 SafeDelete(mpInstanceBuffer); \
-                throw exception(__FUNCTION__ ": " #n " is not loadable."); \
+                throw JZ_EXCEPTION(#n " is not loadable."); \
             }
 
             JZ_HELPER(mpSimpleEffect);
@@ -123,10 +125,18 @@ namespace jz
             mpShadowMan = new ShadowMan();
 
             mpInstanceBuffer->push_back(graphics::BufferEntry(kMaxEntries, kMaxEntries));
+
+            _SizeWorkerQueues();
         }
 
         RenderMan::~RenderMan()
         {
+            for (size_t i = 0u; i < mWorkerQueues.size(); i++)
+            {
+                SafeDelete(mWorkerQueues[i]);
+            }
+            mWorkerQueues.clear();
+
             SafeDelete(mpShadowMan);
             SafeDelete(mpReflectionMan);
             SafeDelete(mpDeferred);
@@ -152,63 +162,87 @@ namespace jz
         __inline float SortForOpaque(float v) { return -v; }
         __inline float SortForTransparent(float v) { return v; }
 
-        graphics::RenderNode* RenderMan::_GetNode(const graphics::RenderPack& r)
+        u32 RenderMan::_GetPass(const graphics::RenderPack& r)
         {
             using namespace graphics;
             if ((r.Flags & RenderPack::kTransparent) != 0)
             {
-                if ((r.Flags & RenderPack::kReflection) != 0) { return (&mRenderReflectionTransparent); }
-                else if ((r.Flags & RenderPack::kGUI) != 0) { return (&mRenderGuiTransparent); }
-                else if ((r.Flags & RenderPack::kShadow) != 0) { return (&mRenderShadow); }
-                else { return (&mRenderTransparent); }
+                if ((r.Flags & RenderPack::kReflection) != 0) { return kPassReflectionTransparent; }
+                else if ((r.Flags & RenderPack::kGUI) != 0) { return kPassGuiTransparent; }
+                else if ((r.Flags & RenderPack::kShadow) != 0) { return kPassShadow; }
+                else { return kPassTransparent; }
             }
             else
             {
-                if ((r.Flags & RenderPack::kReflection) != 0) { return (&mRenderReflectionOpaque); }
-                else if ((r.Flags & RenderPack::kGUI) != 0) { return (&mRenderGuiOpaque); }
-                else if ((r.Flags & RenderPack::kShadow) != 0) { return (&mRenderShadow); }
-                else { return (&mRenderOpaque); }
+                if ((r.Flags & RenderPack::kReflection) != 0) { return kPassReflectionOpaque; }
+                else if ((r.Flags & RenderPack::kGUI) != 0) { return kPassGuiOpaque; }
+                else if ((r.Flags & RenderPack::kShadow) != 0) { return kPassShadow; }
+                else { return kPassOpaque; }
             }
 
-            return (&mRenderOpaque);
+            return kPassOpaque;
         }
 
         void RenderMan::Pose(const graphics::RenderPack& r)
+        {
+            Pose(r, r.DrawFunc, r.DrawFuncParam, r.EffectTechnique, r.Sort);
+        }
+
+        void RenderMan::Pose(const graphics::RenderPack& r, graphics::DrawOp aDrawFunc, voidc_p aDrawFuncParam, graphics::Technique aTechnique, float aSort)
         {
             using namespace graphics;
-            float sort = ((r.Flags & RenderPack::kTransparent) != 0) ? SortForTransparent(r.Sort) : SortForOpaque(r.Sort);
-            if ((r.Flags & RenderPack::kTransparent) != 0 && (r.Flags & RenderPack::kNoStrictSort) == 0)
+            bool bTransparent = ((r.Flags & RenderPack::kTransparent) != 0);
+            bool bDepthFirst = (bTransparent && (r.Flags & RenderPack::kNoStrictSort) == 0);
+            bool bInstanced = (r.InstancingPrepareFunc && r.InstancingDrawFunc);
+            float sort = (bTransparent) ? SortForTransparent(aSort) : SortForOpaque(aSort);
+
+            RenderCommand commands[RenderQueue::kMaxCommands];
+            size_t states[RenderQueue::kStateCount];
+            size_t count = RenderQueue::BuildStateCommands(r, aTechnique, true, commands, states);
+            if (aDrawFunc)
             {
-                RenderNode* node = _GetNode(r);
-                if (r.PreEffectFunc) { node = node->AdoptSorted(r.PreEffectFunc, r.PreEffectFuncParam, sort); }
-                if (r.pEffect.IsValid()) { node = node->AdoptSorted(RenderOperations::SetEffect, r.pEffect.Get(), sort); }
-                if (r.PostEffectFunc) { node = node->AdoptSorted(r.PostEffectFunc, r.PostEffectFuncParam, sort); }
-                if (r.EffectTechnique.IsValid()) { node = node->AdoptSorted(RenderOperations::SetEffectTechnique, graphics::Technique::ToVoidP(r.EffectTechnique), sort); }
-                if (r.pVertexDeclaration.IsValid() && r.pVertexDeclaration->IsReset()) { node = node->AdoptSorted(RenderOperations::SetVertexDeclaration, r.pVertexDeclaration.Get(), sort); }
-                if (r.pMaterial.IsValid() && r.pMaterial->IsReset()) { node = node->AdoptSorted(RenderOperations::SetMaterial, r.pMaterial.Get(), sort); }
-                if (r.pMesh.IsValid() && r.pMesh->IsReset()) { node = node->AdoptSorted(RenderOperations::SetMesh, r.pMesh.Get(), sort); }
-                if (r.DrawFunc) { node = node->AdoptAndUpdateSort(r.DrawFunc, r.DrawFuncParam, sort); }
-                if (r.InstancingPrepareFunc && r.InstancingDrawFunc)
-                {
-                    _InsertInstancingOp(node, r.InstancingPrepareFunc, r.InstancingPrepareParam, r.InstancingDrawFunc, &RenderNode::AdoptAndUpdateSort, sort);
-                }
+                commands[count].Op = aDrawFunc;
+                commands[count].pInstance = aDrawFuncParam;
+                count++;
             }
-            else 
+
+            u32 pass = _GetPass(r);
+            s32 worker = system::Jobs::GetCurrentWorkerIndex();
+
+            if (worker > 0)
             {
-                RenderNode* node = _GetNode(r);
-                if (r.PreEffectFunc) { node = node->AdoptAndUpdateSort(r.PreEffectFunc, r.PreEffectFuncParam, sort); }
-                if (r.pEffect.IsValid()) { node = node->AdoptAndUpdateSort(RenderOperations::SetEffect, r.pEffect.Get(), sort); }
-                if (r.PostEffectFunc) { node = node->AdoptAndUpdateSort(r.PostEffectFunc, r.PostEffectFuncParam, sort); }
-                if (r.EffectTechnique.IsValid()) { node = node->AdoptAndUpdateSort(RenderOperations::SetEffectTechnique, graphics::Technique::ToVoidP(r.EffectTechnique), sort); }
-                if (r.pVertexDeclaration.IsValid() && r.pVertexDeclaration->IsReset()) { node = node->AdoptAndUpdateSort(RenderOperations::SetVertexDeclaration, r.pVertexDeclaration.Get(), sort); }
-                if (r.pMaterial.IsValid() && r.pMaterial->IsReset()) { node = node->AdoptAndUpdateSort(RenderOperations::SetMaterial, r.pMaterial.Get(), sort); }
-                if (r.pMesh.IsValid() && r.pMesh->IsReset()) { node = node->AdoptAndUpdateSort(RenderOperations::SetMesh, r.pMesh.Get(), sort); }
-                if (r.DrawFunc) { node = node->AdoptAndUpdateSort(r.DrawFunc, r.DrawFuncParam, sort); }
-                if (r.InstancingPrepareFunc && r.InstancingDrawFunc)
+                // Only possible if Jobs was created after the frame started.
+                JZ_E_ON_FAIL((size_t)worker < mWorkerQueues.size(), "no render queue for the current worker.");
+                WorkerQueue& q = *(mWorkerQueues[worker]);
+
+                if (bInstanced)
+                {
+                    PendingInstance p;
+                    p.Pass = pass;
+                    p.bDepthFirst = bDepthFirst;
+                    p.Sort = sort;
+                    for (size_t i = 0u; i < RenderQueue::kStateCount; i++) { p.States[i] = states[i]; }
+                    for (size_t i = 0u; i < count; i++) { p.Commands[i] = commands[i]; }
+                    p.Count = count;
+                    p.PrepareFunc = r.InstancingPrepareFunc;
+                    p.PrepareParam = r.InstancingPrepareParam;
+                    p.DrawFunc = r.InstancingDrawFunc;
+
+                    q.Instances.push_back(p);
+                }
+                else if (count > 0u)
                 {
-                    _InsertInstancingOp(node, r.InstancingPrepareFunc, r.InstancingPrepareParam, r.InstancingDrawFunc, &RenderNode::AdoptAndUpdateSort, sort);
+                    q.Queue.Add(pass, bDepthFirst, sort, states, commands, count);
                 }
             }
+            else if (bInstanced)
+            {
+                _InsertInstancingOp(pass, bDepthFirst, sort, states, commands, count, r.InstancingPrepareFunc, r.InstancingPrepareParam, r.InstancingDrawFunc);
+            }
+            else if (count > 0u)
+            {
+                mQueue.Add(pass, bDepthFirst, sort, states, commands, count);
+            }
         }
 
         void RenderMan::ClearWithoutRender()
@@ -217,7 +251,7 @@ namespace jz
             mConsoleText.clear();
             // End Temp:
 
-            _ResetTrees();
+            _ResetQueue();
             _ClearInstanceBuffers();
             mpDeferred->ClearLights();
         }
@@ -227,13 +261,15 @@ namespace jz
             using namespace graphics;
             Graphics& graphics = Graphics::GetSingleton();
 
+            _MergeWorkerQueues();
+
             if (graphics.Begin(mClearColor, !mpDeferred->bActive()))
             {
                 if (mpDeferred->bActive())
                 {
                     graphics.BeginGraphicsEventMark("Shadow map generation.");
                     mpShadowMan->Pre();
-                    mRenderShadow.RenderChildren();
+                    mQueue.Render(kPassShadow);
                     mpShadowMan->Post();
                     graphics.EndGraphicsEventMark();
 
@@ -241,10 +277,10 @@ namespace jz
                     SetStandardParameters();
                     mpReflectionMan->Pre();
                     graphics.BeginGraphicsEventMark("Opaque.");
-                    mRenderReflectionOpaque.RenderChildren();
+                    mQueue.Render(kPassReflectionOpaque);
                     graphics.EndGraphicsEventMark();
                     graphics.BeginGraphicsEventMark("Transparent.");
-                    mRenderReflectionTransparent.RenderChildren();
+                    mQueue.Render(kPassReflectionTransparent);
                     graphics.EndGraphicsEventMark();
                     mpReflectionMan->Post();
                     graphics.EndGraphicsEventMark();
@@ -258,32 +294,23 @@ namespace jz
                     SetStandardParameters();
                 }
 
-#if !NDEBUG
-                static bool msbDebugSaved = false;
-                if (!msbDebugSaved)
-                {
-                    mRenderOpaque.SaveDigraph("render_opaque.dot");
-                    msbDebugSaved = true;
-                }
-#endif
-
                 graphics.BeginGraphicsEventMark("Opaque.");
-                mRenderOpaque.RenderChildren();
+                mQueue.Render(kPassOpaque);
                 graphics.EndGraphicsEventMark();
 
                 graphics.BeginGraphicsEventMark("Transparent.");
                 if (mpDeferred->bActive()) { mpDeferred->PreTransparency(); }
-                mRenderTransparent.RenderChildren();
+                mQueue.Render(kPassTransparent);
                 graphics.EndGraphicsEventMark();
                 if (mpDeferred->bActive()) { mpDeferred->End(); }
                 graphics.EndGraphicsEventMark();
 
-                if (mRenderGuiOpaque.GetHead() || mRenderGuiTransparent.GetHead())
+                if (!mQueue.bEmpty(kPassGuiOpaque) || !mQueue.bEmpty(kPassGuiTransparent))
                 {
                     graphics.Clear(Graphics::kDepth | Graphics::kStencil);
 
-                    mRenderGuiOpaque.RenderChildren();
-                    mRenderGuiTransparent.RenderChildren();
+                    mQueue.Render(kPassGuiOpaque);
+                    mQueue.Render(kPassGuiTransparent);
                 }
 
                 // Temp:
@@ -306,16 +333,49 @@ namespace jz
             ClearWithoutRender();
         }
 
-        void RenderMan::_ResetTrees()
+        void RenderMan::_MergeWorkerQueues()
+        {
+            for (size_t i = 1u; i < mWorkerQueues.size(); i++)
+            {
+                WorkerQueue& q = *(mWorkerQueues[i]);
+                mQueue.Append(q.Queue);
+                q.Queue.Reset();
+
+                const size_t kInstances = q.Instances.size();
+                for (size_t j = 0u; j < kInstances; j++)
+                {
+                    PendingInstance& p = q.Instances[j];
+                    _InsertInstancingOp(p.Pass, p.bDepthFirst, p.Sort, p.States, p.Commands, p.Count, p.PrepareFunc, p.PrepareParam, p.DrawFunc);
+                }
+                q.Instances.clear();
+            }
+        }
+
+        void RenderMan::_ResetQueue()
         {
-            mRenderOpaque.Reset();
-            mRenderReflectionOpaque.Reset();
-            mRenderReflectionTransparent.Reset();
-            mRenderShadow.Reset();
-            mRenderTransparent.Reset();
-            mRenderGuiOpaque.Reset();
-            mRenderGuiTransparent.Reset();
-            graphics::RenderNode::ResetGlobal();
+            mQueue.Reset();
+
+            for (size_t i = 1u; i < mWorkerQueues.size(); i++)
+            {
+                mWorkerQueues[i]->Queue.Reset();
+                mWorkerQueues[i]->Instances.clear();
+            }
+
+            // The next frame starts here, pick up a Jobs created since the last one.
+            _SizeWorkerQueues();
+        }
+
+        void RenderMan::_SizeWorkerQueues()
+        {
+            if (!system::Jobs::GetSingletonExists()) { return; }
+
+            const size_t kSize = (system::Jobs::GetSingleton().GetWorkerCount() + 1u);
+
+            if (mWorkerQueues.empty()) { mWorkerQueues.push_back(null); }
+            while (mWorkerQueues.size() < kSize)
+            {
+                mWorkerQueues.push_back(new WorkerQueue());
+            }
         }
 
         void RenderMan::_ClearInstanceBuffers()
@@ -326,34 +386,55 @@ namespace jz
             {
                 (*mpInstanceBuffer)[i].CurrentOffset = kMaxEntries;
             }
+
+            mInstanceBatchHeads.clear();
+            mInstanceBatches.clear();
         }
 
-        void RenderMan::_InsertInstancingOp(graphics::RenderNode* p, graphics::InstancingOp iOp, voidc_p apInstanceOpParam, graphics::DrawOp dOp, graphics::AdoptOp aOp, float aSortOrder)
+        void RenderMan::_InsertInstancingOp(u32 aPass, bool abDepthFirst, float aSortOrder, const size_t* apStates, graphics::RenderCommand* apCommands, size_t aCount, graphics::InstancingOp iOp, voidc_p apInstanceOpParam, graphics::DrawOp dOp)
         {
             using namespace graphics;
-            #pragma region If a child with space exists, add this instance to that child
-            RenderNode* node = p->GetHead();
-            bool bIncrement = false;
-            while (node)
+
+            // Batches are found by a hash of everything that precedes the instancing op. Strictly
+            // sorted batches only merge instances at the same depth, as they did in the tree.
+            size_t hash = RenderQueue::Combine(aPass, (abDepthFirst) ? 1u : 0u);
+            for (size_t i = 0u; i < aCount; i++)
             {
-                u32 index = reinterpret_cast<u32>(node->GetInstance());
-                BufferEntry& buffer = (*mpInstanceBuffer)[index];
+                hash = RenderQueue::Combine(hash, reinterpret_cast<size_t>(apCommands[i].Op));
+                hash = RenderQueue::Combine(hash, reinterpret_cast<size_t>(apCommands[i].pInstance));
+            }
+            if (abDepthFirst)
+            {
+                u32 depth;
+                memcpy(&depth, &aSortOrder, sizeof(u32));
+                hash = RenderQueue::Combine(hash, depth);
+            }
 
-                if (buffer.CurrentOffset > 0u)
+            InstanceBatchHeads::iterator I = mInstanceBatchHeads.find(hash);
+            u32 head = (I != mInstanceBatchHeads.end()) ? I->second : kNoInstanceBatch;
+
+            #pragma region If a batch with space exists, add this instance to that batch
+            for (u32 i = head; i != kNoInstanceBatch; i = mInstanceBatches[i].Next)
+            {
+                const InstanceBatch& batch = mInstanceBatches[i];
+                BufferEntry& buffer = (*mpInstanceBuffer)[batch.Buffer];
+
+                if (buffer.CurrentOffset > 0u &&
+                    mQueue.bPrefix(batch.Entry, apCommands, aCount) &&
+                    (!abDepthFirst || mQueue.GetDepth(batch.Entry) == aSortOrder))
                 {
                     if (iOp(buffer, apInstanceOpParam))
                     {
-                        // reinserting to update z-sorting order.
-                        (p->*aOp)(dOp, reinterpret_cast<voidc_p>(index), aSortOrder);
+                        // updating z-sorting order.
+                        mQueue.LowerDepth(batch.Entry, aSortOrder);
                         return;
                     }
                 }
-                node = node->GetNext();
             }
             #pragma endregion
 
             #pragma region else
-            // Either there is no existing draw op, or all the existing instancing buffers are
+            // Either there is no existing batch, or all the existing instancing buffers are
             // full. We need to insert a new draw op.
             {
                 if ((*mpInstanceBuffer)[mCurrentBuffer].CurrentOffset < kMaxEntries) { mCurrentBuffer++; }
@@ -364,7 +445,17 @@ namespace jz
                 }
 
                 iOp((*mpInstanceBuffer)[mCurrentBuffer], apInstanceOpParam);
-                (p->*aOp)(dOp, reinterpret_cast<voidc_p>(mCurrentBuffer), aSortOrder);
+
+                apCommands[aCount].Op = dOp;
+                apCommands[aCount].pInstance = reinterpret_cast<voidc_p>(mCurrentBuffer);
+
+                InstanceBatch batch;
+                batch.Entry = mQueue.Add(aPass, abDepthFirst, aSortOrder, apStates, apCommands, (aCount + 1u));
+                batch.Buffer = mCurrentBuffer;
+                batch.Next = head;
+
+                mInstanceBatchHeads[hash] = (u32)mInstanceBatches.size();
+                mInstanceBatches.push_back(batch);
             }
             #pragma endregion
         }
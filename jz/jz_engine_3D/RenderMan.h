@@ -30,8 +30,9 @@
 #include <jz_core/Matrix4.h>
 #include <jz_core/Memory.h>
 #include <jz_core/Utility.h>
-#include <jz_graphics/RenderNode.h>
 #include <jz_graphics/RenderPack.h>
+#include <jz_graphics/RenderQueue.h>
+#include <map>
 #include <vector>
 
 namespace jz
@@ -64,7 +65,13 @@ namespace jz
             ~RenderMan();
 
             JZ_EXPORT void ClearWithoutRender();
+            // Pose() may be called from job workers while posing. Each worker records into its own
+            // queue and the queues are merged, on the thread calling Render(), before the one sort.
             JZ_EXPORT void Pose(const graphics::RenderPack& r);
+
+            // Poses r with its draw function, technique, and sort replaced. Used in place of
+            // copying r, which would modify the (non-atomic) reference counts of its resources.
+            JZ_EXPORT void Pose(const graphics::RenderPack& r, graphics::DrawOp aDrawFunc, voidc_p aDrawFuncParam, graphics::Technique aTechnique, float aSort);
             JZ_EXPORT void Render();
 
             const vector<graphics::BufferEntry>& GetInstanceBuffers() const { return (*mpInstanceBuffer); }
@@ -145,22 +152,67 @@ namespace jz
             RenderMan(const RenderMan&);
             RenderMan& operator=(const RenderMan&);
 
-            graphics::RenderNode mRenderOpaque;
-            graphics::RenderNode mRenderTransparent;
-            graphics::RenderNode mRenderGuiOpaque;
-            graphics::RenderNode mRenderGuiTransparent;
-            graphics::RenderNode mRenderReflectionOpaque;
-            graphics::RenderNode mRenderReflectionTransparent;
-            graphics::RenderNode mRenderShadow;
+            // Passes in render order.
+            enum Pass
+            {
+                kPassShadow,
+                kPassReflectionOpaque,
+                kPassReflectionTransparent,
+                kPassOpaque,
+                kPassTransparent,
+                kPassGuiOpaque,
+                kPassGuiTransparent
+            };
+
+            graphics::RenderQueue mQueue;
+
+            u32 _GetPass(const graphics::RenderPack& r);
+            void _MergeWorkerQueues();
+            void _ResetQueue();
+            void _SizeWorkerQueues();
+
+            // Instanced packs touch the shared instance buffers, so those posed on a worker are
+            // inserted when its queue is merged.
+            struct PendingInstance
+            {
+                u32 Pass;
+                bool bDepthFirst;
+                float Sort;
+                size_t States[graphics::RenderQueue::kStateCount];
+                graphics::RenderCommand Commands[graphics::RenderQueue::kMaxCommands];
+                size_t Count;
+                graphics::InstancingOp PrepareFunc;
+                voidc_p PrepareParam;
+                graphics::DrawOp DrawFunc;
+            };
+
+            struct WorkerQueue
+            {
+                graphics::RenderQueue Queue;
+                vector<PendingInstance> Instances;
+            };
+
+            // Indexed by Jobs::GetCurrentWorkerIndex(), entry 0 (the main thread) is null and
+            // poses directly into mQueue. Sized from the Jobs worker count on construction
+            // and at the start of every frame, never while workers may be posing.
+            vector<WorkerQueue*> mWorkerQueues;
+
+            struct InstanceBatch
+            {
+                size_t Entry;
+                u32 Buffer;
+                u32 Next;
+            };
 
-            graphics::RenderNode* _GetNode(const graphics::RenderPack& r);
-            void _ResetTrees();
+            typedef map<size_t, u32> InstanceBatchHeads;
+            InstanceBatchHeads mInstanceBatchHeads;
+            vector<InstanceBatch> mInstanceBatches;
 
             u32 mCurrentBuffer;
             vector<graphics::BufferEntry>* mpInstanceBuffer;
 
             void _ClearInstanceBuffers();
-            void _InsertInstancingOp(graphics::RenderNode* p, graphics::InstancingOp iOp, voidc_p apInstanceOpParam, graphics::DrawOp dOp, graphics::AdoptOp aOp, float aSortOrder);
+            void _InsertInstancingOp(u32 aPass, bool abDepthFirst, float aSortOrder, const size_t* apStates, graphics::RenderCommand* apCommands, size_t aCount, graphics::InstancingOp iOp, voidc_p apInstanceOpParam, graphics::DrawOp dOp);
         };
 
     }
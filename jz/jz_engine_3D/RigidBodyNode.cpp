@@ -32,11 +32,13 @@ namespace jz
     namespace engine_3D
     {
 
+        JZ_SCENE_NODE_CLASS_IMPL(RigidBodyNode, MeshNode);
+
         RigidBodyNode::RigidBodyNode()
             : MeshNode()
         {}
 
-        RigidBodyNode::RigidBodyNode(const string& aBaseId, const string& aId)
+        RigidBodyNode::RigidBodyNode(const system::StringId& aBaseId, const system::StringId& aId)
             : MeshNode(aBaseId, aId)
         {}
 
@@ -59,7 +61,7 @@ namespace jz
                 mpPhysicsBody = pWorld->Create(new physics::BoxShape(aHalfExtents), physics::Body3D::kDynamic, physics::Body3D::kDynamic | physics::Body3D::kStatic);
                 mpPhysicsBody->SetMass(aMass);
                 mpPhysicsBody->SetFriction(aFriction);
-                mpPhysicsBody->SetFrame(CoordinateFrame3D::CreateFromMatrix4(mWorld));
+                mpPhysicsBody->SetFrame(CoordinateFrame3D::CreateFromMatrix4(_World()));
                 mpPhysicsBody->OnUpdate.Add<RigidBodyNode, &RigidBodyNode::__UpdateHandler>(this, mUpdateConnection);
             }
         }
@@ -95,15 +97,15 @@ namespace jz
             }
         }
 
-        SceneNode* RigidBodyNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        SceneNode* RigidBodyNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
             return new RigidBodyNode(aBaseId, aCloneId);
         }
 
         void RigidBodyNode::__UpdateHandler(physics::Body3D* apBody)
         {
-            ToTransform(apBody->GetFrame(), mWorld);
-            mFlags |= SceneNodeFlags::kWorldDirty;
+            ToTransform(apBody->GetFrame(), _World());
+            _Flags() |= SceneNodeFlags::kWorldDirty;
         }
 
     }
@@ -38,9 +38,11 @@ namespace jz
 
         class RigidBodyNode : public MeshNode
         {
+            JZ_SCENE_NODE_CLASS()
+
         public:
             RigidBodyNode();
-            RigidBodyNode(const string& aBaseId, const string& aId);
+            RigidBodyNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~RigidBodyNode();
 
             void DisablePhysicsBody();
@@ -49,7 +51,7 @@ namespace jz
         protected:
             virtual void _PreUpdateA(const Matrix4& aParentWorld, bool abParentChanged) override;
             virtual void _PopulateClone(SceneNode* apNode) override;
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId) override;
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId) override;
 
             physics::Body3DPtr mpPhysicsBody;
             void __UpdateHandler(physics::Body3D* apBody);
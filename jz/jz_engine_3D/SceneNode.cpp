@@ -20,6 +20,8 @@
 // THE SOFTWARE.
 // 
 
+#include <jz_core/Hash.h>
+#include <jz_core/StringUtility.h>
 #include <jz_engine_3D/SceneNode.h>
 
 namespace jz
@@ -27,108 +29,223 @@ namespace jz
     namespace engine_3D
     {
 
-        SceneNode::Container SceneNode::msNodes;
+        // Open addressed table from the hash of (base id, id) to the node registered
+        // under it. The table is kept at most half full so probes stay short; removal
+        // shifts the following run back instead of leaving tombstones.
+        class SceneNode::Registry sealed
+        {
+        public:
+            Registry()
+                : mCount(0u)
+            {}
+
+            SceneNode* Find(u64 aKey, const system::StringId& aBaseId, const system::StringId& aId) const
+            {
+                if (mEntries.empty()) { return null; }
+
+                const size_t kMask = (mEntries.size() - 1u);
+                for (size_t i = (size_t)aKey & kMask; mEntries[i].pNode; i = (i + 1u) & kMask)
+                {
+                    const Entry& e = mEntries[i];
+
+                    // Keys can collide; ids are interned so comparing them is cheap.
+                    if (e.Key == aKey && e.pNode->mId == aId && e.pNode->mBaseId == aBaseId)
+                    {
+                        return e.pNode;
+                    }
+                }
+
+                return null;
+            }
+
+            void Insert(u64 aKey, SceneNode* apNode)
+            {
+                if ((mCount + 1u) * 2u > mEntries.size()) { _Grow(); }
+
+                _Insert(aKey, apNode);
+                mCount++;
+            }
+
+            void Remove(u64 aKey, SceneNode* apNode)
+            {
+                if (mEntries.empty()) { return; }
+
+                const size_t kMask = (mEntries.size() - 1u);
+                size_t i = (size_t)aKey & kMask;
+                for (; mEntries[i].pNode != apNode; i = (i + 1u) & kMask)
+                {
+                    if (!mEntries[i].pNode) { return; }
+                }
+
+                for (size_t j = (i + 1u) & kMask; mEntries[j].pNode; j = (j + 1u) & kMask)
+                {
+                    const size_t home = (size_t)mEntries[j].Key & kMask;
+
+                    // Entry j can fill the hole at i unless its home lies cyclically in (i, j].
+                    const bool bStay = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                    if (!bStay)
+                    {
+                        mEntries[i] = mEntries[j];
+                        i = j;
+                    }
+                }
+
+                mEntries[i] = Entry();
+                mCount--;
+            }
+
+        private:
+            struct Entry
+            {
+                Entry()
+                    : Key(0u), pNode(null)
+                {}
+
+                u64 Key;
+                SceneNode* pNode;
+            };
+
+            static const size_t kMinimumSize = 256u;
+
+            vector<Entry> mEntries;
+            size_t mCount;
+
+            void _Insert(u64 aKey, SceneNode* apNode)
+            {
+                const size_t kMask = (mEntries.size() - 1u);
+                size_t i = (size_t)aKey & kMask;
+                while (mEntries[i].pNode) { i = (i + 1u) & kMask; }
+
+                mEntries[i].Key = aKey;
+                mEntries[i].pNode = apNode;
+            }
+
+            void _Grow()
+            {
+                vector<Entry> old;
+                old.swap(mEntries);
+
+                mEntries.resize((old.empty()) ? (size_t)kMinimumSize : (old.size() * 2u));
+                for (size_t i = 0u; i < old.size(); i++)
+                {
+                    if (old[i].pNode) { _Insert(old[i].Key, old[i].pNode); }
+                }
+            }
+        };
+
+        SceneNode::Registry SceneNode::msNodes;
         SceneNode::RetrieveContainer SceneNode::msToRetrieve;
+        AnimationBatch SceneNode::msAnimation;
+        TransformHierarchy SceneNode::msTransforms;
 
         SceneNode::SceneNode()
-            : mBaseId(string()),
-            mId(string()),
-            mbDirty(false),
-            mFlags(SceneNodeFlags::kLocalDirty),
-            mLocal(Matrix4::kIdentity),
-            mWit(Matrix4::kIdentity),
-            mWorld(Matrix4::kIdentity),
-            mbValidBounding(false),
+            : mbValidBounding(false),
             mWorldAABB(BoundingBox::kZero),
-            mWorldBounding(BoundingSphere::kZero)
+            mWorldBounding(BoundingSphere::kZero),
+            mTransform(msTransforms.Add(this))
         {}
 
-        SceneNode::SceneNode(const string& aBaseId, const string& aId)
-            : mBaseId(aBaseId),
-            mId(aId),
-            mbDirty(false),
-            mFlags(SceneNodeFlags::kLocalDirty),
-            mLocal(Matrix4::kIdentity),
-            mWit(Matrix4::kIdentity),
-            mWorld(Matrix4::kIdentity),
-            mbValidBounding(false),
+        SceneNode::SceneNode(const system::StringId& aBaseId, const system::StringId& aId)
+            : mbValidBounding(false),
             mWorldAABB(BoundingBox::kZero),
-            mWorldBounding(BoundingSphere::kZero)
+            mWorldBounding(BoundingSphere::kZero),
+            mTransform(msTransforms.Add(this)),
+            mBaseId(aBaseId),
+            mId(aId)
         {
-            string combinedId = (aBaseId + aId);
-            JZ_ASSERT(msNodes.find(combinedId) == msNodes.end());
-
-            msNodes.insert(make_pair(combinedId, this));
+            _Register();
 
-            RetrieveContainer::iterator I = msToRetrieve.find(combinedId);
-
-            if (I != msToRetrieve.end())
+            // Keys can collide, so only actions waiting on these ids are run. They are
+            // taken out first, since an action may create nodes of its own.
+            vector<RetrieveAction> actions;
+            const u64 kKey = _GetKey(mBaseId, mId);
+            for (RetrieveContainer::iterator I = msToRetrieve.lower_bound(kKey); I != msToRetrieve.end() && I->first == kKey; )
             {
-                I->second(this);
-                msToRetrieve.erase(I);
+                if (I->second.BaseId == mBaseId && I->second.Id == mId)
+                {
+                    actions.push_back(I->second.Action);
+                    msToRetrieve.erase(I++);
+                }
+                else
+                {
+                    I++;
+                }
             }
+
+            for (size_t i = 0u; i < actions.size(); i++) { actions[i](this); }
         }
 
         SceneNode::~SceneNode()
         {
-            if (!mBaseId.empty() || !mId.empty())
+            _Unregister();
+
+            // ~TreeNode() detaches children without going through SetParent().
+            for (iterator I = begin(); I != end(); I++)
             {
-                msNodes.erase(mBaseId + mId);
+                msTransforms.SetParent(I->mTransform, TransformHierarchy::kNone);
             }
+
+            msTransforms.Remove(mTransform);
         }
 
         void SceneNode::SetParent(weak_pointer p)
         {
             TreeNode<SceneNode>::SetParent(p);
+            msTransforms.SetParent(mTransform, (p) ? p->mTransform : TransformHierarchy::kNone);
 
-            if (GetParent() && (GetBaseId() == string()))
+            if (GetParent() && GetBaseId().empty())
             {
                 SetBaseId(GetParent()->GetBaseId());
             }
         }
 
-        void SceneNode::SetIds(const string& aBaseId, const string& aId)
+        void SceneNode::SetIds(const system::StringId& aBaseId, const system::StringId& aId)
         {
-            JZ_ASSERT(msNodes.find(aBaseId + aId) == msNodes.end());
+            JZ_ASSERT(!_Find(aBaseId, aId));
 
-            if (!(mBaseId + mId).empty()) { msNodes.erase(mBaseId + mId); }
+            _Unregister();
             mBaseId = aBaseId;
             mId = aId;
-            if (!(mBaseId + mId).empty()) { msNodes.insert(make_pair(mBaseId + mId, this)); }
+            _Register();
         }
 
-        void SceneNode::SetBaseId(const string& v)
+        void SceneNode::SetBaseId(const system::StringId& v)
         {
-            JZ_ASSERT(msNodes.find(v + mId) == msNodes.end());
+            JZ_ASSERT(!_Find(v, mId));
 
-            if (!(mBaseId + mId).empty()) { msNodes.erase(mBaseId + mId); }
+            _Unregister();
             mBaseId = v;
-            if (!(mBaseId + mId).empty()) { msNodes.insert(make_pair(mBaseId + mId, this)); }
+            _Register();
         }
 
-        void SceneNode::SetId(const string& v)
+        void SceneNode::SetId(const system::StringId& v)
         {
-            JZ_ASSERT(msNodes.find(mBaseId + v) == msNodes.end());
+            JZ_ASSERT(!_Find(mBaseId, v));
 
-            if (!(mBaseId + mId).empty()) { msNodes.erase(mBaseId + mId); }
+            _Unregister();
             mId = v;
-            if (!(mBaseId + mId).empty()) { msNodes.insert(make_pair(mBaseId + mId, this)); }
+            _Register();
         }
 
-        void SceneNode::Get(const string& aBaseId, const string& aId, RetrieveAction aAction)
+        void SceneNode::Get(const system::StringId& aBaseId, const system::StringId& aId, RetrieveAction aAction)
         {
-            Container::iterator I = msNodes.find(aBaseId + aId);
+            SceneNode* p = _Find(aBaseId, aId);
             
-            if (I != msNodes.end()) { aAction(I->second); }
+            if (p) { aAction(p); }
             else
             {
-                msToRetrieve.insert(make_pair(aBaseId + aId, aAction));
+                Retrieve retrieve;
+                retrieve.BaseId = aBaseId;
+                retrieve.Id = aId;
+                retrieve.Action = aAction;
+
+                msToRetrieve.insert(make_pair(_GetKey(aBaseId, aId), retrieve));
             }
         }
 
         AutoPtr<SceneNode> SceneNode::Clone(SceneNode* apParent, const string& aCloneIdPostfix)
         {
-            SceneNode* clone = _SpawnClone(mBaseId, mId + aCloneIdPostfix);
+            SceneNode* clone = _SpawnClone(mBaseId, system::StringId::Append(mId, aCloneIdPostfix.c_str()));
 
             if (clone)
             {
@@ -145,16 +262,66 @@ namespace jz
             }
         }
 
+        void SceneNode::Instantiate(SceneNode* apParent, const system::StringId& aBaseIdPrefix, size_t aCount, const Matrix4* apLocalTransforms, vector<AutoPtr<SceneNode> >& arInstances)
+        {
+            msTransforms.Reserve(_GetSubtreeSize() * aCount);
+            arInstances.reserve(arInstances.size() + aCount);
+
+            for (size_t i = 0u; i < aCount; i++)
+            {
+                const system::StringId kBaseId = system::StringId::Append(aBaseIdPrefix, StringUtility::ToString(i).c_str());
+
+                SceneNode* p = _Instance(apParent, kBaseId);
+                if (p)
+                {
+                    if (apLocalTransforms) { p->SetLocalTransform(apLocalTransforms[i]); }
+                    arInstances.push_back(p);
+                }
+            }
+        }
+
         void SceneNode::_PopulateClone(SceneNode* apNode)
         {
-            apNode->mLocal = mLocal;
+            apNode->_Local() = _Local();
         }
 
-        SceneNode* SceneNode::_SpawnClone(const string& aBaseId, const string& aCloneId)
+        const SceneNodeClass SceneNode::kClass = { null, "SceneNode" };
+
+        SceneNode* SceneNode::_SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId)
         {
             return new SceneNode(aBaseId, aCloneId);
         }
 
+        SceneNode* SceneNode::_Instance(SceneNode* apParent, const system::StringId& aBaseId)
+        {
+            SceneNode* instance = _SpawnClone(aBaseId, mId);
+
+            if (instance)
+            {
+                _PopulateClone(instance);
+
+                for (iterator I = begin(); I != end(); I++)
+                {
+                    I->_Instance(instance, aBaseId);
+                }
+
+                instance->SetParent(apParent);
+            }
+
+            return instance;
+        }
+
+        size_t SceneNode::_GetSubtreeSize() const
+        {
+            size_t ret = 1u;
+            for (const_iterator I = begin(); I != end(); I++)
+            {
+                ret += I->_GetSubtreeSize();
+            }
+
+            return ret;
+        }
+
         void SceneNode::_CloneChildren(SceneNode* aToParent, const string& aCloneIdPostfix)
         {
             for (iterator I = begin(); I != end(); I++)
@@ -163,101 +330,79 @@ namespace jz
             }
         }
 
-        void SceneNode::_UpdateWit()
+        SceneNode* SceneNode::_Find(const system::StringId& aBaseId, const system::StringId& aId)
         {
-            mWit = Matrix4::CreateNormalTransform(mWorld);
+            return msNodes.Find(_GetKey(aBaseId, aId), aBaseId, aId);
         }
 
-        Matrix4 SceneNode::_GetUpdatedWorldTransform(const Matrix4& aParentWorld, bool abParentChanged) const
+        SceneNode* SceneNode::_Find(const char* apBaseId, const char* apId)
+        {
+            const system::StringId kBaseId(system::StringId::Find(apBaseId, strlen(apBaseId)));
+            const system::StringId kId(system::StringId::Find(apId, strlen(apId)));
+
+            // A string that was never interned is not the id of any node.
+            if ((kBaseId.empty() && *apBaseId) || (kId.empty() && *apId)) { return null; }
+
+            return _Find(kBaseId, kId);
+        }
+
+        u64 SceneNode::_GetKey(const system::StringId& aBaseId, const system::StringId& aId)
+        {
+            const u64 idHash = aId.GetHash();
+
+            return hash64((u8c_p)&idHash, sizeof(u64), aBaseId.GetHash());
+        }
+
+        void SceneNode::_Register()
         {
-            if ((mFlags & SceneNodeFlags::kIgnoreParent) == 0)
+            if (!mBaseId.empty() || !mId.empty())
             {
-                if ((mFlags & SceneNodeFlags::kWorldDirty) != 0)
-                {
-                    return (mWorld);
-                }
-                else if (abParentChanged || (mFlags & SceneNodeFlags::kLocalDirty) != 0)
-                {
-                    return (mLocal * aParentWorld);
-                }
+                JZ_ASSERT(!_Find(mBaseId, mId));
+                msNodes.Insert(_GetKey(mBaseId, mId), this);
             }
-            else
+        }
+
+        void SceneNode::_Unregister()
+        {
+            if (!mBaseId.empty() || !mId.empty())
             {
-                if ((mFlags & SceneNodeFlags::kWorldDirty) != 0)
-                {
-                    return (mWorld);
-                }
-                else if ((mFlags & SceneNodeFlags::kLocalDirty) != 0)
-                {
-                    return (mLocal);
-                }
+                msNodes.Remove(_GetKey(mBaseId, mId), this);
             }
-
-            return (mWorld);
         }
 
-        bool SceneNode::_Update(const Matrix4& aParentWorld, bool abParentChanged)
+        Matrix4 SceneNode::_GetUpdatedWorldTransform(const Matrix4& aParentWorld, bool abParentChanged) const
         {
-            bool bChanged = false;
-
-            if ((mFlags & SceneNodeFlags::kIgnoreParent) == 0)
+            if ((_Flags() & SceneNodeFlags::kIgnoreParent) == 0)
             {
-                if ((mFlags & SceneNodeFlags::kWorldDirty) != 0)
+                if ((_Flags() & SceneNodeFlags::kWorldDirty) != 0)
                 {
-                    _UpdateWit();
-                    Matrix4 invParent = Matrix4::Invert(aParentWorld);
-                    mLocal = (mWorld * invParent);
-
-                    mFlags &= ~SceneNodeFlags::kWorldDirty;
-                    mFlags &= ~SceneNodeFlags::kLocalDirty;
-                    bChanged = true;
+                    return (_World());
                 }
-                else if (abParentChanged || (mFlags & SceneNodeFlags::kLocalDirty) != 0)
+                else if (abParentChanged || (_Flags() & SceneNodeFlags::kLocalDirty) != 0)
                 {
-                    mWorld = (mLocal * aParentWorld);
-                    _UpdateWit();
-
-                    mFlags &= ~SceneNodeFlags::kLocalDirty;
-                    bChanged = true;
+                    return (_Local() * aParentWorld);
                 }
             }
             else
             {
-                if ((mFlags & SceneNodeFlags::kWorldDirty) != 0)
+                if ((_Flags() & SceneNodeFlags::kWorldDirty) != 0)
                 {
-                    _UpdateWit();
-                    mLocal = mWorld;
-
-                    mFlags &= ~SceneNodeFlags::kWorldDirty;
-                    mFlags &= ~SceneNodeFlags::kLocalDirty;
-                    bChanged = true;
+                    return (_World());
                 }
-                else if ((mFlags & SceneNodeFlags::kLocalDirty) != 0)
+                else if ((_Flags() & SceneNodeFlags::kLocalDirty) != 0)
                 {
-                    mWorld = mLocal;
-                    _UpdateWit();
-
-                    mFlags &= ~SceneNodeFlags::kLocalDirty;
-                    bChanged = true;
+                    return (_Local());
                 }
             }
 
-            bool bBoundingUpdate = bChanged;
-            for (iterator I = begin(); I != end(); I++)
-            {
-                bBoundingUpdate = I->_DoUpdate(mWorld, bChanged) || bBoundingUpdate;
-            }
-
-            mbDirty = bBoundingUpdate;
-
-            if (mbDirty)
-            {
-                mWorldAABB = BoundingBox::kZero;
-                mWorldBounding = BoundingSphere::kZero;
-                mbValidBounding = false;
-            }
+            return (_World());
+        }
 
-            return mbDirty;
+        void SceneNode::_ResetBounding()
+        {
+            mWorldAABB = BoundingBox::kZero;
+            mWorldBounding = BoundingSphere::kZero;
+            mbValidBounding = false;
         }
 
         void SceneNode::_UpdateBounding()
@@ -269,7 +414,7 @@ namespace jz
 
             for (; I != end(); I++)
             {
-                if (I->mbValidBounding && (I->mFlags & SceneNodeFlags::kExcludeFromBounding) == 0)
+                if (I->mbValidBounding && (I->_Flags() & SceneNodeFlags::kExcludeFromBounding) == 0)
                 {
                     bValid = true;
                     box = I->mWorldAABB;
@@ -282,7 +427,7 @@ namespace jz
 
             for (; I != end(); I++)
             {
-                if (I->mbValidBounding && (I->mFlags & SceneNodeFlags::kExcludeFromBounding) == 0)
+                if (I->mbValidBounding && (I->_Flags() & SceneNodeFlags::kExcludeFromBounding) == 0)
                 {
                     box = BoundingBox::Merge(box, I->mWorldAABB);
                     sphere = BoundingSphere::Merge(sphere, I->mWorldBounding);
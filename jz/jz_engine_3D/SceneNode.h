@@ -31,6 +31,9 @@
 #include <jz_core/Quaternion.h>
 #include <jz_core/Tree.h>
 #include <jz_core/Vector3.h>
+#include <jz_engine_3D/AnimationBatch.h>
+#include <jz_engine_3D/TransformHierarchy.h>
+#include <jz_system/StringId.h>
 #include <functional>
 #include <map>
 #include <string>
@@ -47,96 +50,131 @@ namespace jz
                 kLocalDirty = (1 << 0),
                 kWorldDirty = (1 << 1),
                 kExcludeFromBounding = (1 << 2),
-                kIgnoreParent = (1 << 3)
+                kIgnoreParent = (1 << 3),
+                kChanged = (1 << 4)
             };
         }
 
         static const char* kSceneNodeDefaultCloneIdPostfix = "_clone";
 
+        // Static description of a SceneNode class, used by SceneNodeCast in place of
+        // dynamic_cast. Every SceneNode subclass declares one with JZ_SCENE_NODE_CLASS
+        // in its body and defines it with JZ_SCENE_NODE_CLASS_IMPL in its .cpp.
+        struct SceneNodeClass
+        {
+            const SceneNodeClass* pBase;
+            const char* pName;
+        };
+
+#       define JZ_SCENE_NODE_CLASS() \
+            public: \
+                static const ::jz::engine_3D::SceneNodeClass kClass; \
+                virtual const ::jz::engine_3D::SceneNodeClass& GetClass() const override { return kClass; }
+
+#       define JZ_SCENE_NODE_CLASS_IMPL(aClass, aBase) \
+            const ::jz::engine_3D::SceneNodeClass aClass::kClass = { &aBase::kClass, #aClass }
+
+        class SceneNode;
+        template <typename T> T* SceneNodeCast(SceneNode* p);
+
         class SceneNode : public TreeNode<SceneNode>
         {
         public:
             JZ_ALIGNED_NEW
 
-            bool IsIgnoringParent() const { return ((mFlags & SceneNodeFlags::kIgnoreParent) != 0); }
-            bool IsLocalDirty() const { return ((mFlags & SceneNodeFlags::kLocalDirty) != 0); }
-            bool IsWorldDirty() const { return ((mFlags & SceneNodeFlags::kWorldDirty) != 0); }
+            static const SceneNodeClass kClass;
+            virtual const SceneNodeClass& GetClass() const { return kClass; }
+
+            bool IsA(const SceneNodeClass& aClass) const
+            {
+                for (const SceneNodeClass* p = &GetClass(); p; p = p->pBase)
+                {
+                    if (p == &aClass) { return true; }
+                }
+
+                return false;
+            }
+
+            bool IsIgnoringParent() const { return ((_Flags() & SceneNodeFlags::kIgnoreParent) != 0); }
+            bool IsLocalDirty() const { return ((_Flags() & SceneNodeFlags::kLocalDirty) != 0); }
+            bool IsWorldDirty() const { return ((_Flags() & SceneNodeFlags::kWorldDirty) != 0); }
 
             typedef tr1::function<void(SceneNode*)> RetrieveAction;
 
             virtual void SetParent(weak_pointer p) override;
 
             SceneNode();
-            SceneNode(const string& aBaseId, const string& aId);
+            SceneNode(const system::StringId& aBaseId, const system::StringId& aId);
             virtual ~SceneNode();
 
-            bool bDirty() const { return mbDirty; }
+            // True if the last Update moved this node or one of its descendants.
+            bool bDirty() const { return ((_Flags() & SceneNodeFlags::kChanged) != 0); }
             bool bValidBounding() const { return mbValidBounding; }
-            const Matrix4& GetWit() const { return mWit; }
+            const Matrix4& GetWit() const { return _Wit(); }
 
             virtual const BoundingBox& GetBoundingBox() const { return mWorldAABB; }
             virtual const BoundingSphere& GetBoundingSphere() const { return mWorldBounding; }
 
-            virtual void SetIds(const string& aBaseId, const string& aId);
-            const string& GetBaseId() const { return mBaseId; }
-            virtual void SetBaseId(const string& v);
-            const string& GetId() const { return mId; }
-            virtual void SetId(const string& v);
+            virtual void SetIds(const system::StringId& aBaseId, const system::StringId& aId);
+            const system::StringId& GetBaseId() const { return mBaseId; }
+            virtual void SetBaseId(const system::StringId& v);
+            const system::StringId& GetId() const { return mId; }
+            virtual void SetId(const system::StringId& v);
 
             Quaternion GetLocalOrientation() const
             {
                 Quaternion ret;
-                ToQuaternion(mLocal, ret);
+                ToQuaternion(_Local(), ret);
                 return ret;
             }
 
             void SetLocalOrientation(const Quaternion& v)
             {
-                ToTransform(v, mLocal);
-                mFlags |= SceneNodeFlags::kLocalDirty;
+                ToTransform(v, _Local());
+                _Flags() |= SceneNodeFlags::kLocalDirty;
             }
 
-            Vector3 GetLocalTranslation() const { return mLocal.GetTranslation(); }
+            Vector3 GetLocalTranslation() const { return _Local().GetTranslation(); }
             void SetLocalTranslation(const Vector3& v)
             {
-                mLocal.SetTranslation(v);
-                mFlags |= SceneNodeFlags::kLocalDirty;
+                _Local().SetTranslation(v);
+                _Flags() |= SceneNodeFlags::kLocalDirty;
             }
 
-            const Matrix4& GetLocalTransform() const { return mLocal; }
+            const Matrix4& GetLocalTransform() const { return _Local(); }
             void SetLocalTransform(const Matrix4& v)
             {
-                mLocal = v;
-                mFlags |= SceneNodeFlags::kLocalDirty;
+                _Local() = v;
+                _Flags() |= SceneNodeFlags::kLocalDirty;
             }
 
             Quaternion GetWorldOrientation() const
             {
                 Quaternion ret;
-                ToQuaternion(mWorld, ret);
+                ToQuaternion(_World(), ret);
                 return ret;
             }
 
             void SetWorldOrientation(const Quaternion& v)
             {
-                ToTransform(v, mWorld);
-                mFlags |= SceneNodeFlags::kWorldDirty;
+                ToTransform(v, _World());
+                _Flags() |= SceneNodeFlags::kWorldDirty;
             }
 
-            Vector3 GetWorldTranslation() const { return mWorld.GetTranslation(); }
+            Vector3 GetWorldTranslation() const { return _World().GetTranslation(); }
             void SetWorldTranslation(const Vector3& v)
             {
-                mWorld.SetTranslation(v);
-                mFlags |= SceneNodeFlags::kWorldDirty;
+                _World().SetTranslation(v);
+                _Flags() |= SceneNodeFlags::kWorldDirty;
             }
 
-            const Matrix4& GetWitTransform() const { return mWit; }
+            const Matrix4& GetWitTransform() const { return _Wit(); }
 
-            const Matrix4& GetWorldTransform() const { return mWorld; }
+            const Matrix4& GetWorldTransform() const { return _World(); }
             void SetWorldTransform(const Matrix4& v)
             {
-                mWorld = v;
-                mFlags |= SceneNodeFlags::kWorldDirty;
+                _World() = v;
+                _Flags() |= SceneNodeFlags::kWorldDirty;
             }
 
             typedef Event<void(SceneNode*)> Callback;
@@ -147,33 +185,43 @@ namespace jz
             {
                 _DoPreUpdateA(aParentWorld, abParentChanged);
                 _DoPreUpdateB(aParentWorld, abParentChanged);
+                msAnimation.Pose();
                 _DoUpdate(aParentWorld, abParentChanged);
+                msAnimation.Skin();
                 _DoPostUpdate();
             }
 
             template <typename T>
             AutoPtr<T> Clone(SceneNode* apParent)
             {
-                return dynamic_cast<T*>(Clone(apParent, kSceneNodeDefaultCloneIdPostfix));
+                return SceneNodeCast<T>(Clone(apParent, kSceneNodeDefaultCloneIdPostfix).Get());
             }
 
-            template <>
-            AutoPtr<SceneNode> Clone<SceneNode>(SceneNode* apParent)
+            AutoPtr<SceneNode> Clone(SceneNode* apParent, const string& aCloneIdPostfix);
+
+            // Creates aCount instances of this subtree under apParent. Instance i keeps the
+            // ids of this subtree under the base id aBaseIdPrefix + i, so id lookups within
+            // an instance find that instance's nodes, and its root takes the local transform
+            // apLocalTransforms[i], or keeps this node's if apLocalTransforms is null.
+            // Immutable data such as key frames and skins is shared with this subtree rather
+            // than copied. The roots are appended to arInstances.
+            void Instantiate(SceneNode* apParent, const system::StringId& aBaseIdPrefix, size_t aCount, const Matrix4* apLocalTransforms, vector<AutoPtr<SceneNode> >& arInstances);
+
+            template <typename T>
+            static AutoPtr<T> Get(const system::StringId& aBaseId, const system::StringId& aId)
             {
-                return Clone(apParent, kSceneNodeDefaultCloneIdPostfix);
+                return SceneNodeCast<T>(_Find(aBaseId, aId));
             }
-            
-            AutoPtr<SceneNode> Clone(SceneNode* apParent, const string& aCloneIdPostfix);
 
+            // As above, but does not intern apBaseId or apId, a lookup of ids no node has
+            // leaves the string pool as it was.
             template <typename T>
-            static AutoPtr<T> Get(const string& aBaseId, const string& aId)
+            static AutoPtr<T> Get(const char* apBaseId, const char* apId)
             {
-                Container::iterator I = msNodes.find(aBaseId + aId);
-                if (I != msNodes.end()) { return dynamic_cast<T*>(I->second); }
-                else { return null; }
+                return SceneNodeCast<T>(_Find(apBaseId, apId));
             }
 
-            static void Get(const string& aBaseId, const string& aId, RetrieveAction aAction);
+            static void Get(const system::StringId& aBaseId, const system::StringId& aId, RetrieveAction aAction);
 
             template <typename U>
             void Apply(tr1::function<void(U*)> aAction)
@@ -193,40 +241,65 @@ namespace jz
             }
 
         protected:
+            // Transforms live in msTransforms, see TransformHierarchy. References returned
+            // here are invalidated when a SceneNode is created.
+            unatural _Flags() const { return msTransforms.GetFlags(mTransform); }
+            unatural& _Flags() { return msTransforms.GetFlags(mTransform); }
+            const Matrix4& _Local() const { return msTransforms.GetLocal(mTransform); }
+            Matrix4& _Local() { return msTransforms.GetLocal(mTransform); }
+            const Matrix4& _Wit() const { return msTransforms.GetWit(mTransform); }
+            const Matrix4& _World() const { return msTransforms.GetWorld(mTransform); }
+            Matrix4& _World() { return msTransforms.GetWorld(mTransform); }
+
             Matrix4 _GetUpdatedWorldTransform(const Matrix4& aParentWorld, bool abParentChanged) const;
 
             virtual void _PopulateClone(SceneNode* apNode);
             virtual void _PreUpdateA(const Matrix4& aParentWorld, bool abParentChanged) {}
             virtual void _PreUpdateB(const Matrix4& aParentWorld, bool abParentChanged) {}
             virtual void _PostUpdate(bool abChanged) {}
-            virtual SceneNode* _SpawnClone(const string& aBaseId, const string& aCloneId);
+            virtual SceneNode* _SpawnClone(const system::StringId& aBaseId, const system::StringId& aCloneId);
 
-            unatural mFlags;
-            Matrix4 mLocal;
-            Matrix4 mWit;
-            Matrix4 mWorld;
             bool mbValidBounding;
             BoundingBox mWorldAABB;
             BoundingSphere mWorldBounding;
 
+            static AnimationBatch msAnimation;
+
         private:
+            friend class TransformHierarchy;
+
             SceneNode(const SceneNode&);
             SceneNode& operator=(const SceneNode&);
 
-            bool mbDirty;
-            string mBaseId;
-            string mId;
+            TransformHierarchy::Slot mTransform;
+            system::StringId mBaseId;
+            system::StringId mId;
 
-            typedef map<string, SceneNode*> Container;
-            typedef map<string, RetrieveAction> RetrieveContainer;
+            class Registry;
 
-            static Container msNodes;
+            struct Retrieve
+            {
+                system::StringId BaseId;
+                system::StringId Id;
+                RetrieveAction Action;
+            };
+
+            typedef multimap<u64, Retrieve> RetrieveContainer;
+
+            static Registry msNodes;
             static RetrieveContainer msToRetrieve;
+            static TransformHierarchy msTransforms;
 
-            void _CloneChildren(SceneNode* aToParent, const string& aCloneIdPostfix);
-            void _UpdateWit();
+            static SceneNode* _Find(const system::StringId& aBaseId, const system::StringId& aId);
+            static SceneNode* _Find(const char* apBaseId, const char* apId);
+            static u64 _GetKey(const system::StringId& aBaseId, const system::StringId& aId);
 
-            bool _Update(const Matrix4& aParentWorld, bool abParentChanged);
+            void _CloneChildren(SceneNode* aToParent, const string& aCloneIdPostfix);
+            SceneNode* _Instance(SceneNode* apParent, const system::StringId& aBaseId);
+            size_t _GetSubtreeSize() const;
+            void _Register();
+            void _Unregister();
+            void _ResetBounding();
             void _UpdateBounding();
 
             void _DoPreUpdateA(const Matrix4& aParentWorld, bool abParentChanged)
@@ -236,7 +309,7 @@ namespace jz
 
                 for (iterator I = begin(); I != end(); I++)
                 {
-                    I->_DoPreUpdateA(mWorld, abParentChanged);
+                    I->_DoPreUpdateA(_World(), abParentChanged);
                 }
             }
 
@@ -246,27 +319,29 @@ namespace jz
 
                 for (iterator I = begin(); I != end(); I++)
                 {
-                    I->_DoPreUpdateB(mWorld, abParentChanged);
+                    I->_DoPreUpdateB(_World(), abParentChanged);
                 }
             }
 
             bool _DoUpdate(const Matrix4& aParentWorld, bool abParentChanged)
             {
-                bool bReturn = _Update(aParentWorld, abParentChanged);
+                bool bReturn = msTransforms.Update(mTransform, aParentWorld, abParentChanged);
 
                 return bReturn;
             }
 
             void _DoPostUpdate()
             {
-                _PostUpdate(mbDirty);
+                const bool kbDirty = bDirty();
+
+                _PostUpdate(kbDirty);
 
                 for (iterator I = begin(); I != end(); I++)
                 {
                     I->_DoPostUpdate();
                 }
 
-                if (mbDirty)
+                if (kbDirty)
                 {
                     _UpdateBounding();
                     OnUpdateEnd(this);
@@ -276,6 +351,18 @@ namespace jz
 
         typedef AutoPtr<SceneNode> SceneNodePtr;
 
+        template <>
+        inline AutoPtr<SceneNode> SceneNode::Clone<SceneNode>(SceneNode* apParent)
+        {
+            return Clone(apParent, kSceneNodeDefaultCloneIdPostfix);
+        }
+
+        template <typename T>
+        T* SceneNodeCast(SceneNode* p)
+        {
+            return (p && p->IsA(T::kClass)) ? static_cast<T*>(p) : null;
+        }
+
     }
 }
 
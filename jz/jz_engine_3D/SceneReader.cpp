@@ -39,6 +39,11 @@
 
 namespace jz
 {
+    namespace system
+    {
+        template <> struct ByteOrder<engine_3D::KeyFrame> { enum { kWordSize = sizeof(f32) }; };
+    }
+
     namespace engine_3D
     {
 
@@ -60,13 +65,13 @@ namespace jz
             };
         }
 
-        static SceneNode* ReadAnimatedMesh(system::IReadFilePtr& in)
+        static SceneNodePtr ReadAnimatedMesh(system::IReadFilePtr& in, u16 aVersion)
         {
             using namespace graphics;
             using namespace system;
 
             Graphics& graphics = Graphics::GetSingleton();
-            AnimatedMeshNode* ret = new AnimatedMeshNode();
+            AnimatedMeshNodeNodePtr ret(new AnimatedMeshNode());
 
             ret->SetEffect(graphics.Create<StandardEffect>(ReadString(in)));
             ret->SetMaterial(graphics.Create<Material>(ReadString(in)));
@@ -78,42 +83,49 @@ namespace jz
             ret->SetRootJointId(ReadString(in));
 
             size_t size = ReadSizeT(in);
-            vector<string>& ids = ret->GetJointIds();
+            vector<StringId>& ids = ret->GetJointIds();
             
             for (size_t i = 0; i < size; i++)
             {
                 ids.push_back(ReadString(in));
             }
 
+            // Without them, every joint is bounded by the whole mesh.
+            if (aVersion >= SceneFile::kJointAABBsVersion)
+            {
+                ReadBuffer(in, ret->GetJointAABBs());
+            }
+
             return ret;
         }
 
-        static SceneNode* ReadDirectionalLight(system::IReadFilePtr& in)
+        static SceneNodePtr ReadDirectionalLight(system::IReadFilePtr& in)
         {
-            LightNode* ret = new LightNode();
+            LightNodePtr ret(new LightNode());
             ret->SetColor(system::ReadVector3(in));
             ret->SetType(LightNodeType::kDirectional);
 
             return ret;
         }
 
-        static SceneNode* ReadJoint(system::IReadFilePtr& in)
+        static SceneNodePtr ReadJoint(system::IReadFilePtr& in)
         {
             string animationId = system::ReadString(in);
 
-            JointNode* ret = new JointNode();
+            JointNodePtr ret(new JointNode());
             system::ReadBuffer(in, ret->GetAnimation().KeyFrames);
+            ret->GetAnimation().Compress();
 
             return ret;
         }
 
-        static SceneNode* ReadMesh(system::IReadFilePtr& in)
+        static SceneNodePtr ReadMesh(system::IReadFilePtr& in)
         {
             using namespace graphics;
             using namespace system;
 
             Graphics& graphics = Graphics::GetSingleton();
-            MeshNode* ret = new MeshNode();
+            MeshNodePtr ret(new MeshNode());
 
             ret->SetEffect(graphics.Create<StandardEffect>(ReadString(in)));
             ret->SetMaterial(graphics.Create<Material>(ReadString(in)));
@@ -122,18 +134,18 @@ namespace jz
             return ret;
         }
 
-        static SceneNode* ReadPhysics(system::IReadFilePtr& in)
+        static SceneNodePtr ReadPhysics(system::IReadFilePtr& in)
         {
-            PhysicsNode* ret = new PhysicsNode();
+            PhysicsNodePtr ret(new PhysicsNode());
             ret->GetWorldTree()->mTriangleTree.Read(in);
             ret->GetWorldBody()->Update();
 
             return ret;
         }
 
-        static SceneNode* ReadPointLight(system::IReadFilePtr& in)
+        static SceneNodePtr ReadPointLight(system::IReadFilePtr& in)
         {
-            LightNode* ret = new LightNode();
+            LightNodePtr ret(new LightNode());
             ret->SetAttenuation(ReadVector3(in));
             ret->SetColor(ReadVector3(in));
             ret->SetType(LightNodeType::kPoint);
@@ -141,9 +153,9 @@ namespace jz
             return ret;
         }
 
-        static SceneNode* ReadSpotLight(system::IReadFilePtr& in)
+        static SceneNodePtr ReadSpotLight(system::IReadFilePtr& in)
         {
-            LightNode* ret = new LightNode();
+            LightNodePtr ret(new LightNode());
             ret->SetFalloffAngle(Radian(ReadSingle(in)));
             ret->SetFalloffExponent(ReadSingle(in));
             ret->SetAttenuation(ReadVector3(in));
@@ -153,8 +165,26 @@ namespace jz
             return ret;
         }
 
+        static SceneNodePtr CreateSceneNode(SceneNodeType::Enum aType, system::IReadFilePtr& in, u16 aVersion)
+        {
+            switch (aType)
+            {
+            case SceneNodeType::kAnimatedMesh: return ReadAnimatedMesh(in, aVersion);
+            //case SceneNodeType::kCamera: return ReadCamera(in);
+            case SceneNodeType::kDirectionalLight: return ReadDirectionalLight(in);
+            case SceneNodeType::kJoint: return ReadJoint(in);
+            case SceneNodeType::kMesh: return ReadMesh(in);
+            case SceneNodeType::kNode: return SceneNodePtr(new SceneNode());
+            case SceneNodeType::kPhysics: return ReadPhysics(in);
+            case SceneNodeType::kPointLight: return ReadPointLight(in);
+            case SceneNodeType::kSpotLight: return ReadSpotLight(in);
+            default:
+                throw JZ_EXCEPTION("should not be here.");
+            }
+        }
+
         static void ReadSceneNode(system::IReadFilePtr& in, SceneNode* pParent);
-        static SceneNode* ReadSceneNode(system::IReadFilePtr& in)
+        static SceneNodePtr ReadSceneNode(system::IReadFilePtr& in)
         {
             int childrenCount = ReadInt32(in);
             string baseId = ReadString(in);
@@ -162,28 +192,15 @@ namespace jz
             Matrix4 localTransform = ReadMatrix4(in);
             SceneNodeType::Enum type = (SceneNodeType::Enum)ReadInt32(in);
             
-            SceneNode* pNode = null;
-            switch (type)
-            {
-            case SceneNodeType::kAnimatedMesh: pNode = ReadAnimatedMesh(in); break;
-            //case SceneNodeType::kCamera: pNode = ReadCamera(in); break;
-            case SceneNodeType::kDirectionalLight: pNode = ReadDirectionalLight(in); break;
-            case SceneNodeType::kJoint: pNode = ReadJoint(in); break;
-            case SceneNodeType::kMesh: pNode = ReadMesh(in); break;
-            case SceneNodeType::kNode: pNode = new SceneNode(); break;
-            case SceneNodeType::kPhysics: pNode = ReadPhysics(in); break;
-            case SceneNodeType::kPointLight: pNode = ReadPointLight(in); break;
-            case SceneNodeType::kSpotLight: pNode = ReadSpotLight(in); break;
-            default:
-                throw exception("should not be here.");
-            }
+            // The legacy layout predates versioning.
+            SceneNodePtr pNode(CreateSceneNode(type, in, 0u));
 
             pNode->SetIds(baseId, id);
             pNode->SetLocalTransform(localTransform);
 
             for (int i = 0; i < childrenCount; i++)
             {
-                ReadSceneNode(in, pNode);
+                ReadSceneNode(in, pNode.Get());
             }
 
             return pNode;
@@ -191,15 +208,90 @@ namespace jz
 
         static void ReadSceneNode(system::IReadFilePtr& in, SceneNode* pParent)
         {
-            SceneNode* pNode = ReadSceneNode(in);
+            SceneNodePtr pNode(ReadSceneNode(in));
             pNode->SetParent(pParent);
         }
 
+        // Sizes are u64, so a NodeCount times a record size cannot wrap on 32 bit builds.
+        static bool IsSection(const SceneFile::Header& aHeader, size_t aFileSize, u32 aOffset, u64 aSize)
+        {
+            return ((aOffset % SceneFile::kAlignment) == 0u && aOffset >= aHeader.HeaderSize && ((u64)aOffset + aSize) <= (u64)aFileSize);
+        }
+
+        JZ_STATIC_ASSERT(sizeof(SceneFile::Header) == 48);
+        JZ_STATIC_ASSERT(sizeof(SceneFile::Node) == 24);
+        JZ_STATIC_ASSERT(sizeof(Matrix4) == 64);
+
+        // Nodes are created in file order, so a node's parent always exists already and
+        // hierarchy is rebuilt without recursion.
+        static SceneNodePtr ReadScene(system::IReadFilePtr& in)
+        {
+            using namespace system;
+
+            const size_t kFileSize = in->GetSize();
+            ByteBuffer data(kFileSize);
+            JZ_E_ON_FAIL(kFileSize >= sizeof(SceneFile::Header) && in->Read(data.Get(), kFileSize) == kFileSize, "failed reading scene.");
+
+            SceneFile::Header header;
+            memcpy(&header, data.Get(), sizeof(SceneFile::Header));
+
+            JZ_E_ON_FAIL(header.Magic == SceneFile::kMagic, "not a binary scene.");
+            JZ_E_ON_FAIL(header.Version >= SceneFile::kMinVersion && header.Version <= SceneFile::kVersion, "unsupported scene version.");
+            JZ_E_ON_FAIL(header.HeaderSize >= sizeof(SceneFile::Header) && header.NodeCount > 0u, "invalid scene header.");
+            JZ_E_ON_FAIL(IsSection(header, kFileSize, header.TransformsOffset, ((u64)header.NodeCount * sizeof(Matrix4))), "invalid scene transforms.");
+            JZ_E_ON_FAIL(IsSection(header, kFileSize, header.NodesOffset, ((u64)header.NodeCount * sizeof(SceneFile::Node))), "invalid scene nodes.");
+            JZ_E_ON_FAIL(IsSection(header, kFileSize, header.StringsOffset, header.StringsSize), "invalid scene strings.");
+            JZ_E_ON_FAIL(header.StringsSize > 0u && data[(size_t)header.StringsOffset + header.StringsSize - 1u] == 0u, "unterminated scene strings.");
+            JZ_E_ON_FAIL(IsSection(header, kFileSize, header.PayloadOffset, header.PayloadSize), "invalid scene payload.");
+
+            const char* pStrings = (const char*)(data.Get() + header.StringsOffset);
+            u8* pPayloads = (data.Get() + header.PayloadOffset);
+
+            vector<SceneNode*> nodes(header.NodeCount, null);
+            SceneNodePtr pRoot;
+
+            for (u32 i = 0u; i < header.NodeCount; i++)
+            {
+                SceneFile::Node node;
+                memcpy(&node, data.Get() + header.NodesOffset + (i * sizeof(SceneFile::Node)), sizeof(SceneFile::Node));
+
+                JZ_E_ON_FAIL((i == 0u) ? (node.Parent == SceneFile::kNoParent) : (node.Parent < i), "invalid scene hierarchy.");
+                JZ_E_ON_FAIL(node.BaseId < header.StringsSize && node.Id < header.StringsSize, "invalid scene id.");
+                JZ_E_ON_FAIL(((u64)node.Payload + node.PayloadSize) <= header.PayloadSize, "invalid scene node payload.");
+
+                // Each node reads only its own payload, a short one fails instead of
+                // reading into the next.
+                IReadFilePtr pPayload(new MemoryReadFile(in->GetFilename(), pPayloads + node.Payload, node.PayloadSize));
+                SceneNodePtr pNode(CreateSceneNode((SceneNodeType::Enum)node.Type, pPayload, header.Version));
+
+                Matrix4 localTransform;
+                memcpy(localTransform.pData, data.Get() + header.TransformsOffset + (i * sizeof(Matrix4)), sizeof(Matrix4));
+
+                pNode->SetIds(pStrings + node.BaseId, pStrings + node.Id);
+                pNode->SetLocalTransform(localTransform);
+
+                if (i == 0u) { pRoot = pNode; }
+                else { pNode->SetParent(nodes[node.Parent]); }
+
+                nodes[i] = pNode.Get();
+            }
+
+            return pRoot;
+        }
+
         AutoPtr<SceneNode> LoadScene(const string& aFilename)
         {
             system::IReadFilePtr pFile = system::Files::GetSingleton().Open(aFilename.c_str());
 
-            SceneNode* pRet = ReadSceneNode(pFile);
+            u32 magic = 0u;
+            const bool kbBinary = (pFile->Read(&magic, sizeof(u32)) == sizeof(u32) && magic == SceneFile::kMagic);
+            JZ_E_ON_FAIL(pFile->Seek(0, false), "failed seeking scene.");
+
+            if (kbBinary) { return ReadScene(pFile); }
+
+            // The legacy layout is a long run of small scalar reads.
+            system::IReadFilePtr pBuffered(new system::BufferedReadFile(pFile));
+            SceneNodePtr pRet(ReadSceneNode(pBuffered));
 
             return pRet;
         }
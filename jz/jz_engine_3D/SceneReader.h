@@ -30,8 +30,59 @@ namespace jz
 {
     namespace engine_3D
     {
+
+        // Binary scene layout, read with one Read() of the whole file. All offsets are
+        // from the start of the file, so the file can be used wherever it is loaded or
+        // mapped. Sections are 16-byte aligned:
+        //
+        //   Header
+        //   Matrix4[NodeCount]      local transforms
+        //   Node[NodeCount]         depth-first order, parents before their children
+        //   char[StringsSize]       null terminated ids, Node::BaseId and Node::Id index it
+        //   u8[PayloadSize]         per type data, encoded as in the original stream format
+        //
+        // Files that do not start with kMagic are read as the original stream format of
+        // nested nodes.
+        namespace SceneFile
+        {
+            static const u32 kMagic = 0x43535A4A; // "JZSC"
+            static const u16 kVersion = 2u;
+            static const u16 kMinVersion = 1u;
+
+            // Version 2 appends bind space bounding boxes per joint to animated meshes.
+            static const u16 kJointAABBsVersion = 2u;
+            static const u32 kNoParent = 0xFFFFFFFF;
+            static const u32 kAlignment = 16u;
+
+            struct Header
+            {
+                u32 Magic;
+                u16 Version;
+                u16 HeaderSize;
+                u32 NodeCount;
+                u32 TransformsOffset;
+                u32 NodesOffset;
+                u32 StringsOffset;
+                u32 StringsSize;
+                u32 PayloadOffset;
+                u32 PayloadSize;
+                u32 Reserved[3];
+            };
+
+            struct Node
+            {
+                u32 Parent;
+                u32 BaseId;
+                u32 Id;
+                u32 Type;
+                u32 Payload;
+                u32 PayloadSize;
+            };
+        }
+
         class SceneNode; typedef AutoPtr<SceneNode> SceneNodePtr;
         AutoPtr<SceneNode> LoadScene(const string& aFilename);
+
     }
 }
 
@@ -29,7 +29,7 @@
 
 namespace jz
 {
-    engine_3D::ShadowMan* engine_3D::ShadowMan::mspSingleton = null;
+    template <> engine_3D::ShadowMan* Singleton<engine_3D::ShadowMan>::mspSingleton = null;
     namespace engine_3D
     {
 
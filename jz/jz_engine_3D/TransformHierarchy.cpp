@@ -0,0 +1,380 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_engine_3D/SceneNode.h>
+#include <jz_engine_3D/TransformHierarchy.h>
+#include <jz_system/Jobs.h>
+#include <algorithm>
+
+namespace jz
+{
+    namespace engine_3D
+    {
+
+        static const size_t kMinimumCapacity = 16u;
+        static const u32 kNoEntry = TransformHierarchy::kNone;
+
+        struct EntryLess
+        {
+            EntryLess(const vector<u32>& aRoots, const vector<u32>& aDepths)
+                : Roots(aRoots), Depths(aDepths)
+            {}
+
+            bool operator()(u32 a, u32 b) const
+            {
+                if (Roots[a] != Roots[b]) { return (Roots[a] < Roots[b]); }
+                if (Depths[a] != Depths[b]) { return (Depths[a] < Depths[b]); }
+
+                return (a < b);
+            }
+
+            const vector<u32>& Roots;
+            const vector<u32>& Depths;
+
+        private:
+            EntryLess& operator=(const EntryLess&);
+        };
+
+        template <typename T>
+        static void Permute(vector<T>& arData, const vector<u32>& aOrder)
+        {
+            vector<T> data(aOrder.size());
+            for (size_t i = 0u; i < aOrder.size(); i++) { data[i] = arData[aOrder[i]]; }
+
+            arData.swap(data);
+        }
+
+        static void Permute(MemoryBuffer<Matrix4>& arData, MemoryBuffer<Matrix4>& arScratch, const vector<u32>& aOrder)
+        {
+            for (size_t i = 0u; i < aOrder.size(); i++) { arScratch[i] = arData[aOrder[i]]; }
+
+            memcpy(arData.Get(), arScratch.Get(), aOrder.size() * sizeof(Matrix4));
+        }
+
+        TransformHierarchy::TransformHierarchy()
+            : mbSorted(true)
+        {}
+
+        TransformHierarchy::~TransformHierarchy()
+        {}
+
+        TransformHierarchy::Slot TransformHierarchy::Add(SceneNode* apNode)
+        {
+            const u32 kDense = (u32)mFlags.size();
+
+            if (kDense >= mLocal.size())
+            {
+                const size_t kCapacity = Max(kMinimumCapacity, (mLocal.size() * 2u));
+
+                mLocal.resize(kCapacity);
+                mWit.resize(kCapacity);
+                mWorld.resize(kCapacity);
+            }
+
+            mLocal[kDense] = Matrix4::kIdentity;
+            mWit[kDense] = Matrix4::kIdentity;
+            mWorld[kDense] = Matrix4::kIdentity;
+            mFlags.push_back(SceneNodeFlags::kLocalDirty);
+            mNodes.push_back(apNode);
+            mParentSlots.push_back(kNoEntry);
+
+            Slot slot;
+            if (!mFreeSlots.empty())
+            {
+                slot = mFreeSlots.back();
+                mFreeSlots.pop_back();
+                mSlots[slot] = kDense;
+            }
+            else
+            {
+                slot = (Slot)mSlots.size();
+                mSlots.push_back(kDense);
+            }
+            mDenseToSlot.push_back(slot);
+
+            // A new entry is a tree of its own, appending it keeps the order valid.
+            if (mbSorted)
+            {
+                mDepths.push_back(0u);
+                mParents.push_back(kNoEntry);
+                mRoots.push_back(kDense);
+                mTreeEnds.push_back(kDense + 1u);
+                mStates.push_back(kStateOutside);
+            }
+
+            return slot;
+        }
+
+        void TransformHierarchy::Reserve(size_t aAdditional)
+        {
+            const size_t kCapacity = (mFlags.size() + aAdditional);
+
+            if (kCapacity > mLocal.size())
+            {
+                mLocal.resize(kCapacity);
+                mWit.resize(kCapacity);
+                mWorld.resize(kCapacity);
+            }
+
+            mFlags.reserve(kCapacity);
+            mNodes.reserve(kCapacity);
+            mParentSlots.reserve(kCapacity);
+            mDenseToSlot.reserve(kCapacity);
+            mSlots.reserve(mSlots.size() + aAdditional);
+        }
+
+        void TransformHierarchy::Remove(Slot aSlot)
+        {
+            const u32 kDense = mSlots[aSlot];
+            const u32 kLast = (u32)(mFlags.size() - 1u);
+
+            JZ_ASSERT(kDense != kNoEntry);
+
+            if (kDense != kLast)
+            {
+                mLocal[kDense] = mLocal[kLast];
+                mWit[kDense] = mWit[kLast];
+                mWorld[kDense] = mWorld[kLast];
+                mFlags[kDense] = mFlags[kLast];
+                mNodes[kDense] = mNodes[kLast];
+                mParentSlots[kDense] = mParentSlots[kLast];
+                mDenseToSlot[kDense] = mDenseToSlot[kLast];
+                mSlots[mDenseToSlot[kDense]] = kDense;
+            }
+
+            mFlags.pop_back();
+            mNodes.pop_back();
+            mParentSlots.pop_back();
+            mDenseToSlot.pop_back();
+
+            mSlots[aSlot] = kNoEntry;
+            mFreeSlots.push_back(aSlot);
+            mbSorted = false;
+        }
+
+        void TransformHierarchy::SetParent(Slot aSlot, Slot aParent)
+        {
+            const u32 kDense = mSlots[aSlot];
+            Slot& parent = mParentSlots[kDense];
+
+            if (parent != aParent)
+            {
+                // The local transform is kept, the world transform follows the new parent.
+                parent = aParent;
+                mFlags[kDense] |= SceneNodeFlags::kLocalDirty;
+                mbSorted = false;
+            }
+        }
+
+        bool TransformHierarchy::Update(Slot aSlot, const Matrix4& aParentWorld, bool abParentChanged)
+        {
+            if (!mbSorted) { _Sort(); }
+
+            const u32 kStart = mSlots[aSlot];
+            const u32 kEnd = mTreeEnds[mRoots[kStart]];
+
+            mStates[kStart] = (_UpdateEntry(kStart, aParentWorld, abParentChanged)) ? kStateChanged : kStateClean;
+
+            // Each level only reads the level above it, so its entries can be updated in parallel.
+            LevelBody body;
+            body.pThis = this;
+            body.Start = kStart;
+
+            const bool kbParallel = system::Jobs::GetSingletonExists();
+
+            u32 begin = (kStart + 1u);
+            while (begin < kEnd)
+            {
+                u32 end = (begin + 1u);
+                while (end < kEnd && mDepths[end] == mDepths[begin]) { end++; }
+
+                if (kbParallel && (end - begin) >= kParallelThreshold)
+                {
+                    system::Jobs::GetSingleton().ParallelFor(body, begin, end, kParallelGrainSize);
+                }
+                else
+                {
+                    _UpdateRange(kStart, begin, end);
+                }
+
+                begin = end;
+            }
+
+            // Children follow their parents, so one reverse pass carries changes up to kStart.
+            for (u32 i = kEnd; i > kStart; )
+            {
+                i--;
+
+                const u8 kState = mStates[i];
+                if (kState == kStateChanged)
+                {
+                    mFlags[i] |= SceneNodeFlags::kChanged;
+                    mNodes[i]->_ResetBounding();
+
+                    if (i != kStart) { mStates[mParents[i]] = kStateChanged; }
+                }
+                else if (kState == kStateClean)
+                {
+                    mFlags[i] &= ~SceneNodeFlags::kChanged;
+                }
+            }
+
+            return (mStates[kStart] == kStateChanged);
+        }
+
+        void TransformHierarchy::_Sort()
+        {
+            const u32 kCount = (u32)mFlags.size();
+
+            #pragma region Depth and root of every entry
+            vector<u32> depths(kCount, kNoEntry);
+            vector<u32> roots(kCount, kNoEntry);
+            vector<u32> path;
+
+            for (u32 i = 0u; i < kCount; i++)
+            {
+                u32 j = i;
+                while (depths[j] == kNoEntry)
+                {
+                    const Slot kParent = mParentSlots[j];
+                    if (kParent == kNoEntry)
+                    {
+                        depths[j] = 0u;
+                        roots[j] = mDenseToSlot[j];
+                        break;
+                    }
+
+                    path.push_back(j);
+                    j = mSlots[kParent];
+                }
+
+                while (!path.empty())
+                {
+                    const u32 k = path.back();
+                    const u32 kParent = mSlots[mParentSlots[k]];
+                    path.pop_back();
+
+                    depths[k] = (depths[kParent] + 1u);
+                    roots[k] = roots[kParent];
+                }
+            }
+            #pragma endregion
+
+            #pragma region Reorder by tree, then by depth
+            vector<u32> order(kCount);
+            for (u32 i = 0u; i < kCount; i++) { order[i] = i; }
+            sort(order.begin(), order.end(), EntryLess(roots, depths));
+
+            MemoryBuffer<Matrix4> scratch(Max(kCount, 1u));
+            Permute(mLocal, scratch, order);
+            Permute(mWit, scratch, order);
+            Permute(mWorld, scratch, order);
+            Permute(mFlags, order);
+            Permute(mNodes, order);
+            Permute(mParentSlots, order);
+            Permute(mDenseToSlot, order);
+            Permute(depths, order);
+            #pragma endregion
+
+            mDepths.swap(depths);
+            mParents.resize(kCount);
+            mRoots.resize(kCount);
+            mTreeEnds.resize(kCount);
+            mStates.assign(kCount, kStateOutside);
+
+            for (u32 i = 0u; i < kCount; i++) { mSlots[mDenseToSlot[i]] = i; }
+
+            for (u32 i = 0u; i < kCount; i++)
+            {
+                mParents[i] = (mParentSlots[i] == kNoEntry) ? kNoEntry : mSlots[mParentSlots[i]];
+                mRoots[i] = (mParents[i] == kNoEntry) ? i : mRoots[mParents[i]];
+                mTreeEnds[mRoots[i]] = (i + 1u);
+            }
+
+            mbSorted = true;
+        }
+
+        bool TransformHierarchy::_UpdateEntry(u32 i, const Matrix4& aParentWorld, bool abParentChanged)
+        {
+            unatural& flags = mFlags[i];
+
+            if ((flags & SceneNodeFlags::kIgnoreParent) == 0)
+            {
+                if ((flags & SceneNodeFlags::kWorldDirty) != 0)
+                {
+                    mWit[i] = Matrix4::CreateNormalTransform(mWorld[i]);
+                    mLocal[i] = (mWorld[i] * Matrix4::Invert(aParentWorld));
+
+                    flags &= ~(SceneNodeFlags::kWorldDirty | SceneNodeFlags::kLocalDirty);
+                    return true;
+                }
+                else if (abParentChanged || (flags & SceneNodeFlags::kLocalDirty) != 0)
+                {
+                    mWorld[i] = (mLocal[i] * aParentWorld);
+                    mWit[i] = Matrix4::CreateNormalTransform(mWorld[i]);
+
+                    flags &= ~SceneNodeFlags::kLocalDirty;
+                    return true;
+                }
+            }
+            else
+            {
+                if ((flags & SceneNodeFlags::kWorldDirty) != 0)
+                {
+                    mWit[i] = Matrix4::CreateNormalTransform(mWorld[i]);
+                    mLocal[i] = mWorld[i];
+
+                    flags &= ~(SceneNodeFlags::kWorldDirty | SceneNodeFlags::kLocalDirty);
+                    return true;
+                }
+                else if ((flags & SceneNodeFlags::kLocalDirty) != 0)
+                {
+                    mWorld[i] = mLocal[i];
+                    mWit[i] = Matrix4::CreateNormalTransform(mWorld[i]);
+
+                    flags &= ~SceneNodeFlags::kLocalDirty;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void TransformHierarchy::_UpdateRange(u32 aStart, size_t aBegin, size_t aEnd)
+        {
+            for (size_t i = aBegin; i < aEnd; i++)
+            {
+                const u32 kParent = mParents[i];
+
+                if (kParent < aStart || mStates[kParent] == kStateOutside)
+                {
+                    mStates[i] = kStateOutside;
+                }
+                else
+                {
+                    mStates[i] = (_UpdateEntry((u32)i, mWorld[kParent], (mStates[kParent] == kStateChanged))) ? kStateChanged : kStateClean;
+                }
+            }
+        }
+
+    }
+}
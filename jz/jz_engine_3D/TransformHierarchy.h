@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_ENGINE_3D_TRANSFORM_HIERARCHY_H_
+#define _JZ_ENGINE_3D_TRANSFORM_HIERARCHY_H_
+
+#include <jz_core/Matrix4.h>
+#include <jz_core/Memory.h>
+#include <vector>
+
+namespace jz
+{
+    namespace engine_3D
+    {
+
+        class SceneNode;
+
+        // Local, world and normal transforms of every SceneNode, kept in parallel arrays
+        // instead of inline in each node. Entries are grouped by tree and sorted by depth
+        // within a tree, so a parent always precedes its children and updating a tree is
+        // one linear pass per level. The order is rebuilt lazily after the hierarchy
+        // changes; nodes refer to their entry through a slot that does not move.
+        class TransformHierarchy sealed
+        {
+        public:
+            typedef u32 Slot;
+
+            static const u32 kNone = 0xFFFFFFFF;
+
+            // Levels smaller than kParallelThreshold are updated on the calling thread.
+            static const size_t kParallelGrainSize = (1 << 8);
+            static const size_t kParallelThreshold = (1 << 11);
+
+            TransformHierarchy();
+            ~TransformHierarchy();
+
+            Slot Add(SceneNode* apNode);
+            void Reserve(size_t aAdditional);
+            void Remove(Slot aSlot);
+            void SetParent(Slot aSlot, Slot aParent);
+
+            unatural GetFlags(Slot aSlot) const { return mFlags[mSlots[aSlot]]; }
+            unatural& GetFlags(Slot aSlot) { return mFlags[mSlots[aSlot]]; }
+            const Matrix4& GetLocal(Slot aSlot) const { return mLocal[mSlots[aSlot]]; }
+            Matrix4& GetLocal(Slot aSlot) { return mLocal[mSlots[aSlot]]; }
+            const Matrix4& GetWit(Slot aSlot) const { return mWit[mSlots[aSlot]]; }
+            Matrix4& GetWit(Slot aSlot) { return mWit[mSlots[aSlot]]; }
+            const Matrix4& GetWorld(Slot aSlot) const { return mWorld[mSlots[aSlot]]; }
+            Matrix4& GetWorld(Slot aSlot) { return mWorld[mSlots[aSlot]]; }
+
+            // Updates aSlot and its descendants, with aParentWorld as the parent transform
+            // of aSlot. SceneNodeFlags::kChanged is set on every entry in the subtree that
+            // moved or has a descendant that moved, and cleared on the rest. Returns true
+            // if aSlot has the flag.
+            bool Update(Slot aSlot, const Matrix4& aParentWorld, bool abParentChanged);
+
+        private:
+            TransformHierarchy(const TransformHierarchy&);
+            TransformHierarchy& operator=(const TransformHierarchy&);
+
+            enum State
+            {
+                kStateOutside = 0,
+                kStateClean = 1,
+                kStateChanged = 2
+            };
+
+            struct LevelBody
+            {
+                void operator()(size_t aBegin, size_t aEnd) { pThis->_UpdateRange(Start, aBegin, aEnd); }
+
+                TransformHierarchy* pThis;
+                u32 Start;
+            };
+
+            MemoryBuffer<Matrix4> mLocal;
+            MemoryBuffer<Matrix4> mWit;
+            MemoryBuffer<Matrix4> mWorld;
+            vector<unatural> mFlags;
+            vector<SceneNode*> mNodes;
+            vector<Slot> mParentSlots;
+            vector<Slot> mDenseToSlot;
+
+            // Valid while mbSorted. mParents and mRoots are dense indices, mTreeEnds is
+            // only meaningful at a root entry.
+            vector<u32> mDepths;
+            vector<u32> mParents;
+            vector<u32> mRoots;
+            vector<u32> mTreeEnds;
+            vector<u8> mStates;
+            bool mbSorted;
+
+            vector<u32> mSlots;
+            vector<Slot> mFreeSlots;
+
+            void _Sort();
+            bool _UpdateEntry(u32 i, const Matrix4& aParentWorld, bool abParentChanged);
+            void _UpdateRange(u32 aStart, size_t aBegin, size_t aEnd);
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,492 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_filesystem/BlockCodec.h>
+#include <zlib/zlib.h>
+#include <zlib/zutil.h>
+#include <ctime>
+
+namespace jz
+{
+    namespace filesystem
+    {
+
+        #pragma region Store
+        class StoreCodec sealed : public IBlockCodec
+        {
+            public:
+                virtual const char* GetName() const override { return "store"; }
+
+                // Never smaller than the input, so blocks are always written as is.
+                virtual size_t Encode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    return 0u;
+                }
+
+                virtual size_t Decode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    if (aInSize > aAvailableOut) { return 0u; }
+
+                    memcpy(apOut, apIn, aInSize);
+                    return aInSize;
+                }
+        };
+        #pragma endregion
+
+        #pragma region Deflate
+        class DeflateCodec sealed : public IBlockCodec
+        {
+            public:
+                virtual const char* GetName() const override { return "deflate"; }
+
+                virtual size_t Encode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    z_stream stream;
+                    memset(&stream, 0, sizeof(z_stream));
+                    stream.next_in = (Bytef*)apIn;
+                    stream.avail_in = aInSize;
+                    stream.next_out = apOut;
+                    stream.avail_out = aAvailableOut;
+                    stream.zalloc = (alloc_func)null;
+                    stream.zfree = (free_func)null;
+                    
+                    int ret = deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+                    
+                    if (ret == Z_OK)
+                    {
+                        ret = deflate(&stream, Z_FINISH);
+                        deflateEnd(&stream);
+                    }
+                    
+                    return (ret == Z_STREAM_END) ? stream.total_out : 0u;
+                }
+
+                virtual size_t Decode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    z_stream stream;
+                    memset(&stream, 0, sizeof(z_stream));
+                    stream.next_in = (Bytef*)apIn;
+                    stream.avail_in = aInSize;
+                    stream.next_out = apOut;
+                    stream.avail_out = aAvailableOut;
+                    stream.zalloc = (alloc_func)null;
+                    stream.zfree = (free_func)null;
+
+                    int ret = inflateInit2(&stream, -MAX_WBITS);
+                    
+                    if (ret == Z_OK)
+                    {
+                        ret = inflate(&stream, Z_FINISH);
+                        inflateEnd(&stream);
+                    }
+                    
+                    return (ret == Z_STREAM_END) ? stream.total_out : 0u;
+                }
+        };
+        #pragma endregion
+
+        #pragma region Lz
+        // A sequence is a token byte (literal count in the high nibble, match length - 4
+        // in the low nibble, 15 meaning more length bytes follow), the literals, then a
+        // 16-bit little endian offset and the extra match length bytes. The last sequence
+        // has literals only and ends the block.
+        static const size_t kLzMinMatch = 4u;
+        static const size_t kLzLastLiterals = 5u;
+        static const size_t kLzMatchFindLimit = 12u;
+        static const size_t kLzMaxOffset = 65535u;
+
+        __inline u32 _LzRead32(const u8* p)
+        {
+            u32 ret;
+            memcpy(&ret, p, sizeof(u32));
+
+            return ret;
+        }
+
+        __inline u32 _LzHash(u32 v, u32 aBits)
+        {
+            return ((v * 2654435761u) >> (32u - aBits));
+        }
+
+        static u8* _LzWriteLength(u8* op, size_t aLength)
+        {
+            for (; aLength >= 255u; aLength -= 255u) { *op++ = 255u; }
+            *op++ = (u8)aLength;
+
+            return op;
+        }
+
+        // Returns the new output position, or null if the sequence does not fit.
+        static u8* _LzEmit(const u8* apLiterals, size_t aLiterals, size_t aOffset, size_t aMatchLength, u8* op, const u8* apOutEnd)
+        {
+            const size_t kWorstCase = (1u + (aLiterals / 255u) + 1u + aLiterals + 2u + (aMatchLength / 255u) + 1u);
+            if ((size_t)(apOutEnd - op) < kWorstCase) { return null; }
+
+            u8* pToken = op++;
+            u8 token = (u8)(Min(aLiterals, (size_t)15u) << 4u);
+            if (aLiterals >= 15u) { op = _LzWriteLength(op, (aLiterals - 15u)); }
+
+            memcpy(op, apLiterals, aLiterals);
+            op += aLiterals;
+
+            if (aMatchLength > 0u)
+            {
+                *op++ = (u8)(aOffset & 0xFF);
+                *op++ = (u8)(aOffset >> 8u);
+
+                const size_t kLength = (aMatchLength - kLzMinMatch);
+                token |= (u8)Min(kLength, (size_t)15u);
+                if (kLength >= 15u) { op = _LzWriteLength(op, (kLength - 15u)); }
+            }
+
+            *pToken = token;
+
+            return op;
+        }
+
+        static bool _LzReadLength(const u8*& rp, const u8* apEnd, size_t& arLength)
+        {
+            while (rp < apEnd)
+            {
+                const u8 kByte = *rp++;
+                arLength += kByte;
+
+                if (kByte != 255u) { return true; }
+            }
+
+            return false;
+        }
+
+        static size_t _LzDecode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut)
+        {
+            const u8* ip = apIn;
+            const u8* const kpInEnd = (apIn + aInSize);
+            u8* op = apOut;
+            u8* const kpOutEnd = (apOut + aAvailableOut);
+
+            while (ip < kpInEnd)
+            {
+                const u8 kToken = *ip++;
+
+                size_t literals = (kToken >> 4u);
+                if (literals == 15u && !_LzReadLength(ip, kpInEnd, literals)) { return 0u; }
+                if ((size_t)(kpInEnd - ip) < literals || (size_t)(kpOutEnd - op) < literals) { return 0u; }
+
+                memcpy(op, ip, literals);
+                ip += literals;
+                op += literals;
+
+                if (ip == kpInEnd) { break; }
+                if ((kpInEnd - ip) < 2) { return 0u; }
+
+                const size_t kOffset = (size_t)(ip[0] | (ip[1] << 8u));
+                ip += 2;
+                if (kOffset == 0u || kOffset > (size_t)(op - apOut)) { return 0u; }
+
+                size_t length = (kToken & 15u);
+                if (length == 15u && !_LzReadLength(ip, kpInEnd, length)) { return 0u; }
+                length += kLzMinMatch;
+                if ((size_t)(kpOutEnd - op) < length) { return 0u; }
+
+                const u8* pMatch = (op - kOffset);
+                if (kOffset >= length)
+                {
+                    memcpy(op, pMatch, length);
+                }
+                else
+                {
+                    // Overlapping, repeats the last kOffset bytes.
+                    for (size_t i = 0u; i < length; i++) { op[i] = pMatch[i]; }
+                }
+
+                op += length;
+            }
+
+            return (size_t)(op - apOut);
+        }
+
+        class LzCodec sealed : public IBlockCodec
+        {
+            public:
+                virtual const char* GetName() const override { return "lz"; }
+
+                virtual size_t Encode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    // 8KB on the stack, plenty for a block. Positions are stored in 16 bits,
+                    // inputs over 64KB still encode correctly but find fewer matches.
+                    static const u32 kHashBits = 12u;
+                    u16 table[1 << kHashBits];
+
+                    const u8* ip = apIn;
+                    const u8* anchor = apIn;
+                    const u8* const kpEnd = (apIn + aInSize);
+                    u8* op = apOut;
+                    const u8* const kpOutEnd = (apOut + aAvailableOut);
+
+                    if (aInSize > kLzMatchFindLimit)
+                    {
+                        memset(table, 0, sizeof(table));
+
+                        const u8* const kpMatchLimit = (kpEnd - kLzLastLiterals);
+                        const u8* const kpFindLimit = (kpEnd - kLzMatchFindLimit);
+
+                        while (ip <= kpFindLimit)
+                        {
+                            const u32 kValue = _LzRead32(ip);
+                            const u32 kHash = _LzHash(kValue, kHashBits);
+                            const u8* pCandidate = (apIn + table[kHash]);
+                            table[kHash] = (u16)(ip - apIn);
+
+                            if (pCandidate < ip && (size_t)(ip - pCandidate) <= kLzMaxOffset && _LzRead32(pCandidate) == kValue)
+                            {
+                                const u8* p = (ip + kLzMinMatch);
+                                const u8* q = (pCandidate + kLzMinMatch);
+                                while (p < kpMatchLimit && *p == *q) { p++; q++; }
+
+                                op = _LzEmit(anchor, (size_t)(ip - anchor), (size_t)(ip - pCandidate), (size_t)(p - ip), op, kpOutEnd);
+                                if (!op) { return 0u; }
+
+                                ip = p;
+                                anchor = p;
+                            }
+                            else
+                            {
+                                // Step faster through data that is not matching.
+                                ip += (1u + ((ip - anchor) >> 6u));
+                            }
+                        }
+                    }
+
+                    op = _LzEmit(anchor, (size_t)(kpEnd - anchor), 0u, 0u, op, kpOutEnd);
+
+                    return (op) ? (size_t)(op - apOut) : 0u;
+                }
+
+                virtual size_t Decode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    return _LzDecode(apIn, aInSize, apOut, aAvailableOut);
+                }
+        };
+
+        class LzHighCodec sealed : public IBlockCodec
+        {
+            public:
+                virtual const char* GetName() const override { return "lz-high"; }
+
+                virtual size_t Encode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    static const u32 kHashBits = 15u;
+                    static const size_t kMaxAttempts = 64u;
+
+                    const size_t kFindLimit = (aInSize > kLzMatchFindLimit) ? (aInSize - kLzMatchFindLimit) : 0u;
+                    const size_t kMatchLimit = (aInSize > kLzLastLiterals) ? (aInSize - kLzLastLiterals) : 0u;
+
+                    u8* op = apOut;
+                    const u8* const kpOutEnd = (apOut + aAvailableOut);
+                    size_t anchor = 0u;
+
+                    if (aInSize > kLzMatchFindLimit)
+                    {
+                        vector<s32> head((1 << kHashBits), -1);
+                        vector<s32> prev(aInSize, -1);
+                        size_t inserted = 0u;
+
+                        size_t ip = 0u;
+                        size_t length = 0u;
+                        size_t offset = 0u;
+                        while (ip <= kFindLimit)
+                        {
+                            _FindMatch(apIn, ip, kMatchLimit, kMaxAttempts, kHashBits, head, prev, inserted, length, offset);
+                            if (length < kLzMinMatch) { ip++; continue; }
+
+                            // Lazy matching, defer to the next position while it matches longer.
+                            size_t nextLength = 0u;
+                            size_t nextOffset = 0u;
+                            while (ip + 1u <= kFindLimit)
+                            {
+                                _FindMatch(apIn, (ip + 1u), kMatchLimit, kMaxAttempts, kHashBits, head, prev, inserted, nextLength, nextOffset);
+                                if (nextLength <= length) { break; }
+
+                                ip++;
+                                length = nextLength;
+                                offset = nextOffset;
+                            }
+
+                            op = _LzEmit((apIn + anchor), (ip - anchor), offset, length, op, kpOutEnd);
+                            if (!op) { return 0u; }
+
+                            ip += length;
+                            anchor = ip;
+                        }
+                    }
+
+                    op = _LzEmit((apIn + anchor), (aInSize - anchor), 0u, 0u, op, kpOutEnd);
+
+                    return (op) ? (size_t)(op - apOut) : 0u;
+                }
+
+                virtual size_t Decode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const override
+                {
+                    return _LzDecode(apIn, aInSize, apOut, aAvailableOut);
+                }
+
+            private:
+                static void _FindMatch(const u8* apIn, size_t aPos, size_t aMatchLimit, size_t aMaxAttempts, u32 aHashBits,
+                    vector<s32>& arHead, vector<s32>& arPrev, size_t& arInserted, size_t& arLength, size_t& arOffset)
+                {
+                    for (; arInserted <= aPos; arInserted++)
+                    {
+                        const u32 kHash = _LzHash(_LzRead32(apIn + arInserted), aHashBits);
+                        arPrev[arInserted] = arHead[kHash];
+                        arHead[kHash] = (s32)arInserted;
+                    }
+
+                    arLength = 0u;
+                    arOffset = 0u;
+
+                    const u8* const kpPos = (apIn + aPos);
+                    s32 candidate = arPrev[aPos];
+                    for (size_t attempt = 0u; candidate >= 0 && attempt < aMaxAttempts; attempt++)
+                    {
+                        const size_t kOffset = (aPos - (size_t)candidate);
+                        if (kOffset > kLzMaxOffset) { break; }
+
+                        const u8* pCandidate = (apIn + candidate);
+                        if (pCandidate[arLength] == kpPos[arLength] && _LzRead32(pCandidate) == _LzRead32(kpPos))
+                        {
+                            size_t length = kLzMinMatch;
+                            while ((aPos + length) < aMatchLimit && pCandidate[length] == kpPos[length]) { length++; }
+
+                            if (length > arLength)
+                            {
+                                arLength = length;
+                                arOffset = kOffset;
+                            }
+                        }
+
+                        candidate = arPrev[candidate];
+                    }
+                }
+        };
+        #pragma endregion
+
+        static const StoreCodec gsStoreCodec;
+        static const DeflateCodec gsDeflateCodec;
+        static const LzCodec gsLzCodec;
+        static const LzHighCodec gsLzHighCodec;
+
+        static const IBlockCodec* gspCodecs[Block::kDescriptorCount] =
+        {
+            &gsStoreCodec,
+            &gsDeflateCodec,
+            &gsLzCodec,
+            &gsLzHighCodec
+        };
+
+        const IBlockCodec* BlockCodecs::Get(u16 aDescriptor)
+        {
+            return (aDescriptor < Block::kDescriptorCount) ? gspCodecs[aDescriptor] : null;
+        }
+
+        void BlockCodecs::Register(u16 aDescriptor, const IBlockCodec* apCodec)
+        {
+            JZ_E_ON_FAIL(aDescriptor < Block::kDescriptorCount, "descriptor out of range.");
+            gspCodecs[aDescriptor] = apCodec;
+        }
+
+        void BlockCodecs::Benchmark(const ByteBuffer& aCorpus, size_t aBlockDataSize, vector<BlockCodecStats>& arStats)
+        {
+            // Decode is repeated until it has run this long, single passes over a small
+            // corpus finish below clock() resolution.
+            static const double kMinimumDecodeSeconds = 0.25;
+
+            JZ_E_ON_FAIL(aBlockDataSize > 0u, "block size must be non-zero.");
+
+            const size_t kSize = aCorpus.size();
+            const size_t kBlockCount = ((kSize + aBlockDataSize - 1u) / aBlockDataSize);
+
+            ByteBuffer encoded;
+            encoded.resize(kBlockCount * aBlockDataSize);
+            ByteBuffer decoded;
+            decoded.resize(kSize);
+            vector<size_t> sizes(kBlockCount);
+
+            arStats.clear();
+            for (u16 descriptor = 0u; descriptor < Block::kDescriptorCount; descriptor++)
+            {
+                const IBlockCodec* pCodec = gspCodecs[descriptor];
+                if (!pCodec) { continue; }
+
+                BlockCodecStats stats;
+                stats.Descriptor = descriptor;
+                stats.pName = pCodec->GetName();
+                stats.InSize = kSize;
+                stats.OutSize = 0u;
+
+                // Same policy as FileSystem::Write(), blocks that do not shrink are stored.
+                const clock_t kEncodeStart = clock();
+                for (size_t i = 0u; i < kBlockCount; i++)
+                {
+                    const size_t kOffset = (i * aBlockDataSize);
+                    const size_t kBlockSize = Min(aBlockDataSize, (kSize - kOffset));
+
+                    sizes[i] = pCodec->Encode((aCorpus.Get() + kOffset), kBlockSize, (encoded.Get() + kOffset), (kBlockSize - 1u));
+                    stats.OutSize += (sizes[i] > 0u) ? sizes[i] : kBlockSize;
+                }
+                const double kEncodeSeconds = (double)(clock() - kEncodeStart) / (double)CLOCKS_PER_SEC;
+
+                size_t passes = 0u;
+                double decodeSeconds = 0.0;
+                const clock_t kDecodeStart = clock();
+                do
+                {
+                    for (size_t i = 0u; i < kBlockCount; i++)
+                    {
+                        const size_t kOffset = (i * aBlockDataSize);
+                        const size_t kBlockSize = Min(aBlockDataSize, (kSize - kOffset));
+
+                        if (sizes[i] > 0u)
+                        {
+                            JZ_E_ON_FAIL(pCodec->Decode((encoded.Get() + kOffset), sizes[i], (decoded.Get() + kOffset), kBlockSize) == kBlockSize, "codec round trip failed.");
+                        }
+                        else
+                        {
+                            memcpy((decoded.Get() + kOffset), (aCorpus.Get() + kOffset), kBlockSize);
+                        }
+                    }
+
+                    passes++;
+                    decodeSeconds = (double)(clock() - kDecodeStart) / (double)CLOCKS_PER_SEC;
+                } while (decodeSeconds < kMinimumDecodeSeconds);
+
+                JZ_E_ON_FAIL(kSize == 0u || memcmp(decoded.Get(), aCorpus.Get(), kSize) == 0, "codec round trip failed.");
+
+                static const double kMegabyte = (1024.0 * 1024.0);
+                stats.EncodeMBps = (kEncodeSeconds > 0.0) ? ((double)kSize / kMegabyte) / kEncodeSeconds : 0.0;
+                stats.DecodeMBps = (decodeSeconds > 0.0) ? ((double)(kSize * passes) / kMegabyte) / decodeSeconds : 0.0;
+
+                arStats.push_back(stats);
+            }
+        }
+
+    }
+}
@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef JZ_FILESYSTEM_BLOCK_CODEC_H_
+#define JZ_FILESYSTEM_BLOCK_CODEC_H_
+
+#include <jz_core/Memory.h>
+#include <vector>
+
+namespace jz
+{
+    namespace filesystem
+    {
+
+        namespace Block
+        {
+            enum Descriptor
+            {
+                kDescriptorUncompressed = 0,
+                kDescriptorDeflated = 1,
+                kDescriptorLz = 2,
+                kDescriptorLzHigh = 3,
+                kDescriptorCount = 16
+            };
+            
+            enum Type
+            {
+                kTypeNone = 0,
+                kTypeStart = 1,
+                kTypeInternal = 2,
+                kTypeEnd = 3
+            };
+        }
+
+        /// <summary>
+        /// Compresses and decompresses single blocks. Implementations must be stateless,
+        /// since blocks are encoded and decoded concurrently on job threads.
+        /// </summary>
+        class IBlockCodec abstract
+        {
+            public:
+                virtual ~IBlockCodec() {}
+
+                virtual const char* GetName() const = 0;
+
+                // Both return the number of bytes written to apOut, or 0 if the output does
+                // not fit in aAvailableOut or the input is invalid. Neither throws.
+                virtual size_t Encode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const = 0;
+                virtual size_t Decode(const u8* apIn, size_t aInSize, u8* apOut, size_t aAvailableOut) const = 0;
+        };
+
+        struct BlockCodecStats
+        {
+            u16 Descriptor;
+            const char* pName;
+            size_t InSize;
+            size_t OutSize;
+            double EncodeMBps;
+            double DecodeMBps;
+
+            float GetRatio() const { return (OutSize > 0u) ? ((float)InSize / (float)OutSize) : 0.0f; }
+        };
+
+        /// <summary>
+        /// Registry of codecs keyed by Block::Descriptor.
+        /// </summary>
+        /// <remarks>
+        /// kDescriptorLz is an LZ77 byte format in the style of LZ4: greedy single-probe
+        /// matching, decode cost dominated by memcpy. kDescriptorLzHigh writes the same
+        /// format from a hash chain search with lazy matching, trading encode time for
+        /// ratio while decoding at the same speed. kDescriptorDeflated is zlib at maximum
+        /// compression, for the best ratio and the slowest decode.
+        /// </remarks>
+        class BlockCodecs sealed
+        {
+            public:
+                // null if no codec is registered for aDescriptor.
+                static const IBlockCodec* Get(u16 aDescriptor);
+                static void Register(u16 aDescriptor, const IBlockCodec* apCodec);
+
+                // Compresses aCorpus in blocks of aBlockDataSize with every registered codec
+                // and measures encode and decode throughput, for choosing a write policy.
+                // Run from jz_app_benchmark --codecs.
+                static void Benchmark(const ByteBuffer& aCorpus, size_t aBlockDataSize, vector<BlockCodecStats>& arStats);
+
+            private:
+                BlockCodecs();
+        };
+
+    }
+}
+
+#endif
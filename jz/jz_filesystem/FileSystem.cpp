@@ -20,85 +20,246 @@
 // THE SOFTWARE.
 // 
 
-#include <jz_core/CRC32.h>
+#include <jz_core/Atomic.h>
+#include <jz_core/Crc32.h>
 #include <jz_core/StringUtility.h>
 #include <jz_filesystem/FileSystem.h>
+#include <jz_system/Jobs.h>
 #include <sys/stat.h>
-#include <zlib/zlib.h>
-#include <zlib/zutil.h>
+#include <cstddef>
 #include <ctime>
 
+#if JZ_PLATFORM_WINDOWS
+#   include <jz_system/Win32.h>
+#   include <io.h>
+#else
+#   include <unistd.h>
+#   define _fseeki64 fseeko
+#   define _ftelli64 ftello
+#endif
+
 namespace jz
 {
     namespace filesystem
     {
 
-        static unatural _Deflate(const u8* pIn, size_t aInSize, u8* pOut, size_t aAvailableOut)
+        // Blocks handed to one job. Encoding a block with deflate or lz-high costs far
+        // more than scheduling it, so keep ranges short to spread large files widely.
+        static const size_t kBlocksPerJob = 4u;
+
+        template <typename T>
+        static void _ForEachBlock(T& aBody, size_t aBlockCount)
         {
-            z_stream stream;
-            memset(&stream, 0, sizeof(z_stream));
-            stream.next_in = (Bytef*)pIn;
-            stream.avail_in = aInSize;
-            stream.next_out = pOut;
-            stream.avail_out = aAvailableOut;
-            stream.zalloc = (alloc_func)null;
-            stream.zfree = (alloc_func)null;
-            
-            int ret = deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
-            
-            if (ret == Z_OK)
+            if (system::Jobs::GetSingletonExists())
             {
-                ret = deflate(&stream, Z_FINISH);
-                deflateEnd(&stream);
-                
-                if (ret == Z_STREAM_END)
+                system::Jobs::GetSingleton().ParallelFor(aBody, 0u, aBlockCount, kBlocksPerJob);
+            }
+            else
+            {
+                aBody(0u, aBlockCount);
+            }
+        }
+
+        // fflush() only hands the data to the OS, this also waits for it to reach the disk.
+        static bool _Sync(FILE* p)
+        {
+            if (fflush(p) != 0) { return false; }
+
+    #       if JZ_PLATFORM_WINDOWS
+                return (FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(p))) != FALSE);
+    #       else
+                return (fsync(fileno(p)) == 0);
+    #       endif
+        }
+
+        // Every block holds at most kBlockDataSize bytes of the file before compression,
+        // so block i always expands to offset (i * kBlockDataSize). That makes blocks
+        // independent units that can be encoded and decoded in any order.
+        static size_t _GetBlockCount(size_t aFileSize, size_t aBlockDataSize)
+        {
+            return ((aFileSize + aBlockDataSize - 1u) / aBlockDataSize);
+        }
+
+        struct BlockEncoder
+        {
+            const IBlockCodec* pCodec;
+            const u8* pIn;
+            u8* pOut;
+            u16* pSizes;
+            size_t BlockDataSize;
+            size_t FileSize;
+
+            // pSizes[i] is the encoded size of block i, or 0 if it is stored as is.
+            void operator()(size_t aBegin, size_t aEnd)
+            {
+                for (size_t i = aBegin; i < aEnd; i++)
                 {
-                    ret = Z_OK;
+                    const size_t kOffset = (i * BlockDataSize);
+                    const size_t kSize = Min(BlockDataSize, (FileSize - kOffset));
+
+                    pSizes[i] = (u16)pCodec->Encode((pIn + kOffset), kSize, (pOut + kOffset), (kSize - 1u));
                 }
-                
-                deflateEnd(&stream);
             }
-            
-            JZ_E_ON_FAIL(ret == Z_OK, "deflation failed.");
-            
-            return stream.total_in;
-        }
+        };
 
-        static unatural _Inflate(const u8* pIn, size_t aInSize, u8* pOut, size_t aAvailableOut)
+        struct BlockDecoder
         {
-            z_stream stream;
-            memset(&stream, 0, sizeof(z_stream));
-            stream.next_in = (Bytef*)pIn;
-            stream.avail_in = aInSize;
-            stream.next_out = pOut;
-            stream.avail_out = aAvailableOut;
-            stream.zalloc = (alloc_func)null;
-            stream.zfree = (alloc_func)null;
-
-            int ret = inflateInit2(&stream, -MAX_WBITS);
-            
-            if (ret == Z_OK)
+            const u8* const* ppBlocks;
+            u8* pOut;
+            size_t BlockDataSize;
+            size_t FileSize;
+            volatile s32 Failures;
+
+            void operator()(size_t aBegin, size_t aEnd)
             {
-                ret = inflate(&stream, Z_FINISH);
-                inflateEnd(&stream);
-                
-                if (ret == Z_STREAM_END)
+                for (size_t i = aBegin; i < aEnd; i++)
                 {
-                    ret = Z_OK;
+                    const BlockHeader& header = *reinterpret_cast<const BlockHeader*>(ppBlocks[i]);
+                    const u8* pData = (ppBlocks[i] + sizeof(BlockHeader));
+                    const size_t kOffset = (i * BlockDataSize);
+                    const size_t kSize = Min(BlockDataSize, (FileSize - kOffset));
+
+                    const IBlockCodec* pCodec = BlockCodecs::Get(header.Descriptor);
+
+                    size_t size = 0u;
+                    if (pCodec && Crc32((void_p)pData, header.DataSize) == header.CRC)
+                    {
+                        size = pCodec->Decode(pData, header.DataSize, (pOut + kOffset), kSize);
+                    }
+
+                    if (size != kSize) { AtomicIncrement(&Failures); }
                 }
-                
-                inflateEnd(&stream);
             }
-            
-            JZ_E_ON_FAIL(ret == Z_OK, "inflation failed.");
-            
-            return stream.total_out;
+        };
+
+        // Reads the blocks of one file as a single run from its first block, which is where
+        // Write() puts them unless the pack is fragmented. Blocks that turn out to be
+        // elsewhere are read one at a time on the AsyncIO worker before decoding.
+        class BlockChainRead sealed
+        {
+        public:
+            BlockChainRead(const system::AsyncFilePtr& apFile, size_t aBlockSize, size_t aBlockCount, u64 aFirstBlock, u8* apOut, size_t aFileSize, const system::AsyncIO::Callback& aCallback)
+                : mpFile(apFile), mBlocks(aBlockSize * aBlockCount), mBlockSize(aBlockSize), mBlockCount(aBlockCount),
+                  mFirstBlock(aFirstBlock), mpOut(apOut), mFileSize(aFileSize), mCallback(aCallback)
+            {}
+
+            u8* GetBlocks() { return mBlocks.Get(); }
+
+            void OnRead(system::AsyncIO::Result& arResult)
+            {
+                // A short run is not an error, the rest is read by following the chain.
+                if (arResult.State != system::AsyncIO::kCancelled)
+                {
+                    if (_Decode(arResult.Bytes))
+                    {
+                        arResult.State = system::AsyncIO::kComplete;
+                        arResult.Bytes = mFileSize;
+                    }
+                    else
+                    {
+                        arResult.State = system::AsyncIO::kFailed;
+                        arResult.Bytes = 0u;
+                    }
+                }
+
+                arResult.pOut = mpOut;
+
+                system::AsyncIO::Callback callback(mCallback);
+                delete this;
+
+                if (callback) { callback(arResult); }
+            }
+
+        private:
+            BlockChainRead(const BlockChainRead&);
+            BlockChainRead& operator=(const BlockChainRead&);
+
+            system::AsyncFilePtr mpFile;
+            ByteBuffer mBlocks;
+            size_t mBlockSize;
+            size_t mBlockCount;
+            u64 mFirstBlock;
+            u8* mpOut;
+            size_t mFileSize;
+            system::AsyncIO::Callback mCallback;
+
+            bool _Decode(size_t aRunSize)
+            {
+                const size_t kBlockDataSize = (mBlockSize - sizeof(BlockHeader));
+                vector<const u8*> pointers(mBlockCount);
+
+                u64 filePos = mFirstBlock;
+                for (size_t i = 0u; i < mBlockCount; i++)
+                {
+                    u8* p = (mBlocks.Get() + (i * mBlockSize));
+
+                    const bool kbInRun = (filePos == (mFirstBlock + (i * mBlockSize)) && ((i + 1u) * mBlockSize) <= aRunSize);
+                    if (!kbInRun && mpFile->ReadAt(filePos, p, mBlockSize) != mBlockSize) { return false; }
+
+                    const BlockHeader& header = *reinterpret_cast<const BlockHeader*>(p);
+                    if (header.DataSize > kBlockDataSize) { return false; }
+
+                    pointers[i] = p;
+                    filePos = header.NextBlock;
+                }
+
+                // Serial, Jobs::Wait() cannot be called from an AsyncIO thread. Separate
+                // requests still decode in parallel on separate workers.
+                BlockDecoder decoder = { &pointers[0], mpOut, kBlockDataSize, mFileSize, 0 };
+                decoder(0u, mBlockCount);
+
+                return (decoder.Failures == 0);
+            }
+        };
+
+        void FileView::CopyTo(ByteBuffer& arBuffer) const
+        {
+            arBuffer.resize(mSize);
+
+            size_t bufferPos = 0u;
+            const size_t kSpans = mSpans.size();
+            for (size_t i = 0u; i < kSpans; i++)
+            {
+                const FileSpan& span = mSpans[i];
+                for (u32 j = 0u; j < span.BlockCount; j++)
+                {
+                    size_t size = 0u;
+                    const u8* p = GetBlockData(span, j, size);
+                    memcpy((void_p)(arBuffer.Get() + bufferPos), p, size);
+                    bufferPos += size;
+                }
+            }
+
+            JZ_ASSERT(bufferPos == mSize);
         }
-        
-        FileSystem::FileSystem(const char* apFileSystemFilename)
-            : mpFileSystemHandle(null), mFileSystemSize(0u), mCurrentPos(0u)
+
+        const u8* FileView::GetBlockData(const FileSpan& aSpan, u32 aBlock, size_t& arSize) const
         {
-            _Open(apFileSystemFilename);
+            const u8* pBlock = (aSpan.pBlocks + (aBlock * mBlockSize));
+            arSize = reinterpret_cast<const BlockHeader*>(pBlock)->DataSize;
+
+            return (pBlock + sizeof(BlockHeader));
+        }
+
+        const u8* FileView::GetContiguousData() const
+        {
+            if (mSpans.size() == 1u && mSpans[0].BlockCount == 1u)
+            {
+                return (mSpans[0].pBlocks + sizeof(BlockHeader));
+            }
+            else
+            {
+                return null;
+            }
+        }
+
+        FileSystem::FileSystem(const char* apFileSystemFilename, Mode aMode)
+            : mFilename(apFileSystemFilename), mpFileSystemHandle(null), mpJournalHandle(null), mJournalRecords(0u),
+              mFileSystemSize(0u), mCurrentPos(0u),
+              mDefaultCodec(Block::kDescriptorLz)
+        {
+            if (aMode == kReadOnlyMapped) { _OpenMapped(apFileSystemFilename); }
+            else { _Open(apFileSystemFilename); }
         }
         
         FileSystem::~FileSystem()
@@ -108,15 +269,23 @@ namespace jz
         
         void FileSystem::_Destroy()
         {
-            try
+            if (!IsMapped())
             {
-                Commit();
+                try
+                {
+                    Commit();
+                }
+                catch (...)
+                {}
             }
-            catch (...)
-            {}
+
+            mMapping.Close();
+            mpAsyncFile.Reset();
 
             mFileSystemSize = 0u;     
             mCurrentPos = 0u;
+            mJournalRecords = 0u;
+            mDirtyPages.clear();
 
             memset((void_p)&mFileSystemHeader, 0, sizeof(FileSystemHeader));
 
@@ -125,6 +294,12 @@ namespace jz
                 fclose(mpFileSystemHandle);
                 mpFileSystemHandle = null;
             }
+
+            if (mpJournalHandle)
+            {
+                fclose(mpJournalHandle);
+                mpJournalHandle = null;
+            }
         }
         
         time_t FileSystem::GetModifiedTime(const FileTag& aTag) const
@@ -143,14 +318,57 @@ namespace jz
             }
         }
 
+        u16 FileSystem::GetCodecForExtension(const char* apExtension) const
+        {
+            string extension(apExtension);
+            StringUtility::MakeLowercase(extension);
+
+            ExtensionCodecs::const_iterator I = mExtensionCodecs.find(extension);
+
+            return (I != mExtensionCodecs.end()) ? I->second : mDefaultCodec;
+        }
+
+        void FileSystem::SetCodecForExtension(const char* apExtension, u16 aDescriptor)
+        {
+            JZ_E_ON_FAIL(BlockCodecs::Get(aDescriptor), "no codec registered for descriptor.");
+
+            string extension(apExtension);
+            StringUtility::MakeLowercase(extension);
+
+            mExtensionCodecs[extension] = aDescriptor;
+        }
+
+        void FileSystem::SetDefaultCodec(u16 aDescriptor)
+        {
+            JZ_E_ON_FAIL(BlockCodecs::Get(aDescriptor), "no codec registered for descriptor.");
+            mDefaultCodec = aDescriptor;
+        }
+
     #   if JZ_LITTLE_ENDIAN
             void FileSystem::Commit()
             {
+                JZ_E_ON_FAIL(!IsMapped(), "file system is read-only.");
+
                 _WriteFileSystemHeader();
-                _WriteFileTable();
-                _Flush();
+                _WriteDirtyPages();
+                JZ_E_ON_FAIL(_Sync(mpFileSystemHandle), "sync failed.");
+
+                // The table on disk is now current, so the journal can be dropped.
+                if (mJournalRecords > 0u)
+                {
+                    _ReopenJournal("wb");
+                    mJournalRecords = 0u;
+                }
             }
             
+            void FileSystem::Sync()
+            {
+                JZ_E_ON_FAIL(!IsMapped(), "file system is read-only.");
+
+                JZ_E_ON_FAIL(_Sync(mpFileSystemHandle), "sync failed.");
+                JZ_E_ON_FAIL(_Sync(mpJournalHandle), "journal sync failed.");
+            }
+
             bool FileSystem::GetExists(const FileTag& aTag) const
             {
                 const size_t kFileTableSize = mFileTable.size();
@@ -175,13 +393,15 @@ namespace jz
 
             void FileSystem::Delete(const FileTag& aTag)
             {
+                JZ_E_ON_FAIL(!IsMapped(), "file system is read-only.");
+
                 u32 index;
                 if (_FindFileIndex(aTag, index))
                 {
                     mFileTable[index].Hash = 0u;
                     mFileTable[index].ModifiedTime = 0u;
                     
-                    Commit();
+                    _LogFileEntry(index);
                 }
             }
 
@@ -191,72 +411,180 @@ namespace jz
                 JZ_E_ON_FAIL(_FindFileIndex(aTag, index), "file not found.");
                 const FileTableEntry& entry = mFileTable[index];
 
+                if (IsMapped())
+                {
+                    _ReadMapped(entry, arBuffer);
+                    return;
+                }
+
                 const u32 kFileSize = entry.FileSize;
-        
-                arBuffer.resize(kFileSize);
-                
+                const size_t kBlockSize = mBlockBuffer.GetSizeInBytes();
+                const size_t kBlockDataSize = (kBlockSize - sizeof(BlockHeader));
+                const size_t kBlockCount = _GetBlockCount(kFileSize, kBlockDataSize);
+
+                // Pull the chain in serially, then decode all blocks at once.
+                ByteBuffer blocks;
+                blocks.resize(kBlockCount * kBlockSize);
+                vector<const u8*> pointers(kBlockCount);
+
                 u64 filePos = entry.FirstBlockPosition;
-                size_t bufferPos = 0u;
+                for (size_t i = 0u; i < kBlockCount; i++)
+                {
+                    u8* p = (blocks.Get() + (i * kBlockSize));
+                    _ReadAt(p, kBlockSize, filePos);
+                    pointers[i] = p;
 
-                const BlockHeader& header = _GetBlockHeader();            
-                const size_t kBlockBufferSize = mBlockBuffer.GetSizeInBytes();
-                u8* const kpBlockData = (mBlockBuffer.Get() + sizeof(BlockHeader));
+                    const BlockHeader& header = *reinterpret_cast<const BlockHeader*>(p);
+                    JZ_E_ON_FAIL(header.DataSize <= kBlockDataSize, "block data size is too big.");
+                    filePos = header.NextBlock;
+                }
+
+                _DecodeBlocks(pointers, kFileSize, arBuffer);
+            }
+              
+            system::AsyncIO::RequestHandle FileSystem::ReadAsync(const FileTag& aTag, ByteBuffer& arBuffer, system::AsyncIO::Priority aPriority, const system::AsyncIO::Callback& aCallback)
+            {
+                u32 index;
+                JZ_E_ON_FAIL(_FindFileIndex(aTag, index), "file not found.");
+                const FileTableEntry& entry = mFileTable[index];
+
+                // Blocks written through stdio must reach the file before another handle
+                // reads them.
+                if (!IsMapped()) { _Flush(); }
+                if (!mpAsyncFile.Get()) { mpAsyncFile.Reset(new system::AsyncFile(mFilename)); }
+
+                const size_t kBlockSize = mBlockBuffer.GetSizeInBytes();
+                const size_t kBlockCount = _GetBlockCount(entry.FileSize, (kBlockSize - sizeof(BlockHeader)));
+
+                arBuffer.resize(entry.FileSize);
+                system::AsyncIO& io = system::AsyncIO::GetSingleton();
+                if (kBlockCount == 0u) { return io.Read(mpAsyncFile, 0u, null, 0u, aPriority, aCallback); }
+
+                const u64 kRunEnd = Min((entry.FirstBlockPosition + (kBlockCount * kBlockSize)), Max(mFileSystemSize, entry.FirstBlockPosition));
+                const size_t kRunSize = (size_t)(kRunEnd - entry.FirstBlockPosition);
+
+                BlockChainRead* p = new BlockChainRead(mpAsyncFile, kBlockSize, kBlockCount, entry.FirstBlockPosition, arBuffer.Get(), entry.FileSize, aCallback);
+
+                try
+                {
+                    return io.Read(mpAsyncFile, entry.FirstBlockPosition, p->GetBlocks(), kRunSize, aPriority,
+                        system::AsyncIO::Callback::Bind<BlockChainRead, &BlockChainRead::OnRead>(p));
+                }
+                catch (...)
+                {
+                    delete p;
+                    throw;
+                }
+            }
+
+            bool FileSystem::View(const FileTag& aTag, FileView& arView) const
+            {
+                JZ_E_ON_FAIL(IsMapped(), "views require a mapped file system.");
+
+                u32 index;
+                JZ_E_ON_FAIL(_FindFileIndex(aTag, index), "file not found.");
+                const FileTableEntry& entry = mFileTable[index];
+
+                const u32 kFileSize = entry.FileSize;
+                const size_t kBlockSize = mBlockBuffer.GetSizeInBytes();
+
+                arView.Clear();
+                arView.mBlockSize = kBlockSize;
+                arView.mSize = kFileSize;
+
+                _PrefetchMapped(entry);
+
+                u64 filePos = entry.FirstBlockPosition;
+                size_t bufferPos = 0u;
 
                 while (bufferPos < kFileSize)
                 {
-                    _ReadBlockAt(filePos);
-                    JZ_E_ON_FAIL(Crc32(kpBlockData, header.DataSize) == header.CRC, "CRC check failed.");
+                    const BlockHeader& header = _GetMappedBlockHeader(filePos);
+                    const u8* pBlock = reinterpret_cast<const u8*>(&header);
+                    const u8* pData = (pBlock + sizeof(BlockHeader));
 
-                    size_t bytesRead = 0u;
-                
-                    if (header.Descriptor == Block::kDescriptorDeflated)
+                    if (header.Descriptor != Block::kDescriptorUncompressed)
+                    {
+                        arView.Clear();
+                        return false;
+                    }
+
+                    JZ_E_ON_FAIL(Crc32((void_p)pData, header.DataSize) == header.CRC, "CRC check failed.");
+
+                    // Extend the current span when this block directly follows its last block.
+                    if (!arView.mSpans.empty() &&
+                        (arView.mSpans.back().pBlocks + (arView.mSpans.back().BlockCount * kBlockSize)) == pBlock)
                     {
-                        bytesRead = _Inflate(kpBlockData, header.DataSize, (arBuffer.Get() + bufferPos), kFileSize - bufferPos);
+                        FileSpan& span = arView.mSpans.back();
+                        span.BlockCount++;
+                        span.DataSize += header.DataSize;
                     }
                     else
                     {
-                        bytesRead = header.DataSize;
-                        memcpy((void_p)(arBuffer.Get() + bufferPos), kpBlockData, bytesRead);
+                        FileSpan span = { pBlock, 1u, header.DataSize };
+                        arView.mSpans.push_back(span);
                     }
-                    
-                    bufferPos += bytesRead;
+
+                    bufferPos += header.DataSize;
                     filePos = header.NextBlock;
                 }
-                
-                JZ_ASSERT(bufferPos == kFileSize);
+
+                JZ_E_ON_FAIL(bufferPos == kFileSize, "file size does not match its blocks.");
+
+                return true;
             }
-              
+
             void FileSystem::Write(const FileTag& aTag, const ByteBuffer& aBuffer)
             {
+                Write(aTag, aBuffer, mDefaultCodec);
+            }
+
+            void FileSystem::Write(const char* apFilename, const ByteBuffer& aBuffer)
+            {
+                const char* pExtension = strrchr(apFilename, '.');
+
+                Write(FileTag(apFilename), aBuffer, (pExtension) ? GetCodecForExtension(pExtension + 1) : mDefaultCodec);
+            }
+
+            void FileSystem::Write(const FileTag& aTag, const ByteBuffer& aBuffer, u16 aDescriptor)
+            {
+                JZ_E_ON_FAIL(!IsMapped(), "file system is read-only.");
+
+                const IBlockCodec* pCodec = BlockCodecs::Get(aDescriptor);
+                JZ_E_ON_FAIL(pCodec, "no codec registered for descriptor.");
+
                 FileTableEntry& entry = _AddFileEntry(aTag);
 
-                size_t bufferPos = 0u;
                 u64 filePos = (entry.FirstBlockPosition == 0u) ? mFileSystemSize : entry.FirstBlockPosition;
                 const size_t kBufferSize = aBuffer.GetSizeInBytes();
                 const size_t kBlockBufferSize = mBlockBuffer.GetSizeInBytes();
                 const size_t kBlockDataSize = (kBlockBufferSize - sizeof(BlockHeader));
-                u8* const kpBlockData = (mBlockBuffer.Get() + sizeof(BlockHeader));
+                const size_t kBlockCount = _GetBlockCount(kBufferSize, kBlockDataSize);
                 BlockHeader& header = _GetBlockHeader();
 
                 entry.FileSize = kBufferSize;
                 entry.FirstBlockPosition = filePos;
 
+                // Compress all blocks up front, then place them in order below.
+                ByteBuffer encoded;
+                encoded.resize(kBlockCount * kBlockDataSize);
+                vector<u16> encodedSizes(kBlockCount);
+                if (kBlockCount > 0u)
+                {
+                    BlockEncoder encoder = { pCodec, aBuffer.Get(), encoded.Get(), &encodedSizes[0], kBlockDataSize, kBufferSize };
+                    _ForEachBlock(encoder, kBlockCount);
+                }
+
+                size_t block = 0u;
+
                 // Write over free space.
-                while (filePos > 0u && filePos < mFileSystemSize)
+                while (block < kBlockCount && filePos > 0u && filePos < mFileSystemSize)
                 {
-                    const size_t kDataSize = Min(kBlockDataSize, kBufferSize - bufferPos);
-                    
-                    memcpy(kpBlockData, (aBuffer.Get() + bufferPos), kDataSize);
-                    bufferPos += kDataSize;
-                    
                     _ReadBlockHeaderAt(filePos);
-                    
-                    header.CRC = Crc32(kpBlockData, kDataSize);
-                    header.Hash = aTag.GetHash();
-                    header.Descriptor = Block::kDescriptorUncompressed;
-                    header.DataSize = kDataSize;
+                    _PrepareBlock(aTag, aBuffer, encoded, encodedSizes, aDescriptor, block);
+                    block++;
 
-                    if (header.NextBlock == 0u && bufferPos < kBufferSize)
+                    if (header.NextBlock == 0u && block < kBlockCount)
                     {
                         header.NextBlock = mFileSystemSize;
                     }
@@ -266,19 +594,12 @@ namespace jz
                 }
                  
                 // Write at end.
-                while (bufferPos < kBufferSize)
+                while (block < kBlockCount)
                 {
-                    const size_t kDataSize = Min(kBlockDataSize, kBufferSize - bufferPos);
-
-                    memcpy(kpBlockData, (aBuffer.Get() + bufferPos), kDataSize);
-                    bufferPos += kDataSize;
+                    _PrepareBlock(aTag, aBuffer, encoded, encodedSizes, aDescriptor, block);
+                    block++;
                     
-                    header.CRC = Crc32(kpBlockData, kDataSize);
-                    header.Hash = aTag.GetHash();
-                    header.Descriptor = Block::kDescriptorUncompressed;
-                    header.DataSize = kDataSize;
-                    
-                    if (bufferPos < kBufferSize) { header.NextBlock = (mFileSystemSize + kBlockBufferSize); }
+                    if (block < kBlockCount) { header.NextBlock = (mFileSystemSize + kBlockBufferSize); }
                     else { header.NextBlock = 0u; }
                     
                     _WriteBlockAt(filePos);
@@ -287,7 +608,9 @@ namespace jz
                     JZ_ASSERT(filePos == mCurrentPos || filePos == 0u);
                 }
                 
-                Commit();
+                // Blocks must reach the pack before the journal references them.
+                _Flush();
+                _LogFileEntry((u32)(&entry - mFileTable.Get()));
             }
       
             void FileSystem::_CalculateFileSystemSize()
@@ -302,6 +625,16 @@ namespace jz
                 JZ_E_ON_FAIL(fflush(mpFileSystemHandle) == 0, "flush failed.");
             }
       
+            const BlockHeader& FileSystem::_GetMappedBlockHeader(u64 aPos) const
+            {
+                JZ_E_ON_FAIL(aPos > 0u && (aPos + sizeof(BlockHeader)) <= mFileSystemSize, "block position out of range.");
+
+                const BlockHeader& header = *reinterpret_cast<const BlockHeader*>(mMapping.Get() + aPos);
+                JZ_E_ON_FAIL((aPos + sizeof(BlockHeader) + header.DataSize) <= mFileSystemSize, "block data out of range.");
+
+                return header;
+            }
+
             void FileSystem::_PeekBlockHeader(u64 aPos)
             {
                 _ReadBlockHeaderAt(aPos);
@@ -321,6 +654,78 @@ namespace jz
                 _ReadAt(mBlockBuffer.Get(), mBlockBuffer.GetSizeInBytes(), aPos);
             }
             
+            void FileSystem::_PrefetchMapped(const FileTableEntry& aEntry) const
+            {
+                // Files appended in one Write() occupy consecutive blocks, so prefetching
+                // the run that would hold the whole file covers the common case with one
+                // readahead. Files that reuse freed blocks only lose the hint.
+                const size_t kBlockSize = mBlockBuffer.GetSizeInBytes();
+                const size_t kBlockDataSize = (kBlockSize - sizeof(BlockHeader));
+                const u64 kBlocks = Max((u64)1u, (u64)((aEntry.FileSize + kBlockDataSize - 1u) / kBlockDataSize));
+
+                if (aEntry.FirstBlockPosition > 0u && aEntry.FirstBlockPosition < mFileSystemSize)
+                {
+                    const u64 kSize = Min((kBlocks * kBlockSize), (mFileSystemSize - aEntry.FirstBlockPosition));
+                    mMapping.WillNeed((mMapping.Get() + aEntry.FirstBlockPosition), (size_t)kSize);
+                }
+            }
+
+            void FileSystem::_ReadMapped(const FileTableEntry& aEntry, ByteBuffer& arBuffer) const
+            {
+                const size_t kBlockDataSize = (mBlockBuffer.GetSizeInBytes() - sizeof(BlockHeader));
+                const size_t kBlockCount = _GetBlockCount(aEntry.FileSize, kBlockDataSize);
+
+                _PrefetchMapped(aEntry);
+
+                vector<const u8*> pointers(kBlockCount);
+
+                u64 filePos = aEntry.FirstBlockPosition;
+                for (size_t i = 0u; i < kBlockCount; i++)
+                {
+                    const BlockHeader& header = _GetMappedBlockHeader(filePos);
+                    JZ_E_ON_FAIL(header.DataSize <= kBlockDataSize, "block data size is too big.");
+                    pointers[i] = reinterpret_cast<const u8*>(&header);
+                    filePos = header.NextBlock;
+                }
+
+                _DecodeBlocks(pointers, aEntry.FileSize, arBuffer);
+            }
+
+            void FileSystem::_DecodeBlocks(const vector<const u8*>& aBlocks, size_t aFileSize, ByteBuffer& arBuffer) const
+            {
+                arBuffer.resize(aFileSize);
+                if (aBlocks.empty()) { return; }
+
+                BlockDecoder decoder = { &aBlocks[0], arBuffer.Get(), (mBlockBuffer.GetSizeInBytes() - sizeof(BlockHeader)), aFileSize, 0 };
+                _ForEachBlock(decoder, aBlocks.size());
+
+                JZ_E_ON_FAIL(decoder.Failures == 0, "CRC check or inflation failed.");
+            }
+
+            void FileSystem::_PrepareBlock(const FileTag& aTag, const ByteBuffer& aBuffer, const ByteBuffer& aEncoded, const vector<u16>& aEncodedSizes, u16 aDescriptor, size_t aBlock)
+            {
+                const size_t kBlockDataSize = (mBlockBuffer.GetSizeInBytes() - sizeof(BlockHeader));
+                const size_t kOffset = (aBlock * kBlockDataSize);
+                u8* const kpBlockData = (mBlockBuffer.Get() + sizeof(BlockHeader));
+                BlockHeader& header = _GetBlockHeader();
+
+                if (aEncodedSizes[aBlock] > 0u)
+                {
+                    header.Descriptor = aDescriptor;
+                    header.DataSize = aEncodedSizes[aBlock];
+                    memcpy(kpBlockData, (aEncoded.Get() + kOffset), header.DataSize);
+                }
+                else
+                {
+                    header.Descriptor = Block::kDescriptorUncompressed;
+                    header.DataSize = (u16)Min(kBlockDataSize, (aBuffer.GetSizeInBytes() - kOffset));
+                    memcpy(kpBlockData, (aBuffer.Get() + kOffset), header.DataSize);
+                }
+
+                header.CRC = Crc32(kpBlockData, header.DataSize);
+                header.Hash = aTag.GetHash();
+            }
+
             void FileSystem::_ReadBlockHeaderAt(u64 aPos)
             {
                 _ReadAt(mBlockBuffer.Get(), sizeof(BlockHeader), aPos);
@@ -376,6 +781,134 @@ namespace jz
             {
                 _WriteAt((const void_p)mFileTable.Get(), mFileTable.GetSizeInBytes(), (1 << mFileSystemHeader.BlockSizePower));
             }
+
+            void FileSystem::_WriteFileTableRange(u32 aBegin, u32 aEnd)
+            {
+                JZ_ASSERT(aBegin < aEnd && aEnd <= mFileTable.size());
+
+                const u64 kPos = (1 << mFileSystemHeader.BlockSizePower) + ((u64)aBegin * sizeof(FileTableEntry));
+                _WriteAt((const void_p)(mFileTable.Get() + aBegin), ((aEnd - aBegin) * sizeof(FileTableEntry)), kPos);
+            }
+
+            // Adjacent dirty pages are written with one call.
+            void FileSystem::_WriteDirtyPages()
+            {
+                if (mDirtyPages.empty()) { return; }
+
+                const u32 kFileTableSize = mFileTable.size();
+                const u32 kPages = ((kFileTableSize + gskFileTablePageEntries - 1u) / gskFileTablePageEntries);
+
+                u32 page = 0u;
+                while (page < kPages)
+                {
+                    if ((mDirtyPages[page >> 5] & (1u << (page & 31u))) == 0u) { page++; continue; }
+
+                    u32 end = (page + 1u);
+                    while (end < kPages && (mDirtyPages[end >> 5] & (1u << (end & 31u))) != 0u) { end++; }
+
+                    _WriteFileTableRange((page * gskFileTablePageEntries), Min((end * gskFileTablePageEntries), kFileTableSize));
+                    page = end;
+                }
+
+                mDirtyPages.clear();
+            }
+
+            void FileSystem::_LogFileEntry(u32 aIndex)
+            {
+                _MarkDirty(aIndex);
+
+                JournalRecord record;
+                record.Signature = gskJournalSignature;
+                record.Index = aIndex;
+                record.Entry = mFileTable[aIndex];
+                record.CRC = Crc32((const void_p)&record, offsetof(JournalRecord, CRC));
+
+                JZ_E_ON_FAIL(fwrite(&record, sizeof(JournalRecord), 1, mpJournalHandle) == 1, "journal write failed.");
+                JZ_E_ON_FAIL(fflush(mpJournalHandle) == 0, "journal flush failed.");
+
+                mJournalRecords++;
+                if (mJournalRecords >= gskJournalCheckpointRecords)
+                {
+                    Commit();
+                }
+            }
+
+            void FileSystem::_MarkDirty(u32 aIndex)
+            {
+                if (mDirtyPages.empty())
+                {
+                    const u32 kPages = ((mFileTable.size() + gskFileTablePageEntries - 1u) / gskFileTablePageEntries);
+                    mDirtyPages.resize(((kPages + 31u) / 32u), 0u);
+                }
+
+                const u32 kPage = (aIndex / gskFileTablePageEntries);
+                mDirtyPages[kPage >> 5] |= (1u << (kPage & 31u));
+            }
+
+            void FileSystem::_OpenJournal(const char* apFileSystemFilename, bool abReplay)
+            {
+                mJournalFilename = string(apFileSystemFilename) + ".journal";
+
+                // Entries logged after the last checkpoint. A torn record at the tail is
+                // from a crash mid-append and is dropped along with everything after it.
+                mJournalRecords = (abReplay) ? _ReplayJournal() : 0u;
+                if (!IsMapped())
+                {
+                    if (mJournalRecords > 0u) { Commit(); }
+                    else { _ReopenJournal("wb"); }
+                }
+            }
+
+            void FileSystem::_ReopenJournal(const char* apMode)
+            {
+                if (mpJournalHandle)
+                {
+                    fclose(mpJournalHandle);
+                    mpJournalHandle = null;
+                }
+
+    #           if JZ_PLATFORM_WINDOWS
+                    fopen_s(&mpJournalHandle, mJournalFilename.c_str(), apMode);
+    #           else
+                    mpJournalHandle = fopen(mJournalFilename.c_str(), apMode);
+    #           endif
+
+                JZ_E_ON_FAIL(mpJournalHandle, "failed opening journal.");
+            }
+
+            u32 FileSystem::_ReplayJournal()
+            {
+                FILE* pJournal = null;
+    #           if JZ_PLATFORM_WINDOWS
+                    fopen_s(&pJournal, mJournalFilename.c_str(), "rb");
+    #           else
+                    pJournal = fopen(mJournalFilename.c_str(), "rb");
+    #           endif
+
+                if (!pJournal) { return 0u; }
+
+                const u32 kFileTableSize = mFileTable.size();
+                u32 ret = 0u;
+
+                JournalRecord record;
+                while (fread(&record, sizeof(JournalRecord), 1, pJournal) == 1)
+                {
+                    if (record.Signature != gskJournalSignature ||
+                        record.Index >= kFileTableSize ||
+                        record.CRC != Crc32((const void_p)&record, offsetof(JournalRecord, CRC)))
+                    {
+                        break;
+                    }
+
+                    mFileTable[record.Index] = record.Entry;
+                    _MarkDirty(record.Index);
+                    ret++;
+                }
+
+                fclose(pJournal);
+
+                return ret;
+            }
             
             bool FileSystem::_FindFileIndex(const FileTag& aTag, u32& arIndex) const
             {
@@ -446,6 +979,7 @@ namespace jz
                         mFileTable.Initialize();
                         _WriteFileSystemHeader();
                         _WriteFileTable();
+                        _Flush();
                     }
                     else
                     {
@@ -457,6 +991,9 @@ namespace jz
                         _ReadAt((void_p)mFileTable.Get(), mFileTable.GetSizeInBytes(), (1 << mFileSystemHeader.BlockSizePower));
                         _CalculateFileSystemSize();
                     }
+
+                    // A journal left next to a new pack belongs to a deleted one.
+                    _OpenJournal(apFileSystemFilename, kbExists);
                 }
                 catch (std::exception&)
                 {
@@ -465,6 +1002,34 @@ namespace jz
                 }
             }
                                     
+            void FileSystem::_OpenMapped(const char* apFileSystemFilename)
+            {
+                mMapping.Open(apFileSystemFilename);
+                mFileSystemSize = mMapping.GetSize();
+
+                try
+                {
+                    JZ_E_ON_FAIL(mFileSystemSize >= sizeof(FileSystemHeader), "archive is truncated.");
+                    memcpy((void_p)&mFileSystemHeader, mMapping.Get(), sizeof(FileSystemHeader));
+                    JZ_E_ON_FAIL(mFileSystemHeader.BlockSizePower <= gskMaximumBlockSizePower, "chunk size is too big.");
+                    JZ_E_ON_FAIL(mFileSystemHeader.FileTableSizePower <= gskMaximumFileTableSizePower, "file table size is too big.");
+
+                    const u64 kFileTablePos = (1 << mFileSystemHeader.BlockSizePower);
+                    mBlockBuffer.resize((1 << mFileSystemHeader.BlockSizePower));
+                    mFileTable.resize((1 << mFileSystemHeader.FileTableSizePower));
+                    JZ_E_ON_FAIL((kFileTablePos + mFileTable.GetSizeInBytes()) <= mFileSystemSize, "archive is truncated.");
+                    memcpy((void_p)mFileTable.Get(), (mMapping.Get() + kFileTablePos), mFileTable.GetSizeInBytes());
+
+                    // Apply pending journal entries in memory only, the pack is not writable.
+                    _OpenJournal(apFileSystemFilename, true);
+                }
+                catch (std::exception&)
+                {
+                    _Destroy();
+                    throw;
+                }
+            }
+
             u32 FileSystem::_GetIndex(const FileTag& aTag) const
             {
                 const u32 kMask = (1 << mFileSystemHeader.FileTableSizePower) - 1u;
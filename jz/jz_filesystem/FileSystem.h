@@ -24,32 +24,21 @@
 #ifndef JZ_FILESYSTEM_FILE_SYSTEM_H_
 #define JZ_FILESYSTEM_FILE_SYSTEM_H_
 
+#include <jz_filesystem/BlockCodec.h>
 #include <jz_filesystem/FileTag.h>
+#include <jz_filesystem/MappedFile.h>
+#include <jz_system/AsyncIO.h>
 #include <ctime>
+#include <map>
 #include <queue>
+#include <string>
+#include <vector>
 
 namespace jz
 {
     namespace filesystem
     {
 
-        namespace Block
-        {
-            enum Descriptor
-            {
-                kDescriptorUncompressed = 0,
-                kDescriptorDeflated = 1
-            };
-            
-            enum Type
-            {
-                kTypeNone = 0,
-                kTypeStart = 1,
-                kTypeInternal = 2,
-                kTypeEnd = 3
-            };
-        }
-        
     #   if defined(_MSC_VER)
     #       pragma pack(push, packing)
     #       pragma pack(1)
@@ -83,6 +72,14 @@ namespace jz
             u32 FileSize;
             u32 ModifiedTime;
         } PACK_STRUCT;
+
+        struct JournalRecord
+        {
+            u32 Signature;
+            u32 Index;
+            FileTableEntry Entry;
+            u32 CRC;
+        } PACK_STRUCT;
         
     #   ifdef _MSC_VER
     #       pragma pack(pop, packing)
@@ -91,6 +88,9 @@ namespace jz
 
         static const size_t gskFileSystemOpsPerTick = 8;
         static const u32 gskSignature = 0xA18BC5B7;
+        static const u32 gskJournalSignature = 0x4A524E4C;
+        static const u32 gskJournalCheckpointRecords = 1024;
+        static const u32 gskFileTablePageEntries = 32;
         static const u16 gskMaximumBlockSizePower = 14;
         static const u32 gskMaximumFileTableSizePower = 20;
         static const u16 gskDefaultBlockSizePower = 12;
@@ -112,12 +112,67 @@ namespace jz
         static struct tm gskBaseTimeT = { 0, 0, 0, 1, 0, 108 };
         static const time_t gskBaseTime = mktime(&gskBaseTimeT);
                 
+        /// <summary>
+        /// A run of one file's blocks that are stored back to back in a mapped pack.
+        /// </summary>
+        struct FileSpan
+        {
+            const u8* pBlocks;
+            u32 BlockCount;
+            u32 DataSize;
+        };
+
+        /// <summary>
+        /// Zero-copy view of an uncompressed file in a mapped FileSystem. Valid until
+        /// the FileSystem is destroyed.
+        /// </summary>
+        /// <remarks>
+        /// Every block starts with a BlockHeader, so the payload of a multi-block file is
+        /// not contiguous even when the blocks are. Each span is walked block by block
+        /// with GetBlockData().
+        /// </remarks>
+        class FileView
+        {
+            public:
+                FileView()
+                    : mBlockSize(0u), mSize(0u)
+                {}
+
+                void Clear() { mSpans.clear(); mSize = 0u; }
+                void CopyTo(ByteBuffer& arBuffer) const;
+
+                const u8* GetBlockData(const FileSpan& aSpan, u32 aBlock, size_t& arSize) const;
+
+                // The payload if the file fits in a single block, null otherwise.
+                const u8* GetContiguousData() const;
+
+                size_t GetSize() const { return mSize; }
+                size_t GetSpanCount() const { return mSpans.size(); }
+                const FileSpan& GetSpan(size_t i) const { return mSpans[i]; }
+
+            private:
+                friend class FileSystem;
+
+                vector<FileSpan> mSpans;
+                size_t mBlockSize;
+                size_t mSize;
+        };
+
         class FileSystem
         {
             public:
-                FileSystem(const char* apFileSystemFilename);
+                enum Mode
+                {
+                    kReadWrite = 0,
+                    kReadOnlyMapped = 1
+                };
+
+                FileSystem(const char* apFileSystemFilename, Mode aMode = kReadWrite);
                 ~FileSystem();
 
+                // Checkpoints the journal: writes the dirty pages of the file table to the
+                // pack, syncs it and truncates the journal. Write() and Delete() only append
+                // to the journal, and checkpoint on their own every gskJournalCheckpointRecords.
                 void Commit();
                 bool GetExists(const FileTag& aTag) const;
                 u16 GetFileTableSizePower() const { return mFileSystemHeader.FileTableSizePower; }
@@ -125,19 +180,62 @@ namespace jz
 
                 void Delete(const FileTag& aTag);
                 void Read(const FileTag& aTag, ByteBuffer& arBuffer);
+
+                // Starts reading aTag into arBuffer through AsyncIO, which must exist. arBuffer
+                // is sized on the calling thread and must not be touched until the request is
+                // done. Blocks are located and decoded on an AsyncIO worker, so aTag must not
+                // be written or deleted while the read is in flight.
+                system::AsyncIO::RequestHandle ReadAsync(const FileTag& aTag, ByteBuffer& arBuffer, system::AsyncIO::Priority aPriority = system::AsyncIO::kMed, const system::AsyncIO::Callback& aCallback = system::AsyncIO::Callback());
+
+                // Blocks are encoded with the codec registered for aDescriptor, and stored
+                // as is where that does not make them smaller. The first overload uses the
+                // default codec, the last picks one from the extension of apFilename.
                 void Write(const FileTag& aTag, const ByteBuffer& aBuffer);
+                void Write(const FileTag& aTag, const ByteBuffer& aBuffer, u16 aDescriptor);
+                void Write(const char* apFilename, const ByteBuffer& aBuffer);
+
+                u16 GetDefaultCodec() const { return mDefaultCodec; }
+                void SetDefaultCodec(u16 aDescriptor);
+                u16 GetCodecForExtension(const char* apExtension) const;
+                void SetCodecForExtension(const char* apExtension, u16 aDescriptor);
+
+                bool IsMapped() const { return mMapping.IsOpen(); }
+
+                // Write() and Delete() do not wait for the disk, so a crash can lose the ones
+                // made since the last Sync() or Commit(). Sync() makes them durable, blocks
+                // first and then the journal records that reference them. Call it once per
+                // batch of writes, not per write.
+                void Sync();
+
+                // Mapped mode only. Returns false if the file is stored with any compressed
+                // blocks, those must go through Read().
+                bool View(const FileTag& aTag, FileView& arView) const;
                 
             private:
                 FileSystem(const FileSystem&);
                 FileSystem& operator=(const FileSystem&);
                 
+                string mFilename;
                 FILE* mpFileSystemHandle;
+                FILE* mpJournalHandle;
+                string mJournalFilename;
+                u32 mJournalRecords;
+                MappedFile mMapping;
+                system::AsyncFilePtr mpAsyncFile;
                 u64 mFileSystemSize;
                 u64 mCurrentPos;
                 
                 FileSystemHeader mFileSystemHeader;
                 ByteBuffer mBlockBuffer;
                 MemoryBuffer<FileTableEntry> mFileTable;
+
+                // One bit per gskFileTablePageEntries entries. Slots are picked by hash, so
+                // the entries of a checkpoint are scattered over the whole table.
+                vector<u32> mDirtyPages;
+
+                typedef map<string, u16> ExtensionCodecs;
+                ExtensionCodecs mExtensionCodecs;
+                u16 mDefaultCodec;
                 
                 const BlockHeader& _GetBlockHeader() const
                 {
@@ -150,11 +248,17 @@ namespace jz
                 }
 
                 void _CalculateFileSystemSize();
+                void _DecodeBlocks(const vector<const u8*>& aBlocks, size_t aFileSize, ByteBuffer& arBuffer) const;
                 void _Destroy();
                 void _Flush();
+                const BlockHeader& _GetMappedBlockHeader(u64 aPos) const;
+                void _OpenMapped(const char* apFileSystemFilename);
                 void _PeekBlockHeader(u64 aPos);
+                void _PrepareBlock(const FileTag& aTag, const ByteBuffer& aBuffer, const ByteBuffer& aEncoded, const vector<u16>& aEncodedSizes, u16 aDescriptor, size_t aBlock);
+                void _PrefetchMapped(const FileTableEntry& aEntry) const;
                 void _ReadAt(void_p ap, size_t aSize, u64 aFilePos);
                 void _ReadBlockAt(u64 aPos);            
+                void _ReadMapped(const FileTableEntry& aEntry, ByteBuffer& arBuffer) const;
                 void _ReadBlockHeaderAt(u64 aPos);
                 void _SeekAbsolute(u64 aPos);
                 u64 _Tell();
@@ -164,6 +268,14 @@ namespace jz
 
                 void _WriteFileSystemHeader();
                 void _WriteFileTable();
+                void _WriteFileTableRange(u32 aBegin, u32 aEnd);
+                void _WriteDirtyPages();
+
+                void _LogFileEntry(u32 aIndex);
+                void _MarkDirty(u32 aIndex);
+                void _OpenJournal(const char* apFileSystemFilename, bool abReplay);
+                void _ReopenJournal(const char* apMode);
+                u32 _ReplayJournal();
                 
                 FileTableEntry& _AddFileEntry(const FileTag& aTag);
                 bool _FindFileIndex(const FileTag& aTag, u32& arIndex) const;
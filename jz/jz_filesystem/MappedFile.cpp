@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_filesystem/MappedFile.h>
+
+#if JZ_PLATFORM_WINDOWS
+#   include <jz_system/Win32.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace jz
+{
+    namespace filesystem
+    {
+
+    #   if JZ_PLATFORM_WINDOWS
+            MappedFile::MappedFile()
+                : mpData(null), mSize(0u), mFile(INVALID_HANDLE_VALUE), mMapping(null)
+            {}
+
+            void MappedFile::Close()
+            {
+                if (mpData) { UnmapViewOfFile(mpData); mpData = null; }
+                if (mMapping) { CloseHandle(mMapping); mMapping = null; }
+                if (mFile != INVALID_HANDLE_VALUE) { CloseHandle(mFile); mFile = INVALID_HANDLE_VALUE; }
+                mSize = 0u;
+            }
+
+            void MappedFile::Open(const char* apFilename)
+            {
+                Close();
+
+                mFile = CreateFileA(apFilename, GENERIC_READ, FILE_SHARE_READ, null, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, null);
+                JZ_E_ON_FAIL(mFile != INVALID_HANDLE_VALUE, "failed opening file for mapping.");
+
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+                {
+                    Close();
+                    JZ_E_ON_FAIL(false, "file is empty or its size could not be read.");
+                }
+
+                mMapping = CreateFileMappingA(mFile, null, PAGE_READONLY, 0u, 0u, null);
+                if (mMapping) { mpData = (const u8*)MapViewOfFile(mMapping, FILE_MAP_READ, 0u, 0u, 0u); }
+                if (!mpData)
+                {
+                    Close();
+                    JZ_E_ON_FAIL(false, "failed mapping file.");
+                }
+
+                mSize = (u64)size.QuadPart;
+            }
+
+            void MappedFile::WillNeed(const u8* apBegin, size_t aSize) const
+            {
+                // PrefetchVirtualMemory() requires Windows 8, rely on the
+                // FILE_FLAG_RANDOM_ACCESS cache hint instead.
+            }
+    #   else
+            MappedFile::MappedFile()
+                : mpData(null), mSize(0u), mFile(-1)
+            {}
+
+            void MappedFile::Close()
+            {
+                if (mpData) { munmap((void_p)mpData, (size_t)mSize); mpData = null; }
+                if (mFile >= 0) { close(mFile); mFile = -1; }
+                mSize = 0u;
+            }
+
+            void MappedFile::Open(const char* apFilename)
+            {
+                Close();
+
+                mFile = open(apFilename, O_RDONLY);
+                JZ_E_ON_FAIL(mFile >= 0, "failed opening file for mapping.");
+
+                struct stat fileInfo;
+                if (fstat(mFile, &fileInfo) != 0 || fileInfo.st_size == 0)
+                {
+                    Close();
+                    JZ_E_ON_FAIL(false, "file is empty or its size could not be read.");
+                }
+
+                void_p p = mmap(null, (size_t)fileInfo.st_size, PROT_READ, MAP_SHARED, mFile, 0);
+                if (p == MAP_FAILED)
+                {
+                    Close();
+                    JZ_E_ON_FAIL(false, "failed mapping file.");
+                }
+
+                mpData = (const u8*)p;
+                mSize = (u64)fileInfo.st_size;
+            }
+
+            void MappedFile::WillNeed(const u8* apBegin, size_t aSize) const
+            {
+                static const size_t kPageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+                // madvise() requires a page aligned start.
+                const size_t kOffset = ((size_t)apBegin & (kPageSize - 1u));
+                madvise((void_p)(apBegin - kOffset), (aSize + kOffset), MADV_WILLNEED);
+            }
+    #   endif
+
+        MappedFile::~MappedFile()
+        {
+            Close();
+        }
+
+    }
+}
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef JZ_FILESYSTEM_MAPPED_FILE_H_
+#define JZ_FILESYSTEM_MAPPED_FILE_H_
+
+#include <jz_core/Prereqs.h>
+
+namespace jz
+{
+    namespace filesystem
+    {
+
+        /// <summary>
+        /// Read-only view of an entire file mapped into the address space.
+        /// </summary>
+        class MappedFile
+        {
+            public:
+                MappedFile();
+                ~MappedFile();
+
+                void Close();
+                void Open(const char* apFilename);
+
+                const u8* Get() const { return mpData; }
+                u64 GetSize() const { return mSize; }
+                bool IsOpen() const { return (mpData != null); }
+
+                // Hints that [apBegin, apBegin + aSize) will be read soon, so the pages
+                // are faulted in by one readahead instead of one fault per page.
+                void WillNeed(const u8* apBegin, size_t aSize) const;
+
+            private:
+                MappedFile(const MappedFile&);
+                MappedFile& operator=(const MappedFile&);
+
+                const u8* mpData;
+                u64 mSize;
+
+    #           if JZ_PLATFORM_WINDOWS
+                    void_p mFile;
+                    void_p mMapping;
+    #           else
+                    int mFile;
+    #           endif
+        };
+
+    }
+}
+
+#endif
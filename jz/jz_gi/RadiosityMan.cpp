@@ -29,7 +29,7 @@
 
 namespace jz
 {
-    gi::RadiosityMan* gi::RadiosityMan::mspSingleton = null;
+    template <> gi::RadiosityMan* Singleton<gi::RadiosityMan>::mspSingleton = null;
     namespace gi
     {
 
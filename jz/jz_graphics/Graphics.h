@@ -32,6 +32,7 @@
 #include <jz_core/Utility.h>
 #include <jz_graphics/PrimitiveType.h>
 #include <jz_graphics/Viewport.h>
+#include <jz_system/Files.h>
 #include <map>
 #include <list>
 
@@ -115,7 +116,7 @@ namespace jz
             T* Create(typename EnableIf<tr1::is_base_of<IVolatileObject, T>::value>::type* pDummy = null)
             {
                 T* p(new T());
-                mVolatileObjects.insert(make_pair(T::SortOrder, p));
+                mVolatileObjects.insert(make_pair((int)T::SortOrder, p));
                 if (mbLoaded) { p->Create(); }
                 if (!mbLost) { p->Reset(GetViewportWidth(), GetViewportHeight()); }
 
@@ -126,7 +127,7 @@ namespace jz
             T* Create(A1 a1, typename EnableIf<tr1::is_base_of<IVolatileObject, T>::value>::type* pDummy = null)
             {
                 T* p(new T(a1));
-                mVolatileObjects.insert(make_pair(T::SortOrder, p));
+                mVolatileObjects.insert(make_pair((int)T::SortOrder, p));
                 if (mbLoaded) { p->Create(); }
                 if (!mbLost) { p->Reset(GetViewportWidth(), GetViewportHeight()); }
 
@@ -137,7 +138,7 @@ namespace jz
             T* Create(A1 a1, A2 a2, typename EnableIf<tr1::is_base_of<IVolatileObject, T>::value>::type* pDummy = null)
             {
                 T* p(new T(a1, a2));
-                mVolatileObjects.insert(make_pair(T::SortOrder, p));
+                mVolatileObjects.insert(make_pair((int)T::SortOrder, p));
                 if (mbLoaded) { p->Create(); }
                 if (!mbLost) { p->Reset(GetViewportWidth(), GetViewportHeight()); }
 
@@ -148,7 +149,7 @@ namespace jz
             T* Create(A1 a1, A2 a2, A3 a3, typename EnableIf<tr1::is_base_of<IVolatileObject, T>::value>::type* pDummy = null)
             {
                 T* p(new T(a1, a2, a3));
-                mVolatileObjects.insert(make_pair(T::SortOrder, p));
+                mVolatileObjects.insert(make_pair((int)T::SortOrder, p));
                 if (mbLoaded) { p->Create(); }
                 if (!mbLost) { p->Reset(GetViewportWidth(), GetViewportHeight()); }
 
@@ -159,7 +160,7 @@ namespace jz
             T* Create(A1 a1, A2 a2, A3 a3, A4 a4, typename EnableIf<tr1::is_base_of<IVolatileObject, T>::value>::type* pDummy = null)
             {
                 T* p(new T(a1, a2, a3, a4));
-                mVolatileObjects.insert(make_pair(T::SortOrder, p));
+                mVolatileObjects.insert(make_pair((int)T::SortOrder, p));
                 if (mbLoaded) { p->Create(); }
                 if (!mbLost) { p->Reset(GetViewportWidth(), GetViewportHeight()); }
 
@@ -170,7 +171,7 @@ namespace jz
             T* Create(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, typename EnableIf<tr1::is_base_of<IVolatileObject, T>::value>::type* pDummy = null)
             {
                 T* p(new T(a1, a2, a3, a4, a5));
-                mVolatileObjects.insert(make_pair(T::SortOrder, p));
+                mVolatileObjects.insert(make_pair((int)T::SortOrder, p));
                 if (mbLoaded) { p->Create(); }
                 if (!mbLost) { p->Reset(GetViewportWidth(), GetViewportHeight()); }
 
@@ -258,7 +259,7 @@ namespace jz
             {
                 string name(system::Files::CleanFilename(aFilename));
 
-                Key key(T::SortOrder, name);
+                Key key((int)T::SortOrder, name);
 
                 Objects::iterator I = mObjects.find(key);
 
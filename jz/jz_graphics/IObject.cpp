@@ -21,7 +21,6 @@
 // 
 
 #include <jz_core/Logger.h>
-#include <jz_core/StringUtility.h>
 #include <jz_graphics/IObject.h>
 #include <jz_graphics/Graphics.h>
 #include <jz_system/Files.h>
@@ -41,16 +40,16 @@ namespace jz
 #       define JZ_ERROR_HELPER() \
             if (mInternalState == kErrorFileNotFound) \
             { \
-                LogMessage(__FUNCTION__ ": " + mFilename + " was not found or could not be opened."); \
+                JZ_LOG(Logger::kGraphics, Logger::kNormal, "%: % was not found or could not be opened.", __FUNCTION__, mFilename); \
                 return; \
             } \
             else if (mInternalState == kErrorDataRead) \
             { \
-                LogMessage(__FUNCTION__ ": " + mFilename + " data read exception."); \
+                JZ_LOG(Logger::kGraphics, Logger::kNormal, "%: % data read exception.", __FUNCTION__, mFilename); \
             } \
             else if (mInternalState == kErrorGraphics) \
             { \
-                LogMessage(__FUNCTION__ ": " + mFilename + " graphics error."); \
+                JZ_LOG(Logger::kGraphics, Logger::kNormal, "%: % graphics error.", __FUNCTION__, mFilename); \
                 return; \
             }
 
@@ -66,7 +65,7 @@ namespace jz
                 else
                 {
                     mInternalState = kErrorFileNotFound;
-                    LogMessage(__FUNCTION__ ": \"" + mFilename + "\" is not loadable.", Logger::kWarning);
+                    JZ_LOG(Logger::kGraphics, Logger::kWarning, "%: \"%\" is not loadable.", __FUNCTION__, mFilename);
                 }
             }
         }
@@ -111,7 +110,7 @@ namespace jz
                 }
                 catch (std::exception& e)
                 {
-                    LogMessage(__FUNCTION__ ": of " + StringUtility::ToString(this) + " failed, " + string(e.what()), Logger::kError);
+                    JZ_LOG(Logger::kGraphics, Logger::kError, "%: of % failed, %", __FUNCTION__, this, e.what());
                     mInternalState = kError;
                 }
             }
@@ -128,7 +127,7 @@ namespace jz
                 }
                 catch (std::exception& e)
                 {
-                    LogMessage(__FUNCTION__ ": of " + StringUtility::ToString(this) + " failed, " + string(e.what()), Logger::kError);
+                    JZ_LOG(Logger::kGraphics, Logger::kError, "%: of % failed, %", __FUNCTION__, this, e.what());
                     mInternalState = kError;
                 }
             }
@@ -145,7 +144,7 @@ namespace jz
                 }
                 catch (std::exception& e)
                 {
-                    LogMessage(__FUNCTION__ ": of " + StringUtility::ToString(this) + " failed, " + string(e.what()), Logger::kError);
+                    JZ_LOG(Logger::kGraphics, Logger::kError, "%: of % failed, %", __FUNCTION__, this, e.what());
                     mInternalState = kError;
                 }
             }
@@ -162,7 +161,7 @@ namespace jz
                 }
                 catch (std::exception& e)
                 {
-                    LogMessage(__FUNCTION__ ": of " + StringUtility::ToString(this) + " failed, " + string(e.what()), Logger::kError);
+                    JZ_LOG(Logger::kGraphics, Logger::kError, "%: of % failed, %", __FUNCTION__, this, e.what());
                     mInternalState = kError;
                 }
             }
@@ -452,8 +452,8 @@ namespace jz
                 
                     if (!b)
                     {
-                        LogMessage("Failed attaching material \"" + GetFilename() + "\" to Effect \"" + mpAttachedTo->GetFilename() + "\".", Logger::kError);
-                        LogMessage("Parameter with semantic \"" + mParameters[i]->GetSemantic() + "\" failed validation.", Logger::kError);
+                        JZ_LOG(Logger::kGraphics, Logger::kError, "Failed attaching material \"%\" to Effect \"%\".", GetFilename(), mpAttachedTo->GetFilename());
+                        JZ_LOG(Logger::kGraphics, Logger::kError, "Parameter with semantic \"%\" failed validation.", mParameters[i]->GetSemantic());
                     
                         _DestroyParameters();
                         mInternalState = (kErrorGraphics);
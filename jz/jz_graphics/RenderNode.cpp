@@ -20,150 +20,17 @@
 // THE SOFTWARE.
 // 
 
-#include <jz_core/ResetPool.h>
 #include <jz_graphics/RenderNode.h>
+#include <jz_graphics/RenderQueue.h>
 
 namespace jz
 {
-    graphics::RenderNode* ResetPool<graphics::RenderNode>::mspData = null;
-    graphics::RenderNode* ResetPool<graphics::RenderNode>::mspOldData = null;
-    size_t ResetPool<graphics::RenderNode>::msCount = 0u;
-    size_t ResetPool<graphics::RenderNode>::msSize = 0u;
     namespace graphics
     {
 
-        RenderNode* RenderNode::Adopt(RenderNodeDelegate aDelegate, voidc_p apInstance)
+        void RenderNode::RenderChildren()
         {
-            for (RenderNode* e = mpHead; e != null; e = e->mpNext)
-            {
-                if (e->mpInstance == apInstance) { return e; }
-            }
-
-            return AdoptFront(aDelegate, apInstance);
-        }
-
-        RenderNode* RenderNode::AdoptAndUpdateSort(RenderNodeDelegate aDelegate, voidc_p apInstance, float aSortOrder)
-        {
-            RenderNode* prev = null;
-
-            for (RenderNode* e = mpHead; e != null; e = e->mpNext)
-            {
-                if (e->mpInstance == apInstance)
-                {
-                    e->mSortOrder = Min(e->mSortOrder, aSortOrder);
-                    if (prev) { prev->mpNext = e->mpNext; }
-                    else { mpHead = e->mpNext; }
-
-                    _ReinsertSorted(e);
-
-                    return e;
-                }
-
-                prev = e;
-            }
-
-            return AdoptSorted(aDelegate, apInstance, aSortOrder);
-        }
-
-        RenderNode* RenderNode::AdoptFront(RenderNodeDelegate aDelegate, voidc_p apInstance)
-        {
-            RenderNode* ret = RenderPool::Grab(aDelegate, apInstance);
-            ret->mpNext = mpHead;
-            mpHead = ret;
-
-            return ret;
-        }
-
-        RenderNode* RenderNode::AdoptSorted(RenderNodeDelegate aDelegate, voidc_p apInstance, float aSortOrder)
-        {
-            if (!mpHead || mpHead->mSortOrder > aSortOrder)
-            {
-                RenderNode* ret = AdoptFront(aDelegate, apInstance);
-                ret->mSortOrder = aSortOrder;
-
-                return ret;
-            }
-            else if (mpHead->mSortOrder == aSortOrder && mpHead->mpInstance == apInstance)
-            {
-                return mpHead;
-            }
-            else
-            {
-                RenderNode* prev = mpHead;
-                RenderNode* e = mpHead->mpNext;
-                for (; e != null; e = e->mpNext)
-                {
-                    if (e->mSortOrder == aSortOrder && e->mpInstance == apInstance) { return e; }
-                    else if (e->mSortOrder > aSortOrder) { break; }
-
-                    prev = e;
-                }
-
-                RenderNode* ret = RenderPool::Grab(aDelegate, apInstance, aSortOrder);
-                prev->mpNext = ret;
-                ret->mpNext = e;
-
-                return ret;
-            }
-        }
-
-        void RenderNode::_Reset()
-        {
-            mpHead = null;
-            mpNext = null;
-            mSortOrder = Constants<float>::kMax;
-        }
-
-        void RenderNode::_ReinsertSorted(RenderNode* pNode)
-        {
-            if (!mpHead || mpHead->mSortOrder >= pNode->mSortOrder)
-            {
-                pNode->mpNext = mpHead;
-                mpHead = pNode;
-            }
-            else
-            {
-                RenderNode* prev = mpHead;
-                RenderNode* e = mpHead->mpNext;
-
-                if (pNode->mpNext && pNode->mSortOrder < pNode->mSortOrder)
-                {
-                    prev = pNode->mpNext;
-                    e = prev->mpNext;
-                }
-
-                for (; e != null; e = e->mpNext)
-                {
-                    if (e->mSortOrder >= pNode->mSortOrder) { break; }
-                    prev = e;
-                }
-
-                prev->mpNext = pNode;
-                pNode->mpNext = e;
-            }
-        }
-
-        RenderNode* RenderNode::RenderPool::Grab(RenderNodeDelegate aDelegate, voidc_p apInstance)
-        {
-            RenderNode* node = ResetPool<RenderNode>::Grab();
-            node->mDelegate = aDelegate;
-            node->mpInstance = apInstance;
-            node->_Reset();
-
-            return node;
-        }
-
-        RenderNode* RenderNode::RenderPool::Grab(RenderNodeDelegate aDelegate, voidc_p apInstance, float aSortOrder)
-        {
-            RenderNode* node = Grab(aDelegate, apInstance);
-            node->mSortOrder = aSortOrder;
-
-            return node;
-        }
-
-        void RenderNode::RenderPool::Reset()
-        {
-            ResetPool<RenderNode>::Reset();
+            mpQueue->_Render(mLevel, mBegin, mEnd);
         }
 
     }
@@ -26,120 +26,38 @@
 
 #include <jz_core/Prereqs.h>
 
-#if !NDEBUG
-#   include <jz_core/StringUtility.h>
-#   include <jz_system/Files.h>
-#   include <jz_system/WriteHelpers.h>
-#endif
-
 namespace jz
 {
     namespace graphics
     {
 
-        class RenderNode;
-        typedef void (*RenderNodeDelegate)(RenderNode* apNode, voidc_p apInstance);
+        class RenderQueue;
 
+        // Handle passed to a DrawOp while it is executing. It identifies the run of sorted
+        // RenderQueue entries that share the op and everything above it, so an op can
+        // set its state, render everything that depends on that state, and then restore it.
         class RenderNode sealed
         {   
         public:
-            RenderNode()
-                : mpHead(null),
-                mpNext(null),
-                mDelegate(null),
-                mpInstance(null),
-                mSortOrder(Constants<float>::kMax)
-            {}
-
-            ~RenderNode()
+            RenderNode(RenderQueue* apQueue, size_t aLevel, size_t aBegin, size_t aEnd)
+                : mpQueue(apQueue),
+                mLevel(aLevel),
+                mBegin(aBegin),
+                mEnd(aEnd)
             {}
 
-#if !NDEBUG
-            void SaveDigraph(const string& aFilename)
-            {
-                system::IWriteFilePtr pFile = system::Files::GetSingleton().OpenWriteable(aFilename.c_str());
-                
-                system::WriteTextLine(pFile, "digraph jz\n{\n\tnode [shape = box];");
-                {
-                    string name = StringUtility::ToString(mpInstance) + ":" + StringUtility::ToString(mSortOrder);
-                    Digraph(pFile, name);
-                }
-                system::WriteTextLine(pFile, "}");
-            }
-
-            void Digraph(system::IWriteFilePtr& pFile, const string& aParentName)
-            {
-                string name = StringUtility::ToString(mpInstance) + ":" + StringUtility::ToString(mSortOrder);
-                system::WriteTextLine(pFile, "\t\"" + name + "\" -> \"" + aParentName + "\";");
-
-                for (RenderNode* e = mpHead; e != null; e = e->mpNext)
-                {
-                    e->Digraph(pFile, name);
-                }
-            }
-#endif
-
-            RenderNode* Adopt(RenderNodeDelegate aDelegate, voidc_p apInstance);
-            RenderNode* AdoptAndUpdateSort(RenderNodeDelegate aDelegate, voidc_p apInstance, float aSortOrder);
-            RenderNode* AdoptFront(RenderNodeDelegate aDelegate, voidc_p apInstance);
-            RenderNode* AdoptSorted(RenderNodeDelegate aDelegate, voidc_p apInstance, float aSortOrder);
-
-            RenderNode* GetHead() const { return mpHead; }
-            RenderNode* GetNext() const { return mpNext; }
-            voidc_p GetInstance() const { return mpInstance; }
-
-            void Render()
-            {
-                mDelegate(this, mpInstance);
-            }
-            
-            void RenderChildren()
-            {
-                for (RenderNode* e = mpHead; e != null; e = e->mpNext)
-                {
-                    e->Render();
-                }
-            }
-
-            static void ResetGlobal()
-            {
-                RenderPool::Reset();
-            }
-
-            void Reset()
-            {
-                _Reset();
-            }
+            void RenderChildren();
 
         private:
-            void _Reset();
-            void _ReinsertSorted(RenderNode* pNode);
-
             RenderNode(const RenderNode&);
             RenderNode& operator=(const RenderNode&);
 
-            RenderNode* mpHead;
-            RenderNode* mpNext;
-            RenderNodeDelegate mDelegate;
-            voidc_p mpInstance;
-            float mSortOrder;
-
-            class RenderPool
-            {
-            public:
-                static RenderNode* Grab(RenderNodeDelegate aDelegate, voidc_p apInstance);
-                static RenderNode* Grab(RenderNodeDelegate aDelegate, voidc_p apInstance, float aSortOrder);
-                static void Reset();
-
-            private:
-                RenderPool();
-                RenderPool(const RenderPool&);
-                RenderPool& operator=(const RenderPool&);
-            };
+            RenderQueue* mpQueue;
+            size_t mLevel;
+            size_t mBegin;
+            size_t mEnd;
         };   
 
-        typedef RenderNode* (RenderNode::*AdoptOp)(RenderNodeDelegate aDelegate, voidc_p apInstance, float aSortOrder);
-
     }
 }
 
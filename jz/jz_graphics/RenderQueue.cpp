@@ -0,0 +1,391 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_graphics/Effect.h>
+#include <jz_graphics/Material.h>
+#include <jz_graphics/Mesh.h>
+#include <jz_graphics/RenderOps.h>
+#include <jz_graphics/RenderQueue.h>
+#include <jz_graphics/VertexDeclaration.h>
+#include <algorithm>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        static const size_t kMinimumStateSlots = 64u;
+
+        // Maps a float to a u32 with the same ordering.
+        __inline u32 SortableDepth(float v)
+        {
+            u32 u;
+            memcpy(&u, &v, sizeof(u32));
+
+            return ((u & 0x80000000u) != 0u) ? ~u : (u | 0x80000000u);
+        }
+
+        __inline size_t HashState(size_t v)
+        {
+            return ((v ^ (v >> 4) ^ (v >> 16)) * 0x9E3779B1u);
+        }
+
+        struct DepthOrder
+        {
+            DepthOrder(const vector<float>& arDepths)
+                : Depths(arDepths)
+            {}
+
+            bool operator()(u32 a, u32 b) const
+            {
+                return (Depths[a] < Depths[b]) || (Depths[a] == Depths[b] && a < b);
+            }
+
+            const vector<float>& Depths;
+        };
+
+        RenderQueue::StateTable::StateTable()
+            : mStamp(1u)
+        {}
+
+        u32 RenderQueue::StateTable::Intern(size_t aValue, float aDepth)
+        {
+            if ((mDepths.size() + 1u) * 2u > mSlots.size()) { _Grow(); }
+
+            const size_t kMask = (mSlots.size() - 1u);
+            for (size_t i = (HashState(aValue) & kMask); true; i = ((i + 1u) & kMask))
+            {
+                Slot& slot = mSlots[i];
+                if (slot.Stamp != mStamp)
+                {
+                    slot.Value = aValue;
+                    slot.Id = (u32)mDepths.size();
+                    slot.Stamp = mStamp;
+                    mDepths.push_back(aDepth);
+
+                    return slot.Id;
+                }
+                else if (slot.Value == aValue)
+                {
+                    mDepths[slot.Id] = Min(mDepths[slot.Id], aDepth);
+
+                    return slot.Id;
+                }
+            }
+        }
+
+        void RenderQueue::StateTable::Rank(vector<u32>& arRanks) const
+        {
+            const size_t kSize = mDepths.size();
+
+            vector<u32> order(kSize);
+            for (size_t i = 0u; i < kSize; i++) { order[i] = (u32)i; }
+            sort(order.begin(), order.end(), DepthOrder(mDepths));
+
+            arRanks.resize(kSize);
+            for (size_t i = 0u; i < kSize; i++) { arRanks[order[i]] = (u32)i; }
+        }
+
+        void RenderQueue::StateTable::Reset()
+        {
+            mDepths.clear();
+            mStamp++;
+
+            if (mStamp == 0u)
+            {
+                const size_t kSize = mSlots.size();
+                for (size_t i = 0u; i < kSize; i++) { mSlots[i].Stamp = 0u; }
+                mStamp = 1u;
+            }
+        }
+
+        void RenderQueue::StateTable::_Grow()
+        {
+            vector<Slot> old(Max(mSlots.size() * 2u, kMinimumStateSlots));
+            for (size_t i = 0u; i < old.size(); i++) { old[i].Stamp = 0u; }
+            old.swap(mSlots);
+
+            const size_t kMask = (mSlots.size() - 1u);
+            const size_t kSize = old.size();
+            for (size_t i = 0u; i < kSize; i++)
+            {
+                if (old[i].Stamp == mStamp)
+                {
+                    size_t j = (HashState(old[i].Value) & kMask);
+                    while (mSlots[j].Stamp == mStamp) { j = ((j + 1u) & kMask); }
+
+                    mSlots[j] = old[i];
+                }
+            }
+        }
+
+        RenderQueue::RenderQueue()
+            : mbSorted(false)
+        {
+            Reset();
+        }
+
+        RenderQueue::~RenderQueue()
+        {}
+
+        size_t RenderQueue::BuildStateCommands(const RenderPack& r, Technique aTechnique, bool abRequireReset, RenderCommand* apCommands, size_t* apStates)
+        {
+            size_t count = 0u;
+            for (size_t i = 0u; i < kStateCount; i++) { apStates[i] = 0u; }
+
+#           define JZ_HELPER(op, instance) \
+                apCommands[count].Op = (op); \
+                apCommands[count].pInstance = (instance); \
+                count++;
+
+            if (r.PreEffectFunc)
+            {
+                JZ_HELPER(r.PreEffectFunc, r.PreEffectFuncParam);
+                apStates[kLayer] = Combine(reinterpret_cast<size_t>(r.PreEffectFunc), reinterpret_cast<size_t>(r.PreEffectFuncParam));
+            }
+
+            if (r.pEffect.IsValid())
+            {
+                JZ_HELPER(RenderOperations::SetEffect, r.pEffect.Get());
+                apStates[kEffect] = reinterpret_cast<size_t>(r.pEffect.Get());
+            }
+
+            if (r.PostEffectFunc)
+            {
+                JZ_HELPER(r.PostEffectFunc, r.PostEffectFuncParam);
+                apStates[kTechnique] = Combine(reinterpret_cast<size_t>(r.PostEffectFunc), reinterpret_cast<size_t>(r.PostEffectFuncParam));
+            }
+
+            if (aTechnique.IsValid())
+            {
+                voidc_p p = Technique::ToVoidP(aTechnique);
+                JZ_HELPER(RenderOperations::SetEffectTechnique, p);
+                apStates[kTechnique] = Combine(apStates[kTechnique], reinterpret_cast<size_t>(p));
+            }
+
+            if (r.pVertexDeclaration.IsValid() && (!abRequireReset || r.pVertexDeclaration->IsReset()))
+            {
+                JZ_HELPER(RenderOperations::SetVertexDeclaration, r.pVertexDeclaration.Get());
+                apStates[kMaterial] = reinterpret_cast<size_t>(r.pVertexDeclaration.Get());
+            }
+
+            if (r.pMaterial.IsValid() && (!abRequireReset || r.pMaterial->IsReset()))
+            {
+                JZ_HELPER(RenderOperations::SetMaterial, r.pMaterial.Get());
+                apStates[kMaterial] = Combine(apStates[kMaterial], reinterpret_cast<size_t>(r.pMaterial.Get()));
+            }
+
+            if (r.pMesh.IsValid() && (!abRequireReset || r.pMesh->IsReset()))
+            {
+                JZ_HELPER(RenderOperations::SetMesh, r.pMesh.Get());
+                apStates[kMesh] = reinterpret_cast<size_t>(r.pMesh.Get());
+            }
+
+#           undef JZ_HELPER
+
+            return count;
+        }
+
+        size_t RenderQueue::Add(u32 aPass, bool abDepthFirst, float aDepth, const size_t* apStates, const RenderCommand* apCommands, size_t aCount)
+        {
+            JZ_ASSERT(aPass < kMaxPasses);
+
+            Entry e;
+            e.First = (u32)mCommands.size();
+            e.Count = (u32)aCount;
+            e.Pass = aPass;
+            e.bDepthFirst = abDepthFirst;
+            e.Depth = aDepth;
+            for (size_t i = 0u; i < kStateCount; i++) { e.States[i] = apStates[i]; }
+
+            mCommands.insert(mCommands.end(), apCommands, apCommands + aCount);
+            mEntries.push_back(e);
+            mPassCounts[aPass]++;
+            mbSorted = false;
+
+            return (mEntries.size() - 1u);
+        }
+
+        void RenderQueue::LowerDepth(size_t aEntry, float aDepth)
+        {
+            Entry& e = mEntries[aEntry];
+            if (aDepth < e.Depth)
+            {
+                e.Depth = aDepth;
+                mbSorted = false;
+            }
+        }
+
+        void RenderQueue::Append(const RenderQueue& b)
+        {
+            const u32 kOffset = (u32)mCommands.size();
+            const size_t kSize = b.mEntries.size();
+
+            mCommands.insert(mCommands.end(), b.mCommands.begin(), b.mCommands.end());
+            mEntries.reserve(mEntries.size() + kSize);
+            for (size_t i = 0u; i < kSize; i++)
+            {
+                mEntries.push_back(b.mEntries[i]);
+                mEntries.back().First += kOffset;
+            }
+
+            for (size_t i = 0u; i < kMaxPasses; i++) { mPassCounts[i] += b.mPassCounts[i]; }
+            if (kSize > 0u) { mbSorted = false; }
+        }
+
+        bool RenderQueue::bPrefix(size_t aEntry, const RenderCommand* apCommands, size_t aCount) const
+        {
+            const Entry& e = mEntries[aEntry];
+            if (e.Count < aCount) { return false; }
+
+            for (size_t i = 0u; i < aCount; i++)
+            {
+                if (mCommands[e.First + i] != apCommands[i]) { return false; }
+            }
+
+            return true;
+        }
+
+        void RenderQueue::Render(u32 aPass)
+        {
+            JZ_ASSERT(aPass < kMaxPasses);
+
+            if (mPassCounts[aPass] > 0u)
+            {
+                if (!mbSorted) { _Sort(); }
+                _Render(0u, mPassBegin[aPass], mPassBegin[aPass + 1u]);
+            }
+        }
+
+        void RenderQueue::Reset()
+        {
+            mEntries.clear();
+            mCommands.clear();
+            for (size_t i = 0u; i < kMaxPasses; i++) { mPassCounts[i] = 0u; }
+            mbSorted = false;
+        }
+
+        u64 RenderQueue::_CreateKey(const Entry& e, const u32* apIds) const
+        {
+            u64 ret = (((u64)e.Pass) << 61) | (((u64)(e.bDepthFirst ? 1u : 0u)) << 60);
+            u32 depth = SortableDepth(e.Depth);
+
+#           define JZ_HELPER(state, bits) ((u64)Min(mRanks[state][apIds[state]], (u32)((1u << (bits)) - 1u)))
+
+            if (e.bDepthFirst)
+            {
+                ret |= (((u64)depth) << 28);
+                ret |= (JZ_HELPER(kLayer, 5) << 23) | (JZ_HELPER(kEffect, 5) << 18) | (JZ_HELPER(kTechnique, 6) << 12) | (JZ_HELPER(kMaterial, 6) << 6) | JZ_HELPER(kMesh, 6);
+            }
+            else
+            {
+                ret |= (JZ_HELPER(kLayer, 8) << 52) | (JZ_HELPER(kEffect, 8) << 44) | (JZ_HELPER(kTechnique, 8) << 36) | (JZ_HELPER(kMaterial, 10) << 26) | (JZ_HELPER(kMesh, 10) << 16);
+                ret |= (u64)(depth >> 16);
+            }
+
+#           undef JZ_HELPER
+
+            return ret;
+        }
+
+        void RenderQueue::_Render(size_t aLevel, size_t aBegin, size_t aEnd)
+        {
+            size_t i = aBegin;
+            while (i < aEnd)
+            {
+                const Entry& e = mEntries[mSorted[i].Entry];
+                if (e.Count <= aLevel) { i++; continue; }
+
+                RenderCommand command = mCommands[e.First + aLevel];
+                size_t j = (i + 1u);
+                for (; j < aEnd; j++)
+                {
+                    const Entry& f = mEntries[mSorted[j].Entry];
+                    if (f.Count > aLevel && mCommands[f.First + aLevel] != command) { break; }
+                }
+
+                RenderNode node(this, (aLevel + 1u), i, j);
+                command.Op(&node, command.pInstance);
+                i = j;
+            }
+        }
+
+        // LSD radix sort on 8-bit digits. Digits that every key shares are skipped, which
+        // is common for the upper bits since a frame only touches a few passes and states.
+        void RenderQueue::_Sort()
+        {
+            const size_t kSize = mEntries.size();
+
+            // States are interned here rather than in Add() so that queues recorded on other
+            // threads can be appended without remapping ids.
+            mIds.resize(kSize * kStateCount);
+            for (size_t i = 0u; i < kStateCount; i++)
+            {
+                StateTable& table = mStates[i];
+                table.Reset();
+
+                for (size_t j = 0u; j < kSize; j++)
+                {
+                    mIds[(j * kStateCount) + i] = table.Intern(mEntries[j].States[i], mEntries[j].Depth);
+                }
+
+                table.Rank(mRanks[i]);
+            }
+
+            mSorted.resize(kSize);
+            mScratch.resize(kSize);
+            for (size_t i = 0u; i < kSize; i++)
+            {
+                mSorted[i].Key = _CreateKey(mEntries[i], &(mIds[i * kStateCount]));
+                mSorted[i].Entry = (u32)i;
+            }
+
+            for (u32 shift = 0u; kSize > 0u && shift < 64u; shift += 8u)
+            {
+                size_t histogram[256];
+                memset(histogram, 0, sizeof(histogram));
+
+                for (size_t i = 0u; i < kSize; i++) { histogram[(mSorted[i].Key >> shift) & 0xFF]++; }
+                if (histogram[(mSorted[0].Key >> shift) & 0xFF] == kSize) { continue; }
+
+                size_t offset = 0u;
+                for (size_t i = 0u; i < 256u; i++)
+                {
+                    size_t count = histogram[i];
+                    histogram[i] = offset;
+                    offset += count;
+                }
+
+                for (size_t i = 0u; i < kSize; i++)
+                {
+                    mScratch[histogram[(mSorted[i].Key >> shift) & 0xFF]++] = mSorted[i];
+                }
+                mSorted.swap(mScratch);
+            }
+
+            mPassBegin[0] = 0u;
+            for (size_t i = 0u; i < kMaxPasses; i++) { mPassBegin[i + 1u] = mPassBegin[i] + mPassCounts[i]; }
+            mbSorted = true;
+        }
+
+    }
+}
@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_GRAPHICS_RENDER_QUEUE_H_
+#define _JZ_GRAPHICS_RENDER_QUEUE_H_
+
+#include <jz_core/Prereqs.h>
+#include <jz_graphics/RenderNode.h>
+#include <jz_graphics/RenderPack.h>
+#include <vector>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        struct RenderCommand
+        {
+            DrawOp Op;
+            voidc_p pInstance;
+
+            bool operator==(const RenderCommand& b) const { return (Op == b.Op && pInstance == b.pInstance); }
+            bool operator!=(const RenderCommand& b) const { return !(*this == b); }
+        };
+
+        // Flat, per-frame list of draw commands ordered by a 64-bit sort key.
+        //
+        // Each entry is the chain of DrawOps posed for one RenderPack. At render time the
+        // entries are radix sorted once by key and then walked level by level - adjacent
+        // entries that issue the same op with the same instance at a level are grouped so
+        // the op runs once and its RenderChildren() renders the group. State changes are
+        // therefore emitted only where neighboring entries actually differ.
+        //
+        // Key layout (most significant first):
+        //   - pass (3 bits)
+        //   - depth first flag (1 bit)
+        //   - state first: layer (8), effect (8), technique (8), material (10), mesh (10), depth (16)
+        //   - depth first: depth (32), layer (5), effect (5), technique (6), material (6), mesh (6)
+        //
+        // State fields are ranks of the state values interned at sort time, ordered by the
+        // nearest depth they were posed at. Ranks that do not fit their field are clamped,
+        // which only affects ordering - grouping is decided by the commands themselves.
+        class RenderQueue sealed
+        {
+        public:
+            enum State
+            {
+                kLayer,
+                kEffect,
+                kTechnique,
+                kMaterial,
+                kMesh,
+                kStateCount
+            };
+
+            static const u32 kMaxPasses = 8u;
+            static const size_t kMaxCommands = 16u;
+
+            RenderQueue();
+            ~RenderQueue();
+
+            // Fills apCommands with the state setting ops of r (pre-effect, effect, post-effect, aTechnique,
+            // vertex declaration, material, and mesh) and apStates with the values of each State field.
+            // If abRequireReset is true, declarations, materials, and meshes that are not reset are skipped.
+            static size_t BuildStateCommands(const RenderPack& r, Technique aTechnique, bool abRequireReset, RenderCommand* apCommands, size_t* apStates);
+            static size_t Combine(size_t a, size_t b) { return ((a * 31u) ^ (b + (b >> 3))); }
+
+            // Adds an entry and returns its index. Lower depth sorts first.
+            size_t Add(u32 aPass, bool abDepthFirst, float aDepth, const size_t* apStates, const RenderCommand* apCommands, size_t aCount);
+
+            // Moves entry aEntry to min(current depth, aDepth).
+            void LowerDepth(size_t aEntry, float aDepth);
+
+            // Adds the entries of b. Queues can be recorded on separate threads and appended
+            // into one queue on the render thread, which then sorts once.
+            void Append(const RenderQueue& b);
+
+            float GetDepth(size_t aEntry) const { return mEntries[aEntry].Depth; }
+            bool bPrefix(size_t aEntry, const RenderCommand* apCommands, size_t aCount) const;
+            bool bEmpty(u32 aPass) const { return (mPassCounts[aPass] == 0u); }
+
+            void Render(u32 aPass);
+            void Reset();
+
+        private:
+            friend void RenderNode::RenderChildren();
+
+            RenderQueue(const RenderQueue&);
+            RenderQueue& operator=(const RenderQueue&);
+
+            struct Entry
+            {
+                u32 First;
+                u32 Count;
+                u32 Pass;
+                bool bDepthFirst;
+                float Depth;
+                size_t States[kStateCount];
+            };
+
+            struct SortItem
+            {
+                u64 Key;
+                u32 Entry;
+            };
+
+            class StateTable sealed
+            {
+            public:
+                StateTable();
+
+                u32 Intern(size_t aValue, float aDepth);
+                void Rank(vector<u32>& arRanks) const;
+                void Reset();
+
+            private:
+                struct Slot
+                {
+                    size_t Value;
+                    u32 Id;
+                    u32 Stamp;
+                };
+
+                void _Grow();
+
+                vector<Slot> mSlots;
+                vector<float> mDepths;
+                u32 mStamp;
+            };
+
+            vector<Entry> mEntries;
+            vector<RenderCommand> mCommands;
+            vector<SortItem> mSorted;
+            vector<SortItem> mScratch;
+            vector<u32> mIds;
+            vector<u32> mRanks[kStateCount];
+            StateTable mStates[kStateCount];
+            size_t mPassCounts[kMaxPasses];
+            size_t mPassBegin[kMaxPasses + 1u];
+            bool mbSorted;
+
+            u64 _CreateKey(const Entry& e, const u32* apIds) const;
+            void _Render(size_t aLevel, size_t aBegin, size_t aEnd);
+            void _Sort();
+        };
+
+    }
+}
+
+#endif
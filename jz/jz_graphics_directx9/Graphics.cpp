@@ -39,7 +39,7 @@
 
 namespace jz
 {
-    graphics::Graphics* graphics::Graphics::mspSingleton = null;
+    template <> graphics::Graphics* Singleton<graphics::Graphics>::mspSingleton = null;
     namespace graphics
     {
 
@@ -761,7 +761,7 @@ namespace jz
                 }
                 catch (exception& e)
                 {
-                    LogMessage(e.what());
+                    JZ_LOG(Logger::kGraphics, Logger::kNormal, "%", e.what());
                     mbActive = false;
                     return;
                 }
@@ -33,7 +33,7 @@ namespace jz
     namespace graphics
     {
 
-#       if JZ_MULTITHREADED
+#       if JZ_MULTITHREADED_IO
             class TextureLoader : public system::ILoaderEntry
             {
             public:
@@ -169,7 +169,7 @@ namespace jz
 
         IObject::State Texture::_Load()
         {
-#       if JZ_MULTITHREADED
+#       if JZ_MULTITHREADED_IO
             if (!system::Loader::GetSingletonExists())
             {
 #       endif
@@ -197,7 +197,7 @@ namespace jz
                 mHandle = p;
 
                 return (kLost);
-#       if JZ_MULTITHREADED
+#       if JZ_MULTITHREADED_IO
             }
             else
             {
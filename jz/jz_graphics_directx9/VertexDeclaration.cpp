@@ -30,6 +30,12 @@
 
 namespace jz
 {
+    namespace system
+    {
+        // Read as bytes, Direct3D 9 hosts are little endian.
+        template <> struct ByteOrder<D3DVERTEXELEMENT9> { enum { kWordSize = sizeof(u8) }; };
+    }
+
     namespace graphics
     {
 
@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_graphics/DepthStencilSurface.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        DepthStencilSurface::DepthStencilSurface(unatural aWidth, unatural aHeight, Format aFormat)
+            : mWidth(aWidth), mHeight(aHeight), mFormat(aFormat)
+        {}
+
+        DepthStencilSurface::~DepthStencilSurface()
+        {}
+
+        void DepthStencilSurface::SetToDevice()
+        {
+            if (IsReset())
+            {
+                mPrevHandle = NullGetState(NullState::kDepthStencil);
+                NullSetState(NullState::kDepthStencil, this);
+            }
+        }
+
+        void DepthStencilSurface::RestorePrevToDevice()
+        {
+            if (IsReset())
+            {
+                NullSetState(NullState::kDepthStencil, mPrevHandle);
+                mPrevHandle.Reset();
+            }
+        }
+
+        void DepthStencilSurface::_Create()
+        {
+        }
+
+        void DepthStencilSurface::_Destroy()
+        {
+        }
+
+        void DepthStencilSurface::_Lost()
+        {
+        }
+        
+        void DepthStencilSurface::_Reset(natural aWidth, natural aHeight)
+        {
+        }
+
+    }
+}
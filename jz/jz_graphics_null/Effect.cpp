@@ -0,0 +1,197 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Logger.h>
+#include <jz_core/Memory.h>
+#include <jz_system/Files.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics/Effect.h>
+#include <jz_graphics/Pass.h>
+#include <jz_graphics_null/Null.h>
+#include <set>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        __inline uint Pack(uint n, uint count)
+        {
+            uint ret = (((count << 16) & 0xFFFF0000) | (0x0000FFFF & n));
+
+            return ret;
+        }
+
+        // Techniques are not parsed, every technique runs a single pass.
+        static const uint kPassCount = 1u;
+
+        // Parameter and technique handles are the address of the name in this set,
+        // so equal names get equal handles across effects.
+        typedef set<string> Names;
+        static Names gsNames;
+
+        static voidc_p Intern(const string& s)
+        {
+            return &(*(gsNames.insert(s).first));
+        }
+
+        // A compiled effect stores the names of its parameters, semantics and
+        // techniques null terminated, a name is treated as present if it occurs in
+        // the file that way. This can report a name that is only a suffix of
+        // another, which at worst costs extra parameter sets.
+        static bool Contains(const ByteBuffer& aData, const string& s)
+        {
+            const size_t kLength = (s.size() + 1u);
+
+            if (s.empty() || aData.size() < kLength) { return false; }
+
+            const size_t kEnd = (aData.size() - kLength);
+            for (size_t i = 0u; i <= kEnd; i++)
+            {
+                if (memcmp(aData.Get() + i, s.c_str(), kLength) == 0)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        Effect::Effect(const string& aFilename)
+            : IObject(aFilename)
+        { }
+        
+        Effect::~Effect()
+        {}
+
+        Pass Effect::Begin() const
+        {
+            if (mHandle)
+            {
+                NullSetState(NullState::kEffect, this);
+                gNullStatistics.EffectBegins++;
+
+                Pass ret;
+                ret.mEffect = mHandle;
+                ret.mHandle = Pack(0u, kPassCount);
+                return ret;
+            }
+            else
+            {
+                return (Pass());
+            }
+        }
+
+        void Effect::End() const
+        {}
+
+        void Effect::SetTechnique(Technique aTechnique)
+        {
+            mActiveTechnique = aTechnique;
+
+            if (mHandle)
+            {
+                NullSetState(NullState::kTechnique, Technique::ToVoidP(aTechnique));
+            }
+        }
+
+        IObject::State Effect::_Load()
+        {
+            using namespace system;
+            JZ_ASSERT(!mHandle);
+
+            IReadFilePtr pFile;
+            try
+            {
+                pFile = Files::GetSingleton().Open(GetFilename().c_str());
+            }
+            catch (exception&)
+            {
+                return (kErrorFileNotFound);
+            }
+            const size_t kSize = pFile->GetSize();
+
+            ByteBuffer* p = new ByteBuffer(kSize);
+            if (pFile->Read(p->Get(), kSize) != kSize)
+            {
+                delete p;
+                return (kErrorDataRead);
+            }
+
+            gNullStatistics.UploadedBytes += kSize;
+            mHandle = p;
+
+            return (kLost);
+        }
+
+        IObject::State Effect::_Unload()
+        {
+            SafeDelete<ByteBuffer>(mHandle);
+
+            return (kUnloaded);
+        }
+
+        IObject::State Effect::_Lost()
+        {
+            return (kLost);
+        }
+
+        IObject::State Effect::_Reset(natural aWidth, natural aHeight)
+        {
+            return (kReset);
+        }
+
+        // Annotations are never reported, the null device renders every technique
+        // as opaque.
+        Handle Effect::_GetParameterAnnotationByName(voidc_p apObject, const string& aName) const
+        {
+            return (Handle());
+        }
+
+        Handle Effect::_GetTechniqueAnnotationByName(voidc_p apObject, const string& aName) const
+        {
+            return (Handle());
+        }
+
+        void Effect::_GetParameterBySemantic(const string& s, Handle& arEffect, Handle& arHandle) const
+        {
+            arEffect = mHandle;
+            arHandle = Handle();
+
+            if (mHandle && Contains(*StaticCast<ByteBuffer*>(mHandle), s))
+            {
+                arHandle = Intern(s);
+            }
+        }
+
+        Handle Effect::_GetTechniqueByName(const string& aName) const
+        {
+            if (mHandle && Contains(*StaticCast<ByteBuffer*>(mHandle), aName))
+            {
+                return (Intern(aName));
+            }
+
+            return (Handle());
+        }
+
+    }
+}
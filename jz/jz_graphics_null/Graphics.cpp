@@ -0,0 +1,341 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Logger.h>
+#include <jz_core/Memory.h>
+#include <jz_graphics/Effect.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics/VolatileTexture.h>
+#include <jz_graphics_null/Null.h>
+#include <jz_system/Files.h>
+
+namespace jz
+{
+    template <> graphics::Graphics* Singleton<graphics::Graphics>::mspSingleton = null;
+    namespace graphics
+    {
+
+        static const natural kDefaultViewportWidth = 1280;
+        static const natural kDefaultViewportHeight = 720;
+        static const uint kMaxTextureDimension = 4096u;
+
+        static Viewport gsViewport;
+
+        bool Graphics::IsActive() const
+        {
+            return true;
+        }
+
+        natural Graphics::GetViewportWidth() const
+        {
+            return (mSettings.bIsFullscreen) ? mSettings.FullscreenWidth : mSettings.ViewportWidth;
+        }
+
+        natural Graphics::GetViewportHeight() const
+        {
+            return (mSettings.bIsFullscreen) ? mSettings.FullscreenHeight : mSettings.ViewportHeight;
+        }
+
+        void Graphics::Resize(natural width, natural height)
+        {
+            natural newWidth = Max(width, (natural)1);
+            natural newHeight = Max(height, (natural)1);
+
+            if (newWidth != mSettings.ViewportWidth || newHeight != mSettings.ViewportHeight)
+            {
+                mSettings.ViewportWidth = newWidth;
+                mSettings.ViewportHeight = newHeight;
+                _RecalculateWindowSize();
+                mbNeedsResize = true;
+            }
+        }
+
+        void Graphics::SetFullscreen(bool abFullscreen)
+        {
+            if (mSettings.bWantsFullscreen != abFullscreen)
+            {
+                mSettings.bWantsFullscreen = abFullscreen;
+                mbNeedsResize = true;
+            }
+        }
+
+        void Graphics::SetMinimized(bool abMinimized)
+        {
+            mbMinimized = abMinimized;
+        }
+
+        void Graphics::_Reset()
+        {
+            if (mbLost)
+            {
+                for (Objects::iterator I = mObjects.begin(); I != mObjects.end(); I++)
+                {
+                    I->second->Reset(GetViewportWidth(), GetViewportHeight());
+                }
+
+                for (VolatileObjects::iterator I = mVolatileObjects.begin(); I != mVolatileObjects.end(); I++)
+                {
+                    I->second->Reset(GetViewportWidth(), GetViewportHeight());
+                }
+
+                OnReset(GetViewportWidth(), GetViewportHeight());
+
+                mbNeedsResize = false;
+                mbLost = false;
+            }
+        }
+
+        void Graphics::_Lost()
+        {
+            if (!mbLost)
+            {
+                mbLost = true;
+                OnLost();
+
+                for (VolatileObjects::reverse_iterator I = mVolatileObjects.rbegin(); I != mVolatileObjects.rend(); I++)
+                {
+                    I->second->Lost();
+                }
+
+                for (Objects::reverse_iterator I = mObjects.rbegin(); I != mObjects.rend(); I++)
+                {
+                    I->second->Lost();
+                }
+
+                NullClearStates();
+                gsViewport = Viewport();
+            }
+        }
+
+        static void DefaultTexturePopulate(natural aWidth, natural aHeight, void_p apData, size_t aPitch)
+        {
+            JZ_ASSERT(aWidth == 1);
+            JZ_ASSERT(aHeight == 1);
+
+            u8_p p = (u8_p)apData;
+
+            p[0] = 255; // B
+            p[1] = 127; // G
+            p[2] = 127; // R
+            p[3] = 255; // A
+        }
+
+        Graphics::Graphics(bool abStartFullscreen)
+            : mbActive(true), mbBegin(false), mbLost(true), mbLoaded(false), mbNeedsResize(false),
+            mbOwnsWindow(false), mbMinimized(false),
+            mpActiveEffect(null), mpActiveMesh(null), mpActivePass(null)
+        {
+            _SetDefaultSettings();
+
+            if (abStartFullscreen) { SetFullscreen(true); }
+            _ResetDevice();
+
+            mpDefaultTexture = Create<VolatileTexture>(1, 1, VolatileTexture::kA8R8G8B8, DefaultTexturePopulate);
+        }
+
+        Graphics::~Graphics()
+        {
+            _Lost();
+            _Unload();
+        }
+
+        bool Graphics::Begin(const ColorRGBA& c, bool abClear)
+        {
+            JZ_ASSERT(!mbBegin);
+
+            if (mbActive && !mbMinimized)
+            {
+                if (mbLost || mbNeedsResize)
+                {
+                    _ResetDevice();
+                }
+
+                if (abClear)
+                {
+                    Clear(kColor | kDepth | kStencil, c);
+                }
+
+                mbBegin = true;
+
+                return true;
+            }
+
+            return false;
+        }
+
+        void Graphics::End(bool abPresent)
+        {
+            if (mbBegin && abPresent)
+            {
+                gNullStatistics.Frames++;
+            }
+
+            mbBegin = false;
+        }
+
+        void Graphics::Clear(unatural aClearOptions, const ColorRGBA& aClearColor, float aZdepth, u8 aStencil)
+        {
+            gNullStatistics.Clears++;
+        }
+
+        void Graphics::DrawPrimitives(PrimitiveType::Enum aType, voidc_p aVertices, size_t aPrimitiveCount, size_t aVertexStrideInBytes)
+        {
+            NullDraw(aPrimitiveCount);
+            gNullStatistics.UploadedBytes += (GetVertexCount(aType, aPrimitiveCount) * aVertexStrideInBytes);
+        }
+
+        void Graphics::DrawIndexedPrimitives(PrimitiveType::Enum aType, voidc_p aIndices, size_t aPrimitiveCount, voidc_p aVertices, size_t aVertexCount, size_t aVertexStrideInBytes)
+        {
+            NullDraw(aPrimitiveCount);
+            gNullStatistics.UploadedBytes += (GetVertexCount(aType, aPrimitiveCount) * sizeof(u16));
+            gNullStatistics.UploadedBytes += (aVertexCount * aVertexStrideInBytes);
+        }
+
+        void Graphics::SetViewport(const Viewport& v)
+        {
+            if (v.X == gsViewport.X && v.Y == gsViewport.Y && 
+                v.Width == gsViewport.Width && v.Height == gsViewport.Height &&
+                v.MinZ == gsViewport.MinZ && v.MaxZ == gsViewport.MaxZ)
+            {
+                gNullStatistics.RedundantChanges[NullState::kViewport]++;
+            }
+            else
+            {
+                gsViewport = v;
+                gNullStatistics.Changes[NullState::kViewport]++;
+            }
+        }
+
+        void Graphics::EnableClipPlane(unatural aIndex)
+        {
+            NullSetState(NullState::kClipPlanes, Handle((uint)(1 << aIndex)));
+        }
+
+        void Graphics::DisableClipPlanes()
+        {
+            NullSetState(NullState::kClipPlanes, null);
+        }
+
+        void Graphics::SetClipPlane(unatural aIndex, const Vector4& v)
+        {
+            gNullStatistics.UploadedBytes += sizeof(Vector4);
+        }
+
+        void Graphics::BeginGraphicsEventMark(const string& s)
+        {}
+
+        void Graphics::EndGraphicsEventMark()
+        {}
+
+        void Graphics::_Load()
+        {
+            if (!mbLoaded)
+            {
+                for (Objects::iterator I = mObjects.begin(); I != mObjects.end(); I++)
+                {
+                    I->second->Load();
+                }
+
+                for (VolatileObjects::iterator I = mVolatileObjects.begin(); I != mVolatileObjects.end(); I++)
+                {
+                    I->second->Create();
+                }
+
+                OnLoad();
+                mbLoaded = true;
+            }
+        }
+
+        void Graphics::_Unload()
+        {
+            if (mbLoaded)
+            {
+                mbLoaded = false;
+                OnUnload();
+
+                for (VolatileObjects::reverse_iterator I = mVolatileObjects.rbegin(); I != mVolatileObjects.rend(); I++)
+                {
+                    I->second->Destroy();
+                }
+
+                for (Objects::reverse_iterator I = mObjects.rbegin(); I != mObjects.rend(); I++)
+                {
+                    I->second->Unload();
+                }
+            }
+        }
+
+        void Graphics::_ResetDevice()
+        {
+            if (mbNeedsResize)
+            {
+                mSettings.bIsFullscreen = mSettings.bWantsFullscreen;
+            }
+
+            _Lost();
+            _Load();
+            _Reset();
+        }
+
+        void Graphics::_RecalculateViewportSize()
+        {
+            mSettings.ViewportHeight = mSettings.WindowHeight - (mSettings.WindowBottomBorder + mSettings.WindowTopBorder);
+            mSettings.ViewportWidth  = mSettings.WindowWidth  - (mSettings.WindowLeftBorder   + mSettings.WindowRightBorder);
+        }
+        
+        void Graphics::_RecalculateWindowSize()
+        {
+            mSettings.WindowHeight = mSettings.ViewportHeight + (mSettings.WindowBottomBorder + mSettings.WindowTopBorder);
+            mSettings.WindowWidth  = mSettings.ViewportWidth  + (mSettings.WindowLeftBorder   + mSettings.WindowRightBorder);
+        }
+
+        // There is no window, the borders are zero and the viewport is the window.
+        void Graphics::_SetDefaultSettings()
+        {
+            mSettings.bIsFullscreen      = false;
+            mSettings.bWantsFullscreen   = false;
+            mSettings.FullscreenFormat   = 0;
+            mSettings.FullscreenWidth    = kDefaultViewportWidth;
+            mSettings.FullscreenHeight   = kDefaultViewportHeight;
+            mSettings.FullscreenRefresh  = 0;
+
+            mSettings.WindowX            = 0;
+            mSettings.WindowY            = 0;
+
+            mSettings.WindowLeftBorder   = 0;
+            mSettings.WindowRightBorder  = 0;
+            mSettings.WindowBottomBorder = 0;
+            mSettings.WindowTopBorder    = 0;
+
+            mSettings.WindowWidth        = kDefaultViewportWidth;
+            mSettings.WindowHeight       = kDefaultViewportHeight;
+
+            _RecalculateViewportSize();
+        }
+
+        uint Graphics::GetMaxTextureDimension() const
+        {
+            return kMaxTextureDimension;
+        }
+
+    }
+}
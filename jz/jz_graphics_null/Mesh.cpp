@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Memory.h>
+#include <jz_system/Files.h>
+#include <jz_system/ReadHelpers.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics/Mesh.h>
+#include <jz_graphics/VertexDeclaration.h>
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        Mesh::Mesh(const string& aFilename)
+            : IObject(aFilename),
+            mAABB(BoundingBox::kZero),
+            mBoundingSphere(BoundingSphere::kZero),
+            mPrimitiveCount(0),
+            mPrimitiveType((PrimitiveType::Enum)0),
+            mVertexCount(0),
+            mVertexStride(0)
+        {}
+        
+        Mesh::~Mesh()
+        {}
+
+        static VertexDeclarationPtr ReadVertexDeclaration(system::IReadFilePtr& pFile)
+        {
+            string filename = system::ReadString(pFile);
+            VertexDeclarationPtr pRet = Graphics::GetSingleton().Create<VertexDeclaration>(filename);
+
+            return pRet;
+        }
+
+        // Skips a buffer of aSizeInBytes, the null device does not keep mesh data.
+        static void SkipBuffer(system::IReadFilePtr& pFile, size_t aSizeInBytes)
+        {
+            if (aSizeInBytes > 0u)
+            {
+                JZ_E_ON_FAIL(pFile->Seek((natural)aSizeInBytes, true), "failed skipping mesh data.");
+                gNullStatistics.UploadedBytes += aSizeInBytes;
+            }
+        }
+
+        VertexDeclaration* Mesh::GetVertexDeclaration() const
+        {
+            return (mpVertexDeclaration.Get());
+        }
+
+        void Mesh::SetIndices() const
+        {
+            NullSetState(NullState::kIndices, this);
+        }
+
+        void Mesh::SetVertices() const
+        {
+            NullSetState(NullState::kVertices, this);
+        }
+
+        void Mesh::CalculateBoundings(const MemoryBuffer<Vector4>& aSkinning, BoundingBox& arAABB, BoundingSphere& arSphere) const
+        {
+            // Vertices are not kept, the rest pose boundings are the best available.
+            arAABB = mAABB;
+            arSphere = mBoundingSphere;
+        }
+
+        void Mesh::Draw() const
+        {
+            NullDraw(mPrimitiveCount);
+        }
+
+        void Mesh::Draw(natural aPrimitiveCount) const
+        {
+            NullDraw(aPrimitiveCount);
+        }
+
+        IObject::State Mesh::_Load()
+        {
+            using namespace system;
+
+            IReadFilePtr pFile;
+            try
+            {
+                pFile = Files::GetSingleton().Open(GetFilename().c_str());
+            }
+            catch (std::exception&)
+            {
+                return (kErrorFileNotFound);
+            }
+
+            try
+            {
+                mAABB = ReadBoundingBox(pFile);
+                mBoundingSphere = ReadBoundingSphere(pFile);
+                mPrimitiveCount = ReadInt32(pFile);
+                mPrimitiveType = (PrimitiveType::Enum)ReadInt32(pFile);
+                mVertexCount = ReadInt32(pFile);
+                mpVertexDeclaration = ReadVertexDeclaration(pFile);
+                mVertexStride = ReadInt32(pFile);
+
+                SkipBuffer(pFile, (ReadSizeT(pFile) * sizeof(u16)));
+                SkipBuffer(pFile, ReadSizeT(pFile));
+            }
+            catch (std::exception&)
+            {
+                _Clear();
+                return (kErrorDataRead);
+            }
+
+            return (kLost);
+        }
+
+        void Mesh::_Clear()
+        {
+            mAABB = BoundingBox::kZero;
+            mBoundingSphere = BoundingSphere::kZero;
+            mPrimitiveCount = 0;
+            mPrimitiveType = (PrimitiveType::Enum)0;
+            mVertexCount = 0;
+            mpVertexDeclaration.Reset();
+            mVertexStride = 0;
+        }
+
+        IObject::State Mesh::_Unload()
+        {
+            _Clear();
+
+            return (kUnloaded);
+        }
+
+    }
+}
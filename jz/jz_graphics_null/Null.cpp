@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        NullStatistics gNullStatistics = NullStatistics::Create();
+        static voidc_p gspStates[NullState::kCount];
+
+        const char* NullState::ToString(Enum v)
+        {
+    #       define JZ_HELPER(e) case k##e: return #e; break
+
+            switch (v)
+            {
+                JZ_HELPER(Effect);
+                JZ_HELPER(Technique);
+                JZ_HELPER(Indices);
+                JZ_HELPER(Vertices);
+                JZ_HELPER(VertexDeclaration);
+                JZ_HELPER(Target0);
+                JZ_HELPER(Target1);
+                JZ_HELPER(Target2);
+                JZ_HELPER(Target3);
+                JZ_HELPER(DepthStencil);
+                JZ_HELPER(Viewport);
+                JZ_HELPER(ClipPlanes);
+            default:
+                JZ_ASSERT(false);
+                return "";
+            }
+
+    #       undef JZ_HELPER
+        }
+
+        bool NullSetState(NullState::Enum aState, voidc_p apValue)
+        {
+            JZ_ASSERT(aState < NullState::kCount);
+
+            if (gspStates[aState] == apValue)
+            {
+                gNullStatistics.RedundantChanges[aState]++;
+                return false;
+            }
+            else
+            {
+                gspStates[aState] = apValue;
+                gNullStatistics.Changes[aState]++;
+                return true;
+            }
+        }
+
+        voidc_p NullGetState(NullState::Enum aState)
+        {
+            JZ_ASSERT(aState < NullState::kCount);
+
+            return (gspStates[aState]);
+        }
+
+        void NullClearStates()
+        {
+            for (size_t i = 0u; i < NullState::kCount; i++)
+            {
+                gspStates[i] = null;
+            }
+        }
+
+        void NullDraw(size_t aPrimitiveCount)
+        {
+            gNullStatistics.DrawCalls++;
+            gNullStatistics.Primitives += aPrimitiveCount;
+        }
+
+    }
+}
@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_GRAPHICS_NULL_NULL_H_
+#define _JZ_GRAPHICS_NULL_NULL_H_
+
+#include <jz_core/Prereqs.h>
+#include <jz_graphics/PrimitiveType.h>
+#include <cstring>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        namespace NullState
+        {
+            enum Enum
+            {
+                kEffect = 0,
+                kTechnique = 1,
+                kIndices = 2,
+                kVertices = 3,
+                kVertexDeclaration = 4,
+                kTarget0 = 5,
+                kTarget1 = 6,
+                kTarget2 = 7,
+                kTarget3 = 8,
+                kDepthStencil = 9,
+                kViewport = 10,
+                kClipPlanes = 11,
+                kCount = 12
+            };
+
+            const char* ToString(Enum v);
+        }
+
+        /// <summary>
+        /// Counts of the work submitted to the null device.
+        /// </summary>
+        /// <remarks>
+        /// Changes counts sets of a state to a new value, RedundantChanges sets of a
+        /// state to the value it already had. UploadedBytes counts effect parameter
+        /// data, user pointer vertices and indices and the contents of loaded or
+        /// created meshes and textures.
+        /// </remarks>
+        struct NullStatistics
+        {
+            static NullStatistics Create()
+            {
+                NullStatistics ret;
+                memset(&ret, 0, sizeof(NullStatistics));
+
+                return ret;
+            }
+
+            u64 Frames;
+            u64 Clears;
+            u64 DrawCalls;
+            u64 Primitives;
+            u64 EffectBegins;
+            u64 PassBegins;
+            u64 Commits;
+            u64 ParameterSets;
+            u64 TextureSets;
+            u64 Changes[NullState::kCount];
+            u64 RedundantChanges[NullState::kCount];
+            u64 UploadedBytes;
+        };
+
+        extern NullStatistics gNullStatistics;
+
+        // Sets aState to apValue, returns false and counts a redundant change if
+        // apValue was already set.
+        bool NullSetState(NullState::Enum aState, voidc_p apValue);
+        voidc_p NullGetState(NullState::Enum aState);
+
+        // Restores every state to its initial (null) value, as a device reset would.
+        void NullClearStates();
+
+        void NullDraw(size_t aPrimitiveCount);
+
+        __inline size_t GetVertexCount(PrimitiveType::Enum aType, size_t aPrimitiveCount)
+        {
+            switch (aType)
+            {
+            case PrimitiveType::kPointList: return (aPrimitiveCount);
+            case PrimitiveType::kLineList: return (aPrimitiveCount * 2u);
+            case PrimitiveType::kLineStrip: return (aPrimitiveCount + 1u);
+            case PrimitiveType::kTriangleList: return (aPrimitiveCount * 3u);
+            case PrimitiveType::kTriangleStrip: return (aPrimitiveCount + 2u);
+            case PrimitiveType::kTriangleFan: return (aPrimitiveCount + 2u);
+            default:
+                JZ_ASSERT(false);
+                return 0u;
+            }
+        }
+
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_graphics/OcclusionQuery.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        OcclusionQuery::OcclusionQuery()
+            : mLastPixelCount(0u)
+        {}
+
+        OcclusionQuery::~OcclusionQuery()
+        {}
+
+        bool OcclusionQuery::Begin()
+        {
+            return IsReset();
+        }
+
+        void OcclusionQuery::End()
+        {
+            JZ_ASSERT(IsReset());
+        }
+
+        bool OcclusionQuery::IsComplete() const
+        {
+            return IsReset();
+        }
+
+        // Nothing is rasterized, queries report the whole viewport as visible so
+        // nothing is culled by them.
+        unatural OcclusionQuery::GetPixelCount() const
+        {
+            if (IsReset())
+            {
+                Graphics& graphics = Graphics::GetSingleton();
+
+                return ((unatural)(graphics.GetViewportWidth() * graphics.GetViewportHeight()));
+            }
+
+            return (mLastPixelCount);
+        }
+
+        void OcclusionQuery::_Create()
+        {}
+
+        void OcclusionQuery::_Destroy()
+        {}
+
+        void OcclusionQuery::_Lost()
+        {}
+        
+        void OcclusionQuery::_Reset(natural aWidth, natural aHeight)
+        {}
+
+    }
+}
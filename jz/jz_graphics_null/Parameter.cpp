@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_graphics/Parameter.h>
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        static void Record(Handle e, Handle p, size_t aSizeInBytes)
+        {
+            if (e && p)
+            {
+                gNullStatistics.ParameterSets++;
+                gNullStatistics.UploadedBytes += aSizeInBytes;
+            }
+        }
+
+        static void RecordTexture(Handle e, Handle p)
+        {
+            if (e && p)
+            {
+                gNullStatistics.TextureSets++;
+            }
+        }
+
+        void __SetParameterValue(Handle e, Handle p, bool v)
+        {
+            // Effect booleans are 32-bit.
+            Record(e, p, sizeof(u32));
+        }
+
+        void __SetParameterValue(Handle e, Handle p, float v)
+        {
+            Record(e, p, sizeof(float));
+        }
+
+        void __SetParameterValue(Handle e, Handle p, voidc_p v, size_t aSizeInBytes)
+        {
+            Record(e, p, aSizeInBytes);
+        }
+
+        void __SetParameterValue(Handle e, Handle p, float const* v, size_t aNumberOfSingles)
+        {
+            Record(e, p, (aNumberOfSingles * sizeof(float)));
+        }
+
+        void __SetParameterValue(Handle e, Handle p, const Matrix4& v)
+        {
+            Record(e, p, sizeof(Matrix4));
+        }
+
+        void __SetParameterValue(Handle e, Handle p, Matrix4 const* v, size_t aNumberOfMatrix4)
+        {
+            Record(e, p, (aNumberOfMatrix4 * sizeof(Matrix4)));
+        }
+
+        void __SetParameterValue(Handle e, Handle p, Vector4 const* v, size_t aNumberOfVector4)
+        {
+            Record(e, p, (aNumberOfVector4 * sizeof(Vector4)));
+        }
+
+        void __SetParameterValue(Handle e, Handle p, Target* v)
+        {
+            RecordTexture(e, p);
+        }
+
+        void __SetParameterValue(Handle e, Handle p, Texture* v)
+        {
+            RecordTexture(e, p);
+        }
+
+        void __SetParameterValue(Handle e, Handle p, VolatileTexture* v)
+        {
+            RecordTexture(e, p);
+        }
+
+    }
+}
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Memory.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics/SystemMemorySurface.h>
+#include <jz_graphics_null/Null.h>
+#include <cstring>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        static unatural GetBytesPerPixel(SystemMemorySurface::Format aFormat)
+        {
+            switch (aFormat)
+            {
+            case SystemMemorySurface::kR3G3B2:
+            case SystemMemorySurface::kA8:
+                return 1u;
+            case SystemMemorySurface::kR16F:
+            case SystemMemorySurface::kR5G6B5:
+            case SystemMemorySurface::kX1R5G5B5:
+            case SystemMemorySurface::kA1R5G5B5:
+            case SystemMemorySurface::kA4R4G4B4:
+            case SystemMemorySurface::kA8R3G3B2:
+            case SystemMemorySurface::kX4R4G4B4:
+                return 2u;
+            case SystemMemorySurface::kA8R8G8B8:
+            case SystemMemorySurface::kX8R8G8B8:
+            case SystemMemorySurface::kA2B10G10R10:
+            case SystemMemorySurface::kA8B8G8R8:
+            case SystemMemorySurface::kX8B8G8R8:
+            case SystemMemorySurface::kG16R16:
+            case SystemMemorySurface::kA2R10G10B10:
+                return 4u;
+            case SystemMemorySurface::kA16B16G16R16F:
+            case SystemMemorySurface::kA16B16G16R16:
+                return 8u;
+            default:
+                JZ_ASSERT(false);
+                return 4u;
+            }
+        }
+
+        struct Surface
+        {
+            Surface(unatural aWidth, unatural aHeight, unatural aBytesPerPixel)
+                : Pitch(aWidth * aBytesPerPixel), Data(aWidth * aHeight * aBytesPerPixel)
+            {
+                memset(Data.Get(), 0, Data.GetSizeInBytes());
+            }
+
+            unatural Pitch;
+            ByteBuffer Data;
+        };
+
+        SystemMemorySurface::SystemMemorySurface(unatural aWidth, unatural aHeight, Format aFormat)
+            : mWidth(aWidth), mHeight(aHeight), mFormat(aFormat)
+        {}
+
+        SystemMemorySurface::~SystemMemorySurface()
+        {}
+
+        void SystemMemorySurface::Lock(const RectangleU& aRect, u32 aLockFlags, void_p& arpLock, unatural& arPitch)
+        {
+            Surface* p = StaticCast<Surface*>(mpSurface);
+            JZ_ASSERT(p);
+
+            arpLock = (p->Data.Get() + (aRect.Top * p->Pitch) + (aRect.Left * GetBytesPerPixel(mFormat)));
+            arPitch = p->Pitch;
+        }
+
+        void SystemMemorySurface::Unlock()
+        {}
+
+        // There is no backbuffer to read, the surface keeps its contents.
+        void SystemMemorySurface::PopulateFromBackbuffer()
+        {}
+
+        void SystemMemorySurface::_Create()
+        {
+        }
+
+        void SystemMemorySurface::_Destroy()
+        {
+        }
+
+        void SystemMemorySurface::_Lost()
+        {
+            SafeDelete<Surface>(mpSurface);
+        }
+        
+        void SystemMemorySurface::_Reset(natural aWidth, natural aHeight)
+        {
+            unatural width = (mWidth > 0u) ? mWidth : aWidth;
+            unatural height = (mHeight > 0u) ? mHeight : aHeight;
+
+            mpSurface = new Surface(width, height, GetBytesPerPixel(mFormat));
+        }
+
+    }
+}
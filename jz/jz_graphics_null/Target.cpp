@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics/Target.h>
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        static const unatural kMaxTargets = 4u;
+
+        Target::Target(unatural aWidth, unatural aHeight, Format aFormat, float aScaling)
+            : mWidth(aWidth), mHeight(aHeight), mFormat(aFormat), mScaling(aScaling)
+        {}
+
+        Target::~Target()
+        {}
+
+        void Target::SetToDevice(unatural aTargetIndex)
+        {
+            JZ_ASSERT(aTargetIndex < kMaxTargets);
+
+            NullSetState((NullState::Enum)(NullState::kTarget0 + aTargetIndex), this);
+        }
+
+        // The backbuffer is the null value of target 0.
+        void Target::ResetTarget(unatural aTargetIndex)
+        {
+            JZ_ASSERT(aTargetIndex < kMaxTargets);
+
+            NullSetState((NullState::Enum)(NullState::kTarget0 + aTargetIndex), null);
+        }
+
+        void Target::_Create()
+        {}
+
+        void Target::_Destroy()
+        {}
+
+        void Target::_Lost()
+        {}
+        
+        void Target::_Reset(natural aWidth, natural aHeight)
+        {}
+
+    }
+}
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Memory.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics/VertexDeclaration.h>
+#include <jz_graphics/VolatileMesh.h>
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        VolatileMesh::VolatileMesh(size_t aIndexBufferSizeInBytes, size_t aVertexBufferSizeInBytes, 
+                PopulateFunction aIndexBufferPopulate,
+                PopulateFunction aVertexBufferPopulate)
+            : mPrimitiveCount(0),
+              mPrimitiveType((PrimitiveType::Enum)0),
+              mVertexCount(0),
+              mVertexStride(0),
+              mpVertexDeclaration(null),
+              mIndexBufferSizeInBytes(aIndexBufferSizeInBytes),
+              mVertexBufferSizeInBytes(aVertexBufferSizeInBytes),
+              mPopulateIndices(aIndexBufferPopulate),
+              mPopulateVertices(aVertexBufferPopulate)
+        {}
+
+        VolatileMesh::~VolatileMesh()
+        {}
+
+        void VolatileMesh::SetVertexDeclaration(VertexDeclaration* p)
+        {
+            mpVertexDeclaration.Reset(p);
+        }
+
+        VertexDeclaration* VolatileMesh::GetVertexDeclaration() const
+        {
+            return (mpVertexDeclaration.Get());
+        }
+
+        void VolatileMesh::SetIndices() const
+        {
+            NullSetState(NullState::kIndices, this);
+        }
+
+        void VolatileMesh::SetVertices() const
+        {
+            NullSetState(NullState::kVertices, this);
+        }
+
+        void VolatileMesh::Draw() const
+        {
+            NullDraw(mPrimitiveCount);
+        }
+
+        void VolatileMesh::Draw(natural aPrimitiveCount) const
+        {
+            NullDraw(aPrimitiveCount);
+        }
+
+        void VolatileMesh::SetSizes(size_t aIndexBufferSizeInBytes, size_t aVertexBufferSizeInBytes)
+        {
+            Lost();
+            Destroy();
+
+            mIndexBufferSizeInBytes = aIndexBufferSizeInBytes;
+            mVertexBufferSizeInBytes = aVertexBufferSizeInBytes;
+
+            if (!Graphics::GetSingleton().IsLost()) { Reset(Graphics::GetSingleton().GetViewportWidth(), Graphics::GetSingleton().GetViewportHeight()); }
+            if (Graphics::GetSingleton().IsLoaded()) { Create(); }
+        }
+
+        // The populate functions run into scratch memory that is dropped after,
+        // so their CPU cost is still measured.
+        static void Populate(const VolatileMesh::PopulateFunction& aFunction, size_t aSizeInBytes)
+        {
+            if (aSizeInBytes > 0u)
+            {
+                if (aFunction)
+                {
+                    ByteBuffer buf(aSizeInBytes);
+                    aFunction(aSizeInBytes, buf.Get());
+                }
+
+                gNullStatistics.UploadedBytes += aSizeInBytes;
+            }
+        }
+
+        void VolatileMesh::_Create()
+        {
+            Populate(mPopulateIndices, mIndexBufferSizeInBytes);
+            Populate(mPopulateVertices, mVertexBufferSizeInBytes);
+        }
+
+        void VolatileMesh::_Destroy()
+        {}
+
+        void VolatileMesh::_Lost()
+        {}
+        
+        void VolatileMesh::_Reset(natural aWidth, natural aHeight)
+        {}
+
+    }
+}
@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Memory.h>
+#include <jz_graphics/Graphics.h>
+#include <jz_graphics/VolatileTexture.h>
+#include <jz_graphics_null/Null.h>
+
+namespace jz
+{
+    namespace graphics
+    {
+
+        static unatural GetBytesPerPixel(VolatileTexture::Format aFormat)
+        {
+            switch (aFormat)
+            {
+            case VolatileTexture::kR3G3B2:
+            case VolatileTexture::kA8:
+                return 1u;
+            case VolatileTexture::kR5G6B5:
+            case VolatileTexture::kX1R5G5B5:
+            case VolatileTexture::kA1R5G5B5:
+            case VolatileTexture::kA4R4G4B4:
+            case VolatileTexture::kA8R3G3B2:
+            case VolatileTexture::kX4R4G4B4:
+            case VolatileTexture::kR16F:
+                return 2u;
+            case VolatileTexture::kA8R8G8B8:
+            case VolatileTexture::kX8R8G8B8:
+            case VolatileTexture::kA2B10G10R10:
+            case VolatileTexture::kA8B8G8R8:
+            case VolatileTexture::kX8B8G8R8:
+            case VolatileTexture::kG16R16:
+            case VolatileTexture::kA2R10G10B10:
+            case VolatileTexture::kG16R16F:
+            case VolatileTexture::kR32F:
+                return 4u;
+            case VolatileTexture::kA16B16G16R16:
+            case VolatileTexture::kA16B16G16R16F:
+            case VolatileTexture::kG32R32F:
+                return 8u;
+            case VolatileTexture::kA32B32G32R32F:
+                return 16u;
+            default:
+                JZ_ASSERT(false);
+                return 4u;
+            }
+        }
+
+        VolatileTexture::VolatileTexture(unatural aWidth, unatural aHeight, Format aFormat, PopulateFunction aFunction, float aScaling)
+            : mWidth(aWidth), mHeight(aHeight), mFormat(aFormat), mPopulateFunction(aFunction), mScaling(aScaling)
+        {}
+
+        VolatileTexture::~VolatileTexture()
+        {}
+
+        void VolatileTexture::_Create()
+        {
+            if (mWidth != 0u && mHeight != 0u)
+            {
+                _CreateHelper(mWidth, mHeight);
+            }
+        }
+
+        void VolatileTexture::_Destroy()
+        {}
+
+        void VolatileTexture::_Lost()
+        {}
+        
+        void VolatileTexture::_Reset(natural aWidth, natural aHeight)
+        {
+            if (mWidth == 0u || mHeight == 0u)
+            {
+                unatural width = ((unatural)(aWidth * mScaling));
+                unatural height = ((unatural)(aHeight * mScaling));
+
+                _CreateHelper(width, height);
+            }
+        }
+
+        // Texels are written to a scratch buffer and discarded.
+        void VolatileTexture::_CreateHelper(unatural width, unatural height)
+        {
+            const size_t kPitch = (width * GetBytesPerPixel(mFormat));
+            const size_t kSizeInBytes = (kPitch * height);
+
+            if (mPopulateFunction && kSizeInBytes > 0u)
+            {
+                ByteBuffer buf(kSizeInBytes);
+                mPopulateFunction(width, height, buf.Get(), kPitch);
+            }
+
+            gNullStatistics.UploadedBytes += kSizeInBytes;
+        }
+
+    }
+}
@@ -92,7 +92,7 @@ namespace jz
             }
             catch (exception& e)
             {
-                LogMessage(__FUNCTION__ ": \"" + GetFilename() + "\": " + string(e.what()), Logger::kError);
+                JZ_LOG(Logger::kGraphics, Logger::kError, "%: \"%\": %", __FUNCTION__, GetFilename(), e.what());
                 return (kErrorDataRead);
             }
 
@@ -36,7 +36,7 @@
 
 namespace jz
 {
-    graphics::Graphics* graphics::Graphics::mspSingleton = null;
+    template <> graphics::Graphics* Singleton<graphics::Graphics>::mspSingleton = null;
     namespace graphics
     {
 
@@ -479,7 +479,7 @@ namespace jz
 
             if (!EnumDisplaySettings(null, ENUM_CURRENT_SETTINGS, &dm))
             {
-                LogMessage(__FUNCTION__ ": failed enumerating mode settings.", Logger::kError);
+                JZ_LOG(Logger::kGraphics, Logger::kError, "%: failed enumerating mode settings.", __FUNCTION__);
                 mSettings.bWantsFullscreen = false;
             }
             else
@@ -490,7 +490,7 @@ namespace jz
 
                 if (ChangeDisplaySettings(&dm, CDS_FULLSCREEN) != DISP_CHANGE_SUCCESSFUL)
                 {
-                    LogMessage(__FUNCTION__ ": change to fullscreen mode failed.", Logger::kError);
+                    JZ_LOG(Logger::kGraphics, Logger::kError, "%: change to fullscreen mode failed.", __FUNCTION__);
                     mSettings.bWantsFullscreen = false;
                 }
             }
@@ -605,7 +605,7 @@ namespace jz
                     }
                     catch (exception& e)
                     {
-                        LogMessage(e.what());
+                        JZ_LOG(Logger::kGraphics, Logger::kNormal, "%", e.what());
                         mSettings.bWantsFullscreen = false;
                         mSettings.bIsFullscreen = false;
                         return;
@@ -642,7 +642,7 @@ namespace jz
                 }
                 catch (exception& e)
                 {
-                    LogMessage(e.what());
+                    JZ_LOG(Logger::kGraphics, Logger::kNormal, "%", e.what());
                     mbActive = false;
                     return;
                 }
@@ -670,7 +670,7 @@ namespace jz
                 if (!SetPixelFormat(gspDeviceContext, pixelFormat, &pixelFormatDescriptor))
                 {
                     ReleaseDeviceContext();
-                    LogMessage(__FUNCTION__ ": failed setting pixel format.", Logger::kError);
+                    JZ_LOG(Logger::kGraphics, Logger::kError, "%: failed setting pixel format.", __FUNCTION__);
                     Sleep(100);
                     return;
                 }
@@ -682,7 +682,7 @@ namespace jz
                 if (!wglMakeCurrent(gspDeviceContext, gspOpenGLContext))
                 {
                     DestroyOpenGLContext();
-                    LogMessage(__FUNCTION__ ": failed making open gl context current.", Logger::kError);
+                    JZ_LOG(Logger::kGraphics, Logger::kError, "%: failed making open gl context current.", __FUNCTION__);
                     Sleep(100);
                     return;
                 }
@@ -179,7 +179,7 @@ namespace jz
                 mBoundingSphere = BoundingSphere::kZero;
                 mAABB = BoundingBox::kZero;
 
-                LogMessage(e.what(), Logger::kError);
+                JZ_LOG(Logger::kGraphics, Logger::kError, "%", e.what());
                 return (kErrorDataRead);
             }
 
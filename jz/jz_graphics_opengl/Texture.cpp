@@ -48,7 +48,7 @@ namespace jz
             }
             catch (exception& e)
             {
-                LogMessage(e.what(), Logger::kError);
+                JZ_LOG(Logger::kGraphics, Logger::kError, "%", e.what());
                 return (kErrorDataRead);
             }
 
@@ -22,7 +22,6 @@
 
 #include <jz_core/Logger.h>
 #include <jz_core/Memory.h>
-#include <jz_core/StringUtility.h>
 #include <jz_graphics/VertexDeclaration.h>
 #include <jz_graphics_opengl/OpenGL.h>
 #include <jz_system/Files.h>
@@ -53,6 +52,18 @@ namespace jz
             size_t VertexStrideInBytes;
         };
 
+    }
+
+    namespace system
+    {
+        // Element mixes field widths, so it is read as bytes and _Load() swaps its 16-bit
+        // fields.
+        template <> struct ByteOrder<graphics::Element> { enum { kWordSize = sizeof(u8) }; };
+    }
+
+    namespace graphics
+    {
+
         VertexDeclaration::VertexDeclaration(const string& aFilename)
             : IObject(aFilename)
         {}
@@ -95,7 +106,7 @@ namespace jz
             // 12, DEPTH, not supported.
             // 13, SAMPLE, not supported.
             default:
-                LogMessage("Invalid vertex attrib index: " + StringUtility::ToString(v.Usage));
+                JZ_LOG(Logger::kGraphics, Logger::kNormal, "Invalid vertex attrib index: %", v.Usage);
                 return 0;
             }
         }
@@ -118,7 +129,7 @@ namespace jz
                 case 11: return 2; break; // USHORT2N
                 case 12: return 4; break; // USHORT4N
                 default:
-                    LogMessage("Invalid vertex type: " + StringUtility::ToString(v.Type));
+                    JZ_LOG(Logger::kGraphics, Logger::kNormal, "Invalid vertex type: %", v.Type);
                     return 0;
             }
         }
@@ -141,7 +152,7 @@ namespace jz
                 case 11: return (2 * sizeof(u16)); break; // USHORT2N
                 case 12: return (4 * sizeof(u16)); break; // USHORT4N
                 default:
-                    LogMessage("Invalid vertex type: " + StringUtility::ToString(v.Type));
+                    JZ_LOG(Logger::kGraphics, Logger::kNormal, "Invalid vertex type: %", v.Type);
                     return 0;
             }
         }
@@ -164,7 +175,7 @@ namespace jz
                 case 11: return GL_UNSIGNED_SHORT; break; // USHORT2N
                 case 12: return GL_UNSIGNED_SHORT; break; // USHORT4N
                 default:
-                    LogMessage("Invalid vertex type: " + StringUtility::ToString(v.Type));
+                    JZ_LOG(Logger::kGraphics, Logger::kNormal, "Invalid vertex type: %", v.Type);
                     return 0;
             }
         }
@@ -187,7 +198,7 @@ namespace jz
                 case 11: return true; break; // USHORT2N
                 case 12: return true; break; // USHORT4N
                 default:
-                    LogMessage("Invalid vertex type: " + StringUtility::ToString(v.Type));
+                    JZ_LOG(Logger::kGraphics, Logger::kNormal, "Invalid vertex type: %", v.Type);
                     return 0;
             }
         }
@@ -237,6 +248,14 @@ namespace jz
                 system::ReadBuffer(pFile, pData->Elements);
                 const size_t kSize = pData->Elements.size();
 
+#               if JZ_BIG_ENDIAN
+                    for (size_t i = 0u; i < kSize; i++)
+                    {
+                        system::SwapByteOrder(&(pData->Elements[i].Stream), sizeof(u16), 1u);
+                        system::SwapByteOrder(&(pData->Elements[i].Offset), sizeof(u16), 1u);
+                    }
+#               endif
+
                 if (pData->Elements.size() > 0u)
                 {
                     const Element& e = (pData->Elements[pData->Elements.size() - 1u]);
@@ -251,7 +270,7 @@ namespace jz
             {
                 SafeDelete(pData);
                 
-                LogMessage(e.what(), Logger::kError);
+                JZ_LOG(Logger::kGraphics, Logger::kError, "%", e.what());
                 return (kErrorDataRead);
             }
 
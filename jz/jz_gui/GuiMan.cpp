@@ -28,7 +28,7 @@
 
 namespace jz
 {
-    gui::GuiMan* gui::GuiMan::mspSingleton = null;
+    template <> gui::GuiMan* Singleton<gui::GuiMan>::mspSingleton = null;
 
     namespace gui
     {
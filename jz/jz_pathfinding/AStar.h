@@ -109,7 +109,7 @@ namespace jz
                         float curG = (g[x] + dis);
 
                         // Find node in open set using linear search.
-                        set<PathHelper>::iterator I = open.end();
+                        typename set<PathHelper>::iterator I = open.end();
                         for (I = open.begin(); I != open.end(); I++) { if (I->I == y) { break; } }
 
                         if (I == open.end())
@@ -43,7 +43,8 @@ namespace jz
     {
 
         const Vector3 World3D::kDefaultGravity = Vector3(0, -9.8f, 0);
-        const float World3D::kTimeStep = (float)(1.0 / 60.0);
+        const s64 World3D::kTimeStepNanoseconds = (system::Time::kNanosecondsPerSecond / 60);
+        const float World3D::kTimeStep = (float)(double(kTimeStepNanoseconds) / double(system::Time::kNanosecondsPerSecond));
 
         World3D::World3D()
             : 
@@ -52,7 +53,7 @@ namespace jz
                 mAverageCollisionPairs(0u),
 #           endif
             mGravity(kDefaultGravity),
-            mTimePool(0.0f),
+            mStep(kTimeStepNanoseconds),
             mUnitMeter(1.0f)
         {
             Sap3D* p = new Sap3D();
@@ -123,18 +124,16 @@ namespace jz
             ToMatrix(q0, arOut.Orientation);
         }
 
-        void World3D::Tick(float aTimeStep)
+        void World3D::Tick(s64 aElapsedNanoseconds)
         {
-            mTimePool += aTimeStep;
+            const uint kSteps = mStep.Advance(aElapsedNanoseconds);
 
-            while (mTimePool > kTimeStep)
+            for (uint step = 0u; step < kSteps; step++)
             {
 #           if JZ_PROFILING
                 mAverageCollisionPairs = 0u;
 #           endif
 
-                mTimePool -= kTimeStep;
-
                 const size_t kSize = mBodies.size();
                 for (size_t i = 0u; i < kSize; i++)
                 {
@@ -27,6 +27,7 @@
 #include <jz_core/Auto.h>
 #include <jz_core/BoundingBox.h>
 #include <jz_core/Vector3.h>
+#include <jz_system/Time.h>
 #include <vector>
 
 namespace jz
@@ -42,6 +43,7 @@ namespace jz
         {
         public:
             static const Vector3 kDefaultGravity;
+            static const s64 kTimeStepNanoseconds;
             static const float kTimeStep;
 
             World3D();
@@ -55,7 +57,8 @@ namespace jz
             Vector3 GetGravity() const { return (mGravity / mUnitMeter); }
             void SetGravity(const Vector3& g) { mGravity = (mUnitMeter * g); }
 
-            void Tick(float aTimeStep);
+            // Runs as many fixed steps of kTimeStep as the elapsed time covers.
+            void Tick(s64 aElapsedNanoseconds);
 
 #           if JZ_PROFILING
                 unatural AverageCollisionPairs;
@@ -70,7 +73,7 @@ namespace jz
             IBroadphase3DPtr mpBroadphase;
             Bodies mBodies;
             Vector3 mGravity;
-            float mTimePool;
+            system::FixedTimestep mStep;
             float mUnitMeter;
 
         protected:
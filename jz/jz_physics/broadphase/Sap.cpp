@@ -75,10 +75,16 @@ namespace jz
 
             abr = BoundingBox::Clamp(abr, kMaximumBounding);
 
-            ushort handle = (ushort)mBoxes.Add(BoxEntry(apCollideable, aType, aCollidesWith));
+            SlotMap<BoxEntry>::handle_type boxHandle = mBoxes.Add(BoxEntry(apCollideable, aType, aCollidesWith));
 
             // I don't like this. Need a more graceful way of handling this.
-            if (handle == EndPoint::kSentinelId) { throw exception("exceeded maximum number of physical objects."); }
+            if (SlotMap<BoxEntry>::GetIndex(boxHandle) >= EndPoint::kSentinelId)
+            {
+                mBoxes.Remove(boxHandle);
+                throw JZ_EXCEPTION("exceeded maximum number of physical objects.");
+            }
+
+            ushort handle = (ushort)SlotMap<BoxEntry>::GetIndex(boxHandle);
 
             for (int i = 0; i < 3; i++)
             {
@@ -88,8 +94,8 @@ namespace jz
                 mAxes[i].push_back(EndPoint(true, handle, EndPoint::kSentinelMax - 1));
                 mAxes[i].push_back(EndPoint(true, EndPoint::kSentinelId, EndPoint::kSentinelMax));
 
-                mBoxes[handle].SetMin(i, min);
-                mBoxes[handle].SetMax(i, max);
+                mBoxes.GetByIndex(handle).SetMin(i, min);
+                mBoxes.GetByIndex(handle).SetMax(i, max);
             }
 
             Update(handle, aBounding);
@@ -135,12 +141,12 @@ namespace jz
             // If in the pair remove cache, this entry is going to be removed anyway so don't update.
             if (!mPairRemoveCache[aHandle])
             {
-                _UpdateHelper(aHandle, Axis::kX, mBoxes[aHandle].MinX, GetSortableUintFromFloat(bb.Min.X));
-                _UpdateHelper(aHandle, Axis::kX, mBoxes[aHandle].MaxX, GetSortableUintFromFloat(bb.Max.X));
-                _UpdateHelper(aHandle, Axis::kY, mBoxes[aHandle].MinY, GetSortableUintFromFloat(bb.Min.Y));
-                _UpdateHelper(aHandle, Axis::kY, mBoxes[aHandle].MaxY, GetSortableUintFromFloat(bb.Max.Y));
-                _UpdateHelper(aHandle, Axis::kZ, mBoxes[aHandle].MinZ, GetSortableUintFromFloat(bb.Min.Z));
-                _UpdateHelper(aHandle, Axis::kZ, mBoxes[aHandle].MaxZ, GetSortableUintFromFloat(bb.Max.Z));
+                _UpdateHelper(aHandle, Axis::kX, mBoxes.GetByIndex(aHandle).MinX, GetSortableUintFromFloat(bb.Min.X));
+                _UpdateHelper(aHandle, Axis::kX, mBoxes.GetByIndex(aHandle).MaxX, GetSortableUintFromFloat(bb.Max.X));
+                _UpdateHelper(aHandle, Axis::kY, mBoxes.GetByIndex(aHandle).MinY, GetSortableUintFromFloat(bb.Min.Y));
+                _UpdateHelper(aHandle, Axis::kY, mBoxes.GetByIndex(aHandle).MaxY, GetSortableUintFromFloat(bb.Max.Y));
+                _UpdateHelper(aHandle, Axis::kZ, mBoxes.GetByIndex(aHandle).MinZ, GetSortableUintFromFloat(bb.Min.Z));
+                _UpdateHelper(aHandle, Axis::kZ, mBoxes.GetByIndex(aHandle).MaxZ, GetSortableUintFromFloat(bb.Max.Z));
             }
         }
 
@@ -160,24 +166,24 @@ namespace jz
 
                 if (!data[j + 1].IsMax())
                 {
-                    mBoxes[jhandle].AdjustMin(axis0, 1);
+                    mBoxes.GetByIndex(jhandle).AdjustMin(axis0, 1);
 
                     // Note: Collideable() test is not used for removes as it allows the
                     //  type or collideable masks to be changed for an object while it is
                     //  colliding.
-                    if (TwoSidedIntersect(mBoxes[nhandle], mBoxes[jhandle], axis1, axis2))
+                    if (TwoSidedIntersect(mBoxes.GetByIndex(nhandle), mBoxes.GetByIndex(jhandle), axis1, axis2))
                     {
                         mPairs.Remove(nhandle, jhandle);
                     }
                 }
                 else
                 {
-                    mBoxes[jhandle].AdjustMax(axis0, 1);
+                    mBoxes.GetByIndex(jhandle).AdjustMax(axis0, 1);
                 }
             }
 
             data[j + 1] = n;
-            mBoxes[nhandle].SetMax(axis0, j + 1);
+            mBoxes.GetByIndex(nhandle).SetMax(axis0, j + 1);
         }
 
         void Sap3D::_MoveMaxRight(int axis0, EndPoint& n, int startIndex)
@@ -196,26 +202,26 @@ namespace jz
 
                 if (!data[j - 1].IsMax())
                 {
-                    mBoxes[jhandle].AdjustMin(axis0, -1);
+                    mBoxes.GetByIndex(jhandle).AdjustMin(axis0, -1);
 
-                    if (Collideable(mBoxes[nhandle], mBoxes[jhandle])
+                    if (Collideable(mBoxes.GetByIndex(nhandle), mBoxes.GetByIndex(jhandle))
                         // Note that the order of parameters to OneSidedIntersect matters.
                         // In this case, we are checking the minimum of the box we
                         // are updating against the maximum of the current box.
-                        && OneSidedIntersect(mBoxes[nhandle], mBoxes[jhandle], axis0)
-                        && TwoSidedIntersect(mBoxes[nhandle], mBoxes[jhandle], axis1, axis2))
+                        && OneSidedIntersect(mBoxes.GetByIndex(nhandle), mBoxes.GetByIndex(jhandle), axis0)
+                        && TwoSidedIntersect(mBoxes.GetByIndex(nhandle), mBoxes.GetByIndex(jhandle), axis1, axis2))
                     {
                         mPairs.Add(nhandle, jhandle);
                     }
                 }
                 else
                 {
-                    mBoxes[jhandle].AdjustMax(axis0, -1);
+                    mBoxes.GetByIndex(jhandle).AdjustMax(axis0, -1);
                 }
             }
 
             data[j - 1] = n;
-            mBoxes[nhandle].SetMax(axis0, j - 1);
+            mBoxes.GetByIndex(nhandle).SetMax(axis0, j - 1);
         }
 
         void Sap3D::_MoveMinLeft(int axis0, EndPoint& n, int startIndex)
@@ -234,26 +240,26 @@ namespace jz
 
                 if (data[j + 1].IsMax())
                 {
-                    mBoxes[jhandle].AdjustMax(axis0, 1);
+                    mBoxes.GetByIndex(jhandle).AdjustMax(axis0, 1);
 
-                    if (Collideable(mBoxes[nhandle], mBoxes[jhandle])
+                    if (Collideable(mBoxes.GetByIndex(nhandle), mBoxes.GetByIndex(jhandle))
                         // Note that the order of parameters to OneSidedIntersect matters.
                         // In this case, we are checking the maximum of the box we
                         // are updating against the minimum of the current box.
-                        && OneSidedIntersect(mBoxes[jhandle], mBoxes[nhandle], axis0)
-                        && TwoSidedIntersect(mBoxes[nhandle], mBoxes[jhandle], axis1, axis2))
+                        && OneSidedIntersect(mBoxes.GetByIndex(jhandle), mBoxes.GetByIndex(nhandle), axis0)
+                        && TwoSidedIntersect(mBoxes.GetByIndex(nhandle), mBoxes.GetByIndex(jhandle), axis1, axis2))
                     {
                         mPairs.Add(nhandle, jhandle);
                     }
                 }
                 else
                 {
-                    mBoxes[jhandle].AdjustMin(axis0, 1);
+                    mBoxes.GetByIndex(jhandle).AdjustMin(axis0, 1);
                 }
             }
 
             data[j + 1] = n;
-            mBoxes[nhandle].SetMin(axis0, j + 1);
+            mBoxes.GetByIndex(nhandle).SetMin(axis0, j + 1);
         }
 
         void Sap3D::_MoveMinRight(int axis0, EndPoint& n, int startIndex)
@@ -272,24 +278,24 @@ namespace jz
 
                 if (data[j - 1].IsMax())
                 {
-                    mBoxes[jhandle].AdjustMax(axis0, -1);
+                    mBoxes.GetByIndex(jhandle).AdjustMax(axis0, -1);
 
                     // Note: Collideable() test is not used for removes as it allows the
                     //  type or collideable masks to be changed for an object while it is
                     //  colliding.
-                    if (TwoSidedIntersect(mBoxes[nhandle], mBoxes[jhandle], axis1, axis2))
+                    if (TwoSidedIntersect(mBoxes.GetByIndex(nhandle), mBoxes.GetByIndex(jhandle), axis1, axis2))
                     {
                         mPairs.Remove(nhandle, jhandle);
                     }
                 }
                 else
                 {
-                    mBoxes[jhandle].AdjustMin(axis0, -1);
+                    mBoxes.GetByIndex(jhandle).AdjustMin(axis0, -1);
                 }
             }
 
             data[j - 1] = n;
-            mBoxes[nhandle].SetMin(axis0, j - 1);
+            mBoxes.GetByIndex(nhandle).SetMin(axis0, j - 1);
         }
 
         void Sap3D::_RemoveHelper(vector<int>& aToRemoves, int axis)
@@ -313,8 +319,8 @@ namespace jz
                     for (int j = start; j <= end; j++)
                     {
                         a[j] = a[j + offset];
-                        if (a[j].IsMax()) { mBoxes[a[j].OwnerId()].AdjustMax(axis, -offset); }
-                        else { mBoxes[a[j].OwnerId()].AdjustMin(axis, -offset); }
+                        if (a[j].IsMax()) { mBoxes.GetByIndex(a[j].OwnerId()).AdjustMax(axis, -offset); }
+                        else { mBoxes.GetByIndex(a[j].OwnerId()).AdjustMin(axis, -offset); }
                     }
                 }
 
@@ -323,8 +329,8 @@ namespace jz
                 for (int i = (aToRemoves[count - 1] - count + 1); i < newAxisCount - 1; i++)
                 {
                     a[i] = a[i + count];
-                    if (a[i].IsMax()) { mBoxes[a[i].OwnerId()].AdjustMax(axis, -count); }
-                    else { mBoxes[a[i].OwnerId()].AdjustMin(axis, -count); }
+                    if (a[i].IsMax()) { mBoxes.GetByIndex(a[i].OwnerId()).AdjustMax(axis, -count); }
+                    else { mBoxes.GetByIndex(a[i].OwnerId()).AdjustMin(axis, -count); }
                 }
 
                 // move sentinel.
@@ -345,12 +351,12 @@ namespace jz
                     ushort handle = mRemoves[i];
                     mPairRemoveCache[handle] = false;
 
-                    mRemovesX.push_back(mBoxes[handle].MinX);
-                    mRemovesX.push_back(mBoxes[handle].MaxX);
-                    mRemovesY.push_back(mBoxes[handle].MinY);
-                    mRemovesY.push_back(mBoxes[handle].MaxY);
-                    mRemovesZ.push_back(mBoxes[handle].MinZ);
-                    mRemovesZ.push_back(mBoxes[handle].MaxZ);
+                    mRemovesX.push_back(mBoxes.GetByIndex(handle).MinX);
+                    mRemovesX.push_back(mBoxes.GetByIndex(handle).MaxX);
+                    mRemovesY.push_back(mBoxes.GetByIndex(handle).MinY);
+                    mRemovesY.push_back(mBoxes.GetByIndex(handle).MaxY);
+                    mRemovesZ.push_back(mBoxes.GetByIndex(handle).MinZ);
+                    mRemovesZ.push_back(mBoxes.GetByIndex(handle).MaxZ);
                 }
 
                 _RemoveHelper(mRemovesX, 0);
@@ -360,8 +366,7 @@ namespace jz
                 for (int i = 0; i < count; i++)
                 {
                     ushort handle = mRemoves[i];
-                    mBoxes[handle].Object = null;
-                    mBoxes.remove(handle);
+                    mBoxes.Remove(mBoxes.GetHandleFromIndex(handle));
                 }
                 mRemoves.clear();
             }
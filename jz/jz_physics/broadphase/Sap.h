@@ -24,8 +24,8 @@
 #ifndef _JZ_PHYSICS_SAP_H_
 #define _JZ_PHYSICS_SAP_H_
 
-#include <jz_core/AddressBuffer.h>
 #include <jz_core/Delegate.h>
+#include <jz_core/SlotMap.h>
 #include <jz_core/Vector3.h>
 #include <jz_physics/broadphase/IBroadphase.h>
 #include <jz_physics/broadphase/PairTable.h>
@@ -212,8 +212,8 @@ namespace jz
             {
                 if (mStartCollision)
                 {
-                    void_p a = mBoxes[aPair.A].Object;
-                    void_p b = mBoxes[aPair.B].Object;
+                    void_p a = mBoxes.GetByIndex(aPair.A).Object;
+                    void_p b = mBoxes.GetByIndex(aPair.B).Object;
 
                     mStartCollision(a, b);
                 }
@@ -223,8 +223,8 @@ namespace jz
             {
                 if (mStopCollision)
                 {
-                    void_p a = mBoxes[aPair.A].Object;
-                    void_p b = mBoxes[aPair.B].Object;
+                    void_p a = mBoxes.GetByIndex(aPair.A).Object;
+                    void_p b = mBoxes.GetByIndex(aPair.B).Object;
 
                     mStopCollision(a, b);
                 }
@@ -234,8 +234,8 @@ namespace jz
             {
                 if (mUpdateCollision)
                 {
-                    void_p a = mBoxes[aPair.A].Object;
-                    void_p b = mBoxes[aPair.B].Object;
+                    void_p a = mBoxes.GetByIndex(aPair.A).Object;
+                    void_p b = mBoxes.GetByIndex(aPair.B).Object;
 
                     mUpdateCollision(a, b);
                 }
@@ -266,7 +266,10 @@ namespace jz
                 return bReturn;
             }
 
-            AddressBuffer<BoxEntry> mBoxes;
+            // Broadphase handles are the u16 slot index of the entry in mBoxes. Slot
+            // indices are stable while an entry is live, and iteration over mBoxes
+            // stays dense under churn.
+            SlotMap<BoxEntry> mBoxes;
             vector<EndPoint> mAxes[3];
             vector<u16> mRemoves;
 
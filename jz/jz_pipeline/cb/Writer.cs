@@ -8,6 +8,7 @@ using Microsoft.Xna.Framework.Content.Pipeline.Processors;
 using Microsoft.Xna.Framework.Content.Pipeline.Serialization.Compiler;
 using Microsoft.Xna.Framework.Graphics;
 using System;
+using System.Collections.Generic;
 using System.IO;
 using jz;
 using jz.pipeline;
@@ -271,12 +272,21 @@ namespace jz.cb
         }
     }
 
+    // Writes the binary scene layout read by jz_engine_3D/SceneReader.cpp. Node
+    // payloads keep the per type encoding of the original stream format.
     public static class SceneWriter 
     {
         #region Private members
+        private const UInt32 kMagic = 0x43535A4A; // "JZSC"
+        private const UInt16 kVersion = 2;
+        private const UInt32 kNoParent = UInt32.MaxValue;
+        private const int kAlignment = 16;
+        private const int kHeaderSize = 48;
+        private const int kNodeSize = 24;
+        private const int kMatrixSize = 64;
+
         private static void _WriteAnimatedMeshPart(BinaryWriter aOut, DocInfo aInfo, AnimatedMeshPartSceneNodeContent aNode)
         {
-            _WriteSceneNode(aOut, aInfo, aNode);
             Helpers.Write(aOut, aInfo, aNode.Effect);
             Helpers.Write(aOut, aInfo, aNode.Material);
             Helpers.Write(aOut, aInfo, aNode.MeshPart);
@@ -292,17 +302,20 @@ namespace jz.cb
             {
                 Helpers.Write(aOut, e);
             }
+            Helpers.Write(aOut, (UInt32)aNode.JointAABBs.Length);
+            foreach (BoundingBox e in aNode.JointAABBs)
+            {
+                Helpers.Write(aOut, e);
+            }
         }
 
         private static void _WriteDirectionalLight(BinaryWriter aOut, DocInfo aInfo, DirectionalLightSceneNodeContent aNode)
         {
-            _WriteSceneNode(aOut, aInfo, aNode);
             Helpers.Write(aOut, aNode.LightColor);
         }
 
         private static void _WriteJoint(BinaryWriter aOut, DocInfo aInfo, JointSceneNodeContent aNode)
         {
-            _WriteSceneNode(aOut, aInfo, aNode);
             Helpers.Write(aOut, aNode.Animation.Id);
             Helpers.Write(aOut, (UInt32)aNode.Animation.KeyFrames.Length);
             foreach (AnimationKeyFrame e in aNode.Animation.KeyFrames)
@@ -313,7 +326,6 @@ namespace jz.cb
 
         private static void _WriteMeshPart(BinaryWriter aOut, DocInfo aInfo, MeshPartSceneNodeContent aNode)
         {
-            _WriteSceneNode(aOut, aInfo, aNode);
             Helpers.Write(aOut, aInfo, aNode.Effect);
             Helpers.Write(aOut, aInfo, aNode.Material);
             Helpers.Write(aOut, aInfo, aNode.MeshPart);
@@ -321,54 +333,157 @@ namespace jz.cb
 
         private static void _WritePhysics(BinaryWriter aOut, DocInfo aInfo, PhysicsSceneNodeContent aNode)
         {
-            _WriteSceneNode(aOut, aInfo, aNode);
             aNode.Tree.Write(aOut);
         }
 
         private static void _WritePointLight(BinaryWriter aOut, DocInfo aInfo, PointLightSceneNodeContent aNode)
         {
-            _WriteSceneNode(aOut, aInfo, aNode);
             Helpers.Write(aOut, aNode.LightAttenuation);
             Helpers.Write(aOut, aNode.LightColor);
         }
 
-        private static void _WriteSceneNode(BinaryWriter aOut, DocInfo aInfo, SceneNodeContent aNode)
+        private static void _WritePayload(BinaryWriter aOut, DocInfo aInfo, SceneNodeContent aNode)
         {
-            Helpers.Write(aOut, (Int32)aNode.ChildrenCount);
-            Helpers.Write(aOut, aNode.BaseId);
-            Helpers.Write(aOut, aNode.Id);
-            Helpers.Write(aOut, aNode.LocalTransform);
-            Helpers.Write(aOut, (Int32)aNode.Type);
+            switch (aNode.Type)
+            {
+                case SceneNodeType.AnimatedMeshPart: _WriteAnimatedMeshPart(aOut, aInfo, (AnimatedMeshPartSceneNodeContent)aNode); break;
+                case SceneNodeType.DirectionalLight: _WriteDirectionalLight(aOut, aInfo, (DirectionalLightSceneNodeContent)aNode); break;
+                case SceneNodeType.Joint: _WriteJoint(aOut, aInfo, (JointSceneNodeContent)aNode); break;
+                case SceneNodeType.MeshPart: _WriteMeshPart(aOut, aInfo, (MeshPartSceneNodeContent)aNode); break;
+                case SceneNodeType.Node: break;
+                case SceneNodeType.Physics: _WritePhysics(aOut, aInfo, (PhysicsSceneNodeContent)aNode); break;
+                case SceneNodeType.PointLight: _WritePointLight(aOut, aInfo, (PointLightSceneNodeContent)aNode); break;
+                case SceneNodeType.SpotLight: _WriteSpotLight(aOut, aInfo, (SpotLightSceneNodeContent)aNode); break;
+                default:
+                    throw new Exception(Utilities.kShouldNotBeHere);
+            }
         }
 
         private static void _WriteSpotLight(BinaryWriter aOut, DocInfo aInfo, SpotLightSceneNodeContent aNode)
         {
-            _WriteSceneNode(aOut, aInfo, aNode);
             Helpers.Write(aOut, aNode.FalloffAngleInRadians);
             Helpers.Write(aOut, aNode.FalloffExponent);
             Helpers.Write(aOut, aNode.LightAttenuation);
             Helpers.Write(aOut, aNode.LightColor);
         }
+
+        private static UInt32 _AddString(MemoryStream aStrings, Dictionary<string, UInt32> aOffsets, string v)
+        {
+            UInt32 ret;
+            if (aOffsets.TryGetValue(v, out ret)) { return ret; }
+
+            ret = (UInt32)aStrings.Length;
+            foreach (char c in v)
+            {
+                if (c > byte.MaxValue) { throw new ArgumentOutOfRangeException(); }
+                else { aStrings.WriteByte((byte)c); }
+            }
+            aStrings.WriteByte(0);
+
+            aOffsets.Add(v, ret);
+            return ret;
+        }
+
+        private static int _Align(int v)
+        {
+            return ((v + (kAlignment - 1)) / kAlignment) * kAlignment;
+        }
+
+        private static void _Pad(BinaryWriter aOut, int aPosition)
+        {
+            while (aOut.BaseStream.Position < aPosition) { aOut.Write((byte)0); }
+        }
         #endregion
 
+        // aContent.Nodes is in depth-first order, each node followed by its
+        // ChildrenCount children. Only the first tree is written, the reader has
+        // always loaded a single root. Offsets are from the start of aOut.
         public static void Write(BinaryWriter aOut, DocInfo aInfo, SceneContent aContent)
         {
+            List<SceneNodeContent> nodes = new List<SceneNodeContent>();
+            List<UInt32> parents = new List<UInt32>();
+            Stack<int> open = new Stack<int>();
+            Stack<int> remaining = new Stack<int>();
+
             foreach (SceneNodeContent e in aContent.Nodes)
             {
-                switch (e.Type)
+                while (remaining.Count > 0 && remaining.Peek() == 0) { remaining.Pop(); open.Pop(); }
+                if (nodes.Count > 0 && open.Count == 0) { break; }
+
+                if (open.Count > 0)
                 {
-                    case SceneNodeType.AnimatedMeshPart: _WriteAnimatedMeshPart(aOut, aInfo, (AnimatedMeshPartSceneNodeContent)e); break;
-                    case SceneNodeType.DirectionalLight: _WriteDirectionalLight(aOut, aInfo, (DirectionalLightSceneNodeContent)e); break;
-                    case SceneNodeType.Joint: _WriteJoint(aOut, aInfo, (JointSceneNodeContent)e); break;
-                    case SceneNodeType.MeshPart: _WriteMeshPart(aOut, aInfo, (MeshPartSceneNodeContent)e); break;
-                    case SceneNodeType.Node: _WriteSceneNode(aOut, aInfo, e); break;
-                    case SceneNodeType.Physics: _WritePhysics(aOut, aInfo, (PhysicsSceneNodeContent)e); break;
-                    case SceneNodeType.PointLight: _WritePointLight(aOut, aInfo, (PointLightSceneNodeContent)e); break;
-                    case SceneNodeType.SpotLight: _WriteSpotLight(aOut, aInfo, (SpotLightSceneNodeContent)e); break;
-                    default:
-                        throw new Exception(Utilities.kShouldNotBeHere);
+                    remaining.Push(remaining.Pop() - 1);
+                    parents.Add((UInt32)open.Peek());
+                }
+                else
+                {
+                    parents.Add(kNoParent);
                 }
+
+                open.Push(nodes.Count);
+                remaining.Push(e.ChildrenCount);
+                nodes.Add(e);
+            }
+
+            MemoryStream strings = new MemoryStream();
+            Dictionary<string, UInt32> stringOffsets = new Dictionary<string, UInt32>();
+            MemoryStream payload = new MemoryStream();
+            BinaryWriter payloadWriter = new BinaryWriter(payload);
+            UInt32[] payloadOffsets = new UInt32[nodes.Count];
+            UInt32[] payloadSizes = new UInt32[nodes.Count];
+            UInt32[] baseIds = new UInt32[nodes.Count];
+            UInt32[] ids = new UInt32[nodes.Count];
+
+            for (int i = 0; i < nodes.Count; i++)
+            {
+                baseIds[i] = _AddString(strings, stringOffsets, nodes[i].BaseId);
+                ids[i] = _AddString(strings, stringOffsets, nodes[i].Id);
+
+                payloadOffsets[i] = (UInt32)payload.Length;
+                _WritePayload(payloadWriter, aInfo, nodes[i]);
+                payloadWriter.Flush();
+                payloadSizes[i] = (UInt32)payload.Length - payloadOffsets[i];
+            }
+
+            int transformsOffset = _Align(kHeaderSize);
+            int nodesOffset = _Align(transformsOffset + (nodes.Count * kMatrixSize));
+            int stringsOffset = _Align(nodesOffset + (nodes.Count * kNodeSize));
+            int payloadOffset = _Align(stringsOffset + (int)strings.Length);
+
+            Helpers.Write(aOut, kMagic);
+            Helpers.Write(aOut, kVersion);
+            Helpers.Write(aOut, (UInt16)kHeaderSize);
+            Helpers.Write(aOut, (UInt32)nodes.Count);
+            Helpers.Write(aOut, (UInt32)transformsOffset);
+            Helpers.Write(aOut, (UInt32)nodesOffset);
+            Helpers.Write(aOut, (UInt32)stringsOffset);
+            Helpers.Write(aOut, (UInt32)strings.Length);
+            Helpers.Write(aOut, (UInt32)payloadOffset);
+            Helpers.Write(aOut, (UInt32)payload.Length);
+            _Pad(aOut, kHeaderSize);
+
+            _Pad(aOut, transformsOffset);
+            foreach (SceneNodeContent e in nodes)
+            {
+                Helpers.Write(aOut, e.LocalTransform);
             }
+
+            _Pad(aOut, nodesOffset);
+            for (int i = 0; i < nodes.Count; i++)
+            {
+                Helpers.Write(aOut, parents[i]);
+                Helpers.Write(aOut, baseIds[i]);
+                Helpers.Write(aOut, ids[i]);
+                Helpers.Write(aOut, (UInt32)nodes[i].Type);
+                Helpers.Write(aOut, payloadOffsets[i]);
+                Helpers.Write(aOut, payloadSizes[i]);
+            }
+
+            _Pad(aOut, stringsOffset);
+            aOut.Write(strings.ToArray());
+
+            _Pad(aOut, payloadOffset);
+            aOut.Write(payload.ToArray());
         }
     }
 }
@@ -485,6 +485,49 @@ namespace jz.pipeline
                 }
             }
 
+            /// <summary>
+            /// Bounding box of the vertices influenced by each joint, in the space of the vertices
+            /// before skinning. Joints that influence no vertices get an inverted box.
+            /// </summary>
+            public BoundingBox[] GetJointAABBs(int aJointCount)
+            {
+                BoundingBox[] ret = new BoundingBox[aJointCount];
+                for (int i = 0; i < aJointCount; i++) { ret[i] = Utilities.kInvertedMaxBox; }
+
+                int position = GetOffsetInBytes(VertexElementUsage.Position, 0);
+                int indices = GetOffsetInBytes(VertexElementUsage.BlendIndices, 0);
+                int weights = GetOffsetInBytes(VertexElementUsage.BlendWeight, 0);
+
+                if (position >= 0 && indices >= 0 && weights >= 0)
+                {
+                    int count = VertexCount;
+                    for (int i = 0; i < count; i++)
+                    {
+                        Vector3 pos = GetVector3(i, position);
+                        Vector4 ind = GetVector4(i, indices);
+                        Vector4 wght = GetVector4(i, weights);
+
+                        _AddToJointAABB(ret, ind.X, wght.X, pos);
+                        _AddToJointAABB(ret, ind.Y, wght.Y, pos);
+                        _AddToJointAABB(ret, ind.Z, wght.Z, pos);
+                        _AddToJointAABB(ret, ind.W, wght.W, pos);
+                    }
+                }
+
+                return ret;
+            }
+
+            private static void _AddToJointAABB(BoundingBox[] arBoxes, float aIndex, float aWeight, Vector3 v)
+            {
+                int index = (int)aIndex;
+
+                if (aWeight > 0.0f && index >= 0 && index < arBoxes.Length)
+                {
+                    arBoxes[index].Min = Vector3.Min(arBoxes[index].Min, v);
+                    arBoxes[index].Max = Vector3.Max(arBoxes[index].Max, v);
+                }
+            }
+
             public SingleEnumerable EnumerateSingle(VertexElementUsage aUsage, byte aUsageIndex)
             {
                 SingleEnumerable ret = new SingleEnumerable(Vertices, GetOffsetInBytes(aUsage, aUsageIndex), VertexStrideInBytes, GetElementSizeInBytes(aUsage, aUsageIndex));
@@ -536,6 +579,19 @@ namespace jz.pipeline
                 return ret;
             }
 
+            public Vector4 GetVector4(int aVertexIndex, int aOffsetInBytes)
+            {
+                int kIndex = (aVertexIndex * VertexStrideInBytes) + aOffsetInBytes;
+
+                Vector4 ret = new Vector4(
+                    BitConverter.ToSingle(Vertices, kIndex + 0),
+                    BitConverter.ToSingle(Vertices, kIndex + sizeof(float)),
+                    BitConverter.ToSingle(Vertices, kIndex + (2 * sizeof(float))),
+                    BitConverter.ToSingle(Vertices, kIndex + (3 * sizeof(float))));
+
+                return ret;
+            }
+
             public void SetVector3(int aVertexIndex, int aOffsetInBytes, Vector3 v)
             {
                 int kIndex = (aVertexIndex * VertexStrideInBytes) + aOffsetInBytes;
@@ -652,6 +708,7 @@ namespace jz.pipeline
             InverseBindTransforms = aInverseBindTransforms;
             RootJoint = aRootJoint;
             Joints = aJoints;
+            JointAABBs = aMeshPart.GetJointAABBs(aInverseBindTransforms.Length);
         }
 
         public readonly JzEffectContent Effect;
@@ -661,6 +718,7 @@ namespace jz.pipeline
         public readonly Matrix[] InverseBindTransforms;
         public readonly string RootJoint;
         public readonly string[] Joints;
+        public readonly BoundingBox[] JointAABBs;
     }
 
     public sealed class DirectionalLightSceneNodeContent : SceneNodeContent
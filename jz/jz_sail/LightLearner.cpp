@@ -29,6 +29,11 @@
 
 namespace jz
 {
+    namespace system
+    {
+        template <> struct ByteOrder<sail::ImageIlluminationMetrics> { enum { kWordSize = sizeof(float) }; };
+    }
+
     namespace sail
     {
 
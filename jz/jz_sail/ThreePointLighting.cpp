@@ -46,7 +46,7 @@ namespace jz
               mDesiredCameraYaw(Radian::kZero), 
               mDesiredCameraPitch(Radian::kZero),
               mMotivation(ThreePointSettings::kDefault),
-              mLastTick(0.0f)
+              mLastTick(0.0)
         {}
 
         ThreePointLighting::~ThreePointLighting()
@@ -57,8 +57,8 @@ namespace jz
 
         bool ThreePointLighting::Tick(const Matrix4& aInverseViewTransform, const BoundingSphere& aTargetBS, const vector<MotivatingLight>& aMotivatingLights, LightSettings& arSettings)
         {
-            float currentTime = system::Time::GetSingleton().GetSeconds();
-            float elapsedTime = Clamp(currentTime - mLastTick, kMinElapsed, kMaxElapsed);
+            double currentTime = system::Time::GetSingleton().GetSecondsPrecise();
+            float elapsedTime = Clamp((float)(currentTime - mLastTick), kMinElapsed, kMaxElapsed);
             mLastTick = currentTime;
 
             #pragma region Update
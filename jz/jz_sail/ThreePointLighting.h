@@ -114,7 +114,7 @@ namespace jz
             Radian mCameraPitch;
             Radian mDesiredCameraYaw;
             Radian mDesiredCameraPitch;
-            float mLastTick;
+            double mLastTick;
 
             LightLearner mLearner;
 
@@ -30,7 +30,7 @@
 
 namespace jz
 {
-    sound::SoundMan* sound::SoundMan::mspSingleton = null;
+    template <> sound::SoundMan* Singleton<sound::SoundMan>::mspSingleton = null;
 
     namespace sound
     {
@@ -49,7 +49,7 @@ namespace jz
             }
             catch (std::exception& e)
             {
-                LogMessage(e.what(), Logger::kError);
+                JZ_LOG(Logger::kSound, Logger::kError, "%", e.what());
                 return null;
             }
 
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Hash.h>
+#include <jz_system/AssetCache.h>
+
+namespace jz
+{
+    template <> system::AssetCache* Singleton<system::AssetCache>::mspSingleton = null;
+    namespace system
+    {
+
+        AssetCache::AssetCache(size_t aBudget)
+            : mBudget(aBudget)
+        {
+            memset(&mStats, 0, sizeof(Stats));
+        }
+
+        AssetCache::~AssetCache()
+        {}
+
+        u64 AssetCache::GetKey(const string& aArchive, const string& aEntry, u32 aCrc32, size_t aSize)
+        {
+            const u64 kContent = (((u64)aCrc32) << 32) ^ (u64)aSize;
+            const u64 kArchive = hash64((u8c_p)aArchive.c_str(), (u32)aArchive.length(), kContent);
+
+            return hash64((u8c_p)aEntry.c_str(), (u32)aEntry.length(), kArchive);
+        }
+
+        bool AssetCache::GetAccepts(size_t aSize) const
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            return (aSize <= (mBudget / 4u));
+        }
+
+        size_t AssetCache::GetBudget() const
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            return mBudget;
+        }
+
+        void AssetCache::SetBudget(size_t aBudget)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            mBudget = aBudget;
+            _Evict(mBudget);
+        }
+
+        AssetCache::Stats AssetCache::GetStats() const
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            return mStats;
+        }
+
+        void AssetCache::ResetStats()
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            mStats.Hits = 0u;
+            mStats.Misses = 0u;
+            mStats.Evictions = 0u;
+        }
+
+        SharedBufferPtr AssetCache::Find(u64 aKey)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            Index::iterator I = mIndex.find(aKey);
+
+            if (I == mIndex.end())
+            {
+                mStats.Misses++;
+                return SharedBufferPtr();
+            }
+
+            mStats.Hits++;
+            mLru.splice(mLru.begin(), mLru, I->second);
+
+            return I->second->pBuffer;
+        }
+
+        SharedBufferPtr AssetCache::Insert(u64 aKey, const SharedBufferPtr& apBuffer)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            if (apBuffer->size() > (mBudget / 4u)) { return apBuffer; }
+
+            Index::iterator I = mIndex.find(aKey);
+            if (I != mIndex.end())
+            {
+                mLru.splice(mLru.begin(), mLru, I->second);
+                return I->second->pBuffer;
+            }
+
+            _Evict(mBudget - apBuffer->size());
+
+            Entry entry;
+            entry.Key = aKey;
+            entry.pBuffer = apBuffer;
+
+            mLru.push_front(entry);
+            mIndex.insert(make_pair(aKey, mLru.begin()));
+
+            mStats.Entries++;
+            mStats.Bytes += apBuffer->size();
+
+            return apBuffer;
+        }
+
+        void AssetCache::Clear()
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            _Evict(0u);
+        }
+
+        void AssetCache::_Evict(size_t aBudget)
+        {
+            while (mStats.Bytes > aBudget && !mLru.empty())
+            {
+                const Entry& entry = mLru.back();
+
+                mStats.Entries--;
+                mStats.Bytes -= entry.pBuffer->size();
+                mStats.Evictions++;
+
+                mIndex.erase(entry.Key);
+                mLru.pop_back();
+            }
+        }
+
+    }
+}
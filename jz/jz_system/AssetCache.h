@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SYSTEM_ASSET_CACHE_H_
+#define _JZ_SYSTEM_ASSET_CACHE_H_
+
+#include <jz_core/Atomic.h>
+#include <jz_core/Auto.h>
+#include <jz_core/Memory.h>
+#include <jz_core/Utility.h>
+#include <list>
+#include <map>
+#include <string>
+
+#if JZ_MULTITHREADED
+#   include <jz_system/Mutex.h>
+#endif
+
+namespace jz
+{
+    namespace system
+    {
+
+        // Block of decoded data that is filled once and then only read. The reference
+        // count is atomic, the cache and any number of readers on any thread share it.
+        class SharedBuffer sealed
+        {
+        public:
+            SharedBuffer(size_t aSize)
+                : mReferenceCount(0), mData(aSize)
+            {}
+
+            const u8* Get() const { return mData.Get(); }
+            u8* Get() { return mData.Get(); }
+            size_t size() const { return mData.size(); }
+
+        private:
+            friend void jz::__IncrementRefCount<system::SharedBuffer>(system::SharedBuffer* p);
+            friend void jz::__DecrementRefCount<system::SharedBuffer>(system::SharedBuffer* p);
+
+            SharedBuffer(const SharedBuffer&);
+            SharedBuffer& operator=(const SharedBuffer&);
+
+            volatile s32 mReferenceCount;
+            ByteBuffer mData;
+        };
+
+    }
+
+    template <>
+    __inline void __IncrementRefCount<system::SharedBuffer>(system::SharedBuffer* p)
+    {
+        AtomicIncrement(&(p->mReferenceCount));
+    }
+
+    template <>
+    __inline void __DecrementRefCount<system::SharedBuffer>(system::SharedBuffer* p)
+    {
+        if (AtomicDecrement(&(p->mReferenceCount)) == 0) { delete p; }
+    }
+
+    namespace system
+    {
+
+        typedef AutoPtr<SharedBuffer> SharedBufferPtr;
+
+        // Process-wide cache of decompressed archive entries, evicting the least recently
+        // used ones once the byte budget is exceeded. Keys come from GetKey(), which mixes
+        // the entry's CRC and size in with its archive and name, so an archive that is
+        // rebuilt in place never hits stale data, the old entries simply age out.
+        //
+        // Optional: archives only consult the cache if the application has created one.
+        // Buffers evicted while a reader still holds them stay alive until it lets go,
+        // so the budget bounds what the cache keeps, not what is in use.
+        class AssetCache sealed : public Singleton<AssetCache>
+        {
+        public:
+            static const size_t kDefaultBudget = (64u << 20);
+
+            struct Stats
+            {
+                size_t Hits;
+                size_t Misses;
+                size_t Evictions;
+                size_t Entries;
+                size_t Bytes;
+            };
+
+            AssetCache(size_t aBudget = kDefaultBudget);
+            ~AssetCache();
+
+            static u64 GetKey(const string& aArchive, const string& aEntry, u32 aCrc32, size_t aSize);
+
+            // True if a buffer of aSize bytes is worth caching. Entries over a quarter of
+            // the budget are not, they would evict most of the cache on their own.
+            bool GetAccepts(size_t aSize) const;
+
+            size_t GetBudget() const;
+            void SetBudget(size_t aBudget);
+
+            Stats GetStats() const;
+            void ResetStats();
+
+            // Null on a miss. A hit makes the entry the most recently used.
+            SharedBufferPtr Find(u64 aKey);
+
+            // Returns the cached buffer, which is not apBuffer if another thread inserted
+            // the same key first. Buffers that are not accepted are returned uncached.
+            SharedBufferPtr Insert(u64 aKey, const SharedBufferPtr& apBuffer);
+
+            void Clear();
+
+        private:
+            AssetCache(const AssetCache&);
+            AssetCache& operator=(const AssetCache&);
+
+            struct Entry
+            {
+                u64 Key;
+                SharedBufferPtr pBuffer;
+            };
+
+            typedef std::list<Entry> Lru;
+            typedef std::map<u64, Lru::iterator> Index;
+
+            size_t mBudget;
+            Lru mLru;
+            Index mIndex;
+            Stats mStats;
+
+#           if JZ_MULTITHREADED
+                mutable Mutex mMutex;
+#           endif
+
+            void _Evict(size_t aBudget);
+        };
+
+    }
+}
+
+#endif
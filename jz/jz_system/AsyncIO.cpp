@@ -0,0 +1,712 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Logger.h>
+#include <jz_system/AsyncIO.h>
+
+#if JZ_PLATFORM_WINDOWS
+#   include <jz_system/Win32.h>
+#else
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#   if defined(__linux__) && JZ_MULTITHREADED_IO
+#       define JZ_ASYNC_IO_URING 1
+#       include <linux/io_uring.h>
+#       include <sys/mman.h>
+#       include <sys/syscall.h>
+#       include <sys/uio.h>
+#   endif
+#endif
+
+#ifndef JZ_ASYNC_IO_URING
+#   define JZ_ASYNC_IO_URING 0
+#endif
+
+namespace jz
+{
+    template <> system::AsyncIO* Singleton<system::AsyncIO>::mspSingleton = null;
+    namespace system
+    {
+
+#pragma region AsyncFile
+        AsyncFile::AsyncFile(const char* apFilename)
+            : mReferenceCount(0), mFilename(apFilename), mSize(0u)
+        {
+            _Open();
+        }
+
+        AsyncFile::AsyncFile(const string& aFilename)
+            : mReferenceCount(0), mFilename(aFilename), mSize(0u)
+        {
+            _Open();
+        }
+
+    #   if JZ_PLATFORM_WINDOWS
+            AsyncFile::~AsyncFile()
+            {
+                CloseHandle(mFile);
+            }
+
+            size_t AsyncFile::ReadAt(u64 aOffset, void_p apOut, size_t aSize) const
+            {
+                size_t total = 0u;
+                while (total < aSize)
+                {
+                    const u64 kOffset = (aOffset + total);
+
+                    // With an offset in the OVERLAPPED, a synchronous handle reads at that
+                    // position without touching the shared file pointer.
+                    OVERLAPPED overlapped;
+                    memset(&overlapped, 0, sizeof(OVERLAPPED));
+                    overlapped.Offset = (DWORD)(kOffset & 0xFFFFFFFF);
+                    overlapped.OffsetHigh = (DWORD)(kOffset >> 32);
+
+                    DWORD request = (DWORD)Min((aSize - total), (size_t)(1u << 30));
+                    DWORD read = 0u;
+                    if (!::ReadFile(mFile, ((u8*)apOut + total), request, &read, &overlapped) || read == 0u) { break; }
+
+                    total += read;
+                }
+
+                return total;
+            }
+
+            void AsyncFile::_Open()
+            {
+                // FILE_SHARE_WRITE, a FileSystem pack is open for writing through stdio
+                // while it is read from here.
+                mFile = CreateFileA(mFilename.c_str(), GENERIC_READ, (FILE_SHARE_READ | FILE_SHARE_WRITE), null, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, null);
+                JZ_E_ON_FAIL(mFile != INVALID_HANDLE_VALUE, "failed opening file for asynchronous reads.");
+
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(mFile, &size))
+                {
+                    CloseHandle(mFile);
+                    JZ_E_ON_FAIL(false, "failed reading file size.");
+                }
+
+                mSize = (u64)size.QuadPart;
+            }
+    #   else
+            AsyncFile::~AsyncFile()
+            {
+                close(mFile);
+            }
+
+            size_t AsyncFile::ReadAt(u64 aOffset, void_p apOut, size_t aSize) const
+            {
+                size_t total = 0u;
+                while (total < aSize)
+                {
+                    ssize_t read = pread(mFile, ((u8*)apOut + total), (aSize - total), (off_t)(aOffset + total));
+                    if (read < 0 && errno == EINTR) { continue; }
+                    if (read <= 0) { break; }
+
+                    total += (size_t)read;
+                }
+
+                return total;
+            }
+
+            void AsyncFile::_Open()
+            {
+                mFile = open(mFilename.c_str(), (O_RDONLY | O_CLOEXEC));
+                JZ_E_ON_FAIL(mFile >= 0, "failed opening file for asynchronous reads.");
+
+                struct stat info;
+                if (fstat(mFile, &info) != 0)
+                {
+                    close(mFile);
+                    JZ_E_ON_FAIL(false, "failed reading file size.");
+                }
+
+                mSize = (u64)info.st_size;
+            }
+    #   endif
+#pragma endregion
+
+#pragma region Ring
+    #   if JZ_ASYNC_IO_URING
+            // Minimal io_uring driven through the raw system calls, so there is no
+            // dependency on liburing. All SQ and CQ ring access happens with
+            // AsyncIO::mMutex held, only io_uring_enter() is made without it.
+            struct AsyncIO::Ring
+            {
+                struct Slot
+                {
+                    RequestHandle Handle;
+                    iovec Vector;
+                };
+
+                int Fd;
+                void_p pSq;
+                size_t SqBytes;
+                void_p pCq;
+                size_t CqBytes;
+                io_uring_sqe* pSqes;
+                size_t SqesBytes;
+
+                u32* pSqHead;
+                u32* pSqTail;
+                u32 SqMask;
+                u32* pSqArray;
+
+                u32* pCqHead;
+                u32* pCqTail;
+                u32 CqMask;
+                io_uring_cqe* pCqes;
+
+                // Reads in flight, user_data of a read is its slot + 1. user_data 0 is the
+                // no-op that wakes the ring thread.
+                vector<Slot> Slots;
+                vector<u32> Free;
+
+                bool bWaiting;
+                bool bWakePosted;
+
+                bool IsIdle() const { return (Free.size() == Slots.size() && !bWakePosted); }
+
+                static Ring* Create(u32 aDepth);
+                static void Destroy(Ring* p);
+
+                // Entries written but not yet consumed by the kernel.
+                u32 GetUnsubmitted() const
+                {
+                    return (*pSqTail - __atomic_load_n(pSqHead, __ATOMIC_ACQUIRE));
+                }
+
+                void Push(u8 aOpcode, int aFd, const iovec* apVector, u64 aOffset, u64 aUserData);
+            };
+
+            static int _RingEnter(int aFd, u32 aSubmit, u32 aWait)
+            {
+                return (int)syscall(__NR_io_uring_enter, aFd, aSubmit, aWait, ((aWait > 0u) ? IORING_ENTER_GETEVENTS : 0u), null, 0);
+            }
+
+            // Returns null if the kernel is too old, or io_uring is disabled or filtered.
+            AsyncIO::Ring* AsyncIO::Ring::Create(u32 aDepth)
+            {
+                io_uring_params params;
+                memset(&params, 0, sizeof(io_uring_params));
+
+                // Room for a full set of reads plus the wake no-op, twice over, so the SQ
+                // never fills while entries wait for io_uring_enter().
+                int fd = (int)syscall(__NR_io_uring_setup, (aDepth * 2u), &params);
+                if (fd < 0) { return null; }
+
+                Ring* p = new Ring();
+                p->Fd = fd;
+                p->SqBytes = (params.sq_off.array + (params.sq_entries * sizeof(u32)));
+                p->CqBytes = (params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe)));
+                p->SqesBytes = (params.sq_entries * sizeof(io_uring_sqe));
+                p->pSq = mmap(null, p->SqBytes, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), fd, IORING_OFF_SQ_RING);
+                p->pCq = mmap(null, p->CqBytes, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), fd, IORING_OFF_CQ_RING);
+                p->pSqes = (io_uring_sqe*)mmap(null, p->SqesBytes, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), fd, IORING_OFF_SQES);
+
+                if (p->pSq == MAP_FAILED) { p->pSq = null; }
+                if (p->pCq == MAP_FAILED) { p->pCq = null; }
+                if (p->pSqes == MAP_FAILED) { p->pSqes = null; }
+                if (!p->pSq || !p->pCq || !p->pSqes)
+                {
+                    Destroy(p);
+                    return null;
+                }
+
+                u8* pSq = (u8*)p->pSq;
+                p->pSqHead = (u32*)(pSq + params.sq_off.head);
+                p->pSqTail = (u32*)(pSq + params.sq_off.tail);
+                p->SqMask = *((u32*)(pSq + params.sq_off.ring_mask));
+                p->pSqArray = (u32*)(pSq + params.sq_off.array);
+
+                u8* pCq = (u8*)p->pCq;
+                p->pCqHead = (u32*)(pCq + params.cq_off.head);
+                p->pCqTail = (u32*)(pCq + params.cq_off.tail);
+                p->CqMask = *((u32*)(pCq + params.cq_off.ring_mask));
+                p->pCqes = (io_uring_cqe*)(pCq + params.cq_off.cqes);
+
+                p->Slots.resize(aDepth);
+                for (u32 i = aDepth; i > 0u; i--) { p->Free.push_back(i - 1u); }
+                p->bWaiting = false;
+                p->bWakePosted = false;
+
+                return p;
+            }
+
+            void AsyncIO::Ring::Destroy(Ring* p)
+            {
+                if (p->pSqes) { munmap(p->pSqes, p->SqesBytes); }
+                if (p->pCq) { munmap(p->pCq, p->CqBytes); }
+                if (p->pSq) { munmap(p->pSq, p->SqBytes); }
+                if (p->Fd >= 0) { close(p->Fd); }
+
+                delete p;
+            }
+
+            void AsyncIO::Ring::Push(u8 aOpcode, int aFd, const iovec* apVector, u64 aOffset, u64 aUserData)
+            {
+                const u32 kTail = *pSqTail;
+                const u32 kIndex = (kTail & SqMask);
+
+                io_uring_sqe& sqe = pSqes[kIndex];
+                memset(&sqe, 0, sizeof(io_uring_sqe));
+                sqe.opcode = aOpcode;
+                sqe.fd = aFd;
+                sqe.off = aOffset;
+                sqe.addr = (u64)(size_t)apVector;
+                sqe.len = (apVector) ? 1u : 0u;
+                sqe.user_data = aUserData;
+
+                pSqArray[kIndex] = kIndex;
+                __atomic_store_n(pSqTail, (kTail + 1u), __ATOMIC_RELEASE);
+            }
+
+            void AsyncIO::_RingMain(const Thread& aThread)
+            {
+                Ring& ring = *mpRing;
+                Lock lock(mMutex);
+
+                while (true)
+                {
+                    _RingSubmit();
+
+                    if (ring.IsIdle())
+                    {
+                        if (mbDone) { break; }
+
+                        mSubmit.Wait(mMutex);
+                        continue;
+                    }
+
+                    const u32 kSubmit = ring.GetUnsubmitted();
+                    ring.bWaiting = true;
+                    mMutex.Unlock();
+
+                    // EINTR and EBUSY leave entries in the SQ, they are picked up on the
+                    // next pass.
+                    _RingEnter(ring.Fd, kSubmit, 1u);
+
+                    mMutex.Lock();
+                    ring.bWaiting = false;
+
+                    _RingReap();
+                }
+
+                mWork.NotifyAll();
+            }
+
+            void AsyncIO::_RingReap()
+            {
+                Ring& ring = *mpRing;
+
+                u32 head = *(ring.pCqHead);
+                const u32 kTail = __atomic_load_n(ring.pCqTail, __ATOMIC_ACQUIRE);
+                if (head == kTail) { return; }
+
+                for (; head != kTail; head++)
+                {
+                    const io_uring_cqe& cqe = ring.pCqes[head & ring.CqMask];
+                    if (cqe.user_data == 0u) { ring.bWakePosted = false; continue; }
+
+                    const u32 kSlot = (u32)(cqe.user_data - 1u);
+                    const RequestHandle kHandle = ring.Slots[kSlot].Handle;
+                    ring.Free.push_back(kSlot);
+
+                    // A failed or short read is finished by the worker with ReadAt().
+                    mRequests[kHandle].Bytes = (cqe.res > 0) ? (size_t)cqe.res : 0u;
+                    mCompleted.push_back(kHandle);
+                }
+
+                __atomic_store_n(ring.pCqHead, head, __ATOMIC_RELEASE);
+                mWork.NotifyAll();
+            }
+
+            void AsyncIO::_RingSubmit()
+            {
+                Ring& ring = *mpRing;
+
+                while (!ring.Free.empty() && !mPending.empty())
+                {
+                    const RequestHandle kHandle = _PopPending();
+                    const Request& r = mRequests[kHandle];
+
+                    const u32 kSlot = ring.Free.back();
+                    ring.Free.pop_back();
+
+                    Ring::Slot& slot = ring.Slots[kSlot];
+                    slot.Handle = kHandle;
+                    slot.Vector.iov_base = r.pOut;
+                    slot.Vector.iov_len = r.Size;
+
+                    ring.Push(IORING_OP_READV, r.pFile->mFile, &(slot.Vector), r.Offset, (kSlot + 1u));
+                }
+            }
+
+            // The ring thread cannot see new requests while it is blocked in
+            // io_uring_enter(), a no-op completion gets it out.
+            void AsyncIO::_RingWake()
+            {
+                Ring& ring = *mpRing;
+
+                if (ring.bWaiting && !ring.bWakePosted && !ring.Free.empty())
+                {
+                    ring.bWakePosted = true;
+                    ring.Push(IORING_OP_NOP, -1, null, 0u, 0u);
+                    _RingEnter(ring.Fd, ring.GetUnsubmitted(), 0u);
+                }
+
+                mSubmit.NotifyOne();
+            }
+    #   elif JZ_MULTITHREADED
+            struct AsyncIO::Ring
+            {
+                bool IsIdle() const { return true; }
+                static void Destroy(Ring* p) { delete p; }
+            };
+
+            void AsyncIO::_RingMain(const Thread& aThread) {}
+            void AsyncIO::_RingReap() {}
+            void AsyncIO::_RingSubmit() {}
+            void AsyncIO::_RingWake() {}
+    #   endif
+#pragma endregion
+
+        AsyncIO::AsyncIO(uint aThreadCount, bool abAllowUring)
+            : mBackend(kThreadPool), mSequence(0u), mpCursorFile(null), mCursorOffset(0u), mbDone(false)
+#           if JZ_MULTITHREADED
+                , mpRing(null), mpRingThread(null)
+#           endif
+        {
+#           if JZ_ASYNC_IO_URING
+                if (abAllowUring) { mpRing = Ring::Create(kQueueDepth); }
+                if (mpRing)
+                {
+                    mBackend = kUring;
+                    mpRingThread = new Thread(tr1::bind(&AsyncIO::_RingMain, this, tr1::placeholders::_1));
+                }
+#           endif
+
+#           if JZ_MULTITHREADED_IO
+                const uint kThreadCount = jz::Max(aThreadCount, 1u);
+                for (uint i = 0u; i < kThreadCount; i++)
+                {
+                    mThreads.push_back(new Thread(tr1::bind(&AsyncIO::_WorkerMain, this, tr1::placeholders::_1)));
+                }
+#           endif
+        }
+
+        AsyncIO::~AsyncIO()
+        {
+            vector<RequestHandle> cancelled;
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+
+                mbDone = true;
+                for (Pending::iterator I = mPending.begin(); I != mPending.end(); I++)
+                {
+                    mRequests[I->Handle].State = kInFlight;
+                    cancelled.push_back(I->Handle);
+                }
+                mPending.clear();
+            }
+
+            for (size_t i = 0u; i < cancelled.size(); i++) { _Finish(cancelled[i], kCancelled, 0u); }
+
+#           if JZ_MULTITHREADED
+                {
+                    Lock lock(mMutex);
+                    mSubmit.NotifyAll();
+                    mWork.NotifyAll();
+                }
+
+                // Reads already issued are allowed to finish.
+                if (mpRingThread) { delete mpRingThread; mpRingThread = null; }
+
+                for (size_t i = 0u; i < mThreads.size(); i++) { delete mThreads[i]; }
+                mThreads.clear();
+
+                if (mpRing) { Ring::Destroy(mpRing); mpRing = null; }
+#           endif
+        }
+
+        AsyncIO::RequestHandle AsyncIO::Read(const AsyncFilePtr& apFile, u64 aOffset, void_p apOut, size_t aSize, Priority aPriority, const Callback& aCallback)
+        {
+            JZ_E_ON_FAIL(apFile.Get() != null, "file is null.");
+            JZ_E_ON_FAIL(aPriority >= kLow && aPriority <= kCritical, "invalid priority.");
+
+            Request r;
+            r.pFile = apFile;
+            r.Offset = aOffset;
+            r.pOut = apOut;
+            r.Size = aSize;
+            r.Order = aPriority;
+            r.OnComplete = aCallback;
+            r.State = kPending;
+            r.Bytes = 0u;
+            r.bReleased = false;
+
+            RequestHandle ret = kInvalidRequest;
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+
+                JZ_E_ON_FAIL(!mbDone, "AsyncIO is shutting down.");
+
+                r.Sequence = mSequence++;
+                ret = mRequests.Add(r);
+                mPending.insert(_GetKey(ret, r));
+
+#               if JZ_MULTITHREADED
+                    if (mpRing) { _RingWake(); }
+                    else { mWork.NotifyOne(); }
+#               endif
+            }
+
+#           if !JZ_MULTITHREADED_IO
+                RequestHandle next = kInvalidRequest;
+                {
+#                   if JZ_MULTITHREADED
+                        Lock lock(mMutex);
+#                   endif
+
+                    next = _PopPending();
+                }
+
+                if (next != kInvalidRequest) { _Service(next); }
+#           endif
+
+            return ret;
+        }
+
+        bool AsyncIO::Cancel(RequestHandle aHandle)
+        {
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+
+                Request* p = mRequests.Find(aHandle);
+                if (!p || p->State != kPending) { return false; }
+
+                mPending.erase(_GetKey(aHandle, *p));
+
+                // Claimed, so a second Cancel() fails while the callback runs.
+                p->State = kInFlight;
+            }
+
+            _Finish(aHandle, kCancelled, 0u);
+
+            return true;
+        }
+
+        AsyncIO::Status AsyncIO::GetStatus(RequestHandle aHandle, size_t* apBytes) const
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            const Request* p = mRequests.Find(aHandle);
+            if (!p) { return kInvalid; }
+
+            if (apBytes) { *apBytes = p->Bytes; }
+
+            return p->State;
+        }
+
+        AsyncIO::Status AsyncIO::Wait(RequestHandle aHandle, size_t* apBytes)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+
+                while (true)
+                {
+                    const Request* p = mRequests.Find(aHandle);
+                    if (!p) { return kInvalid; }
+                    if (p->State >= kComplete) { break; }
+
+                    mDone.Wait(mMutex);
+                }
+#           endif
+
+            return GetStatus(aHandle, apBytes);
+        }
+
+        void AsyncIO::Release(RequestHandle aHandle)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            Request* p = mRequests.Find(aHandle);
+            if (!p) { return; }
+
+            if (p->State >= kComplete) { mRequests.Remove(aHandle); }
+            else { p->bReleased = true; }
+        }
+
+        AsyncIO::PendingKey AsyncIO::_GetKey(RequestHandle aHandle, const Request& aRequest)
+        {
+            PendingKey ret = { aRequest.Order, aRequest.pFile.Get(), aRequest.Offset, aRequest.Sequence, aHandle };
+
+            return ret;
+        }
+
+        void AsyncIO::_Finish(RequestHandle aHandle, Status aStatus, size_t aBytes)
+        {
+            Result result;
+            Callback callback;
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+
+                const Request& r = mRequests[aHandle];
+                result.Handle = aHandle;
+                result.State = aStatus;
+                result.pOut = r.pOut;
+                result.Bytes = aBytes;
+                callback = r.OnComplete;
+            }
+
+            if (callback)
+            {
+                try
+                {
+                    callback(result);
+                }
+                catch (std::exception& e)
+                {
+                    JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
+                    result.State = kFailed;
+                }
+            }
+
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+
+                Request& r = mRequests[aHandle];
+                r.State = result.State;
+                r.Bytes = result.Bytes;
+                r.pFile.Reset();
+                r.OnComplete.Reset();
+
+                if (r.bReleased) { mRequests.Remove(aHandle); }
+
+#               if JZ_MULTITHREADED
+                    mDone.NotifyAll();
+#               endif
+            }
+        }
+
+        // Elevator order: the first pending read of the highest priority at or after the
+        // position of the last read issued, wrapping to the start when there is none.
+        AsyncIO::RequestHandle AsyncIO::_PopPending()
+        {
+            if (mPending.empty()) { return kInvalidRequest; }
+
+            const s32 kOrder = mPending.begin()->Order;
+            const PendingKey kCursor = { kOrder, mpCursorFile, mCursorOffset, 0u, kInvalidRequest };
+
+            Pending::iterator I = mPending.lower_bound(kCursor);
+            if (I == mPending.end() || I->Order != kOrder) { I = mPending.begin(); }
+
+            const RequestHandle kHandle = I->Handle;
+            mPending.erase(I);
+
+            Request& r = mRequests[kHandle];
+            r.State = kInFlight;
+            mpCursorFile = r.pFile.Get();
+            mCursorOffset = (r.Offset + r.Size);
+
+            return kHandle;
+        }
+
+        // Reads whatever part of the request is not done yet, all of it for the thread
+        // pool, the remainder of a short or failed io_uring read otherwise.
+        void AsyncIO::_Service(RequestHandle aHandle)
+        {
+            AsyncFilePtr pFile;
+            u64 offset;
+            u8* pOut;
+            size_t size;
+            size_t bytes;
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+
+                const Request& r = mRequests[aHandle];
+                pFile = r.pFile;
+                offset = r.Offset;
+                pOut = (u8*)r.pOut;
+                size = r.Size;
+                bytes = r.Bytes;
+            }
+
+            if (bytes < size) { bytes += pFile->ReadAt((offset + bytes), (pOut + bytes), (size - bytes)); }
+
+            _Finish(aHandle, ((bytes == size) ? kComplete : kFailed), bytes);
+        }
+
+#       if JZ_MULTITHREADED
+            void AsyncIO::_WorkerMain(const Thread& aThread)
+            {
+                while (true)
+                {
+                    RequestHandle handle = kInvalidRequest;
+                    {
+                        Lock lock(mMutex);
+
+                        while (true)
+                        {
+                            if (!mCompleted.empty())
+                            {
+                                handle = mCompleted.front();
+                                mCompleted.pop_front();
+                                break;
+                            }
+
+                            if (!mpRing)
+                            {
+                                handle = _PopPending();
+                                if (handle != kInvalidRequest) { break; }
+                            }
+
+                            if (mbDone && mPending.empty() && (!mpRing || mpRing->IsIdle())) { return; }
+
+                            mWork.Wait(mMutex);
+                        }
+                    }
+
+                    _Service(handle);
+                }
+            }
+#       endif
+
+    }
+}
@@ -0,0 +1,266 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SYSTEM_ASYNC_IO_H_
+#define _JZ_SYSTEM_ASYNC_IO_H_
+
+#include <jz_core/Atomic.h>
+#include <jz_core/Auto.h>
+#include <jz_core/Delegate.h>
+#include <jz_core/SlotMap.h>
+#include <jz_core/Utility.h>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+#if JZ_MULTITHREADED
+#   include <jz_system/ConditionVariable.h>
+#   include <jz_system/Mutex.h>
+#   include <jz_system/Thread.h>
+#endif
+
+namespace jz
+{
+    namespace system
+    {
+
+        // File opened for positional reads. Unlike IReadFile there is no file position, so
+        // any number of threads can read from one AsyncFile at the same time. The reference
+        // count is atomic, requests in flight hold a reference to their file.
+        class AsyncFile sealed
+        {
+        public:
+            AsyncFile(const char* apFilename);
+            AsyncFile(const string& aFilename);
+            ~AsyncFile();
+
+            const char* GetFilename() const { return mFilename.c_str(); }
+
+            // Size when the file was opened.
+            u64 GetSize() const { return mSize; }
+
+            // Blocking. Returns the number of bytes read, which is less than aSize only at
+            // the end of the file or on an error.
+            size_t ReadAt(u64 aOffset, void_p apOut, size_t aSize) const;
+
+        private:
+            friend class AsyncIO;
+            friend void jz::__IncrementRefCount<system::AsyncFile>(system::AsyncFile* p);
+            friend void jz::__DecrementRefCount<system::AsyncFile>(system::AsyncFile* p);
+
+            AsyncFile(const AsyncFile&);
+            AsyncFile& operator=(const AsyncFile&);
+
+            volatile s32 mReferenceCount;
+            string mFilename;
+            u64 mSize;
+
+    #       if JZ_PLATFORM_WINDOWS
+                void_p mFile;
+    #       else
+                int mFile;
+    #       endif
+
+            void _Open();
+        };
+
+    }
+
+    template <>
+    __inline void __IncrementRefCount<system::AsyncFile>(system::AsyncFile* p)
+    {
+        AtomicIncrement(&(p->mReferenceCount));
+    }
+
+    template <>
+    __inline void __DecrementRefCount<system::AsyncFile>(system::AsyncFile* p)
+    {
+        if (AtomicDecrement(&(p->mReferenceCount)) == 0) { delete p; }
+    }
+
+    namespace system
+    {
+
+        typedef AutoPtr<AsyncFile> AsyncFilePtr;
+
+        // Queue of reads into caller owned memory, serviced in the background. Pending reads
+        // are issued highest priority first, and within a priority in ascending (file,
+        // offset) order, sweeping from the last position read and wrapping around at the
+        // end, so a burst of reads into one archive becomes one pass across it.
+        //
+        // On Linux, reads are submitted in batches to an io_uring by a dedicated thread and
+        // the worker threads only run completions. Elsewhere, or when the kernel refuses
+        // to create a ring, the worker threads issue the reads themselves. When
+        // JZ_MULTITHREADED_IO is 0, Read() completes the request before it returns.
+        //
+        // Every request runs its callback exactly once, whatever the outcome, on a worker
+        // thread or on the thread that cancels it. The callback runs before the request
+        // is marked done, so it may post-process the data (decompress it for example) and
+        // change the outcome it reports, and Wait() returns after it. A callback must not
+        // Wait() on its own request.
+        class AsyncIO sealed : public Singleton<AsyncIO>
+        {
+        public:
+            enum Backend
+            {
+                kThreadPool = 0,
+                kUring = 1
+            };
+
+            enum Priority
+            {
+                kLow = 0,
+                kMed = 1,
+                kHigh = 2,
+                kCritical = 3
+            };
+
+            enum Status
+            {
+                kInvalid = 0,
+                kPending = 1,
+                kInFlight = 2,
+                kComplete = 3,
+                kFailed = 4,
+                kCancelled = 5
+            };
+
+            typedef SlotMap<u32>::handle_type RequestHandle;
+            static const RequestHandle kInvalidRequest = SlotMap<u32>::kInvalidHandle;
+
+            struct Result
+            {
+                RequestHandle Handle;
+                Status State;
+                void_p pOut;
+                size_t Bytes;
+            };
+
+            typedef Delegate<void(Result&)> Callback;
+
+            static const uint kDefaultThreadCount = 2u;
+            static const uint kQueueDepth = 64u;
+
+            AsyncIO(uint aThreadCount = kDefaultThreadCount, bool abAllowUring = true);
+            ~AsyncIO();
+
+            Backend GetBackend() const { return mBackend; }
+
+            // Reads aSize bytes at aOffset of apFile into apOut, which must stay valid until
+            // the request completes. The request is kComplete only if all aSize bytes were
+            // read, otherwise it is kFailed and Result::Bytes holds the count read.
+            RequestHandle Read(const AsyncFilePtr& apFile, u64 aOffset, void_p apOut, size_t aSize, Priority aPriority = kMed, const Callback& aCallback = Callback());
+
+            // Only succeeds for requests that have not been issued yet. The callback runs
+            // on the calling thread before Cancel() returns.
+            bool Cancel(RequestHandle aHandle);
+
+            Status GetStatus(RequestHandle aHandle, size_t* apBytes = null) const;
+
+            // Blocks until the request is complete, failed or cancelled.
+            Status Wait(RequestHandle aHandle, size_t* apBytes = null);
+
+            // Invalidates aHandle. A request released before it is done still completes and
+            // runs its callback, its handle is simply freed afterwards instead of kept for
+            // GetStatus(). Every request must eventually be released.
+            void Release(RequestHandle aHandle);
+
+        private:
+            AsyncIO(const AsyncIO&);
+            AsyncIO& operator=(const AsyncIO&);
+
+            struct Request
+            {
+                AsyncFilePtr pFile;
+                u64 Offset;
+                void_p pOut;
+                size_t Size;
+                Priority Order;
+                u32 Sequence;
+                Callback OnComplete;
+                Status State;
+                size_t Bytes;
+                bool bReleased;
+            };
+
+            struct PendingKey
+            {
+                s32 Order;
+                const AsyncFile* pFile;
+                u64 Offset;
+                u32 Sequence;
+                RequestHandle Handle;
+
+                bool operator<(const PendingKey& b) const
+                {
+                    if (Order != b.Order) { return (Order > b.Order); }
+                    if (pFile != b.pFile) { return (pFile < b.pFile); }
+                    if (Offset != b.Offset) { return (Offset < b.Offset); }
+
+                    return (Sequence < b.Sequence);
+                }
+            };
+
+            typedef std::set<PendingKey> Pending;
+
+            struct Ring;
+
+            Backend mBackend;
+            SlotMap<Request> mRequests;
+            Pending mPending;
+            u32 mSequence;
+            const AsyncFile* mpCursorFile;
+            u64 mCursorOffset;
+            bool mbDone;
+
+#           if JZ_MULTITHREADED
+                mutable Mutex mMutex;
+                ConditionVariable mWork;
+                ConditionVariable mDone;
+                vector<Thread*> mThreads;
+
+                // io_uring only, read results waiting for a worker to run their callback.
+                std::deque<RequestHandle> mCompleted;
+                ConditionVariable mSubmit;
+                Ring* mpRing;
+                Thread* mpRingThread;
+
+                void _RingMain(const Thread& aThread);
+                void _RingReap();
+                void _RingSubmit();
+                void _RingWake();
+                void _WorkerMain(const Thread& aThread);
+#           endif
+
+            static PendingKey _GetKey(RequestHandle aHandle, const Request& aRequest);
+
+            void _Finish(RequestHandle aHandle, Status aStatus, size_t aBytes);
+            RequestHandle _PopPending();
+            void _Service(RequestHandle aHandle);
+        };
+
+    }
+}
+
+#endif
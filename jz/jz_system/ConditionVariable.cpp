@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_system/ConditionVariable.h>
+
+#if JZ_MULTITHREADED
+#   if JZ_PLATFORM_POSIX
+#       include <errno.h>
+#       include <sys/time.h>
+#       include <time.h>
+#   endif
+
+    namespace jz
+    {
+        namespace system
+        {
+
+        #   if JZ_PLATFORM_WINDOWS
+                ConditionVariable::ConditionVariable()
+                {
+                    InitializeConditionVariable(&mHandle);
+                }
+
+                ConditionVariable::~ConditionVariable()
+                {}
+
+                void ConditionVariable::NotifyAll()
+                {
+                    WakeAllConditionVariable(&mHandle);
+                }
+
+                void ConditionVariable::NotifyOne()
+                {
+                    WakeConditionVariable(&mHandle);
+                }
+
+                void ConditionVariable::Wait(Mutex& aMutex)
+                {
+                    SleepConditionVariableCS(&mHandle, &(aMutex.mHandle), INFINITE);
+                }
+
+                bool ConditionVariable::Wait(Mutex& aMutex, ulong aMilliseconds)
+                {
+                    return (SleepConditionVariableCS(&mHandle, &(aMutex.mHandle), aMilliseconds) != FALSE);
+                }
+        #   else
+                ConditionVariable::ConditionVariable()
+                {
+                    pthread_cond_init(&mHandle, null);
+                }
+
+                ConditionVariable::~ConditionVariable()
+                {
+                    pthread_cond_destroy(&mHandle);
+                }
+
+                void ConditionVariable::NotifyAll()
+                {
+                    pthread_cond_broadcast(&mHandle);
+                }
+
+                void ConditionVariable::NotifyOne()
+                {
+                    pthread_cond_signal(&mHandle);
+                }
+
+                void ConditionVariable::Wait(Mutex& aMutex)
+                {
+                    pthread_cond_wait(&mHandle, &(aMutex.mHandle));
+                }
+
+                bool ConditionVariable::Wait(Mutex& aMutex, ulong aMilliseconds)
+                {
+                    // pthread_cond_timedwait takes an absolute CLOCK_REALTIME time.
+                    timeval now;
+                    gettimeofday(&now, null);
+
+                    u64 nanoseconds = ((u64)now.tv_usec * 1000u) + ((u64)(aMilliseconds % 1000u) * 1000000u);
+
+                    timespec t;
+                    t.tv_sec = now.tv_sec + (time_t)(aMilliseconds / 1000u) + (time_t)(nanoseconds / 1000000000u);
+                    t.tv_nsec = (long)(nanoseconds % 1000000000u);
+
+                    return (pthread_cond_timedwait(&mHandle, &(aMutex.mHandle), &t) != ETIMEDOUT);
+                }
+        #   endif
+
+        }
+    }
+#endif
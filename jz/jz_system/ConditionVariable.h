@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SYSTEM_CONDITION_VARIABLE_H_
+#define _JZ_SYSTEM_CONDITION_VARIABLE_H_
+
+#include <jz_core/Prereqs.h>
+
+#if JZ_MULTITHREADED
+#   include <jz_system/Mutex.h>
+
+    namespace jz
+    {
+        namespace system
+        {
+
+            // Waiters must hold aMutex exactly once (it is recursive, but a wait only
+            // releases one level of ownership). Wakeups may be spurious, always wait
+            // in a loop that checks the predicate.
+            class ConditionVariable
+            {
+                public:
+                    ConditionVariable();
+                    ~ConditionVariable();
+
+                    void NotifyAll();
+                    void NotifyOne();
+
+                    void Wait(Mutex& aMutex);
+
+                    // Returns false on timeout.
+                    bool Wait(Mutex& aMutex, ulong aMilliseconds);
+
+                private:
+                    ConditionVariable(const ConditionVariable&);
+                    ConditionVariable& operator=(const ConditionVariable&);
+
+        #           if JZ_PLATFORM_WINDOWS
+                        CONDITION_VARIABLE mHandle;
+        #           else
+                        pthread_cond_t mHandle;
+        #           endif
+            };
+
+        }
+    }
+#endif
+
+#endif
@@ -20,22 +20,32 @@
 // THE SOFTWARE.
 //
 
+#include <jz_core/Hash.h>
 #include <jz_core/Memory.h>
 #include <jz_core/StringUtility.h>
 #include <jz_system/Files.h>
+#include <algorithm>
+#include <stdexcept>
 
 #include <sys/stat.h>
 #include <zlib/zlib.h>
 
+#if JZ_MULTITHREADED
+#   include <jz_system/Thread.h>
+#endif
+
 #if JZ_PLATFORM_WINDOWS
 #   include <jz_system/Win32.h>
 #   include <direct.h>
 #   include <io.h>
+#else
+#   include <dirent.h>
+#   include <unistd.h>
 #endif
 
 namespace jz
 {
-    system::Files* system::Files::mspSingleton = null;
+    template <> system::Files* Singleton<system::Files>::mspSingleton = null;
     namespace system
     {
 
@@ -47,6 +57,11 @@ namespace jz
             : mFilename(apFilename), mpData(apData), mSize(aSize), mPosition(0), mbOwnMemory(abOwnMemory)
         {}
 
+        // The buffer is shared and immutable, mpBuffer only keeps it alive.
+        MemoryReadFile::MemoryReadFile(const string& aFilename, const SharedBufferPtr& apBuffer)
+            : mFilename(aFilename), mpBuffer(apBuffer), mpData((void_p)apBuffer->Get()), mSize(apBuffer->size()), mPosition(0), mbOwnMemory(false)
+        {}
+
         MemoryReadFile::~MemoryReadFile()
         {
             if (mbOwnMemory && mpData)
@@ -71,7 +86,7 @@ namespace jz
                     n -= (pos - mSize);
                 }
 
-                memcpy(apOutBuffer, (byte*)mpData + mPosition, n);
+                memcpy(apOutBuffer, (u8*)mpData + mPosition, n);
 
         #       if !NDEBUG
                     long tmp = mPosition;
@@ -138,7 +153,7 @@ namespace jz
 #           if JZ_PLATFORM_WINDOWS
                 CloseHandle(StaticCast<HANDLE>(mpFile));
 #           else
-                fclose(StaticCast<HANDLE>(mpFile));
+                fclose(StaticCast<FILE*>(mpFile));
 #           endif
         }
         
@@ -151,7 +166,7 @@ namespace jz
 #           if JZ_PLATFORM_WINDOWS
                 return SetFilePointer(StaticCast<HANDLE>(mpFile), 0u, null, FILE_CURRENT);
 #           else
-                return ftell(StaticCast<FILE>(mpFile));
+                return ftell(StaticCast<FILE*>(mpFile));
 #           endif
         }
 
@@ -167,7 +182,7 @@ namespace jz
 
                 return (read);
 #           else
-                return (fread(apOutBuffer, 1, aSize, StaticCast<FILE>(mpFile)));
+                return (fread(apOutBuffer, 1, aSize, StaticCast<FILE*>(mpFile)));
 #           endif
         }
         
@@ -189,7 +204,7 @@ namespace jz
 
                 return true;
 #           else
-                return (fseek(StaticCast<FILE>(mpFile), aPosition, (abRelative) ? SEEK_CUR : SEEK_SET));
+                return (fseek(StaticCast<FILE*>(mpFile), aPosition, (abRelative) ? SEEK_CUR : SEEK_SET) == 0);
 #           endif
         }
 
@@ -203,20 +218,21 @@ namespace jz
                 }
                 else
                 {
-                    throw std::exception(__FUNCTION__ ": load failed.");
+                    throw JZ_EXCEPTION("load failed.");
                 }
 #           else
-                mpFile = fopen(mFilename.c_str(), "rb");
+                FILE* pFile = fopen(mFilename.c_str(), "rb");
+                mpFile = pFile;
             
-                if (mpFile)
+                if (pFile)
                 {
-                    fseek(mpFile, 0, SEEK_END);
-                    mSize = ftell(mpFile);
-                    fseek(mpFile, 0, SEEK_SET);
+                    fseek(pFile, 0, SEEK_END);
+                    mSize = ftell(pFile);
+                    fseek(pFile, 0, SEEK_SET);
                 }
                 else
                 {
-                    throw std::exception(__FUNCTION__ ": load failed.");
+                    throw JZ_EXCEPTION("load failed.");
                 }        
 #           endif
         }
@@ -281,7 +297,7 @@ namespace jz
             }
             else
             {
-                throw std::exception(__FUNCTION__ ": load failed.");
+                throw JZ_EXCEPTION("load failed.");
             }        
         }
 
@@ -369,6 +385,173 @@ namespace jz
             return true;
         }
 
+        BufferedReadFile::BufferedReadFile(const AutoPtr<IReadFile>& apFile, size_t aBufferSize)
+            : mpFile(apFile), mBuffer(Max(aBufferSize, (size_t)1u)), mBufferStart(0), mBufferUsed(0u), mPosition(apFile->GetPosition()), mSize(apFile->GetSize())
+        {}
+
+        BufferedReadFile::~BufferedReadFile()
+        {}
+
+        size_t BufferedReadFile::Read(void_p apOutBuffer, size_t aSize)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            u8* pOut = (u8*)apOutBuffer;
+            size_t ret = 0u;
+
+            while (ret < aSize)
+            {
+                if (mPosition >= mBufferStart && (size_t)(mPosition - mBufferStart) < mBufferUsed)
+                {
+                    const size_t kOffset = (size_t)(mPosition - mBufferStart);
+                    const size_t kCount = Min(aSize - ret, mBufferUsed - kOffset);
+
+                    memcpy(pOut + ret, mBuffer.Get() + kOffset, kCount);
+                    ret += kCount;
+                    mPosition += (natural)kCount;
+                }
+                else if (aSize - ret >= mBuffer.size())
+                {
+                    if (mpFile->GetPosition() != mPosition && !mpFile->Seek(mPosition, false)) { break; }
+
+                    const size_t kCount = mpFile->Read(pOut + ret, aSize - ret);
+                    ret += kCount;
+                    mPosition += (natural)kCount;
+                    break;
+                }
+                else if (!_Fill())
+                {
+                    break;
+                }
+            }
+
+            return ret;
+        }
+
+        bool BufferedReadFile::Seek(natural aPosition, bool abRelative)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            const natural kPosition = (abRelative) ? (mPosition + aPosition) : aPosition;
+
+            if (kPosition < 0 || (size_t)kPosition > mSize)
+            {
+                return false;
+            }
+
+            // The buffer is kept; a seek that lands inside it is served without touching the wrapped file.
+            mPosition = kPosition;
+
+            return true;
+        }
+
+        bool BufferedReadFile::_Fill()
+        {
+            mBufferStart = mPosition;
+            mBufferUsed = 0u;
+
+            if (mpFile->GetPosition() != mPosition && !mpFile->Seek(mPosition, false))
+            {
+                return false;
+            }
+
+            mBufferUsed = mpFile->Read(mBuffer.Get(), mBuffer.size());
+
+            return (mBufferUsed > 0u);
+        }
+
+        BufferedWriteFile::BufferedWriteFile(const AutoPtr<IWriteFile>& apFile, size_t aBufferSize)
+            : mpFile(apFile), mBuffer(Max(aBufferSize, (size_t)1u)), mBufferUsed(0u)
+        {}
+
+        BufferedWriteFile::~BufferedWriteFile()
+        {
+            _Flush();
+        }
+
+        natural BufferedWriteFile::GetPosition() const
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(const_cast<Mutex&>(mMutex));
+#           endif
+
+            return (mpFile->GetPosition() + (natural)mBufferUsed);
+        }
+
+        size_t BufferedWriteFile::GetSize() const
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(const_cast<Mutex&>(mMutex));
+#           endif
+
+            return Max(mpFile->GetSize(), (size_t)(mpFile->GetPosition() + (natural)mBufferUsed));
+        }
+
+        bool BufferedWriteFile::Flush()
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            return _Flush();
+        }
+
+        bool BufferedWriteFile::Seek(natural aPosition, bool abRelative)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            if (!_Flush())
+            {
+                return false;
+            }
+
+            return mpFile->Seek(aPosition, abRelative);
+        }
+
+        size_t BufferedWriteFile::Write(voidc_p apOutBuffer, size_t aSize)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            if (mBufferUsed + aSize > mBuffer.size())
+            {
+                if (!_Flush())
+                {
+                    return 0u;
+                }
+            }
+
+            if (aSize >= mBuffer.size())
+            {
+                return mpFile->Write(apOutBuffer, aSize);
+            }
+
+            memcpy(mBuffer.Get() + mBufferUsed, apOutBuffer, aSize);
+            mBufferUsed += aSize;
+
+            return aSize;
+        }
+
+        bool BufferedWriteFile::_Flush()
+        {
+            if (mBufferUsed == 0u)
+            {
+                return true;
+            }
+
+            const size_t kUsed = mBufferUsed;
+            mBufferUsed = 0u;
+
+            return (mpFile->Write(mBuffer.Get(), kUsed) == kUsed);
+        }
+
         enum
         {
             gkZipEncrypted            = 1 << 0,
@@ -378,6 +561,8 @@ namespace jz
             gkZipStrongEncrypted      = 1 << 6,
             gkZipUseUTF8              = 1 << 11,
             gkLocalHeaderSignature    = 0x04034b50,
+            gkCentralHeaderSignature  = 0x02014b50,
+            gkEndOfDirectorySignature = 0x06054b50,
         };
         
         enum
@@ -394,284 +579,1078 @@ namespace jz
             gkZipCompressionBZip2     = 12
         };
 
-        ZipArchive::ZipArchive(const char* apFilename)
-            : mpZipFile(Files::GetSingleton().Open(apFilename))
+        // Raw deflate stream, as stored in zip entries.
+        static bool _Inflate(const u8* apIn, u32 aInSize, u8* apOut, u32 aOutSize)
         {
-            while (FindLocalHeaders());
-        }
+            z_stream stream;
+            int ret(Z_ERRNO);
 
-        ZipArchive::ZipArchive(const string& aFilename)
-            : mpZipFile(Files::GetSingleton().Open(aFilename.c_str()))
-        {
-            while (FindLocalHeaders());
-        }
+            stream.next_in   = (Bytef*)apIn;
+            stream.avail_in  = (uInt)aInSize;
+            stream.next_out  = (Bytef*)apOut;
+            stream.avail_out = (uInt)aOutSize;
+            stream.zalloc    = (alloc_func)0;
+            stream.zfree     = (free_func)0;
 
-        ZipArchive::~ZipArchive()
-        {}
+            ret = inflateInit2(&stream, -MAX_WBITS);
 
-        bool ZipArchive::GetExists(const char* apFilename) const
-        {
-            string filename(Files::CleanFilename(apFilename));
-            
-            if (mFiles.find(filename) != mFiles.end()) { return true; }
-            else { return false; }
+            if (ret == Z_OK)
+            {
+                ret = inflate(&stream, Z_FINISH);
+                inflateEnd(&stream);
+
+                if (ret == Z_STREAM_END)
+                {
+                    ret = Z_OK;
+                }
+            }
+
+            return (ret == Z_OK);
         }
 
-        IReadFile* ZipArchive::Open(const char* apFilename) const
+        // Null if apFilename is not a file on disk, AsyncFile cannot see into archives.
+        static AsyncFile* _OpenAsyncFile(const char* apFilename)
         {
-            string filename(Files::CleanFilename(apFilename));
-            
-            return _Open(filename);
+            if (Files::Exists(apFilename)) { return new AsyncFile(apFilename); }
+
+            string cleanedFilename(Files::CleanFilename(apFilename));
+            if (Files::Exists(cleanedFilename.c_str())) { return new AsyncFile(cleanedFilename); }
+
+            return null;
         }
 
-        IReadFile* ZipArchive::_Open(const string& aFilename) const
+        static AsyncIO::RequestHandle _ReadAsync(const AsyncFilePtr& apFile, ByteBuffer& arOut, AsyncIO::Priority aPriority, const AsyncIO::Callback& aCallback)
         {
-            const ZipFileEntry* pEntry(0);
-            
-            CompressedFiles::const_iterator I = mFiles.find(aFilename);
-            JZ_E_ON_FAIL(I != mFiles.end(), "file not found.");
-
-            pEntry = &(I->second);
-           
-            switch (pEntry->Header.CompressionMethod)
-            {
-                case gkZipCompressionStore:
-                    return new SubReadFile(pEntry->FullFilename, mpZipFile, pEntry->Offset, pEntry->Offset + pEntry->Header.DataDescriptor.UncompressedSize);
-                break;
-                case gkZipCompressionDeflated:
-                    {
-                        u32 cSize = pEntry->Header.DataDescriptor.CompressedSize;
-                        u32 uSize = pEntry->Header.DataDescriptor.UncompressedSize;
-
-                        byte* pcBuf = (byte*)Malloc(cSize, JZ_ALIGN_OF(byte));
-                        byte* puBuf = (byte*)Malloc(uSize, JZ_ALIGN_OF(byte));
-
-                        const_cast< AutoPtr<IReadFile>& >(mpZipFile)->Seek(pEntry->Offset, false);
-                        const_cast< AutoPtr<IReadFile>& >(mpZipFile)->Read(pcBuf, cSize);
-                        
-                        z_stream stream;
-                        int ret(Z_ERRNO);    			
-
-                        stream.next_in   = (Bytef*)pcBuf;
-                        stream.avail_in  = (uInt)cSize;
-                        stream.next_out  = (Bytef*)puBuf;
-                        stream.avail_out = (uInt)uSize;
-                        stream.zalloc    = (alloc_func)0;
-                        stream.zfree     = (free_func)0;
-
-                        ret = inflateInit2(&stream, -MAX_WBITS);
-                        
-                        if (ret == Z_OK)
-                        {
-                            ret = inflate(&stream, Z_FINISH);
-                            inflateEnd(&stream);
-                            
-                            if (ret == Z_STREAM_END)
-                            {
-                                ret = Z_OK;
-                            }
-                            
-                            inflateEnd(&stream);
-                        }
+            arOut.resize((size_t)apFile->GetSize());
 
-                        Free(pcBuf);
-                        pcBuf = 0;
-                        
-                        if (ret != Z_OK)
-                        {
-                            Free(puBuf);
-                            JZ_E_ON_FAIL(false, "inflation failed.");
-                        }
-                        else
-                        {
-                            return new MemoryReadFile(pEntry->FullFilename, puBuf, uSize, true);
-                        }
-                    }
-                break;
-            }
-            
-            JZ_E_ON_FAIL(false, "file not found.");
+            return AsyncIO::GetSingleton().Read(apFile, 0u, arOut.Get(), arOut.size(), aPriority, aCallback);
         }
 
-    #   if JZ_LITTLE_ENDIAN
-            bool ZipArchive::FindLocalHeaders()
-            {
-                char buffer[Files::kMaximumPathLength];
+        // Owns the compressed data of a deflated zip entry while it is read, then inflates
+        // it into the caller's buffer and chains to the caller's callback.
+        class ZipInflateRead sealed
+        {
+        public:
+            ZipInflateRead(u32 aCompressedSize, u8* apOut, u32 aSize, const AsyncIO::Callback& aCallback)
+                : mCompressed(aCompressedSize), mpOut(apOut), mSize(aSize), mCallback(aCallback)
+            {}
 
-	            ZipFileEntry entry;
+            u8* GetCompressed() { return mCompressed.Get(); }
 
-                JZ_E_ON_FAIL(mpZipFile->Read(&entry.Header, sizeof(ZipLocalFileHeader)) == sizeof(ZipLocalFileHeader), "failed reading local header.");
-                
-                // todo: verify that this is correct procedure - basically, we stop when we get to 
-                // the end of the zip file, which has different information than the local headers
-                // and will not have a "correct" signature.
-                if (entry.Header.Signature != gkLocalHeaderSignature)
+            void OnRead(AsyncIO::Result& arResult)
+            {
+                if (arResult.State == AsyncIO::kComplete)
                 {
-                    return false;
+                    if (_Inflate(mCompressed.Get(), (u32)mCompressed.size(), mpOut, mSize)) { arResult.Bytes = mSize; }
+                    else { arResult.State = AsyncIO::kFailed; arResult.Bytes = 0u; }
                 }
 
-                JZ_E_ON_FAIL(entry.Header.FilenameLength <= Files::kMaximumPathLength, "filename length too big.");
-                JZ_E_ON_FAIL(mpZipFile->Read(buffer, entry.Header.FilenameLength) == entry.Header.FilenameLength, "failed reading filename.");
-                
-                buffer[entry.Header.FilenameLength] = 0; // add null terminator
-                ProcessFilename(buffer, entry);
+                arResult.pOut = mpOut;
 
-                // skip the extra field
-                if (entry.Header.ExtraFieldLength > 0)
-                {
-                    JZ_E_ON_FAIL(mpZipFile->Seek(entry.Header.ExtraFieldLength, true), "failed skipping extra field.");
-                }
+                AsyncIO::Callback callback(mCallback);
+                delete this;
 
-                // todo: according to the standard, this is after the compressed data?
-                // but how do we know the size in this case? Is the descriptor in the header
-                // still valid?
-                if (entry.Header.Flags & gkZipUseDataDescriptor)
-                {
-                    JZ_E_ON_FAIL(mpZipFile->Read(&entry.Header.DataDescriptor, sizeof(ZipDataDescriptor)) == sizeof(ZipDataDescriptor), "failed reading data descriptor.");
-	            }
-    	        
-	            entry.Offset = mpZipFile->GetPosition();
+                if (callback) { callback(arResult); }
+            }
 
-                JZ_E_ON_FAIL(mpZipFile->Seek(entry.Header.DataDescriptor.CompressedSize, true), "failed skipping compressed data.");
+        private:
+            ZipInflateRead(const ZipInflateRead&);
+            ZipInflateRead& operator=(const ZipInflateRead&);
 
-                // THis is not general. Two folders deep will fail.
-                mFiles.insert(make_pair(entry.FullFilename, entry));
+            ByteBuffer mCompressed;
+            u8* mpOut;
+            u32 mSize;
+            AsyncIO::Callback mCallback;
+        };
 
-	            return true;
+        InflateReadFile::InflateReadFile(const string& aFilename, const AutoPtr<IReadFile>& apFile, const AsyncFilePtr& apAsyncFile, natural aStart, size_t aCompressedSize, size_t aSize)
+            : mFilename(aFilename), mpFile(apFile), mpAsyncFile(apAsyncFile), mStart(aStart), mCompressedSize(aCompressedSize), mSize(aSize), mPosition(0),
+              mpStream(null), mInput(kInputSize), mIn(0u), mOut(0u), mWindow(kWindowSize)
+        {
+            z_stream* pStream = new z_stream;
+            memset(pStream, 0, sizeof(z_stream));
+
+            if (inflateInit2(pStream, -MAX_WBITS) != Z_OK)
+            {
+                delete pStream;
+                JZ_E_ON_FAIL(false, "inflate init failed.");
             }
-    #   endif        
 
-        void ZipArchive::ProcessFilename(const char* apFilename, ZipFileEntry& arOut)
-        {
-            arOut.Path = Files::CleanFilename(Files::ExtractPath(apFilename));
-            arOut.ShortFilename = Files::CleanFilename(Files::ExtractBase(apFilename) + "." + Files::ExtractExtension(apFilename));
-            arOut.FullFilename = Files::CleanFilename(apFilename);
+            mpStream = pStream;
         }
 
-        
-        FileArchive::FileArchive(const string& aPath)
-            : mPath(aPath)
+        InflateReadFile::~InflateReadFile()
         {
-            JZ_E_ON_FAIL(Files::IsDirectory(mPath.c_str()), "path is not valid.");
+            z_stream* pStream = static_cast<z_stream*>(mpStream);
+            inflateEnd(pStream);
+            delete pStream;
         }
 
-        FileArchive::~FileArchive()
+        size_t InflateReadFile::Read(void_p apOutBuffer, size_t aSize)
         {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            if ((size_t)mPosition >= mSize) { return 0u; }
+
+            const size_t kSize = Min(aSize, mSize - (size_t)mPosition);
+
+            if (mOut != (size_t)mPosition) { _Restart(mPosition); }
+
+            const size_t ret = _Inflate((u8*)apOutBuffer, kSize);
+            mPosition += (natural)ret;
+
+            return ret;
         }
 
-        bool FileArchive::GetExists(const char* apFilename) const
+        // Only moves the read position, the stream catches up on the next Read().
+        bool InflateReadFile::Seek(natural aPosition, bool abRelative)
         {
-            string fullPath = Files::Combine(mPath, apFilename);
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
 
-            bool bReturn = (Files::Exists(fullPath.c_str()));
-            bReturn = bReturn && Files::IsFile(fullPath.c_str());
-            
-            return bReturn;
+            const natural kPosition = (abRelative) ? mPosition + aPosition : aPosition;
+
+            if (kPosition < 0 || (size_t)kPosition > mSize) { return false; }
+
+            mPosition = kPosition;
+
+            return true;
         }
 
-        IReadFile* FileArchive::Open(const char* apFilename) const
+        // Inflates up to aSize bytes into apOut, or discards them if apOut is null. Output
+        // goes through the circular mWindow so the last kWindowSize bytes are always at
+        // hand when a block boundary qualifies as a restart point.
+        size_t InflateReadFile::_Inflate(u8* apOut, size_t aSize)
         {
-            string fullPath = Files::Combine(mPath, apFilename);
+            z_stream& stream = *static_cast<z_stream*>(mpStream);
+            size_t ret = 0u;
 
-            IReadFile* pReturn = new ReadFile(fullPath.c_str());
+            while (ret < aSize && mOut < mSize)
+            {
+                if (stream.avail_in == 0u)
+                {
+                    const size_t kIn = Min(kInputSize, mCompressedSize - mIn);
 
-            return pReturn;
-        }
+                    if (kIn == 0u || !_ReadInput(mIn, mInput.Get(), kIn)) { break; }
 
-        Files::Files()
-        {}
-            
-        Files::~Files()
-        {}
+                    mIn += kIn;
+                    stream.next_in  = (Bytef*)mInput.Get();
+                    stream.avail_in = (uInt)kIn;
+                }
 
-        string Files::CleanFilename(const string& aFilename)
-        {
-            size_t size = aFilename.length();
+                const size_t kWindowPosition = (mOut % kWindowSize);
+                const size_t kAvailable = Min(kWindowSize - kWindowPosition, aSize - ret);
 
-            string ret;
-            ret.resize(size);
+                stream.next_out  = (Bytef*)(mWindow.Get() + kWindowPosition);
+                stream.avail_out = (uInt)kAvailable;
 
-            for (size_t i = 0u; i < size; i++)
-            {
-#               if JZ_PLATFORM_WINDOWS
-                    if (aFilename[i] == '/') { ret[i] = '\\'; }
-#               else
-                    if (aFilename[i] == '\\') { ret[i] = '/'; }
-#               endif
+                const int kResult = inflate(&stream, Z_BLOCK);
+                JZ_E_ON_FAIL(kResult == Z_OK || kResult == Z_STREAM_END || (kResult == Z_BUF_ERROR && stream.avail_in == 0u), "inflation failed.");
+
+                const size_t kProduced = (kAvailable - stream.avail_out);
+                if (apOut) { memcpy(apOut + ret, mWindow.Get() + kWindowPosition, kProduced); }
+
+                ret  += kProduced;
+                mOut += kProduced;
+
+                if (kResult == Z_STREAM_END) { break; }
+
+                // Bit 7 of data_type is set at the end of a block header, bit 6 if that
+                // block is the last one.
+                const size_t kLastRestart = (mRestartPoints.empty()) ? 0u : mRestartPoints.back().Out;
+                if ((stream.data_type & 128) && !(stream.data_type & 64) && (mOut - kLastRestart) >= kRestartInterval)
+                {
+                    const size_t kWindow = Min(mOut, kWindowSize);
+                    const size_t kHead = (mOut % kWindowSize);
+
+                    mRestartPoints.push_back(RestartPoint());
+                    RestartPoint& point = mRestartPoints.back();
+                    point.Out  = mOut;
+                    point.In   = (mIn - stream.avail_in);
+                    point.Bits = (stream.data_type & 7);
+                    point.Window.resize(kWindow);
+
+                    // Unroll the circular window, oldest byte first.
+                    if (kWindow < kWindowSize) { memcpy(point.Window.Get(), mWindow.Get(), kWindow); }
                     else
                     {
-                        ret[i] = tolower(aFilename[i]);
+                        memcpy(point.Window.Get(), mWindow.Get() + kHead, kWindowSize - kHead);
+                        memcpy(point.Window.Get() + (kWindowSize - kHead), mWindow.Get(), kHead);
                     }
+                }
             }
 
             return ret;
         }
-           
-        void Files::AddArchive(const AutoPtr<IArchive>& apArchive)
+
+        bool InflateReadFile::_ReadInput(size_t aOffset, u8* apOut, size_t aSize)
         {
-#           if JZ_MULTITHREADED
-                Lock lock(mMutex);
-#           endif
+            const natural kOffset = mStart + (natural)aOffset;
 
-            mArchives.push_back(apArchive);
-        }
+            if (mpAsyncFile.Get()) { return (mpAsyncFile->ReadAt((u64)kOffset, apOut, aSize) == aSize); }
 
-        bool Files::GetExists(const char* apFilename) const
+            const natural kOriginal = mpFile->GetPosition();
+            const bool kbReturn = mpFile->Seek(kOffset, false) && (mpFile->Read(apOut, aSize) == aSize);
+            mpFile->Seek(kOriginal, false);
+
+            return kbReturn;
+        }
+
+        // Positions the stream at the nearest restart point at or before aPosition and
+        // inflates forward to it.
+        void InflateReadFile::_Restart(natural aPosition)
         {
-            if (Files::Exists(apFilename)) { return true; }
-            
-            string cleanedFilename(CleanFilename(apFilename));
+            z_stream& stream = *static_cast<z_stream*>(mpStream);
+            const size_t kPosition = (size_t)aPosition;
 
-            if (Files::Exists(cleanedFilename.c_str())) { return true; }
+            const RestartPoint* pPoint = null;
+            for (size_t i = mRestartPoints.size(); i > 0u; i--)
             {
-#               if JZ_MULTITHREADED
-                    Lock lock(const_cast<Mutex&>(mMutex));
-#               endif
+                if (mRestartPoints[i - 1u].Out <= kPosition) { pPoint = &mRestartPoints[i - 1u]; break; }
+            }
+
+            const size_t kPointOut = (pPoint) ? pPoint->Out : 0u;
+
+            // Reading forward from where the stream already is beats any restart point.
+            if (mOut > kPosition || mOut < kPointOut)
+            {
+                JZ_E_ON_FAIL(inflateReset(&stream) == Z_OK, "inflate reset failed.");
+                stream.avail_in = 0u;
 
-                for (Archives::const_iterator I = mArchives.begin(); I != mArchives.end(); I++)
+                if (pPoint)
                 {
-                    if ((*I)->GetExists(cleanedFilename.c_str())) { return true; }
+                    if (pPoint->Bits > 0)
+                    {
+                        u8 byte = 0u;
+                        JZ_E_ON_FAIL(_ReadInput(pPoint->In - 1u, &byte, 1u), "failed reading compressed data.");
+                        inflatePrime(&stream, pPoint->Bits, byte >> (8 - pPoint->Bits));
+                    }
+
+                    JZ_E_ON_FAIL(inflateSetDictionary(&stream, (const Bytef*)pPoint->Window.Get(), (uInt)pPoint->Window.size()) == Z_OK, "inflate set dictionary failed.");
+
+                    // Restore the tail of the circular window, later restart points copy it.
+                    for (size_t i = 0u; i < pPoint->Window.size(); i++)
+                    {
+                        mWindow[(pPoint->Out - pPoint->Window.size() + i) % kWindowSize] = pPoint->Window[i];
+                    }
                 }
+
+                mIn  = (pPoint) ? pPoint->In : 0u;
+                mOut = kPointOut;
             }
 
-            return false;
+            while (mOut < kPosition)
+            {
+                JZ_E_ON_FAIL(_Inflate(null, kPosition - mOut) > 0u, "failed inflating to seek position.");
+            }
         }
 
-        IReadFile* Files::Open(const char* apFilename) const
+        struct ZipArchive::EntryLess
+        {
+            EntryLess(const char* apNames)
+                : mpNames(apNames)
+            {}
+
+            bool operator()(const ZipFileEntry& a, const ZipFileEntry& b) const
+            {
+                return (_Compare(mpNames + a.NameOffset, a.NameLength, mpNames + b.NameOffset, b.NameLength) < 0);
+            }
+
+            bool operator()(const ZipFileEntry& a, const string& b) const
+            {
+                return (_Compare(mpNames + a.NameOffset, a.NameLength, b.c_str(), b.length()) < 0);
+            }
+
+            bool operator()(const string& a, const ZipFileEntry& b) const
+            {
+                return (_Compare(a.c_str(), a.length(), mpNames + b.NameOffset, b.NameLength) < 0);
+            }
+
+        private:
+            static int _Compare(const char* a, size_t aLength, const char* b, size_t bLength)
+            {
+                const int kReturn = memcmp(a, b, Min(aLength, bLength));
+
+                if (kReturn != 0) { return kReturn; }
+                else { return (aLength < bLength) ? -1 : ((aLength > bLength) ? 1 : 0); }
+            }
+
+            const char* mpNames;
+        };
+
+        ZipArchive::ZipArchive(const char* apFilename)
+            : mpZipFile(Files::GetSingleton().Open(apFilename)), mpAsyncFile(_OpenAsyncFile(apFilename))
+        {
+            if (!_ReadCentralDirectory())
+            {
+                mEntries.clear();
+                mNames.clear();
+
+                JZ_E_ON_FAIL(mpZipFile->Seek(0, false), "failed seeking to first local header.");
+                while (FindLocalHeaders());
+            }
+
+            _Sort();
+        }
+
+        ZipArchive::ZipArchive(const string& aFilename)
+            : mpZipFile(Files::GetSingleton().Open(aFilename.c_str())), mpAsyncFile(_OpenAsyncFile(aFilename.c_str()))
+        {
+            if (!_ReadCentralDirectory())
+            {
+                mEntries.clear();
+                mNames.clear();
+
+                JZ_E_ON_FAIL(mpZipFile->Seek(0, false), "failed seeking to first local header.");
+                while (FindLocalHeaders());
+            }
+
+            _Sort();
+        }
+
+        ZipArchive::~ZipArchive()
+        {}
+
+        bool ZipArchive::GetExists(const char* apFilename) const
+        {
+            string filename(Files::CleanFilename(apFilename));
+            
+            if (_Find(filename)) { return true; }
+            else { return false; }
+        }
+
+        IReadFile* ZipArchive::Open(const char* apFilename) const
+        {
+            string filename(Files::CleanFilename(apFilename));
+            
+            return _Open(filename);
+        }
+
+        bool ZipArchive::GetFiles(vector<string>& arOut) const
+        {
+            arOut.reserve(arOut.size() + mEntries.size());
+
+            for (Entries::const_iterator I = mEntries.begin(); I != mEntries.end(); I++)
+            {
+                arOut.push_back(_GetName(*I));
+            }
+
+            return true;
+        }
+
+        IReadFile* ZipArchive::_Open(const string& aFilename) const
         {
-            if (Files::Exists(apFilename))
+            const ZipFileEntry* pEntry = _Find(aFilename);
+            JZ_E_ON_FAIL(pEntry, "file not found.");
+
+            const natural kOffset = _GetDataOffset(*pEntry);
+           
+            switch (pEntry->CompressionMethod)
             {
-                return new ReadFile(apFilename);
+                case gkZipCompressionStore:
+                    // SubReadFile takes an inclusive end position.
+                    return new SubReadFile(_GetName(*pEntry), mpZipFile, kOffset, kOffset + (natural)pEntry->UncompressedSize - 1);
+                break;
+                case gkZipCompressionDeflated:
+                    // Entries the AssetCache takes are inflated whole and shared, anything
+                    // else streams.
+                    if (AssetCache::GetSingletonExists() && AssetCache::GetSingleton().GetAccepts(pEntry->UncompressedSize))
+                    {
+                        AssetCache& cache = AssetCache::GetSingleton();
+                        const string kName(_GetName(*pEntry));
+                        const u64 kKey = AssetCache::GetKey(mpZipFile->GetFilename(), kName, pEntry->Crc32, pEntry->UncompressedSize);
+
+                        SharedBufferPtr pBuffer(cache.Find(kKey));
+                        if (!pBuffer.IsValid()) { pBuffer = cache.Insert(kKey, _InflateEntry(*pEntry, kOffset)); }
+
+                        return new MemoryReadFile(kName, pBuffer);
+                    }
+                    else
+                    {
+                        return new InflateReadFile(_GetName(*pEntry), mpZipFile, mpAsyncFile, kOffset, pEntry->CompressedSize, pEntry->UncompressedSize);
+                    }
+                break;
             }
             
-            string cleanedFilename(CleanFilename(apFilename));
+            JZ_E_ON_FAIL(false, "unsupported compression method.");
+        }
+
+        // The data offset of entries from the central directory is resolved here, with a
+        // small blocking read of the local header on the calling thread.
+        AsyncIO::RequestHandle ZipArchive::ReadAsync(const char* apFilename, ByteBuffer& arOut, AsyncIO::Priority aPriority, const AsyncIO::Callback& aCallback) const
+        {
+            if (!mpAsyncFile.Get()) { return AsyncIO::kInvalidRequest; }
+
+            const ZipFileEntry* pEntry = _Find(Files::CleanFilename(apFilename));
+            JZ_E_ON_FAIL(pEntry, "file not found.");
 
-            if (Files::Exists(cleanedFilename.c_str()))
+            const natural kOffset = _GetDataOffset(*pEntry);
+            const u32 kSize = pEntry->UncompressedSize;
+
+            switch (pEntry->CompressionMethod)
             {
-                return new ReadFile(cleanedFilename);
+                case gkZipCompressionStore:
+                    arOut.resize(kSize);
+                    return AsyncIO::GetSingleton().Read(mpAsyncFile, kOffset, arOut.Get(), kSize, aPriority, aCallback);
+                break;
+                case gkZipCompressionDeflated:
+                    {
+                        arOut.resize(kSize);
+
+                        const u32 kCompressedSize = pEntry->CompressedSize;
+                        ZipInflateRead* p = new ZipInflateRead(kCompressedSize, arOut.Get(), kSize, aCallback);
+
+                        try
+                        {
+                            return AsyncIO::GetSingleton().Read(mpAsyncFile, kOffset, p->GetCompressed(), kCompressedSize, aPriority,
+                                AsyncIO::Callback::Bind<ZipInflateRead, &ZipInflateRead::OnRead>(p));
+                        }
+                        catch (...)
+                        {
+                            delete p;
+                            throw;
+                        }
+                    }
+                break;
             }
+
+            JZ_E_ON_FAIL(false, "unsupported compression method.");
+        }
+
+        void ZipArchive::_AddEntry(const char* apFilename, size_t aLength, ZipFileEntry& arEntry)
+        {
+            const string kFilename(Files::CleanFilename(string(apFilename, aLength)));
+
+            arEntry.NameOffset = (u32)mNames.size();
+            arEntry.NameLength = (u32)kFilename.length();
+
+            mNames.insert(mNames.end(), kFilename.begin(), kFilename.end());
+            mEntries.push_back(arEntry);
+        }
+
+        const ZipArchive::ZipFileEntry* ZipArchive::_Find(const string& aFilename) const
+        {
+            if (mEntries.empty()) { return null; }
+
+            const EntryLess kLess((mNames.empty()) ? null : &mNames[0]);
+            Entries::const_iterator I = lower_bound(mEntries.begin(), mEntries.end(), aFilename, kLess);
+
+            if (I != mEntries.end() && !kLess(aFilename, *I)) { return &(*I); }
+            else { return null; }
+        }
+
+        natural ZipArchive::_GetDataOffset(const ZipFileEntry& aEntry) const
+        {
+            if (aEntry.DataOffset != 0u) { return (natural)aEntry.DataOffset; }
+
+            ZipLocalFileHeader header;
+            JZ_E_ON_FAIL(_ReadAt(aEntry.LocalHeaderOffset, &header, sizeof(ZipLocalFileHeader)), "failed reading local header.");
+            JZ_E_ON_FAIL(header.Signature == gkLocalHeaderSignature, "invalid local header.");
+
+            return (natural)(aEntry.LocalHeaderOffset + sizeof(ZipLocalFileHeader) + header.FilenameLength + header.ExtraFieldLength);
+        }
+
+        SharedBufferPtr ZipArchive::_InflateEntry(const ZipFileEntry& aEntry, natural aOffset) const
+        {
+            ByteBuffer compressed(aEntry.CompressedSize);
+            SharedBufferPtr pReturn(new SharedBuffer(aEntry.UncompressedSize));
+
+            JZ_E_ON_FAIL(_ReadAt(aOffset, compressed.Get(), aEntry.CompressedSize), "failed reading compressed data.");
+            JZ_E_ON_FAIL(_Inflate(compressed.Get(), aEntry.CompressedSize, pReturn->Get(), aEntry.UncompressedSize), "inflation failed.");
+
+            return pReturn;
+        }
+
+        string ZipArchive::_GetName(const ZipFileEntry& aEntry) const
+        {
+            if (aEntry.NameLength == 0u) { return string(); }
+            else { return string(&mNames[aEntry.NameOffset], aEntry.NameLength); }
+        }
+
+        bool ZipArchive::_ReadAt(natural aOffset, void_p apOut, size_t aSize) const
+        {
+            if (mpAsyncFile.Get()) { return (mpAsyncFile->ReadAt((u64)aOffset, apOut, aSize) == aSize); }
+
+#           if JZ_MULTITHREADED
+                Lock lock(const_cast<Mutex&>(mMutex));
+#           endif
+
+            IReadFile* pFile = const_cast<IReadFile*>(mpZipFile.Get());
+
+            return (pFile->Seek(aOffset, false) && pFile->Read(apOut, aSize) == aSize);
+        }
+
+    #   if JZ_LITTLE_ENDIAN
+            // Reads the whole central directory in one go. Returns false if there is none,
+            // or it is a zip64 directory, in which case the local headers are scanned.
+            bool ZipArchive::_ReadCentralDirectory()
+            {
+                const size_t kFileSize = mpZipFile->GetSize();
+                if (kFileSize < sizeof(ZipEndOfCentralDirectory)) { return false; }
+
+                // The end record is last in the file, followed only by a comment of at
+                // most 64KB.
+                const size_t kTailSize = Min(kFileSize, sizeof(ZipEndOfCentralDirectory) + 0xFFFF);
+                ByteBuffer tail(kTailSize);
+                if (!_ReadAt((natural)(kFileSize - kTailSize), tail.Get(), kTailSize)) { return false; }
+
+                ZipEndOfCentralDirectory end;
+                bool bFound = false;
+
+                for (size_t i = (kTailSize - sizeof(ZipEndOfCentralDirectory) + 1u); i > 0u; i--)
+                {
+                    memcpy(&end, tail.Get() + (i - 1u), sizeof(ZipEndOfCentralDirectory));
+                    if (end.Signature == gkEndOfDirectorySignature) { bFound = true; break; }
+                }
+
+                if (!bFound) { return false; }
+                if (end.TotalEntries == 0xFFFF || end.DirectorySize == 0xFFFFFFFF || end.DirectoryOffset == 0xFFFFFFFF) { return false; }
+                if ((size_t)end.DirectoryOffset + (size_t)end.DirectorySize > kFileSize) { return false; }
+                if (end.TotalEntries == 0u) { return true; }
+
+                ByteBuffer directory(end.DirectorySize);
+                if (!_ReadAt((natural)end.DirectoryOffset, directory.Get(), end.DirectorySize)) { return false; }
+
+                mEntries.reserve(end.TotalEntries);
+
+                size_t pos = 0u;
+                for (u32 i = 0u; i < end.TotalEntries; i++)
+                {
+                    ZipCentralDirectoryHeader header;
+
+                    if (pos + sizeof(ZipCentralDirectoryHeader) > end.DirectorySize) { return false; }
+                    memcpy(&header, directory.Get() + pos, sizeof(ZipCentralDirectoryHeader));
+                    pos += sizeof(ZipCentralDirectoryHeader);
+
+                    if (header.Signature != gkCentralHeaderSignature) { return false; }
+                    if (pos + header.FilenameLength > end.DirectorySize) { return false; }
+
+                    ZipFileEntry entry;
+                    entry.LocalHeaderOffset = header.LocalHeaderOffset;
+                    entry.DataOffset        = 0u;
+                    entry.Crc32             = (u32)header.DataDescriptor.Crc32;
+                    entry.CompressedSize    = header.DataDescriptor.CompressedSize;
+                    entry.UncompressedSize  = header.DataDescriptor.UncompressedSize;
+                    entry.CompressionMethod = (u16)header.CompressionMethod;
+
+                    _AddEntry((const char*)(directory.Get() + pos), header.FilenameLength, entry);
+
+                    pos += (header.FilenameLength + header.ExtraFieldLength + header.CommentLength);
+                }
+
+                return true;
+            }
+
+            bool ZipArchive::FindLocalHeaders()
+            {
+                char buffer[Files::kMaximumPathLength];
+
+                ZipLocalFileHeader header;
+	            ZipFileEntry entry;
+
+                entry.LocalHeaderOffset = (u32)mpZipFile->GetPosition();
+
+                // An archive without a central directory ends right after its last entry.
+                if ((size_t)entry.LocalHeaderOffset == mpZipFile->GetSize()) { return false; }
+
+                JZ_E_ON_FAIL(mpZipFile->Read(&header, sizeof(ZipLocalFileHeader)) == sizeof(ZipLocalFileHeader), "failed reading local header.");
                 
+                // todo: verify that this is correct procedure - basically, we stop when we get to 
+                // the end of the zip file, which has different information than the local headers
+                // and will not have a "correct" signature.
+                if (header.Signature != gkLocalHeaderSignature)
+                {
+                    return false;
+                }
+
+                JZ_E_ON_FAIL(header.FilenameLength <= Files::kMaximumPathLength, "filename length too big.");
+                JZ_E_ON_FAIL(mpZipFile->Read(buffer, header.FilenameLength) == header.FilenameLength, "failed reading filename.");
+
+                // skip the extra field
+                if (header.ExtraFieldLength > 0)
+                {
+                    JZ_E_ON_FAIL(mpZipFile->Seek(header.ExtraFieldLength, true), "failed skipping extra field.");
+                }
+
+                // todo: according to the standard, this is after the compressed data?
+                // but how do we know the size in this case? Is the descriptor in the header
+                // still valid?
+                if (header.Flags & gkZipUseDataDescriptor)
+                {
+                    JZ_E_ON_FAIL(mpZipFile->Read(&header.DataDescriptor, sizeof(ZipDataDescriptor)) == sizeof(ZipDataDescriptor), "failed reading data descriptor.");
+	            }
+    	        
+	            entry.DataOffset        = (u32)mpZipFile->GetPosition();
+                entry.Crc32             = (u32)header.DataDescriptor.Crc32;
+                entry.CompressedSize    = header.DataDescriptor.CompressedSize;
+                entry.UncompressedSize  = header.DataDescriptor.UncompressedSize;
+                entry.CompressionMethod = (u16)header.CompressionMethod;
+
+                JZ_E_ON_FAIL(mpZipFile->Seek(header.DataDescriptor.CompressedSize, true), "failed skipping compressed data.");
+
+                _AddEntry(buffer, header.FilenameLength, entry);
+
+	            return true;
+            }
+    #   endif        
+
+        // Stable, so the first of any duplicate names wins as it did with the map.
+        void ZipArchive::_Sort()
+        {
+            if (mEntries.empty()) { return; }
+
+            stable_sort(mEntries.begin(), mEntries.end(), EntryLess((mNames.empty()) ? null : &mNames[0]));
+        }
+
+        
+        FileArchive::FileArchive(const string& aPath)
+            : mPath(aPath)
+        {
+            JZ_E_ON_FAIL(Files::IsDirectory(mPath.c_str()), "path is not valid.");
+        }
+
+        FileArchive::~FileArchive()
+        {
+        }
+
+        bool FileArchive::GetExists(const char* apFilename) const
+        {
+            string fullPath = Files::Combine(mPath, apFilename);
+
+            bool bReturn = (Files::Exists(fullPath.c_str()));
+            bReturn = bReturn && Files::IsFile(fullPath.c_str());
+            
+            return bReturn;
+        }
+
+        IReadFile* FileArchive::Open(const char* apFilename) const
+        {
+            string fullPath = Files::Combine(mPath, apFilename);
+
+            IReadFile* pReturn = new ReadFile(fullPath.c_str());
+
+            return pReturn;
+        }
+
+        AsyncIO::RequestHandle FileArchive::ReadAsync(const char* apFilename, ByteBuffer& arOut, AsyncIO::Priority aPriority, const AsyncIO::Callback& aCallback) const
+        {
+            AsyncFilePtr pFile(new AsyncFile(Files::Combine(mPath, apFilename)));
+
+            return _ReadAsync(pFile, arOut, aPriority, aCallback);
+        }
+
+        // Appends the files under aRoot/aRelative, as paths relative to aRoot.
+        static void _ListTree(const string& aRoot, const string& aRelative, vector<string>& arOut)
+        {
+            const string kDirectory(Files::Combine(aRoot, aRelative));
+
+#           if JZ_PLATFORM_WINDOWS
+                struct _finddata_t info;
+                const intptr_t h = _findfirst(Files::Combine(kDirectory, "*").c_str(), &info);
+                if (h == -1) { return; }
+
+                for (int res = 0; res != -1; res = _findnext(h, &info))
+                {
+                    const string kName(info.name);
+                    const bool kbDirectory = ((info.attrib & _A_SUBDIR) != 0);
+#           else
+                DIR* pDirectory = opendir(kDirectory.c_str());
+                if (!pDirectory) { return; }
+
+                for (struct dirent* pEntry = readdir(pDirectory); pEntry; pEntry = readdir(pDirectory))
+                {
+                    const string kName(pEntry->d_name);
+                    const bool kbDirectory = Files::IsDirectory(Files::Combine(kDirectory, kName).c_str());
+#           endif
+                    if (kName == "." || kName == "..") { continue; }
+
+                    const string kRelative(Files::Combine(aRelative, kName));
+
+                    if (kbDirectory) { _ListTree(aRoot, kRelative, arOut); }
+                    else { arOut.push_back(Files::CleanFilename(kRelative)); }
+                }
+
+#           if JZ_PLATFORM_WINDOWS
+                _findclose(h);
+#           else
+                closedir(pDirectory);
+#           endif
+        }
+
+        bool FileArchive::GetFiles(vector<string>& arOut) const
+        {
+            _ListTree(mPath, string(), arOut);
+
+            return true;
+        }
+
+        // Immutable once published, except for the missing table. Slots is an open
+        // addressed table of hash64 of the cleaned path, resolving to the first archive in
+        // Mounted that lists the path.
+        //
+        // MissingNames remembers cleaned paths that are not loose files on disk, so their
+        // lookups skip straight to the archives. Readers claim its slots with a compare
+        // and swap; names are only freed with the index.
+        struct Files::Index
+        {
+            static const u32 kNone = 0xFFFFFFFF;
+            static const size_t kMissingCapacity = (1 << 10);
+            static const size_t kMissingProbes = 8u;
+
+            struct Slot
             {
-#               if JZ_MULTITHREADED
-                    Lock lock(const_cast<Mutex&>(mMutex));
-#               endif
+                u64 Hash;
+                u32 NameOffset;
+                u32 NameLength;
+                u32 Archive;
+            };
+
+            Archives Mounted;
+            vector<u32> Unindexed;
+            vector<Slot> Slots;
+            vector<char> Names;
+
+            Index(const Archives& aArchives)
+                : Mounted(aArchives)
+            {
+                vector< vector<string> > files(Mounted.size());
+                size_t count = 0u;
+
+                for (size_t i = 0u; i < Mounted.size(); i++)
+                {
+                    if (Mounted[i]->GetFiles(files[i])) { count += files[i].size(); }
+                    else { Unindexed.push_back((u32)i); }
+                }
+
+                size_t capacity = 16u;
+                while (capacity < (count * 2u)) { capacity *= 2u; }
+
+                Slot empty;
+                memset(&empty, 0, sizeof(Slot));
+                empty.Archive = kNone;
+                Slots.resize(capacity, empty);
+
+                for (size_t i = 0u; i < files.size(); i++)
+                {
+                    for (size_t j = 0u; j < files[i].size(); j++) { _Add((u32)i, files[i][j]); }
+                }
+            }
+
+            ~Index()
+            {
+                for (size_t i = 0u; i < kMissingCapacity; i++) { delete[] MissingNames[i].Get(); }
+            }
+
+            // The archive position of aCleanedFilename, or kNone.
+            u32 Find(const string& aCleanedFilename) const
+            {
+                const u64 kHash = _GetHash(aCleanedFilename);
+                const size_t kMask = (Slots.size() - 1u);
+
+                for (size_t i = (size_t)kHash & kMask; Slots[i].Archive != kNone; i = ((i + 1u) & kMask))
+                {
+                    if (_Equals(Slots[i], kHash, aCleanedFilename)) { return Slots[i].Archive; }
+                }
+
+                return kNone;
+            }
+
+            bool IsMissing(const string& aCleanedFilename) const
+            {
+                const size_t kStart = (size_t)_GetHash(aCleanedFilename);
+
+                for (size_t i = 0u; i < kMissingProbes; i++)
+                {
+                    const size_t kSlot = ((kStart + i) & (kMissingCapacity - 1u));
+                    const char* p = MissingNames[kSlot].Get();
+
+                    if (!p) { return false; }
+                    if (strcmp(p, aCleanedFilename.c_str()) == 0) { return (Missing[kSlot].Get() != 0); }
+                }
 
-                for (Archives::const_iterator I = mArchives.begin(); I != mArchives.end(); I++)
+                return false;
+            }
+
+            // A name that finds no free slot in its probe range is simply not remembered.
+            void SetMissing(const string& aCleanedFilename, bool abMissing) const
+            {
+                const size_t kStart = (size_t)_GetHash(aCleanedFilename);
+                char* pCopy = null;
+
+                for (size_t i = 0u; i < kMissingProbes; i++)
                 {
-                    if ((*I)->GetExists(cleanedFilename.c_str()))
+                    const size_t kSlot = ((kStart + i) & (kMissingCapacity - 1u));
+                    char* p = MissingNames[kSlot].Get();
+
+                    if (!p)
+                    {
+                        if (!abMissing) { break; }
+
+                        if (!pCopy)
+                        {
+                            pCopy = new char[aCleanedFilename.length() + 1u];
+                            memcpy(pCopy, aCleanedFilename.c_str(), aCleanedFilename.length() + 1u);
+                        }
+
+                        p = MissingNames[kSlot].CompareExchange(pCopy, null);
+                        if (!p)
+                        {
+                            p = pCopy;
+                            pCopy = null;
+                        }
+                    }
+
+                    if (strcmp(p, aCleanedFilename.c_str()) == 0)
                     {
-                        return (*I)->Open(cleanedFilename.c_str());
+                        Missing[kSlot].Set((abMissing) ? 1 : 0);
+                        break;
                     }
                 }
+
+                delete[] pCopy;
+            }
+
+        private:
+            mutable AtomicPointer<char> MissingNames[kMissingCapacity];
+            mutable AtomicInt Missing[kMissingCapacity];
+
+            static u64 _GetHash(const string& aCleanedFilename)
+            {
+                return hash64((u8c_p)aCleanedFilename.c_str(), (u32)aCleanedFilename.length(), 0u);
+            }
+
+            bool _Equals(const Slot& aSlot, u64 aHash, const string& aCleanedFilename) const
+            {
+                return (aSlot.Hash == aHash && aSlot.NameLength == aCleanedFilename.length() &&
+                    (aSlot.NameLength == 0u || memcmp(&Names[aSlot.NameOffset], aCleanedFilename.c_str(), aSlot.NameLength) == 0));
+            }
+
+            // Earlier archives are added first, so an existing slot always wins.
+            void _Add(u32 aArchive, const string& aCleanedFilename)
+            {
+                const u64 kHash = _GetHash(aCleanedFilename);
+                const size_t kMask = (Slots.size() - 1u);
+
+                size_t i = (size_t)kHash & kMask;
+                for (; Slots[i].Archive != kNone; i = ((i + 1u) & kMask))
+                {
+                    if (_Equals(Slots[i], kHash, aCleanedFilename)) { return; }
+                }
+
+                Slots[i].Hash = kHash;
+                Slots[i].NameOffset = (u32)Names.size();
+                Slots[i].NameLength = (u32)aCleanedFilename.length();
+                Slots[i].Archive = aArchive;
+
+                Names.insert(Names.end(), aCleanedFilename.begin(), aCleanedFilename.end());
+            }
+        };
+
+        class Files::ReadScope sealed
+        {
+        public:
+            // A writer that flips the generation between the read of mGeneration and the
+            // increment does not wait on this slot, and the next writer would free the
+            // index while it is in use. The count only protects the index if the
+            // generation is unchanged once the index has been loaded, otherwise retry.
+            // Increment() is a full barrier, so the loads after it are not hoisted.
+            ReadScope(const Files& aFiles)
+                : mrFiles(aFiles), mSlot(0), mpIndex(null)
+            {
+                while (true)
+                {
+                    const s32 kGeneration = mrFiles.mGeneration.Get();
+                    mSlot = (kGeneration & 1);
+
+                    mrFiles.mReaders[mSlot].Increment();
+                    mpIndex = mrFiles.mpIndex.Get();
+
+                    if (mrFiles.mGeneration.Get() == kGeneration) { break; }
+
+                    mrFiles.mReaders[mSlot].Decrement();
+                }
             }
 
-            string msg = __FUNCTION__ ": load failed, \"" + string(apFilename) + "\".";
-            throw std::exception(msg.c_str());
+            ~ReadScope()
+            {
+                mrFiles.mReaders[mSlot].Decrement();
+            }
+
+            const Index& Get() const { return *mpIndex; }
+
+        private:
+            ReadScope(const ReadScope&);
+            ReadScope& operator=(const ReadScope&);
+
+            const Files& mrFiles;
+            s32 mSlot;
+            const Index* mpIndex;
+        };
+
+        Files::Files()
+            : mpIndex(new Index(Archives())), mGeneration(0)
+        {}
+            
+        Files::~Files()
+        {
+            delete mpIndex;
+        }
+
+        string Files::CleanFilename(const string& aFilename)
+        {
+            size_t size = aFilename.length();
+
+            string ret;
+            ret.resize(size);
+
+            for (size_t i = 0u; i < size; i++)
+            {
+#               if JZ_PLATFORM_WINDOWS
+                    if (aFilename[i] == '/') { ret[i] = '\\'; }
+                    else
+                    {
+                        ret[i] = tolower(aFilename[i]);
+                    }
+#               else
+                    // Case is kept, file systems here are case sensitive.
+                    if (aFilename[i] == '\\') { ret[i] = '/'; }
+                    else
+                    {
+                        ret[i] = aFilename[i];
+                    }
+#               endif
+            }
+
+            return ret;
+        }
+           
+        void Files::AddArchive(const AutoPtr<IArchive>& apArchive)
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            Archives archives(mpIndex->Mounted);
+            archives.push_back(apArchive);
+
+            _SetIndex(new Index(archives));
+        }
+
+        void Files::Refresh()
+        {
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+
+            _SetIndex(new Index(mpIndex->Mounted));
+        }
+
+        bool Files::GetExists(const char* apFilename) const
+        {
+            const string kCleanedFilename(CleanFilename(apFilename));
+
+            ReadScope scope(*this);
+
+            if (!_FindOnDisk(scope.Get(), apFilename, kCleanedFilename).empty()) { return true; }
+
+            return (_Find(scope.Get(), kCleanedFilename) != null);
+        }
+
+        IReadFile* Files::Open(const char* apFilename) const
+        {
+            const string kCleanedFilename(CleanFilename(apFilename));
+
+            {
+                ReadScope scope(*this);
+
+                const string kOnDisk(_FindOnDisk(scope.Get(), apFilename, kCleanedFilename));
+                if (!kOnDisk.empty()) { return new ReadFile(kOnDisk); }
+
+                const IArchive* pArchive = _Find(scope.Get(), kCleanedFilename);
+                if (pArchive) { return pArchive->Open(kCleanedFilename.c_str()); }
+            }
+
+            throw std::runtime_error(string(__FUNCTION__) + ": load failed, \"" + string(apFilename) + "\".");
+        }
+
+        AsyncIO::RequestHandle Files::ReadAsync(const char* apFilename, ByteBuffer& arOut, AsyncIO::Priority aPriority, const AsyncIO::Callback& aCallback) const
+        {
+            const string kCleanedFilename(CleanFilename(apFilename));
+
+            {
+                ReadScope scope(*this);
+
+                const string kOnDisk(_FindOnDisk(scope.Get(), apFilename, kCleanedFilename));
+                if (!kOnDisk.empty()) { return _ReadAsync(AsyncFilePtr(new AsyncFile(kOnDisk)), arOut, aPriority, aCallback); }
+
+                const IArchive* pArchive = _Find(scope.Get(), kCleanedFilename);
+                if (pArchive) { return pArchive->ReadAsync(kCleanedFilename.c_str(), arOut, aPriority, aCallback); }
+            }
+
+            throw std::runtime_error(string(__FUNCTION__) + ": load failed, \"" + string(apFilename) + "\".");
+        }
+
+        // The name apFilename has on disk, as given or cleaned, or empty if it is on disk
+        // under neither. Then the index remembers it, until it is rebuilt.
+        string Files::_FindOnDisk(const Index& aIndex, const char* apFilename, const string& aCleanedFilename) const
+        {
+            if (aIndex.IsMissing(aCleanedFilename)) { return string(); }
+
+            if (Files::Exists(apFilename)) { return string(apFilename); }
+            if (Files::Exists(aCleanedFilename.c_str())) { return aCleanedFilename; }
+
+            aIndex.SetMissing(aCleanedFilename, true);
+
+            return string();
+        }
+
+        // Unindexed archives ahead of the indexed winner still get to claim the file.
+        const IArchive* Files::_Find(const Index& aIndex, const string& aCleanedFilename) const
+        {
+            const u32 kIndexed = aIndex.Find(aCleanedFilename);
+
+            for (size_t i = 0u; i < aIndex.Unindexed.size() && aIndex.Unindexed[i] < kIndexed; i++)
+            {
+                const IArchive* p = aIndex.Mounted[aIndex.Unindexed[i]].Get();
+                if (p->GetExists(aCleanedFilename.c_str())) { return p; }
+            }
+
+            if (kIndexed != Index::kNone) { return aIndex.Mounted[kIndexed].Get(); }
+            else { return null; }
+        }
+
+        // Called with mMutex held, so writers never overlap. The index is swapped before
+        // the generation flips, so a reader that validated the old generation holds
+        // either index and is counted in the slot drained here.
+        void Files::_SetIndex(Index* apIndex)
+        {
+            Index* pOld = mpIndex.Exchange(apIndex);
+            const s32 kSlot = (mGeneration.ExchangeAdd(1) & 1);
+
+            while (mReaders[kSlot].Get() != 0)
+            {
+#               if JZ_MULTITHREADED
+                    Thread::Sleep(0u);
+#               endif
+            }
+
+            delete pOld;
         }
 
         IWriteFile* Files::OpenWriteable(const char* apFilename) const
         {
-            return new WriteFile(apFilename);
+            IWriteFile* pReturn = new WriteFile(apFilename);
+
+            // The file is on disk now, even if a lookup found it missing before.
+            {
+                ReadScope scope(*this);
+                scope.Get().SetMissing(CleanFilename(apFilename), false);
+            }
+
+            return pReturn;
         }
 
         string Files::Combine(const string& aPathLeft, const string& aPathRight)
@@ -875,10 +1854,18 @@ namespace jz
 
         string Files::GetCurrentProcessFilename()
         {
-            TCHAR fullPath[kMaximumPathLength + 1u];
-            GetModuleFileName(null, fullPath, kMaximumPathLength + 1u);
+#           if JZ_PLATFORM_WINDOWS
+                TCHAR fullPath[kMaximumPathLength + 1u];
+                GetModuleFileName(null, fullPath, kMaximumPathLength + 1u);
 
-            return string(fullPath);
+                return string(fullPath);
+#           else
+                char fullPath[kMaximumPathLength + 1u];
+                const ssize_t kLength = readlink("/proc/self/exe", fullPath, kMaximumPathLength);
+                fullPath[(kLength < 0) ? 0 : kLength] = 0;
+
+                return string(fullPath);
+#           endif
         }
 
     #if JZ_PLATFORM_WINDOWS
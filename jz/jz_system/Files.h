@@ -24,8 +24,12 @@
 #ifndef _JZ_SYSTEM_FILES_H_
 #define _JZ_SYSTEM_FILES_H_
 
+#include <jz_core/Atomic.h>
 #include <jz_core/Auto.h>
+#include <jz_core/Memory.h>
 #include <jz_core/Utility.h>
+#include <jz_system/AssetCache.h>
+#include <jz_system/AsyncIO.h>
 #include <jz_system/Mutex.h>
 #include <list>
 #include <map>
@@ -104,6 +108,7 @@ namespace jz
         public:
             MemoryReadFile(const char* apFilename, void_p apData, size_t aSize, bool abOwnMemory = false);
             MemoryReadFile(const string& aFilename, void_p apData, size_t aSize, bool abOwnMemory = false);
+            MemoryReadFile(const string& aFilename, const SharedBufferPtr& apBuffer);
             virtual ~MemoryReadFile();
 
             virtual const char* GetFilename() const
@@ -133,6 +138,7 @@ namespace jz
             
             bool    mbOwnMemory;
             string  mFilename;
+            SharedBufferPtr mpBuffer;
             void_p   mpData;
             natural mPosition;
             size_t  mSize;
@@ -268,6 +274,167 @@ namespace jz
 #           endif
         };
 
+        // Serves small reads out of a block read from another file so that a run of
+        // scalar Read* helpers costs one virtual Read on the wrapped file per block.
+        // Reads at least as large as the buffer go straight to the wrapped file.
+        class BufferedReadFile : public IReadFile
+        {
+        public:
+            static const size_t kDefaultBufferSize = (1 << 16);
+
+            BufferedReadFile(const AutoPtr<IReadFile>& apFile, size_t aBufferSize = kDefaultBufferSize);
+            virtual ~BufferedReadFile();
+
+            virtual const char* GetFilename() const
+            {
+                return mpFile->GetFilename();
+            }
+
+            virtual natural GetPosition() const
+            {
+                return mPosition;
+            }
+
+            virtual size_t GetSize() const
+            {
+                return mSize;
+            }
+
+            virtual JZ_EXPORT size_t Read(void_p apOutBuffer, size_t aSize);
+            virtual JZ_EXPORT bool Seek(natural aPosition, bool abRelative = false);
+
+        private:
+            friend void jz::__IncrementRefCount<system::BufferedReadFile>(system::BufferedReadFile* p);
+            friend void jz::__DecrementRefCount<system::BufferedReadFile>(system::BufferedReadFile* p);
+
+            BufferedReadFile(const BufferedReadFile&);
+            BufferedReadFile& operator=(const BufferedReadFile&);
+
+            AutoPtr<IReadFile> mpFile;
+            ByteBuffer mBuffer;
+            natural mBufferStart;
+            size_t mBufferUsed;
+            natural mPosition;
+            size_t mSize;
+
+#           if JZ_MULTITHREADED
+                Mutex mMutex;
+#           endif
+
+            bool _Fill();
+        };
+
+        // Collects small writes and passes them to another file in blocks. Pending
+        // bytes are written on Flush(), Seek() and destruction.
+        class BufferedWriteFile : public IWriteFile
+        {
+        public:
+            static const size_t kDefaultBufferSize = (1 << 16);
+
+            BufferedWriteFile(const AutoPtr<IWriteFile>& apFile, size_t aBufferSize = kDefaultBufferSize);
+            virtual ~BufferedWriteFile();
+
+            virtual const char* GetFilename() const
+            {
+                return mpFile->GetFilename();
+            }
+
+            JZ_EXPORT virtual natural GetPosition() const;
+            JZ_EXPORT virtual size_t GetSize() const;
+
+            JZ_EXPORT bool Flush();
+            JZ_EXPORT virtual bool Seek(natural aPosition, bool abRelative = false);
+            JZ_EXPORT virtual size_t Write(voidc_p apOutBuffer, size_t aSize);
+
+        private:
+            friend void jz::__IncrementRefCount<system::BufferedWriteFile>(system::BufferedWriteFile* p);
+            friend void jz::__DecrementRefCount<system::BufferedWriteFile>(system::BufferedWriteFile* p);
+
+            BufferedWriteFile(const BufferedWriteFile&);
+            BufferedWriteFile& operator=(const BufferedWriteFile&);
+
+            AutoPtr<IWriteFile> mpFile;
+            ByteBuffer mBuffer;
+            size_t mBufferUsed;
+
+#           if JZ_MULTITHREADED
+                Mutex mMutex;
+#           endif
+
+            bool _Flush();
+        };
+
+        // Streams a raw deflate stream stored in [aStart, aStart + aCompressedSize) of
+        // another file, inflating in small chunks as it is read. Restart points are
+        // recorded every kRestartInterval bytes of output so a backwards seek resumes
+        // from the nearest one instead of inflating from the start.
+        class InflateReadFile : public IReadFile
+        {
+        public:
+            static const size_t kInputSize       = (1 << 14);
+            static const size_t kRestartInterval = (1 << 20);
+            static const size_t kWindowSize      = (1 << 15);
+
+            InflateReadFile(const string& aFilename, const AutoPtr<IReadFile>& apFile, const AsyncFilePtr& apAsyncFile, natural aStart, size_t aCompressedSize, size_t aSize);
+            virtual ~InflateReadFile();
+
+            virtual const char* GetFilename() const
+            {
+                return mFilename.c_str();
+            }
+
+            virtual natural GetPosition() const
+            {
+                return mPosition;
+            }
+            
+            virtual size_t GetSize() const
+            {
+                return mSize;
+            }
+
+            virtual JZ_EXPORT size_t Read(void_p apOutBuffer, size_t aSize);
+            virtual JZ_EXPORT bool Seek(natural aPosition, bool abRelative = false);
+
+        private:
+            friend void jz::__IncrementRefCount<system::InflateReadFile>(system::InflateReadFile* p);
+            friend void jz::__DecrementRefCount<system::InflateReadFile>(system::InflateReadFile* p);
+
+            InflateReadFile(const InflateReadFile&);
+            InflateReadFile& operator=(const InflateReadFile&);
+
+            struct RestartPoint
+            {
+                size_t Out;
+                size_t In;
+                int Bits;
+                ByteBuffer Window;
+            };
+
+            string mFilename;
+            AutoPtr<IReadFile> mpFile;
+            AsyncFilePtr mpAsyncFile;
+            natural mStart;
+            size_t mCompressedSize;
+            size_t mSize;
+            natural mPosition;
+
+            void_p mpStream;
+            ByteBuffer mInput;
+            size_t mIn;
+            size_t mOut;
+            ByteBuffer mWindow;
+            vector<RestartPoint> mRestartPoints;
+
+#           if JZ_MULTITHREADED
+                Mutex mMutex;
+#           endif
+
+            size_t _Inflate(u8* apOut, size_t aSize);
+            bool _ReadInput(size_t aOffset, u8* apOut, size_t aSize);
+            void _Restart(natural aPosition);
+        };
+
         class IArchive 
         {
         public:
@@ -281,6 +448,23 @@ namespace jz
             virtual bool GetExists(const char* apFilename) const = 0;
             virtual IReadFile* Open(const char* apFilename) const = 0;
 
+            // Starts reading all of apFilename into arOut through AsyncIO. arOut is sized on
+            // the calling thread and must not be touched until the request is done. Returns
+            // AsyncIO::kInvalidRequest if the archive cannot read asynchronously, Open()
+            // the file instead.
+            virtual AsyncIO::RequestHandle ReadAsync(const char* apFilename, ByteBuffer& arOut, AsyncIO::Priority aPriority = AsyncIO::kMed, const AsyncIO::Callback& aCallback = AsyncIO::Callback()) const
+            {
+                return AsyncIO::kInvalidRequest;
+            }
+
+            // Appends every file in the archive, in Files::CleanFilename() form, so Files
+            // can index it. Archives that cannot list their contents return false and
+            // are asked through GetExists() instead.
+            virtual bool GetFiles(vector<string>& arOut) const
+            {
+                return false;
+            }
+
         protected:
             size_t mReferenceCount;
 
@@ -322,6 +506,37 @@ namespace jz
             u16               ExtraFieldLength;
         } STRUCT_PACK;
 
+        struct ZipCentralDirectoryHeader
+        {
+            s32               Signature;
+            s16               VersionMadeBy;
+            s16               VersionNeededToExtract;
+            s16               Flags;
+            s16               CompressionMethod;
+            s16               LastModFileTime;
+            s16               LastModFileDate;
+            ZipDataDescriptor DataDescriptor;
+            u16               FilenameLength;
+            u16               ExtraFieldLength;
+            u16               CommentLength;
+            u16               DiskNumberStart;
+            u16               InternalAttributes;
+            u32               ExternalAttributes;
+            u32               LocalHeaderOffset;
+        } STRUCT_PACK;
+
+        struct ZipEndOfCentralDirectory
+        {
+            s32               Signature;
+            u16               DiskNumber;
+            u16               DirectoryDiskNumber;
+            u16               DiskEntries;
+            u16               TotalEntries;
+            u32               DirectorySize;
+            u32               DirectoryOffset;
+            u16               CommentLength;
+        } STRUCT_PACK;
+
     #   ifdef _MSC_VER
     #       pragma pack(pop,packing)
     #   endif
@@ -336,6 +551,12 @@ namespace jz
 
             virtual bool GetExists(const char* apFilename) const;
             virtual IReadFile* Open(const char* apFilename) const;
+            virtual bool GetFiles(vector<string>& arOut) const;
+
+            // Stored entries are read straight into arOut, deflated entries are read into
+            // a temporary buffer and inflated on an AsyncIO worker. Only archives that are
+            // files on disk, not nested in another archive, can read asynchronously.
+            JZ_EXPORT virtual AsyncIO::RequestHandle ReadAsync(const char* apFilename, ByteBuffer& arOut, AsyncIO::Priority aPriority = AsyncIO::kMed, const AsyncIO::Callback& aCallback = AsyncIO::Callback()) const;
 
         private:
             friend void jz::__IncrementRefCount<system::ZipArchive>(system::ZipArchive* p);
@@ -344,27 +565,43 @@ namespace jz
             ZipArchive(const ZipArchive&);
             ZipArchive& operator=(const ZipArchive&);
             
+            // Entries are kept in a flat array sorted by name, names are packed into
+            // mNames. The data offset is only known for entries found by scanning local
+            // headers, entries from the central directory read their local header on open.
             struct ZipFileEntry
             {
-                ZipFileEntry()
-                    : Offset(0)
-                {}
-                
-                string FullFilename;
-                string ShortFilename;
-                ZipLocalFileHeader Header;
-                natural Offset;
-                string Path;
+                u32 NameOffset;
+                u32 NameLength;
+                u32 LocalHeaderOffset;
+                u32 DataOffset;
+                u32 Crc32;
+                u32 CompressedSize;
+                u32 UncompressedSize;
+                u16 CompressionMethod;
             };
 
-            typedef map<string, ZipFileEntry> CompressedFiles;
+            struct EntryLess;
+            typedef vector<ZipFileEntry> Entries;
 
-            CompressedFiles mFiles;
+            Entries mEntries;
+            vector<char> mNames;
             AutoPtr<IReadFile> mpZipFile;
+            AsyncFilePtr mpAsyncFile;
+
+#           if JZ_MULTITHREADED
+                Mutex mMutex;
+#           endif
 
+            void _AddEntry(const char* apFilename, size_t aLength, ZipFileEntry& arEntry);
+            const ZipFileEntry* _Find(const string& aFilename) const;
+            natural _GetDataOffset(const ZipFileEntry& aEntry) const;
+            SharedBufferPtr _InflateEntry(const ZipFileEntry& aEntry, natural aOffset) const;
+            string _GetName(const ZipFileEntry& aEntry) const;
             IReadFile* _Open(const string& aFilename) const;
+            bool _ReadAt(natural aOffset, void_p apOut, size_t aSize) const;
+            bool _ReadCentralDirectory();
+            void _Sort();
             bool FindLocalHeaders();
-            void ProcessFilename(const char* apFilename, ZipFileEntry& arOut);
         };
 
         class FileArchive : public IArchive
@@ -377,6 +614,10 @@ namespace jz
 
             JZ_EXPORT virtual bool GetExists(const char* apFilename) const override;
             JZ_EXPORT virtual IReadFile* Open(const char* apFilename) const override;
+            JZ_EXPORT virtual AsyncIO::RequestHandle ReadAsync(const char* apFilename, ByteBuffer& arOut, AsyncIO::Priority aPriority = AsyncIO::kMed, const AsyncIO::Callback& aCallback = AsyncIO::Callback()) const override;
+
+            // Lists the directory tree as it is now, see Files::Refresh().
+            JZ_EXPORT virtual bool GetFiles(vector<string>& arOut) const override;
 
         private:
             const string mPath;
@@ -394,11 +635,28 @@ namespace jz
             Files();
             ~Files();
 
+            // Loose files on disk come first, then archives in the order they were
+            // added, the first one with a file wins. Adding an archive rebuilds the path
+            // index, Open(), GetExists() and ReadAsync() do not lock and resolve a path
+            // with one hash lookup, plus a GetExists() probe of any archive that cannot
+            // list its files. A path that is not a loose file is remembered as such by
+            // the index, so later lookups of it do not touch the disk.
             JZ_EXPORT void AddArchive(const AutoPtr<IArchive>& apArchive);
+
+            // Rebuilds the path index, to pick up files added to or removed from a
+            // FileArchive directory since it was added, and loose files created other
+            // than through OpenWriteable() since they were last looked up.
+            JZ_EXPORT void Refresh();
+
             JZ_EXPORT bool GetExists(const char* apFilename) const;
             JZ_EXPORT IReadFile* Open(const char* apFilename) const;
             JZ_EXPORT IWriteFile* OpenWriteable(const char* apFilename) const;
 
+            // Asynchronous counterpart of Open(), resolved the same way. Returns
+            // AsyncIO::kInvalidRequest if the file is in an archive that cannot read
+            // asynchronously. Requires an AsyncIO instance.
+            JZ_EXPORT AsyncIO::RequestHandle ReadAsync(const char* apFilename, ByteBuffer& arOut, AsyncIO::Priority aPriority = AsyncIO::kMed, const AsyncIO::Callback& aCallback = AsyncIO::Callback()) const;
+
             static const natural kMaximumPathLength = 1024;
 		    typedef vector<string> DirectoryList;
             
@@ -407,6 +665,9 @@ namespace jz
                 return (c == '/') || (c == '\\');
             }
 
+            // Converts separators to the platform's. On Windows the name is also lowercased.
+            // Elsewhere case is kept, because the file system is case sensitive there. So
+            // zip entries and the path index match names case sensitively on POSIX.
             JZ_EXPORT static string CleanFilename(const string& aFilename);
             JZ_EXPORT static string Combine(const string& aPathLeft, const string& aPathRight);
             JZ_EXPORT static bool Exists(const char* apFilename);
@@ -425,13 +686,25 @@ namespace jz
             JZ_EXPORT static void SetWorkingDirectory(const string& aPath);
             
         private:
-            typedef list<AutoPtr<IArchive>> Archives;
-            
-            Archives mArchives;
+            typedef vector<AutoPtr<IArchive> > Archives;
+
+            struct Index;
+            class ReadScope;
+
+            // Readers count themselves in mReaders[mGeneration & 1] while they use
+            // mpIndex. A writer swaps in a new index, flips the generation so new readers
+            // count in the other slot, and frees the old index once its slot drains.
+            AtomicPointer<Index> mpIndex;
+            AtomicInt mGeneration;
+            mutable AtomicInt mReaders[2];
 
 #           if JZ_MULTITHREADED
                 Mutex mMutex;
 #           endif
+
+            const IArchive* _Find(const Index& aIndex, const string& aCleanedFilename) const;
+            string _FindOnDisk(const Index& aIndex, const char* apFilename, const string& aCleanedFilename) const;
+            void _SetIndex(Index* apIndex);
         };
  
     }
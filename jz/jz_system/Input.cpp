@@ -28,7 +28,7 @@
 
 namespace jz
 {
-    system::Input* system::Input::mspSingleton = 0;
+    template <> system::Input* Singleton<system::Input>::mspSingleton = 0;
     namespace system
     {
 
@@ -114,6 +114,35 @@ namespace jz
                     mMousePrevY = y;
                 }
             }
+    #   else
+            // No windowing system on this platform. Input only records the
+            // state that was set on it.
+            void Input::SetMouseVisible(bool b)
+            {
+                mbMouseVisible = b;
+            }
+
+            natural Input::GetMouseX() const
+            {
+                return mMousePrevX;
+            }
+
+            natural Input::GetMouseY() const
+            {
+                return mMousePrevY;
+            }
+
+            void Input::SetMousePosition(natural x, natural y)
+            {
+                mMousePrevX = x;
+                mMousePrevY = y;
+            }
+
+            void Input::UpdateMousePosition(natural x, natural y)
+            {
+                mMousePrevX = x;
+                mMousePrevY = y;
+            }
     #   endif
 
     }   
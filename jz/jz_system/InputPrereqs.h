@@ -31,7 +31,6 @@ namespace jz
     namespace system
     {
 
-    #   if JZ_PLATFORM_WINDOWS
         namespace Key
         {
             enum Code
@@ -209,7 +208,6 @@ namespace jz
                 kStateCount = 2
             };
         }
-    #   endif
 
     }
 }
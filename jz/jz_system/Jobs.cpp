@@ -0,0 +1,471 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_system/Jobs.h>
+#include <jz_system/Time.h>
+
+namespace jz
+{
+    template <> system::Jobs* Singleton<system::Jobs>::mspSingleton = null;
+    namespace system
+    {
+
+        struct Job
+        {
+            JobDelegate Function;
+            JobCounter* pCounter;
+            Job* pNext;
+            volatile s32 bBusy;
+            bool bHeap;
+        };
+
+        JZ_STATIC_ASSERT((Jobs::kDequeSize & (Jobs::kDequeSize - 1)) == 0);
+        JZ_STATIC_ASSERT((Jobs::kJobPoolSize & (Jobs::kJobPoolSize - 1)) == 0);
+
+        // Index into Jobs::mWorkers of the current thread, 0 is the main thread and -1 is
+        // a thread not owned by Jobs.
+        static JZ_THREAD_LOCAL s32 tlsWorkerIndex = -1;
+
+#pragma region Deque
+        Jobs::Deque::Deque()
+            : Top(0), Bottom(0)
+        {
+            for (s32 i = 0; i < kDequeSize; i++) { Slots[i] = null; }
+        }
+
+        bool Jobs::Deque::Push(Job* p)
+        {
+            s32 b = Bottom;
+            s32 t = AtomicLoadAcquire(&Top);
+
+            if ((b - t) >= kDequeSize) { return false; }
+
+            AtomicStoreReleasePointer(&(Slots[b & (kDequeSize - 1)]), p);
+            AtomicStoreRelease(&Bottom, b + 1);
+
+            return true;
+        }
+
+        Job* Jobs::Deque::Pop()
+        {
+            s32 b = Bottom - 1;
+            AtomicExchange(&Bottom, b);
+            s32 t = AtomicLoadAcquire(&Top);
+
+            if (t <= b)
+            {
+                Job* p = (Job*)AtomicLoadAcquirePointer(&(Slots[b & (kDequeSize - 1)]));
+                if (t != b) { return p; }
+
+                // Last job, race against stealers for it.
+                if (AtomicCompareExchange(&Top, t + 1, t) != t) { p = null; }
+                AtomicStoreRelease(&Bottom, t + 1);
+
+                return p;
+            }
+            else
+            {
+                AtomicStoreRelease(&Bottom, t);
+                return null;
+            }
+        }
+
+        Job* Jobs::Deque::Steal()
+        {
+            s32 t = AtomicLoadAcquire(&Top);
+            AtomicFence();
+            s32 b = AtomicLoadAcquire(&Bottom);
+
+            if (t < b)
+            {
+                Job* p = (Job*)AtomicLoadAcquirePointer(&(Slots[t & (kDequeSize - 1)]));
+                if (AtomicCompareExchange(&Top, t + 1, t) != t) { return null; }
+
+                return p;
+            }
+
+            return null;
+        }
+#pragma endregion
+
+        Jobs::Worker::Worker()
+            : pPool(new Job[kJobPoolSize]), PoolNext(0), Random(0u)
+        {
+            for (s32 i = 0; i < kJobPoolSize; i++)
+            {
+                pPool[i].pCounter = null;
+                pPool[i].pNext = null;
+                pPool[i].bBusy = 0;
+                pPool[i].bHeap = false;
+            }
+        }
+
+        Jobs::Worker::~Worker()
+        {
+            delete[] pPool;
+        }
+
+        Jobs::Jobs(uint aWorkerCount)
+            : mWorkerCount(0u), mbDone(0)
+#           if JZ_MULTITHREADED
+                , mSleeping(0)
+#           endif
+        {
+#           if JZ_MULTITHREADED
+                mWorkerCount = (aWorkerCount == 0u) ? (Thread::GetHardwareConcurrency() - 1u) : aWorkerCount;
+#           endif
+
+            for (uint i = 0u; i <= mWorkerCount; i++)
+            {
+                mWorkers.push_back(new Worker());
+                mWorkers[i]->Random = (i + 1u) * 2654435761u;
+            }
+
+            tlsWorkerIndex = 0;
+
+#           if JZ_MULTITHREADED
+                for (uint i = 1u; i <= mWorkerCount; i++)
+                {
+                    mThreads.push_back(new Thread(tr1::bind(&Jobs::_WorkerMain, this, i, tr1::placeholders::_1)));
+                }
+#           endif
+        }
+
+        Jobs::~Jobs()
+        {
+            JZ_ASSERT(tlsWorkerIndex == 0);
+
+            AtomicExchange(&mbDone, 1);
+
+#           if JZ_MULTITHREADED
+                mWake.Signal((uint)mThreads.size());
+                for (size_t i = 0u; i < mThreads.size(); i++)
+                {
+                    delete mThreads[i];
+                }
+                mThreads.clear();
+#           endif
+
+            // Anything left, including continuations it releases, runs here on the main
+            // thread, so no counter is left incomplete and no heap job leaks.
+            while (true)
+            {
+                if (_RunMainThreadJob()) { continue; }
+
+                Job* p = _GetJob();
+                if (!p) { break; }
+                _Execute(p);
+            }
+
+            for (size_t i = 0u; i < mWorkers.size(); i++)
+            {
+                delete mWorkers[i];
+            }
+            mWorkers.clear();
+
+            tlsWorkerIndex = -1;
+        }
+
+        s32 Jobs::GetCurrentWorkerIndex()
+        {
+            return tlsWorkerIndex;
+        }
+
+        Job* Jobs::_Allocate(JobDelegate aJob, JobCounter* apCounter)
+        {
+            Job* p = null;
+            s32 index = tlsWorkerIndex;
+
+            // Ring allocation from the thread's pool. If the slot is still in use (many
+            // outstanding jobs) or the thread is not a worker, fall back to the heap.
+            if (index >= 0)
+            {
+                Worker& w = *(mWorkers[index]);
+                Job* pSlot = (w.pPool + (w.PoolNext & (kJobPoolSize - 1)));
+
+                if (AtomicLoadAcquire(&(pSlot->bBusy)) == 0)
+                {
+                    w.PoolNext++;
+                    p = pSlot;
+                    p->bHeap = false;
+                }
+            }
+
+            if (!p)
+            {
+                p = new Job;
+                p->bHeap = true;
+            }
+
+            p->Function = aJob;
+            p->pCounter = apCounter;
+            p->pNext = null;
+            AtomicExchange(&(p->bBusy), 1);
+
+            if (apCounter) { AtomicIncrement(&(apCounter->mCount)); }
+
+            return p;
+        }
+
+        void Jobs::_Execute(Job* p)
+        {
+            p->Function();
+
+            JobCounter* pCounter = p->pCounter;
+
+            if (p->bHeap) { delete p; }
+            else { AtomicStoreRelease(&(p->bBusy), 0); }
+
+            if (pCounter)
+            {
+                AtomicIncrement(&(pCounter->mBusy));
+                if (AtomicDecrement(&(pCounter->mCount)) == 0)
+                {
+                    Job* pContinuation = (Job*)AtomicExchangePointer(&(pCounter->mpContinuations), null);
+                    while (pContinuation)
+                    {
+                        Job* pNext = pContinuation->pNext;
+                        pContinuation->pNext = null;
+                        _Push(pContinuation);
+                        pContinuation = pNext;
+                    }
+                }
+
+                // Last access, the counter may be destroyed by a waiter after this.
+                AtomicDecrement(&(pCounter->mBusy));
+            }
+        }
+
+        void Jobs::_Push(Job* p)
+        {
+            s32 index = tlsWorkerIndex;
+
+            if (index < 0 || !(mWorkers[index]->Queue.Push(p)))
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+                mSharedQueue.push_back(p);
+            }
+
+#           if JZ_MULTITHREADED
+                // The job must be visible before mSleeping is read, a worker increments
+                // mSleeping and then looks for jobs. Without the fence the load can pass
+                // the store to Bottom, and both sides miss each other.
+                AtomicFence();
+                if (AtomicLoadAcquire(&mSleeping) > 0) { mWake.Signal(); }
+#           endif
+        }
+
+        Job* Jobs::_GetJob()
+        {
+            s32 index = tlsWorkerIndex;
+            JZ_ASSERT(index >= 0);
+
+            Worker& w = *(mWorkers[index]);
+            Job* p = w.Queue.Pop();
+            if (p) { return p; }
+
+            // Steal, starting from a random victim.
+            uint count = (uint)mWorkers.size();
+            if (count > 1u)
+            {
+                w.Random = (w.Random * 1664525u) + 1013904223u;
+                uint start = (w.Random >> 16) % count;
+
+                for (uint i = 0u; i < count; i++)
+                {
+                    uint victim = (start + i) % count;
+                    if (victim == (uint)index) { continue; }
+
+                    p = mWorkers[victim]->Queue.Steal();
+                    if (p) { return p; }
+                }
+            }
+
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+            if (!mSharedQueue.empty())
+            {
+                p = mSharedQueue.front();
+                mSharedQueue.pop_front();
+            }
+
+            return p;
+        }
+
+        bool Jobs::_RunMainThreadJob()
+        {
+            JZ_ASSERT(tlsWorkerIndex == 0);
+
+            Job* p = null;
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+                if (!mMainQueue.empty())
+                {
+                    p = mMainQueue.front();
+                    mMainQueue.pop_front();
+                }
+            }
+
+            if (p)
+            {
+                _Execute(p);
+                return true;
+            }
+
+            return false;
+        }
+
+        void Jobs::Run(JobDelegate aJob, JobCounter* apCounter)
+        {
+            _Push(_Allocate(aJob, apCounter));
+        }
+
+        void Jobs::RunAfter(JobCounter& aDependency, JobDelegate aJob, JobCounter* apCounter)
+        {
+            Job* p = _Allocate(aJob, apCounter);
+
+            void_p pHead;
+            do
+            {
+                pHead = AtomicLoadAcquirePointer(&(aDependency.mpContinuations));
+                p->pNext = (Job*)pHead;
+            } while (AtomicCompareExchangePointer(&(aDependency.mpContinuations), p, pHead) != pHead);
+
+            // If the dependency completed before the continuation was added, nothing else
+            // will submit it. Only the count matters here, a completing thread that is
+            // still busy may already have taken the continuations.
+            if (AtomicLoadAcquire(&(aDependency.mCount)) == 0)
+            {
+                Job* pContinuation = (Job*)AtomicExchangePointer(&(aDependency.mpContinuations), null);
+                while (pContinuation)
+                {
+                    Job* pNext = pContinuation->pNext;
+                    pContinuation->pNext = null;
+                    _Push(pContinuation);
+                    pContinuation = pNext;
+                }
+            }
+        }
+
+        void Jobs::RunOnMainThread(JobDelegate aJob, JobCounter* apCounter)
+        {
+            Job* p = _Allocate(aJob, apCounter);
+
+#           if JZ_MULTITHREADED
+                Lock lock(mMutex);
+#           endif
+            mMainQueue.push_back(p);
+        }
+
+        void Jobs::Tick(unatural aMilliseconds)
+        {
+            JZ_ASSERT(tlsWorkerIndex == 0);
+
+            unatural startTick = system::Time::GetSingleton().GetAbsoluteMilliseconds();
+            unatural currentTick = startTick;
+
+            while ((currentTick - startTick) < aMilliseconds)
+            {
+                if (!_RunMainThreadJob())
+                {
+                    // Without workers, the main thread is the only one that can run jobs.
+                    if (mWorkerCount > 0u) { break; }
+
+                    Job* p = _GetJob();
+                    if (!p) { break; }
+                    _Execute(p);
+                }
+
+                currentTick = system::Time::GetSingleton().GetAbsoluteMilliseconds();
+            }
+        }
+
+        void Jobs::Wait(JobCounter& aCounter)
+        {
+            // A thread not owned by Jobs has no queue to run jobs from, it can only
+            // wait for the workers.
+            if (tlsWorkerIndex < 0)
+            {
+                JZ_ASSERT(mWorkerCount > 0u);
+                while (!aCounter.IsDone())
+                {
+#                   if JZ_MULTITHREADED
+                        Thread::Sleep(0u);
+#                   endif
+                }
+                return;
+            }
+
+            uint spin = 0u;
+            while (!aCounter.IsDone())
+            {
+                Job* p = _GetJob();
+                if (p) { _Execute(p); spin = 0u; continue; }
+                if (tlsWorkerIndex == 0 && _RunMainThreadJob()) { spin = 0u; continue; }
+
+#               if JZ_MULTITHREADED
+                    if (++spin > kSpinCount) { Thread::Sleep(0u); }
+#               endif
+            }
+        }
+
+#       if JZ_MULTITHREADED
+            void Jobs::_WorkerMain(uint aIndex, const Thread& aThread)
+            {
+                tlsWorkerIndex = (s32)aIndex;
+
+                uint spin = 0u;
+                while (AtomicLoadAcquire(&mbDone) == 0)
+                {
+                    Job* p = _GetJob();
+                    if (p) { _Execute(p); spin = 0u; continue; }
+
+                    if (++spin <= kSpinCount) { continue; }
+
+                    // Announce before the final check, so a push that lands after the check
+                    // sees mSleeping and signals.
+                    AtomicIncrement(&mSleeping);
+                    p = _GetJob();
+                    if (p)
+                    {
+                        AtomicDecrement(&mSleeping);
+                        _Execute(p);
+                    }
+                    else
+                    {
+                        mWake.Wait();
+                        AtomicDecrement(&mSleeping);
+                    }
+                    spin = 0u;
+                }
+
+                tlsWorkerIndex = -1;
+            }
+#       endif
+
+    }
+}
@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SYSTEM_JOBS_H_
+#define _JZ_SYSTEM_JOBS_H_
+
+#include <jz_core/Atomic.h>
+#include <jz_core/Delegate.h>
+#include <jz_core/Utility.h>
+#include <deque>
+#include <vector>
+
+#if JZ_MULTITHREADED
+#   include <jz_system/Mutex.h>
+#   include <jz_system/Semaphore.h>
+#   include <jz_system/Thread.h>
+#endif
+
+namespace jz
+{
+    namespace system
+    {
+
+        typedef Delegate<void()> JobDelegate;
+
+        struct Job;
+        class Jobs;
+
+        // Tracks completion of a group of jobs. Each job run with a counter increments it
+        // when submitted and decrements it when complete. Jobs can be made to depend on a
+        // counter with Jobs::RunAfter().
+        class JobCounter sealed
+        {
+        public:
+            JobCounter()
+                : mCount(0), mBusy(0), mpContinuations(null)
+            {}
+
+            ~JobCounter()
+            {
+                JZ_ASSERT(IsDone());
+            }
+
+            // mBusy is checked second, so a waiter cannot return and destroy the counter
+            // while the thread that completed it is still releasing continuations.
+            bool IsDone() const { return (AtomicLoadAcquire(&mCount) == 0 && AtomicLoadAcquire(&mBusy) == 0); }
+
+        private:
+            friend class Jobs;
+
+            JobCounter(const JobCounter&);
+            JobCounter& operator=(const JobCounter&);
+
+            volatile s32 mCount;
+            volatile s32 mBusy;
+            void_p volatile mpContinuations;
+        };
+
+        // Fixed pool of worker threads, each with a Chase-Lev work stealing deque. The
+        // thread that constructs Jobs is the main thread and owns an additional queue of
+        // jobs that only run on it, from Tick() or Wait().
+        //
+        // When JZ_MULTITHREADED is 0, no workers are created and all jobs run on the main
+        // thread from Wait() and Tick().
+        class Jobs sealed : public Singleton<Jobs>
+        {
+        public:
+            static const s32 kDequeSize = (1 << 12);
+            static const s32 kJobPoolSize = (1 << 12);
+            static const uint kSpinCount = 64u;
+
+            // aWorkerCount of 0 creates one worker per hardware thread, less the main thread.
+            Jobs(uint aWorkerCount = 0u);
+
+            // Stops the workers, then runs any jobs still queued on the calling thread,
+            // which must be the main thread.
+            ~Jobs();
+
+            uint GetWorkerCount() const { return mWorkerCount; }
+
+            // 0 on the main thread, [1, GetWorkerCount()] on a worker, and -1 on a thread
+            // not owned by Jobs.
+            static s32 GetCurrentWorkerIndex();
+
+            void Run(JobDelegate aJob, JobCounter* apCounter = null);
+            void RunAfter(JobCounter& aDependency, JobDelegate aJob, JobCounter* apCounter = null);
+            void RunOnMainThread(JobDelegate aJob, JobCounter* apCounter = null);
+
+            // Runs main thread jobs for up to aMilliseconds. Must be called from the main thread.
+            void Tick(unatural aMilliseconds);
+
+            // Executes other jobs until aCounter completes. On a thread not owned by Jobs,
+            // blocks until the workers complete it instead.
+            void Wait(JobCounter& aCounter);
+
+            // Splits [aBegin, aEnd) into ranges of at least aGrainSize and calls
+            // aBody(begin, end) for each range in parallel. Returns once all ranges complete.
+            // On a thread not owned by Jobs, aBody is called once for the whole range.
+            template <typename T>
+            void ParallelFor(T& aBody, size_t aBegin, size_t aEnd, size_t aGrainSize = 1u)
+            {
+                if (aEnd <= aBegin) { return; }
+                if (GetCurrentWorkerIndex() < 0) { aBody(aBegin, aEnd); return; }
+
+                size_t count = (aEnd - aBegin);
+                size_t maxRanges = (size_t)((mWorkerCount + 1u) * 4u);
+                size_t grain = jz::Max(jz::Max(aGrainSize, (size_t)1u), (count + maxRanges - 1u) / maxRanges);
+                size_t rangeCount = (count + grain - 1u) / grain;
+
+                if (rangeCount == 1u) { aBody(aBegin, aEnd); return; }
+
+                vector< _ParallelForRange<T> > ranges(rangeCount);
+                JobCounter counter;
+
+                for (size_t i = 0u; i < rangeCount; i++)
+                {
+                    ranges[i].pBody = &aBody;
+                    ranges[i].Begin = aBegin + (i * grain);
+                    ranges[i].End = jz::Min(ranges[i].Begin + grain, aEnd);
+
+                    Run(JobDelegate::Bind< _ParallelForRange<T>, &_ParallelForRange<T>::Execute >(&ranges[i]), &counter);
+                }
+
+                Wait(counter);
+            }
+
+        private:
+            Jobs(const Jobs&);
+            Jobs& operator=(const Jobs&);
+
+            template <typename T>
+            struct _ParallelForRange
+            {
+                _ParallelForRange()
+                    : pBody(null), Begin(0u), End(0u)
+                {}
+
+                void Execute() { (*pBody)(Begin, End); }
+
+                T* pBody;
+                size_t Begin;
+                size_t End;
+            };
+
+            // Single owner pushes and pops at the bottom, any thread steals from the top.
+            struct Deque
+            {
+                Deque();
+
+                bool Push(Job* p);
+                Job* Pop();
+                Job* Steal();
+
+                volatile s32 Top;
+                volatile s32 Bottom;
+                void_p volatile Slots[kDequeSize];
+            };
+
+            struct Worker
+            {
+                Worker();
+                ~Worker();
+
+                Deque Queue;
+                Job* pPool;
+                s32 PoolNext;
+                u32 Random;
+            };
+
+            uint mWorkerCount;
+            vector<Worker*> mWorkers;
+            volatile s32 mbDone;
+
+            std::deque<Job*> mMainQueue;
+            std::deque<Job*> mSharedQueue;
+
+#           if JZ_MULTITHREADED
+                Mutex mMutex;
+                vector<Thread*> mThreads;
+
+                // Idle workers block on mWake, mSleeping counts them.
+                Semaphore mWake;
+                volatile s32 mSleeping;
+
+                void _WorkerMain(uint aIndex, const Thread& aThread);
+#           endif
+
+            Job* _Allocate(JobDelegate aJob, JobCounter* apCounter);
+            void _Execute(Job* p);
+            void _Push(Job* p);
+            Job* _GetJob();
+            bool _RunMainThreadJob();
+        };
+
+    }
+}
+
+#endif
@@ -20,136 +20,116 @@
 // THE SOFTWARE.
 //
 
-#if JZ_MULTITHREADED
+#if JZ_MULTITHREADED_IO
 #   include <jz_system/Loader.h>
-#   include <jz_system/Time.h>
 
     namespace jz
     {
-        system::Loader* system::Loader::mspSingleton = null;
+        template <> system::Loader* Singleton<system::Loader>::mspSingleton = null;
         namespace system
         {
 
+            void ILoaderEntry::_MainThreadStep()
+            {
+                Loader::GetSingleton()._Dispatch(this, MainThreadAction());
+            }
+
+            void ILoaderEntry::_LoaderThreadStep()
+            {
+                Loader::GetSingleton()._Dispatch(this, LoaderThreadAction());
+            }
+
+            void ILoaderEntry::_CompleteStep()
+            {
+                Loader::GetSingleton()._Dispatch(this, kComplete);
+            }
+
             Loader::Loader()
                 : mMilliseconds(4u),
-                  mpMainTail(null), mpLoaderTail(null),
-                  mbDone(false), mThread(Loader::_LoaderFunction)
+                  mpTail(null),
+                  mbDone(false)
             {}
 
             Loader::~Loader()
             {
+                // Entries are not rescheduled once done is set, wait for any in flight.
                 mbDone = true;
-                while (!mThread.bDone()) ;
+                Jobs::GetSingleton().Wait(mCounter);
+
+                Lock lock(mMutex);
+                while (mpHead.IsValid()) { _Remove(mpHead.Get()); }
             }
 
-            void Loader::_Remove(ILoaderEntryPtr& pHead, ILoaderEntry*& pTail, ILoaderEntry* p)
+            void Loader::_Remove(ILoaderEntry* p)
             {
                 JZ_ASSERT(p != null);
-                JZ_ASSERT(pHead.Get() == p && !p->mpPrev);
 
                 ILoaderEntryPtr pNext = (p->mpNext);
+                ILoaderEntry* pPrev = (p->mpPrev);
+
                 p->mpNext.Reset();
-             
-                if (pNext.IsValid()) { pNext->mpPrev = null; }
-                else { pTail = null; }
+                p->mpPrev = null;
 
-                pHead = pNext;
+                if (pNext.IsValid()) { pNext->mpPrev = pPrev; }
+                else { mpTail = pPrev; }
+
+                if (pPrev) { pPrev->mpNext = pNext; }
+                else { mpHead = pNext; }
             }
 
-            void Loader::_Insert(ILoaderEntryPtr& pHead, ILoaderEntry*& pTail, ILoaderEntry* p)
+            void Loader::_Insert(ILoaderEntry* p)
             {
                 JZ_ASSERT(p != null);
                 JZ_ASSERT(!p->mpPrev && !p->mpNext.IsValid());
 
-                p->mpPrev = pTail;
-                if (pTail) { pTail->mpNext.Reset(p); }
-                pTail = p;
+                p->mpPrev = mpTail;
+                if (mpTail) { mpTail->mpNext.Reset(p); }
+                mpTail = p;
 
-                if (!pHead.IsValid()) { pHead = p; }
+                if (!mpHead.IsValid()) { mpHead = p; }
             }
 
-            void Loader::Add(ILoaderEntry* p)
+            void Loader::_Dispatch(ILoaderEntry* p, ILoaderEntry::NextAction aNext)
             {
-                if (p->GetNextAction() == ILoaderEntry::kLoaderThread)
+                if (mbDone) { aNext = ILoaderEntry::kComplete; }
+
+                if (aNext == ILoaderEntry::kLoaderThread)
                 {
-                    Lock lock(mMutex);
-                    _Insert(mpLoaderHead, mpLoaderTail, p);
+                    Jobs::GetSingleton().Run(JobDelegate::Bind<ILoaderEntry, &ILoaderEntry::_LoaderThreadStep>(p), &mCounter);
+                }
+                else if (aNext == ILoaderEntry::kMainThread)
+                {
+                    Jobs::GetSingleton().RunOnMainThread(JobDelegate::Bind<ILoaderEntry, &ILoaderEntry::_MainThreadStep>(p), &mCounter);
                 }
-                else if (p->GetNextAction() == ILoaderEntry::kMainThread)
+                else if (Jobs::GetCurrentWorkerIndex() != 0)
+                {
+                    // Releasing the entry releases what it holds, whose reference counts
+                    // are not atomic, so that only happens on the main thread.
+                    Jobs::GetSingleton().RunOnMainThread(JobDelegate::Bind<ILoaderEntry, &ILoaderEntry::_CompleteStep>(p), &mCounter);
+                }
+                else
                 {
                     Lock lock(mMutex);
-                    _Insert(mpMainHead, mpMainTail, p);
+                    _Remove(p);
                 }
             }
 
-            void Loader::Tick()
+            void Loader::Add(ILoaderEntry* p)
             {
-                if (mThread.bCurrent()) { return; }
+                ILoaderEntry::NextAction next = p->GetNextAction();
+                if (next == ILoaderEntry::kComplete) { return; }
 
-                unatural startTick = system::Time::GetSingleton().GetAbsoluteMilliseconds();
-                unatural currentTick = startTick;
-
-                while ((currentTick - startTick) < mMilliseconds)
                 {
-                    ILoaderEntryPtr p;
-                    {
-                        Lock lock(mMutex);
-                        p = mpMainHead;
-                    }
-
-                    if (!p.IsValid()) { break; }
-
-                    ILoaderEntry::NextAction next = p->MainThreadAction();
-
-                    {
-                        Lock lock(mMutex);
-                        _Remove(mpMainHead, mpMainTail, p.Get());
-                        if (next == ILoaderEntry::kMainThread) 
-                        {
-                            _Insert(mpMainHead, mpMainTail, p.Get());
-                        }
-                        else if (next == ILoaderEntry::kLoaderThread)
-                        {
-                            _Insert(mpLoaderHead, mpLoaderTail, p.Get());
-                        }
-                    }
-
-                    currentTick = system::Time::GetSingleton().GetAbsoluteMilliseconds();
+                    Lock lock(mMutex);
+                    _Insert(p);
                 }
+
+                _Dispatch(p, next);
             }
 
-            void Loader::_LoaderFunction(const Thread& t)
+            void Loader::Tick()
             {
-                Loader& loader = Loader::GetSingleton();
-                while (!loader.mbDone)
-                {
-                    ILoaderEntryPtr p;
-                    {
-                        Lock lock(loader.mMutex);
-                        p = loader.mpLoaderHead;
-                    }
-
-                    if (!p.IsValid())
-                    {
-                        Thread::Sleep(50);
-                        continue;
-                    }
-
-                    ILoaderEntry::NextAction next = p->LoaderThreadAction();
-
-                    {
-                        Lock lock(loader.mMutex);
-                        loader._Remove(loader.mpLoaderHead, loader.mpLoaderTail, p.Get());
-                        if (next == ILoaderEntry::kMainThread) 
-                        {
-                            loader._Insert(loader.mpMainHead, loader.mpMainTail, p.Get());
-                        }
-                        else if (next == ILoaderEntry::kLoaderThread)
-                        {
-                            loader._Insert(loader.mpLoaderHead, loader.mpLoaderTail, p.Get());
-                        }
-                    }
-                }
+                Jobs::GetSingleton().Tick(mMilliseconds);
             }
 
         }
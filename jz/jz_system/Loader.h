@@ -24,11 +24,11 @@
 #ifndef JZ_SYSTEM_LOADER_H_
 #define JZ_SYSTEM_LOADER_H_
 
-#if JZ_MULTITHREADED
+#if JZ_MULTITHREADED_IO
 #   include <jz_core/Auto.h>
 #   include <jz_core/Utility.h>
+#   include <jz_system/Jobs.h>
 #   include <jz_system/Mutex.h>
-#   include <jz_system/Thread.h>
 
     namespace jz
     {
@@ -39,6 +39,12 @@
             class ILoaderEntry abstract
             {
             public:
+                // kLoaderThread actions run as jobs on the Jobs worker pool, kMainThread
+                // actions run from the main thread affinity queue of Jobs. An entry's next
+                // action is scheduled only once the previous one returns, so the actions of
+                // one entry never overlap and each sees what the last one wrote. Loader
+                // thread actions of different entries do run at the same time, they must
+                // not share unsynchronized state.
                 enum NextAction
                 {
                     kMainThread = 0,
@@ -66,6 +72,10 @@
                 ILoaderEntry(const ILoaderEntry&);
                 ILoaderEntry& operator=(const ILoaderEntry&);
 
+                void _MainThreadStep();
+                void _LoaderThreadStep();
+                void _CompleteStep();
+
                 friend class Loader;
                 AutoPtr<ILoaderEntry> mpNext;
                 ILoaderEntry* mpPrev;
@@ -73,6 +83,8 @@
 
             typedef AutoPtr<ILoaderEntry> ILoaderEntryPtr;
 
+            // Schedules ILoaderEntry actions on the Jobs singleton, which must outlive
+            // the Loader. Entries are kept alive by the Loader until they complete.
             class Loader sealed : public Singleton<Loader>
             {
             public:
@@ -87,21 +99,21 @@
                 Loader(const Loader&);
                 Loader& operator=(const Loader&);
 
+                friend class ILoaderEntry;
+
                 unatural mMilliseconds;
 
-                ILoaderEntryPtr mpMainHead;
-                ILoaderEntry* mpMainTail;
-                ILoaderEntryPtr mpLoaderHead;
-                ILoaderEntry* mpLoaderTail;
+                ILoaderEntryPtr mpHead;
+                ILoaderEntry* mpTail;
 
-                void _Insert(ILoaderEntryPtr& pHead, ILoaderEntry*& pTail, ILoaderEntry* p);
-                void _Remove(ILoaderEntryPtr& pHead, ILoaderEntry*& pTail, ILoaderEntry* p);
+                void _Dispatch(ILoaderEntry* p, ILoaderEntry::NextAction aNext);
+                void _Insert(ILoaderEntry* p);
+                void _Remove(ILoaderEntry* p);
 
-                static void _LoaderFunction(const Thread& t);
                 volatile bool mbDone;
 
+                JobCounter mCounter;
                 Mutex mMutex;
-                Thread mThread;
             };
 
         }
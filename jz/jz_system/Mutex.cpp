@@ -20,12 +20,9 @@
 // THE SOFTWARE.
 //
 
-#if JZ_MULTITHREADED
-#   include <jz_system/Mutex.h>
+#include <jz_system/Mutex.h>
 
-#   if JZ_PLATFORM_WINDOWS
-#       include <jz_system/Win32.h>
-#   endif
+#if JZ_MULTITHREADED
 
     namespace jz
     {
@@ -33,28 +30,61 @@
         {
 
         #   if JZ_PLATFORM_WINDOWS
+                // A critical section instead of a kernel mutex, it is also recursive but
+                // does not enter the kernel when uncontended, and can be used with
+                // condition variables.
                 Mutex::Mutex()
-                    : mHandle(CreateMutex(null, false, null))
-                {}
+                {
+                    InitializeCriticalSectionAndSpinCount(&mHandle, 1024u);
+                }
+                
+                Mutex::~Mutex()
+                {
+                    DeleteCriticalSection(&mHandle);
+                }
+                
+                void Mutex::Lock()
+                {
+                    EnterCriticalSection(&mHandle);
+                }
+                
+                bool Mutex::TryLock()
+                {
+                    return (TryEnterCriticalSection(&mHandle) != FALSE);
+                }
+                
+                void Mutex::Unlock()
+                {
+                    LeaveCriticalSection(&mHandle);
+                }
+        #   else
+                Mutex::Mutex()
+                {
+                    pthread_mutexattr_t attr;
+                    pthread_mutexattr_init(&attr);
+                    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+                    pthread_mutex_init(&mHandle, &attr);
+                    pthread_mutexattr_destroy(&attr);
+                }
                 
                 Mutex::~Mutex()
                 {
-                    CloseHandle(mHandle);
+                    pthread_mutex_destroy(&mHandle);
                 }
                 
                 void Mutex::Lock()
                 {
-                    WaitForSingleObject(mHandle, INFINITE);
+                    pthread_mutex_lock(&mHandle);
                 }
                 
                 bool Mutex::TryLock()
                 {
-                    return (WaitForSingleObject(mHandle, 0) == WAIT_OBJECT_0);
+                    return (pthread_mutex_trylock(&mHandle) == 0);
                 }
                 
                 void Mutex::Unlock()
                 {
-                    ReleaseMutex(mHandle);
+                    pthread_mutex_unlock(&mHandle);
                 }
         #   endif
 
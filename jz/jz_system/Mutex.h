@@ -24,11 +24,13 @@
 #ifndef _JZ_SYSTEM_MUTEX_H_
 #define _JZ_SYSTEM_MUTEX_H_
 
-#if JZ_MULTITHREADED
-#   include <jz_core/Prereqs.h>
+#include <jz_core/Prereqs.h>
 
+#if JZ_MULTITHREADED
 #   if JZ_PLATFORM_WINDOWS
-        typedef jz::void_p HANDLE;
+#       include <jz_system/Win32.h>
+#   else
+#       include <pthread.h>
 #   endif
 
     namespace jz
@@ -36,9 +38,11 @@
         namespace system
         {
 
+            class ConditionVariable;
             class Lock;
             class TryLock;
             
+            // Recursive mutex.
             class Mutex
             {
                 public:
@@ -50,8 +54,16 @@
                     void Unlock();
 
                 private:
-                    HANDLE mHandle;
+                    Mutex(const Mutex&);
+                    Mutex& operator=(const Mutex&);
+
+        #           if JZ_PLATFORM_WINDOWS
+                        CRITICAL_SECTION mHandle;
+        #           else
+                        pthread_mutex_t mHandle;
+        #           endif
                     
+                    friend class ConditionVariable;
                     friend class Lock;
                     friend class TryLock;
             };
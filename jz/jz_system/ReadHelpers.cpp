@@ -29,142 +29,109 @@ namespace jz
     namespace system
     {
 
-        bool ReadBoolean(IReadFilePtr& p)
+        void SwapByteOrder(void_p p, size_t aWordSize, size_t aCount)
         {
-            const size_t kSize = (sizeof(u8));
-            u8 val = 0u;
+            u8* pBytes = (u8*)p;
+
+            for (size_t i = 0u; i < aCount; i++, pBytes += aWordSize)
+            {
+                for (size_t j = 0u; j < (aWordSize / 2u); j++)
+                {
+                    Swap(pBytes[j], pBytes[aWordSize - j - 1u]);
+                }
+            }
+        }
 
-            JZ_E_ON_FAIL(p->Read(&val, kSize) == kSize, "failed reading boolean.");
+        bool ReadBoolean(IReadFilePtr& p)
+        {
+            const u8 kVal = ReadValue<u8>(p);
 
-            bool bReturn = (val == 0u) ? false : true;
+            bool bReturn = (kVal == 0u) ? false : true;
 
             return bReturn;
         }
 
         BoundingBox ReadBoundingBox(IReadFilePtr& p)
         {
-            BoundingBox ret;
-            ret.Min = ReadVector3(p);
-            ret.Max = ReadVector3(p);
+            JZ_STATIC_ASSERT(sizeof(BoundingBox) == sizeof(f32) * 6);
 
-            return ret;
+            return ReadValue<BoundingBox>(p);
         }
 
         BoundingSphere ReadBoundingSphere(IReadFilePtr& p)
         {
-            BoundingSphere ret;
-            ret.Center = ReadVector3(p);
-            ret.Radius = ReadSingle(p);
+            JZ_STATIC_ASSERT(sizeof(BoundingSphere) == sizeof(f32) * 4);
 
-            return ret;
+            return ReadValue<BoundingSphere>(p);
         }
 
         string ReadString(IReadFilePtr& p)
         {
-            u32 size;
-            JZ_E_ON_FAIL(p->Read(&size, sizeof(u32)) == sizeof(u32), "failed reading string size.");
-            MemoryBuffer<char> buf(size);
+            const u32 kSize = ReadValue<u32>(p);
+            JZ_E_ON_FAIL(kSize > 0u, "failed reading string size.");
+
+            MemoryBuffer<char> buf(kSize);
             // Includes null terminator.
-            JZ_E_ON_FAIL(p->Read(buf.Get(), size) == size, "failed reading string contents.");
+            ReadArray(p, buf.Get(), kSize);
             
-            return string(buf.Get());
+            return string(buf.Get(), kSize - 1u);
         }
 
         Matrix3 ReadMatrix3(IReadFilePtr& p)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            size_t size = sizeof(f32) * 9;
+            JZ_STATIC_ASSERT(sizeof(Matrix3) == sizeof(f32) * 9);
 
-            Matrix3 ret;
-            JZ_E_ON_FAIL(p->Read(ret.pData, size) == size, "failed reading matrix 3.");
-
-            return ret;
+            return ReadValue<Matrix3>(p);
         }
 
         Matrix4 ReadMatrix4(IReadFilePtr& p)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            size_t size = sizeof(f32) * 16;
-
-            Matrix4 ret;
-            JZ_E_ON_FAIL(p->Read(ret.pData, size) == size, "failed reading matrix 4.");
+            JZ_STATIC_ASSERT(sizeof(Matrix4) == sizeof(f32) * 16);
 
-            return ret;
+            return ReadValue<Matrix4>(p);
         }
 
         float ReadSingle(IReadFilePtr& p)
         {
             JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            size_t size = sizeof(f32) * 1;
 
-            float ret;
-            JZ_E_ON_FAIL(p->Read(&ret, size) == size, "failed reading single.");
-
-            return ret;
+            return ReadValue<float>(p);
         }
 
         s32 ReadInt32(IReadFilePtr& p)
         {
-            size_t size = sizeof(s32) * 1;
-
-            s32 ret;
-            JZ_E_ON_FAIL(p->Read(&ret, size) == size, "failed reading int32.");
-
-            return ret;
+            return ReadValue<s32>(p);
         }
 
         u32 ReadUInt32(IReadFilePtr& p)
         {
-            size_t size = (sizeof(u32) * 1);
-
-            u32 ret;
-            JZ_E_ON_FAIL(p->Read(&ret, size) == size, "failed reading u32.");
-
-            return ret;
+            return ReadValue<u32>(p);
         }
 
         size_t ReadSizeT(IReadFilePtr& p)
         {
-            JZ_STATIC_ASSERT(sizeof(size_t) == sizeof(u32));
-            size_t size = sizeof(u32) * 1;
-
-            size_t ret;
-            JZ_E_ON_FAIL(p->Read(&ret, size) == size, "failed reading size_t.");
-
-            return ret;
+            return (size_t)ReadValue<u32>(p);
         }
 
         Vector2 ReadVector2(IReadFilePtr& p)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            size_t size = sizeof(f32) * 2;
+            JZ_STATIC_ASSERT(sizeof(Vector2) == sizeof(f32) * 2);
 
-            Vector2 ret;
-            JZ_E_ON_FAIL(p->Read(ret.pData, size) == size, "failed reading vector 2.");
-
-            return ret;
+            return ReadValue<Vector2>(p);
         }
 
         Vector3 ReadVector3(IReadFilePtr& p)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            size_t size = sizeof(f32) * 3;
-
-            Vector3 ret;
-            JZ_E_ON_FAIL(p->Read(ret.pData, size) == size, "failed reading vector 3.");
+            JZ_STATIC_ASSERT(sizeof(Vector3) == sizeof(f32) * 3);
 
-            return ret;
+            return ReadValue<Vector3>(p);
         }
 
         Vector4 ReadVector4(IReadFilePtr& p)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            size_t size = sizeof(f32) * 4;
-
-            Vector4 ret;
-            JZ_E_ON_FAIL(p->Read(ret.pData, size) == size, "failed reading vector 4.");
+            JZ_STATIC_ASSERT(sizeof(Vector4) == sizeof(f32) * 4);
 
-            return ret;
+            return ReadValue<Vector4>(p);
         }
 
     }
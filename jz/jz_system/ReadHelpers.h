@@ -39,6 +39,50 @@ namespace jz
     {
 
         class IReadFile; typedef AutoPtr<IReadFile> IReadFilePtr;
+
+        // Files are little endian. ByteOrder<T>::kWordSize is the size of the scalars
+        // that make up T, which are swapped individually on big endian hosts. Compound
+        // types read in bulk must specialize it, the default only takes scalars.
+        template <typename T> struct ByteOrder
+        {
+            JZ_STATIC_ASSERT(tr1::is_arithmetic<T>::value);
+
+            enum { kWordSize = sizeof(T) };
+        };
+        template <> struct ByteOrder<BoundingBox> { enum { kWordSize = sizeof(f32) }; };
+        template <> struct ByteOrder<BoundingSphere> { enum { kWordSize = sizeof(f32) }; };
+        template <> struct ByteOrder<Matrix3> { enum { kWordSize = sizeof(f32) }; };
+        template <> struct ByteOrder<Matrix4> { enum { kWordSize = sizeof(f32) }; };
+        template <> struct ByteOrder<Vector2> { enum { kWordSize = sizeof(f32) }; };
+        template <> struct ByteOrder<Vector3> { enum { kWordSize = sizeof(f32) }; };
+        template <> struct ByteOrder<Vector4> { enum { kWordSize = sizeof(f32) }; };
+
+        void SwapByteOrder(void_p p, size_t aWordSize, size_t aCount);
+
+        // Reads aCount contiguous elements of T with a single Read.
+        template <typename T>
+        void ReadArray(IReadFilePtr& p, T* apOut, size_t aCount)
+        {
+            const size_t kSizeInBytes = (aCount * sizeof(T));
+
+            if (kSizeInBytes > 0u)
+            {
+                JZ_E_ON_FAIL(p->Read(apOut, kSizeInBytes) == kSizeInBytes, "read failed.");
+
+#               if JZ_BIG_ENDIAN
+                    SwapByteOrder(apOut, ByteOrder<T>::kWordSize, (kSizeInBytes / ByteOrder<T>::kWordSize));
+#               endif
+            }
+        }
+
+        template <typename T>
+        T ReadValue(IReadFilePtr& p)
+        {
+            T ret;
+            ReadArray(p, &ret, 1u);
+
+            return ret;
+        }
      
         bool ReadBoolean(IReadFilePtr& p);
         BoundingBox ReadBoundingBox(IReadFilePtr& p);
@@ -58,14 +102,9 @@ namespace jz
         void ReadBuffer(IReadFilePtr& p, MemoryBuffer<T>& arOut)
         {
             const size_t kSize = ReadSizeT(p);
-            const size_t kSizeInBytes = (kSize * sizeof(T));
 
             arOut.resize(kSize);
-
-            if (kSize > 0u)
-            {
-                JZ_E_ON_FAIL(p->Read(arOut.Get(), kSizeInBytes) == kSizeInBytes, "read failed.");
-            }
+            ReadArray(p, arOut.Get(), kSize);
         }
 
     }
@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_system/ReaderWriterLock.h>
+
+#if JZ_MULTITHREADED
+
+    namespace jz
+    {
+        namespace system
+        {
+
+        #   if JZ_PLATFORM_WINDOWS
+                ReaderWriterLock::ReaderWriterLock()
+                {
+                    InitializeSRWLock(&mHandle);
+                }
+
+                ReaderWriterLock::~ReaderWriterLock()
+                {}
+
+                void ReaderWriterLock::LockRead()
+                {
+                    AcquireSRWLockShared(&mHandle);
+                }
+
+                void ReaderWriterLock::LockWrite()
+                {
+                    AcquireSRWLockExclusive(&mHandle);
+                }
+
+                void ReaderWriterLock::UnlockRead()
+                {
+                    ReleaseSRWLockShared(&mHandle);
+                }
+
+                void ReaderWriterLock::UnlockWrite()
+                {
+                    ReleaseSRWLockExclusive(&mHandle);
+                }
+        #   else
+                ReaderWriterLock::ReaderWriterLock()
+                {
+                    pthread_rwlock_init(&mHandle, null);
+                }
+
+                ReaderWriterLock::~ReaderWriterLock()
+                {
+                    pthread_rwlock_destroy(&mHandle);
+                }
+
+                void ReaderWriterLock::LockRead()
+                {
+                    pthread_rwlock_rdlock(&mHandle);
+                }
+
+                void ReaderWriterLock::LockWrite()
+                {
+                    pthread_rwlock_wrlock(&mHandle);
+                }
+
+                void ReaderWriterLock::UnlockRead()
+                {
+                    pthread_rwlock_unlock(&mHandle);
+                }
+
+                void ReaderWriterLock::UnlockWrite()
+                {
+                    pthread_rwlock_unlock(&mHandle);
+                }
+        #   endif
+
+            ReadLock::ReadLock(ReaderWriterLock& aLock)
+                : mLock(aLock)
+            {
+                mLock.LockRead();
+            }
+
+            ReadLock::~ReadLock()
+            {
+                mLock.UnlockRead();
+            }
+
+            WriteLock::WriteLock(ReaderWriterLock& aLock)
+                : mLock(aLock)
+            {
+                mLock.LockWrite();
+            }
+
+            WriteLock::~WriteLock()
+            {
+                mLock.UnlockWrite();
+            }
+
+        }
+    }
+#endif
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SYSTEM_READER_WRITER_LOCK_H_
+#define _JZ_SYSTEM_READER_WRITER_LOCK_H_
+
+#include <jz_core/Prereqs.h>
+
+#if JZ_MULTITHREADED
+#   if JZ_PLATFORM_WINDOWS
+#       include <jz_system/Win32.h>
+#   else
+#       include <pthread.h>
+#   endif
+
+    namespace jz
+    {
+        namespace system
+        {
+
+            class ReadLock;
+            class WriteLock;
+
+            // Any number of readers or a single writer. Not recursive.
+            class ReaderWriterLock
+            {
+                public:
+                    ReaderWriterLock();
+                    ~ReaderWriterLock();
+
+                    void LockRead();
+                    void LockWrite();
+                    void UnlockRead();
+                    void UnlockWrite();
+
+                private:
+                    ReaderWriterLock(const ReaderWriterLock&);
+                    ReaderWriterLock& operator=(const ReaderWriterLock&);
+
+        #           if JZ_PLATFORM_WINDOWS
+                        SRWLOCK mHandle;
+        #           else
+                        pthread_rwlock_t mHandle;
+        #           endif
+            };
+
+            class ReadLock
+            {
+                public:
+                    explicit ReadLock(ReaderWriterLock& aLock);
+                    ~ReadLock();
+
+                private:
+                    ReadLock(const ReadLock&);
+                    ReadLock& operator=(const ReadLock&);
+
+                    ReaderWriterLock& mLock;
+            };
+
+            class WriteLock
+            {
+                public:
+                    explicit WriteLock(ReaderWriterLock& aLock);
+                    ~WriteLock();
+
+                private:
+                    WriteLock(const WriteLock&);
+                    WriteLock& operator=(const WriteLock&);
+
+                    ReaderWriterLock& mLock;
+            };
+
+        }
+    }
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_system/Semaphore.h>
+
+#if JZ_MULTITHREADED
+#   if JZ_PLATFORM_WINDOWS
+#       include <jz_system/Win32.h>
+#   endif
+
+    namespace jz
+    {
+        namespace system
+        {
+
+        #   if JZ_PLATFORM_WINDOWS
+                Semaphore::Semaphore(uint aInitialCount)
+                    : mHandle(CreateSemaphore(null, (LONG)aInitialCount, Constants<int>::kMax, null))
+                {}
+
+                Semaphore::~Semaphore()
+                {
+                    CloseHandle(mHandle);
+                }
+
+                void Semaphore::Signal(uint aCount)
+                {
+                    ReleaseSemaphore(mHandle, (LONG)aCount, null);
+                }
+
+                bool Semaphore::TryWait()
+                {
+                    return (WaitForSingleObject(mHandle, 0u) == WAIT_OBJECT_0);
+                }
+
+                void Semaphore::Wait()
+                {
+                    WaitForSingleObject(mHandle, INFINITE);
+                }
+        #   else
+                Semaphore::Semaphore(uint aInitialCount)
+                    : mCount(aInitialCount)
+                {}
+
+                Semaphore::~Semaphore()
+                {}
+
+                void Semaphore::Signal(uint aCount)
+                {
+                    Lock lock(mMutex);
+                    mCount += aCount;
+
+                    if (aCount == 1u) { mCondition.NotifyOne(); }
+                    else { mCondition.NotifyAll(); }
+                }
+
+                bool Semaphore::TryWait()
+                {
+                    Lock lock(mMutex);
+                    if (mCount == 0u) { return false; }
+
+                    mCount--;
+                    return true;
+                }
+
+                void Semaphore::Wait()
+                {
+                    Lock lock(mMutex);
+                    while (mCount == 0u) { mCondition.Wait(mMutex); }
+
+                    mCount--;
+                }
+        #   endif
+
+        }
+    }
+#endif
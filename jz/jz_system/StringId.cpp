@@ -0,0 +1,240 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_core/Hash.h>
+#include <jz_core/Memory.h>
+#include <jz_system/StringId.h>
+#include <vector>
+
+#if JZ_MULTITHREADED
+#   include <jz_system/Mutex.h>
+#endif
+
+namespace jz
+{
+    namespace system
+    {
+
+        static const size_t kBlockSize = (1 << 16);
+        static const size_t kMinimumSlots = (1 << 10);
+        static const size_t kStackAppendSize = (1 << 8);
+
+        // Interned strings are packed into kBlockSize blocks, the table is open addressed
+        // with linear probing and kept at most half full.
+        class StringPool sealed
+        {
+        public:
+            StringPool()
+                : mCount(0u), mpBlock(null), mBlockUsed(kBlockSize)
+            {
+                Slot empty;
+                empty.Hash = 0u;
+                empty.pString = null;
+                empty.Length = 0u;
+
+                mSlots.resize(kMinimumSlots, empty);
+            }
+
+            ~StringPool()
+            {
+                for (size_t i = 0u; i < mBlocks.size(); i++) { Free(mBlocks[i]); }
+            }
+
+            const char* Find(u64 aHash, const char* apString, size_t aLength, bool abInsert)
+            {
+#               if JZ_MULTITHREADED
+                    Lock lock(mMutex);
+#               endif
+
+                size_t i = _Probe(aHash, apString, aLength);
+                if (mSlots[i].pString || !abInsert) { return mSlots[i].pString; }
+
+                if ((mCount + 1u) * 2u > mSlots.size())
+                {
+                    _Grow();
+                    i = _Probe(aHash, apString, aLength);
+                }
+
+                Slot& slot = mSlots[i];
+                slot.Hash = aHash;
+                slot.pString = _Store(apString, aLength);
+                slot.Length = (u32)aLength;
+                mCount++;
+
+                return slot.pString;
+            }
+
+        private:
+            struct Slot
+            {
+                u64 Hash;
+                const char* pString;
+                u32 Length;
+            };
+
+            vector<Slot> mSlots;
+            size_t mCount;
+            vector<char*> mBlocks;
+            char* mpBlock;
+            size_t mBlockUsed;
+
+#           if JZ_MULTITHREADED
+                Mutex mMutex;
+#           endif
+
+            // The slot holding apString, or the empty slot where it would go.
+            size_t _Probe(u64 aHash, const char* apString, size_t aLength) const
+            {
+                const size_t kMask = (mSlots.size() - 1u);
+
+                size_t i = ((size_t)aHash & kMask);
+                for (; mSlots[i].pString; i = ((i + 1u) & kMask))
+                {
+                    const Slot& slot = mSlots[i];
+                    if (slot.Hash == aHash && slot.Length == aLength && memcmp(slot.pString, apString, aLength) == 0)
+                    {
+                        break;
+                    }
+                }
+
+                return i;
+            }
+
+            void _Grow()
+            {
+                vector<Slot> slots(mSlots.size() * 2u);
+                const size_t kMask = (slots.size() - 1u);
+
+                for (size_t i = 0u; i < mSlots.size(); i++)
+                {
+                    if (!mSlots[i].pString) { continue; }
+
+                    size_t j = ((size_t)mSlots[i].Hash & kMask);
+                    while (slots[j].pString) { j = ((j + 1u) & kMask); }
+                    slots[j] = mSlots[i];
+                }
+
+                mSlots.swap(slots);
+            }
+
+            const char* _Store(const char* apString, size_t aLength)
+            {
+                const size_t kSize = (aLength + 1u);
+                char* p = null;
+
+                // Strings too large to pack get an allocation of their own.
+                if (kSize > (kBlockSize / 4u))
+                {
+                    p = (char*)Malloc(kSize, 1u);
+                    mBlocks.push_back(p);
+                }
+                else
+                {
+                    if (mBlockUsed + kSize > kBlockSize)
+                    {
+                        mpBlock = (char*)Malloc(kBlockSize, 1u);
+                        mBlocks.push_back(mpBlock);
+                        mBlockUsed = 0u;
+                    }
+
+                    p = (mpBlock + mBlockUsed);
+                    mBlockUsed += kSize;
+                }
+
+                memcpy(p, apString, aLength);
+                p[aLength] = 0;
+
+                return p;
+            }
+        };
+
+        static StringPool gsPool;
+
+        StringId::StringId(const char* apString)
+            : mHash(0u), mpString(null)
+        {
+            _Intern(apString, strlen(apString), true);
+        }
+
+        StringId::StringId(const char* apString, size_t aLength)
+            : mHash(0u), mpString(null)
+        {
+            _Intern(apString, aLength, true);
+        }
+
+        StringId::StringId(const string& aString)
+            : mHash(0u), mpString(null)
+        {
+            _Intern(aString.c_str(), aString.length(), true);
+        }
+
+        StringId StringId::Append(const StringId& aPrefix, const char* apSuffix)
+        {
+            const size_t kPrefixLength = strlen(aPrefix.c_str());
+            const size_t kSuffixLength = strlen(apSuffix);
+            const size_t kLength = (kPrefixLength + kSuffixLength);
+
+            char stackBuffer[kStackAppendSize];
+            MemoryBuffer<char> heapBuffer;
+            char* p = stackBuffer;
+
+            if (kLength > kStackAppendSize)
+            {
+                heapBuffer.resize(kLength);
+                p = heapBuffer.Get();
+            }
+
+            memcpy(p, aPrefix.c_str(), kPrefixLength);
+            memcpy(p + kPrefixLength, apSuffix, kSuffixLength);
+
+            return StringId(p, kLength);
+        }
+
+        StringId StringId::Find(const char* apString, size_t aLength)
+        {
+            StringId ret;
+            ret._Intern(apString, aLength, false);
+
+            return ret;
+        }
+
+        u64 StringId::Hash(const char* apString, size_t aLength)
+        {
+            return hash64((u8c_p)apString, (u32)aLength, 0u);
+        }
+
+        void StringId::_Intern(const char* apString, size_t aLength, bool abInsert)
+        {
+            if (aLength == 0u) { return; }
+
+            const u64 kHash = Hash(apString, aLength);
+            const char* p = gsPool.Find(kHash, apString, aLength, abInsert);
+
+            if (p)
+            {
+                mHash = kHash;
+                mpString = p;
+            }
+        }
+
+    }
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SYSTEM_STRING_ID_H_
+#define _JZ_SYSTEM_STRING_ID_H_
+
+#include <jz_core/Prereqs.h>
+#include <string>
+
+namespace jz
+{
+    namespace system
+    {
+
+        // A string interned in a process wide pool, identified by its 64-bit hash. Equal
+        // strings intern to the same pool entry, so comparing two StringIds compares
+        // pointers and copying one never allocates. Pool entries are never freed.
+        //
+        // Construction from a string is implicit so that StringId can replace string
+        // arguments; each construction from a string costs one hash and one pool lookup.
+        class StringId sealed
+        {
+        public:
+            StringId()
+                : mHash(0u), mpString(null)
+            {}
+
+            StringId(const char* apString);
+            StringId(const char* apString, size_t aLength);
+            StringId(const string& aString);
+
+            bool empty() const { return (mpString == null); }
+            const char* c_str() const { return (mpString) ? mpString : ""; }
+            u64 GetHash() const { return mHash; }
+
+            bool operator==(const StringId& b) const { return (mpString == b.mpString); }
+            bool operator!=(const StringId& b) const { return (mpString != b.mpString); }
+            bool operator<(const StringId& b) const { return (mHash < b.mHash) || (mHash == b.mHash && mpString < b.mpString); }
+
+            // aPrefix followed by apSuffix, without building a temporary string.
+            static StringId Append(const StringId& aPrefix, const char* apSuffix);
+
+            // The id of apString if it has already been interned, otherwise an empty id.
+            static StringId Find(const char* apString, size_t aLength);
+
+            static u64 Hash(const char* apString, size_t aLength);
+
+        private:
+            u64 mHash;
+            const char* mpString;
+
+            void _Intern(const char* apString, size_t aLength, bool abInsert);
+        };
+
+    }
+}
+
+#endif
@@ -29,7 +29,9 @@
 
 namespace jz
 {
-    system::System* system::System::mspSingleton = null;
+#   if JZ_PLATFORM_WINDOWS
+        template <> system::System* Singleton<system::System>::mspSingleton = null;
+#   endif
     namespace system
     {
 
@@ -175,7 +177,7 @@ namespace jz
                                 }
                                 catch (std::exception& e)
                                 {
-                                    LogMessage(e.what(), Logger::kError);
+                                    JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                                 }
                             }
                             
@@ -188,7 +190,7 @@ namespace jz
                                 }
                                 catch (std::exception& e)
                                 {
-                                    LogMessage(e.what(), Logger::kError);
+                                    JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                                 }
                             }
                             
@@ -201,7 +203,7 @@ namespace jz
                                 }
                                 catch (std::exception& e)
                                 {
-                                    LogMessage(e.what(), Logger::kError);
+                                    JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                                 }
                             }
 
@@ -214,7 +216,7 @@ namespace jz
                                 }
                                 catch (std::exception& e)
                                 {
-                                    LogMessage(e.what(), Logger::kError);
+                                    JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                                 }
                             }
 
@@ -227,7 +229,7 @@ namespace jz
                                 }
                                 catch (std::exception& e)
                                 {
-                                    LogMessage(e.what(), Logger::kError);
+                                    JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                                 }
                             }
                         }
@@ -242,7 +244,7 @@ namespace jz
                             }
                             catch (std::exception& e)
                             {
-                                LogMessage(e.what(), Logger::kError);
+                                JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                             }
                         }
                         
@@ -256,7 +258,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         sKeys.push_back(aWordParam);
@@ -270,7 +272,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         return 0;
@@ -284,7 +286,7 @@ namespace jz
                             }
                             catch (std::exception& e)
                             {
-                                LogMessage(e.what(), Logger::kError);
+                                JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                             }
 
                             SetCapture(aWindowHandle);
@@ -310,7 +312,7 @@ namespace jz
                             }
                             catch (std::exception& e)
                             {
-                                LogMessage(e.what(), Logger::kError);
+                                JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                             }
 
                             return 0;
@@ -323,7 +325,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         SetCapture(aWindowHandle);
@@ -344,7 +346,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         return 0;
@@ -356,7 +358,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         SetCapture(aWindowHandle);
@@ -378,7 +380,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         return 0;
@@ -390,7 +392,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         SetCapture(aWindowHandle);
@@ -412,7 +414,7 @@ namespace jz
                         }
                         catch (std::exception& e)
                         {
-                            LogMessage(e.what(), Logger::kError);
+                            JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                         }
 
                         return 0;
@@ -436,7 +438,7 @@ namespace jz
                                 }
                                 catch (std::exception& e)
                                 {
-                                    LogMessage(e.what(), Logger::kError);
+                                    JZ_LOG(Logger::kSystem, Logger::kError, "%", e.what());
                                 }
                             }
                         }
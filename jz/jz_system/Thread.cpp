@@ -20,10 +20,22 @@
 // THE SOFTWARE.
 //
 
+#include <jz_system/Thread.h>
+
 #if JZ_MULTITHREADED
-#   include <jz_system/Thread.h>
 #   if JZ_PLATFORM_WINDOWS
 #       include <jz_system/Win32.h>
+#   else
+#       include <jz_core/Atomic.h>
+#       include <errno.h>
+#       include <sched.h>
+#       include <limits.h>
+#       include <sys/resource.h>
+#       include <time.h>
+#       include <unistd.h>
+#       if defined(__linux__)
+#           include <sys/syscall.h>
+#       endif
 #   endif
 
     namespace jz
@@ -31,6 +43,18 @@
         namespace system
         {
 
+            Thread::Thread(ThreadFunc aFunc)
+                : mFunc(aFunc), mbThreadDone(false)
+            {
+                _Start(kDefaultStackSize);
+            }
+            
+            Thread::Thread(ThreadFunc aFunc, size_t aStackSize)
+                : mFunc(aFunc), mbThreadDone(false)
+            {
+                _Start(aStackSize);
+            }
+
         #if JZ_PLATFORM_WINDOWS
                 DWORD WINAPI Thread::_ThreadStart(LPVOID apThread)
                 {
@@ -43,19 +67,11 @@
                     return 0u;
                 }
 
-
-                Thread::Thread(ThreadFunc aFunc)
-                    : mFunc(aFunc), mbThreadDone(false)
-                {
-                    DWORD d;
-                    mHandle = CreateThread(null, kDefaultStackSize, &_ThreadStart, this, 0u, &d);
-                }
-                
-                Thread::Thread(ThreadFunc aFunc, size_t aStackSize)
-                    : mFunc(aFunc), mbThreadDone(false)
+                void Thread::_Start(size_t aStackSize)
                 {
                     DWORD d;
                     mHandle = CreateThread(null, aStackSize, &_ThreadStart, this, 0u, &d);
+                    mId = d;
                 }
                 
                 Thread::~Thread()
@@ -66,7 +82,7 @@
                 
                 bool Thread::bCurrent() const
                 {
-                    return (mHandle == GetCurrentThread());
+                    return (mId == GetCurrentThreadId());
                 }
 
                 void Thread::SetPriority(Priority aPriority)
@@ -81,10 +97,110 @@
                     }
                 }
 
+                uint Thread::GetHardwareConcurrency()
+                {
+                    SYSTEM_INFO info;
+                    GetSystemInfo(&info);
+
+                    return jz::Max((uint)info.dwNumberOfProcessors, 1u);
+                }
+
                 void Thread::Sleep(ulong aMilliseconds)
                 {
                     ::Sleep(aMilliseconds);
                 }
+        #   else
+                // Unprivileged threads run under SCHED_OTHER, which has no priority range, so
+                // priorities map to per-thread nice values instead (Linux only, elsewhere nice
+                // is per process and the request is ignored). Raising priority above normal
+                // requires CAP_SYS_NICE and silently fails without it.
+                static const int kNiceValues[] = { 10, 0, -5, -10 };
+                static const s32 kNoPendingNice = Constants<int>::kMax;
+
+                static void _SetNice(long aId, int aNice)
+                {
+        #           if defined(__linux__)
+                        setpriority(PRIO_PROCESS, (id_t)aId, aNice);
+        #           endif
+                }
+
+                void_p Thread::_ThreadStart(void_p apThread)
+                {
+                    Thread* pThread = static_cast<Thread*>(apThread);
+
+        #           if defined(__linux__)
+                        pThread->mId = (long)syscall(SYS_gettid);
+        #           else
+                        pThread->mId = 1;
+        #           endif
+
+                    s32 nice = AtomicExchange(&(pThread->mPendingNice), kNoPendingNice);
+                    if (nice != kNoPendingNice) { _SetNice(pThread->mId, nice); }
+
+                    (pThread->mFunc)(*pThread);
+
+                    pThread->mbThreadDone = true;
+
+                    return null;
+                }
+
+                void Thread::_Start(size_t aStackSize)
+                {
+                    mId = 0;
+                    mPendingNice = kNoPendingNice;
+
+                    pthread_attr_t attr;
+                    pthread_attr_init(&attr);
+                    if (aStackSize > 0u) { pthread_attr_setstacksize(&attr, jz::Max(aStackSize, (size_t)PTHREAD_STACK_MIN)); }
+                    pthread_create(&mHandle, &attr, &_ThreadStart, this);
+                    pthread_attr_destroy(&attr);
+                }
+
+                Thread::~Thread()
+                {
+                    pthread_join(mHandle, null);
+                }
+
+                bool Thread::bCurrent() const
+                {
+                    return (pthread_equal(mHandle, pthread_self()) != 0);
+                }
+
+                void Thread::SetPriority(Priority aPriority)
+                {
+                    if (aPriority < kLow || aPriority > kCritical) { return; }
+
+                    int nice = kNiceValues[aPriority];
+
+                    // If the thread has not yet published its id, it applies the value on start.
+                    AtomicExchange(&mPendingNice, nice);
+                    if (mId != 0 && AtomicExchange(&mPendingNice, kNoPendingNice) != kNoPendingNice)
+                    {
+                        _SetNice(mId, nice);
+                    }
+                }
+
+                uint Thread::GetHardwareConcurrency()
+                {
+                    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+                    return (count > 0) ? (uint)count : 1u;
+                }
+
+                void Thread::Sleep(ulong aMilliseconds)
+                {
+                    if (aMilliseconds == 0u)
+                    {
+                        sched_yield();
+                        return;
+                    }
+
+                    timespec t;
+                    t.tv_sec = (time_t)(aMilliseconds / 1000u);
+                    t.tv_nsec = (long)((aMilliseconds % 1000u) * 1000000u);
+
+                    while (nanosleep(&t, &t) != 0 && errno == EINTR) ;
+                }
         #   endif
 
         }
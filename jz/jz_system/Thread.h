@@ -24,12 +24,15 @@
 #ifndef _JZ_SYSTEM_THREAD_H_
 #define _JZ_SYSTEM_THREAD_H_
 
+#include <jz_core/Prereqs.h>
+
 #if JZ_MULTITHREADED
-#   include <jz_core/Prereqs.h>
 #   include <functional>
 
 #   if JZ_PLATFORM_WINDOWS
         typedef jz::void_p HANDLE;
+#   else
+#       include <pthread.h>
 #   endif
 
     namespace jz
@@ -48,7 +51,10 @@
                         kCritical = 3
                     };
                 
-                    static const size_t kDefaultStackSize = (1 << 15);
+                    // 0 leaves the stack to the platform: the size linked into the executable on
+                    // Windows, the pthread default elsewhere. On Windows a size is only the initial
+                    // commit, on POSIX it is a hard limit, so job and IO threads use the default.
+                    static const size_t kDefaultStackSize = 0u;
                 
                     typedef tr1::function<void(const Thread&)> ThreadFunc;
                 
@@ -61,21 +67,33 @@
 
                     void SetPriority(Priority aPriority);
 
+                    static uint GetHardwareConcurrency();
                     static void Sleep(ulong aMilliseconds);
 
                 private:
         #           if JZ_PLATFORM_WINDOWS
                         static unsigned long __stdcall _ThreadStart(void_p apThread);
+        #           else
+                        static void_p _ThreadStart(void_p apThread);
         #           endif
         	            
                     Thread(const Thread&);
                     Thread& operator=(const Thread&);
                     
+                    void _Start(size_t aStackSize);
+
                     ThreadFunc mFunc;
                     
                     volatile bool mbThreadDone;
                     
-                    HANDLE mHandle;
+        #           if JZ_PLATFORM_WINDOWS
+                        HANDLE mHandle;
+                        unsigned long mId;
+        #           else
+                        pthread_t mHandle;
+                        volatile long mId;
+                        volatile s32 mPendingNice;
+        #           endif
             };
 
         }
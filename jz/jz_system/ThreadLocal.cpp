@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#include <jz_system/ThreadLocal.h>
+
+#if JZ_MULTITHREADED
+#   if JZ_PLATFORM_WINDOWS
+#       include <jz_system/Win32.h>
+#   endif
+
+    namespace jz
+    {
+        namespace system
+        {
+
+        #   if JZ_PLATFORM_WINDOWS
+                ThreadLocalBase::ThreadLocalBase()
+                    : mKey(TlsAlloc())
+                {
+                    if (mKey == TLS_OUT_OF_INDEXES) { throw JZ_EXCEPTION("out of thread local storage indices."); }
+                }
+
+                ThreadLocalBase::~ThreadLocalBase()
+                {
+                    TlsFree(mKey);
+                }
+
+                void_p ThreadLocalBase::GetValue() const
+                {
+                    return TlsGetValue(mKey);
+                }
+
+                void ThreadLocalBase::SetValue(void_p p)
+                {
+                    TlsSetValue(mKey, p);
+                }
+        #   else
+                ThreadLocalBase::ThreadLocalBase()
+                {
+                    if (pthread_key_create(&mKey, null) != 0) { throw JZ_EXCEPTION("out of thread local storage keys."); }
+                }
+
+                ThreadLocalBase::~ThreadLocalBase()
+                {
+                    pthread_key_delete(mKey);
+                }
+
+                void_p ThreadLocalBase::GetValue() const
+                {
+                    return pthread_getspecific(mKey);
+                }
+
+                void ThreadLocalBase::SetValue(void_p p)
+                {
+                    pthread_setspecific(mKey, p);
+                }
+        #   endif
+
+        }
+    }
+#endif
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2009 Joseph A. Zupko
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+
+#pragma once
+#ifndef _JZ_SYSTEM_THREAD_LOCAL_H_
+#define _JZ_SYSTEM_THREAD_LOCAL_H_
+
+#include <jz_core/Prereqs.h>
+
+#if JZ_MULTITHREADED
+#   if JZ_PLATFORM_POSIX
+#       include <pthread.h>
+#   endif
+
+    namespace jz
+    {
+        namespace system
+        {
+
+            // A pointer with a separate value per thread, initially null on every thread.
+            // Unlike JZ_THREAD_LOCAL, can be a non-static member and works from DLLs that
+            // are loaded at runtime. The pointed to objects are not owned.
+            class ThreadLocalBase
+            {
+                public:
+                    ThreadLocalBase();
+                    ~ThreadLocalBase();
+
+                    void_p GetValue() const;
+                    void SetValue(void_p p);
+
+                private:
+                    ThreadLocalBase(const ThreadLocalBase&);
+                    ThreadLocalBase& operator=(const ThreadLocalBase&);
+
+        #           if JZ_PLATFORM_WINDOWS
+                        ulong mKey;
+        #           else
+                        pthread_key_t mKey;
+        #           endif
+            };
+
+            template <typename T>
+            class ThreadLocal : public ThreadLocalBase
+            {
+                public:
+                    T* Get() const { return static_cast<T*>(GetValue()); }
+                    void Set(T* p) { SetValue(p); }
+
+                    T* operator->() const { return Get(); }
+            };
+
+        }
+    }
+#endif
+
+#endif
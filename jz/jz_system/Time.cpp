@@ -22,14 +22,41 @@
 
 #include <jz_system/Time.h>
 
+#if JZ_PLATFORM_POSIX
+#   include <sched.h>
+#   include <time.h>
+#endif
+
 namespace jz
 {
 
-    system::Time* system::Time::mspSingleton = 0;
+    template <> system::Time* Singleton<system::Time>::mspSingleton = 0;
     namespace system
     {
 
+        static void _Sleep(s64 aNanoseconds)
+        {
+#           if JZ_PLATFORM_WINDOWS
+                ::Sleep((DWORD)(aNanoseconds / Time::kNanosecondsPerMillisecond));
+#           else
+                timespec t;
+                t.tv_sec = (time_t)(aNanoseconds / Time::kNanosecondsPerSecond);
+                t.tv_nsec = (long)(aNanoseconds % Time::kNanosecondsPerSecond);
+                nanosleep(&t, null);
+#           endif
+        }
+
+        static void _Yield()
+        {
+#           if JZ_PLATFORM_WINDOWS
+                SwitchToThread();
+#           else
+                sched_yield();
+#           endif
+        }
+
         Time::Time()
+            : mFrameNanoseconds(0), mFrameLimit(0u)
         {
             Reset();
             Tick();
@@ -38,54 +65,132 @@ namespace jz
         Time::~Time()
         {}
 
-#   if JZ_PLATFORM_WINDOWS
+        s64 Time::GetAbsoluteNanoseconds() const
+        {
+            return _GetCounterNanoseconds();
+        }
+
         unatural Time::GetAbsoluteMilliseconds() const
         {
-            LARGE_INTEGER currentTime;
-            QueryPerformanceCounter(&currentTime);
+            return (unatural)(_GetCounterNanoseconds() / kNanosecondsPerMillisecond);
+        }
 
-            LONGLONG tick = (currentTime.QuadPart - mCounterStartTime.QuadPart);
-            
-            return (unatural)((float)(double(tick) / double(mCounterFrequency.QuadPart)) * 1000.0f);
+        double Time::GetElapsedSecondsPrecise() const
+        {
+            return (double(mTickTime - mLastTime) / double(kNanosecondsPerSecond));
         }
 
         float Time::GetElapsedSeconds() const
         {
-            return (float)(double(mCounterTickTime - mCounterLastTime) / double(mCounterFrequency.QuadPart));
+            return (float)GetElapsedSecondsPrecise();
+        }
+
+        unatural Time::GetMilliseconds() const
+        {
+            return (unatural)(mTickTime / kNanosecondsPerMillisecond);
+        }
+
+        double Time::GetSecondsPrecise() const
+        {
+            return (double(mTickTime) / double(kNanosecondsPerSecond));
         }
 
         float Time::GetSeconds() const
         {
-            return (float)(double(mCounterTickTime) / double(mCounterFrequency.QuadPart));
+            return (float)GetSecondsPrecise();
         }
 
-        unatural Time::GetMilliseconds() const
+        void Time::SetFrameLimit(uint aFramesPerSecond)
         {
-            return (unatural)((float)(double(mCounterTickTime) / double(mCounterFrequency.QuadPart)) * 1000.0f);            
+            mFrameLimit = aFramesPerSecond;
+            mFrameNanoseconds = (aFramesPerSecond > 0u) ? (kNanosecondsPerSecond / aFramesPerSecond) : 0;
         }
 
         void Time::Reset()
         {
-            QueryPerformanceFrequency(&mCounterFrequency);
-            QueryPerformanceCounter(&mCounterStartTime);
-            mCounterLastTime = 0;
-            mCounterTickTime = 0;
+#           if JZ_PLATFORM_WINDOWS
+                QueryPerformanceFrequency(&mCounterFrequency);
+                QueryPerformanceCounter(&mCounterStartTime);
+#           else
+                mCounterStartTime = 0;
+                mCounterStartTime = _GetCounterNanoseconds();
+#           endif
+
+            mLastTime = 0;
+            mTickTime = 0;
         }
-        
+
         void Time::Tick()
         {
-            Update();
+            if (mFrameNanoseconds > 0) { _WaitForFrame(); }
+
+            mLastTime = mTickTime;
+            mTickTime = _GetCounterNanoseconds();
         }
-        
-        void Time::Update()
+
+        s64 Time::_GetCounterNanoseconds() const
+        {
+#           if JZ_PLATFORM_WINDOWS
+                LARGE_INTEGER currentTime;
+                QueryPerformanceCounter(&currentTime);
+
+                // Split into whole seconds and remainder, ticks * 1e9 overflows after a
+                // few days at common counter frequencies.
+                const s64 kTicks = (currentTime.QuadPart - mCounterStartTime.QuadPart);
+                const s64 kFrequency = mCounterFrequency.QuadPart;
+
+                return ((kTicks / kFrequency) * kNanosecondsPerSecond) +
+                    (((kTicks % kFrequency) * kNanosecondsPerSecond) / kFrequency);
+#           else
+                timespec t;
+                clock_gettime(CLOCK_MONOTONIC, &t);
+
+                return (((s64)t.tv_sec * kNanosecondsPerSecond) + (s64)t.tv_nsec) - mCounterStartTime;
+#           endif
+        }
+
+        void Time::_WaitForFrame()
+        {
+            const s64 kTarget = (mTickTime + mFrameNanoseconds);
+
+            for (s64 remaining = (kTarget - _GetCounterNanoseconds()); remaining > 0; remaining = (kTarget - _GetCounterNanoseconds()))
+            {
+                if (remaining > kSpinNanoseconds) { _Sleep(remaining - kSpinNanoseconds); }
+                else { _Yield(); }
+            }
+        }
+
+        FixedTimestep::FixedTimestep(s64 aStepNanoseconds, uint aMaxSteps)
+            : mStepNanoseconds(aStepNanoseconds), mAccumulator(0), mStepCount(0u), mMaxSteps(aMaxSteps)
         {
-            LARGE_INTEGER currentTime;
-            QueryPerformanceCounter(&currentTime);
+            JZ_ASSERT(aStepNanoseconds > 0);
+            JZ_ASSERT(aMaxSteps > 0u);
+        }
+
+        uint FixedTimestep::Advance(s64 aElapsedNanoseconds)
+        {
+            const s64 kMaxAccumulator = (mStepNanoseconds * (s64)mMaxSteps);
 
-            mCounterLastTime = mCounterTickTime;
-            mCounterTickTime = (currentTime.QuadPart - mCounterStartTime.QuadPart);
+            mAccumulator += Max(aElapsedNanoseconds, (s64)0);
+            if (mAccumulator > kMaxAccumulator) { mAccumulator = kMaxAccumulator; }
+
+            const uint kSteps = (uint)(mAccumulator / mStepNanoseconds);
+            mAccumulator -= (mStepNanoseconds * (s64)kSteps);
+            mStepCount += kSteps;
+
+            return kSteps;
+        }
+
+        float FixedTimestep::GetAlpha() const
+        {
+            return (float)(double(mAccumulator) / double(mStepNanoseconds));
+        }
+
+        void FixedTimestep::Reset()
+        {
+            mAccumulator = 0;
+            mStepCount = 0u;
         }
-#   endif
 
     }
 }
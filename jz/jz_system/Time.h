@@ -39,26 +39,89 @@ namespace jz
         class Time : public Singleton<Time>
         {
             public:
+                static const s64 kNanosecondsPerSecond = 1000000000;
+                static const s64 kNanosecondsPerMillisecond = 1000000;
+
                 Time();
                 ~Time();
 
+                JZ_EXPORT s64 GetAbsoluteNanoseconds() const;
                 JZ_EXPORT unatural GetAbsoluteMilliseconds() const;
+
+                // Time between the last two calls to Tick().
+                JZ_EXPORT s64 GetElapsedNanoseconds() const { return (mTickTime - mLastTime); }
+                JZ_EXPORT double GetElapsedSecondsPrecise() const;
                 JZ_EXPORT float GetElapsedSeconds() const;
+
+                // Time from Reset() to the last call to Tick(). The float variant loses
+                // precision after a few hours of uptime, prefer the precise one for anything
+                // that accumulates.
+                JZ_EXPORT s64 GetNanoseconds() const { return mTickTime; }
                 JZ_EXPORT unatural GetMilliseconds() const;
+                JZ_EXPORT double GetSecondsPrecise() const;
                 JZ_EXPORT float GetSeconds() const;
 
+                // Caps the rate of Tick() by waiting out the remainder of each frame. The
+                // wait sleeps while more than kSpinNanoseconds remain and busy-waits the
+                // tail, since sleep granularity is too coarse to hit the target alone.
+                // 0 disables the limiter.
+                static const s64 kSpinNanoseconds = (2 * kNanosecondsPerMillisecond);
+                JZ_EXPORT uint GetFrameLimit() const { return mFrameLimit; }
+                JZ_EXPORT void SetFrameLimit(uint aFramesPerSecond);
+
                 void Reset();
                 JZ_EXPORT void Tick();
 
             private:
     #           if JZ_PLATFORM_WINDOWS        
-                    LARGE_INTEGER mCounterStartTime;
                     LARGE_INTEGER mCounterFrequency;
-                    LONGLONG      mCounterLastTime;
-                    LONGLONG      mCounterTickTime;
+                    LARGE_INTEGER mCounterStartTime;
+    #           else
+                    s64 mCounterStartTime;
     #           endif
-                
-                void Update();
+
+                s64 mLastTime;
+                s64 mTickTime;
+                s64 mFrameNanoseconds;
+                uint mFrameLimit;
+
+                s64 _GetCounterNanoseconds() const;
+                void _WaitForFrame();
+        };
+
+        /// <summary>
+        /// Fixed-timestep scheduler. Accumulates frame time in integer nanoseconds so the
+        /// number of steps taken for a given sequence of frames is exact and reproducible.
+        /// </summary>
+        /// <remarks>
+        /// After a long stall the accumulator is clamped to aMaxSteps steps and the rest of
+        /// the time is dropped, so a slow frame cannot start a spiral of ever-longer frames.
+        /// </remarks>
+        class FixedTimestep sealed
+        {
+            public:
+                static const uint kDefaultMaxSteps = 8u;
+
+                FixedTimestep(s64 aStepNanoseconds, uint aMaxSteps = kDefaultMaxSteps);
+
+                // Adds frame time and returns the number of steps to take this frame.
+                uint Advance(s64 aElapsedNanoseconds);
+
+                // Fraction of a step left in the accumulator, for interpolating between
+                // the previous and current simulation states.
+                float GetAlpha() const;
+
+                u64 GetStepCount() const { return mStepCount; }
+                s64 GetStepNanoseconds() const { return mStepNanoseconds; }
+                float GetStepSeconds() const { return (float)(double(mStepNanoseconds) / double(Time::kNanosecondsPerSecond)); }
+
+                void Reset();
+
+            private:
+                s64 mStepNanoseconds;
+                s64 mAccumulator;
+                u64 mStepCount;
+                uint mMaxSteps;
         };
 
     }
@@ -30,10 +30,16 @@ namespace jz
     namespace system
     {
 
-        void TriangleTree::Node::Read(IReadFilePtr& p)
+        void TriangleTree::Node::ReadNodes(IReadFilePtr& p, Node* apOut, size_t aCount)
         {
-            mFlags = ReadUInt32(p);
-            Sibling = ReadUInt32(p);
+            MemoryBuffer<u32> buf(aCount * 2u);
+            ReadArray(p, buf.Get(), buf.size());
+
+            for (size_t i = 0u; i < aCount; i++)
+            {
+                apOut[i].mFlags = buf[(i * 2u) + 0u];
+                apOut[i].Sibling = buf[(i * 2u) + 1u];
+            }
         }
 
         Vector3 TriangleTree::CalculateMean(const vector<u32>& e)
@@ -245,12 +251,10 @@ namespace jz
             ReadBuffer(pFile, mVertices);
 
             size_t size = ReadSizeT(pFile);
-            for (size_t i = 0u; i < size; i++)
+            if (size > 0u)
             {
-                Node node;
-                node.Read(pFile);
-
-                mNodes.push_back(node);
+                mNodes.resize(size);
+                Node::ReadNodes(pFile, &(mNodes[0]), size);
             }
 
             mTotalAABB = ReadBoundingBox(pFile);
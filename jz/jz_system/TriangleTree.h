@@ -90,7 +90,8 @@ namespace jz
                 void SetFront() { mFlags |= kFbMask; }
                 void SetLeaf() { mFlags |= kLeafMask; }
 
-                void Read(IReadFilePtr& p);
+                // Nodes are stored as (flags, sibling) pairs, read with one call.
+                static void ReadNodes(IReadFilePtr& p, Node* apOut, size_t aCount);
 
                 union
                 {
@@ -26,6 +26,11 @@
 
 #include <jz_system/Win32Resource.h>
 
+// Condition variables and slim reader/writer locks require Vista.
+#ifndef _WIN32_WINNT
+#   define _WIN32_WINNT 0x0600
+#endif
+
 #define NOGDICAPMASKS
 #define NOVIRTUALKEYCODES
 #define NOMENUS
@@ -29,105 +29,113 @@ namespace jz
     namespace system
     {
 
+        void WriteSwapped(IWriteFilePtr& p, voidc_p apIn, size_t aWordSize, size_t aCount)
+        {
+            static const size_t kChunkSize = (1 << 10);
+
+            u8 buf[kChunkSize];
+            const size_t kPerChunk = (kChunkSize / aWordSize);
+            u8c_p pIn = (u8c_p)apIn;
+
+            while (aCount > 0u)
+            {
+                const size_t kCount = Min(aCount, kPerChunk);
+                const size_t kSizeInBytes = (kCount * aWordSize);
+
+                memcpy(buf, pIn, kSizeInBytes);
+                SwapByteOrder(buf, aWordSize, kCount);
+                JZ_E_ON_FAIL(p->Write(buf, kSizeInBytes) == kSizeInBytes, "write failed.");
+
+                pIn += kSizeInBytes;
+                aCount -= kCount;
+            }
+        }
+
         void WriteBoolean(IWriteFilePtr& p, bool v)
         {
-            const size_t kSize = (sizeof(u8));
-            u8 val = (v) ? (u8)1u : (u8)0u;
+            const u8 kVal = (v) ? (u8)1u : (u8)0u;
 
-            JZ_E_ON_FAIL(p->Write(&val, kSize) == kSize, "failed writing boolean.");            
+            WriteValue(p, kVal);
         }
 
         void WriteBoundingBox(IWriteFilePtr& p, const BoundingBox& v)
         {
-            WriteVector3(p, v.Min);
-            WriteVector3(p, v.Max);
+            JZ_STATIC_ASSERT(sizeof(BoundingBox) == sizeof(f32) * 6);
+
+            WriteValue(p, v);
         }
 
         void WriteBoundingSphere(IWriteFilePtr& p, const BoundingSphere& v)
         {
-            WriteVector3(p, v.Center);
-            WriteSingle(p, v.Radius);
+            JZ_STATIC_ASSERT(sizeof(BoundingSphere) == sizeof(f32) * 4);
+
+            WriteValue(p, v);
         }
 
         void WriteString(IWriteFilePtr& p, const string& v)
         {
             const u32 kSize = (v.size() + 1u);
-            JZ_E_ON_FAIL(p->Write(&kSize, sizeof(u32)) == sizeof(u32), "failed writing string size.");
-            MemoryBuffer<char> buf(kSize);
-            buf.CopyFrom(v.c_str(), v.size());
-            buf[v.size()] = 0;
 
-            JZ_E_ON_FAIL(p->Write(buf.Get(), kSize) == kSize, "failed writing string contents.");
+            // Includes null terminator.
+            WriteValue(p, kSize);
+            WriteArray(p, v.c_str(), kSize);
         }
 
         void WriteMatrix3(IWriteFilePtr& p, const Matrix3& v)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            const size_t kSize = sizeof(f32) * 9;
+            JZ_STATIC_ASSERT(sizeof(Matrix3) == sizeof(f32) * 9);
 
-            JZ_E_ON_FAIL(p->Write(v.pData, kSize) == kSize, "failed writing matrix 3.");
+            WriteValue(p, v);
         }
 
         void WriteMatrix4(IWriteFilePtr& p, const Matrix4& v)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            const size_t kSize = sizeof(f32) * 16;
+            JZ_STATIC_ASSERT(sizeof(Matrix4) == sizeof(f32) * 16);
 
-            JZ_E_ON_FAIL(p->Write(v.pData, kSize) == kSize, "failed writing matrix 4.");
+            WriteValue(p, v);
         }
 
         void WriteSingle(IWriteFilePtr& p, float v)
         {
             JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            const size_t kSize = sizeof(f32) * 1;
 
-            JZ_E_ON_FAIL(p->Write(&v, kSize) == kSize, "failed writing single.");
+            WriteValue(p, v);
         }
 
         void WriteInt32(IWriteFilePtr& p, s32 v)
         {
-            const size_t kSize = sizeof(s32) * 1;
-
-            JZ_E_ON_FAIL(p->Write(&v, kSize) == kSize, "failed writing single.");
+            WriteValue(p, v);
         }
 
         void WriteUInt32(IWriteFilePtr& p, u32 v)
         {
-            const size_t kSize = (sizeof(u32) * 1);
-
-            JZ_E_ON_FAIL(p->Write(&v, kSize) == kSize, "failed writing u32.");
+            WriteValue(p, v);
         }
 
         void WriteSizeT(IWriteFilePtr& p, size_t v)
         {
-            JZ_STATIC_ASSERT(sizeof(size_t) == sizeof(u32));
-            const size_t kSize = sizeof(u32) * 1;
-
-            JZ_E_ON_FAIL(p->Write(&v, kSize) == kSize, "failed writing single.");
+            WriteValue(p, (u32)v);
         }
 
         void WriteVector2(IWriteFilePtr& p, const Vector2& v)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            const size_t kSize = sizeof(f32) * 2;
+            JZ_STATIC_ASSERT(sizeof(Vector2) == sizeof(f32) * 2);
 
-            JZ_E_ON_FAIL(p->Write(v.pData, kSize) == kSize, "failed writing vector 2.");
+            WriteValue(p, v);
         }
 
         void WriteVector3(IWriteFilePtr& p, const Vector3& v)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            const size_t kSize = sizeof(f32) * 3;
+            JZ_STATIC_ASSERT(sizeof(Vector3) == sizeof(f32) * 3);
 
-            JZ_E_ON_FAIL(p->Write(v.pData, kSize) == kSize, "failed writing vector 3.");
+            WriteValue(p, v);
         }
 
         void WriteVector4(IWriteFilePtr& p, const Vector4& v)
         {
-            JZ_STATIC_ASSERT(sizeof(float) == sizeof(f32));
-            const size_t kSize = sizeof(f32) * 4;
+            JZ_STATIC_ASSERT(sizeof(Vector4) == sizeof(f32) * 4);
 
-            JZ_E_ON_FAIL(p->Write(v.pData, kSize) == kSize, "failed writing vector 4.");
+            WriteValue(p, v);
         }
 
         void WriteTextLine(IWriteFilePtr& p, const string& v)
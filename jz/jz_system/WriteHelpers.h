@@ -31,6 +31,7 @@
 #include <jz_core/Vector2.h>
 #include <jz_core/Vector3.h>
 #include <jz_core/Vector4.h>
+#include <jz_system/ReadHelpers.h>
 #include <string>
 
 namespace jz
@@ -39,6 +40,31 @@ namespace jz
     {
 
         class IWriteFile; typedef AutoPtr<IWriteFile> IWriteFilePtr;
+
+        void WriteSwapped(IWriteFilePtr& p, voidc_p apIn, size_t aWordSize, size_t aCount);
+
+        // Writes aCount contiguous elements of T with a single Write. Byte order follows
+        // ByteOrder<T>, see ReadHelpers.h.
+        template <typename T>
+        void WriteArray(IWriteFilePtr& p, const T* apIn, size_t aCount)
+        {
+            const size_t kSizeInBytes = (aCount * sizeof(T));
+
+            if (kSizeInBytes > 0u)
+            {
+#               if JZ_BIG_ENDIAN
+                    WriteSwapped(p, apIn, ByteOrder<T>::kWordSize, (kSizeInBytes / ByteOrder<T>::kWordSize));
+#               else
+                    JZ_E_ON_FAIL(p->Write(apIn, kSizeInBytes) == kSizeInBytes, "write failed.");
+#               endif
+            }
+        }
+
+        template <typename T>
+        void WriteValue(IWriteFilePtr& p, const T& v)
+        {
+            WriteArray(p, &v, 1u);
+        }
      
         void WriteBoolean(IWriteFilePtr& p, bool v);
         void WriteBoundingBox(IWriteFilePtr& p, const BoundingBox& v);
@@ -58,13 +84,9 @@ namespace jz
         void WriteBuffer(IWriteFilePtr& p, const MemoryBuffer<T>& aOut)
         {
             const size_t kSize = aOut.size();
-            const size_t kSizeInBytes = aOut.GetSizeInBytes();
 
             WriteSizeT(p, kSize);
-            if (kSize > 0u)
-            {
-                JZ_E_ON_FAIL(p->Write(aOut.Get(), kSizeInBytes) == kSizeInBytes, "write failed.");
-            }
+            WriteArray(p, aOut.Get(), kSize);
         }
 
         void WriteTextLine(IWriteFilePtr& p, const string& s);
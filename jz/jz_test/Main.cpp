@@ -19,27 +19,38 @@ int main(int argc, char** argv)
 {
     using namespace jz;
 
-#   ifndef NDEBUG
+#   if JZ_PLATFORM_WINDOWS && !defined(NDEBUG)
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #   endif
  
     std::ofstream ocf(jz::gskpLogFilename);
     std::ofstream oef(jz::gskpErrorLogFilename);
 
+    // The original buffers are restored before the files close, anything written to
+    // cout or cerr during static destruction would otherwise go to a dead buffer.
+    std::streambuf* pCoutBuffer = std::cout.rdbuf();
+    std::streambuf* pCerrBuffer = std::cerr.rdbuf();
+
     if (ocf.is_open() && !ocf.fail()) { std::cout.rdbuf(ocf.rdbuf()); }
     if (oef.is_open() && !oef.fail()) { std::cerr.rdbuf(oef.rdbuf()); }
 
+    int ret = 0;
     try
     {
         tut::reporter r;
         tut::runner.get().set_callback(&r);
         tut::runner.get().run_tests();  
+
+        if (!r.all_ok()) { ret = 1; }
     }
     catch (std::exception& e)
     {
         std::cerr << e.what() << std::endl;
-        return 1;
+        ret = 1;
     }
 
-    return 0;
+    std::cout.rdbuf(pCoutBuffer);
+    std::cerr.rdbuf(pCerrBuffer);
+
+    return ret;
 }
@@ -47,8 +47,8 @@ namespace tut
     template<> template<>
     void Object::test<1>()
     {
-        vector<u16> adj(AStar<u16, 3>::kMaxNodes);
-        for (size_t i = 0u; i < AStar<u16, 3>::kMaxNodes; i++) { adj[i] = AStar<u16, 3>::kNullNode; }
+        vector<u16> adj(7u * 3u);
+        for (size_t i = 0u; i < adj.size(); i++) { adj[i] = AStar<u16, 3>::kNullNode; }
 
         adj[(0*3)+0] = 1u; adj[(0*3)+1] = 6u;
         adj[(1*3)+0] = 0u; adj[(1*3)+1] = 2u;
@@ -0,0 +1,206 @@
+#include <jz_core/Matrix4.h>
+#include <jz_core/Quaternion.h>
+#include <jz_engine_3D/Animation.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsAnimation);
+
+    using namespace jz;
+    using namespace jz::engine_3D;
+
+    static const size_t kKeyCount = 300u;
+    static const float kFramesPerSecond = 30.0f;
+
+    static Matrix4 Transform(const Vector3& aScale, const Quaternion& aRotation, const Vector3& aTranslation)
+    {
+        Matrix4 rotation = Matrix4::kIdentity;
+        ToTransform(aRotation, rotation);
+
+        return (Matrix4::CreateScale(aScale) * rotation * Matrix4::CreateTranslation(aTranslation));
+    }
+
+    static void AddKey(Animation& a, size_t i, const Matrix4& m)
+    {
+        a.KeyFrames[i].Key = m;
+        a.KeyFrames[i].TimeAndPadding = Vector4((float)i / kFramesPerSecond, 0.0f, 0.0f, 0.0f);
+    }
+
+    // The 300 key clip: a turn and a half about a skewed axis, at a varying rate, along
+    // a curved path.
+    static void CreateClip(const Vector3& aScale, Animation& a)
+    {
+        const Vector3 kAxis = Vector3::Normalize(Vector3(1.0f, 2.0f, 3.0f));
+
+        a.KeyFrames.resize(kKeyCount);
+        for (size_t i = 0u; i < kKeyCount; i++)
+        {
+            const float kT = ((float)i / (float)(kKeyCount - 1u));
+            const float kAngle = (1.5f * Constants<float>::kTwoPi * kT * kT);
+            const Vector3 kTranslation(Sin(Radian(3.0f * kT)), 2.0f * Cos(Radian(3.0f * kT)), 0.5f * kT);
+
+            AddKey(a, i, Transform(aScale, Quaternion(kAxis, Radian(kAngle)), kTranslation));
+        }
+    }
+
+    // Largest difference of the rotation and scale part, and of the translation.
+    static void GetError(const Matrix4& a, const Matrix4& b, float& arBasis, float& arTranslation)
+    {
+        arBasis = 0.0f;
+        arTranslation = 0.0f;
+
+        for (int r = 0; r < 3; r++)
+        {
+            for (int c = 0; c < 3; c++) { arBasis = Max(arBasis, Abs(a(r, c) - b(r, c))); }
+        }
+
+        arTranslation = Vector3::Distance(a.GetTranslation(), b.GetTranslation());
+    }
+
+    static float Determinant3(const Matrix4& m)
+    {
+        const Vector3 kR0(m.M11, m.M12, m.M13);
+        const Vector3 kR1(m.M21, m.M22, m.M23);
+        const Vector3 kR2(m.M31, m.M32, m.M33);
+
+        return Vector3::Dot(Vector3::Cross(kR0, kR1), kR2);
+    }
+
+    // The tolerance bounds the distance between unit quaternions, and matrix elements are
+    // quadratic in the quaternion. An element such as 1 - 2(y^2 + z^2) has a gradient of
+    // length up to 4, so a quaternion error of 1e-3 can move it by 4e-3. 16 bit
+    // quantization adds about 3e-5. Translation is stored as is, so its error is within
+    // the tolerance.
+    static const float kBasisBound = (4.0f * Animation::kDefaultTolerance) + 1e-4f;
+    static const float kTranslationBound = (Animation::kDefaultTolerance + 1e-5f);
+
+    static void CheckRoundTrip(const Animation& aOriginal, const Animation& aCompressed)
+    {
+        for (size_t i = 0u; i < kKeyCount; i++)
+        {
+            Matrix4 m;
+            aCompressed.Sample(i, aCompressed.GetTime(i), m);
+
+            float basis, translation;
+            GetError(m, aOriginal.KeyFrames[i].Key, basis, translation);
+            ensure(basis <= kBasisBound);
+            ensure(translation <= kTranslationBound);
+        }
+    }
+
+    // Round trip of the test clip at every key, within the bounds above.
+    template<> template<>
+    void Object::test<1>()
+    {
+        Animation original;
+        CreateClip(Vector3::kOne, original);
+
+        Animation a(original);
+        a.Compress();
+
+        ensure(a.bCompressed());
+        ensure_equals(a.GetKeyCount(), kKeyCount);
+        ensure_equals(a.KeyFrames.size(), 0u);
+
+        ensure(a.GetRotationKeyCount() < (kKeyCount / 4u));
+        ensure(a.GetTranslationKeyCount() < (kKeyCount / 4u));
+        ensure_equals(a.GetScaleKeyCount(), 1u);
+
+        for (size_t i = 0u; i < kKeyCount; i++) { ensure_equals(a.GetTime(i), original.KeyFrames[i].TimeAndPadding.X); }
+
+        CheckRoundTrip(original, a);
+    }
+
+    // Channels that never change keep one key, and sample to that value everywhere.
+    template<> template<>
+    void Object::test<2>()
+    {
+        const Quaternion kRotation(Vector3::kUnitY, Radian(0.75f));
+        const Vector3 kScale(1.0f, 2.0f, 3.0f);
+        const Vector3 kTranslation(4.0f, 5.0f, 6.0f);
+        const Matrix4 kKey = Transform(kScale, kRotation, kTranslation);
+
+        Animation a;
+        a.KeyFrames.resize(kKeyCount);
+        for (size_t i = 0u; i < kKeyCount; i++) { AddKey(a, i, kKey); }
+
+        a.Compress();
+        ensure_equals(a.GetRotationKeyCount(), 1u);
+        ensure_equals(a.GetTranslationKeyCount(), 1u);
+        ensure_equals(a.GetScaleKeyCount(), 1u);
+
+        for (size_t i = 0u; i < kKeyCount; i += 7u)
+        {
+            AnimationPose pose;
+            a.Sample(i, a.GetTime(i) + (0.5f / kFramesPerSecond), pose);
+
+            ensure(Vector3::Distance(pose.Translation, kTranslation) <= 1e-5f);
+            ensure(Vector3::Distance(pose.Scale, kScale) <= 1e-4f);
+            ensure(Min((pose.Rotation - kRotation).Length(), (pose.Rotation + kRotation).Length()) <= 1e-4f);
+        }
+    }
+
+    // A mirrored basis round trips with its handedness.
+    template<> template<>
+    void Object::test<3>()
+    {
+        const Vector3 kMirror(-1.0f, 1.0f, 1.0f);
+
+        Animation original;
+        CreateClip(kMirror, original);
+        ensure(Determinant3(original.KeyFrames[0].Key) < 0.0f);
+
+        Animation a(original);
+        a.Compress();
+
+        ensure_equals(a.GetScaleKeyCount(), 1u);
+        CheckRoundTrip(original, a);
+
+        for (size_t i = 0u; i < kKeyCount; i += 13u)
+        {
+            Matrix4 m;
+            a.Sample(i, a.GetTime(i), m);
+            ensure(Determinant3(m) < 0.0f);
+        }
+    }
+
+    // ToQuaternion() returns rotations about Y past 240 degrees in the other hemisphere,
+    // where the trace changes sign. Sampling between keys across that flip still takes
+    // the short way round, so midpoints stay close to the rotation halfway between.
+    template<> template<>
+    void Object::test<4>()
+    {
+        static const float kStep = (Constants<float>::kTwoPi / 40.0f);
+
+        Animation a;
+        a.KeyFrames.resize(kKeyCount);
+
+        size_t flips = 0u;
+        Quaternion previous;
+        for (size_t i = 0u; i < kKeyCount; i++)
+        {
+            AddKey(a, i, Matrix4::CreateRotationY(Radian(kStep * (float)i)));
+
+            Quaternion q;
+            ToQuaternion(a.KeyFrames[i].Key, q);
+            if (i > 0u && Quaternion::Dot(previous, q) < 0.0f) { flips++; }
+            previous = q;
+        }
+        ensure(flips > 0u);
+
+        a.Compress();
+
+        for (size_t i = 0u; (i + 1u) < kKeyCount; i++)
+        {
+            Matrix4 m;
+            a.Sample(i, 0.5f * (a.GetTime(i) + a.GetTime(i + 1u)), m);
+
+            float basis, translation;
+            GetError(m, Matrix4::CreateRotationY(Radian(kStep * ((float)i + 0.5f))), basis, translation);
+            ensure(basis <= kBasisBound);
+        }
+    }
+
+}
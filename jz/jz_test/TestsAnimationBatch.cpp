@@ -0,0 +1,155 @@
+#include <jz_core/Matrix4.h>
+#include <jz_core/StringUtility.h>
+#include <jz_engine_3D/AnimatedMeshNode.h>
+#include <jz_engine_3D/AnimationBatch.h>
+#include <jz_engine_3D/JointNode.h>
+#include <jz_system/Jobs.h>
+#include <jz_system/Time.h>
+#include <jz_test/Tests.h>
+#include <vector>
+
+namespace tut
+{
+
+    DUMMY(TestsAnimationBatch);
+
+    using namespace jz;
+    using namespace jz::engine_3D;
+    using namespace jz::system;
+
+    static const size_t kJointCount = 3u;
+    static const size_t kKeyCount = 4u;
+
+    // A chain of kJointCount joints under aRoot, each with its own key frames, one key per
+    // second.
+    static void _CreateSkeleton(SceneNode* apRoot, const StringId& aBaseId, vector<JointNodePtr>& arJoints)
+    {
+        SceneNode* pParent = apRoot;
+        for (size_t i = 0u; i < kJointCount; i++)
+        {
+            JointNodePtr p(new JointNode(aBaseId, StringId(("joint " + StringUtility::ToString(i)).c_str())));
+
+            Animation& a = p->GetAnimation();
+            a.KeyFrames.resize(kKeyCount);
+            for (size_t k = 0u; k < kKeyCount; k++)
+            {
+                a.KeyFrames[k].Key = (Matrix4::CreateRotationY(Radian(0.25f * (float)(k + i))) * Matrix4::CreateTranslation(Vector3(0.0f, 1.0f, (float)k)));
+                a.KeyFrames[k].TimeAndPadding = Vector4((float)k, 0.0f, 0.0f, 0.0f);
+            }
+
+            p->SetParent(pParent);
+            pParent = p.Get();
+            arJoints.push_back(p);
+        }
+    }
+
+    // A mesh skinned to the skeleton of _CreateSkeleton(), with a bind transform of its own.
+    static AnimatedMeshNodeNodePtr _CreateMesh(SceneNode* apRoot, const StringId& aBaseId, size_t i)
+    {
+        AnimatedMeshNodeNodePtr p(new AnimatedMeshNode(aBaseId, StringId(("mesh " + StringUtility::ToString(i)).c_str())));
+
+        p->SetBindTransform(Matrix4::CreateTranslation(Vector3((float)i, 0.0f, 0.0f)));
+
+        MemoryBuffer<Matrix4>& invBinds = p->GetInvBindTransforms();
+        invBinds.resize(kJointCount);
+        for (size_t j = 0u; j < kJointCount; j++)
+        {
+            invBinds[j] = (Matrix4::CreateRotationY(Radian(0.5f * (float)j)) * Matrix4::CreateTranslation(Vector3(0.0f, -(float)j, 0.0f)));
+            p->GetJointIds().push_back(StringId(("joint " + StringUtility::ToString(j)).c_str()));
+        }
+        p->SetRootJointId(p->GetJointIds()[0]);
+
+        p->GetAnimationControl()->SetStartIndex(0);
+        p->GetAnimationControl()->SetEndIndex((int)(kKeyCount - 1u));
+        p->GetAnimationControl()->SetPlay(true);
+
+        p->SetParent(apRoot);
+
+        return p;
+    }
+
+    static bool _AboutEqual(const Vector4& a, const Vector4& b)
+    {
+        const float kTolerance = Constants<float>::kLooseTolerance;
+
+        return (AboutEqual(a.X, b.X, kTolerance) && AboutEqual(a.Y, b.Y, kTolerance) && AboutEqual(a.Z, b.Z, kTolerance) && AboutEqual(a.W, b.W, kTolerance));
+    }
+
+    // Each palette entry is the first three columns of Bind * InvBind * joint world.
+    static void _CheckPalette(const AnimatedMeshNode& aMesh, const vector<JointNodePtr>& aJoints)
+    {
+        const MemoryBuffer<Vector4>& skinning = aMesh.GetSkinning();
+        ensure_equals(skinning.size(), (kJointCount * 3u));
+
+        for (size_t j = 0u; j < kJointCount; j++)
+        {
+            const Matrix4 kExpected = (aMesh.GetBindTransform() * aMesh.GetInvBindTransforms()[j] * aJoints[j]->GetWorldTransform());
+
+            ensure(_AboutEqual(skinning[(j * 3u) + 0u], kExpected.GetCol(0)));
+            ensure(_AboutEqual(skinning[(j * 3u) + 1u], kExpected.GetCol(1)));
+            ensure(_AboutEqual(skinning[(j * 3u) + 2u], kExpected.GetCol(2)));
+        }
+    }
+
+    // Updates the scene aUpdates + 1 times, checking every palette after each update but
+    // the first, which only resolves the joints.
+    static void _Play(SceneNode* apRoot, const vector<AnimatedMeshNodeNodePtr>& aMeshes, const vector<JointNodePtr>& aJoints, size_t aUpdates)
+    {
+        apRoot->Update();
+
+        for (size_t i = 0u; i < aUpdates; i++)
+        {
+            Time::GetSingleton().Tick();
+            apRoot->Update();
+
+            ensure(aJoints[0]->bDirty());
+            for (size_t m = 0u; m < aMeshes.size(); m++) { _CheckPalette(*aMeshes[m], aJoints); }
+        }
+    }
+
+    // Palettes built by Skin() follow the posed skeleton.
+    template<> template<>
+    void Object::test<1>()
+    {
+        Time time;
+
+        const StringId kBaseId("animation batch serial");
+
+        SceneNodePtr root(new SceneNode());
+        root->SetLocalTransform(Matrix4::CreateTranslation(Vector3(1.0f, 2.0f, 3.0f)));
+
+        vector<JointNodePtr> joints;
+        _CreateSkeleton(root.Get(), kBaseId, joints);
+
+        vector<AnimatedMeshNodeNodePtr> meshes;
+        for (size_t i = 0u; i < 3u; i++) { meshes.push_back(_CreateMesh(root.Get(), kBaseId, i)); }
+
+        _Play(root.Get(), meshes, joints, 3u);
+
+        // The joints were posed from their key frames, not left at identity.
+        ensure(!Matrix4::AboutEqual(joints[1]->GetLocalTransform(), Matrix4::kIdentity));
+        ensure(!Matrix4::AboutEqual(joints[2]->GetLocalTransform(), Matrix4::kIdentity));
+    }
+
+    // With more than kParallelThreshold meshes and Jobs running, palettes are built over the
+    // workers with the same result.
+    template<> template<>
+    void Object::test<2>()
+    {
+        Time time;
+        Jobs jobs(3u);
+
+        const StringId kBaseId("animation batch parallel");
+
+        SceneNodePtr root(new SceneNode());
+
+        vector<JointNodePtr> joints;
+        _CreateSkeleton(root.Get(), kBaseId, joints);
+
+        vector<AnimatedMeshNodeNodePtr> meshes;
+        for (size_t i = 0u; i < (AnimationBatch::kParallelThreshold + 6u); i++) { meshes.push_back(_CreateMesh(root.Get(), kBaseId, i)); }
+
+        _Play(root.Get(), meshes, joints, 2u);
+    }
+
+}
@@ -0,0 +1,192 @@
+#include <jz_core/Matrix4.h>
+#include <jz_engine_3D/Animation.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsAnimationControl);
+
+    using namespace jz;
+    using namespace jz::engine_3D;
+    using namespace jz::system;
+
+    static const size_t kKeyCount = 20u;
+    static const float kTolerance = 1e-4f;
+
+    // One key per second, key i translated by i along X, so the pose at a time is easy to
+    // predict: the base plays keys [0, 9] and the layers play [10, 19].
+    static void CreateTimeline(Animation& a)
+    {
+        a.KeyFrames.resize(kKeyCount);
+        for (size_t i = 0u; i < kKeyCount; i++)
+        {
+            a.KeyFrames[i].Key = Matrix4::CreateTranslation(Vector3((float)i, 0.0f, 0.0f));
+            a.KeyFrames[i].TimeAndPadding = Vector4((float)i, 0.0f, 0.0f, 0.0f);
+        }
+    }
+
+    static AnimationControl* CreateControl(int aStartIndex, int aEndIndex)
+    {
+        AnimationControl* p = new AnimationControl();
+        p->SetStartIndex(aStartIndex);
+        p->SetEndIndex(aEndIndex);
+        p->SetPlay(true);
+
+        return p;
+    }
+
+    static float SampleX(const AnimationControl& aControl, const Animation& aAnimation, const StringId& aJoint)
+    {
+        Matrix4 m;
+        ensure(aControl.Sample(aAnimation, aJoint, m));
+
+        return m.GetTranslation().X;
+    }
+
+    // A second Advance() to the same time changes nothing, with or without layers.
+    template<> template<>
+    void Object::test<1>()
+    {
+        Animation a;
+        CreateTimeline(a);
+
+        const StringId kJoint("joint");
+
+        AnimationControlPtr pControl(CreateControl(0, 9));
+        ensure(pControl->Advance(a, 10.0));
+        ensure(pControl->Advance(a, 12.5));
+
+        const int kIndex = pControl->GetCurrentIndex();
+        const float kX = SampleX(*pControl, a, kJoint);
+        ensure(AboutEqual(kX, 2.5f, kTolerance));
+
+        ensure(pControl->Advance(a, 12.5));
+        ensure_equals(pControl->GetCurrentIndex(), kIndex);
+        ensure(AboutEqual(SampleX(*pControl, a, kJoint), kX, kTolerance));
+
+        // Layers are advanced with their parent and must not step again either.
+        AnimationControlPtr pLayer(CreateControl(10, 19));
+        pControl->AddLayer(pLayer.Get(), 0.5f, false);
+        ensure(pControl->Advance(a, 13.5));
+        const int kLayerIndex = pLayer->GetCurrentIndex();
+        const float kBlended = SampleX(*pControl, a, kJoint);
+
+        ensure(pControl->Advance(a, 13.5));
+        ensure(pLayer->Advance(a, 13.5));
+        ensure_equals(pLayer->GetCurrentIndex(), kLayerIndex);
+        ensure(AboutEqual(SampleX(*pControl, a, kJoint), kBlended, kTolerance));
+
+        // A control that is not playing reports no change once its dirty state is used.
+        AnimationControlPtr pStill(new AnimationControl());
+        pStill->SetStartIndex(0);
+        pStill->SetEndIndex(9);
+        ensure(pStill->Advance(a, 1.0));
+        ensure(!pStill->Advance(a, 2.0));
+        ensure(!pStill->Advance(a, 2.0));
+    }
+
+    // An override layer replaces the pose of the joints in its mask, by its weight.
+    template<> template<>
+    void Object::test<2>()
+    {
+        Animation a;
+        CreateTimeline(a);
+
+        const StringId kMasked("masked");
+        const StringId kOther("other");
+
+        AnimationControlPtr pControl(CreateControl(0, 9));
+        AnimationControlPtr pLayer(CreateControl(10, 19));
+        const size_t kLayer = pControl->AddLayer(pLayer.Get(), 1.0f, false);
+
+        JointMask mask;
+        mask.push_back(kMasked);
+        pControl->SetLayerMask(kLayer, mask);
+
+        // The first Advance() starts both ranges at their first key.
+        pControl->Advance(a, 0.0);
+        pControl->Advance(a, 1.0);
+
+        ensure(AboutEqual(SampleX(*pControl, a, kMasked), 11.0f, kTolerance));
+        ensure(AboutEqual(SampleX(*pControl, a, kOther), 1.0f, kTolerance));
+
+        pControl->SetLayerWeight(kLayer, 0.25f);
+        ensure(pControl->Advance(a, 1.0));
+        ensure(AboutEqual(SampleX(*pControl, a, kMasked), 3.5f, kTolerance));
+        ensure(AboutEqual(SampleX(*pControl, a, kOther), 1.0f, kTolerance));
+
+        // An empty mask applies to every joint.
+        pControl->SetLayerMask(kLayer, JointMask());
+        ensure(pControl->Advance(a, 1.0));
+        ensure(AboutEqual(SampleX(*pControl, a, kOther), 3.5f, kTolerance));
+    }
+
+    // An additive layer adds its difference from the first key of its range to the
+    // joints in its mask, by its weight.
+    template<> template<>
+    void Object::test<3>()
+    {
+        Animation a;
+        CreateTimeline(a);
+
+        const StringId kMasked("masked");
+        const StringId kOther("other");
+
+        AnimationControlPtr pControl(CreateControl(0, 9));
+        AnimationControlPtr pLayer(CreateControl(10, 19));
+        const size_t kLayer = pControl->AddLayer(pLayer.Get(), 1.0f, true);
+
+        JointMask mask;
+        mask.push_back(kMasked);
+        pControl->SetLayerMask(kLayer, mask);
+
+        pControl->Advance(a, 0.0);
+        pControl->Advance(a, 3.0);
+
+        // Base at key 3, layer at key 13, three past its reference key 10.
+        ensure(AboutEqual(SampleX(*pControl, a, kMasked), 6.0f, kTolerance));
+        ensure(AboutEqual(SampleX(*pControl, a, kOther), 3.0f, kTolerance));
+
+        pControl->SetLayerWeight(kLayer, 0.5f);
+        ensure(pControl->Advance(a, 3.0));
+        ensure(AboutEqual(SampleX(*pControl, a, kMasked), 4.5f, kTolerance));
+
+        pControl->SetLayerWeight(kLayer, 0.0f);
+        ensure(pControl->Advance(a, 3.0));
+        ensure(AboutEqual(SampleX(*pControl, a, kMasked), 3.0f, kTolerance));
+    }
+
+    // With an update interval, updates in between are skipped: Advance() reports no
+    // change and Sample() declines, so joints hold their last pose. The next update
+    // samples at the actual time, not one interval after the last.
+    template<> template<>
+    void Object::test<4>()
+    {
+        Animation a;
+        CreateTimeline(a);
+
+        const StringId kJoint("joint");
+
+        AnimationControlPtr pControl(CreateControl(0, 9));
+        pControl->SetUpdateInterval(0.5);
+
+        ensure(pControl->Advance(a, 0.0));
+        ensure(AboutEqual(SampleX(*pControl, a, kJoint), 0.0f, kTolerance));
+
+        Matrix4 m;
+        ensure(!pControl->Advance(a, 0.25));
+        ensure(!pControl->Sample(a, kJoint, m));
+        ensure(!pControl->Advance(a, 0.25));
+        ensure(!pControl->Advance(a, 0.45));
+
+        ensure(pControl->Advance(a, 0.7));
+        ensure(AboutEqual(SampleX(*pControl, a, kJoint), 0.7f, kTolerance));
+
+        // A change to the control is not held back by the interval.
+        pControl->SetCurrentIndex(5);
+        ensure(pControl->Advance(a, 0.8));
+        ensure(AboutEqual(SampleX(*pControl, a, kJoint), 5.0f, kTolerance));
+    }
+
+}
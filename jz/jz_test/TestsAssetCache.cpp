@@ -0,0 +1,63 @@
+#include <jz_system/AssetCache.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsAssetCache);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    template<> template<>
+    void Object::test<1>()
+    {
+        AssetCache cache(4096u);
+
+        const u64 a = AssetCache::GetKey("a.zip", "mesh.jz", 1u, 1024u);
+        const u64 b = AssetCache::GetKey("a.zip", "mesh.jz", 2u, 1024u);
+        const u64 c = AssetCache::GetKey("b.zip", "mesh.jz", 1u, 1024u);
+        ensure(a != b && a != c && b != c);
+
+        ensure(!cache.Find(a).IsValid());
+
+        SharedBufferPtr pA(new SharedBuffer(1024u));
+        ensure(cache.Insert(a, pA) == pA);
+        ensure(cache.Find(a) == pA);
+
+        // A second insert of the same key keeps the first buffer.
+        ensure(cache.Insert(a, SharedBufferPtr(new SharedBuffer(1024u))) == pA);
+
+        // Over a quarter of the budget is handed back uncached.
+        ensure(!cache.GetAccepts(1025u));
+        SharedBufferPtr pBig(new SharedBuffer(1025u));
+        ensure(cache.Insert(b, pBig) == pBig);
+        ensure(!cache.Find(b).IsValid());
+
+        // Touching a makes the buffer inserted after it the eviction victim.
+        cache.Insert(b, SharedBufferPtr(new SharedBuffer(1024u)));
+        cache.Insert(c, SharedBufferPtr(new SharedBuffer(1024u)));
+        ensure(cache.Find(a) == pA);
+        cache.Insert(AssetCache::GetKey("c.zip", "mesh.jz", 1u, 1024u), SharedBufferPtr(new SharedBuffer(1024u)));
+        cache.Insert(AssetCache::GetKey("d.zip", "mesh.jz", 1u, 1024u), SharedBufferPtr(new SharedBuffer(1024u)));
+
+        AssetCache::Stats stats = cache.GetStats();
+        ensure_equals(stats.Entries, 4u);
+        ensure_equals(stats.Bytes, 4096u);
+        ensure_equals(stats.Evictions, 1u);
+        ensure(cache.Find(a) == pA);
+        ensure(!cache.Find(b).IsValid());
+
+        cache.SetBudget(2048u);
+        stats = cache.GetStats();
+        ensure_equals(stats.Entries, 2u);
+        ensure(cache.Find(a) == pA);
+
+        cache.Clear();
+        stats = cache.GetStats();
+        ensure_equals(stats.Entries, 0u);
+        ensure_equals(stats.Bytes, 0u);
+        ensure(!cache.Find(a).IsValid());
+    }
+
+}
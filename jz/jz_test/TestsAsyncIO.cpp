@@ -0,0 +1,81 @@
+#include <jz_core/Memory.h>
+#include <jz_system/AsyncIO.h>
+#include <jz_test/Tests.h>
+#include <cstdio>
+
+namespace tut
+{
+
+    DUMMY(TestsAsyncIO);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    static const char* kpFilename = "jz_test_async_io.bin";
+    static const size_t kBlockSize = 4096u;
+    static const size_t kBlockCount = 64u;
+
+    static u8 _GetByte(size_t i) { return (u8)((i * 31u) >> 3); }
+
+    static void _ReadBlocks(bool abAllowUring)
+    {
+        AsyncIO io(2u, abAllowUring);
+        AsyncFilePtr pFile(new AsyncFile(kpFilename));
+        ensure_equals(pFile->GetSize(), (u64)(kBlockSize * kBlockCount));
+
+        ByteBuffer out;
+        out.resize(kBlockSize * kBlockCount);
+        out.Initialize();
+
+        // Issued out of order and at mixed priorities, each must still land in place.
+        vector<AsyncIO::RequestHandle> handles(kBlockCount);
+        for (size_t i = 0u; i < kBlockCount; i++)
+        {
+            const size_t kBlock = ((i * 37u) % kBlockCount);
+            handles[kBlock] = io.Read(pFile, (kBlock * kBlockSize), (out.Get() + (kBlock * kBlockSize)), kBlockSize, (AsyncIO::Priority)(i % 4u));
+        }
+
+        for (size_t i = 0u; i < kBlockCount; i++)
+        {
+            size_t bytes = 0u;
+            ensure_equals(io.Wait(handles[i], &bytes), AsyncIO::kComplete);
+            ensure_equals(bytes, kBlockSize);
+
+            io.Release(handles[i]);
+            ensure_equals(io.GetStatus(handles[i]), AsyncIO::kInvalid);
+        }
+
+        for (size_t i = 0u; i < out.size(); i++) { ensure_equals(out[i], _GetByte(i)); }
+
+        // A read past the end fails and reports the bytes that were there.
+        u8 tail[64];
+        AsyncIO::RequestHandle handle = io.Read(pFile, (out.size() - 16u), tail, sizeof(tail));
+        size_t bytes = 0u;
+        ensure_equals(io.Wait(handle, &bytes), AsyncIO::kFailed);
+        ensure_equals(bytes, 16u);
+        io.Release(handle);
+    }
+
+    template<> template<>
+    void Object::test<1>()
+    {
+        FILE* pFile = fopen(kpFilename, "wb");
+        ensure(pFile != null);
+        for (size_t i = 0u; i < (kBlockSize * kBlockCount); i++) { fputc(_GetByte(i), pFile); }
+        fclose(pFile);
+
+        try
+        {
+            _ReadBlocks(false);
+            _ReadBlocks(true);
+        }
+        catch (...)
+        {
+            remove(kpFilename);
+            throw;
+        }
+
+        remove(kpFilename);
+    }
+
+}
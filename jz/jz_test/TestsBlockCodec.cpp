@@ -0,0 +1,43 @@
+#include <jz_filesystem/BlockCodec.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsBlockCodec);
+
+    using namespace jz;
+    using namespace jz::filesystem;
+
+    template<> template<>
+    void Object::test<1>()
+    {
+        static const size_t kSize = 4072u;
+
+        ByteBuffer in;
+        in.resize(kSize);
+        for (size_t i = 0u; i < kSize; i++) { in[i] = (u8)((i % 251u) < 128u ? (i / 7u) : (i * 31u)); }
+
+        ByteBuffer encoded;
+        encoded.resize(kSize);
+        ByteBuffer decoded;
+        decoded.resize(kSize);
+
+        for (u16 d = 0u; d < Block::kDescriptorCount; d++)
+        {
+            const IBlockCodec* p = BlockCodecs::Get(d);
+            if (!p) { continue; }
+
+            const size_t kEncoded = p->Encode(in.Get(), kSize, encoded.Get(), (kSize - 1u));
+            if (d == Block::kDescriptorUncompressed) { ensure_equals(kEncoded, 0u); continue; }
+
+            ensure(kEncoded > 0u && kEncoded < kSize);
+            ensure_equals(p->Decode(encoded.Get(), kEncoded, decoded.Get(), kSize), kSize);
+            ensure(memcmp(in.Get(), decoded.Get(), kSize) == 0);
+
+            // Output that does not fit fails instead of overrunning.
+            ensure_equals(p->Decode(encoded.Get(), kEncoded, decoded.Get(), (kSize - 1u)), 0u);
+        }
+    }
+
+}
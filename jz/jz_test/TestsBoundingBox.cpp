@@ -0,0 +1,71 @@
+#include <jz_core/BoundingBox.h>
+#include <jz_core/Matrix4.h>
+#include <jz_core/Vector4.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsBoundingBox);
+
+    using namespace jz;
+
+    static Vector3 RandomVector3()
+    {
+        return Vector3(UniformRandomf() - 0.5f, UniformRandomf() - 0.5f, UniformRandomf() - 0.5f);
+    }
+
+    template<> template<>
+    void Object::test<1>()
+    {
+        static const size_t kCount = 16u;
+
+        BoundingBox boxes[kCount];
+        Vector4 columns[kCount * 3u];
+        BoundingBox expected(BoundingBox::kInvertedMax);
+
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            const Vector3 a = RandomVector3();
+            const Vector3 b = RandomVector3();
+            const Vector3 r0 = RandomVector3();
+            const Vector3 r1 = RandomVector3();
+            const Vector3 r2 = RandomVector3();
+            const Vector3 t = 10.0f * RandomVector3();
+
+            const Matrix4 m(r0.X, r0.Y, r0.Z, 0,
+                            r1.X, r1.Y, r1.Z, 0,
+                            r2.X, r2.Y, r2.Z, 0,
+                            t.X,  t.Y,  t.Z,  1);
+
+            columns[(i * 3u) + 0u] = m.GetCol(0);
+            columns[(i * 3u) + 1u] = m.GetCol(1);
+            columns[(i * 3u) + 2u] = m.GetCol(2);
+
+            // Every fourth box is empty and must not contribute.
+            if ((i % 4u) == 3u)
+            {
+                boxes[i] = BoundingBox::kInvertedMax;
+            }
+            else
+            {
+                boxes[i] = BoundingBox(Vector3::Min(a, b), Vector3::Max(a, b));
+                expected = BoundingBox::Merge(expected, BoundingBox::Transform(m, boxes[i]));
+            }
+        }
+
+        const BoundingBox kMerged = BoundingBox::MergeTransformed(columns, boxes, kCount);
+        ensure(BoundingBox::AboutEqual(kMerged, expected, 1e-4f));
+    }
+
+    template<> template<>
+    void Object::test<2>()
+    {
+        Vector4 columns[3] = { Vector4::kUnitX, Vector4::kUnitY, Vector4::kUnitZ };
+        BoundingBox box(BoundingBox::kInvertedMax);
+
+        const BoundingBox kMerged = BoundingBox::MergeTransformed(columns, &box, 1u);
+        ensure(kMerged.Min.X > kMerged.Max.X);
+    }
+
+}
@@ -0,0 +1,544 @@
+#include <jz_core/Atomic.h>
+#include <jz_core/Memory.h>
+#include <jz_system/Files.h>
+#include <jz_system/Thread.h>
+#include <jz_test/Tests.h>
+#include <zlib/zlib.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace tut
+{
+
+    DUMMY(TestsFiles);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    static const char* kpIndexedFilename = "jz_test_files/indexed.bin";
+    static const char* kpMissingFilename = "jz_test_files/missing.bin";
+    static const char* kpLooseFilename = "jz_test_files_loose.bin";
+    static const char* kpZipFilename = "jz_test_files.zip";
+    static const int kReaderCount = 4;
+    static const int kWriterIterations = 400;
+    static const int kAddedArchives = 32;
+
+    // Lists one file that is not on disk, so lookups must go through the index.
+    class ListArchive sealed : public IArchive
+    {
+    public:
+        virtual bool GetExists(const char* apFilename) const override
+        {
+            return (Files::CleanFilename(apFilename) == Files::CleanFilename(kpIndexedFilename));
+        }
+
+        virtual IReadFile* Open(const char* apFilename) const override
+        {
+            static const u8 kData[] = { 1u, 2u, 3u, 4u };
+
+            return new MemoryReadFile(apFilename, (void_p)kData, sizeof(kData));
+        }
+
+        virtual bool GetFiles(vector<string>& arOut) const override
+        {
+            arOut.push_back(Files::CleanFilename(kpIndexedFilename));
+            return true;
+        }
+    };
+
+    struct FilesStress
+    {
+        FilesStress(Files& arFiles)
+            : rFiles(arFiles)
+        {}
+
+        Files& rFiles;
+        AtomicInt Done;
+        AtomicInt Failures;
+        AtomicInt Lookups;
+
+        void Read(const Thread&)
+        {
+            while (Done.Get() == 0)
+            {
+                if (!rFiles.GetExists(kpIndexedFilename)) { Failures.Increment(); }
+                if (rFiles.GetExists(kpMissingFilename)) { Failures.Increment(); }
+
+                IReadFilePtr pFile(rFiles.Open(kpIndexedFilename));
+                if (pFile->GetSize() != 4u) { Failures.Increment(); }
+
+                Lookups.Increment();
+            }
+        }
+
+        void Refresh(const Thread&)
+        {
+            for (int i = 0; i < kWriterIterations; i++) { rFiles.Refresh(); }
+        }
+
+        void Add(const Thread&)
+        {
+            for (int i = 0; i < kAddedArchives; i++)
+            {
+                rFiles.AddArchive(new ListArchive());
+                Thread::Sleep(0u);
+            }
+        }
+    };
+
+    // Readers look up through the lock free index while two writers replace it. An
+    // index freed while a reader still holds it shows up as a failed lookup here, or
+    // as a use after free under a checked build.
+    template<> template<>
+    void Object::test<1>()
+    {
+        ensure(!Files::GetSingletonExists());
+
+        Files files;
+        files.AddArchive(new ListArchive());
+
+        FilesStress stress(files);
+        {
+            vector<Thread*> readers;
+            for (int i = 0; i < kReaderCount; i++)
+            {
+                readers.push_back(new Thread(tr1::bind(&FilesStress::Read, &stress, tr1::placeholders::_1)));
+            }
+
+            {
+                Thread refresh(tr1::bind(&FilesStress::Refresh, &stress, tr1::placeholders::_1));
+                Thread add(tr1::bind(&FilesStress::Add, &stress, tr1::placeholders::_1));
+            }
+
+            stress.Done.Increment();
+            for (size_t i = 0u; i < readers.size(); i++) { delete readers[i]; }
+        }
+
+        ensure(stress.Lookups.Get() > 0);
+        ensure_equals(stress.Failures.Get(), 0);
+        ensure(files.GetExists(kpIndexedFilename));
+    }
+
+    // Separators become the platform's. Case folds on Windows only, so on POSIX names that
+    // differ in case are different files, in the index as on disk.
+    template<> template<>
+    void Object::test<2>()
+    {
+#       if JZ_PLATFORM_WINDOWS
+            ensure_equals(Files::CleanFilename("Media/Sub\\File.TXT"), string("media\\sub\\file.txt"));
+#       else
+            ensure_equals(Files::CleanFilename("Media/Sub\\File.TXT"), string("Media/Sub/File.TXT"));
+#       endif
+        ensure_equals(Files::CleanFilename(""), string());
+
+        Files files;
+        files.AddArchive(new ListArchive());
+
+        ensure(files.GetExists("jz_test_files\\indexed.bin"));
+
+#       if JZ_PLATFORM_WINDOWS
+            ensure(files.GetExists("JZ_Test_Files/Indexed.BIN"));
+#       else
+            ensure(!files.GetExists("JZ_Test_Files/Indexed.BIN"));
+#       endif
+    }
+
+    // A path found missing on disk stays missing for the index, until it is written
+    // through OpenWriteable() or the index is rebuilt.
+    template<> template<>
+    void Object::test<3>()
+    {
+        remove(kpLooseFilename);
+
+        try
+        {
+            Files files;
+            ensure(!files.GetExists(kpLooseFilename));
+
+            {
+                IWriteFilePtr pFile(files.OpenWriteable(kpLooseFilename));
+                const u8 kData = 1u;
+                pFile->Write(&kData, 1u);
+            }
+            ensure(files.GetExists(kpLooseFilename));
+            ensure_equals(IReadFilePtr(files.Open(kpLooseFilename))->GetSize(), 1u);
+
+            remove(kpLooseFilename);
+            ensure(!files.GetExists(kpLooseFilename));
+
+            {
+                ofstream file(kpLooseFilename);
+                file << "x";
+            }
+            ensure(!files.GetExists(kpLooseFilename));
+
+            files.Refresh();
+            ensure(files.GetExists(kpLooseFilename));
+        }
+        catch (...)
+        {
+            remove(kpLooseFilename);
+            throw;
+        }
+
+        remove(kpLooseFilename);
+    }
+
+    // Builds a zip in memory: local headers and data, then optionally the central
+    // directory and end record.
+    class ZipBuilder sealed
+    {
+    public:
+        ZipBuilder()
+            : mCount(0u)
+        {}
+
+        void Add(const char* apName, const vector<u8>& aData, bool abDeflate)
+        {
+            vector<u8> data(aData);
+            if (abDeflate) { _Deflate(aData, data); }
+
+            ZipLocalFileHeader local;
+            memset(&local, 0, sizeof(ZipLocalFileHeader));
+            local.Signature = 0x04034b50;
+            local.VersionNeededToExtract = 20;
+            local.CompressionMethod = (abDeflate) ? 8 : 0;
+            local.DataDescriptor.Crc32 = (s32)crc32(0u, (aData.empty()) ? null : &aData[0], (uInt)aData.size());
+            local.DataDescriptor.CompressedSize = (u32)data.size();
+            local.DataDescriptor.UncompressedSize = (u32)aData.size();
+            local.FilenameLength = (u16)strlen(apName);
+
+            ZipCentralDirectoryHeader central;
+            memset(&central, 0, sizeof(ZipCentralDirectoryHeader));
+            central.Signature = 0x02014b50;
+            central.VersionMadeBy = 20;
+            central.VersionNeededToExtract = 20;
+            central.CompressionMethod = local.CompressionMethod;
+            central.DataDescriptor = local.DataDescriptor;
+            central.FilenameLength = local.FilenameLength;
+            central.LocalHeaderOffset = (u32)mData.size();
+
+            _Append(mData, &local, sizeof(ZipLocalFileHeader));
+            _Append(mData, apName, local.FilenameLength);
+            _Append(mData, (data.empty()) ? null : &data[0], data.size());
+
+            _Append(mDirectory, &central, sizeof(ZipCentralDirectoryHeader));
+            _Append(mDirectory, apName, central.FilenameLength);
+            mCount++;
+        }
+
+        // Without a usable end record the archive falls back to scanning local headers.
+        // abUsable false writes one with zip64 markers, which the archive does not read.
+        void Write(const char* apFilename, bool abDirectory, bool abUsable) const
+        {
+            vector<u8> file(mData);
+
+            if (abDirectory)
+            {
+                ZipEndOfCentralDirectory end;
+                memset(&end, 0, sizeof(ZipEndOfCentralDirectory));
+                end.Signature = 0x06054b50;
+                end.DiskEntries = mCount;
+                end.TotalEntries = mCount;
+                end.DirectorySize = (u32)mDirectory.size();
+                end.DirectoryOffset = (abUsable) ? (u32)mData.size() : 0xFFFFFFFF;
+
+                _Append(file, &mDirectory[0], mDirectory.size());
+                _Append(file, &end, sizeof(ZipEndOfCentralDirectory));
+            }
+
+            FILE* pFile = fopen(apFilename, "wb");
+            ensure(pFile != null);
+            const size_t kWritten = fwrite(&file[0], 1u, file.size(), pFile);
+            fclose(pFile);
+            ensure_equals(kWritten, file.size());
+        }
+
+    private:
+        vector<u8> mData;
+        vector<u8> mDirectory;
+        u16 mCount;
+
+        static void _Append(vector<u8>& arOut, voidc_p apData, size_t aSize)
+        {
+            const u8* p = static_cast<const u8*>(apData);
+            arOut.insert(arOut.end(), p, p + aSize);
+        }
+
+        static void _Deflate(const vector<u8>& aIn, vector<u8>& arOut)
+        {
+            z_stream stream;
+            memset(&stream, 0, sizeof(z_stream));
+            ensure(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+
+            arOut.resize(deflateBound(&stream, (uLong)aIn.size()));
+            stream.next_in = (Bytef*)&aIn[0];
+            stream.avail_in = (uInt)aIn.size();
+            stream.next_out = (Bytef*)&arOut[0];
+            stream.avail_out = (uInt)arOut.size();
+
+            const int kResult = deflate(&stream, Z_FINISH);
+            deflateEnd(&stream);
+            ensure_equals(kResult, Z_STREAM_END);
+
+            arOut.resize(stream.total_out);
+        }
+    };
+
+    // Compressible, but with enough variety that deflate ends many blocks along the way.
+    static void _FillZipData(vector<u8>& arOut, size_t aSize, u32 aSeed)
+    {
+        arOut.resize(aSize);
+
+        u32 state = aSeed;
+        for (size_t i = 0u; i < aSize; i++)
+        {
+            state = (state * 1664525u) + 1013904223u;
+            arOut[i] = (u8)('a' + ((state >> 24) % 16u));
+        }
+    }
+
+    static void _CheckRead(IReadFile* apFile, const vector<u8>& aExpected, size_t aPosition, size_t aSize)
+    {
+        const size_t kExpected = Min(aSize, aExpected.size() - aPosition);
+
+        ensure(apFile->Seek((natural)aPosition, false));
+
+        vector<u8> buffer(aSize + 1u);
+        ensure_equals(apFile->Read(&buffer[0], aSize), kExpected);
+        ensure(kExpected == 0u || memcmp(&buffer[0], &aExpected[aPosition], kExpected) == 0);
+        ensure_equals((size_t)apFile->GetPosition(), aPosition + kExpected);
+    }
+
+    // Reads every entry of the archive: whole, at the end, and at scattered positions,
+    // backwards as well as forwards.
+    static void _CheckZip(const vector<u8>& aStored, const vector<u8>& aLarge)
+    {
+        ZipArchive zip(kpZipFilename);
+
+        vector<string> names;
+        ensure(zip.GetFiles(names));
+        ensure_equals(names.size(), 3u);
+        ensure(zip.GetExists("stored.bin"));
+        ensure(zip.GetExists("empty.bin"));
+        ensure(zip.GetExists("dir/large.bin"));
+
+        {
+            IReadFilePtr pFile(zip.Open("stored.bin"));
+            ensure_equals(pFile->GetSize(), aStored.size());
+            _CheckRead(pFile.Get(), aStored, 0u, aStored.size());
+            _CheckRead(pFile.Get(), aStored, aStored.size() - 1u, 16u);
+            _CheckRead(pFile.Get(), aStored, aStored.size(), 16u);
+            ensure(!pFile->Seek((natural)(aStored.size() + 1u), false));
+        }
+
+        {
+            IReadFilePtr pFile(zip.Open("empty.bin"));
+            ensure_equals(pFile->GetSize(), 0u);
+            u8 byte = 0u;
+            ensure_equals(pFile->Read(&byte, 1u), 0u);
+        }
+
+        {
+            IReadFilePtr pFile(zip.Open("dir/large.bin"));
+            ensure_equals(pFile->GetSize(), aLarge.size());
+
+            // A first pass records the restart points.
+            _CheckRead(pFile.Get(), aLarge, 0u, aLarge.size());
+
+            u32 state = 7u;
+            for (size_t i = 0u; i < 24u; i++)
+            {
+                state = (state * 1664525u) + 1013904223u;
+                _CheckRead(pFile.Get(), aLarge, (size_t)(state % (u32)aLarge.size()), 5000u);
+            }
+
+            // Around a restart point, then back to the start.
+            _CheckRead(pFile.Get(), aLarge, InflateReadFile::kRestartInterval * 2u + 3u, 70000u);
+            _CheckRead(pFile.Get(), aLarge, InflateReadFile::kRestartInterval - 5u, 10u);
+            _CheckRead(pFile.Get(), aLarge, 0u, 100u);
+            _CheckRead(pFile.Get(), aLarge, aLarge.size() - 10u, 100u);
+        }
+    }
+
+    // Stored and deflated zip entries read back as written, with the central directory
+    // and through the local header scan.
+    template<> template<>
+    void Object::test<4>()
+    {
+        vector<u8> stored;
+        vector<u8> large;
+        _FillZipData(stored, 1000u, 1u);
+        _FillZipData(large, (InflateReadFile::kRestartInterval * 3u) + 12345u, 2u);
+
+        ZipBuilder builder;
+        builder.Add("stored.bin", stored, false);
+        builder.Add("empty.bin", vector<u8>(), false);
+        builder.Add("dir/large.bin", large, true);
+
+        Files files;
+
+        try
+        {
+            builder.Write(kpZipFilename, true, true);
+            _CheckZip(stored, large);
+
+            builder.Write(kpZipFilename, true, false);
+            _CheckZip(stored, large);
+
+            builder.Write(kpZipFilename, false, false);
+            _CheckZip(stored, large);
+        }
+        catch (...)
+        {
+            remove(kpZipFilename);
+            throw;
+        }
+
+        remove(kpZipFilename);
+    }
+
+    // A file in memory that counts the calls made on it.
+    class CountingFile sealed : public IReadFile, public IWriteFile
+    {
+    public:
+        CountingFile()
+            : Position(0u), Reads(0u), Writes(0u)
+        {}
+
+        vector<u8> Data;
+        size_t Position;
+        size_t Reads;
+        size_t Writes;
+
+        virtual const char* GetFilename() const override { return "counting"; }
+        virtual natural GetPosition() const override { return (natural)Position; }
+        virtual size_t GetSize() const override { return Data.size(); }
+
+        virtual size_t Read(void_p apOutBuffer, size_t aSize) override
+        {
+            Reads++;
+
+            const size_t kCount = Min(aSize, Data.size() - Position);
+            if (kCount > 0u) { memcpy(apOutBuffer, &Data[Position], kCount); }
+            Position += kCount;
+
+            return kCount;
+        }
+
+        virtual bool Seek(natural aPosition, bool abRelative = false) override
+        {
+            const size_t kPosition = (size_t)((abRelative) ? ((natural)Position + aPosition) : aPosition);
+            if (kPosition > Data.size()) { return false; }
+
+            Position = kPosition;
+            return true;
+        }
+
+        virtual size_t Write(voidc_p apInBuffer, size_t aSize) override
+        {
+            Writes++;
+
+            if (Position + aSize > Data.size()) { Data.resize(Position + aSize); }
+            memcpy(&Data[Position], apInBuffer, aSize);
+            Position += aSize;
+
+            return aSize;
+        }
+    };
+
+    // Small reads are served from the buffer, seeks inside it do not reach the wrapped
+    // file, and reads as large as the buffer pass straight through.
+    template<> template<>
+    void Object::test<5>()
+    {
+        static const size_t kBufferSize = 64u;
+
+        CountingFile* pCounting = new CountingFile();
+        AutoPtr<IReadFile> pWrapped(static_cast<IReadFile*>(pCounting));
+        _FillZipData(pCounting->Data, 1000u, 3u);
+        const vector<u8> kData(pCounting->Data);
+
+        BufferedReadFile file(pWrapped, kBufferSize);
+        ensure_equals(file.GetSize(), kData.size());
+
+        _CheckRead(&file, kData, 0u, 4u);
+        _CheckRead(&file, kData, 4u, 8u);
+        ensure_equals(pCounting->Reads, 1u);
+
+        // Backwards and forwards within the block.
+        _CheckRead(&file, kData, 2u, 10u);
+        _CheckRead(&file, kData, 50u, 14u);
+        ensure_equals(pCounting->Reads, 1u);
+
+        // Past the block, one refill.
+        _CheckRead(&file, kData, 500u, 16u);
+        ensure_equals(pCounting->Reads, 2u);
+        ensure(file.Seek(-8, true));
+        _CheckRead(&file, kData, 508u, 8u);
+        ensure_equals(pCounting->Reads, 2u);
+
+        // A read of the buffer size or more is one read of the wrapped file.
+        _CheckRead(&file, kData, 100u, 300u);
+        ensure_equals(pCounting->Reads, 3u);
+
+        // The end of the file, and seeks outside it.
+        _CheckRead(&file, kData, 990u, 20u);
+        _CheckRead(&file, kData, 1000u, 20u);
+        ensure(!file.Seek(1001, false));
+        ensure(!file.Seek(-1, false));
+    }
+
+    // Small writes are collected and written in blocks; seeks and destruction write what
+    // is pending, and writes as large as the buffer pass straight through.
+    template<> template<>
+    void Object::test<6>()
+    {
+        static const size_t kBufferSize = 64u;
+
+        vector<u8> data;
+        _FillZipData(data, 1000u, 4u);
+
+        CountingFile* pCounting = new CountingFile();
+        AutoPtr<IWriteFile> pWrapped(static_cast<IWriteFile*>(pCounting));
+
+        {
+            BufferedWriteFile file(pWrapped, kBufferSize);
+
+            for (size_t i = 0u; i < 60u; i += 4u) { ensure_equals(file.Write(&data[i], 4u), 4u); }
+            ensure_equals(pCounting->Writes, 0u);
+            ensure_equals((size_t)file.GetPosition(), 60u);
+            ensure_equals(file.GetSize(), 60u);
+
+            // Fills past the buffer: the pending block goes out first.
+            ensure_equals(file.Write(&data[60], 8u), 8u);
+            ensure_equals(pCounting->Writes, 1u);
+            ensure_equals(pCounting->Data.size(), 60u);
+
+            // Large writes are written at once, after what is pending.
+            ensure_equals(file.Write(&data[68], 400u), 400u);
+            ensure_equals(pCounting->Writes, 3u);
+            ensure_equals(pCounting->Data.size(), 468u);
+
+            // A seek writes what is pending before moving.
+            ensure_equals(file.Write(&data[468], 32u), 32u);
+            ensure(file.Seek(10, false));
+            ensure_equals(pCounting->Data.size(), 500u);
+            ensure_equals(file.Write(&data[10], 5u), 5u);
+            ensure_equals((size_t)file.GetPosition(), 15u);
+
+            ensure(file.Seek(500, false));
+            ensure_equals(file.Write(&data[500], 500u), 500u);
+            ensure_equals(file.Write(&data[0], 0u), 0u);
+            ensure(file.Flush());
+            ensure_equals(file.GetSize(), 1000u);
+
+            ensure(file.Seek(999, false));
+            ensure_equals(file.Write(&data[999], 1u), 1u);
+        }
+
+        ensure(pCounting->Data == data);
+    }
+
+}
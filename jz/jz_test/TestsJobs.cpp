@@ -0,0 +1,239 @@
+#include <jz_core/Atomic.h>
+#include <jz_system/Jobs.h>
+#include <jz_system/Thread.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsJobs);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    static const uint kWorkerCount = 3u;
+
+    // More jobs than fit in a deque or a job pool, so the shared queue and heap jobs
+    // are exercised along with the deques.
+    static const size_t kJobCount = (size_t)(Jobs::kDequeSize + Jobs::kJobPoolSize + 100);
+
+    struct Counts
+    {
+        Counts(size_t aSize)
+            : Runs(aSize)
+        {}
+
+        vector<AtomicInt> Runs;
+        AtomicInt Next;
+        AtomicInt Stolen;
+    };
+
+    struct CountJob
+    {
+        CountJob()
+            : pCounts(null), Index(0u)
+        {}
+
+        Counts* pCounts;
+        size_t Index;
+
+        void Execute()
+        {
+            pCounts->Runs[Index].Increment();
+            if (Jobs::GetCurrentWorkerIndex() != 0) { pCounts->Stolen.Increment(); }
+        }
+
+        void ExecuteSlowly()
+        {
+            Execute();
+            Thread::Sleep(1u);
+        }
+    };
+
+    // Every job runs exactly once, wherever it was queued.
+    template<> template<>
+    void Object::test<1>()
+    {
+        Jobs jobs(kWorkerCount);
+        ensure_equals(jobs.GetWorkerCount(), kWorkerCount);
+        ensure_equals(Jobs::GetCurrentWorkerIndex(), 0);
+
+        Counts counts(kJobCount);
+        vector<CountJob> work(kJobCount);
+        JobCounter counter;
+
+        for (size_t i = 0u; i < kJobCount; i++)
+        {
+            work[i].pCounts = &counts;
+            work[i].Index = i;
+            jobs.Run(JobDelegate::Bind<CountJob, &CountJob::Execute>(&work[i]), &counter);
+        }
+
+        jobs.Wait(counter);
+        ensure(counter.IsDone());
+
+        for (size_t i = 0u; i < kJobCount; i++) { ensure_equals(counts.Runs[i].Get(), 1); }
+    }
+
+    // Jobs pushed to the main thread's deque are stolen by the workers while the main
+    // thread is busy with one of them.
+    template<> template<>
+    void Object::test<2>()
+    {
+        static const size_t kCount = 64u;
+
+        Jobs jobs(kWorkerCount);
+
+        Counts counts(kCount);
+        vector<CountJob> work(kCount);
+        JobCounter counter;
+
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            work[i].pCounts = &counts;
+            work[i].Index = i;
+            jobs.Run(JobDelegate::Bind<CountJob, &CountJob::ExecuteSlowly>(&work[i]), &counter);
+        }
+
+        jobs.Wait(counter);
+
+        for (size_t i = 0u; i < kCount; i++) { ensure_equals(counts.Runs[i].Get(), 1); }
+        ensure(counts.Stolen.Get() > 0);
+    }
+
+    struct Chain
+    {
+        Chain()
+            : FirstRuns(0), SeenByAfter(-1), AfterRuns(0)
+        {}
+
+        AtomicInt FirstRuns;
+        AtomicInt SeenByAfter;
+        AtomicInt AfterRuns;
+
+        void First() { Thread::Sleep(0u); FirstRuns.Increment(); }
+        void After() { SeenByAfter.Set(FirstRuns.Get()); AfterRuns.Increment(); }
+    };
+
+    // A continuation runs once, after every job of its dependency, and one added to a
+    // completed counter runs straight away.
+    template<> template<>
+    void Object::test<3>()
+    {
+        static const int kFirstCount = 256;
+
+        Jobs jobs(kWorkerCount);
+        Chain chain;
+
+        JobCounter first;
+        JobCounter after;
+
+        for (int i = 0; i < kFirstCount; i++)
+        {
+            jobs.Run(JobDelegate::Bind<Chain, &Chain::First>(&chain), &first);
+        }
+        jobs.RunAfter(first, JobDelegate::Bind<Chain, &Chain::After>(&chain), &after);
+
+        jobs.Wait(after);
+        jobs.Wait(first);
+        ensure_equals(chain.AfterRuns.Get(), 1);
+        ensure_equals(chain.SeenByAfter.Get(), kFirstCount);
+
+        JobCounter late;
+        jobs.RunAfter(first, JobDelegate::Bind<Chain, &Chain::After>(&chain), &late);
+        jobs.Wait(late);
+        ensure_equals(chain.AfterRuns.Get(), 2);
+    }
+
+    struct Sum
+    {
+        Sum(size_t aSize)
+            : Runs(aSize), Calls(0)
+        {}
+
+        vector<AtomicInt> Runs;
+        AtomicInt Calls;
+
+        void operator()(size_t aBegin, size_t aEnd)
+        {
+            Calls.Increment();
+            for (size_t i = aBegin; i < aEnd; i++) { Runs[i].Increment(); }
+        }
+    };
+
+    struct ForeignParallelFor
+    {
+        ForeignParallelFor(Sum& arSum)
+            : rSum(arSum), WorkerIndex(0)
+        {}
+
+        Sum& rSum;
+        s32 WorkerIndex;
+
+        void Run(const Thread&)
+        {
+            WorkerIndex = Jobs::GetCurrentWorkerIndex();
+            Jobs::GetSingleton().ParallelFor(rSum, 0u, rSum.Runs.size(), 1u);
+        }
+    };
+
+    // ParallelFor covers each index once and respects the grain size. From a thread
+    // Jobs does not own, it calls the body inline for the whole range.
+    template<> template<>
+    void Object::test<4>()
+    {
+        static const size_t kSize = 10007u;
+        static const size_t kGrain = 100u;
+
+        Jobs jobs(kWorkerCount);
+
+        {
+            Sum sum(kSize);
+            jobs.ParallelFor(sum, 0u, kSize, kGrain);
+
+            for (size_t i = 0u; i < kSize; i++) { ensure_equals(sum.Runs[i].Get(), 1); }
+            ensure(sum.Calls.Get() > 1);
+            ensure(sum.Calls.Get() <= (s32)((kSize + kGrain - 1u) / kGrain));
+        }
+
+        {
+            Sum sum(kSize);
+            jobs.ParallelFor(sum, 5u, 5u);
+            ensure_equals(sum.Calls.Get(), 0);
+        }
+
+        {
+            Sum sum(kSize);
+            ForeignParallelFor foreign(sum);
+            {
+                Thread thread(tr1::bind(&ForeignParallelFor::Run, &foreign, tr1::placeholders::_1));
+            }
+
+            ensure_equals(foreign.WorkerIndex, -1);
+            ensure_equals(sum.Calls.Get(), 1);
+            for (size_t i = 0u; i < kSize; i++) { ensure_equals(sum.Runs[i].Get(), 1); }
+        }
+    }
+
+    // Jobs still queued when Jobs is destroyed run, along with their continuations.
+    template<> template<>
+    void Object::test<5>()
+    {
+        Chain chain;
+        JobCounter first;
+        JobCounter after;
+
+        {
+            Jobs jobs(0u);
+            jobs.Run(JobDelegate::Bind<Chain, &Chain::First>(&chain), &first);
+            jobs.RunAfter(first, JobDelegate::Bind<Chain, &Chain::After>(&chain), &after);
+            jobs.RunOnMainThread(JobDelegate::Bind<Chain, &Chain::First>(&chain), &first);
+        }
+
+        ensure(first.IsDone());
+        ensure(after.IsDone());
+        ensure_equals(chain.FirstRuns.Get(), 2);
+        ensure_equals(chain.AfterRuns.Get(), 1);
+    }
+
+}
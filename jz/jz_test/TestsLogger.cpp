@@ -0,0 +1,212 @@
+// Filters the JZ_LOG()s of this file at compile time: no verbose messages and no sound
+// messages, whatever the build.
+#define JZ_LOG_MIN_SEVERITY 1
+#define JZ_LOG_CATEGORY_MASK (~(1u << ::jz::Logger::kSound))
+
+#include <jz_core/Logger.h>
+#include <jz_system/Thread.h>
+#include <jz_test/Tests.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace tut
+{
+
+    DUMMY(TestsLogger);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    static const char* kpLog = "jz_test_logger.log";
+    static const uint kThreadCount = 4u;
+
+    // Few enough that the messages of every thread fit in one queue, even when the threads
+    // run one after another and share it.
+    static const uint kMessagesPerThread = 100u;
+    static const uint kLargeMessages = 2000u;
+
+    static void _Begin()
+    {
+        Logger::SetLogFilename(kpLog);
+    }
+
+    static void _End()
+    {
+        Logger::SetLogFilename(Logger::kLogFilename, true);
+        remove(kpLog);
+    }
+
+    // Lines of the log that contain apText.
+    static void _ReadLines(const char* apText, vector<string>& arLines)
+    {
+        Logger::Flush();
+
+        arLines.clear();
+        ifstream file(kpLog);
+        string line;
+        while (getline(file, line))
+        {
+            if (line.find(apText) != string::npos) { arLines.push_back(line); }
+        }
+    }
+
+    static void _LogMessages(uint aThread, const Thread&)
+    {
+        for (uint i = 0u; i < kMessagesPerThread; i++)
+        {
+            JZ_LOG(Logger::kCore, Logger::kNormal, "logger thread % message %", aThread, i);
+        }
+    }
+
+    // Messages from several threads all reach the log, in order per thread.
+    template<> template<>
+    void Object::test<1>()
+    {
+        _Begin();
+
+        try
+        {
+            {
+                Thread thread0(tr1::bind(_LogMessages, 0u, tr1::placeholders::_1));
+                Thread thread1(tr1::bind(_LogMessages, 1u, tr1::placeholders::_1));
+                Thread thread2(tr1::bind(_LogMessages, 2u, tr1::placeholders::_1));
+                Thread thread3(tr1::bind(_LogMessages, 3u, tr1::placeholders::_1));
+            }
+
+            vector<string> lines;
+            _ReadLines("logger thread", lines);
+            ensure_equals(lines.size(), (size_t)(kThreadCount * kMessagesPerThread));
+
+            uint next[kThreadCount] = { 0u };
+            for (size_t i = 0u; i < lines.size(); i++)
+            {
+                uint thread = 0u;
+                uint message = 0u;
+                const char* p = strstr(lines[i].c_str(), "logger thread");
+                ensure(sscanf(p, "logger thread %u message %u", &thread, &message) == 2);
+                ensure(thread < kThreadCount);
+                ensure_equals(message, next[thread]);
+                next[thread]++;
+            }
+        }
+        catch (...)
+        {
+            _End();
+            throw;
+        }
+
+        _End();
+    }
+
+    static int gsEvaluated = 0;
+
+    static int _Evaluate()
+    {
+        gsEvaluated++;
+        return gsEvaluated;
+    }
+
+    // Messages below the compile time severity, or in a masked category, compile to
+    // nothing, their arguments are not even evaluated.
+    template<> template<>
+    void Object::test<2>()
+    {
+        _Begin();
+
+        try
+        {
+            gsEvaluated = 0;
+
+            JZ_LOG(Logger::kCore, Logger::kVerbose, "logger filter verbose %", _Evaluate());
+            JZ_LOG(Logger::kSound, Logger::kError, "logger filter sound %", _Evaluate());
+            ensure_equals(gsEvaluated, 0);
+
+            JZ_LOG(Logger::kCore, Logger::kWarning, "logger filter kept %", _Evaluate());
+            ensure_equals(gsEvaluated, 1);
+
+            vector<string> lines;
+            _ReadLines("logger filter", lines);
+            ensure_equals(lines.size(), 1u);
+            ensure(lines[0].find("logger filter kept 1") != string::npos);
+        }
+        catch (...)
+        {
+            _End();
+            throw;
+        }
+
+        _End();
+    }
+
+    // A full queue drops messages instead of blocking, and counts each one it drops.
+    template<> template<>
+    void Object::test<3>()
+    {
+        _Begin();
+
+        try
+        {
+            const string kLarge(4000u, 'x');
+            const unatural kDroppedBefore = Logger::GetDroppedCount();
+
+            for (uint i = 0u; i < kLargeMessages; i++)
+            {
+                JZ_LOG(Logger::kCore, Logger::kNormal, "logger large % %", i, kLarge);
+            }
+
+            const unatural kDropped = (Logger::GetDroppedCount() - kDroppedBefore);
+            ensure(kDropped > 0u);
+
+            vector<string> lines;
+            _ReadLines("logger large", lines);
+            ensure_equals(lines.size() + kDropped, (size_t)kLargeMessages);
+        }
+        catch (...)
+        {
+            _End();
+            throw;
+        }
+
+        _End();
+    }
+
+    // A thread that exits gives its queue to the next thread that logs.
+    template<> template<>
+    void Object::test<4>()
+    {
+        _Begin();
+
+        try
+        {
+            // One thread first, so that a queue is free for the ones after it.
+            {
+                Thread thread(tr1::bind(_LogMessages, 0u, tr1::placeholders::_1));
+            }
+            const unatural kQueues = Logger::GetThreadQueueCount();
+
+            for (uint i = 0u; i < 20u; i++)
+            {
+                {
+                    Thread thread(tr1::bind(_LogMessages, (i % kThreadCount), tr1::placeholders::_1));
+                }
+
+                // Keeps the shared queue from filling.
+                Logger::Flush();
+            }
+            ensure_equals(Logger::GetThreadQueueCount(), kQueues);
+
+            vector<string> lines;
+            _ReadLines("logger thread", lines);
+            ensure_equals(lines.size(), (size_t)(21u * kMessagesPerThread));
+        }
+        catch (...)
+        {
+            _End();
+            throw;
+        }
+
+        _End();
+    }
+
+}
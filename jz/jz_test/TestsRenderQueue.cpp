@@ -0,0 +1,308 @@
+#include <jz_graphics/RenderNode.h>
+#include <jz_graphics/RenderQueue.h>
+#include <jz_graphics_null/Null.h>
+#include <jz_system/Jobs.h>
+#include <jz_system/Thread.h>
+#include <jz_test/Tests.h>
+#include <cmath>
+#include <vector>
+
+namespace tut
+{
+
+    DUMMY(TestsRenderQueue);
+
+    using namespace jz;
+    using namespace jz::graphics;
+    using namespace jz::system;
+
+    // Distinct addresses to use as effect and draw instances.
+    static const char gskInstances[1024] = { 0 };
+
+    struct DrawRecord
+    {
+        size_t Effect;
+        size_t Draw;
+
+        bool operator==(const DrawRecord& b) const { return (Effect == b.Effect && Draw == b.Draw); }
+    };
+
+    static vector<DrawRecord> gsDraws;
+
+    static size_t _Index(voidc_p p)
+    {
+        return (size_t)(static_cast<const char*>(p) - gskInstances);
+    }
+
+    static void _SetEffect(RenderNode* apNode, voidc_p apInstance)
+    {
+        NullSetState(NullState::kEffect, apInstance);
+        apNode->RenderChildren();
+    }
+
+    static void _SetMesh(RenderNode* apNode, voidc_p apInstance)
+    {
+        NullSetState(NullState::kVertices, apInstance);
+        apNode->RenderChildren();
+    }
+
+    static void _Draw(RenderNode* apNode, voidc_p apInstance)
+    {
+        DrawRecord record;
+        record.Effect = _Index(NullGetState(NullState::kEffect));
+        record.Draw = _Index(apInstance);
+        gsDraws.push_back(record);
+
+        NullDraw(1u);
+        apNode->RenderChildren();
+    }
+
+    static void _Add(RenderQueue& q, u32 aPass, bool abDepthFirst, float aDepth, size_t aEffect, size_t aDraw)
+    {
+        size_t states[RenderQueue::kStateCount] = { 0 };
+        states[RenderQueue::kEffect] = reinterpret_cast<size_t>(gskInstances + aEffect);
+
+        RenderCommand commands[2];
+        commands[0].Op = _SetEffect;
+        commands[0].pInstance = (gskInstances + aEffect);
+        commands[1].Op = _Draw;
+        commands[1].pInstance = (gskInstances + aDraw);
+
+        q.Add(aPass, abDepthFirst, aDepth, states, commands, 2u);
+    }
+
+    // Renders aPass from a cleared device, returns the number of effect changes.
+    static u64 _Render(RenderQueue& q, u32 aPass)
+    {
+        NullClearStates();
+        gsDraws.clear();
+
+        const u64 kBefore = gNullStatistics.Changes[NullState::kEffect];
+        const u64 kDrawsBefore = gNullStatistics.DrawCalls;
+        q.Render(aPass);
+        ensure_equals(gNullStatistics.DrawCalls - kDrawsBefore, (u64)gsDraws.size());
+
+        return (gNullStatistics.Changes[NullState::kEffect] - kBefore);
+    }
+
+    static void _CheckDraws(const size_t* apExpected, size_t aCount)
+    {
+        ensure_equals(gsDraws.size(), aCount);
+        for (size_t i = 0u; i < aCount; i++) { ensure_equals(gsDraws[i].Draw, apExpected[i]); }
+    }
+
+    // Passes render separately, each only its own entries.
+    template<> template<>
+    void Object::test<1>()
+    {
+        RenderQueue q;
+        _Add(q, 2u, false, 0.0f, 0u, 0u);
+        _Add(q, 0u, false, 2.0f, 0u, 1u);
+        _Add(q, 1u, false, 0.0f, 0u, 2u);
+        _Add(q, 0u, false, 1.0f, 0u, 3u);
+
+        ensure(!q.bEmpty(0u));
+        ensure(q.bEmpty(3u));
+
+        static const size_t kPass0[] = { 3u, 1u };
+        ensure_equals(_Render(q, 0u), (u64)1u);
+        _CheckDraws(kPass0, 2u);
+
+        static const size_t kPass1[] = { 2u };
+        _Render(q, 1u);
+        _CheckDraws(kPass1, 1u);
+
+        static const size_t kPass2[] = { 0u };
+        _Render(q, 2u);
+        _CheckDraws(kPass2, 1u);
+
+        ensure_equals(_Render(q, 3u), (u64)0u);
+        ensure(gsDraws.empty());
+
+        q.Reset();
+        ensure(q.bEmpty(0u));
+    }
+
+    // State first entries group by state, nearest state first and front to back within
+    // it. Depth first entries follow them in depth order, whatever their state.
+    template<> template<>
+    void Object::test<2>()
+    {
+        {
+            RenderQueue q;
+            for (size_t i = 0u; i < 6u; i++) { _Add(q, 0u, false, (float)i, (i % 2u), i); }
+
+            static const size_t kExpected[] = { 0u, 2u, 4u, 1u, 3u, 5u };
+            ensure_equals(_Render(q, 0u), (u64)2u);
+            _CheckDraws(kExpected, 6u);
+            ensure_equals(gsDraws[0].Effect, 0u);
+            ensure_equals(gsDraws[3].Effect, 1u);
+        }
+
+        {
+            RenderQueue q;
+            for (size_t i = 0u; i < 6u; i++) { _Add(q, 0u, true, (float)(5u - i), (i % 2u), i); }
+
+            static const size_t kExpected[] = { 5u, 4u, 3u, 2u, 1u, 0u };
+            ensure_equals(_Render(q, 0u), (u64)6u);
+            _CheckDraws(kExpected, 6u);
+        }
+
+        {
+            RenderQueue q;
+            _Add(q, 0u, true, 0.5f, 0u, 0u);
+            _Add(q, 0u, false, 3.0f, 1u, 1u);
+            _Add(q, 0u, true, -1.0f, 1u, 2u);
+            _Add(q, 0u, false, 2.0f, 0u, 3u);
+            _Add(q, 0u, false, 4.0f, 1u, 4u);
+
+            // Effect 1 is nearest, through the depth first entry at -1.
+            static const size_t kExpected[] = { 1u, 4u, 3u, 2u, 0u };
+            ensure_equals(_Render(q, 0u), (u64)4u);
+            _CheckDraws(kExpected, 5u);
+        }
+    }
+
+    // More effects than the key has room for. Ranks past the field are clamped, so
+    // entries of those effects may interleave, but every draw still runs under its own
+    // effect and entries of unclamped effects still share one change.
+    template<> template<>
+    void Object::test<3>()
+    {
+        static const size_t kEffects = 300u;
+        static const size_t kUnclamped = 255u;
+
+        RenderQueue q;
+        for (size_t i = 0u; i < kEffects; i++)
+        {
+            _Add(q, 0u, false, (float)i, i, (i * 2u) + 1u);
+            _Add(q, 0u, false, (float)(1000u - i), i, (i * 2u) + 2u);
+        }
+
+        const u64 kChanges = _Render(q, 0u);
+        ensure_equals(gsDraws.size(), (kEffects * 2u));
+
+        u64 runs = 0u;
+        for (size_t i = 0u; i < gsDraws.size(); i++)
+        {
+            ensure_equals((gsDraws[i].Draw - 1u) / 2u, gsDraws[i].Effect);
+            if (i == 0u || gsDraws[i].Effect != gsDraws[i - 1u].Effect) { runs++; }
+        }
+        ensure_equals(kChanges, runs);
+
+        for (size_t i = 0u; i < (kUnclamped * 2u); i += 2u)
+        {
+            ensure_equals(gsDraws[i].Effect, (i / 2u));
+            ensure_equals(gsDraws[i + 1u].Effect, (i / 2u));
+        }
+        ensure(kChanges >= kEffects);
+    }
+
+    // Appended queues sort as if their entries had been added to one queue, including
+    // after the target has already been sorted.
+    template<> template<>
+    void Object::test<4>()
+    {
+        RenderQueue reference;
+        for (size_t i = 0u; i < 8u; i++) { _Add(reference, (u32)(i % 2u), (i == 5u), (float)(8u - i), (i % 3u), i); }
+
+        RenderQueue a;
+        RenderQueue b;
+        for (size_t i = 0u; i < 8u; i++) { _Add((i < 3u) ? a : b, (u32)(i % 2u), (i == 5u), (float)(8u - i), (i % 3u), i); }
+
+        _Render(a, 0u);
+        a.Append(b);
+
+        for (u32 pass = 0u; pass < 2u; pass++)
+        {
+            const u64 kExpectedChanges = _Render(reference, pass);
+            const vector<DrawRecord> kExpected(gsDraws);
+            ensure_equals(kExpected.size(), 4u);
+
+            ensure_equals(_Render(a, pass), kExpectedChanges);
+            ensure(gsDraws == kExpected);
+        }
+
+        ensure_equals(_Render(b, 1u), (u64)3u);
+    }
+
+    static const size_t kSceneSize = 500u;
+    static const uint kSceneWorkers = 3u;
+
+    // Entry i of a scene of mixed passes, states and sort modes. Depths differ in their
+    // upper 16 bits, so no two entries tie in either key layout.
+    static void _Pose(RenderQueue& q, size_t i)
+    {
+        const size_t kEffect = (i % 5u);
+        const size_t kMesh = 8u + (i % 11u);
+
+        size_t states[RenderQueue::kStateCount] = { 0 };
+        states[RenderQueue::kEffect] = reinterpret_cast<size_t>(gskInstances + kEffect);
+        states[RenderQueue::kMesh] = reinterpret_cast<size_t>(gskInstances + kMesh);
+
+        RenderCommand commands[3];
+        commands[0].Op = _SetEffect;
+        commands[0].pInstance = (gskInstances + kEffect);
+        commands[1].Op = _SetMesh;
+        commands[1].pInstance = (gskInstances + kMesh);
+        commands[2].Op = _Draw;
+        commands[2].pInstance = (gskInstances + 32u + i);
+
+        const float kDepth = (float)ldexp(1.0 + (double)((i * 37u) % 128u) / 128.0, (int)(i / 128u));
+        q.Add((u32)(i % 3u), ((i % 7u) == 0u), kDepth, states, commands, 3u);
+    }
+
+    // Poses into the calling worker's queue, the main thread into the first, as RenderMan
+    // does.
+    struct SceneBody
+    {
+        SceneBody(RenderQueue* apQueues)
+            : pQueues(apQueues)
+        {}
+
+        RenderQueue* pQueues;
+
+        void operator()(size_t aBegin, size_t aEnd)
+        {
+            RenderQueue& q = pQueues[Max(Jobs::GetCurrentWorkerIndex(), 0)];
+            for (size_t i = aBegin; i < aEnd; i++) { _Pose(q, i); }
+
+            // Lets the other workers take ranges, even on a single core.
+            Thread::Sleep(1u);
+        }
+    };
+
+    // A scene posed with ParallelFor into per worker queues and merged renders the same
+    // op sequence, with the same state changes, as the scene posed serially.
+    template<> template<>
+    void Object::test<5>()
+    {
+        RenderQueue serial;
+        for (size_t i = 0u; i < kSceneSize; i++) { _Pose(serial, i); }
+
+        Jobs jobs(kSceneWorkers);
+        RenderQueue queues[kSceneWorkers + 1u];
+        {
+            SceneBody body(queues);
+            jobs.ParallelFor(body, 0u, kSceneSize, 16u);
+        }
+        for (uint i = 1u; i <= kSceneWorkers; i++) { queues[0].Append(queues[i]); }
+
+        for (u32 pass = 0u; pass < 3u; pass++)
+        {
+            const u64 kVerticesBefore = gNullStatistics.Changes[NullState::kVertices];
+            const u64 kEffectChanges = _Render(serial, pass);
+            const u64 kVertexChanges = (gNullStatistics.Changes[NullState::kVertices] - kVerticesBefore);
+            const vector<DrawRecord> kExpected(gsDraws);
+
+            ensure(kExpected.size() > (kSceneSize / 4u));
+            ensure(kEffectChanges < kExpected.size());
+
+            const u64 kParallelVerticesBefore = gNullStatistics.Changes[NullState::kVertices];
+            ensure_equals(_Render(queues[0], pass), kEffectChanges);
+            ensure_equals(gNullStatistics.Changes[NullState::kVertices] - kParallelVerticesBefore, kVertexChanges);
+            ensure(gsDraws == kExpected);
+        }
+    }
+
+}
@@ -0,0 +1,207 @@
+#include <jz_core/StringUtility.h>
+#include <jz_engine_3D/AnimatedMeshNode.h>
+#include <jz_engine_3D/JointNode.h>
+#include <jz_engine_3D/SceneNode.h>
+#include <jz_test/Tests.h>
+#include <cstring>
+#include <vector>
+
+namespace tut
+{
+
+    DUMMY(TestsSceneNode);
+
+    using namespace jz;
+    using namespace jz::engine_3D;
+    using namespace jz::system;
+
+    static StringId _Id(size_t i)
+    {
+        return StringId(("node " + StringUtility::ToString(i)).c_str());
+    }
+
+    static void _Count(size_t* apCount, SceneNode* p)
+    {
+        (*apCount)++;
+    }
+
+    static void _Store(SceneNode** appOut, SceneNode* p)
+    {
+        *appOut = p;
+    }
+
+    // Nodes stay findable by id as others are removed from between them, which shifts
+    // the runs of the registry back over the removed entries.
+    template<> template<>
+    void Object::test<1>()
+    {
+        const size_t kCount = 3000u;
+        const StringId kBaseId("scene node registry");
+
+        vector<SceneNodePtr> nodes;
+        for (size_t i = 0u; i < kCount; i++) { nodes.push_back(SceneNodePtr(new SceneNode(kBaseId, _Id(i)))); }
+
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            ensure(SceneNode::Get<SceneNode>(kBaseId, _Id(i)) == nodes[i]);
+        }
+
+        // Every third node, and one long run.
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            if ((i % 3u) == 0u || (i > 1000u && i < 1500u)) { nodes[i].Reset(); }
+        }
+
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            ensure(SceneNode::Get<SceneNode>(kBaseId, _Id(i)) == nodes[i]);
+        }
+
+        // Renamed nodes are found under their new id only.
+        nodes[1]->SetId(_Id(kCount));
+        ensure(!SceneNode::Get<SceneNode>(kBaseId, _Id(1u)).IsValid());
+        ensure(SceneNode::Get<SceneNode>(kBaseId, _Id(kCount)) == nodes[1]);
+
+        // The same id under another base id is another node.
+        SceneNodePtr other(new SceneNode(StringId("scene node registry other"), _Id(2u)));
+        ensure(SceneNode::Get<SceneNode>(kBaseId, _Id(2u)) == nodes[2]);
+        ensure(SceneNode::Get<SceneNode>("scene node registry other", "node 2") == other);
+
+        nodes.clear();
+        other.Reset();
+
+        for (size_t i = 0u; i <= kCount; i++)
+        {
+            ensure(!SceneNode::Get<SceneNode>(kBaseId, _Id(i)).IsValid());
+        }
+    }
+
+    // Pending retrievals run once, for the node with their ids only, and lookups by
+    // string do not intern ids that no node has.
+    template<> template<>
+    void Object::test<2>()
+    {
+        const StringId kBaseId("scene node retrieve");
+
+        size_t count = 0u;
+        SceneNode* pFound = null;
+
+        SceneNode::Get(kBaseId, StringId("wanted"), tr1::bind(_Count, &count, tr1::placeholders::_1));
+        SceneNode::Get(kBaseId, StringId("wanted"), tr1::bind(_Store, &pFound, tr1::placeholders::_1));
+
+        SceneNodePtr other(new SceneNode(kBaseId, StringId("unwanted")));
+        ensure_equals(count, 0u);
+        ensure(pFound == null);
+
+        SceneNodePtr wanted(new SceneNode(kBaseId, StringId("wanted")));
+        ensure_equals(count, 1u);
+        ensure(pFound == wanted.Get());
+
+        wanted.Reset();
+        SceneNodePtr again(new SceneNode(kBaseId, StringId("wanted")));
+        ensure_equals(count, 1u);
+
+        // Found at once when the node exists.
+        SceneNode::Get(kBaseId, StringId("wanted"), tr1::bind(_Count, &count, tr1::placeholders::_1));
+        ensure_equals(count, 2u);
+
+        const char* kpMissing = "scene node never interned";
+        ensure(!SceneNode::Get<SceneNode>("scene node retrieve", kpMissing).IsValid());
+        ensure(!SceneNode::Get<SceneNode>(kpMissing, "wanted").IsValid());
+        ensure(StringId::Find(kpMissing, strlen(kpMissing)).empty());
+        ensure(SceneNode::Get<SceneNode>("scene node retrieve", "wanted") == again);
+    }
+
+    static StringId _InstanceBaseId(size_t i)
+    {
+        return StringId(("scene node instance " + StringUtility::ToString(i)).c_str());
+    }
+
+    // Instances have their own nodes, found under their own base ids, and share key
+    // frames and skins with the prefab until one of them changes its copy.
+    template<> template<>
+    void Object::test<3>()
+    {
+        const StringId kBaseId("scene node prefab");
+        const size_t kCount = 3u;
+
+        SceneNodePtr parent(new SceneNode());
+        SceneNodePtr prefab(new SceneNode(kBaseId, StringId("root")));
+        prefab->SetLocalTransform(Matrix4::CreateTranslation(Vector3(0.0f, 5.0f, 0.0f)));
+
+        JointNodePtr joint(new JointNode(kBaseId, StringId("joint")));
+        joint->GetAnimation().KeyFrames.resize(2u);
+        joint->GetAnimation().KeyFrames[0].Key = Matrix4::kIdentity;
+        joint->GetAnimation().KeyFrames[1].Key = Matrix4::CreateTranslation(Vector3(1.0f, 0.0f, 0.0f));
+        joint->SetParent(prefab.Get());
+
+        AnimatedMeshNodeNodePtr mesh(new AnimatedMeshNode(kBaseId, StringId("mesh")));
+        mesh->GetInvBindTransforms().resize(1u);
+        mesh->GetInvBindTransforms()[0] = Matrix4::kIdentity;
+        mesh->GetJointIds().push_back(StringId("joint"));
+        mesh->SetRootJointId(StringId("joint"));
+        mesh->SetParent(prefab.Get());
+
+        vector<Matrix4> transforms;
+        for (size_t i = 0u; i < kCount; i++) { transforms.push_back(Matrix4::CreateTranslation(Vector3((float)i, 0.0f, 0.0f))); }
+
+        vector<SceneNodePtr> instances;
+        prefab->Instantiate(parent.Get(), StringId("scene node instance "), kCount, &transforms[0], instances);
+        ensure_equals(instances.size(), kCount);
+
+        const JointNode& kJoint = *joint;
+        const AnimatedMeshNode& kMesh = *mesh;
+
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            ensure(instances[i]->GetParent() == parent.Get());
+            ensure(instances[i]->GetBaseId() == _InstanceBaseId(i));
+            ensure(instances[i]->GetId() == StringId("root"));
+            ensure(instances[i]->GetLocalTransform() == transforms[i]);
+
+            JointNodePtr p(SceneNode::Get<JointNode>(_InstanceBaseId(i), StringId("joint")));
+            ensure(p.IsValid());
+            ensure(p != joint);
+            ensure(p->GetParent() == instances[i].Get());
+
+            AnimatedMeshNodeNodePtr m(SceneNode::Get<AnimatedMeshNode>(_InstanceBaseId(i), StringId("mesh")));
+            ensure(m.IsValid());
+            ensure(m != mesh);
+            ensure(m->GetAnimationControl() != mesh->GetAnimationControl());
+
+            const JointNode& kInstanceJoint = *p;
+            const AnimatedMeshNode& kInstanceMesh = *m;
+            ensure(&kInstanceJoint.GetAnimation() == &kJoint.GetAnimation());
+            ensure(&kInstanceMesh.GetInvBindTransforms() == &kMesh.GetInvBindTransforms());
+        }
+
+        // Changing an instance copies its data first, the prefab and the other instances
+        // keep theirs.
+        JointNodePtr joint0(SceneNode::Get<JointNode>(_InstanceBaseId(0u), StringId("joint")));
+        joint0->GetAnimation().KeyFrames[1].Key = Matrix4::CreateTranslation(Vector3(2.0f, 0.0f, 0.0f));
+
+        AnimatedMeshNodeNodePtr mesh0(SceneNode::Get<AnimatedMeshNode>(_InstanceBaseId(0u), StringId("mesh")));
+        mesh0->SetBindTransform(Matrix4::CreateTranslation(Vector3(0.0f, 0.0f, 2.0f)));
+
+        const JointNode& kJoint0 = *joint0;
+        const JointNode& kJoint1 = *SceneNode::Get<JointNode>(_InstanceBaseId(1u), StringId("joint"));
+        ensure(&kJoint0.GetAnimation() != &kJoint.GetAnimation());
+        ensure(&kJoint1.GetAnimation() == &kJoint.GetAnimation());
+        ensure(kJoint.GetAnimation().KeyFrames[1].Key == Matrix4::CreateTranslation(Vector3(1.0f, 0.0f, 0.0f)));
+
+        const AnimatedMeshNode& kMesh0 = *mesh0;
+        const AnimatedMeshNode& kMesh1 = *SceneNode::Get<AnimatedMeshNode>(_InstanceBaseId(1u), StringId("mesh"));
+        ensure(&kMesh0.GetInvBindTransforms() != &kMesh.GetInvBindTransforms());
+        ensure(&kMesh1.GetInvBindTransforms() == &kMesh.GetInvBindTransforms());
+        ensure(kMesh.GetBindTransform() == Matrix4::kIdentity);
+        ensure(kMesh0.GetJointIds() == kMesh.GetJointIds());
+
+        // Without transforms, instances keep the prefab's.
+        vector<SceneNodePtr> more;
+        prefab->Instantiate(parent.Get(), StringId("scene node more "), 2u, null, more);
+        ensure_equals(more.size(), 2u);
+        ensure(more[1]->GetLocalTransform() == prefab->GetLocalTransform());
+        ensure(SceneNode::Get<JointNode>(StringId("scene node more 1"), StringId("joint")).IsValid());
+    }
+
+}
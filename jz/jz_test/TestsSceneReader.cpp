@@ -0,0 +1,310 @@
+#include <jz_core/Matrix4.h>
+#include <jz_engine_3D/JointNode.h>
+#include <jz_engine_3D/LightNode.h>
+#include <jz_engine_3D/SceneReader.h>
+#include <jz_system/Files.h>
+#include <jz_test/Tests.h>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace tut
+{
+
+    DUMMY(TestsSceneReader);
+
+    using namespace jz;
+    using namespace jz::engine_3D;
+    using namespace jz::system;
+
+    static const char* kpSceneFilename = "jz_test_scene.jzs";
+    static const char* kpSceneBaseId = "scene reader";
+
+    enum
+    {
+        kDirectionalLight = 3,
+        kJoint = 4,
+        kNode = 7
+    };
+
+    static void _Append(vector<u8>& arOut, voidc_p apData, size_t aSize)
+    {
+        const u8* p = static_cast<const u8*>(apData);
+        arOut.insert(arOut.end(), p, p + aSize);
+    }
+
+    static void _AppendString(vector<u8>& arOut, const char* apString)
+    {
+        const u32 kSize = (u32)(strlen(apString) + 1u);
+        _Append(arOut, &kSize, sizeof(u32));
+        _Append(arOut, apString, kSize);
+    }
+
+    static void _Align(vector<u8>& arOut)
+    {
+        while ((arOut.size() % SceneFile::kAlignment) != 0u) { arOut.push_back(0u); }
+    }
+
+    // Lays out a binary scene as SceneFile describes it.
+    class SceneBuilder sealed
+    {
+    public:
+        void Add(u32 aParent, const char* apId, u32 aType, const vector<u8>& aPayload)
+        {
+            SceneFile::Node node;
+            node.Parent = aParent;
+            node.BaseId = 0u;
+            node.Id = (u32)mStrings.size() + (u32)strlen(kpSceneBaseId) + 1u;
+            node.Type = aType;
+            node.Payload = (u32)mPayload.size();
+            node.PayloadSize = (u32)aPayload.size();
+
+            mNodes.push_back(node);
+            mStrings.insert(mStrings.end(), apId, apId + strlen(apId) + 1u);
+            mPayload.insert(mPayload.end(), aPayload.begin(), aPayload.end());
+        }
+
+        void Write(vector<u8>& arOut, SceneFile::Header& arHeader) const
+        {
+            const u32 kCount = (u32)mNodes.size();
+
+            arOut.assign(sizeof(SceneFile::Header), 0u);
+
+            memset(&arHeader, 0, sizeof(SceneFile::Header));
+            arHeader.Magic = SceneFile::kMagic;
+            arHeader.Version = SceneFile::kVersion;
+            arHeader.HeaderSize = (u16)sizeof(SceneFile::Header);
+            arHeader.NodeCount = kCount;
+
+            _Align(arOut);
+            arHeader.TransformsOffset = (u32)arOut.size();
+            for (u32 i = 0u; i < kCount; i++)
+            {
+                const Matrix4 kLocal = Matrix4::CreateTranslation(Vector3((float)i, 0.0f, 0.0f));
+                _Append(arOut, kLocal.pData, sizeof(Matrix4));
+            }
+
+            _Align(arOut);
+            arHeader.NodesOffset = (u32)arOut.size();
+            _Append(arOut, &mNodes[0], kCount * sizeof(SceneFile::Node));
+
+            _Align(arOut);
+            arHeader.StringsOffset = (u32)arOut.size();
+            _Append(arOut, kpSceneBaseId, strlen(kpSceneBaseId) + 1u);
+            _Append(arOut, &mStrings[0], mStrings.size());
+            arHeader.StringsSize = ((u32)arOut.size() - arHeader.StringsOffset);
+
+            _Align(arOut);
+            arHeader.PayloadOffset = (u32)arOut.size();
+            if (!mPayload.empty()) { _Append(arOut, &mPayload[0], mPayload.size()); }
+            arHeader.PayloadSize = (u32)mPayload.size();
+
+            memcpy(&arOut[0], &arHeader, sizeof(SceneFile::Header));
+        }
+
+    private:
+        vector<SceneFile::Node> mNodes;
+        vector<char> mStrings;
+        vector<u8> mPayload;
+    };
+
+    static KeyFrame _Key(size_t i)
+    {
+        KeyFrame ret;
+        ret.Key = Matrix4::CreateTranslation(Vector3(0.0f, (float)i, 0.0f));
+        ret.TimeAndPadding = Vector4((float)i, 0.0f, 0.0f, 0.0f);
+
+        return ret;
+    }
+
+    // A root with a joint and a light under it, and a plain node under the joint.
+    static void _BuildScene(vector<u8>& arOut, SceneFile::Header& arHeader)
+    {
+        SceneBuilder builder;
+
+        builder.Add(SceneFile::kNoParent, "root", kNode, vector<u8>());
+
+        vector<u8> joint;
+        _AppendString(joint, "animation");
+        const u32 kKeys = 2u;
+        _Append(joint, &kKeys, sizeof(u32));
+        for (u32 i = 0u; i < kKeys; i++)
+        {
+            const KeyFrame kKey = _Key(i);
+            _Append(joint, &kKey, sizeof(KeyFrame));
+        }
+        builder.Add(0u, "joint", kJoint, joint);
+
+        vector<u8> light;
+        const Vector3 kColor(0.25f, 0.5f, 0.75f);
+        _Append(light, &kColor, sizeof(Vector3));
+        builder.Add(0u, "light", kDirectionalLight, light);
+
+        builder.Add(1u, "leaf", kNode, vector<u8>());
+
+        builder.Write(arOut, arHeader);
+    }
+
+    static SceneNodePtr _Load(const vector<u8>& aScene)
+    {
+        FILE* pFile = fopen(kpSceneFilename, "wb");
+        ensure(pFile != null);
+        const size_t kWritten = fwrite(&aScene[0], 1u, aScene.size(), pFile);
+        fclose(pFile);
+        ensure_equals(kWritten, aScene.size());
+
+        return LoadScene(kpSceneFilename);
+    }
+
+    static void _EnsureFails(const vector<u8>& aScene)
+    {
+        bool bThrown = false;
+        try
+        {
+            _Load(aScene);
+        }
+        catch (std::exception&)
+        {
+            bThrown = true;
+        }
+
+        ensure(bThrown);
+    }
+
+    static SceneFile::Node& _Node(vector<u8>& arScene, const SceneFile::Header& aHeader, u32 i)
+    {
+        return *reinterpret_cast<SceneFile::Node*>(&arScene[aHeader.NodesOffset + (i * sizeof(SceneFile::Node))]);
+    }
+
+    // A valid scene comes back with its hierarchy, ids, transforms and payloads.
+    template<> template<>
+    void Object::test<1>()
+    {
+        Files files;
+
+        vector<u8> scene;
+        SceneFile::Header header;
+        _BuildScene(scene, header);
+
+        try
+        {
+            SceneNodePtr root(_Load(scene));
+            remove(kpSceneFilename);
+
+            ensure(root.IsValid());
+            ensure(root->GetBaseId() == StringId(kpSceneBaseId));
+            ensure(root->GetId() == StringId("root"));
+            ensure(root->GetParent() == null);
+
+            SceneNode::iterator I = root->begin();
+            ensure(I != root->end());
+            JointNode* pJoint = SceneNodeCast<JointNode>(&(*I));
+            ensure(pJoint != null);
+            ensure(pJoint->GetId() == StringId("joint"));
+            ensure(Matrix4::AboutEqual(pJoint->GetLocalTransform(), Matrix4::CreateTranslation(Vector3(1.0f, 0.0f, 0.0f))));
+            const Animation& animation = pJoint->GetAnimation();
+            ensure_equals(animation.GetKeyCount(), 2u);
+            ensure_equals(animation.GetTime(1u), 1.0f);
+            Matrix4 key;
+            animation.Sample(1u, 1.0f, key);
+            ensure(Matrix4::AboutEqual(key, _Key(1u).Key, Constants<float>::kLooseTolerance));
+
+            I++;
+            ensure(I != root->end());
+            LightNode* pLight = SceneNodeCast<LightNode>(&(*I));
+            ensure(pLight != null);
+            ensure(pLight->GetId() == StringId("light"));
+            ensure(pLight->GetType() == LightNodeType::kDirectional);
+            ensure(pLight->GetColor() == Vector3(0.25f, 0.5f, 0.75f));
+
+            I++;
+            ensure(I == root->end());
+
+            ensure(pJoint->begin() != pJoint->end());
+            ensure(pJoint->begin()->GetId() == StringId("leaf"));
+            ensure(Matrix4::AboutEqual(pJoint->begin()->GetLocalTransform(), Matrix4::CreateTranslation(Vector3(3.0f, 0.0f, 0.0f))));
+        }
+        catch (...)
+        {
+            remove(kpSceneFilename);
+            throw;
+        }
+    }
+
+    // Damaged scenes are rejected, and leave no nodes behind to collide with the next
+    // load.
+    template<> template<>
+    void Object::test<2>()
+    {
+        Files files;
+
+        vector<u8> valid;
+        SceneFile::Header header;
+        _BuildScene(valid, header);
+
+        try
+        {
+            // Truncated.
+            {
+                vector<u8> scene(valid);
+                scene.resize(scene.size() / 2u);
+                _EnsureFails(scene);
+            }
+
+            // A parent that is not before its child.
+            {
+                vector<u8> scene(valid);
+                _Node(scene, header, 3u).Parent = 3u;
+                _EnsureFails(scene);
+            }
+
+            // A second root.
+            {
+                vector<u8> scene(valid);
+                _Node(scene, header, 2u).Parent = SceneFile::kNoParent;
+                _EnsureFails(scene);
+            }
+
+            // Strings without a final terminator.
+            {
+                vector<u8> scene(valid);
+                scene[header.StringsOffset + header.StringsSize - 1u] = 'x';
+                _EnsureFails(scene);
+            }
+
+            // An id past the strings.
+            {
+                vector<u8> scene(valid);
+                _Node(scene, header, 1u).Id = header.StringsSize;
+                _EnsureFails(scene);
+            }
+
+            // A payload past the payload section.
+            {
+                vector<u8> scene(valid);
+                _Node(scene, header, 2u).Payload = header.PayloadSize;
+                _EnsureFails(scene);
+            }
+
+            // A payload shorter than its node reads. The bytes after it are in the file,
+            // but belong to no node.
+            {
+                vector<u8> scene(valid);
+                _Node(scene, header, 2u).PayloadSize -= 4u;
+                _EnsureFails(scene);
+            }
+
+            SceneNodePtr root(_Load(valid));
+            ensure(root.IsValid());
+        }
+        catch (...)
+        {
+            remove(kpSceneFilename);
+            throw;
+        }
+
+        remove(kpSceneFilename);
+    }
+
+}
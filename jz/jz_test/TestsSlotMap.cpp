@@ -0,0 +1,75 @@
+#include <jz_core/SlotMap.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsSlotMap);
+
+    using namespace jz;
+
+    typedef SlotMap<int> IntMap;
+
+    template<> template<>
+    void Object::test<1>()
+    {
+        IntMap map;
+        ensure(map.empty());
+        ensure(!map.IsValid(IntMap::kInvalidHandle));
+
+        IntMap::handle_type a = map.Add(1);
+        IntMap::handle_type b = map.Add(2);
+        IntMap::handle_type c = map.Add(3);
+
+        ensure_equals(map.size(), 3u);
+        ensure_equals(map[a], 1);
+        ensure_equals(map[b], 2);
+        ensure_equals(map[c], 3);
+
+        ensure(map.Remove(a));
+        ensure(!map.Remove(a));
+        ensure(!map.IsValid(a));
+        ensure(map.Find(a) == null);
+        ensure_equals(map.size(), 2u);
+        ensure_equals(map[b], 2);
+        ensure_equals(map[c], 3);
+
+        // Reusing a slot must not revive the stale handle.
+        IntMap::handle_type d = map.Add(4);
+        IntMap::handle_type e = map.Add(5);
+        ensure(map.IsValid(d));
+        ensure(map.IsValid(e));
+        ensure(!map.IsValid(a));
+        ensure(a != d && a != e);
+    }
+
+    template<> template<>
+    void Object::test<2>()
+    {
+        IntMap map;
+        vector<IntMap::handle_type> handles;
+
+        for (int i = 0; i < 1000; i++) { handles.push_back(map.Add(i)); }
+        for (int i = 0; i < 1000; i += 2) { ensure(map.Remove(handles[i])); }
+
+        ensure_equals(map.size(), 500u);
+
+        int sum = 0;
+        for (IntMap::iterator I = map.begin(); I != map.end(); I++) { sum += *I; }
+        ensure_equals(sum, 250000);
+
+        for (IntMap::size_type i = 0u; i < map.size(); i++)
+        {
+            IntMap::handle_type h = map.GetHandleFromDense(i);
+            ensure(map.IsValid(h));
+            ensure_equals(map[h], *(map.begin() + i));
+        }
+
+        for (int i = 1; i < 1000; i += 2) { ensure_equals(map[handles[i]], i); }
+
+        map.clear();
+        ensure(map.empty());
+        for (int i = 0; i < 1000; i++) { ensure(!map.IsValid(handles[i])); }
+    }
+
+}
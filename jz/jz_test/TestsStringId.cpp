@@ -0,0 +1,80 @@
+#include <jz_core/StringUtility.h>
+#include <jz_system/StringId.h>
+#include <jz_test/Tests.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace tut
+{
+
+    DUMMY(TestsStringId);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    static StringId _Find(const char* apString)
+    {
+        return StringId::Find(apString, strlen(apString));
+    }
+
+    // Equal strings intern to one entry, and Find() never adds one.
+    template<> template<>
+    void Object::test<1>()
+    {
+        ensure(StringId().empty());
+        ensure(StringId("").empty());
+        ensure(_Find("").empty());
+
+        ensure(_Find("string id never interned").empty());
+        ensure(_Find("string id never interned").empty());
+
+        const StringId a("string id a");
+        const StringId b(string("string id a"));
+        const StringId c("string id abc", 11u);
+
+        ensure(!a.empty());
+        ensure(a == b);
+        ensure(a == c);
+        ensure(a.c_str() == b.c_str());
+        ensure(a.GetHash() == StringId::Hash("string id a", 11u));
+        ensure(strcmp(a.c_str(), "string id a") == 0);
+        ensure(_Find("string id a") == a);
+
+        ensure(a != StringId("string id b"));
+        ensure(StringId::Append(a, "bc") == StringId("string id abc"));
+        ensure(StringId::Append(StringId(), "string id a") == a);
+    }
+
+    // Entries stay valid as the table grows and blocks fill, including strings too long
+    // to pack into a block.
+    template<> template<>
+    void Object::test<2>()
+    {
+        const size_t kCount = 5000u;
+
+        vector<StringId> ids;
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            ids.push_back(StringId(("string id pool " + StringUtility::ToString(i)).c_str()));
+        }
+
+        const string kLong(40000u, 'x');
+        const StringId kLongId(kLong);
+        const StringId kAppended(StringId::Append(StringId("string id long "), kLong.c_str()));
+
+        for (size_t i = 0u; i < kCount; i++)
+        {
+            const string kExpected("string id pool " + StringUtility::ToString(i));
+
+            ensure(strcmp(ids[i].c_str(), kExpected.c_str()) == 0);
+            ensure(_Find(kExpected.c_str()) == ids[i]);
+        }
+
+        ensure(kLongId.c_str() != kLong.c_str());
+        ensure(kLong == kLongId.c_str());
+        ensure(_Find(kLong.c_str()) == kLongId);
+        ensure(("string id long " + kLong) == kAppended.c_str());
+    }
+
+}
@@ -0,0 +1,233 @@
+#include <jz_core/Atomic.h>
+#include <jz_system/ConditionVariable.h>
+#include <jz_system/Mutex.h>
+#include <jz_system/ReaderWriterLock.h>
+#include <jz_system/Semaphore.h>
+#include <jz_system/Thread.h>
+#include <jz_system/ThreadLocal.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsThreading);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    static const int kSignalCount = 1000;
+
+    struct SemaphoreSignaller
+    {
+        SemaphoreSignaller(Semaphore& arSemaphore)
+            : rSemaphore(arSemaphore)
+        {}
+
+        Semaphore& rSemaphore;
+
+        void Run(const Thread&)
+        {
+            for (int i = 0; i < kSignalCount; i += 2)
+            {
+                rSemaphore.Signal(2u);
+                if ((i % 64) == 0) { Thread::Sleep(0u); }
+            }
+        }
+    };
+
+    // Each Signal() allows exactly as many waits as its count, from any thread.
+    template<> template<>
+    void Object::test<1>()
+    {
+        {
+            Semaphore semaphore(2u);
+            ensure(semaphore.TryWait());
+            ensure(semaphore.TryWait());
+            ensure(!semaphore.TryWait());
+
+            semaphore.Signal(3u);
+            ensure(semaphore.TryWait());
+            ensure(semaphore.TryWait());
+            ensure(semaphore.TryWait());
+            ensure(!semaphore.TryWait());
+        }
+
+        {
+            Semaphore semaphore;
+            SemaphoreSignaller signaller(semaphore);
+
+            int waits = 0;
+            {
+                Thread thread(tr1::bind(&SemaphoreSignaller::Run, &signaller, tr1::placeholders::_1));
+                for (; waits < kSignalCount; waits++) { semaphore.Wait(); }
+            }
+
+            ensure_equals(waits, kSignalCount);
+            ensure(!semaphore.TryWait());
+        }
+    }
+
+    struct ReaderWriterStress
+    {
+        ReaderWriterStress()
+            : Readers(0), MaxReaders(0), Writing(0), Violations(0), Value(0)
+        {}
+
+        ReaderWriterLock Lock;
+        AtomicInt Readers;
+        AtomicInt MaxReaders;
+        AtomicInt Writing;
+        AtomicInt Violations;
+        int Value;
+
+        void Read(const Thread&)
+        {
+            for (int i = 0; i < 50; i++)
+            {
+                ReadLock lock(Lock);
+
+                const s32 kReaders = Readers.Increment();
+                if (Writing.Get() != 0) { Violations.Increment(); }
+
+                s32 max = MaxReaders.Get();
+                while (kReaders > max && MaxReaders.CompareExchange(kReaders, max) != max) { max = MaxReaders.Get(); }
+
+                const int kValue = Value;
+                Thread::Sleep(1u);
+                if (Value != kValue) { Violations.Increment(); }
+
+                Readers.Decrement();
+            }
+        }
+
+        void Write(const Thread&)
+        {
+            for (int i = 0; i < 50; i++)
+            {
+                WriteLock lock(Lock);
+
+                if (Writing.Increment() != 1 || Readers.Get() != 0) { Violations.Increment(); }
+                Value++;
+                Thread::Sleep(0u);
+                Writing.Decrement();
+            }
+        }
+    };
+
+    // Readers share the lock, a writer holds it alone.
+    template<> template<>
+    void Object::test<2>()
+    {
+        ReaderWriterStress stress;
+        {
+            Thread reader0(tr1::bind(&ReaderWriterStress::Read, &stress, tr1::placeholders::_1));
+            Thread reader1(tr1::bind(&ReaderWriterStress::Read, &stress, tr1::placeholders::_1));
+            Thread reader2(tr1::bind(&ReaderWriterStress::Read, &stress, tr1::placeholders::_1));
+            Thread writer0(tr1::bind(&ReaderWriterStress::Write, &stress, tr1::placeholders::_1));
+            Thread writer1(tr1::bind(&ReaderWriterStress::Write, &stress, tr1::placeholders::_1));
+        }
+
+        ensure_equals(stress.Violations.Get(), 0);
+        ensure_equals(stress.Value, 100);
+        ensure(stress.MaxReaders.Get() > 1);
+    }
+
+    struct Mailbox
+    {
+        Mailbox()
+            : Posted(0), Taken(0), bClosed(false)
+        {}
+
+        Mutex Access;
+        ConditionVariable Condition;
+        int Posted;
+        int Taken;
+        bool bClosed;
+
+        void Take(const Thread&)
+        {
+            Lock lock(Access);
+            while (true)
+            {
+                while (Taken == Posted && !bClosed) { Condition.Wait(Access); }
+                if (Taken == Posted) { return; }
+                Taken++;
+            }
+        }
+    };
+
+    // A notified waiter sees the state set under the mutex, NotifyAll() wakes every
+    // waiter, and a timed wait with no notify times out.
+    template<> template<>
+    void Object::test<3>()
+    {
+        {
+            Mailbox mailbox;
+            Lock lock(mailbox.Access);
+            ensure(!mailbox.Condition.Wait(mailbox.Access, 10u));
+        }
+
+        Mailbox mailbox;
+        {
+            Thread taker0(tr1::bind(&Mailbox::Take, &mailbox, tr1::placeholders::_1));
+            Thread taker1(tr1::bind(&Mailbox::Take, &mailbox, tr1::placeholders::_1));
+
+            for (int i = 0; i < kSignalCount; i++)
+            {
+                Lock lock(mailbox.Access);
+                mailbox.Posted++;
+                mailbox.Condition.NotifyOne();
+            }
+
+            // Both takers must wake to see the close, or the joins below hang.
+            Lock lock(mailbox.Access);
+            mailbox.bClosed = true;
+            mailbox.Condition.NotifyAll();
+        }
+
+        ensure_equals(mailbox.Taken, kSignalCount);
+    }
+
+    struct LocalValues
+    {
+        LocalValues()
+            : bStartedNull(false), bKeptOwn(false)
+        {}
+
+        ThreadLocal<int> Local;
+        bool bStartedNull;
+        bool bKeptOwn;
+
+        void Run(const Thread&)
+        {
+            int value = 2;
+            bStartedNull = (Local.Get() == null);
+            Local.Set(&value);
+            Thread::Sleep(1u);
+            bKeptOwn = (Local.Get() == &value);
+        }
+    };
+
+    // Each thread sees only its own value, null until it sets one.
+    template<> template<>
+    void Object::test<4>()
+    {
+        LocalValues values;
+        ensure(values.Local.Get() == null);
+
+        int value = 1;
+        values.Local.Set(&value);
+        {
+            Thread thread(tr1::bind(&LocalValues::Run, &values, tr1::placeholders::_1));
+        }
+
+        ensure(values.bStartedNull);
+        ensure(values.bKeptOwn);
+        ensure(values.Local.Get() == &value);
+        ensure_equals(*values.Local.Get(), 1);
+
+        ThreadLocal<int> other;
+        ensure(other.Get() == null);
+    }
+
+}
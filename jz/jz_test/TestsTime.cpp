@@ -0,0 +1,97 @@
+#include <jz_core/Math.h>
+#include <jz_system/Time.h>
+#include <jz_test/Tests.h>
+
+namespace tut
+{
+
+    DUMMY(TestsTime);
+
+    using namespace jz;
+    using namespace jz::system;
+
+    static const s64 kStep = (10 * Time::kNanosecondsPerMillisecond);
+
+    // Steps taken are exact for any split of the same total time, and the remainder is
+    // reported as the alpha.
+    template<> template<>
+    void Object::test<1>()
+    {
+        FixedTimestep step(kStep);
+        ensure_equals(step.GetStepNanoseconds(), kStep);
+        ensure(step.GetAlpha() == 0.0f);
+
+        ensure_equals(step.Advance(kStep - 1), 0u);
+        ensure_equals(step.Advance(1), 1u);
+        ensure(step.GetAlpha() == 0.0f);
+
+        // 1000 frames of a third of a step are 333 steps, with a third left over.
+        uint steps = 0u;
+        for (size_t i = 0u; i < 1000u; i++)
+        {
+            steps += step.Advance(kStep / 3);
+
+            ensure(step.GetAlpha() >= 0.0f);
+            ensure(step.GetAlpha() < 1.0f);
+        }
+        ensure_equals(steps, 333u);
+        ensure_equals(step.GetStepCount(), 334u);
+        ensure(AboutEqual(step.GetAlpha(), 1.0f / 3.0f, Constants<float>::kLooseTolerance));
+
+        // Time running backwards is ignored.
+        ensure_equals(step.Advance(-kStep), 0u);
+        ensure(AboutEqual(step.GetAlpha(), 1.0f / 3.0f, Constants<float>::kLooseTolerance));
+
+        step.Reset();
+        ensure_equals(step.GetStepCount(), 0u);
+        ensure(step.GetAlpha() == 0.0f);
+    }
+
+    // A stall is clamped to aMaxSteps steps and the rest of it is dropped.
+    template<> template<>
+    void Object::test<2>()
+    {
+        FixedTimestep step(kStep, 4u);
+
+        ensure_equals(step.Advance(kStep / 2), 0u);
+        ensure_equals(step.Advance(100 * kStep), 4u);
+        ensure(step.GetAlpha() == 0.0f);
+        ensure_equals(step.GetStepCount(), 4u);
+
+        ensure_equals(step.Advance(kStep + (kStep / 4)), 1u);
+        ensure(AboutEqual(step.GetAlpha(), 0.25f));
+
+        FixedTimestep defaults(kStep);
+        ensure(defaults.Advance(1000 * kStep) == FixedTimestep::kDefaultMaxSteps);
+    }
+
+    // With a frame limit, Tick() waits out the rest of each frame.
+    template<> template<>
+    void Object::test<3>()
+    {
+        Time time;
+        ensure_equals(time.GetFrameLimit(), 0u);
+
+        time.SetFrameLimit(100u);
+        ensure_equals(time.GetFrameLimit(), 100u);
+
+        time.Tick();
+        for (size_t i = 0u; i < 5u; i++)
+        {
+            time.Tick();
+            ensure(time.GetElapsedNanoseconds() >= kStep);
+        }
+
+        ensure(time.GetNanoseconds() >= (5 * kStep));
+
+        time.SetFrameLimit(0u);
+        ensure_equals(time.GetFrameLimit(), 0u);
+
+        const s64 kBefore = time.GetAbsoluteNanoseconds();
+        time.Tick();
+        time.Tick();
+        ensure(time.GetElapsedNanoseconds() >= 0);
+        ensure(time.GetNanoseconds() >= kBefore);
+    }
+
+}
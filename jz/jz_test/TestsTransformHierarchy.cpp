@@ -0,0 +1,165 @@
+#include <jz_core/Matrix4.h>
+#include <jz_engine_3D/SceneNode.h>
+#include <jz_system/Jobs.h>
+#include <jz_test/Tests.h>
+#include <vector>
+
+namespace tut
+{
+
+    DUMMY(TestsTransformHierarchy);
+
+    using namespace jz;
+    using namespace jz::engine_3D;
+    using namespace jz::system;
+
+    static Matrix4 _Local(size_t i)
+    {
+        return (Matrix4::CreateRotationY(Radian(0.1f * (float)(i % 17u))) * Matrix4::CreateTranslation(Vector3((float)(i % 5u), 1.0f, -(float)(i % 3u))));
+    }
+
+    // The world transform as the recursive update computed it.
+    static Matrix4 _ExpectedWorld(const SceneNode* p)
+    {
+        return (p->GetParent()) ? (p->GetLocalTransform() * _ExpectedWorld(p->GetParent())) : p->GetLocalTransform();
+    }
+
+    static void _CheckWorld(const SceneNode* p)
+    {
+        ensure(Matrix4::AboutEqual(p->GetWorldTransform(), _ExpectedWorld(p), Constants<float>::kLooseTolerance));
+
+        for (SceneNode::const_iterator I = p->begin(); I != p->end(); I++) { _CheckWorld(&(*I)); }
+    }
+
+    static SceneNodePtr _Create(SceneNode* apParent, size_t i)
+    {
+        SceneNodePtr p(new SceneNode());
+        p->SetLocalTransform(_Local(i));
+        if (apParent) { p->SetParent(apParent); }
+
+        return p;
+    }
+
+    // World transforms match the recursive result after reparenting, and after a node in
+    // the middle of a chain is removed.
+    template<> template<>
+    void Object::test<1>()
+    {
+        SceneNodePtr root(_Create(null, 0u));
+        SceneNodePtr a(_Create(root.Get(), 1u));
+        SceneNodePtr b(_Create(a.Get(), 2u));
+        SceneNodePtr c(_Create(b.Get(), 3u));
+        SceneNodePtr d(_Create(root.Get(), 4u));
+
+        root->Update();
+        _CheckWorld(root.Get());
+
+        // b and c move under d.
+        b->SetParent(d.Get());
+        root->Update();
+        _CheckWorld(root.Get());
+        ensure(c->GetParent() == b.Get());
+
+        // Removing b leaves c a tree of its own.
+        b->SetParent(null);
+        b.Reset();
+        ensure(c->GetParent() == null);
+
+        root->SetLocalTransform(_Local(5u));
+        root->Update();
+        _CheckWorld(root.Get());
+
+        c->Update();
+        ensure(Matrix4::AboutEqual(c->GetWorldTransform(), c->GetLocalTransform()));
+
+        c->SetParent(a.Get());
+        root->Update();
+        _CheckWorld(root.Get());
+    }
+
+    // An update with nothing dirty changes nothing. After a leaf moves, kChanged is set on
+    // it and its ancestors only, and the clean sibling subtree keeps its transforms.
+    template<> template<>
+    void Object::test<2>()
+    {
+        SceneNodePtr root(_Create(null, 0u));
+        SceneNodePtr x(_Create(root.Get(), 1u));
+        SceneNodePtr x1(_Create(x.Get(), 2u));
+        SceneNodePtr y(_Create(root.Get(), 3u));
+        SceneNodePtr y1(_Create(y.Get(), 4u));
+
+        root->Update();
+        ensure(root->bDirty());
+        ensure(x1->bDirty());
+        ensure(y1->bDirty());
+
+        root->Update();
+        ensure(!root->bDirty());
+        ensure(!x->bDirty());
+        ensure(!x1->bDirty());
+        ensure(!y->bDirty());
+        ensure(!y1->bDirty());
+
+        const Matrix4 kX1 = x1->GetWorldTransform();
+
+        y1->SetLocalTransform(_Local(7u));
+        root->Update();
+        ensure(root->bDirty());
+        ensure(y->bDirty());
+        ensure(y1->bDirty());
+        ensure(!x->bDirty());
+        ensure(!x1->bDirty());
+        ensure(x1->GetWorldTransform() == kX1);
+        _CheckWorld(root.Get());
+
+        // A moved parent carries its children along.
+        x->SetLocalTransform(_Local(8u));
+        root->Update();
+        ensure(x->bDirty());
+        ensure(x1->bDirty());
+        ensure(!y->bDirty());
+        _CheckWorld(root.Get());
+    }
+
+    // A level wider than kParallelThreshold is updated with ParallelFor while Jobs runs,
+    // with the same result as the serial update.
+    template<> template<>
+    void Object::test<3>()
+    {
+        const size_t kWidth = (TransformHierarchy::kParallelThreshold + 100u);
+
+        Jobs jobs(3u);
+
+        SceneNodePtr root(_Create(null, 0u));
+        vector<SceneNodePtr> children;
+        vector<SceneNodePtr> grandchildren;
+        children.reserve(kWidth);
+        grandchildren.reserve(kWidth);
+
+        for (size_t i = 0u; i < kWidth; i++)
+        {
+            children.push_back(_Create(root.Get(), i + 1u));
+            grandchildren.push_back(_Create(children.back().Get(), i + 2u));
+        }
+
+        root->Update();
+        _CheckWorld(root.Get());
+
+        root->Update();
+        ensure(!root->bDirty());
+
+        children[5]->SetLocalTransform(_Local(11u));
+        grandchildren[kWidth - 1u]->SetLocalTransform(_Local(12u));
+        root->Update();
+        _CheckWorld(root.Get());
+
+        ensure(root->bDirty());
+        for (size_t i = 0u; i < kWidth; i++)
+        {
+            const bool kbMoved = (i == 5u || i == (kWidth - 1u));
+            ensure_equals(children[i]->bDirty(), kbMoved);
+            ensure_equals(grandchildren[i]->bDirty(), kbMoved);
+        }
+    }
+
+}